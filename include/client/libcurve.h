@@ -111,6 +111,7 @@ const char* ErrorNum2ErrorName(LIBCURVE_ERROR err);
 typedef enum LIBCURVE_OP {
     LIBCURVE_OP_READ,
     LIBCURVE_OP_WRITE,
+    LIBCURVE_OP_DISCARD,
     LIBCURVE_OP_MAX,
 } LIBCURVE_OP;
 
@@ -231,6 +232,17 @@ int AioRead(int fd, CurveAioContext* aioctx);
  */
 int AioWrite(int fd, CurveAioContext* aioctx);
 
+/**
+ * 异步模式discard，释放[offset, offset + length)范围内的空间
+ * discard之后该范围内的数据是未定义的
+ * 配置项global.enableDiscard关闭时(默认)直接返回成功，不释放空间，
+ * 只有在所有chunkserver都升级到支持discard的版本之后才能开启
+ * @param: fd为当前open返回的文件描述符
+ * @param: aioctx为异步读写的io上下文，保存基本的io信息，buf不使用
+ * @return: 成功返回 0,否则-LIBCURVE_ERROR::FAILED
+ */
+int AioDiscard(int fd, CurveAioContext* aioctx);
+
 /**
  * 重命名文件
  * @param: userinfo是用户信息
@@ -481,6 +493,14 @@ class CurveClient {
     virtual int AioWrite(int fd, CurveAioContext* aioctx,
                          UserDataType dataType);
 
+    /**
+     * 异步discard
+     * @param fd 文件fd
+     * @param aioctx 异步读写的io上下文
+     * @return 返回错误码
+     */
+    virtual int AioDiscard(int fd, CurveAioContext* aioctx);
+
     /**
      * 测试使用，设置fileclient
      * @param client 需要设置的fileclient
@@ -42,9 +42,10 @@
 namespace curve {
 namespace nbd {
 
-int IOController::InitDevAttr(int devfd, NBDConfig* config, int sockfd,
+int IOController::InitDevAttr(int devfd, NBDConfig* config,
+                              const std::vector<int>& sockfds,
                               uint64_t size, uint64_t flags) {
-    int ret = ioctl(devfd, NBD_SET_SOCK, sockfd);
+    int ret = ioctl(devfd, NBD_SET_SOCK, sockfds[0]);
     if (ret < 0) {
         cerr << "curve-ndb: the device " << config->devpath
              << " is busy" << std::endl;
@@ -52,6 +53,19 @@ int IOController::InitDevAttr(int devfd, NBDConfig* config, int sockfd,
     }
 
     do {
+        // 内核支持多连接时，每次NBD_SET_SOCK都会增加一个连接
+        for (size_t i = 1; i < sockfds.size(); ++i) {
+            ret = ioctl(devfd, NBD_SET_SOCK, sockfds[i]);
+            if (ret < 0) {
+                cerr << "curve-ndb: failed to add connection: "
+                     << cpp_strerror(errno) << std::endl;
+                break;
+            }
+        }
+        if (ret < 0) {
+            break;
+        }
+
         ret = ioctl(devfd, NBD_SET_BLKSIZE, CURVE_NBD_BLKSIZE);
         if (ret < 0) {
             break;
@@ -88,7 +102,7 @@ int IOController::InitDevAttr(int devfd, NBDConfig* config, int sockfd,
     return ret;
 }
 
-int IOController::SetUp(NBDConfig* config, int sockfd,
+int IOController::SetUp(NBDConfig* config, const std::vector<int>& sockfds,
                         uint64_t size, uint64_t flags) {
     if (config->devpath.empty()) {
         config->devpath = find_unused_nbd_device();
@@ -112,7 +126,7 @@ int IOController::SetUp(NBDConfig* config, int sockfd,
     }
     int devfd = ret;
 
-    ret = InitDevAttr(devfd, config, sockfd, size, flags);
+    ret = InitDevAttr(devfd, config, sockfds, size, flags);
     if (ret == 0) {
         ret = check_device_size(index, size);
     }
@@ -201,7 +215,8 @@ void NetLinkController::Uninit() {
     nlId_ = -1;
 }
 
-int NetLinkController::SetUp(NBDConfig* config, int sockfd,
+int NetLinkController::SetUp(NBDConfig* config,
+                             const std::vector<int>& sockfds,
                              uint64_t size, uint64_t flags) {
     int ret = Init();
     if (ret < 0) {
@@ -210,7 +225,7 @@ int NetLinkController::SetUp(NBDConfig* config, int sockfd,
         return ret;
     }
 
-    ret = ConnectInternal(config, sockfd, size, flags);
+    ret = ConnectInternal(config, sockfds, size, flags);
     Uninit();
     if (ret < 0) {
         return ret;
@@ -321,7 +336,8 @@ static int netlink_connect_cb(struct nl_msg *msg, void *arg) {
     return NL_OK;
 }
 
-int NetLinkController::ConnectInternal(NBDConfig* config, int sockfd,
+int NetLinkController::ConnectInternal(NBDConfig* config,
+                                       const std::vector<int>& sockfds,
                                        uint64_t size, uint64_t flags) {
     struct nlattr *sock_attr = nullptr;
     struct nlattr *sock_opt = nullptr;
@@ -364,15 +380,17 @@ int NetLinkController::ConnectInternal(NBDConfig* config, int sockfd,
         goto nla_put_failure;
     }
 
-    sock_opt = nla_nest_start(msg, NBD_SOCK_ITEM);
-    if (sock_opt == nullptr) {
-        cerr << "curve-nbd: Could not init sock in netlink message."
-             << std::endl;
-        goto nla_put_failure;
-    }
+    for (int sockfd : sockfds) {
+        sock_opt = nla_nest_start(msg, NBD_SOCK_ITEM);
+        if (sock_opt == nullptr) {
+            cerr << "curve-nbd: Could not init sock in netlink message."
+                 << std::endl;
+            goto nla_put_failure;
+        }
 
-    NLA_PUT_U32(msg, NBD_SOCK_FD, sockfd);
-    nla_nest_end(msg, sock_opt);
+        NLA_PUT_U32(msg, NBD_SOCK_FD, sockfd);
+        nla_nest_end(msg, sock_opt);
+    }
     nla_nest_end(msg, sock_attr);
 
     ret = nl_send_sync(sock_, msg);
@@ -43,6 +43,8 @@
 #include <glog/logging.h>
 #include <inttypes.h>
 #include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 #include "nbd/src/util.h"
 
@@ -80,6 +82,77 @@ static std::ostream& operator<<(std::ostream& os, const IOContext& ctx) {
     return os;
 }
 
+CompletionQueue::CompletionQueue() : head_(nullptr) {
+    eventFd_ = eventfd(0, EFD_CLOEXEC);
+    CHECK(eventFd_ >= 0) << "Failed to create eventfd: "
+                         << cpp_strerror(-errno);
+}
+
+CompletionQueue::~CompletionQueue() {
+    close(eventFd_);
+}
+
+void CompletionQueue::Push(IOContext* ctx) {
+    IOContext* head = head_.load(std::memory_order_relaxed);
+    do {
+        ctx->next = head;
+    } while (!head_.compare_exchange_weak(head, ctx,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+
+    // 队列原本不为空时，写线程一定会在取出请求时看到新放入的请求
+    if (head == nullptr) {
+        Wakeup();
+    }
+}
+
+IOContext* CompletionQueue::PopAll() {
+    IOContext* head = head_.exchange(nullptr, std::memory_order_acquire);
+
+    // 队列中的请求是后进先出的，反转后按完成顺序返回
+    IOContext* reversed = nullptr;
+    while (head != nullptr) {
+        IOContext* next = head->next;
+        head->next = reversed;
+        reversed = head;
+        head = next;
+    }
+
+    return reversed;
+}
+
+void CompletionQueue::Wait() {
+    uint64_t count = 0;
+    ssize_t r = read(eventFd_, &count, sizeof(count));
+    if (r < 0 && errno != EINTR) {
+        LOG(ERROR) << "Failed to read eventfd: " << cpp_strerror(-errno);
+    }
+}
+
+void CompletionQueue::Wakeup() {
+    uint64_t count = 1;
+    ssize_t r = write(eventFd_, &count, sizeof(count));
+    if (r < 0) {
+        LOG(ERROR) << "Failed to write eventfd: " << cpp_strerror(-errno);
+    }
+}
+
+NBDServer::NBDServer(const std::vector<int>& socks, NBDControllerPtr nbdCtrl,
+                     std::shared_ptr<ImageInstance> imageInstance,
+                     std::shared_ptr<SafeIO> safeIO)
+    : started_(false),
+      terminated_(false),
+      nbdCtrl_(nbdCtrl),
+      image_(imageInstance),
+      safeIO_(safeIO),
+      pendingRequestCounts_(0) {
+    for (int sock : socks) {
+        std::unique_ptr<NBDConnection> conn(new NBDConnection());
+        conn->sock = sock;
+        connections_.emplace_back(std::move(conn));
+    }
+}
+
 void NBDServer::NBDAioCallback(struct NebdClientAioContext* aioCtx) {
     IOContext* ctx = reinterpret_cast<IOContext*>(
         reinterpret_cast<char*>(aioCtx) - offsetof(IOContext, nebdAioCtx));
@@ -99,8 +172,10 @@ NBDServer::~NBDServer() {
 
         Shutdown();
 
-        writerThread_.join();
-        readerThread_.join();
+        for (auto& conn : connections_) {
+            conn->writerThread.join();
+            conn->readerThread.join();
+        }
 
         WaitClean();
 
@@ -117,8 +192,12 @@ void NBDServer::Start() {
 
     started_ = true;
 
-    readerThread_ = std::thread(&NBDServer::ReaderFunc, this);
-    writerThread_ = std::thread(&NBDServer::WriterFunc, this);
+    for (auto& conn : connections_) {
+        conn->readerThread =
+            std::thread(&NBDServer::ReaderFunc, this, conn.get());
+        conn->writerThread =
+            std::thread(&NBDServer::WriterFunc, this, conn.get());
+    }
 
     return;
 }
@@ -136,23 +215,26 @@ void NBDServer::Shutdown() {
     LOG(INFO) << "going to shutdown, terminated " << terminated_;
     bool expected = false;
 
+    // 任意一个连接出错，整个设备都不可用，关闭所有的连接
     if (terminated_.compare_exchange_strong(expected, true)) {
-        shutdown(sock_, SHUT_RDWR);
-
-        std::lock_guard<std::mutex> lk(requestMtx_);
-        requestCond_.notify_all();
+        for (auto& conn : connections_) {
+            shutdown(conn->sock, SHUT_RDWR);
+            conn->finishedRequests.Wakeup();
+        }
     }
 }
 
-void NBDServer::ReaderFunc() {
+void NBDServer::ReaderFunc(NBDConnection* conn) {
     ssize_t r = 0;
     bool disconnect = false;
 
     while (!terminated_) {
         std::unique_ptr<IOContext> ctx(new IOContext());
         ctx->server = this;
+        ctx->conn = conn;
 
-        r = safeIO_->ReadExact(sock_, &ctx->request, sizeof(ctx->request));
+        r = safeIO_->ReadExact(conn->sock, &ctx->request,
+                               sizeof(ctx->request));
         if (r < 0) {
             LOG(ERROR) << "Failed to read nbd request header: "
                        << cpp_strerror(r);
@@ -184,7 +266,7 @@ void NBDServer::ReaderFunc() {
                 ctx->data.reset(new char[ctx->request.len]);
 
                 // 写请求，继续读取写入数据
-                r = safeIO_->ReadExact(sock_, ctx->data.get(),
+                r = safeIO_->ReadExact(conn->sock, ctx->data.get(),
                                        ctx->request.len);
                 if (r < 0) {
                     LOG(ERROR) << "Failed to read nbd request data "
@@ -221,31 +303,27 @@ void NBDServer::ReaderFunc() {
     Shutdown();
 }
 
-void NBDServer::WriterFunc() {
+void NBDServer::WriterFunc(NBDConnection* conn) {
     signal(SIGPIPE, SIG_IGN);
 
-    ssize_t r = 0;
-
     while (!terminated_) {
-        std::unique_ptr<IOContext> ctx(WaitRequestFinish());
-
-        if (ctx == nullptr) {
-            LOG(INFO) << "No more requests, terminating";
-            break;
+        IOContext* ctxs = conn->finishedRequests.PopAll();
+        if (ctxs == nullptr) {
+            conn->finishedRequests.Wait();
+            continue;
         }
 
-        r = safeIO_->Write(sock_, &ctx->reply, sizeof(struct nbd_reply));
-        if (r < 0) {
-            LOG(ERROR) << *ctx << ": failed to write reply header : "
-                       << cpp_strerror(r);
-            return;
-        }
+        while (ctxs != nullptr) {
+            std::unique_ptr<IOContext> ctx(ctxs);
+            ctxs = ctxs->next;
 
-        if (ctx->command == NBD_CMD_READ && ctx->reply.error == htonl(0)) {
-            r = safeIO_->Write(sock_, ctx->data.get(), ctx->request.len);
-            if (r < 0) {
-                LOG(ERROR) << *ctx << ": faield to write reply date : "
-                           << cpp_strerror(r);
+            if (!SendReply(conn, ctx.get())) {
+                // 连接已不可用，丢弃剩余的请求
+                while (ctxs != nullptr) {
+                    std::unique_ptr<IOContext> dropped(ctxs);
+                    ctxs = ctxs->next;
+                }
+                Shutdown();
                 return;
             }
         }
@@ -255,44 +333,54 @@ void NBDServer::WriterFunc() {
     Shutdown();
 }
 
-IOContext* NBDServer::WaitRequestFinish() {
-    std::unique_lock<std::mutex> lk(requestMtx_);
-    requestCond_.wait(
-        lk, [this]() { return !finishedRequests_.empty() || terminated_; });
-
-    if (finishedRequests_.empty()) {
-        return nullptr;
+bool NBDServer::SendReply(NBDConnection* conn, IOContext* ctx) {
+    ssize_t r = safeIO_->Write(conn->sock, &ctx->reply,
+                               sizeof(struct nbd_reply));
+    if (r < 0) {
+        LOG(ERROR) << *ctx << ": failed to write reply header : "
+                   << cpp_strerror(r);
+        return false;
     }
 
-    IOContext* ctx = finishedRequests_.front();
-    finishedRequests_.pop_front();
+    if (ctx->command == NBD_CMD_READ && ctx->reply.error == htonl(0)) {
+        r = safeIO_->Write(conn->sock, ctx->data.get(), ctx->request.len);
+        if (r < 0) {
+            LOG(ERROR) << *ctx << ": faield to write reply date : "
+                       << cpp_strerror(r);
+            return false;
+        }
+    }
 
-    return ctx;
+    return true;
 }
 
 void NBDServer::OnRequestStart() {
-    std::lock_guard<std::mutex> lk(requestMtx_);
-    ++pendingRequestCounts_;
+    pendingRequestCounts_.fetch_add(1);
 }
 
 void NBDServer::OnRequestFinish(IOContext* ctx) {
-    std::lock_guard<std::mutex> lk(requestMtx_);
-
-    --pendingRequestCounts_;
+    ctx->conn->finishedRequests.Push(ctx);
 
-    finishedRequests_.push_back(ctx);
-    requestCond_.notify_all();
+    // 计数必须在锁内减少，否则可能在WaitClean检查条件之后、开始等待之前
+    // 减到0，通知丢失，WaitClean一直等待。请求全部返回时才需要通知
+    std::lock_guard<std::mutex> lk(cleanMtx_);
+    if (pendingRequestCounts_.fetch_sub(1) == 1) {
+        cleanCond_.notify_all();
+    }
 }
 
 void NBDServer::WaitClean() {
     LOG(INFO) << "WaitClean, current pending requests: "
               << pendingRequestCounts_;
-    std::unique_lock<std::mutex> lk(requestMtx_);
-    requestCond_.wait(lk, [this]() { return pendingRequestCounts_ == 0; });
-
-    while (!finishedRequests_.empty()) {
-        std::unique_ptr<IOContext> ctx(finishedRequests_.front());
-        finishedRequests_.pop_front();
+    std::unique_lock<std::mutex> lk(cleanMtx_);
+    cleanCond_.wait(lk, [this]() { return pendingRequestCounts_ == 0; });
+
+    for (auto& conn : connections_) {
+        IOContext* ctxs = conn->finishedRequests.PopAll();
+        while (ctxs != nullptr) {
+            std::unique_ptr<IOContext> ctx(ctxs);
+            ctxs = ctxs->next;
+        }
     }
 }
 
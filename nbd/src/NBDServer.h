@@ -43,11 +43,11 @@
 #include <linux/nbd.h>
 #include <atomic>
 #include <condition_variable>  // NOLINT
-#include <deque>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "nbd/src/ImageInstance.h"
 #include "nbd/src/NBDController.h"
@@ -58,6 +58,7 @@ namespace curve {
 namespace nbd {
 
 class NBDServer;
+struct NBDConnection;
 
 // NBD IO请求上下文信息
 struct IOContext {
@@ -68,6 +69,10 @@ struct IOContext {
     int command = 0;
 
     NBDServer* server = nullptr;
+    // 请求所在的连接，请求完成后从该连接返回
+    NBDConnection* conn = nullptr;
+    // 已完成请求队列中的下一个请求
+    IOContext* next = nullptr;
     std::unique_ptr<char[]> data;
 
     // NEBD请求上下文信息
@@ -78,19 +83,64 @@ struct IOContext {
     }
 };
 
+// 已完成请求队列，多个回调线程无锁并发的放入请求，写线程一次取出所有请求
+// 只有队列由空变为非空时才通过eventfd唤醒写线程
+class CompletionQueue {
+ public:
+    CompletionQueue();
+    ~CompletionQueue();
+
+    /**
+     * @brief 放入一个已完成的请求
+     * @param ctx 已完成的请求上下文
+     */
+    void Push(IOContext* ctx);
+
+    /**
+     * @brief 取出所有已完成的请求
+     * @return 按完成顺序链接的请求链表，队列为空时返回nullptr
+     */
+    IOContext* PopAll();
+
+    /**
+     * @brief 等待队列非空或者被唤醒
+     */
+    void Wait();
+
+    /**
+     * @brief 唤醒等待的写线程
+     */
+    void Wakeup();
+
+ private:
+    std::atomic<IOContext*> head_;
+    int eventFd_;
+};
+
+// 与内核之间的一个连接，每个连接有各自的读写线程
+struct NBDConnection {
+    // 与内核通信的socket fd
+    int sock = -1;
+    // 该连接上已完成的请求
+    CompletionQueue finishedRequests;
+    // 读线程
+    std::thread readerThread;
+    // 写线程
+    std::thread writerThread;
+};
+
 // NBDServer负责与nbd内核进行数据通信
+// 内核以多连接模式映射设备时，每个连接上的请求由各自的读写线程处理
 class NBDServer {
  public:
     NBDServer(int sock, NBDControllerPtr nbdCtrl,
               std::shared_ptr<ImageInstance> imageInstance,
               std::shared_ptr<SafeIO> safeIO = std::make_shared<SafeIO>())
-        : started_(false),
-          terminated_(false),
-          sock_(sock),
-          nbdCtrl_(nbdCtrl),
-          image_(imageInstance),
-          pendingRequestCounts_(0),
-          safeIO_(safeIO) {}
+        : NBDServer(std::vector<int>{sock}, nbdCtrl, imageInstance, safeIO) {}
+
+    NBDServer(const std::vector<int>& socks, NBDControllerPtr nbdCtrl,
+              std::shared_ptr<ImageInstance> imageInstance,
+              std::shared_ptr<SafeIO> safeIO = std::make_shared<SafeIO>());
 
     ~NBDServer();
 
@@ -133,13 +183,23 @@ class NBDServer {
 
     /**
      * @brief 读线程执行函数
+     * @param conn 读线程所在的连接
      */
-    void ReaderFunc();
+    void ReaderFunc(NBDConnection* conn);
 
     /**
      * @brief 写线程执行函数
+     * @param conn 写线程所在的连接
+     */
+    void WriterFunc(NBDConnection* conn);
+
+    /**
+     * @brief 向内核返回请求的结果
+     * @param conn 请求所在的连接
+     * @param ctx 已完成的请求
+     * @return 成功返回true，socket写失败返回false
      */
-    void WriterFunc();
+    bool SendReply(NBDConnection* conn, IOContext* ctx);
 
     /**
      * @brief 异步请求开始时执行函数
@@ -152,12 +212,6 @@ class NBDServer {
      */
     void OnRequestFinish(IOContext* ctx);
 
-    /**
-     * @brief 等待异步请求返回
-     * @return 异步请求context
-     */
-    IOContext* WaitRequestFinish();
-
     /**
      * 发起异步请求
      * @param ctx nbd请求上下文
@@ -171,26 +225,18 @@ class NBDServer {
     // server是否停止
     std::atomic<bool> terminated_;
 
-    // 与内核通信的socket fd
-    int sock_;
+    // 与内核之间的连接
+    std::vector<std::unique_ptr<NBDConnection>> connections_;
     NBDControllerPtr nbdCtrl_;
     std::shared_ptr<ImageInstance> image_;
     std::shared_ptr<SafeIO> safeIO_;
 
-    // 保护pendingRequestCounts_和finishedRequests_
-    std::mutex requestMtx_;
-    std::condition_variable requestCond_;
-
     // 正在执行过程中的请求数量
-    uint64_t pendingRequestCounts_;
-
-    // 已完成请求上下文队列
-    std::deque<IOContext*> finishedRequests_;
+    std::atomic<uint64_t> pendingRequestCounts_;
 
-    // 读线程
-    std::thread readerThread_;
-    // 写线程
-    std::thread writerThread_;
+    // server停止后，用于等待正在执行的请求全部返回
+    std::mutex cleanMtx_;
+    std::condition_variable cleanCond_;
 
     // 等待断开连接锁/条件变量
     std::mutex disconnectMutex_;
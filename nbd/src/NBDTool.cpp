@@ -58,10 +58,18 @@ NBDControllerPtr NBDTool::GetController(bool tryNetlink) {
 int NBDTool::Connect(NBDConfig *cfg) {
     // loadmodule 到时候放到外面做
 
-    // init socket pair
-    int ret = socketPair_.Init();
-    if (ret < 0) {
-        return ret;
+    // init socket pair, one for each connection
+    std::vector<int> kernelSocks;
+    std::vector<int> serverSocks;
+    for (int i = 0; i < cfg->connections; ++i) {
+        std::unique_ptr<NBDSocketPair> socketPair(new NBDSocketPair());
+        int ret = socketPair->Init();
+        if (ret < 0) {
+            return ret;
+        }
+        kernelSocks.push_back(socketPair->First());
+        serverSocks.push_back(socketPair->Second());
+        socketPairs_.emplace_back(std::move(socketPair));
     }
 
     // 初始化打开文件
@@ -84,13 +92,13 @@ int NBDTool::Connect(NBDConfig *cfg) {
     }
 
     // load nbd module
-    ret = load_module(cfg);
+    int ret = load_module(cfg);
     if (ret < 0) {
         return ret;
     }
 
     NBDControllerPtr nbdCtrl = GetController(cfg->try_netlink);
-    nbdServer_ = std::make_shared<NBDServer>(socketPair_.Second(), nbdCtrl,
+    nbdServer_ = std::make_shared<NBDServer>(serverSocks, nbdCtrl,
                                              imageInstance);
 
     // setup controller
@@ -99,7 +107,12 @@ int NBDTool::Connect(NBDConfig *cfg) {
     if (cfg->readonly) {
         flags |= NBD_FLAG_READ_ONLY;
     }
-    ret = nbdCtrl->SetUp(cfg, socketPair_.First(), fileSize, flags);
+    // 多连接模式要求任一连接上的flush对所有连接上已完成的写请求生效，
+    // curve的写请求返回时已经持久化，满足该要求
+    if (cfg->connections > 1) {
+        flags |= NBD_FLAG_CAN_MULTI_CONN;
+    }
+    ret = nbdCtrl->SetUp(cfg, kernelSocks, fileSize, flags);
     if (ret < 0) {
         return -1;
     }
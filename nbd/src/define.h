@@ -56,6 +56,12 @@ namespace nbd {
 #define HELP_INFO 1
 #define VERSION_INFO 2
 #define CURVE_NBD_BLKSIZE 4096UL    // CURVE后端当前支持4096大小对齐的IO
+#define CURVE_NBD_MAX_CONNECTIONS 16    // 一个nbd设备最多支持的连接数量
+
+// 低版本内核头文件中没有该定义，多连接模式下需要设置该flag
+#ifndef NBD_FLAG_CAN_MULTI_CONN
+#define NBD_FLAG_CAN_MULTI_CONN (1 << 8)
+#endif
 
 #define NBD_MAX_PATH "/sys/module/nbd/parameters/nbds_max"
 #define PROCESS_NAME "curve-nbd"
@@ -77,6 +83,8 @@ struct NBDConfig {
     bool set_max_part = false;
     // 是否以netlink方式控制nbd内核模块
     bool try_netlink = false;
+    // 与nbd内核之间的连接数量，每个连接有各自的读写线程
+    int connections = 1;
     // 需要映射的后端文件名称
     std::string imgname;
     // 指定需要映射的nbd设备路径
@@ -90,6 +90,7 @@ static void Usage() {
         << "  --max_part <limit>      Override for module param max_part\n"
         << "  --timeout <seconds>     Set nbd request timeout\n"
         << "  --try-netlink           Use the nbd netlink interface\n"
+        << "  --connections <num>     Number of connections per device (1~16)\n"
         << std::endl;
 }
 
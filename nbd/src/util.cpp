@@ -201,6 +201,18 @@ int parse_args(std::vector<const char*>& args, std::ostream *err_msg,   // NOLIN
             }
         } else if (argparse_flag(args, i, "--try-netlink", (char *)NULL)) { // NOLINT
             cfg->try_netlink = true;
+        } else if (argparse_witharg(args, i, &cfg->connections, err,
+                                    "--connections", (char *)NULL)) {   // NOLINT
+            if (!err.str().empty()) {
+                *err_msg << "curve-nbd: " << err.str();
+                return -EINVAL;
+            }
+            if (cfg->connections < 1 ||
+                cfg->connections > CURVE_NBD_MAX_CONNECTIONS) {
+                *err_msg << "curve-nbd: Invalid argument for connections(1~"
+                         << CURVE_NBD_MAX_CONNECTIONS << ")!";
+                return -EINVAL;
+            }
         } else {
             ++i;
         }
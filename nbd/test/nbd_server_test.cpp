@@ -30,6 +30,7 @@
 #include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <memory>
+#include <vector>
 #include "nbd/src/NBDServer.h"
 #include "nbd/test/fake_safe_io.h"
 #include "nbd/test/mock_image_instance.h"
@@ -296,5 +297,60 @@ TEST_F(NBDServerTest, ReadWriteDataErrorTest) {
     ASSERT_TRUE(server_->IsTerminated());
 }
 
+TEST_F(NBDServerTest, MultiConnectionTest) {
+    int fd2[2];
+    ASSERT_NE(-1, socketpair(AF_UNIX, SOCK_STREAM, 0, fd2));
+    server_.reset(new NBDServer(std::vector<int>{fd_[1], fd2[1]},
+                                nullptr, image_));
+    ASSERT_NO_THROW(server_->Start());
+
+    // 两个连接上各下发一个请求
+    request_.from = 0;
+    request_.len = htonl(8);
+    request_.type = htonl(NBD_CMD_READ);
+    request_.magic = htonl(NBD_REQUEST_MAGIC);
+    memcpy(&request_.handle, &handle_, sizeof(request_.handle));
+
+    struct nbd_request request2 = request_;
+    request2.type = htonl(NBD_CMD_FLUSH);
+
+    NebdClientAioContext* readContext;
+    NebdClientAioContext* flushContext;
+    EXPECT_CALL(*image_, AioRead(_))
+        .Times(1)
+        .WillOnce(SaveArg<0>(&readContext));
+    EXPECT_CALL(*image_, Flush(_))
+        .Times(1)
+        .WillOnce(SaveArg<0>(&flushContext));
+
+    ASSERT_EQ(NBDRequestSize, write(fd_[0], &request_, NBDRequestSize));
+    ASSERT_EQ(NBDRequestSize, write(fd2[0], &request2, NBDRequestSize));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kSleepTime));
+
+    // 请求从各自的连接返回
+    flushContext->cb(flushContext);
+    ASSERT_EQ(NBDReplySize, read(fd2[0], &reply_, NBDReplySize));
+    ASSERT_EQ(0, reply_.error);
+
+    memcpy(readContext->buf, handle_, sizeof(handle_));
+    readContext->cb(readContext);
+    char readbuf[8];
+    ASSERT_EQ(NBDReplySize, read(fd_[0], &reply_, NBDReplySize));
+    ASSERT_EQ(0, reply_.error);
+    ASSERT_EQ(sizeof(readbuf), read(fd_[0], readbuf, sizeof(readbuf)));
+    ASSERT_EQ(0, memcmp(readbuf, handle_, sizeof(handle_)));
+
+    // 一个连接断开，整个server停止
+    ::shutdown(fd2[0], SHUT_RDWR);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kSleepTime));
+
+    ASSERT_TRUE(server_->IsTerminated());
+    server_.reset();
+    close(fd2[0]);
+    close(fd2[1]);
+}
+
 }  // namespace nbd
 }  // namespace curve
@@ -163,6 +163,18 @@ TEST_F(NBDToolTest, netlink_connect_test) {
     ASSERT_FALSE(isRunning_);
 }
 
+TEST_F(NBDToolTest, multi_connection_test) {
+    NBDConfig config;
+    config.imgname = kTestImage;
+    config.connections = 4;
+    StartInAnotherThread(&config);
+    ASSERT_TRUE(isRunning_);
+    AssertWriteSuccess(config.devpath);
+    ASSERT_EQ(0, tool_.Disconnect(config.devpath));
+    sleep(1);
+    ASSERT_FALSE(isRunning_);
+}
+
 TEST_F(NBDToolTest, readonly_test) {
     NBDConfig config;
     config.imgname = kTestImage;
@@ -0,0 +1,451 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/**
+ * Project: nebd
+ */
+
+#include "nebd/src/common/shm_ring.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <linux/memfd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+
+// 低版本glibc的fcntl.h中没有file seal相关的定义
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_GET_SEALS 1034
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+
+namespace nebd {
+namespace common {
+
+// 单生产者单消费者队列的控制信息
+// head由消费者修改(提交队列断开后part1也会收回)，tail只由生产者修改，
+// 分别放在不同的cacheline上
+struct ShmRingQueue {
+    alignas(64) std::atomic<uint32_t> head;
+    // 消费者是否在eventfd上等待
+    std::atomic<uint32_t> waiting;
+    alignas(64) std::atomic<uint32_t> tail;
+};
+
+struct ShmRingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t depth;
+    uint32_t slotSize;
+    // part2已经处理完取出的请求，不会再访问提交队列
+    std::atomic<uint32_t> drained;
+    ShmRingQueue sq;
+    ShmRingQueue cq;
+};
+
+namespace {
+
+const uint32_t kShmRingMagic = 0x4e524e47;  // "NRNG"
+const uint32_t kShmRingVersion = 3;
+const size_t kShmRingAlignment = 4096;
+const int kShmRingFdNum = 3;
+const int kBufSize = 128;
+// 共享内存的大小在初始化之后不能再改变，否则对端访问映射区域时会SIGBUS
+const int kShmRingSeals = F_SEAL_SHRINK | F_SEAL_GROW;
+
+inline size_t AlignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+inline size_t GetSqOffset() {
+    return AlignUp(sizeof(ShmRingHeader), 64);
+}
+
+inline size_t GetCqOffset(uint32_t depth) {
+    return AlignUp(GetSqOffset() + depth * sizeof(ShmRingRequest), 64);
+}
+
+inline size_t GetSlotsOffset(uint32_t depth) {
+    return AlignUp(GetCqOffset(depth) + depth * sizeof(ShmRingCompletion),
+                   kShmRingAlignment);
+}
+
+inline bool IsValidGeometry(uint32_t depth, uint32_t slotSize) {
+    return depth > 0 && (depth & (depth - 1)) == 0 &&
+           slotSize > 0 && slotSize % kShmRingAlignment == 0;
+}
+
+inline void CloseFd(int* fd) {
+    if (*fd >= 0) {
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+}  // namespace
+
+ShmRing::ShmRing()
+    : memFd_(-1),
+      sqEventFd_(-1),
+      cqEventFd_(-1),
+      addr_(nullptr),
+      size_(0),
+      depth_(0),
+      slotSize_(0),
+      header_(nullptr),
+      sq_(nullptr),
+      cq_(nullptr),
+      slots_(nullptr) {}
+
+ShmRing::~ShmRing() {
+    Release();
+}
+
+size_t ShmRing::GetMemorySize(uint32_t depth, uint32_t slotSize) {
+    return GetSlotsOffset(depth) + static_cast<size_t>(depth) * slotSize;
+}
+
+int ShmRing::Init(uint32_t depth, uint32_t slotSize) {
+    char buffer[kBufSize];
+    if (!IsValidGeometry(depth, slotSize)) {
+        LOG(ERROR) << "Invalid shm ring geometry, depth = " << depth
+                   << ", slot size = " << slotSize;
+        return -1;
+    }
+
+    // 低版本glibc没有memfd_create的封装
+    memFd_ = syscall(SYS_memfd_create, "nebd-shm-ring",
+                     MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    sqEventFd_ = eventfd(0, EFD_CLOEXEC);
+    cqEventFd_ = eventfd(0, EFD_CLOEXEC);
+    if (memFd_ < 0 || sqEventFd_ < 0 || cqEventFd_ < 0) {
+        LOG(ERROR) << "Create shm ring fd failed, error = "
+                   << strerror_r(errno, buffer, kBufSize);
+        Release();
+        return -1;
+    }
+
+    size_t size = GetMemorySize(depth, slotSize);
+    if (ftruncate(memFd_, size) != 0) {
+        LOG(ERROR) << "Truncate shm ring failed, error = "
+                   << strerror_r(errno, buffer, kBufSize)
+                   << ", size = " << size;
+        Release();
+        return -1;
+    }
+    if (fcntl(memFd_, F_ADD_SEALS, kShmRingSeals | F_SEAL_SEAL) != 0) {
+        LOG(ERROR) << "Seal shm ring failed, error = "
+                   << strerror_r(errno, buffer, kBufSize);
+        Release();
+        return -1;
+    }
+    if (Map(size) != 0) {
+        Release();
+        return -1;
+    }
+
+    header_ = new (addr_) ShmRingHeader();
+    header_->magic = kShmRingMagic;
+    header_->version = kShmRingVersion;
+    header_->depth = depth;
+    header_->slotSize = slotSize;
+    header_->drained.store(0);
+    for (ShmRingQueue* queue : {&header_->sq, &header_->cq}) {
+        queue->head.store(0);
+        queue->waiting.store(0);
+        queue->tail.store(0);
+    }
+    depth_ = depth;
+    slotSize_ = slotSize;
+    sq_ = reinterpret_cast<ShmRingRequest*>(addr_ + GetSqOffset());
+    cq_ = reinterpret_cast<ShmRingCompletion*>(addr_ + GetCqOffset(depth));
+    slots_ = addr_ + GetSlotsOffset(depth);
+    return 0;
+}
+
+int ShmRing::SendTo(int sock) {
+    char buffer[kBufSize];
+    uint32_t magic = kShmRingMagic;
+    struct iovec iov;
+    iov.iov_base = &magic;
+    iov.iov_len = sizeof(magic);
+
+    int fds[kShmRingFdNum] = {memFd_, sqEventFd_, cqEventFd_};
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    ssize_t ret = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    if (ret != sizeof(magic)) {
+        LOG(ERROR) << "Send shm ring failed, error = "
+                   << strerror_r(errno, buffer, kBufSize);
+        return -1;
+    }
+    return 0;
+}
+
+int ShmRing::RecvFrom(int sock) {
+    char buffer[kBufSize];
+    uint32_t magic = 0;
+    struct iovec iov;
+    iov.iov_base = &magic;
+    iov.iov_len = sizeof(magic);
+
+    int fds[kShmRingFdNum];
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    ssize_t ret = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (ret != sizeof(magic) || cmsg == nullptr ||
+        cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) {
+        LOG(ERROR) << "Receive shm ring failed, ret = " << ret
+                   << ", error = " << strerror_r(errno, buffer, kBufSize);
+        if (cmsg != nullptr && cmsg->cmsg_type == SCM_RIGHTS) {
+            int num = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+            memcpy(fds, CMSG_DATA(cmsg),
+                   std::min<size_t>(num, kShmRingFdNum) * sizeof(int));
+            for (int i = 0; i < num && i < kShmRingFdNum; ++i) {
+                close(fds[i]);
+            }
+        }
+        return -1;
+    }
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    memFd_ = fds[0];
+    sqEventFd_ = fds[1];
+    cqEventFd_ = fds[2];
+
+    struct stat st;
+    if (magic != kShmRingMagic || fstat(memFd_, &st) != 0) {
+        LOG(ERROR) << "Invalid shm ring, magic = " << magic;
+        Release();
+        return -1;
+    }
+    // 对端可以随时修改未封印的共享内存的大小，只接受大小已经封印的共享内存
+    int seals = fcntl(memFd_, F_GET_SEALS);
+    if (seals < 0 || (seals & kShmRingSeals) != kShmRingSeals) {
+        LOG(ERROR) << "Shm ring is not sealed, seals = " << seals;
+        Release();
+        return -1;
+    }
+    if (Map(st.st_size) != 0) {
+        Release();
+        return -1;
+    }
+
+    // 校验part1写入的header，防止越界访问
+    header_ = reinterpret_cast<ShmRingHeader*>(addr_);
+    if (size_ < sizeof(ShmRingHeader) ||
+        header_->magic != kShmRingMagic ||
+        header_->version != kShmRingVersion ||
+        !IsValidGeometry(header_->depth, header_->slotSize) ||
+        GetMemorySize(header_->depth, header_->slotSize) != size_) {
+        LOG(ERROR) << "Invalid shm ring header, size = " << size_;
+        Release();
+        return -1;
+    }
+    depth_ = header_->depth;
+    slotSize_ = header_->slotSize;
+    sq_ = reinterpret_cast<ShmRingRequest*>(addr_ + GetSqOffset());
+    cq_ = reinterpret_cast<ShmRingCompletion*>(addr_ + GetCqOffset(depth_));
+    slots_ = addr_ + GetSlotsOffset(depth_);
+    return 0;
+}
+
+bool ShmRing::SubmitRequest(const ShmRingRequest& request) {
+    return Push(&header_->sq, sq_, request, sqEventFd_);
+}
+
+bool ShmRing::FetchRequest(ShmRingRequest* request) {
+    return Pop(&header_->sq, sq_, request);
+}
+
+uint32_t ShmRing::RevokeRequests() {
+    ShmRingQueue* queue = &header_->sq;
+    // 断开之后part1不再提交请求，tail不会再变化
+    uint32_t tail = queue->tail.load(std::memory_order_acquire);
+    uint32_t head = queue->head.load(std::memory_order_acquire);
+    // 失败时head被更新为part2最新取到的位置
+    while (!queue->head.compare_exchange_weak(head, tail,
+                                              std::memory_order_acq_rel)) {}
+    return tail - head;
+}
+
+bool ShmRing::SubmitCompletion(const ShmRingCompletion& completion) {
+    return Push(&header_->cq, cq_, completion, cqEventFd_);
+}
+
+bool ShmRing::FetchCompletion(ShmRingCompletion* completion) {
+    return Pop(&header_->cq, cq_, completion);
+}
+
+int ShmRing::WaitRequest(int sock) {
+    return Wait(&header_->sq, sqEventFd_, sock);
+}
+
+int ShmRing::WaitCompletion(int sock) {
+    return Wait(&header_->cq, cqEventFd_, sock);
+}
+
+void ShmRing::SetDrained() {
+    // 和完成队列的tail一样使用release，part1看到drained时也能看到
+    // 之前提交的所有请求结果
+    header_->drained.store(1, std::memory_order_release);
+}
+
+bool ShmRing::IsDrained() const {
+    return header_->drained.load(std::memory_order_acquire) != 0;
+}
+
+char* ShmRing::GetSlot(uint32_t slot) const {
+    return slots_ + static_cast<size_t>(slot % depth_) * slotSize_;
+}
+
+template <typename T>
+bool ShmRing::Push(ShmRingQueue* queue, T* entries, const T& entry,
+                   int eventFd) {
+    uint32_t tail = queue->tail.load(std::memory_order_relaxed);
+    uint32_t head = queue->head.load(std::memory_order_acquire);
+    if (tail - head >= depth_) {
+        return false;
+    }
+    entries[tail & (depth_ - 1)] = entry;
+    queue->tail.store(tail + 1, std::memory_order_seq_cst);
+
+    // 和Wait中先设置waiting再检查tail配对，保证不会丢失唤醒
+    if (queue->waiting.load(std::memory_order_seq_cst) != 0 &&
+        queue->waiting.exchange(0) != 0) {
+        uint64_t value = 1;
+        ssize_t ret = write(eventFd, &value, sizeof(value));
+        (void)ret;
+    }
+    return true;
+}
+
+template <typename T>
+bool ShmRing::Pop(ShmRingQueue* queue, T* entries, T* entry) {
+    // 提交队列的head可能被part1通过RevokeRequests修改，需要CAS
+    uint32_t head = queue->head.load(std::memory_order_acquire);
+    while (true) {
+        uint32_t tail = queue->tail.load(std::memory_order_acquire);
+        if (head == tail) {
+            return false;
+        }
+        *entry = entries[head & (depth_ - 1)];
+        if (queue->head.compare_exchange_weak(head, head + 1,
+                                              std::memory_order_acq_rel)) {
+            return true;
+        }
+    }
+}
+
+int ShmRing::Wait(ShmRingQueue* queue, int eventFd, int sock) {
+    queue->waiting.store(1, std::memory_order_seq_cst);
+    if (queue->head.load(std::memory_order_relaxed) !=
+        queue->tail.load(std::memory_order_seq_cst)) {
+        queue->waiting.store(0, std::memory_order_relaxed);
+        return 0;
+    }
+
+    struct pollfd fds[2];
+    fds[0].fd = eventFd;
+    fds[0].events = POLLIN;
+    fds[1].fd = sock;
+    fds[1].events = POLLIN | POLLRDHUP;
+    int ret = 0;
+    do {
+        ret = poll(fds, 2, -1);
+    } while (ret < 0 && errno == EINTR);
+
+    // 握手之后sock上不会再有数据，有任何事件都认为对端已经断开
+    if (ret < 0 || fds[1].revents != 0) {
+        return -1;
+    }
+    if (fds[0].revents & POLLIN) {
+        uint64_t value = 0;
+        ssize_t rc = read(eventFd, &value, sizeof(value));
+        (void)rc;
+    }
+    queue->waiting.store(0, std::memory_order_relaxed);
+    return 0;
+}
+
+int ShmRing::Map(size_t size) {
+    char buffer[kBufSize];
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, memFd_, 0);
+    if (addr == MAP_FAILED) {
+        LOG(ERROR) << "Map shm ring failed, error = "
+                   << strerror_r(errno, buffer, kBufSize)
+                   << ", size = " << size;
+        return -1;
+    }
+    addr_ = static_cast<char*>(addr);
+    size_ = size;
+    return 0;
+}
+
+void ShmRing::Release() {
+    if (addr_ != nullptr) {
+        munmap(addr_, size_);
+        addr_ = nullptr;
+        size_ = 0;
+    }
+    header_ = nullptr;
+    sq_ = nullptr;
+    cq_ = nullptr;
+    slots_ = nullptr;
+    CloseFd(&memFd_);
+    CloseFd(&sqEventFd_);
+    CloseFd(&cqEventFd_);
+}
+
+}  // namespace common
+}  // namespace nebd
@@ -0,0 +1,205 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/**
+ * Project: nebd
+ */
+
+#ifndef NEBD_SRC_COMMON_SHM_RING_H_
+#define NEBD_SRC_COMMON_SHM_RING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nebd/src/common/uncopyable.h"
+
+namespace nebd {
+namespace common {
+
+// ring中请求的类型
+enum class ShmRingOp : uint32_t {
+    READ = 1,
+    WRITE = 2,
+};
+
+// 提交队列(sq)中的请求，由part1写入，part2读取
+struct ShmRingRequest {
+    // 请求的offset
+    uint64_t offset;
+    // 请求的长度
+    uint64_t length;
+    // 请求的文件fd
+    int32_t fd;
+    // 请求的类型
+    ShmRingOp op;
+    // 请求数据所在的slot，同时作为请求的id
+    uint32_t slot;
+    uint32_t reserved;
+};
+
+// 完成队列(cq)中的请求结果，由part2写入，part1读取
+struct ShmRingCompletion {
+    // 对应请求的slot
+    uint32_t slot;
+    // 请求的返回值，小于0表示失败
+    int32_t ret;
+};
+
+struct ShmRingHeader;
+struct ShmRingQueue;
+
+/**
+ * part1和part2之间基于共享内存的请求通道
+ *
+ * 共享内存由part1通过memfd创建，依次存放header、提交队列、完成队列以及
+ * depth个固定大小的数据slot。共享内存的大小在创建之后被封印，part2只接受
+ * 已经封印的共享内存，避免映射之后被截断。每个请求独占一个slot，读写数据
+ * 直接在slot中交换，因此提交队列和完成队列都不会溢出。
+ * 两个队列都是单生产者单消费者的，多线程提交时由调用方加锁。
+ * 连接断开后，part2等已经取出的请求都返回之后在header中设置drained标记，
+ * part1据此判断已经取出的请求是否都已返回。连接断开后part1可以通过CAS
+ * 移动提交队列的head收回part2还没有取出的请求，part2取请求时同样通过CAS
+ * 移动head，所以一个请求要么被part2取出，要么被part1收回。
+ * 消费者队列为空时在eventfd上等待，生产者只在消费者等待时才写eventfd，
+ * 所以繁忙时不会有额外的系统调用。
+ * 共享内存和eventfd通过unix socket以SCM_RIGHTS的方式传递给part2。
+ */
+class ShmRing : public Uncopyable {
+ public:
+    ShmRing();
+    ~ShmRing();
+
+    /**
+     * @brief 创建共享内存和eventfd并初始化ring，由part1调用
+     * @param depth 队列深度，必须为2的幂
+     * @param slotSize 每个slot的大小，必须为4KB的整数倍
+     * @return 成功返回0，失败返回-1
+     */
+    int Init(uint32_t depth, uint32_t slotSize);
+
+    /**
+     * @brief 把共享内存和eventfd发送给对端
+     * @param sock 已连接的unix socket
+     * @return 成功返回0，失败返回-1
+     */
+    int SendTo(int sock);
+
+    /**
+     * @brief 从对端接收共享内存和eventfd并映射，由part2调用
+     * @param sock 已连接的unix socket
+     * @return 成功返回0，失败返回-1
+     */
+    int RecvFrom(int sock);
+
+    /**
+     * @brief 提交请求，由part1调用
+     * @return 队列满时返回false
+     */
+    bool SubmitRequest(const ShmRingRequest& request);
+
+    /**
+     * @brief 取出一个请求，由part2调用
+     * @return 队列为空时返回false
+     */
+    bool FetchRequest(ShmRingRequest* request);
+
+    /**
+     * @brief 收回提交队列中part2还没有取出的请求，收回之后part2不会再取到
+     *        这些请求，由part1在连接断开后调用
+     * @return 收回的请求数
+     */
+    uint32_t RevokeRequests();
+
+    /**
+     * @brief 提交请求结果，由part2调用
+     * @return 队列满时返回false
+     */
+    bool SubmitCompletion(const ShmRingCompletion& completion);
+
+    /**
+     * @brief 取出一个请求结果，由part1调用
+     * @return 队列为空时返回false
+     */
+    bool FetchCompletion(ShmRingCompletion* completion);
+
+    /**
+     * @brief 等待提交队列中有请求，同时监听sock上的断开事件
+     * @return 有请求返回0，sock断开返回-1
+     */
+    int WaitRequest(int sock);
+
+    /**
+     * @brief 等待完成队列中有请求结果，同时监听sock上的断开事件
+     * @return 有请求结果返回0，sock断开返回-1
+     */
+    int WaitCompletion(int sock);
+
+    /**
+     * @brief 标记已经取出的请求都已提交结果，之后不再处理任何请求，
+     *        由part2在连接断开后调用
+     */
+    void SetDrained();
+
+    /**
+     * @brief part2是否已经确认不再处理ring上的请求，由part1调用
+     */
+    bool IsDrained() const;
+
+    char* GetSlot(uint32_t slot) const;
+
+    uint32_t GetDepth() const {
+        return depth_;
+    }
+
+    uint32_t GetSlotSize() const {
+        return slotSize_;
+    }
+
+    static size_t GetMemorySize(uint32_t depth, uint32_t slotSize);
+
+ private:
+    int Map(size_t size);
+    void Release();
+
+    template <typename T>
+    bool Push(ShmRingQueue* queue, T* entries, const T& entry, int eventFd);
+    template <typename T>
+    bool Pop(ShmRingQueue* queue, T* entries, T* entry);
+    int Wait(ShmRingQueue* queue, int eventFd, int sock);
+
+ private:
+    // 共享内存的fd
+    int memFd_;
+    // 提交队列的doorbell
+    int sqEventFd_;
+    // 完成队列的doorbell
+    int cqEventFd_;
+    // 共享内存的映射地址和大小
+    char* addr_;
+    size_t size_;
+
+    uint32_t depth_;
+    uint32_t slotSize_;
+    ShmRingHeader* header_;
+    ShmRingRequest* sq_;
+    ShmRingCompletion* cq_;
+    char* slots_;
+};
+
+}  // namespace common
+}  // namespace nebd
+
+#endif  // NEBD_SRC_COMMON_SHM_RING_H_
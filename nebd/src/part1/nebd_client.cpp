@@ -113,10 +113,19 @@ int NebdClient::Init(const char* confpath) {
         }
     }
 
+    if (option_.shmOption.enable) {
+        InitShmTransport();
+    }
+
     return 0;
 }
 
 void NebdClient::Uninit() {
+    if (shmTransport_ != nullptr) {
+        shmTransport_->Fini();
+        shmTransport_.reset();
+    }
+
     if (heartbeatMgr_ != nullptr) {
         heartbeatMgr_->Stop();
     }
@@ -327,6 +336,14 @@ int NebdClient::Discard(int fd, NebdClientAioContext* aioctx) {
 }
 
 int NebdClient::AioRead(int fd, NebdClientAioContext* aioctx) {
+    if (shmTransport_ != nullptr && shmTransport_->AioRead(fd, aioctx)) {
+        return 0;
+    }
+
+    return AioReadByRpc(fd, aioctx);
+}
+
+int NebdClient::AioReadByRpc(int fd, NebdClientAioContext* aioctx) {
     auto task = [this, fd, aioctx]() {
         nebd::client::NebdFileService_Stub stub(&channel_);
         nebd::client::ReadRequest request;
@@ -349,6 +366,14 @@ int NebdClient::AioRead(int fd, NebdClientAioContext* aioctx) {
 static void EmptyDeleter(void* m) {}
 
 int NebdClient::AioWrite(int fd, NebdClientAioContext* aioctx) {
+    if (shmTransport_ != nullptr && shmTransport_->AioWrite(fd, aioctx)) {
+        return 0;
+    }
+
+    return AioWriteByRpc(fd, aioctx);
+}
+
+int NebdClient::AioWriteByRpc(int fd, NebdClientAioContext* aioctx) {
     auto task = [this, fd, aioctx]() {
         nebd::client::NebdFileService_Stub stub(&channel_);
         nebd::client::WriteRequest request;
@@ -518,6 +543,27 @@ int NebdClient::InitNebdClientOption(Configuration* conf) {
 
     option_.requestOption = requestOption;
 
+    ShmTransportOption shmOption;
+    shmOption.enable = conf->GetBoolValue("shm.enable", false);
+    if (shmOption.enable) {
+        ret = conf->GetStringValue("nebdserver.shmAddress",
+                                   &shmOption.serverAddress);
+        LOG_IF(ERROR, ret != true) << "Load nebdserver.shmAddress failed";
+        RETURN_IF_FALSE(ret);
+
+        ret = conf->GetUInt32Value("shm.ringDepth", &shmOption.ringDepth);
+        LOG_IF(ERROR, ret != true)
+            << "Load shm.ringDepth from config file failed, current value is "
+            << shmOption.ringDepth;
+
+        ret = conf->GetUInt32Value("shm.slotSize", &shmOption.slotSize);
+        LOG_IF(ERROR, ret != true)
+            << "Load shm.slotSize from config file failed, current value is "
+            << shmOption.slotSize;
+    }
+
+    option_.shmOption = shmOption;
+
     ret = conf->GetStringValue("log.path", &option_.logOption.logPath);
     LOG_IF(ERROR, ret != true) << "Load log.path failed";
     RETURN_IF_FALSE(ret);
@@ -561,6 +607,24 @@ int NebdClient::InitChannel() {
     return 0;
 }
 
+void NebdClient::InitShmTransport() {
+    auto fallback = [this](int fd, NebdClientAioContext* aioctx) {
+        if (aioctx->op == LIBAIO_OP::LIBAIO_OP_READ) {
+            AioReadByRpc(fd, aioctx);
+        } else {
+            AioWriteByRpc(fd, aioctx);
+        }
+    };
+
+    shmTransport_ = std::make_shared<ShmTransport>();
+    int ret = shmTransport_->Init(option_.shmOption, fallback);
+    if (ret != 0) {
+        LOG(WARNING) << "Init shm transport failed, read and write requests "
+                     << "will be sent by rpc";
+        shmTransport_.reset();
+    }
+}
+
 int64_t NebdClient::ExecuteSyncRpc(RpcTask task) {
     int64_t retryTimes = 0;
     int64_t ret = 0;
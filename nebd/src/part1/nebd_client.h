@@ -37,6 +37,7 @@
 #include "nebd/src/part1/libnebd.h"
 #include "nebd/src/part1/heartbeat_manager.h"
 #include "nebd/src/part1/nebd_metacache.h"
+#include "nebd/src/part1/shm_transport.h"
 
 #include "include/curve_compiler_specific.h"
 
@@ -154,6 +155,17 @@ class NebdClient {
 
     int InitChannel();
 
+    /**
+     * @brief 初始化共享内存通道，失败时读写请求走rpc
+     */
+    void InitShmTransport();
+
+    /**
+     * @brief 通过rpc发送读写请求
+     */
+    int AioReadByRpc(int fd, NebdClientAioContext* aioctx);
+    int AioWriteByRpc(int fd, NebdClientAioContext* aioctx);
+
     void InitLogger(const LogOption& logOption);
 
     /**
@@ -169,6 +181,8 @@ class NebdClient {
     std::shared_ptr<HeartbeatManager> heartbeatMgr_;
     // 缓存模块
     std::shared_ptr<NebdClientMetaCache> metaCache_;
+    // 共享内存通道，未启用或者不可用时为nullptr
+    std::shared_ptr<ShmTransport> shmTransport_;
 
     NebdClientOption option_;
 
@@ -49,6 +49,18 @@ struct LogOption {
     std::string logPath;
 };
 
+// 共享内存通道配置项
+struct ShmTransportOption {
+    // 是否启用共享内存通道，不可用时读写请求走rpc
+    bool enable = false;
+    // part2 shm socket file address
+    std::string serverAddress;
+    // 队列深度，必须为2的幂
+    uint32_t ringDepth = 128;
+    // 每个slot的大小，超过slot大小的请求走rpc
+    uint32_t slotSize = 64 * 1024;
+};
+
 // nebd client配置项
 struct NebdClientOption {
     // part2 socket file address
@@ -59,6 +71,8 @@ struct NebdClientOption {
     RequestOption requestOption;
     // 日志配置项
     LogOption logOption;
+    // 共享内存通道配置项
+    ShmTransportOption shmOption;
 };
 
 // heartbeat配置项
@@ -0,0 +1,380 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ */
+
+#include "nebd/src/part1/shm_transport.h"
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <string>
+
+namespace nebd {
+namespace client {
+
+using nebd::common::ShmRingRequest;
+
+// 等待part2映射共享内存的超时时间
+const int kShmHandshakeTimeoutS = 1;
+// 通道断开后重新协商的间隔，每次失败后翻倍
+const int kShmReconnectIntervalMs = 1000;
+const int kShmMaxReconnectIntervalMs = 60 * 1000;
+// 通道断开后等待part2处理完已取出请求的超时时间和检查间隔
+const int kShmDrainTimeoutMs = 10 * 1000;
+const int kShmDrainCheckIntervalMs = 10;
+const int kBufSize = 128;
+
+ShmTransport::ShmTransport()
+    : sock_(-1),
+      available_(false),
+      stopped_(false) {}
+
+ShmTransport::~ShmTransport() {
+    Fini();
+}
+
+int ShmTransport::Init(const ShmTransportOption& option,
+                       const ShmFallback& fallback) {
+    option_ = option;
+    fallback_ = fallback;
+    if (Negotiate() != 0) {
+        return -1;
+    }
+
+    completionThread_ = std::thread(&ShmTransport::CompletionFunc, this);
+
+    LOG(INFO) << "Init shm transport success, address = "
+              << option.serverAddress
+              << ", ring depth = " << option.ringDepth
+              << ", slot size = " << option.slotSize;
+    return 0;
+}
+
+void ShmTransport::Fini() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopped_ = true;
+        // 关闭socket唤醒completion线程
+        if (sock_ >= 0) {
+            shutdown(sock_, SHUT_RDWR);
+        }
+    }
+    stopCond_.notify_all();
+
+    if (completionThread_.joinable()) {
+        completionThread_.join();
+    }
+}
+
+bool ShmTransport::AioRead(int fd, NebdClientAioContext* aioctx) {
+    return Submit(fd, ShmRingOp::READ, aioctx);
+}
+
+bool ShmTransport::AioWrite(int fd, NebdClientAioContext* aioctx) {
+    return Submit(fd, ShmRingOp::WRITE, aioctx);
+}
+
+bool ShmTransport::Submit(int fd, ShmRingOp op,
+                          NebdClientAioContext* aioctx) {
+    std::shared_ptr<ShmRing> ring;
+    uint32_t slot = 0;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!available_ || freeSlots_.empty() ||
+            aioctx->length > ring_->GetSlotSize()) {
+            return false;
+        }
+        ring = ring_;
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+        inflight_[slot] = {fd, aioctx};
+    }
+
+    // 拷贝数据时不持锁，多个线程可以并发提交
+    // 持有ring的引用，拷贝期间重新协商也不会释放正在使用的共享内存
+    if (op == ShmRingOp::WRITE) {
+        memcpy(ring->GetSlot(slot), aioctx->buf, aioctx->length);
+    }
+
+    ShmRingRequest request;
+    memset(&request, 0, sizeof(request));
+    request.offset = aioctx->offset;
+    request.length = aioctx->length;
+    request.fd = fd;
+    request.op = op;
+    request.slot = slot;
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    // 通道已经断开(或者已经重新协商)，请求已经由OnDisconnect交给了fallback
+    if (!available_ || ring != ring_) {
+        return true;
+    }
+    // 每个请求独占一个slot，提交队列不会满
+    CHECK(ring_->SubmitRequest(request));
+    return true;
+}
+
+int ShmTransport::Negotiate() {
+    auto ring = std::make_shared<ShmRing>();
+    if (ring->Init(option_.ringDepth, option_.slotSize) != 0) {
+        LOG(ERROR) << "Init shm ring failed";
+        return -1;
+    }
+
+    int sock = Connect(option_.serverAddress, ring.get());
+    if (sock < 0) {
+        return -1;
+    }
+
+    uint32_t depth = ring->GetDepth();
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (stopped_) {
+        close(sock);
+        return -1;
+    }
+    ring_ = ring;
+    sock_ = sock;
+    inflight_.assign(depth, {-1, nullptr});
+    freeSlots_.clear();
+    freeSlots_.reserve(depth);
+    for (uint32_t i = 0; i < depth; ++i) {
+        freeSlots_.push_back(depth - 1 - i);
+    }
+    available_ = true;
+    return 0;
+}
+
+int ShmTransport::Connect(const std::string& address, ShmRing* ring) {
+    char buffer[kBufSize];
+    struct sockaddr_un addr;
+    if (address.size() >= sizeof(addr.sun_path)) {
+        LOG(ERROR) << "Shm server address too long, address = " << address;
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, address.c_str(), sizeof(addr.sun_path) - 1);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        LOG(ERROR) << "Create socket failed, error = "
+                   << strerror_r(errno, buffer, kBufSize);
+        return -1;
+    }
+
+    struct timeval timeout = {kShmHandshakeTimeoutS, 0};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    int ret = connect(sock, reinterpret_cast<struct sockaddr*>(&addr),
+                      sizeof(addr));
+    if (ret != 0) {
+        LOG(WARNING) << "Connect to shm server failed, error = "
+                     << strerror_r(errno, buffer, kBufSize)
+                     << ", address = " << address;
+        close(sock);
+        return -1;
+    }
+
+    // part2映射共享内存成功后返回一个字节的0
+    char ack = -1;
+    if (ring->SendTo(sock) != 0 ||
+        recv(sock, &ack, sizeof(ack), 0) != sizeof(ack) || ack != 0) {
+        LOG(WARNING) << "Shm handshake failed, address = " << address;
+        close(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+void ShmTransport::CompletionFunc() {
+    while (true) {
+        std::shared_ptr<ShmRing> ring;
+        int sock = -1;
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            ring = ring_;
+            sock = sock_;
+        }
+
+        ProcessCompletion(ring.get(), sock);
+        OnDisconnect(ring.get());
+
+        if (!WaitReconnect()) {
+            break;
+        }
+    }
+}
+
+void ShmTransport::ProcessCompletion(ShmRing* ring, int sock) {
+    while (true) {
+        ShmRingCompletion completion;
+        if (!ring->FetchCompletion(&completion)) {
+            if (ring->WaitCompletion(sock) != 0) {
+                break;
+            }
+            continue;
+        }
+        HandleCompletion(ring, completion);
+    }
+}
+
+void ShmTransport::HandleCompletion(ShmRing* ring,
+                                    const ShmRingCompletion& completion) {
+    uint32_t slot = completion.slot % ring->GetDepth();
+    InflightRequest request;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        request = inflight_[slot];
+    }
+    NebdClientAioContext* aioctx = request.aioctx;
+    if (aioctx == nullptr) {
+        LOG(ERROR) << "Unexpected shm completion, slot = " << slot;
+        return;
+    }
+
+    if (completion.ret < 0) {
+        LOG(ERROR) << "Shm request failed, fd = " << request.fd
+                   << ", op = " << aioctx->op
+                   << ", offset = " << aioctx->offset
+                   << ", length = " << aioctx->length
+                   << ", ret = " << completion.ret;
+        aioctx->ret = -1;
+    } else {
+        if (aioctx->op == LIBAIO_OP::LIBAIO_OP_READ) {
+            memcpy(aioctx->buf, ring->GetSlot(slot), aioctx->length);
+        }
+        aioctx->ret = 0;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        inflight_[slot] = {-1, nullptr};
+        freeSlots_.push_back(slot);
+    }
+    aioctx->cb(aioctx);
+}
+
+void ShmTransport::OnDisconnect(ShmRing* ring) {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        available_ = false;
+        close(sock_);
+        sock_ = -1;
+    }
+
+    // 先收回part2还没有取出的请求，这些请求一定没有执行过，part2崩溃或者
+    // 重启时也可以安全地重新提交
+    uint32_t revoked = ring->RevokeRequests();
+
+    // part2可能只是断开了socket，已经取出的请求还在执行。等part2确认
+    // 这些请求都已返回，否则重新提交的写请求可能和旧的请求乱序落盘
+    bool drained = WaitDrained(ring);
+
+    // 断开之前已经返回的请求直接完成，不能重复提交
+    ShmRingCompletion completion;
+    while (ring->FetchCompletion(&completion)) {
+        HandleCompletion(ring, completion);
+    }
+
+    std::vector<InflightRequest> requests;
+    bool stopped = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        stopped = stopped_;
+        for (auto& request : inflight_) {
+            if (request.aioctx != nullptr) {
+                requests.push_back(request);
+                request = {-1, nullptr};
+            }
+        }
+    }
+
+    if (stopped) {
+        LOG(ERROR) << "Shm transport stopped, "
+                   << requests.size() << " requests failed";
+        // Fini之后不能再走rpc
+        for (auto& request : requests) {
+            request.aioctx->ret = -1;
+            request.aioctx->cb(request.aioctx);
+        }
+        return;
+    }
+
+    if (drained) {
+        LOG(WARNING) << "Shm transport disconnected, "
+                     << requests.size() << " requests fall back to rpc";
+    } else {
+        // part2崩溃或者重启后不会确认drain，已经取出但没有返回的请求和
+        // rpc超时一样重试，由rpc的重试逻辑保证最终完成
+        LOG(WARNING) << "Shm transport disconnected and part2 did not drain "
+                     << "the ring, " << requests.size() << " requests fall "
+                     << "back to rpc, " << revoked << " of them never fetched";
+    }
+    for (auto& request : requests) {
+        fallback_(request.fd, request.aioctx);
+    }
+}
+
+bool ShmTransport::WaitDrained(ShmRing* ring) {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(kShmDrainTimeoutMs);
+    std::unique_lock<std::mutex> lock(mtx_);
+    while (!ring->IsDrained()) {
+        // Fini之后不再等待
+        if (stopped_ || std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        stopCond_.wait_for(lock,
+                           std::chrono::milliseconds(kShmDrainCheckIntervalMs));
+    }
+    return true;
+}
+
+bool ShmTransport::WaitReconnect() {
+    int intervalMs = kShmReconnectIntervalMs;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            stopCond_.wait_for(lock, std::chrono::milliseconds(intervalMs),
+                               [this]() { return stopped_; });
+            if (stopped_) {
+                return false;
+            }
+        }
+
+        // part2重启之后重新创建共享内存并协商，旧的共享内存在
+        // 所有引用释放之后回收
+        if (Negotiate() == 0) {
+            LOG(INFO) << "Shm transport reconnected, address = "
+                      << option_.serverAddress;
+            return true;
+        }
+        intervalMs = std::min(intervalMs * 2, kShmMaxReconnectIntervalMs);
+    }
+}
+
+}  // namespace client
+}  // namespace nebd
@@ -0,0 +1,146 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ */
+
+#ifndef NEBD_SRC_PART1_SHM_TRANSPORT_H_
+#define NEBD_SRC_PART1_SHM_TRANSPORT_H_
+
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <memory>
+#include <string>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "nebd/src/common/shm_ring.h"
+#include "nebd/src/part1/libnebd.h"
+#include "nebd/src/part1/nebd_common.h"
+
+namespace nebd {
+namespace client {
+
+using nebd::common::ShmRing;
+using nebd::common::ShmRingOp;
+using nebd::common::ShmRingCompletion;
+
+// 共享内存通道断开后，未完成的请求通过该函数改走rpc
+using ShmFallback = std::function<void(int fd, NebdClientAioContext* aioctx)>;
+
+/**
+ * part1端的共享内存通道
+ *
+ * 读写请求的数据直接拷贝到和part2共享的slot中，省去了rpc的序列化和
+ * socket的收发。slot用完或者请求超过slot大小时返回false，由调用方走rpc。
+ * 通道断开后，先收回part2没有取出的请求，再等待part2确认已经取出的请求
+ * 都已返回，之后所有未完成的请求通过fallback重新走rpc。part2崩溃或重启
+ * 时不会确认，超时后已经取出的请求和rpc超时一样重试。
+ * 之后的请求先走rpc，同时后台定期重新创建共享内存和part2协商，协商成功后
+ * 恢复使用共享内存。
+ */
+class ShmTransport {
+ public:
+    ShmTransport();
+    ~ShmTransport();
+
+    /**
+     * @brief 创建共享内存并连接part2
+     * @param option 共享内存通道配置项
+     * @param fallback 通道断开时重新提交未完成请求的函数
+     * @return 成功返回0，失败返回-1
+     */
+    int Init(const ShmTransportOption& option, const ShmFallback& fallback);
+
+    /**
+     * @brief 断开和part2的连接
+     */
+    void Fini();
+
+    /**
+     * @brief 通过共享内存发送读请求
+     * @return 请求已提交返回true，返回false时需要走rpc
+     */
+    bool AioRead(int fd, NebdClientAioContext* aioctx);
+
+    /**
+     * @brief 通过共享内存发送写请求
+     * @return 请求已提交返回true，返回false时需要走rpc
+     */
+    bool AioWrite(int fd, NebdClientAioContext* aioctx);
+
+ private:
+    struct InflightRequest {
+        int fd;
+        NebdClientAioContext* aioctx;
+    };
+
+    bool Submit(int fd, ShmRingOp op, NebdClientAioContext* aioctx);
+
+    // 创建新的共享内存并和part2握手，成功后替换当前的ring
+    int Negotiate();
+
+    // 连接part2并发送共享内存，成功返回socket，失败返回-1
+    int Connect(const std::string& address, ShmRing* ring);
+
+    // 处理part2返回的请求结果，断开后重新协商
+    void CompletionFunc();
+
+    // 处理ring上的请求结果，直到sock断开
+    void ProcessCompletion(ShmRing* ring, int sock);
+
+    // 完成一个请求结果对应的请求
+    void HandleCompletion(ShmRing* ring, const ShmRingCompletion& completion);
+
+    // 通道断开后把未完成的请求交给fallback，Fini之后返回失败
+    void OnDisconnect(ShmRing* ring);
+
+    // 等待part2确认已经取出的请求都已返回
+    // @return 确认返回true，超时或者Fini返回false
+    bool WaitDrained(ShmRing* ring);
+
+    // 等待一段时间后重新协商，直到成功或者Fini
+    // @return 协商成功返回true，Fini返回false
+    bool WaitReconnect();
+
+ private:
+    ShmTransportOption option_;
+    ShmFallback fallback_;
+
+    // 保护ring_、sock_、available_、stopped_、freeSlots_、inflight_
+    // 以及提交队列
+    std::mutex mtx_;
+    // 每次协商都会创建新的ring，提交线程拷贝数据期间持有旧ring的引用
+    std::shared_ptr<ShmRing> ring_;
+    // 和part2之间的unix socket，用于传递共享内存以及检测对端断开
+    int sock_;
+    bool available_;
+    // Fini之后不再重新协商
+    bool stopped_;
+    std::condition_variable stopCond_;
+    std::vector<uint32_t> freeSlots_;
+    // 以slot为下标记录未完成的请求
+    std::vector<InflightRequest> inflight_;
+
+    std::thread completionThread_;
+};
+
+}  // namespace client
+}  // namespace nebd
+
+#endif  // NEBD_SRC_PART1_SHM_TRANSPORT_H_
@@ -119,6 +119,7 @@ const char METAFILEPATH[] = "meta.file.path";
 const char HEARTBEATTIMEOUTSEC[] = "heartbeat.timeout.sec";
 const char HEARTBEATCHECKINTERVALMS[] = "heartbeat.check.interval.ms";
 const char CURVECLIENTCONFPATH[] = "curveclient.confPath";
+const char SHMLISTENADDRESS[] = "shm.listen.address";
 
 }  // namespace server
 }  // namespace nebd
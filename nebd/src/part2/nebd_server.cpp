@@ -51,6 +51,11 @@ int NebdServer::Init(const std::string &confPath,
     }
     LOG(INFO) << "NebdServer init socket file address ok";
 
+    // 共享内存通道是可选的，没有配置时不启用
+    if (!conf_.GetStringValue(SHMLISTENADDRESS, &shmListenAddress_)) {
+        shmListenAddress_.clear();
+    }
+
     curveClient_ = curveClient;
     bool initExecutorOk = InitCurveRequestExecutor();
     if (false == initExecutorOk) {
@@ -243,13 +248,32 @@ bool NebdServer::StartServer() {
         return false;
     }
 
+    StartShmRingService();
+
     isRunning_ = true;
     server_.RunUntilAskedToQuit();
 
     isRunning_ = false;
+    if (shmRingService_ != nullptr) {
+        shmRingService_->Stop();
+    }
     fileLock.ReleaseFileLock();
     return true;
 }
 
+void NebdServer::StartShmRingService() {
+    if (shmListenAddress_.empty()) {
+        return;
+    }
+
+    shmRingService_ = std::make_shared<NebdShmRingService>(fileManager_);
+    int ret = shmRingService_->Start(shmListenAddress_);
+    if (ret != 0) {
+        LOG(WARNING) << "NebdServer start shm ring service fail, "
+                     << "requests will be served by rpc";
+        shmRingService_ = nullptr;
+    }
+}
+
 }  // namespace server
 }  // namespace nebd
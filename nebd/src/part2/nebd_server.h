@@ -30,6 +30,7 @@
 #include "nebd/src/part2/file_manager.h"
 #include "nebd/src/part2/heartbeat_manager.h"
 #include "nebd/src/part2/request_executor_curve.h"
+#include "nebd/src/part2/shm_ring_service.h"
 
 namespace nebd {
 namespace server {
@@ -95,11 +96,18 @@ class NebdServer {
      */
     bool StartServer();
 
+    /**
+     * @brief 启动共享内存通道服务，启动失败时part1的请求走rpc
+     */
+    void StartShmRingService();
+
  private:
     // 配置项
     Configuration conf_;
     // NebdServer监听地址
     std::string listenAddress_;
+    // 共享内存通道的监听地址，为空表示不启用
+    std::string shmListenAddress_;
     // NebdServer是否处于running状态
     bool isRunning_ =  false;
 
@@ -111,6 +119,8 @@ class NebdServer {
     std::shared_ptr<HeartbeatManager> heartbeatManager_;
     // curveclient
     std::shared_ptr<CurveClient> curveClient_;
+    // 共享内存通道服务
+    std::shared_ptr<NebdShmRingService> shmRingService_;
 };
 
 }  // namespace server
@@ -154,9 +154,24 @@ int CurveRequestExecutor::GetInfo(
 
 int CurveRequestExecutor::Discard(
     NebdFileInstance* fd, NebdServerAioContext* aioctx) {
+    int curveFd = GetCurveFdFromNebdFileInstance(fd);
+    if (curveFd < 0) {
+        return -1;
+    }
 
-    aioctx->ret = 0;
-    aioctx->cb(aioctx);
+    CurveAioCombineContext *curveCombineCtx = new CurveAioCombineContext();
+    curveCombineCtx->nebdCtx = aioctx;
+    int ret = FromNebdCtxToCurveCtx(aioctx, &curveCombineCtx->curveCtx);
+    if (ret < 0) {
+        delete curveCombineCtx;
+        return -1;
+    }
+
+    ret = client_->AioDiscard(curveFd, &curveCombineCtx->curveCtx);
+    if (ret !=  LIBCURVE_ERROR::OK) {
+        delete curveCombineCtx;
+        return -1;
+    }
 
     return 0;
 }
@@ -271,6 +286,9 @@ int CurveRequestExecutor::FromNebdOpToCurveOp(LIBAIO_OP op, LIBCURVE_OP *out) {
     case LIBAIO_OP::LIBAIO_OP_WRITE:
         *out = LIBCURVE_OP_WRITE;
         return 0;
+    case LIBAIO_OP::LIBAIO_OP_DISCARD:
+        *out = LIBCURVE_OP_DISCARD;
+        return 0;
 
     default:
         return -1;
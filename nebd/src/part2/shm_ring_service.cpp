@@ -0,0 +1,268 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ */
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <glog/logging.h>
+#include <butil/iobuf.h>
+
+#include <cstring>
+
+#include "nebd/src/part2/shm_ring_service.h"
+
+namespace nebd {
+namespace server {
+
+static void EmptyDeleter(void* m) {}
+
+static void CompleteRequest(ShmRingConnection* conn, uint32_t slot, int ret) {
+    ShmRingCompletion completion;
+    completion.slot = slot;
+    completion.ret = ret < 0 ? -1 : 0;
+
+    std::lock_guard<std::mutex> lock(conn->mtx);
+    // part1每个请求独占一个slot，正常情况下完成队列不会满
+    if (!conn->ring.SubmitCompletion(completion)) {
+        LOG(ERROR) << "Shm completion queue is full, slot = " << slot;
+    }
+    if (--conn->inflight == 0) {
+        conn->cond.notify_all();
+    }
+}
+
+void NebdShmRingCallback(NebdServerAioContext* context) {
+    CHECK(context != nullptr);
+    std::unique_ptr<ShmRingAioContext> contextGuard(
+        static_cast<ShmRingAioContext*>(context));
+    std::unique_ptr<butil::IOBuf> iobufGuard(
+        reinterpret_cast<butil::IOBuf*>(context->buf));
+    ShmRingConnection* conn = contextGuard->conn;
+    uint32_t slot = contextGuard->slot;
+
+    int ret = context->ret;
+    if (ret < 0) {
+        LOG(ERROR) << (context->op == LIBAIO_OP::LIBAIO_OP_READ ?
+                       "Read" : "Write")
+                   << " file failed. offset: " << context->offset
+                   << ", size: " << context->size
+                   << ", return code: " << ret;
+    } else if (context->op == LIBAIO_OP::LIBAIO_OP_READ) {
+        size_t copySize = iobufGuard->copy_to(conn->ring.GetSlot(slot),
+                                              context->size);
+        if (copySize != context->size) {
+            LOG(ERROR) << "Copy read data failed. "
+                       << "offset: " << context->offset
+                       << ", size: " << context->size
+                       << ", copy size: " << copySize;
+            ret = -1;
+        }
+    }
+
+    CompleteRequest(conn, slot, ret);
+}
+
+NebdShmRingService::~NebdShmRingService() {
+    Stop();
+}
+
+int NebdShmRingService::Start(const std::string& address) {
+    struct sockaddr_un addr;
+    if (address.size() >= sizeof(addr.sun_path)) {
+        LOG(ERROR) << "Shm listen address too long, address: " << address;
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, address.c_str(), sizeof(addr.sun_path) - 1);
+
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) {
+        LOG(ERROR) << "Create shm listen socket failed, errno: " << errno;
+        return -1;
+    }
+
+    // 调用方已经持有listen address的文件锁，残留的socket文件可以直接删除
+    unlink(address.c_str());
+    int ret = bind(listenFd_, reinterpret_cast<struct sockaddr*>(&addr),
+                   sizeof(addr));
+    if (ret != 0 || listen(listenFd_, SOMAXCONN) != 0) {
+        LOG(ERROR) << "Listen on shm address failed, address: " << address
+                   << ", errno: " << errno;
+        close(listenFd_);
+        listenFd_ = -1;
+        return -1;
+    }
+
+    address_ = address;
+    running_ = true;
+    acceptThread_ = std::thread(&NebdShmRingService::AcceptFunc, this);
+    LOG(INFO) << "Shm ring service listen on " << address;
+    return 0;
+}
+
+void NebdShmRingService::Stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    // 唤醒阻塞在accept上的线程
+    shutdown(listenFd_, SHUT_RDWR);
+    acceptThread_.join();
+    close(listenFd_);
+    listenFd_ = -1;
+    unlink(address_.c_str());
+
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto& conn : connections_) {
+            shutdown(conn->sock, SHUT_RDWR);
+        }
+    }
+    ReapConnections(true);
+    LOG(INFO) << "Shm ring service stopped";
+}
+
+void NebdShmRingService::AcceptFunc() {
+    while (running_) {
+        int sock = accept4(listenFd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (sock < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (running_) {
+                LOG(ERROR) << "Accept shm connection failed, errno: "
+                           << errno;
+            }
+            break;
+        }
+
+        ReapConnections(false);
+
+        auto conn = std::make_shared<ShmRingConnection>();
+        conn->sock = sock;
+        std::lock_guard<std::mutex> lock(mtx_);
+        conn->th = std::thread(&NebdShmRingService::ServeFunc,
+                               this, conn.get());
+        connections_.push_back(conn);
+    }
+}
+
+void NebdShmRingService::ServeFunc(ShmRingConnection* conn) {
+    // 映射共享内存成功后回复一个字节的0
+    char ack = 0;
+    if (conn->ring.RecvFrom(conn->sock) != 0 ||
+        send(conn->sock, &ack, sizeof(ack), MSG_NOSIGNAL) != sizeof(ack)) {
+        LOG(ERROR) << "Shm handshake failed";
+        conn->finished = true;
+        return;
+    }
+    LOG(INFO) << "Shm ring connected, ring depth: " << conn->ring.GetDepth()
+              << ", slot size: " << conn->ring.GetSlotSize();
+
+    while (true) {
+        ShmRingRequest request;
+        if (!conn->ring.FetchRequest(&request)) {
+            if (conn->ring.WaitRequest(conn->sock) != 0) {
+                break;
+            }
+            continue;
+        }
+        Dispatch(conn, request);
+    }
+
+    // 请求返回时会访问共享内存，等所有请求返回后才能释放
+    std::unique_lock<std::mutex> lock(conn->mtx);
+    conn->cond.wait(lock, [conn]() { return conn->inflight == 0; });
+    // 通知part1已经取出的请求都已返回，提交队列中剩下的请求不会再被执行，
+    // part1可以安全地把它们改走rpc
+    conn->ring.SetDrained();
+    LOG(INFO) << "Shm ring disconnected";
+    conn->finished = true;
+}
+
+void NebdShmRingService::Dispatch(ShmRingConnection* conn,
+                                  const ShmRingRequest& request) {
+    uint32_t slot = request.slot % conn->ring.GetDepth();
+    {
+        std::lock_guard<std::mutex> lock(conn->mtx);
+        ++conn->inflight;
+    }
+
+    if (request.length > conn->ring.GetSlotSize() ||
+        (request.op != ShmRingOp::READ && request.op != ShmRingOp::WRITE)) {
+        LOG(ERROR) << "Invalid shm request. "
+                   << "fd: " << request.fd
+                   << ", op: " << static_cast<uint32_t>(request.op)
+                   << ", size: " << request.length;
+        CompleteRequest(conn, slot, -1);
+        return;
+    }
+
+    ShmRingAioContext* aioContext = new ShmRingAioContext();
+    aioContext->offset = request.offset;
+    aioContext->size = request.length;
+    aioContext->cb = NebdShmRingCallback;
+    aioContext->conn = conn;
+    aioContext->slot = slot;
+
+    // 写请求的数据直接引用共享内存，不做拷贝
+    butil::IOBuf* buf = new butil::IOBuf();
+    aioContext->buf = buf;
+
+    int rc = 0;
+    if (request.op == ShmRingOp::READ) {
+        aioContext->op = LIBAIO_OP::LIBAIO_OP_READ;
+        rc = fileManager_->AioRead(request.fd, aioContext);
+    } else {
+        aioContext->op = LIBAIO_OP::LIBAIO_OP_WRITE;
+        buf->append_user_data(conn->ring.GetSlot(slot), request.length,
+                              EmptyDeleter);
+        rc = fileManager_->AioWrite(request.fd, aioContext);
+    }
+
+    if (rc < 0) {
+        aioContext->ret = rc;
+        NebdShmRingCallback(aioContext);
+    }
+}
+
+void NebdShmRingService::ReapConnections(bool all) {
+    std::list<std::shared_ptr<ShmRingConnection>> finished;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        for (auto iter = connections_.begin(); iter != connections_.end();) {
+            if (all || (*iter)->finished) {
+                finished.push_back(*iter);
+                iter = connections_.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
+    for (auto& conn : finished) {
+        conn->th.join();
+        close(conn->sock);
+    }
+}
+
+}  // namespace server
+}  // namespace nebd
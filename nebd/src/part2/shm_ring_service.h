@@ -0,0 +1,119 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ */
+
+#ifndef NEBD_SRC_PART2_SHM_RING_SERVICE_H_
+#define NEBD_SRC_PART2_SHM_RING_SERVICE_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+
+#include "nebd/src/common/shm_ring.h"
+#include "nebd/src/part2/file_manager.h"
+
+namespace nebd {
+namespace server {
+
+using nebd::common::ShmRing;
+using nebd::common::ShmRingOp;
+using nebd::common::ShmRingRequest;
+using nebd::common::ShmRingCompletion;
+
+// 一个part1进程的共享内存连接
+struct ShmRingConnection {
+    int sock = -1;
+    ShmRing ring;
+    // 请求结果由curve client的回调线程并发提交，需要加锁
+    std::mutex mtx;
+    std::condition_variable cond;
+    // 已经下发还没有返回的请求数，由mtx保护
+    int64_t inflight = 0;
+    // 连接断开并且所有请求都已返回
+    std::atomic<bool> finished{false};
+    std::thread th;
+};
+
+// 共享内存请求的上下文
+struct ShmRingAioContext : public NebdServerAioContext {
+    ShmRingConnection* conn = nullptr;
+    uint32_t slot = 0;
+};
+
+void NebdShmRingCallback(NebdServerAioContext* context);
+
+/**
+ * part2端的共享内存通道服务
+ *
+ * 监听一个单独的unix socket，part1连接以后通过该socket传递共享内存和
+ * eventfd，之后读写请求直接从共享内存的提交队列中取出，交给
+ * NebdFileManager处理，结果写回完成队列。
+ * 每个连接由一个线程轮询提交队列，连接断开后等待已下发的请求都返回，
+ * 在共享内存中设置drained标记通知part1，然后才释放共享内存。
+ */
+class NebdShmRingService {
+ public:
+    explicit NebdShmRingService(std::shared_ptr<NebdFileManager> fileManager)
+        : fileManager_(fileManager), listenFd_(-1), running_(false) {}
+    virtual ~NebdShmRingService();
+
+    /**
+     * @brief 在指定地址上监听part1的连接
+     * @param address unix socket file address
+     * @return 成功返回0，失败返回-1
+     */
+    int Start(const std::string& address);
+
+    /**
+     * @brief 断开所有连接并停止服务
+     */
+    void Stop();
+
+ private:
+    void AcceptFunc();
+
+    void ServeFunc(ShmRingConnection* conn);
+
+    void Dispatch(ShmRingConnection* conn, const ShmRingRequest& request);
+
+    /**
+     * @brief 回收已经结束的连接
+     * @param all 为true时等待所有连接结束
+     */
+    void ReapConnections(bool all);
+
+ private:
+    std::shared_ptr<NebdFileManager> fileManager_;
+    std::string address_;
+    int listenFd_;
+    std::atomic<bool> running_;
+    std::thread acceptThread_;
+
+    std::mutex mtx_;
+    std::list<std::shared_ptr<ShmRingConnection>> connections_;
+};
+
+}  // namespace server
+}  // namespace nebd
+
+#endif  // NEBD_SRC_PART2_SHM_RING_SERVICE_H_
@@ -0,0 +1,220 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/**
+ * Project: nebd
+ */
+
+#include <gtest/gtest.h>
+#include <linux/memfd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <thread>  // NOLINT
+
+#include "nebd/src/common/shm_ring.h"
+
+namespace nebd {
+namespace common {
+
+const uint32_t kDepth = 4;
+const uint32_t kSlotSize = 4096;
+
+class ShmRingTest : public ::testing::Test {
+ protected:
+    void SetUp() override {
+        ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, socks_));
+        ASSERT_EQ(0, client_.Init(kDepth, kSlotSize));
+        ASSERT_EQ(0, client_.SendTo(socks_[0]));
+        ASSERT_EQ(0, server_.RecvFrom(socks_[1]));
+    }
+
+    void TearDown() override {
+        close(socks_[0]);
+        close(socks_[1]);
+    }
+
+    int socks_[2];
+    ShmRing client_;
+    ShmRing server_;
+};
+
+TEST(ShmRingInitTest, InvalidGeometryTest) {
+    ShmRing ring;
+    // 深度不是2的幂
+    ASSERT_EQ(-1, ring.Init(3, kSlotSize));
+    // slot大小没有按4KB对齐
+    ASSERT_EQ(-1, ring.Init(kDepth, 1000));
+    ASSERT_EQ(0, ring.Init(kDepth, kSlotSize));
+    ASSERT_EQ(kDepth, ring.GetDepth());
+    ASSERT_EQ(kSlotSize, ring.GetSlotSize());
+}
+
+TEST(ShmRingInitTest, RecvInvalidTest) {
+    int socks[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, socks));
+    // 对端没有发送fd
+    uint32_t magic = 0;
+    ASSERT_EQ(sizeof(magic), write(socks[0], &magic, sizeof(magic)));
+    ShmRing ring;
+    ASSERT_EQ(-1, ring.RecvFrom(socks[1]));
+    close(socks[0]);
+    close(socks[1]);
+}
+
+TEST(ShmRingInitTest, RecvUnsealedTest) {
+    int socks[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, socks));
+    // 对端发送的共享内存没有封印大小
+    int fds[3];
+    fds[0] = syscall(SYS_memfd_create, "unsealed", MFD_CLOEXEC);
+    fds[1] = eventfd(0, EFD_CLOEXEC);
+    fds[2] = eventfd(0, EFD_CLOEXEC);
+    ASSERT_LE(0, fds[0]);
+    ASSERT_EQ(0, ftruncate(fds[0],
+                           ShmRing::GetMemorySize(kDepth, kSlotSize)));
+
+    uint32_t magic = 0x4e524e47;
+    struct iovec iov = {&magic, sizeof(magic)};
+    char control[CMSG_SPACE(sizeof(fds))];
+    memset(control, 0, sizeof(control));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+    ASSERT_EQ(sizeof(magic), sendmsg(socks[0], &msg, 0));
+
+    ShmRing ring;
+    ASSERT_EQ(-1, ring.RecvFrom(socks[1]));
+    for (int fd : fds) {
+        close(fd);
+    }
+    close(socks[0]);
+    close(socks[1]);
+}
+
+TEST_F(ShmRingTest, SubmitAndFetchTest) {
+    ASSERT_EQ(kDepth, server_.GetDepth());
+    ASSERT_EQ(kSlotSize, server_.GetSlotSize());
+
+    ShmRingRequest request;
+    ShmRingCompletion completion;
+    ASSERT_FALSE(server_.FetchRequest(&request));
+    ASSERT_FALSE(client_.FetchCompletion(&completion));
+
+    // 写入的数据对端可见
+    for (uint32_t i = 0; i < kDepth; ++i) {
+        memset(client_.GetSlot(i), 'a' + i, kSlotSize);
+        request.offset = i * kSlotSize;
+        request.length = kSlotSize;
+        request.fd = 1;
+        request.op = ShmRingOp::WRITE;
+        request.slot = i;
+        ASSERT_TRUE(client_.SubmitRequest(request));
+    }
+    // 队列满
+    ASSERT_FALSE(client_.SubmitRequest(request));
+
+    for (uint32_t i = 0; i < kDepth; ++i) {
+        ASSERT_TRUE(server_.FetchRequest(&request));
+        ASSERT_EQ(i, request.slot);
+        ASSERT_EQ(i * kSlotSize, request.offset);
+        ASSERT_EQ(ShmRingOp::WRITE, request.op);
+        ASSERT_EQ('a' + i, server_.GetSlot(request.slot)[kSlotSize - 1]);
+
+        completion.slot = request.slot;
+        completion.ret = 0;
+        ASSERT_TRUE(server_.SubmitCompletion(completion));
+    }
+    ASSERT_FALSE(server_.FetchRequest(&request));
+
+    for (uint32_t i = 0; i < kDepth; ++i) {
+        ASSERT_TRUE(client_.FetchCompletion(&completion));
+        ASSERT_EQ(i, completion.slot);
+        ASSERT_EQ(0, completion.ret);
+    }
+    ASSERT_FALSE(client_.FetchCompletion(&completion));
+}
+
+TEST_F(ShmRingTest, WaitTest) {
+    // 队列不为空时直接返回
+    ShmRingRequest request;
+    memset(&request, 0, sizeof(request));
+    ASSERT_TRUE(client_.SubmitRequest(request));
+    ASSERT_EQ(0, server_.WaitRequest(socks_[1]));
+    ASSERT_TRUE(server_.FetchRequest(&request));
+
+    // 等待过程中提交的请求会唤醒消费者
+    std::thread th([&]() {
+        usleep(100 * 1000);
+        ShmRingCompletion completion;
+        completion.slot = 1;
+        completion.ret = -1;
+        server_.SubmitCompletion(completion);
+    });
+    ShmRingCompletion completion;
+    while (!client_.FetchCompletion(&completion)) {
+        ASSERT_EQ(0, client_.WaitCompletion(socks_[0]));
+    }
+    ASSERT_EQ(1, completion.slot);
+    ASSERT_EQ(-1, completion.ret);
+    th.join();
+
+    // 对端断开
+    shutdown(socks_[0], SHUT_RDWR);
+    ASSERT_EQ(-1, server_.WaitRequest(socks_[1]));
+}
+
+TEST_F(ShmRingTest, DrainedTest) {
+    ASSERT_FALSE(client_.IsDrained());
+    ASSERT_FALSE(server_.IsDrained());
+
+    // part2设置的标记对part1可见
+    server_.SetDrained();
+    ASSERT_TRUE(client_.IsDrained());
+}
+
+TEST_F(ShmRingTest, RevokeRequestsTest) {
+    ShmRingRequest request;
+    memset(&request, 0, sizeof(request));
+    ASSERT_EQ(0, client_.RevokeRequests());
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        request.slot = i;
+        ASSERT_TRUE(client_.SubmitRequest(request));
+    }
+    // part2已经取出的请求不会被收回
+    ASSERT_TRUE(server_.FetchRequest(&request));
+    ASSERT_EQ(0, request.slot);
+
+    // 剩下的请求被part1收回后，part2不会再取到
+    ASSERT_EQ(3, client_.RevokeRequests());
+    ASSERT_FALSE(server_.FetchRequest(&request));
+    ASSERT_EQ(0, client_.RevokeRequests());
+}
+
+}  // namespace common
+}  // namespace nebd
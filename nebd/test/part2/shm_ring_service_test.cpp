@@ -0,0 +1,220 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: nebd
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <butil/iobuf.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "nebd/src/part2/shm_ring_service.h"
+#include "nebd/test/part2/mock_file_manager.h"
+
+namespace nebd {
+namespace server {
+
+using ::testing::_;
+using ::testing::Return;
+using ::testing::DoAll;
+using ::testing::SaveArg;
+
+const char kShmAddress[] = "/tmp/nebd_shm_ring_service_test.sock";  // NOLINT
+const uint32_t kDepth = 4;
+const uint32_t kSlotSize = 4096;
+const int kTestFd = 1;
+
+class ShmRingServiceTest : public ::testing::Test {
+ public:
+    void SetUp() {
+        fileManager_ = std::make_shared<MockFileManager>();
+        service_ = std::make_shared<NebdShmRingService>(fileManager_);
+        ASSERT_EQ(0, service_->Start(kShmAddress));
+        ASSERT_EQ(0, Connect(&ring_));
+    }
+
+    void TearDown() {
+        service_->Stop();
+        close(sock_);
+    }
+
+    int Connect(ShmRing* ring) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, kShmAddress, sizeof(addr.sun_path) - 1);
+        sock_ = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(sock_, reinterpret_cast<struct sockaddr*>(&addr),
+                    sizeof(addr)) != 0) {
+            return -1;
+        }
+        if (ring->Init(kDepth, kSlotSize) != 0 || ring->SendTo(sock_) != 0) {
+            return -1;
+        }
+        char ack = -1;
+        if (recv(sock_, &ack, sizeof(ack), 0) != sizeof(ack)) {
+            return -1;
+        }
+        return ack;
+    }
+
+    void Submit(ShmRingOp op, uint32_t slot, uint64_t length) {
+        ShmRingRequest request;
+        memset(&request, 0, sizeof(request));
+        request.offset = 0;
+        request.length = length;
+        request.fd = kTestFd;
+        request.op = op;
+        request.slot = slot;
+        ASSERT_TRUE(ring_.SubmitRequest(request));
+    }
+
+    void WaitCompletion(ShmRingCompletion* completion) {
+        while (!ring_.FetchCompletion(completion)) {
+            ASSERT_EQ(0, ring_.WaitCompletion(sock_));
+        }
+    }
+
+ protected:
+    std::shared_ptr<MockFileManager> fileManager_;
+    std::shared_ptr<NebdShmRingService> service_;
+    ShmRing ring_;
+    int sock_;
+};
+
+TEST_F(ShmRingServiceTest, WriteTest) {
+    memset(ring_.GetSlot(1), 'a', kSlotSize);
+
+    NebdServerAioContext* aioContext = nullptr;
+    EXPECT_CALL(*fileManager_, AioWrite(kTestFd, _))
+        .WillOnce(DoAll(SaveArg<1>(&aioContext), Return(0)));
+    Submit(ShmRingOp::WRITE, 1, kSlotSize);
+
+    while (aioContext == nullptr) {
+        usleep(1000);
+    }
+    ASSERT_EQ(LIBAIO_OP::LIBAIO_OP_WRITE, aioContext->op);
+    ASSERT_EQ(kSlotSize, aioContext->size);
+    butil::IOBuf* buf = reinterpret_cast<butil::IOBuf*>(aioContext->buf);
+    ASSERT_EQ(kSlotSize, buf->size());
+    ASSERT_EQ(std::string(kSlotSize, 'a'), buf->to_string());
+
+    aioContext->ret = 0;
+    aioContext->cb(aioContext);
+
+    ShmRingCompletion completion;
+    WaitCompletion(&completion);
+    ASSERT_EQ(1, completion.slot);
+    ASSERT_EQ(0, completion.ret);
+}
+
+TEST_F(ShmRingServiceTest, ReadTest) {
+    NebdServerAioContext* aioContext = nullptr;
+    EXPECT_CALL(*fileManager_, AioRead(kTestFd, _))
+        .WillOnce(DoAll(SaveArg<1>(&aioContext), Return(0)));
+    Submit(ShmRingOp::READ, 2, kSlotSize);
+
+    while (aioContext == nullptr) {
+        usleep(1000);
+    }
+    ASSERT_EQ(LIBAIO_OP::LIBAIO_OP_READ, aioContext->op);
+    butil::IOBuf* buf = reinterpret_cast<butil::IOBuf*>(aioContext->buf);
+    buf->append(std::string(kSlotSize, 'b'));
+    aioContext->ret = 0;
+    aioContext->cb(aioContext);
+
+    ShmRingCompletion completion;
+    WaitCompletion(&completion);
+    ASSERT_EQ(2, completion.slot);
+    ASSERT_EQ(0, completion.ret);
+    ASSERT_EQ(std::string(kSlotSize, 'b'),
+              std::string(ring_.GetSlot(2), kSlotSize));
+}
+
+TEST_F(ShmRingServiceTest, FailedTest) {
+    // 下发请求失败
+    EXPECT_CALL(*fileManager_, AioRead(kTestFd, _))
+        .WillOnce(Return(-1));
+    Submit(ShmRingOp::READ, 0, kSlotSize);
+    ShmRingCompletion completion;
+    WaitCompletion(&completion);
+    ASSERT_EQ(0, completion.slot);
+    ASSERT_EQ(-1, completion.ret);
+
+    // 请求超过slot大小
+    EXPECT_CALL(*fileManager_, AioWrite(_, _))
+        .Times(0);
+    Submit(ShmRingOp::WRITE, 1, kSlotSize + 1);
+    WaitCompletion(&completion);
+    ASSERT_EQ(1, completion.slot);
+    ASSERT_EQ(-1, completion.ret);
+
+    // 请求异步返回失败
+    NebdServerAioContext* aioContext = nullptr;
+    EXPECT_CALL(*fileManager_, AioRead(kTestFd, _))
+        .WillOnce(DoAll(SaveArg<1>(&aioContext), Return(0)));
+    Submit(ShmRingOp::READ, 2, kSlotSize);
+    while (aioContext == nullptr) {
+        usleep(1000);
+    }
+    aioContext->ret = -1;
+    aioContext->cb(aioContext);
+    WaitCompletion(&completion);
+    ASSERT_EQ(2, completion.slot);
+    ASSERT_EQ(-1, completion.ret);
+}
+
+TEST_F(ShmRingServiceTest, DisconnectTest) {
+    NebdServerAioContext* aioContext = nullptr;
+    EXPECT_CALL(*fileManager_, AioWrite(kTestFd, _))
+        .WillOnce(DoAll(SaveArg<1>(&aioContext), Return(0)));
+    Submit(ShmRingOp::WRITE, 0, kSlotSize);
+    while (aioContext == nullptr) {
+        usleep(1000);
+    }
+
+    // part1断开后，未返回的请求仍然可以正常返回
+    shutdown(sock_, SHUT_RDWR);
+    usleep(100 * 1000);
+    ASSERT_FALSE(ring_.IsDrained());
+    aioContext->ret = 0;
+    aioContext->cb(aioContext);
+
+    // 所有请求返回之后设置drained标记，结果已经写入完成队列
+    while (!ring_.IsDrained()) {
+        usleep(1000);
+    }
+    ShmRingCompletion completion;
+    ASSERT_TRUE(ring_.FetchCompletion(&completion));
+    ASSERT_EQ(0, completion.slot);
+    ASSERT_EQ(0, completion.ret);
+
+    // 断开后可以重新连接
+    close(sock_);
+    ShmRing ring;
+    ASSERT_EQ(0, Connect(&ring));
+}
+
+}  // namespace server
+}  // namespace nebd
@@ -358,20 +358,53 @@ TEST_F(TestReuqestExecutorCurve, test_AioWrite) {
 
 TEST_F(TestReuqestExecutorCurve, test_Discard) {
     auto executor = CurveRequestExecutor::GetInstance();
+    NebdServerAioContext aiotcx;
+    aiotcx.cb = NebdUnitTestCallback;
     std::string curveFilename("/cinder/volume-1234_cinder_");
-    std::unique_ptr<CurveFileInstance> curveFileIns(new CurveFileInstance());
-    NebdServerAioContext* aioctx = new NebdServerAioContext();
-    nebd::client::DiscardResponse response;
-    TestReuqestExecutorCurveClosure done;
 
-    aioctx->op = LIBAIO_OP::LIBAIO_OP_DISCARD;
-    aioctx->cb = NebdFileServiceCallback;
-    aioctx->response = &response;
-    aioctx->done = &done;
+    // 1. nebdFileIns不是CurveFileInstance类型, discard失败
+    {
+        auto nebdFileIns = new NebdFileInstance();
+        EXPECT_CALL(*curveClient_, AioDiscard(_, _)).Times(0);
+        ASSERT_EQ(-1, executor.Discard(nebdFileIns, &aiotcx));
+    }
 
-    ASSERT_EQ(0, executor.Discard(curveFileIns.get(), aioctx));
-    ASSERT_TRUE(done.IsRunned());
-    ASSERT_EQ(response.retcode(), nebd::client::RetCode::kOK);
+    // 2. nebdFileIns中的fd<0, discard失败
+    {
+        auto curveFileIns = new CurveFileInstance();
+        curveFileIns->fd = -1;
+        EXPECT_CALL(*curveClient_, AioDiscard(_, _)).Times(0);
+        ASSERT_EQ(-1, executor.Discard(curveFileIns, &aiotcx));
+    }
+
+    // 3. 调用curveclient的AioDiscard接口失败, discard失败
+    {
+        auto curveFileIns = new CurveFileInstance();
+        aiotcx.size = 4096;
+        aiotcx.offset = 0;
+        aiotcx.buf = nullptr;
+        aiotcx.op = LIBAIO_OP::LIBAIO_OP_DISCARD;
+        curveFileIns->fd = 1;
+        curveFileIns->fileName = curveFilename;
+        EXPECT_CALL(*curveClient_, AioDiscard(1, _))
+            .WillOnce(Return(LIBCURVE_ERROR::FAILED));
+        ASSERT_EQ(-1, executor.Discard(curveFileIns, &aiotcx));
+    }
+
+    // 4. discard成功
+    {
+        auto curveFileIns = new CurveFileInstance();
+        curveFileIns->fd = 1;
+        curveFileIns->fileName = curveFilename;
+        CurveAioContext* curveCtx;
+        EXPECT_CALL(*curveClient_, AioDiscard(1, _))
+            .WillOnce(DoAll(SaveArg<1>(&curveCtx),
+                            Return(LIBCURVE_ERROR::OK)));
+        ASSERT_EQ(0, executor.Discard(curveFileIns, &aiotcx));
+        ASSERT_EQ(LIBCURVE_OP::LIBCURVE_OP_DISCARD, curveCtx->op);
+        ASSERT_EQ(4096, curveCtx->length);
+        curveCtx->cb(curveCtx);
+    }
 }
 
 TEST_F(TestReuqestExecutorCurve, test_Flush) {
@@ -35,6 +35,7 @@
 #include "src/chunkserver/chunkserver_metrics.h"
 #include "src/chunkserver/op_request.h"
 #include "src/chunkserver/chunk_service_closure.h"
+#include "src/common/crc32.h"
 
 namespace curve {
 namespace chunkserver {
@@ -59,7 +60,8 @@ void ChunkServiceImpl::DeleteChunk(RpcController *controller,
 
     brpc::ClosureGuard doneGuard(closure);
 
-    if (inflightThrottle_->IsOverLoad()) {
+    if (inflightThrottle_->IsOverLoad(request->logicpoolid(),
+                                      request->copysetid())) {
         response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD);
         LOG_EVERY_N(WARNING, 100)
             << "DeleteChunk: "
@@ -86,6 +88,54 @@ void ChunkServiceImpl::DeleteChunk(RpcController *controller,
     req->Process();
 }
 
+void ChunkServiceImpl::DeleteChunks(RpcController *controller,
+                                    const ChunkRequest *request,
+                                    ChunkResponse *response,
+                                    Closure *done) {
+    ChunkServiceClosure* closure =
+        new (std::nothrow) ChunkServiceClosure(inflightThrottle_,
+                                               request,
+                                               response,
+                                               done);
+    CHECK(nullptr != closure) << "new chunk service closure failed";
+
+    brpc::ClosureGuard doneGuard(closure);
+
+    if (inflightThrottle_->IsOverLoad(request->logicpoolid(),
+                                      request->copysetid())) {
+        response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD);
+        LOG_EVERY_N(WARNING, 100)
+            << "DeleteChunks: "
+            << "too many inflight requests to process in chunkserver";
+        return;
+    }
+
+    if (request->chunkids_size() == 0) {
+        response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_INVALID_REQUEST);
+        LOG(ERROR) << "delete chunks failed, no chunk in request:"
+                   << request->logicpoolid() << "," << request->copysetid();
+        return;
+    }
+
+    // 判断copyset是否存在
+    auto nodePtr = copysetNodeManager_->GetCopysetNode(request->logicpoolid(),
+                                                       request->copysetid());
+    if (nullptr == nodePtr) {
+        response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_COPYSET_NOTEXIST);
+        LOG(WARNING) << "delete chunks failed, copyset node is not found:"
+                     << request->logicpoolid() << "," << request->copysetid();
+        return;
+    }
+
+    std::shared_ptr<DeleteChunksRequest>
+        req = std::make_shared<DeleteChunksRequest>(nodePtr,
+                                                    controller,
+                                                    request,
+                                                    response,
+                                                    doneGuard.release());
+    req->Process();
+}
+
 void ChunkServiceImpl::WriteChunk(RpcController *controller,
                                   const ChunkRequest *request,
                                   ChunkResponse *response,
@@ -99,7 +149,8 @@ void ChunkServiceImpl::WriteChunk(RpcController *controller,
 
     brpc::ClosureGuard doneGuard(closure);
 
-    if (inflightThrottle_->IsOverLoad()) {
+    if (inflightThrottle_->IsOverLoad(request->logicpoolid(),
+                                      request->copysetid())) {
         response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD);
         LOG_EVERY_N(WARNING, 100)
             << "WriteChunk: "
@@ -143,6 +194,56 @@ void ChunkServiceImpl::WriteChunk(RpcController *controller,
     req->Process();
 }
 
+void ChunkServiceImpl::DiscardChunk(RpcController *controller,
+                                    const ChunkRequest *request,
+                                    ChunkResponse *response,
+                                    Closure *done) {
+    ChunkServiceClosure* closure =
+        new (std::nothrow) ChunkServiceClosure(inflightThrottle_,
+                                               request,
+                                               response,
+                                               done);
+    CHECK(nullptr != closure) << "new chunk service closure failed";
+
+    brpc::ClosureGuard doneGuard(closure);
+
+    if (inflightThrottle_->IsOverLoad(request->logicpoolid(),
+                                      request->copysetid())) {
+        response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD);
+        LOG_EVERY_N(WARNING, 100)
+            << "DiscardChunk: "
+            << "too many inflight requests to process in chunkserver";
+        return;
+    }
+
+    if (!CheckRequestOffsetAndLength(request->offset(), request->size())) {
+        response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_INVALID_REQUEST);
+        LOG(ERROR) << "I/O request, op: " << request->optype()
+                   << " offset: " << request->offset()
+                   << " size: " << request->size()
+                   << " max size: " << maxChunkSize_;
+        return;
+    }
+
+    // 判断copyset是否存在
+    auto nodePtr = copysetNodeManager_->GetCopysetNode(request->logicpoolid(),
+                                                       request->copysetid());
+    if (nullptr == nodePtr) {
+        response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_COPYSET_NOTEXIST);
+        LOG(WARNING) << "discard chunk failed, copyset node is not found:"
+                     << request->logicpoolid() << "," << request->copysetid();
+        return;
+    }
+
+    std::shared_ptr<DiscardChunkRequest>
+        req = std::make_shared<DiscardChunkRequest>(nodePtr,
+                                                    controller,
+                                                    request,
+                                                    response,
+                                                    doneGuard.release());
+    req->Process();
+}
+
 void ChunkServiceImpl::CreateCloneChunk(RpcController *controller,
                                         const ChunkRequest *request,
                                         ChunkResponse *response,
@@ -156,7 +257,8 @@ void ChunkServiceImpl::CreateCloneChunk(RpcController *controller,
 
     brpc::ClosureGuard doneGuard(closure);
 
-    if (inflightThrottle_->IsOverLoad()) {
+    if (inflightThrottle_->IsOverLoad(request->logicpoolid(),
+                                      request->copysetid())) {
         response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD);
         LOG_EVERY_N(WARNING, 100)
             << "CreateCloneChunk: "
@@ -214,7 +316,8 @@ void ChunkServiceImpl::ReadChunk(RpcController *controller,
 
     brpc::ClosureGuard doneGuard(closure);
 
-    if (inflightThrottle_->IsOverLoad()) {
+    if (inflightThrottle_->IsOverLoad(request->logicpoolid(),
+                                      request->copysetid())) {
         response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD);
         LOG_EVERY_N(WARNING, 100)
             << "ReadChunk: "
@@ -266,7 +369,8 @@ void ChunkServiceImpl::RecoverChunk(RpcController *controller,
 
     brpc::ClosureGuard doneGuard(closure);
 
-    if (inflightThrottle_->IsOverLoad()) {
+    if (inflightThrottle_->IsOverLoad(request->logicpoolid(),
+                                      request->copysetid())) {
         response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD);
         LOG_EVERY_N(WARNING, 100)
             << "RecoverChunk: "
@@ -318,7 +422,8 @@ void ChunkServiceImpl::ReadChunkSnapshot(RpcController *controller,
 
     brpc::ClosureGuard doneGuard(closure);
 
-    if (inflightThrottle_->IsOverLoad()) {
+    if (inflightThrottle_->IsOverLoad(request->logicpoolid(),
+                                      request->copysetid())) {
         response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD);
         LOG_EVERY_N(WARNING, 100)
             << "ReadChunkSnapshot: "
@@ -365,7 +470,8 @@ void ChunkServiceImpl::DeleteChunkSnapshotOrCorrectSn(
 
     brpc::ClosureGuard doneGuard(closure);
 
-    if (inflightThrottle_->IsOverLoad()) {
+    if (inflightThrottle_->IsOverLoad(request->logicpoolid(),
+                                      request->copysetid())) {
         response->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD);
         LOG_EVERY_N(WARNING, 100)
             << "DeleteChunkSnapshotOrCorrectSn: "
@@ -505,13 +611,43 @@ void ChunkServiceImpl::GetChunkHash(RpcController *controller,
         return;
     }
 
-    CSErrorCode ret;
+    CSErrorCode ret = CSErrorCode::InvalidArgError;
     std::string hash;
 
-    ret = nodePtr->GetDataStore()->GetChunkHash(request->chunkid(),
-                                                request->offset(),
-                                                request->length(),
-                                                &hash);
+    // 请求region hash时只读取上次计算之后写过的region，
+    // 未开启region hash时返回InvalidArgError，退化为计算指定区域的hash
+    if (request->has_regionhash() && request->regionhash()) {
+        uint32_t regionSize = 0;
+        std::vector<uint32_t> crcs;
+        ret = nodePtr->GetDataStore()->GetChunkRegionHash(request->chunkid(),
+                                                          &regionSize,
+                                                          &crcs);
+        if (CSErrorCode::Success == ret) {
+            uint32_t root = curve::common::CRC32(
+                reinterpret_cast<const char*>(crcs.data()),
+                crcs.size() * sizeof(uint32_t));
+            hash = std::to_string(root);
+            response->set_regionsize(regionSize);
+            for (uint32_t crc : crcs) {
+                response->add_regionhashes(crc);
+            }
+        }
+    }
+    if (CSErrorCode::InvalidArgError == ret) {
+        // 默认按chunk文件的偏移计算，与老版本chunkserver返回的hash一致
+        if (request->hashversion() ==
+            CHUNK_HASH_VERSION::CHUNK_HASH_VERSION_DATA) {
+            ret = nodePtr->GetDataStore()->GetChunkDataHash(
+                request->chunkid(), request->offset(), request->length(),
+                &hash);
+        } else {
+            ret = nodePtr->GetDataStore()->GetChunkHash(request->chunkid(),
+                                                        request->offset(),
+                                                        request->length(),
+                                                        &hash);
+        }
+        response->set_hashversion(request->hashversion());
+    }
 
     if (CSErrorCode::Success == ret) {
         // 1.成功
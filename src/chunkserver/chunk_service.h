@@ -48,6 +48,11 @@ class ChunkServiceImpl : public ChunkService {
                      ChunkResponse *response,
                      Closure *done);
 
+    void DeleteChunks(RpcController *controller,
+                      const ChunkRequest *request,
+                      ChunkResponse *response,
+                      Closure *done);
+
     void ReadChunk(RpcController *controller,
                    const ChunkRequest *request,
                    ChunkResponse *response,
@@ -58,6 +63,11 @@ class ChunkServiceImpl : public ChunkService {
                     ChunkResponse *response,
                     Closure *done);
 
+    void DiscardChunk(RpcController *controller,
+                      const ChunkRequest *request,
+                      ChunkResponse *response,
+                      Closure *done);
+
     void ReadChunkSnapshot(RpcController *controller,
                            const ChunkRequest *request,
                            ChunkResponse *response,
@@ -46,7 +46,12 @@ void ChunkServiceClosure::Run() {
     // 这一行必须放在brpcDone_调用之后，ut里需要测试inflightio超过限制时的表现
     // 会在传进来的closure里面加一个sleep来控制inflightio个数
     if (nullptr != inflightThrottle_) {
-        inflightThrottle_->Decrement();
+        if (nullptr != request_) {
+            inflightThrottle_->Decrement(request_->logicpoolid(),
+                                         request_->copysetid());
+        } else {
+            inflightThrottle_->Decrement();
+        }
     }
 }
 
@@ -97,6 +102,15 @@ void ChunkServiceClosure::OnResonse() {
     bool hasError = false;
     uint64_t latencyUs =
         common::TimeUtility::GetTimeofDayUs() - receivedTimeUs_;
+
+    // 读写请求的延时用于inflight流控自适应调整上限，
+    // 过载被拒绝的请求没有真正处理，不统计
+    if (nullptr != inflightThrottle_ &&
+        response_->status() != CHUNK_OP_STATUS::CHUNK_OP_STATUS_OVERLOAD &&
+        (request_->optype() == CHUNK_OP_TYPE::CHUNK_OP_READ ||
+         request_->optype() == CHUNK_OP_TYPE::CHUNK_OP_WRITE)) {
+        inflightThrottle_->OnLatency(latencyUs);
+    }
     switch (request_->optype()) {
         case CHUNK_OP_TYPE::CHUNK_OP_READ: {
             // 如果是read请求，返回CHUNK_OP_STATUS_CHUNK_NOTEXIST也认为是正确的
@@ -49,7 +49,12 @@ class ChunkServiceClosure : public braft::Closure {
         , receivedTimeUs_(common::TimeUtility::GetTimeofDayUs()) {
             // closure创建的什么加1，closure调用的时候减1
             if (nullptr != inflightThrottle_) {
-                inflightThrottle_->Increment();
+                if (nullptr != request_) {
+                    inflightThrottle_->Increment(request_->logicpoolid(),
+                                                 request_->copysetid());
+                } else {
+                    inflightThrottle_->Increment();
+                }
             }
             // 统计请求数量
             OnRequest();
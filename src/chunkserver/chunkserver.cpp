@@ -34,6 +34,7 @@
 #include "src/chunkserver/chunkserver_service.h"
 #include "src/chunkserver/copyset_service.h"
 #include "src/chunkserver/chunk_service.h"
+#include "src/chunkserver/integrity_service.h"
 #include "src/chunkserver/braft_cli_service.h"
 #include "src/chunkserver/braft_cli_service2.h"
 #include "src/chunkserver/chunkserver_helper.h"
@@ -119,11 +120,13 @@ int ChunkServer::Run(int argc, char** argv) {
         << "Failed to initialize concurrentapply module!";
 
     // 初始化本地文件系统
-    std::shared_ptr<LocalFileSystem> fs(
-        LocalFsFactory::CreateFs(FileSystemType::EXT4, ""));
+    bool enableIoUring = false;
+    LOG_IF(FATAL, !conf.GetBoolValue("fs.enable_io_uring", &enableIoUring));
+    std::shared_ptr<LocalFileSystem> fs(LocalFsFactory::CreateFs(
+        enableIoUring ? FileSystemType::EXT4_IOURING : FileSystemType::EXT4,
+        ""));
     LocalFileSystemOption lfsOption;
-    LOG_IF(FATAL, !conf.GetBoolValue(
-        "fs.enable_renameat2", &lfsOption.enableRenameat2));
+    InitLocalFileSystemOptions(&conf, &lfsOption);
     LOG_IF(FATAL, 0 != fs->Init(lfsOption))
         << "Failed to initialize local filesystem module!";
 
@@ -234,6 +237,24 @@ int ChunkServer::Run(int argc, char** argv) {
     snapshotThrottle_ = snapshotThrottle;
     copysetNodeOptions.snapshotThrottle = &snapshotThrottle_;
 
+    // install snapshot时并发下载文件的个数以及单个copyset的带宽限制
+    CurveSnapshotCopierOptions copierOptions;
+    LOG_IF(FATAL,
+           !conf.GetUInt32Value("chunkserver.snapshot_copy_concurrency",
+                                &copierOptions.copyConcurrency));
+    LOG_IF(FATAL,
+           !conf.GetUInt64Value(
+               "chunkserver.snapshot_copyset_throughput_bytes",
+               &copierOptions.throughputBytes));
+    CurveSnapshotStorage::set_copier_options(copierOptions);
+
+    // 发送snapshot时跳过全零的页，接收方总是把没有收到数据的区域清零
+    bool skipZeroPages;
+    LOG_IF(FATAL,
+           !conf.GetBoolValue("chunkserver.snapshot_skip_zero_pages",
+                              &skipZeroPages));
+    kCurveFileService.set_skip_zero_pages(skipZeroPages);
+
     butil::ip_t ip;
     if (butil::str2ip(copysetNodeOptions.ip.c_str(), &ip) < 0) {
         LOG(FATAL) << "Invalid server IP provided: " << copysetNodeOptions.ip;
@@ -277,13 +298,12 @@ int ChunkServer::Run(int argc, char** argv) {
     CHECK(0 == ret) << "Fail to add CopysetService";
 
     // inflight throttle
-    int maxInflight;
-    LOG_IF(FATAL,
-           !conf.GetIntValue("copyset.max_inflight_requests",
-                             &maxInflight));
+    InflightThrottleOptions inflightThrottleOptions;
+    InitInflightThrottleOptions(&conf, &inflightThrottleOptions);
     std::shared_ptr<InflightThrottle> inflightThrottle
-        = std::make_shared<InflightThrottle>(maxInflight);
+        = std::make_shared<InflightThrottle>(inflightThrottleOptions);
     CHECK(nullptr != inflightThrottle) << "new inflight throttle failed";
+    inflightThrottle->ExposeMetric("chunkserver");
 
     // chunk service
     ChunkServiceOptions chunkServiceOptions;
@@ -325,6 +345,20 @@ int ChunkServer::Run(int argc, char** argv) {
         brpc::SERVER_DOESNT_OWN_SERVICE);
     CHECK(0 == ret) << "Fail to add ChunkServerService";
 
+    // integrity service
+    ScrubOptions scrubOptions;
+    InitScrubOptions(&conf, &scrubOptions);
+    scrubOptions.copysetNodeManager = copysetNodeManager_;
+    scrubOptions.localAddr = endPoint;
+    scrubOptions.chunkSize = copysetNodeOptions.maxChunkSize;
+    scrubOptions.inflightThrottle = inflightThrottle;
+    LOG_IF(FATAL, scrubManager_.Init(scrubOptions) != 0)
+        << "Failed to init scrub manager.";
+    IntegrityServiceImpl integrityService(&scrubManager_);
+    ret = server.AddService(&integrityService,
+        brpc::SERVER_DOESNT_OWN_SERVICE);
+    CHECK(0 == ret) << "Fail to add IntegrityService";
+
     // 启动rpc service
     LOG(INFO) << "Internal server is going to serve on: "
               << copysetNodeOptions.ip << ":" << copysetNodeOptions.port;
@@ -348,6 +382,9 @@ int ChunkServer::Run(int argc, char** argv) {
         ret = externalServer.AddService(&braftCliService2,
                         brpc::SERVER_DOESNT_OWN_SERVICE);
         CHECK(0 == ret) << "Fail to add BRaftCliService2 at external server";
+        ret = externalServer.AddService(&integrityService,
+                        brpc::SERVER_DOESNT_OWN_SERVICE);
+        CHECK(0 == ret) << "Fail to add IntegrityService at external server";
         braft::RaftStatImpl raftStatService;
         ret = externalServer.AddService(&raftStatService,
                         brpc::SERVER_DOESNT_OWN_SERVICE);
@@ -375,6 +412,8 @@ int ChunkServer::Run(int argc, char** argv) {
         << "Failed to start heartbeat manager.";
     LOG_IF(FATAL, copysetNodeManager_->Run() != 0)
         << "Failed to start CopysetNodeManager.";
+    LOG_IF(FATAL, scrubManager_.Run() != 0)
+        << "Failed to start scrub manager.";
 
     // =======================等待进程退出==================================//
     while (!brpc::IsAskedToQuit()) {
@@ -390,6 +429,8 @@ int ChunkServer::Run(int argc, char** argv) {
     LOG(INFO) << "ChunkServer is going to quit.";
     LOG_IF(ERROR, heartbeat_.Fini() != 0)
         << "Failed to shutdown heartbeat manager.";
+    LOG_IF(ERROR, scrubManager_.Fini() != 0)
+        << "Failed to shutdown scrub manager.";
     LOG_IF(ERROR, copysetNodeManager_->Fini() != 0)
         << "Failed to shutdown CopysetNodeManager.";
     LOG_IF(ERROR, cloneManager_.Fini() != 0)
@@ -399,6 +440,9 @@ int ChunkServer::Run(int argc, char** argv) {
     LOG_IF(ERROR, trash_->Fini() != 0)
         << "Failed to shutdown trash.";
     concurrentapply.Stop();
+    // 停止文件池的后台清理线程
+    kWalFilePool->UnInitialize();
+    chunkfilePool->UnInitialize();
 
     google::ShutdownGoogleLogging();
     return 0;
@@ -421,6 +465,12 @@ void ChunkServer::InitChunkFilePoolOptions(
     LOG_IF(FATAL, !conf->GetBoolValue(
         "chunkfilepool.enable_get_chunk_from_pool",
         &chunkFilePoolOptions->getFileFromPool));
+    LOG_IF(FATAL, !conf->GetBoolValue("chunkfilepool.clean.enable",
+        &chunkFilePoolOptions->needClean));
+    LOG_IF(FATAL, !conf->GetUInt32Value("chunkfilepool.clean.bytes_per_write",
+        &chunkFilePoolOptions->bytesPerWrite));
+    LOG_IF(FATAL, !conf->GetUInt32Value("chunkfilepool.low_water_mark",
+        &chunkFilePoolOptions->lowWaterMark));
 
     if (chunkFilePoolOptions->getFileFromPool == false) {
         std::string chunkFilePoolUri;
@@ -438,6 +488,18 @@ void ChunkServer::InitChunkFilePoolOptions(
     }
 }
 
+void ChunkServer::InitLocalFileSystemOptions(
+    common::Configuration *conf, LocalFileSystemOption *lfsOption) {
+    LOG_IF(FATAL, !conf->GetBoolValue(
+        "fs.enable_renameat2", &lfsOption->enableRenameat2));
+    LOG_IF(FATAL, !conf->GetUInt32Value(
+        "fs.io_uring_queue_depth", &lfsOption->ioUringQueueDepth));
+    LOG_IF(FATAL, !conf->GetUInt32Value(
+        "fs.io_uring_fixed_buffer_num", &lfsOption->ioUringFixedBufferNum));
+    LOG_IF(FATAL, !conf->GetUInt32Value(
+        "fs.io_uring_fixed_buffer_size", &lfsOption->ioUringFixedBufferSize));
+}
+
 void ChunkServer::InitConcurrentApplyOptions(common::Configuration *conf,
         ConcurrentApplyOption *concurrentApplyOptions) {
     LOG_IF(FATAL, !conf->GetIntValue(
@@ -461,6 +523,12 @@ void ChunkServer::InitWalFilePoolOptions(
     LOG_IF(FATAL, !conf->GetBoolValue(
         "walfilepool.enable_get_segment_from_pool",
         &walPoolOptions->getFileFromPool));
+    LOG_IF(FATAL, !conf->GetBoolValue("walfilepool.clean.enable",
+        &walPoolOptions->needClean));
+    LOG_IF(FATAL, !conf->GetUInt32Value("walfilepool.clean.bytes_per_write",
+        &walPoolOptions->bytesPerWrite));
+    LOG_IF(FATAL, !conf->GetUInt32Value("walfilepool.low_water_mark",
+        &walPoolOptions->lowWaterMark));
 
     if (walPoolOptions->getFileFromPool == false) {
         std::string filePoolUri;
@@ -510,6 +578,16 @@ void ChunkServer::InitCopysetNodeOptions(
         &copysetNodeOptions->locationLimit));
     LOG_IF(FATAL, !conf->GetUInt32Value("copyset.load_concurrency",
         &copysetNodeOptions->loadConcurrency));
+    LOG_IF(FATAL, !conf->GetUInt32Value("copyset.load_chunk_concurrency",
+        &copysetNodeOptions->loadChunkConcurrency));
+    LOG_IF(FATAL, !conf->GetBoolValue("copyset.enable_chunk_meta_index",
+        &copysetNodeOptions->enableChunkMetaIndex));
+    LOG_IF(FATAL, !conf->GetBoolValue("copyset.enable_chunk_group_commit",
+        &copysetNodeOptions->enableChunkGroupCommit));
+    LOG_IF(FATAL, !conf->GetUInt32Value("copyset.chunk_region_hash_size",
+        &copysetNodeOptions->chunkRegionHashSize));
+    LOG_IF(FATAL, !conf->GetBoolValue("copyset.discard_punch_hole",
+        &copysetNodeOptions->discardPunchHole));
     LOG_IF(FATAL, !conf->GetUInt32Value("copyset.check_retrytimes",
         &copysetNodeOptions->checkRetryTimes));
     LOG_IF(FATAL, !conf->GetUInt32Value("copyset.finishload_margin",
@@ -528,6 +606,8 @@ void ChunkServer::InitCopyerOptions(
         &copyerOptions->curveConf));
     LOG_IF(FATAL,
         !conf->GetStringValue("s3.config_path", &copyerOptions->s3Conf));
+    LOG_IF(FATAL, !conf->GetUInt32Value("global.chunk_size",
+        &copyerOptions->chunkSize));
     bool disableCurveClient = false;
     bool disableS3Adapter = false;
     LOG_IF(FATAL, !conf->GetBoolValue("clone.disable_curve_client",
@@ -569,6 +649,10 @@ void ChunkServer::InitHeartbeatOptions(
         &heartbeatOptions->intervalSec));
     LOG_IF(FATAL, !conf->GetUInt32Value("mds.heartbeat_timeout",
         &heartbeatOptions->timeout));
+    LOG_IF(FATAL, !conf->GetBoolValue("mds.heartbeat_enable_delta",
+        &heartbeatOptions->enableDelta));
+    LOG_IF(FATAL, !conf->GetUInt32Value("mds.full_heartbeat_interval",
+        &heartbeatOptions->fullHeartbeatInterval));
 }
 
 void ChunkServer::InitRegisterOptions(
@@ -605,6 +689,37 @@ void ChunkServer::InitTrashOptions(
         "trash.scan_periodSec", &trashOptions->scanPeriodSec));
 }
 
+void ChunkServer::InitScrubOptions(
+    common::Configuration *conf, ScrubOptions *scrubOptions) {
+    LOG_IF(FATAL, !conf->GetUInt32Value(
+        "scrub.read_size", &scrubOptions->readSize));
+    LOG_IF(FATAL, !conf->GetUInt64Value(
+        "scrub.bytes_per_second", &scrubOptions->bytesPerSecond));
+    LOG_IF(FATAL, !conf->GetUInt32Value(
+        "scrub.retry_times", &scrubOptions->retryTimes));
+    LOG_IF(FATAL, !conf->GetUInt32Value(
+        "scrub.retry_interval_ms", &scrubOptions->retryIntervalMs));
+    LOG_IF(FATAL, !conf->GetUInt32Value(
+        "scrub.rpc_timeout_ms", &scrubOptions->rpcTimeoutMs));
+}
+
+void ChunkServer::InitInflightThrottleOptions(
+    common::Configuration *conf,
+    InflightThrottleOptions *inflightThrottleOptions) {
+    LOG_IF(FATAL, !conf->GetUInt64Value("copyset.max_inflight_requests",
+        &inflightThrottleOptions->maxInflight));
+    LOG_IF(FATAL, !conf->GetBoolValue("copyset.inflight_adaptive_enable",
+        &inflightThrottleOptions->enableAdaptive));
+    LOG_IF(FATAL, !conf->GetUInt64Value("copyset.min_inflight_requests",
+        &inflightThrottleOptions->minInflight));
+    LOG_IF(FATAL, !conf->GetUInt64Value("copyset.inflight_target_latency_us",
+        &inflightThrottleOptions->targetLatencyUs));
+    LOG_IF(FATAL, !conf->GetUInt32Value("copyset.inflight_copyset_percent",
+        &inflightThrottleOptions->copysetPercent));
+    LOG_IF(FATAL, !conf->GetUInt32Value("copyset.inflight_background_percent",
+        &inflightThrottleOptions->backgroundPercent));
+}
+
 void ChunkServer::InitMetricOptions(
     common::Configuration *conf, ChunkServerMetricOptions *metricOptions) {
     LOG_IF(FATAL, !conf->GetUInt32Value(
@@ -31,6 +31,7 @@
 #include "src/chunkserver/clone_manager.h"
 #include "src/chunkserver/register.h"
 #include "src/chunkserver/trash.h"
+#include "src/chunkserver/scrub_manager.h"
 #include "src/chunkserver/chunkserver_metrics.h"
 #include "src/chunkserver/concurrent_apply/concurrent_apply.h"
 
@@ -62,6 +63,9 @@ class ChunkServer {
     void InitWalFilePoolOptions(common::Configuration *conf,
         FilePoolOptions *walPoolOption);
 
+    void InitLocalFileSystemOptions(common::Configuration *conf,
+        curve::fs::LocalFileSystemOption *lfsOption);
+
     void InitConcurrentApplyOptions(common::Configuration *conf,
         ConcurrentApplyOption *concurrentApplyOption);
 
@@ -83,6 +87,12 @@ class ChunkServer {
     void InitTrashOptions(common::Configuration *conf,
         TrashOptions *trashOptions);
 
+    void InitScrubOptions(common::Configuration *conf,
+        ScrubOptions *scrubOptions);
+
+    void InitInflightThrottleOptions(common::Configuration *conf,
+        InflightThrottleOptions *inflightThrottleOptions);
+
     void InitMetricOptions(common::Configuration *conf,
         ChunkServerMetricOptions *metricOptions);
 
@@ -109,6 +119,9 @@ class ChunkServer {
     // trash_ 定期回收垃圾站中的物理空间
     std::shared_ptr<Trash> trash_;
 
+    // scrubManager_ 执行后台数据校验任务
+    ScrubManager scrubManager_;
+
     // install snapshot流控
     scoped_refptr<SnapshotThrottle> snapshotThrottle_;
 };
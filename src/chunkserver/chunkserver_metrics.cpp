@@ -207,12 +207,15 @@ void CSCopysetMetric::MonitorDataStore(CSDataStore* datastore) {
     std::string chunkCountPrefix = Prefix() + "_chunk_count";
     std::string snapshotCountPrefix = Prefix() + "snapshot_count";
     std::string cloneChunkCountPrefix = Prefix() + "_clonechunk_count";
+    std::string unsyncedBytesPrefix = Prefix() + "_unsynced_bytes";
     chunkCount_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
         chunkCountPrefix, GetDatastoreChunkCountFunc, datastore);
     snapshotCount_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
         snapshotCountPrefix, GetDatastoreSnapshotCountFunc, datastore);
     cloneChunkCount_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
         cloneChunkCountPrefix, GetDatastoreCloneChunkCountFunc, datastore);
+    unsyncedBytes_ = std::make_shared<bvar::PassiveStatus<uint64_t>>(
+        unsyncedBytesPrefix, GetDatastoreUnsyncedBytesFunc, datastore);
 }
 
 ChunkServerMetric::ChunkServerMetric()
@@ -223,7 +226,8 @@ ChunkServerMetric::ChunkServerMetric()
     , chunkTrashed_(nullptr)
     , chunkCount_(nullptr)
     , snapshotCount_(nullptr)
-    , cloneChunkCount_(nullptr) {}
+    , cloneChunkCount_(nullptr)
+    , unsyncedBytes_(nullptr) {}
 
 ChunkServerMetric* ChunkServerMetric::self_ = nullptr;
 
@@ -272,6 +276,10 @@ int ChunkServerMetric::Init(const ChunkServerMetricOptions& option) {
     cloneChunkCount_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
         cloneChunkCountPrefix, GetTotalCloneChunkCountFunc, this);
 
+    std::string unsyncedBytesPrefix = Prefix() + "_unsynced_bytes";
+    unsyncedBytes_ = std::make_shared<bvar::PassiveStatus<uint64_t>>(
+        unsyncedBytesPrefix, GetTotalUnsyncedBytesFunc, this);
+
     hasInited_ = true;
     LOG(INFO) << "Init chunkserver metric success.";
     return 0;
@@ -287,6 +295,7 @@ int ChunkServerMetric::Fini() {
     chunkCount_ = nullptr;
     snapshotCount_ = nullptr;
     cloneChunkCount_ = nullptr;
+    unsyncedBytes_ = nullptr;
     copysetMetricMap_.Clear();
     hasInited_ = false;
     return 0;
@@ -379,6 +388,9 @@ void ChunkServerMetric::MonitorChunkFilePool(FilePool* chunkFilePool) {
     std::string chunkLeftPrefix = Prefix() + "_chunkfilepool_left";
     chunkLeft_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
         chunkLeftPrefix, GetChunkLeftFunc, chunkFilePool);
+    if (chunkFilePool != nullptr) {
+        chunkFilePool->ExposeMetric(Prefix() + "_chunkfilepool");
+    }
 }
 
 void ChunkServerMetric::MonitorWalFilePool(FilePool* walFilePool) {
@@ -389,6 +401,9 @@ void ChunkServerMetric::MonitorWalFilePool(FilePool* walFilePool) {
     std::string walSegmentLeftPrefix = Prefix() + "_walfilepool_left";
     walSegmentLeft_ = std::make_shared<bvar::PassiveStatus<uint32_t>>(
         walSegmentLeftPrefix, GetWalSegmentLeftFunc, walFilePool);
+    if (walFilePool != nullptr) {
+        walFilePool->ExposeMetric(Prefix() + "_walfilepool");
+    }
 }
 
 void ChunkServerMetric::MonitorTrash(Trash* trash) {
@@ -183,7 +183,8 @@ class CSCopysetMetric {
         , copysetId_(0)
         , chunkCount_(nullptr)
         , snapshotCount_(nullptr)
-        , cloneChunkCount_(nullptr) {}
+        , cloneChunkCount_(nullptr)
+        , unsyncedBytes_(nullptr) {}
 
     ~CSCopysetMetric() {}
 
@@ -254,6 +255,13 @@ class CSCopysetMetric {
         return cloneChunkCount_->get_value();
     }
 
+    const uint64_t GetUnsyncedBytes() const {
+        if (unsyncedBytes_ == nullptr) {
+            return 0;
+        }
+        return unsyncedBytes_->get_value();
+    }
+
  private:
     inline std::string Prefix() {
         return "copyset_"
@@ -273,6 +281,8 @@ class CSCopysetMetric {
     PassiveStatusPtr<uint32_t> snapshotCount_;
     // copyset上的 clone chunk 的数量
     PassiveStatusPtr<uint32_t> cloneChunkCount_;
+    // copyset上已写入但还没有sync到磁盘的字节数
+    PassiveStatusPtr<uint64_t> unsyncedBytes_;
     // copyset上的IO类型的metric统计
     CSIOMetric ioMetrics_;
 };
@@ -495,6 +505,12 @@ class ChunkServerMetric : public Uncopyable {
         return cloneChunkCount_->get_value();
     }
 
+    const uint64_t GetTotalUnsyncedBytes() {
+        if (unsyncedBytes_ == nullptr)
+            return 0;
+        return unsyncedBytes_->get_value();
+    }
+
     const uint32_t GetChunkLeftCount() const {
         if (chunkLeft_ == nullptr)
             return 0;
@@ -533,6 +549,8 @@ class ChunkServerMetric : public Uncopyable {
     PassiveStatusPtr<uint32_t> snapshotCount_;
     // chunkserver上的 clone chunk 的数量
     PassiveStatusPtr<uint32_t> cloneChunkCount_;
+    // chunkserver上已写入但还没有sync到磁盘的字节数
+    PassiveStatusPtr<uint64_t> unsyncedBytes_;
     // 各复制组metric的映射表，用GroupId作为key
     CopysetMetricMap copysetMetricMap_;
     // chunkserver上的IO类型的metric统计
@@ -54,11 +54,13 @@ void CurveAioCallback(struct CurveAioContext* context) {
 
 OriginCopyer::OriginCopyer()
     : curveClient_(nullptr)
-    , s3Client_(nullptr) {}
+    , s3Client_(nullptr)
+    , chunkSize_(0) {}
 
 int OriginCopyer::Init(const CopyerOptions& options) {
     curveClient_ = options.curveClient;
     s3Client_ = options.s3Client;
+    chunkSize_ = options.chunkSize;
     if (curveClient_ != nullptr) {
         int errorCode = curveClient_->Init(options.curveConf.c_str());
         if (errorCode != 0) {
@@ -137,15 +139,135 @@ void OriginCopyer::DownloadFromS3(const string& objectName,
         return;
     }
 
+    std::shared_ptr<const CompressedObjectHeader> header;
+    if (GetS3Header(objectName, &header)) {
+        DownloadS3Data(objectName, header, off, size, buf, done);
+    } else {
+        FetchS3Header(objectName,
+                      curve::common::kCompressedObjectHeaderReadSize,
+                      off, size, buf, done);
+    }
+    doneGuard.release();
+}
+
+void OriginCopyer::FetchS3Header(const string& objectName,
+                                 size_t headerLen,
+                                 off_t off,
+                                 size_t size,
+                                 char* buf,
+                                 DownloadClosure* done) {
+    // 对象可能比headerLen短，未读到的部分保持为0
+    std::shared_ptr<char> headerBuf(new char[headerLen](),
+                                    std::default_delete<char[]>());
     GetObjectAsyncCallBack cb =
         [=] (const S3Adapter* adapter,
              const std::shared_ptr<GetObjectAsyncContext>& context) {
             brpc::ClosureGuard doneGuard(done);
             if (context->retCode != 0) {
                 done->SetFailed();
+                return;
             }
+
+            // 没有magic的是未压缩的旧对象，按未压缩读取
+            if (!CompressedObjectHeader::HasMagic(headerBuf.get(),
+                                                  headerLen)) {
+                PutS3Header(objectName, nullptr);
+                DownloadS3Data(objectName, nullptr, off, size, buf, done);
+                doneGuard.release();
+                return;
+            }
+
+            // 按照chunkSize_校验frameNum，避免header长度溢出或者过大
+            uint32_t len = CompressedObjectHeader::GetHeaderLength(
+                headerBuf.get(), headerLen, chunkSize_);
+            if (len > headerLen) {
+                // header比预读的数据长，重新读取完整的header
+                FetchS3Header(objectName, len, off, size, buf, done);
+                doneGuard.release();
+                return;
+            }
+            // 有magic但是header无效，可能是对象损坏或者读到了不完整的数据，
+            // 按未压缩读取会返回错误的数据，直接返回失败。不缓存失败的结果，
+            // 下次请求重新读取header
+            auto header = std::make_shared<CompressedObjectHeader>();
+            if (len == 0 ||
+                !header->Decode(headerBuf.get(), len, chunkSize_)) {
+                LOG(ERROR) << "Invalid compressed object header."
+                           << "object name: " << objectName
+                           << ", header length: " << len;
+                done->SetFailed();
+                return;
+            }
+            PutS3Header(objectName, header);
+            DownloadS3Data(objectName, header, off, size, buf, done);
+            doneGuard.release();
         };
+    GetS3ObjectAsync(objectName, 0, headerLen, headerBuf.get(), cb);
+}
 
+void OriginCopyer::DownloadS3Data(
+    const string& objectName,
+    std::shared_ptr<const CompressedObjectHeader> header,
+    off_t off,
+    size_t size,
+    char* buf,
+    DownloadClosure* done) {
+    brpc::ClosureGuard doneGuard(done);
+    if (header == nullptr) {
+        GetObjectAsyncCallBack cb =
+            [=] (const S3Adapter* adapter,
+                 const std::shared_ptr<GetObjectAsyncContext>& context) {
+                brpc::ClosureGuard doneGuard(done);
+                if (context->retCode != 0) {
+                    done->SetFailed();
+                }
+            };
+        GetS3ObjectAsync(objectName, off, size, buf, cb);
+        doneGuard.release();
+        return;
+    }
+
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    if (!header->GetFrameRange(off, size, &begin, &end)) {
+        LOG(ERROR) << "Download range out of compressed object."
+                   << "object name: " << objectName
+                   << ", offset: " << off
+                   << ", size: " << size
+                   << ", data length: " << header->GetDataLength();
+        done->SetFailed();
+        return;
+    }
+    uint64_t frameOff = header->GetFrameOffset(begin);
+    size_t frameLen = header->GetFrameOffset(end) - frameOff;
+    std::shared_ptr<char> frameBuf(new char[frameLen],
+                                   std::default_delete<char[]>());
+    GetObjectAsyncCallBack cb =
+        [=] (const S3Adapter* adapter,
+             const std::shared_ptr<GetObjectAsyncContext>& context) {
+            brpc::ClosureGuard doneGuard(done);
+            if (context->retCode != 0) {
+                done->SetFailed();
+                return;
+            }
+            if (!header->DecompressFrames(frameBuf.get(), begin, end,
+                                          off, size, buf)) {
+                LOG(ERROR) << "Decompress s3 object failed."
+                           << "object name: " << objectName
+                           << ", offset: " << off
+                           << ", size: " << size;
+                done->SetFailed();
+            }
+        };
+    GetS3ObjectAsync(objectName, frameOff, frameLen, frameBuf.get(), cb);
+    doneGuard.release();
+}
+
+void OriginCopyer::GetS3ObjectAsync(const string& objectName,
+                                    off_t off,
+                                    size_t size,
+                                    char* buf,
+                                    GetObjectAsyncCallBack cb) {
     auto context = std::make_shared<GetObjectAsyncContext>();
     context->key = objectName;
     context->buf = buf;
@@ -154,7 +276,36 @@ void OriginCopyer::DownloadFromS3(const string& objectName,
     context->cb = cb;
 
     s3Client_->GetObjectAsync(context);
-    doneGuard.release();
+}
+
+bool OriginCopyer::GetS3Header(
+    const string& objectName,
+    std::shared_ptr<const CompressedObjectHeader>* header) {
+    std::unique_lock<std::mutex> lock(s3HeaderMtx_);
+    auto iter = s3HeaderMap_.find(objectName);
+    if (iter == s3HeaderMap_.end()) {
+        return false;
+    }
+    s3HeaderList_.splice(s3HeaderList_.begin(), s3HeaderList_, iter->second);
+    *header = iter->second->second;
+    return true;
+}
+
+void OriginCopyer::PutS3Header(
+    const string& objectName,
+    std::shared_ptr<const CompressedObjectHeader> header) {
+    std::unique_lock<std::mutex> lock(s3HeaderMtx_);
+    auto iter = s3HeaderMap_.find(objectName);
+    if (iter != s3HeaderMap_.end()) {
+        s3HeaderList_.erase(iter->second);
+        s3HeaderMap_.erase(iter);
+    }
+    s3HeaderList_.emplace_front(objectName, header);
+    s3HeaderMap_[objectName] = s3HeaderList_.begin();
+    if (s3HeaderList_.size() > kMaxS3HeaderCacheNum) {
+        s3HeaderMap_.erase(s3HeaderList_.back().first);
+        s3HeaderList_.pop_back();
+    }
 }
 
 void OriginCopyer::DownloadFromCurve(const string& fileName,
@@ -24,9 +24,11 @@
 #define SRC_CHUNKSERVER_CLONE_COPYER_H_
 
 #include <glog/logging.h>
+#include <list>
 #include <memory>
 #include <unordered_map>
 #include <string>
+#include <utility>
 
 #include "include/chunkserver/chunkserver_common.h"
 #include "src/common/location_operator.h"
@@ -35,6 +37,7 @@
 #include "src/client/client_common.h"
 #include "include/client/libcurve.h"
 #include "src/common/s3_adapter.h"
+#include "src/common/compressed_object.h"
 
 namespace curve {
 namespace chunkserver {
@@ -46,10 +49,14 @@ using curve::common::LocationOperator;
 using curve::common::OriginType;
 using curve::common::GetObjectAsyncCallBack;
 using curve::common::GetObjectAsyncContext;
+using curve::common::CompressedObjectHeader;
 using std::string;
 
 class DownloadClosure;
 
+// 缓存的s3对象header的最大数量，对象名包含版本号，对象写入后不会再修改
+const size_t kMaxS3HeaderCacheNum = 4096;
+
 struct CopyerOptions {
     // curvefs上的root用户信息
     UserInfo curveUser;
@@ -61,6 +68,8 @@ struct CopyerOptions {
     std::shared_ptr<FileClient> curveClient;
     // s3 adapter的对象指针
     std::shared_ptr<S3Adapter> s3Client;
+    // chunk的大小，也是s3对象原始数据长度的上限，用于校验压缩对象的header
+    uint32_t chunkSize = 0;
 };
 
 struct AsyncDownloadContext {
@@ -113,6 +122,39 @@ class OriginCopyer {
                           char* buf,
                           DownloadClosure* done);
 
+    /**
+     * 读取s3对象开头的headerLen字节并解析header，然后下载数据
+     * 快照转储的对象可能是压缩的，需要根据header确定数据的位置。
+     * header无效时(包括crc不匹配)按未压缩的对象读取
+     */
+    void FetchS3Header(const string& objectName,
+                       size_t headerLen,
+                       off_t off,
+                       size_t size,
+                       char* buf,
+                       DownloadClosure* done);
+    /**
+     * 根据header下载对象中[off, off + size)的原始数据
+     * @param header: 为nullptr时对象未压缩，直接读取对应的范围；
+     * 否则读取覆盖该范围的frame并解压
+     */
+    void DownloadS3Data(const string& objectName,
+                        std::shared_ptr<const CompressedObjectHeader> header,
+                        off_t off,
+                        size_t size,
+                        char* buf,
+                        DownloadClosure* done);
+    void GetS3ObjectAsync(const string& objectName,
+                          off_t off,
+                          size_t size,
+                          char* buf,
+                          GetObjectAsyncCallBack cb);
+
+    bool GetS3Header(const string& objectName,
+                     std::shared_ptr<const CompressedObjectHeader>* header);
+    void PutS3Header(const string& objectName,
+                     std::shared_ptr<const CompressedObjectHeader> header);
+
  private:
     // curvefs上的root用户信息
     UserInfo curveUser_;
@@ -120,10 +162,21 @@ class OriginCopyer {
     std::shared_ptr<FileClient> curveClient_;
     // 负责跟s3交互
     std::shared_ptr<S3Adapter>  s3Client_;
+    // chunk的大小，s3对象的header中记录的原始数据不能超过这个大小
+    uint32_t chunkSize_;
     // 保护fdMap_的互斥锁
     std::mutex  mtx_;
     // 文件名->文件fd 的映射
     std::unordered_map<std::string, int> fdMap_;
+
+    using S3HeaderItem =
+        std::pair<std::string, std::shared_ptr<const CompressedObjectHeader>>;
+    // 保护s3对象header缓存的互斥锁
+    std::mutex s3HeaderMtx_;
+    // 按LRU淘汰的s3对象header，header为nullptr表示对象未压缩
+    std::list<S3HeaderItem> s3HeaderList_;
+    std::unordered_map<std::string, std::list<S3HeaderItem>::iterator>
+        s3HeaderMap_;
 };
 
 }  // namespace chunkserver
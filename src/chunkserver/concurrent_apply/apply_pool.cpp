@@ -0,0 +1,399 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <glog/logging.h>
+
+#include <set>
+#include <utility>
+
+#include "src/chunkserver/concurrent_apply/apply_pool.h"
+#include "src/common/concurrent/count_down_event.h"
+#include "src/common/timeutility.h"
+
+using ::curve::common::CountDownEvent;
+using ::curve::common::TimeUtility;
+
+namespace curve {
+namespace chunkserver {
+namespace concurrent {
+
+ApplyPool::ApplyPool(const std::string& name, int concurrent, int depth)
+    : name_(name),
+      concurrent_(concurrent),
+      capacity_(static_cast<int64_t>(concurrent) * depth),
+      running_(false),
+      pending_(0) {
+    for (int i = 0; i < concurrent_; ++i) {
+        std::unique_ptr<ApplyQueue> queue(new ApplyQueue());
+        std::string prefix = name_ + "_queue_" + std::to_string(i);
+        queue->depth.expose(prefix + "_depth");
+        queue->waitLatency.expose(prefix + "_wait");
+        queues_.emplace_back(std::move(queue));
+    }
+    stealCount_.expose(name_ + "_steal_count");
+}
+
+ApplyPool::~ApplyPool() {
+    Stop();
+}
+
+void ApplyPool::Start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    for (int i = 0; i < concurrent_; ++i) {
+        queues_[i]->th = std::thread(&ApplyPool::Run, this, i);
+    }
+}
+
+void ApplyPool::Stop() {
+    if (!running_.load()) {
+        return;
+    }
+    // The chains parked by the asynchronous tasks are not in the queues,
+    // the threads may exit before they finish, so wait for all the tasks
+    Flush();
+    if (!running_.exchange(false)) {
+        return;
+    }
+    for (auto& queue : queues_) {
+        std::lock_guard<std::mutex> lk(queue->mtx);
+        queue->cond.notify_all();
+    }
+    for (auto& queue : queues_) {
+        queue->th.join();
+    }
+}
+
+void ApplyPool::Push(uint64_t key, Task task, uint64_t volume) {
+    TaskItem item;
+    item.task = std::move(task);
+    PushItem(key, std::move(item), volume);
+}
+
+void ApplyPool::PushAsync(uint64_t key, AsyncTask task, uint64_t volume) {
+    TaskItem item;
+    item.asyncTask = std::move(task);
+    PushItem(key, std::move(item), volume);
+}
+
+void ApplyPool::PushItem(uint64_t key, TaskItem item, uint64_t volume) {
+    int64_t pending = pending_.load();
+    while (true) {
+        if (pending < capacity_) {
+            if (pending_.compare_exchange_weak(pending, pending + 1)) {
+                break;
+            }
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(fullMtx_);
+        while (pending_.load() >= capacity_) {
+            notFull_.wait(lk);
+        }
+        pending = pending_.load();
+    }
+
+    TaskChain* chain = nullptr;
+    bool newChain = false;
+    ChainShard* shard = GetShard(key);
+    {
+        std::lock_guard<std::mutex> lk(shard->mtx);
+        auto iter = shard->chains.find(key);
+        if (iter == shard->chains.end()) {
+            chain = new TaskChain();
+            chain->key = key;
+            chain->volume = volume;
+            chain->home = key % concurrent_;
+            shard->chains.emplace(key, chain);
+            newChain = true;
+        } else {
+            chain = iter->second;
+        }
+        item.pushTime = TimeUtility::GetTimeofDayUs();
+        chain->tasks.push_back(std::move(item));
+        queues_[chain->home]->depth << 1;
+    }
+
+    // The chain already exists means it is queued or being executed,
+    // the task will be executed after the tasks before it
+    if (newChain) {
+        Schedule(chain->home, chain);
+    }
+}
+
+void ApplyPool::Flush() {
+    // Append a barrier to every chain, all the tasks pushed before are
+    // finished when all the barriers are executed. The shards are locked
+    // together, so no barrier can be executed before the count is set.
+    CountDownEvent event(0);
+    int count = 0;
+    for (auto& shard : shards_) {
+        shard.mtx.lock();
+    }
+    for (auto& shard : shards_) {
+        for (auto& item : shard.chains) {
+            item.second->tasks.push_back({[&event]() { event.Signal(); },
+                                          nullptr,
+                                          TimeUtility::GetTimeofDayUs()});
+            queues_[item.second->home]->depth << 1;
+            ++count;
+        }
+    }
+    pending_.fetch_add(count);
+    event.Reset(count);
+    for (auto& shard : shards_) {
+        shard.mtx.unlock();
+    }
+    event.Wait();
+}
+
+void ApplyPool::Flush(const std::vector<uint64_t>& keys) {
+    // Same as Flush(), but only the chains of the keys get a barrier.
+    // The shards are locked in index order, the same as Flush().
+    std::set<int> shardIndexes;
+    for (auto key : keys) {
+        shardIndexes.insert(key % kChainShardNum);
+    }
+    for (int index : shardIndexes) {
+        shards_[index].mtx.lock();
+    }
+    CountDownEvent event(0);
+    int count = 0;
+    std::set<uint64_t> flushed;
+    for (auto key : keys) {
+        if (!flushed.insert(key).second) {
+            continue;
+        }
+        ChainShard* shard = GetShard(key);
+        auto iter = shard->chains.find(key);
+        if (iter == shard->chains.end()) {
+            continue;
+        }
+        iter->second->tasks.push_back({[&event]() { event.Signal(); },
+                                       nullptr,
+                                       TimeUtility::GetTimeofDayUs()});
+        queues_[iter->second->home]->depth << 1;
+        ++count;
+    }
+    pending_.fetch_add(count);
+    event.Reset(count);
+    for (int index : shardIndexes) {
+        shards_[index].mtx.unlock();
+    }
+    event.Wait();
+}
+
+int64_t ApplyPool::GetQueueDepth(int index) const {
+    return queues_[index]->depth.get_value();
+}
+
+void ApplyPool::Schedule(int index, TaskChain* chain) {
+    ApplyQueue* queue = queues_[index].get();
+    {
+        std::lock_guard<std::mutex> lk(queue->mtx);
+        Enqueue(queue, chain);
+        if (queue->idle.load() && !queue->signaled) {
+            queue->signaled = true;
+            queue->cond.notify_one();
+            return;
+        }
+    }
+    // The thread of the queue is busy, let an idle thread steal the chain.
+    // The size of the queue is increased before the idle flags are read,
+    // and a thread sets its idle flag before reading the sizes, so either
+    // the thread finds the chain or it is woken up here.
+    for (int i = 1; i < concurrent_; ++i) {
+        if (Wakeup(queues_[(index + i) % concurrent_].get())) {
+            return;
+        }
+    }
+}
+
+bool ApplyPool::Wakeup(ApplyQueue* queue) {
+    if (!queue->idle.load()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lk(queue->mtx);
+    if (!queue->idle.load() || queue->signaled) {
+        return false;
+    }
+    queue->signaled = true;
+    queue->cond.notify_one();
+    return true;
+}
+
+void ApplyPool::Enqueue(ApplyQueue* queue, TaskChain* chain) {
+    auto& chains = queue->runnable[chain->volume];
+    if (chains.empty()) {
+        queue->volumes.push_back(chain->volume);
+    }
+    chains.push_back(chain);
+    queue->size.fetch_add(1);
+}
+
+ApplyPool::TaskChain* ApplyPool::Dequeue(ApplyQueue* queue) {
+    if (queue->volumes.empty()) {
+        return nullptr;
+    }
+    uint64_t volume = queue->volumes.front();
+    queue->volumes.pop_front();
+    auto iter = queue->runnable.find(volume);
+    TaskChain* chain = iter->second.front();
+    iter->second.pop_front();
+    if (iter->second.empty()) {
+        queue->runnable.erase(iter);
+    } else {
+        // the volume waits for the other volumes before its next chain
+        queue->volumes.push_back(volume);
+    }
+    queue->size.fetch_sub(1);
+    return chain;
+}
+
+ApplyPool::TaskChain* ApplyPool::PickChain(int index) {
+    for (int i = 0; i < concurrent_; ++i) {
+        ApplyQueue* queue = queues_[(index + i) % concurrent_].get();
+        if (queue->size.load() == 0) {
+            continue;
+        }
+        TaskChain* chain = nullptr;
+        {
+            std::lock_guard<std::mutex> lk(queue->mtx);
+            chain = Dequeue(queue);
+        }
+        if (chain != nullptr) {
+            // steal a chain from the next busy queue
+            if (i != 0) {
+                stealCount_ << 1;
+            }
+            return chain;
+        }
+    }
+    return nullptr;
+}
+
+void ApplyPool::WaitForChain(int index) {
+    ApplyQueue* queue = queues_[index].get();
+    std::unique_lock<std::mutex> lk(queue->mtx);
+    while (!queue->signaled && queue->size.load() == 0 && running_.load()) {
+        queue->cond.wait(lk);
+    }
+    queue->signaled = false;
+    queue->idle.store(false);
+}
+
+void ApplyPool::Run(int index) {
+    ApplyQueue* queue = queues_[index].get();
+    while (true) {
+        TaskChain* chain = PickChain(index);
+        if (chain == nullptr) {
+            // Look at the queues again after marking the thread idle,
+            // a chain scheduled after that will wake the thread up
+            queue->idle.store(true);
+            chain = PickChain(index);
+            if (chain == nullptr) {
+                // exit only after all the tasks are finished
+                if (!running_.load()) {
+                    return;
+                }
+                WaitForChain(index);
+                continue;
+            }
+            // The thread may have been chosen to steal another chain,
+            // pass the wakeup to the other idle threads
+            bool signaled = false;
+            {
+                std::lock_guard<std::mutex> lk(queue->mtx);
+                signaled = queue->signaled;
+                queue->signaled = false;
+                queue->idle.store(false);
+            }
+            if (signaled) {
+                for (int i = 1; i < concurrent_; ++i) {
+                    if (Wakeup(queues_[(index + i) % concurrent_].get())) {
+                        break;
+                    }
+                }
+            }
+        }
+        RunChain(index, chain);
+    }
+}
+
+void ApplyPool::RunChain(int index, TaskChain* chain) {
+    ChainShard* shard = GetShard(chain->key);
+    for (int i = 0; i < kMaxTasksPerRun; ++i) {
+        TaskItem item;
+        {
+            std::lock_guard<std::mutex> lk(shard->mtx);
+            if (chain->tasks.empty()) {
+                shard->chains.erase(chain->key);
+                delete chain;
+                return;
+            }
+            item = std::move(chain->tasks.front());
+            chain->tasks.pop_front();
+        }
+        ApplyQueue* home = queues_[chain->home].get();
+        home->depth << -1;
+        home->waitLatency << TimeUtility::GetTimeofDayUs() - item.pushTime;
+
+        if (item.asyncTask) {
+            // the chain is scheduled again when the task finishes, it must
+            // not be touched here, the task may have finished already
+            item.asyncTask([this, chain]() { FinishAsyncTask(chain); });
+            return;
+        }
+        item.task();
+        FinishTask();
+    }
+    // put the chain back to the tail of the queue
+    Schedule(index, chain);
+}
+
+void ApplyPool::FinishAsyncTask(TaskChain* chain) {
+    bool empty = false;
+    {
+        ChainShard* shard = GetShard(chain->key);
+        std::lock_guard<std::mutex> lk(shard->mtx);
+        if (chain->tasks.empty()) {
+            shard->chains.erase(chain->key);
+            delete chain;
+            empty = true;
+        }
+    }
+    FinishTask();
+    // The chain is not empty if Stop is waiting for it, its tasks may let
+    // Stop go on, so the pool should not be touched after Schedule
+    if (!empty) {
+        Schedule(chain->home, chain);
+    }
+}
+
+void ApplyPool::FinishTask() {
+    if (pending_.fetch_sub(1) >= capacity_) {
+        std::lock_guard<std::mutex> lk(fullMtx_);
+        notFull_.notify_all();
+    }
+}
+
+}   // namespace concurrent
+}   // namespace chunkserver
+}   // namespace curve
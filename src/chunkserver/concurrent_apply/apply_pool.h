@@ -0,0 +1,260 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#ifndef SRC_CHUNKSERVER_CONCURRENT_APPLY_APPLY_POOL_H_
+#define SRC_CHUNKSERVER_CONCURRENT_APPLY_APPLY_POOL_H_
+
+#include <bvar/bvar.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>    // NOLINT
+#include <string>
+#include <thread>    // NOLINT
+#include <unordered_map>
+#include <vector>
+#include <condition_variable>    // NOLINT
+
+#include "include/curve_compiler_specific.h"
+
+namespace curve {
+namespace chunkserver {
+namespace concurrent {
+
+/**
+ * ApplyPool executes the apply tasks of one thread pool (read or write).
+ *
+ * Tasks with the same key (chunk id) are linked into a task chain and are
+ * executed one by one in push order, so the order of the operations on the
+ * same chunk is kept. Each chain is queued on its home queue (key % number
+ * of threads), and a thread whose own queue is empty steals a whole chain
+ * from the other queues, so a few hot chunks will not block the other
+ * chunks hashed to the same thread while the other threads are idle.
+ *
+ * The runnable chains of a queue are grouped by volume (the file that the
+ * chunk belongs to) and the volumes are served round robin, one chain run
+ * at a time, so a volume with lots of busy chunks can not monopolize the
+ * threads and delay the requests of the other volumes.
+ *
+ * Every queue has its own lock, pushers and threads of different queues do
+ * not contend with each other. A thread going to sleep marks itself idle
+ * before looking at the queues for the last time, and a chain scheduled to
+ * a busy queue wakes up an idle thread to steal it.
+ *
+ * An asynchronous task finishes when the callback passed to it is called,
+ * e.g. by the io completion thread. Its chain is parked until then, so the
+ * following tasks of the key still run after it, while the thread goes on
+ * with the other chains instead of waiting for the io.
+ */
+class ApplyPool {
+ public:
+    using Task = std::function<void()>;
+    // The argument should be called when the task finishes
+    using AsyncTask = std::function<void(std::function<void()>)>;
+
+    /**
+     * @param[in] name: name of the pool, used as the prefix of metrics
+     * @param[in] concurrent: num of threads
+     * @param[in] depth: depth of every queue, Push blocks when the tasks
+     *                   not finished exceed concurrent * depth
+     */
+    ApplyPool(const std::string& name, int concurrent, int depth);
+    ~ApplyPool();
+
+    void Start();
+
+    /**
+     * Stop the threads after all the pushed tasks are finished
+     */
+    void Stop();
+
+    /**
+     * Push a task to the chain of the key
+     * @param[in] key: tasks with the same key are executed in order
+     * @param[in] task: the task to execute
+     * @param[in] volume: the volume that the key belongs to, chains of
+     *                    different volumes are scheduled fairly
+     */
+    void Push(uint64_t key, Task task, uint64_t volume = 0);
+
+    /**
+     * Push an asynchronous task to the chain of the key, the next task of
+     * the key is executed after the callback passed to the task is called
+     * @param[in] key: tasks with the same key are executed in order
+     * @param[in] task: the task to execute, it should call the callback
+     *                  exactly once, in any thread
+     * @param[in] volume: the volume that the key belongs to
+     */
+    void PushAsync(uint64_t key, AsyncTask task, uint64_t volume = 0);
+
+    /**
+     * Wait until all the tasks pushed before are finished
+     */
+    void Flush();
+
+    /**
+     * Wait until the tasks of the keys pushed before are finished,
+     * the chains of the other keys are not waited for
+     * @param[in] keys: the keys to wait for
+     */
+    void Flush(const std::vector<uint64_t>& keys);
+
+    /**
+     * Get the number of tasks waiting in the chains homed at the queue
+     */
+    int64_t GetQueueDepth(int index) const;
+
+    /**
+     * Get the number of chains stolen from the other queues
+     */
+    uint64_t GetStealCount() const {
+        return stealCount_.get_value();
+    }
+
+ private:
+    struct TaskItem {
+        Task task;
+        // set instead of task for an asynchronous task
+        AsyncTask asyncTask;
+        // time when the task is pushed, in us
+        uint64_t pushTime;
+    };
+
+    struct TaskChain {
+        uint64_t key;
+        uint64_t volume;
+        // index of the home queue
+        int home;
+        // protected by the lock of the shard where the chain is
+        std::deque<TaskItem> tasks;
+    };
+
+    struct ChainShard {
+        std::mutex mtx;
+        std::unordered_map<uint64_t, TaskChain*> chains;
+    };
+
+    struct CURVE_CACHELINE_ALIGNMENT ApplyQueue {
+        std::thread th;
+        std::mutex mtx;
+        std::condition_variable cond;
+        // chains waiting to be executed grouped by volume, and the volumes
+        // having runnable chains in round robin order, protected by mtx
+        std::unordered_map<uint64_t, std::deque<TaskChain*>> runnable;
+        std::deque<uint64_t> volumes;
+        // number of the runnable chains, read without mtx to skip the
+        // empty queues when stealing
+        std::atomic<int64_t> size{0};
+        // the thread of the queue is looking for chains before sleeping
+        // or is sleeping, a chain scheduled then should wake it up
+        std::atomic<bool> idle{false};
+        // the thread is woken up, protected by mtx
+        bool signaled = false;
+        // tasks waiting in the chains homed at this queue
+        bvar::Adder<int64_t> depth;
+        // time between the task is pushed and it starts to execute
+        bvar::LatencyRecorder waitLatency;
+    };
+
+    void PushItem(uint64_t key, TaskItem item, uint64_t volume);
+
+    void Run(int index);
+
+    /**
+     * Pick a chain from the own queue first, steal one from the other
+     * queues if the own queue is empty
+     */
+    TaskChain* PickChain(int index);
+
+    /**
+     * Sleep until the thread is woken up by Schedule or Stop
+     */
+    void WaitForChain(int index);
+
+    /**
+     * Execute the tasks of the chain, the chain is released if it becomes
+     * empty, otherwise it is put back to the queue after a batch of tasks,
+     * so that the other chains in the queue get a chance to run
+     */
+    void RunChain(int index, TaskChain* chain);
+
+    /**
+     * Called when an asynchronous task of the chain finishes, the chain
+     * is put back to its home queue if it has more tasks
+     */
+    void FinishAsyncTask(TaskChain* chain);
+
+    /**
+     * Account a finished task and wake up the pushers waiting for space
+     */
+    void FinishTask();
+
+    /**
+     * Put the chain to the queue and wake up the thread of the queue, or
+     * an idle thread if the thread of the queue is busy
+     */
+    void Schedule(int index, TaskChain* chain);
+
+    /**
+     * Wake up the thread of the queue if it is idle
+     * @return false if the thread is busy or is woken up already
+     */
+    bool Wakeup(ApplyQueue* queue);
+
+    /**
+     * Put the chain to the tail of its volume in the queue / take a chain
+     * from the volume at the head of the round robin order
+     * Should be called with the lock of the queue held
+     */
+    void Enqueue(ApplyQueue* queue, TaskChain* chain);
+    TaskChain* Dequeue(ApplyQueue* queue);
+
+    ChainShard* GetShard(uint64_t key) {
+        return &shards_[key % kChainShardNum];
+    }
+
+ private:
+    static const int kChainShardNum = 32;
+    // max tasks of one chain executed before the chain is rescheduled
+    static const int kMaxTasksPerRun = 64;
+
+    std::string name_;
+    int concurrent_;
+    // max tasks not finished in the pool
+    int64_t capacity_;
+    std::atomic<bool> running_;
+    // tasks pushed but not finished
+    std::atomic<int64_t> pending_;
+
+    // pushers wait on notFull_ when the pool is full
+    std::mutex fullMtx_;
+    std::condition_variable notFull_;
+
+    ChainShard shards_[kChainShardNum];
+    std::vector<std::unique_ptr<ApplyQueue>> queues_;
+    bvar::Adder<uint64_t> stealCount_;
+};
+
+}   // namespace concurrent
+}   // namespace chunkserver
+}   // namespace curve
+
+#endif  // SRC_CHUNKSERVER_CONCURRENT_APPLY_APPLY_POOL_H_
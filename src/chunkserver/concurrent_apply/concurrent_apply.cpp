@@ -22,12 +22,7 @@
 
 #include <glog/logging.h>
 
-#include <algorithm>
-#include <vector>
 #include "src/chunkserver/concurrent_apply/concurrent_apply.h"
-#include "src/common/concurrent/count_down_event.h"
-
-using ::curve::common::CountDownEvent;
 
 namespace curve {
 namespace chunkserver {
@@ -42,15 +37,13 @@ bool ConcurrentApplyModule::Init(const ConcurrentApplyOption &opt) {
         return false;
     }
 
+    rapplyPool_.reset(new ApplyPool(
+        "concurrent_apply_read", rconcurrentsize_, rqueuedepth_));
+    wapplyPool_.reset(new ApplyPool(
+        "concurrent_apply_write", wconcurrentsize_, wqueuedepth_));
+    rapplyPool_->Start();
+    wapplyPool_->Start();
     start_ = true;
-    cond_.Reset(opt.rconcurrentsize + opt.wconcurrentsize);
-    InitThreadPool(ThreadPoolType::READ, rconcurrentsize_, rqueuedepth_);
-    InitThreadPool(ThreadPoolType::WRITE, wconcurrentsize_, wqueuedepth_);
-
-    if (!cond_.WaitFor(5000)) {
-        LOG(ERROR) << "init concurrent module's threads fail";
-        start_ = false;
-    }
 
     LOG(INFO) << "Init concurrent module's threads success";
     return start_;
@@ -76,86 +69,27 @@ bool ConcurrentApplyModule::checkOptAndInit(
     return true;
 }
 
-
-void ConcurrentApplyModule::InitThreadPool(
-    ThreadPoolType type, int concorrent, int depth) {
-    for (int i = 0; i < concorrent; i++) {
-        auto asyncth = new (std::nothrow) taskthread(depth);
-        CHECK(asyncth != nullptr) << "allocate failed!";
-
-        switch (type) {
-        case ThreadPoolType::READ:
-            rapplyMap_.insert(std::make_pair(i, asyncth));
-            break;
-
-        case ThreadPoolType::WRITE:
-            wapplyMap_.insert(std::make_pair(i, asyncth));
-            break;
-        }
-    }
-
-    for (int i = 0; i < concorrent; i++) {
-        switch (type) {
-        case ThreadPoolType::READ:
-            rapplyMap_[i]->th = std::move(
-                std::thread(&ConcurrentApplyModule::Run, this, type, i));
-            break;
-
-        case ThreadPoolType::WRITE:
-            wapplyMap_[i]->th =
-                std::thread(&ConcurrentApplyModule::Run, this, type, i);
-            break;
-        }
-    }
-}
-
-void ConcurrentApplyModule::Run(ThreadPoolType type, int index) {
-    cond_.Signal();
-    while (start_) {
-        switch (type) {
-        case ThreadPoolType::READ:
-            rapplyMap_[index]->tq.Pop()();
-            break;
-
-        case ThreadPoolType::WRITE:
-            wapplyMap_[index]->tq.Pop()();
-            break;
-        }
-    }
-}
-
 void ConcurrentApplyModule::Stop() {
     LOG(INFO) << "stop ConcurrentApplyModule...";
     start_ = false;
-    auto wakeup = []() {};
-    for (auto iter : rapplyMap_) {
-        iter.second->tq.Push(wakeup);
-        iter.second->th.join();
-        delete iter.second;
+    if (rapplyPool_ != nullptr) {
+        rapplyPool_->Stop();
+        rapplyPool_.reset();
     }
-    rapplyMap_.clear();
-
-    for (auto iter : wapplyMap_) {
-        iter.second->tq.Push(wakeup);
-        iter.second->th.join();
-        delete iter.second;
+    if (wapplyPool_ != nullptr) {
+        wapplyPool_->Stop();
+        wapplyPool_.reset();
     }
-    wapplyMap_.clear();
 
     LOG(INFO) << "stop ConcurrentApplyModule ok.";
 }
 
 void ConcurrentApplyModule::Flush() {
-    CountDownEvent event(wconcurrentsize_);
-    auto flushtask = [&event]() {
-        event.Signal();
-    };
-
-    for (int i = 0; i < wconcurrentsize_; i++) {
-        wapplyMap_[i]->tq.Push(flushtask);
-    }
+    wapplyPool_->Flush();
+}
 
-    event.Wait();
+void ConcurrentApplyModule::Flush(const std::vector<uint64_t>& keys) {
+    wapplyPool_->Flush(keys);
 }
 
 ThreadPoolType ConcurrentApplyModule::Schedule(CHUNK_OP_TYPE optype) {
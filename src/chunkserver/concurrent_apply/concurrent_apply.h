@@ -25,20 +25,14 @@
 
 #include <glog/logging.h>
 #include <unistd.h>
-#include <atomic>
-#include <mutex>    // NOLINT
-#include <thread>    // NOLINT
-#include <unordered_map>
+#include <memory>
 #include <utility>
-#include <condition_variable>    // NOLINT
+#include <vector>
 
-#include "src/common/concurrent/task_queue.h"
-#include "src/common/concurrent/count_down_event.h"
+#include "src/chunkserver/concurrent_apply/apply_pool.h"
 #include "proto/chunk.pb.h"
 #include "include/curve_compiler_specific.h"
 
-using curve::common::TaskQueue;
-using curve::common::CountDownEvent;
 using curve::chunkserver::CHUNK_OP_TYPE;
 
 namespace curve {
@@ -60,8 +54,7 @@ class CURVE_CACHELINE_ALIGNMENT ConcurrentApplyModule {
                              rconcurrentsize_(0),
                              wconcurrentsize_(0),
                              rqueuedepth_(0),
-                             wqueuedepth_(0),
-                             cond_(0) {}
+                             wqueuedepth_(0) {}
     ~ConcurrentApplyModule() {}
 
     /**
@@ -75,6 +68,8 @@ class CURVE_CACHELINE_ALIGNMENT ConcurrentApplyModule {
 
     /**
      * Push: apply task will be push to ConcurrentApplyModule
+     * tasks with the same key are executed in order, tasks with different
+     * keys may be executed by any thread of the pool
      * @param[in] key: used to hash task to specified queue
      * @param[in] optype: operation type defined in proto
      * @param[in] f: task
@@ -82,13 +77,48 @@ class CURVE_CACHELINE_ALIGNMENT ConcurrentApplyModule {
      */
     template<class F, class... Args>
     bool Push(uint64_t key, CHUNK_OP_TYPE optype, F&& f, Args&&... args) {
+        return Push(key, 0, optype,
+                    std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    /**
+     * Push: same as above, the tasks of different volumes are scheduled
+     * fairly, so a busy volume will not delay the tasks of the others
+     * @param[in] volume: the volume (file id) that the chunk belongs to
+     */
+    template<class F, class... Args>
+    bool Push(uint64_t key, uint64_t volume, CHUNK_OP_TYPE optype,
+              F&& f, Args&&... args) {
         auto task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
         switch (Schedule(optype)) {
             case ThreadPoolType::READ:
-                rapplyMap_[Hash(key, rconcurrentsize_)]->tq.Push(task);
+                rapplyPool_->Push(key, task, volume);
                 break;
             case ThreadPoolType::WRITE:
-                wapplyMap_[Hash(key, wconcurrentsize_)]->tq.Push(task);
+                wapplyPool_->Push(key, task, volume);
+                break;
+        }
+
+        return true;
+    }
+
+    /**
+     * PushAsync: push an asynchronous task, the task finishes when the
+     * callback passed to it is called, the next task of the key is executed
+     * after that, but the thread does not wait for it
+     * @param[in] key: used to hash task to specified queue
+     * @param[in] volume: the volume (file id) that the chunk belongs to
+     * @param[in] optype: operation type defined in proto
+     * @param[in] task: task, should call the callback exactly once
+     */
+    bool PushAsync(uint64_t key, uint64_t volume, CHUNK_OP_TYPE optype,
+                   ApplyPool::AsyncTask task) {
+        switch (Schedule(optype)) {
+            case ThreadPoolType::READ:
+                rapplyPool_->PushAsync(key, std::move(task), volume);
+                break;
+            case ThreadPoolType::WRITE:
+                wapplyPool_->PushAsync(key, std::move(task), volume);
                 break;
         }
 
@@ -100,38 +130,28 @@ class CURVE_CACHELINE_ALIGNMENT ConcurrentApplyModule {
      */
     void Flush();
 
+    /**
+     * Flush: finish the tasks of the keys in write threads, the tasks of
+     * the other keys are not waited for
+     * @param[in] keys: the keys (chunk ids) to wait for
+     */
+    void Flush(const std::vector<uint64_t>& keys);
+
     void Stop();
 
  private:
     bool checkOptAndInit(const ConcurrentApplyOption &option);
 
-    void Run(ThreadPoolType type, int index);
-
     ThreadPoolType Schedule(CHUNK_OP_TYPE optype);
 
-    void InitThreadPool(ThreadPoolType type, int concorrent, int depth);
-
-    int Hash(uint64_t key, int concurrent) {
-        return key % concurrent;
-    }
-
  private:
-    typedef uint8_t threadIndex;
-    typedef struct taskthread {
-        std::thread th;
-        TaskQueue tq;
-        taskthread(size_t capacity):tq(capacity) {}
-        ~taskthread() = default;
-    } taskthread_t;
-
     bool start_;
     int rconcurrentsize_;
     int rqueuedepth_;
     int wconcurrentsize_;
     int wqueuedepth_;
-    CountDownEvent cond_;
-    CURVE_CACHELINE_ALIGNMENT std::unordered_map<threadIndex, taskthread_t*> wapplyMap_; // NOLINT
-    CURVE_CACHELINE_ALIGNMENT std::unordered_map<threadIndex, taskthread_t*> rapplyMap_;   // NOLINT
+    std::unique_ptr<ApplyPool> wapplyPool_;
+    std::unique_ptr<ApplyPool> rapplyPool_;
 };
 }   // namespace concurrent
 }   // namespace chunkserver
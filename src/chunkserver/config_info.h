@@ -27,6 +27,7 @@
 #include <memory>
 
 #include "src/fs/local_filesystem.h"
+#include "src/common/concurrent/task_thread_pool.h"
 #include "src/chunkserver/trash.h"
 #include "src/chunkserver/inflight_throttle.h"
 #include "src/chunkserver/concurrent_apply/concurrent_apply.h"
@@ -37,6 +38,7 @@ namespace chunkserver {
 
 using curve::fs::LocalFileSystem;
 using curve::chunkserver::concurrent::ConcurrentApplyModule;
+using curve::common::TaskThreadPool;
 
 class FilePool;
 class CopysetNodeManager;
@@ -107,6 +109,24 @@ struct CopysetNodeOptions {
 
     // 限制chunkserver启动时copyset并发恢复加载的数量,为0表示不限制
     uint32_t loadConcurrency = 0;
+    // chunkserver启动时加载chunk文件的并发线程数，为0表示串行加载
+    uint32_t loadChunkConcurrency = 0;
+    // 加载chunk文件的线程池，由CopysetNodeManager在加载copyset期间创建，
+    // 所有copyset共享，为nullptr时datastore串行加载chunk文件
+    std::shared_ptr<TaskThreadPool<>> chunkLoader;
+    // 是否使用metapage索引，开启后copyset正常退出时会将所有chunk的metapage
+    // 保存到索引文件中，下次启动时不需要再逐个读取chunk文件的metapage
+    bool enableChunkMetaIndex = false;
+    // 是否开启chunk写入的group commit，开启后chunk文件不使用O_DSYNC打开，
+    // 数据在raft打快照时统一sync，在此之前raft日志不会被截断
+    bool enableChunkGroupCommit = false;
+    // chunk缓存crc的region大小，需要是page大小的整数倍并且能整除chunk大小，
+    // 写入只会使覆盖到的region失效，比较副本时只需重新读取失效的region，
+    // 为0表示不开启
+    uint32_t chunkRegionHashSize = 0;
+    // discard时是否对chunk文件打洞释放空间，打洞会让chunk文件池预分配的
+    // 空间失效，之后的写入需要重新分配，为false时只将范围置零，保留预分配的空间
+    bool discardPunchHole = false;
     // 检查copyset是否加载完成出现异常时的最大重试次数
     // 可能的异常：1.当前大多数副本还没起来；2.网络问题等导致无法获取leader
     // 3.其他的原因导致无法获取到leader的committed index
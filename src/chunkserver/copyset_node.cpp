@@ -50,6 +50,8 @@ namespace chunkserver {
 using curve::fs::FileSystemInfo;
 
 const char *kCurveConfEpochFilename = "conf.epoch";
+// 计算copyset hash时每次读取的数据大小
+const int kHashReadSize = 1024 * 1024;
 
 CopysetNode::CopysetNode(const LogicPoolID &logicPoolId,
                          const CopysetID &copysetId,
@@ -112,6 +114,22 @@ int CopysetNode::Init(const CopysetNodeOptions &options) {
     dsOptions.chunkSize = options.maxChunkSize;
     dsOptions.pageSize = options.pageSize;
     dsOptions.locationLimit = options.locationLimit;
+    dsOptions.loadPool = options.chunkLoader;
+    dsOptions.syncWrite = !options.enableChunkGroupCommit;
+    dsOptions.regionHashSize = options.chunkRegionHashSize;
+    dsOptions.discardPunchHole = options.discardPunchHole;
+    std::string metaIndexPath = copysetDirPath_ + "/"
+                              + kChunkMetaIndexFilename;
+    // 关闭metapage index时不再维护索引，需删除之前留下的索引文件，
+    // 否则再次开启时可能使用过期的索引
+    if (options.enableChunkMetaIndex) {
+        dsOptions.metaIndexPath = metaIndexPath;
+    } else if (fs_->FileExists(metaIndexPath)
+               && fs_->Delete(metaIndexPath) < 0) {
+        LOG(ERROR) << "Delete stale metapage index failed, path: "
+                   << metaIndexPath << ". Copyset: " << GroupIdString();
+        return -1;
+    }
     dataStore_ = std::make_shared<CSDataStore>(options.localFileSystem,
                                                options.chunkFilePool,
                                                dsOptions);
@@ -215,6 +233,11 @@ void CopysetNode::Fini() {
         // 迁移copyset时，copyset移除后再去执行WriteChunk操作可能出错
         concurrentapply_->Flush();
     }
+    if (nullptr != dataStore_) {
+        // 此时已经不会再有请求apply到datastore，保存metapage索引
+        // 以加快下次启动时的加载速度
+        dataStore_->SaveMetaIndex();
+    }
 }
 
 void CopysetNode::on_apply(::braft::Iterator &iter) {
@@ -238,12 +261,23 @@ void CopysetNode::on_apply(::braft::Iterator &iter) {
             CHECK(nullptr != chunkClosure)
                 << "ChunkClosure dynamic cast failed";
             std::shared_ptr<ChunkOpRequest> opRequest = chunkClosure->request_;
-            auto task = std::bind(&ChunkOpRequest::OnApply,
+            if (CHUNK_OP_TYPE::CHUNK_OP_DELETE_BATCH == opRequest->OpType()) {
+                auto task = std::bind(&ChunkOpRequest::OnApply,
+                                      opRequest,
+                                      iter.index(),
+                                      doneGuard.release());
+                ApplyBarrierTask(opRequest->ChunkIds(), task);
+                continue;
+            }
+            // 写请求在io完成之后才算apply完成，apply线程不需要等待
+            auto task = std::bind(&ChunkOpRequest::OnApplyAsync,
                                   opRequest,
                                   iter.index(),
-                                  doneGuard.release());
-            concurrentapply_->Push(
-                opRequest->ChunkId(), opRequest->OpType(), task);
+                                  doneGuard.release(),
+                                  std::placeholders::_1);
+            concurrentapply_->PushAsync(opRequest->ChunkId(),
+                                        opRequest->FileId(),
+                                        opRequest->OpType(), task);
         } else {
             // 获取log entry
             butil::IOBuf log = iter.data();
@@ -257,16 +291,40 @@ void CopysetNode::on_apply(::braft::Iterator &iter) {
             butil::IOBuf data;
             auto opReq = ChunkOpRequest::Decode(log, &request, &data);
             auto chunkId = request.chunkid();
-            auto task = std::bind(&ChunkOpRequest::OnApplyFromLog,
+            auto opType = request.optype();
+            auto fileId = request.fileid();
+            // 只有批量请求才会设置chunkids
+            std::vector<ChunkID> chunkIds(request.chunkids().begin(),
+                                          request.chunkids().end());
+            if (CHUNK_OP_TYPE::CHUNK_OP_DELETE_BATCH == opType) {
+                auto task = std::bind(&ChunkOpRequest::OnApplyFromLog,
+                                      opReq,
+                                      dataStore_,
+                                      std::move(request),
+                                      data);
+                ApplyBarrierTask(chunkIds, task);
+                continue;
+            }
+            auto task = std::bind(&ChunkOpRequest::OnApplyFromLogAsync,
                                   opReq,
                                   dataStore_,
                                   std::move(request),
-                                  data);
-            concurrentapply_->Push(chunkId, request.optype(), task);
+                                  data,
+                                  std::placeholders::_1);
+            concurrentapply_->PushAsync(chunkId, fileId, opType, task);
         }
     }
 }
 
+void CopysetNode::ApplyBarrierTask(const std::vector<ChunkID>& chunkIds,
+                                   const std::function<void()>& task) {
+    // 批量删除涉及多个chunk，不能按照单个chunk排队。apply线程池是整个
+    // chunkserver共用的，只等待这些chunk之前的请求apply完成，然后在当前
+    // 线程执行，这些chunk之后的请求也在它执行完之后才会apply
+    concurrentapply_->Flush(chunkIds);
+    task();
+}
+
 void CopysetNode::on_shutdown() {
     LOG(INFO) << GroupIdString() << " is shutdown";
 }
@@ -279,6 +337,14 @@ void CopysetNode::on_snapshot_save(::braft::SnapshotWriter *writer,
      * 1.flush I/O to disk，确保数据都落盘
      */
     concurrentapply_->Flush();
+    // chunk文件没有以O_DSYNC打开时，数据可能还在page cache中，
+    // 快照完成后raft会截断之前的日志，所以必须先将数据sync到磁盘
+    if (CSErrorCode::Success != dataStore_->SyncChunks()) {
+        done->status().set_error(EIO, "sync chunks failed");
+        LOG(ERROR) << "Sync chunks failed. "
+                   << "Copyset: " << GroupIdString();
+        return;
+    }
 
     /**
      * 2.保存配置版本: conf.epoch，注意conf.epoch是存放在data目录下
@@ -802,21 +868,22 @@ int CopysetNode::GetHash(std::string *hash) {
             return -1;
         }
 
+        // 分段读取文件计算crc，避免为整个文件分配内存
         len = fileInfo.st_size;
-        char *buff = new (std::nothrow) char[len];
+        int bufSize = std::min(len, kHashReadSize);
+        std::unique_ptr<char[]> buff(new (std::nothrow) char[bufSize]);
         if (nullptr == buff) {
             return -1;
         }
 
-        ret = fs_->Read(fd, buff, 0, len);
-        if (ret != len) {
-            delete[] buff;
-            return -1;
+        for (int offset = 0; offset < len; offset += bufSize) {
+            int readSize = std::min(len - offset, bufSize);
+            ret = fs_->Read(fd, buff.get(), offset, readSize);
+            if (ret != readSize) {
+                return -1;
+            }
+            crc32c = curve::common::CRC32(crc32c, buff.get(), readSize);
         }
-
-        crc32c = curve::common::CRC32(crc32c, buff, len);
-
-        delete[] buff;
     }
 
     *hash = std::to_string(crc32c);
@@ -28,6 +28,7 @@
 #include <string>
 #include <vector>
 #include <climits>
+#include <functional>
 #include <memory>
 
 #include "src/chunkserver/concurrent_apply/concurrent_apply.h"
@@ -386,6 +387,13 @@ class CopysetNode : public braft::StateMachine,
         return ToGroupIdString(logicPoolId_, copysetId_);
     }
 
+    /**
+     * 等待chunkIds之前的apply任务都完成后，在on_apply线程中执行task，
+     * 用于涉及多个chunk的请求
+     */
+    void ApplyBarrierTask(const std::vector<ChunkID>& chunkIds,
+                          const std::function<void()>& task);
+
  private:
     // 逻辑池 id
     LogicPoolID logicPoolId_;
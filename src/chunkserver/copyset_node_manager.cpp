@@ -55,6 +55,14 @@ int CopysetNodeManager::Init(const CopysetNodeOptions &copysetNodeOptions) {
     } else {
         copysetLoader_ = nullptr;
     }
+    // chunk文件加载线程池与copysetLoader_同时工作，由所有copyset共享，
+    // 不能直接复用copysetLoader_，否则copyset的加载任务等待chunk文件
+    // 加载任务时可能占满所有线程导致死锁
+    if (copysetNodeOptions_.loadChunkConcurrency > 0) {
+        copysetNodeOptions_.chunkLoader = std::make_shared<TaskThreadPool<>>();
+    } else {
+        copysetNodeOptions_.chunkLoader = nullptr;
+    }
     return 0;
 }
 
@@ -74,6 +82,15 @@ int CopysetNodeManager::Run() {
             return -1;
         }
     }
+    if (copysetNodeOptions_.chunkLoader != nullptr) {
+        ret = copysetNodeOptions_.chunkLoader->Start(
+            copysetNodeOptions_.loadChunkConcurrency);
+        if (ret < 0) {
+            LOG(ERROR) << "Chunk loader start error. ThreadNum: "
+                       << copysetNodeOptions_.loadChunkConcurrency;
+            return -1;
+        }
+    }
 
     // 启动加载已有的copyset
     ret = ReloadCopysets();
@@ -105,6 +122,13 @@ int CopysetNodeManager::Fini() {
     WriteLockGuard writeLockGuard(rwLock_);
     copysetNodeMap_.clear();
 
+    // copyset安装快照时也会通过该线程池重新加载chunk文件，
+    // 所以需要在所有copyset停止后再关闭
+    if (copysetNodeOptions_.chunkLoader != nullptr) {
+        copysetNodeOptions_.chunkLoader->Stop();
+        copysetNodeOptions_.chunkLoader = nullptr;
+    }
+
     return 0;
 }
 
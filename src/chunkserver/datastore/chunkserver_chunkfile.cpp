@@ -30,6 +30,17 @@
 namespace curve {
 namespace chunkserver {
 
+// The size of each read when computing the hash of a chunk
+const size_t kHashReadSize = 1024 * 1024;
+
+namespace {
+
+inline uint64_t toNanoSeconds(const struct timespec& ts) {
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+}  // namespace
+
 ChunkFileMetaPage::ChunkFileMetaPage(const ChunkFileMetaPage& metaPage) {
     version = metaPage.version;
     sn = metaPage.sn;
@@ -41,6 +52,13 @@ ChunkFileMetaPage::ChunkFileMetaPage(const ChunkFileMetaPage& metaPage) {
     } else {
         bitmap = nullptr;
     }
+    if (metaPage.regionHash != nullptr) {
+        regionHash = std::make_shared<ChunkRegionHash>(*metaPage.regionHash);
+    } else {
+        regionHash = nullptr;
+    }
+    inode = metaPage.inode;
+    ctime = metaPage.ctime;
 }
 
 ChunkFileMetaPage& ChunkFileMetaPage::operator =(
@@ -57,6 +75,13 @@ ChunkFileMetaPage& ChunkFileMetaPage::operator =(
     } else {
         bitmap = nullptr;
     }
+    if (metaPage.regionHash != nullptr) {
+        regionHash = std::make_shared<ChunkRegionHash>(*metaPage.regionHash);
+    } else {
+        regionHash = nullptr;
+    }
+    inode = metaPage.inode;
+    ctime = metaPage.ctime;
     return *this;
 }
 
@@ -141,7 +166,11 @@ CSChunkFile::CSChunkFile(std::shared_ptr<LocalFileSystem> lfs,
       snapshot_(nullptr),
       chunkFilePool_(chunkFilePool),
       lfs_(lfs),
-      metric_(options.metric) {
+      metric_(options.metric),
+      syncWrite_(options.syncWrite),
+      discardPunchHole_(options.discardPunchHole),
+      unsyncedBytes_(0),
+      inflightWrites_(0) {
     CHECK(!baseDir_.empty()) << "Create chunk file failed";
     CHECK(lfs_ != nullptr) << "Create chunk file failed";
     metaPage_.sn = options.sn;
@@ -153,6 +182,19 @@ CSChunkFile::CSChunkFile(std::shared_ptr<LocalFileSystem> lfs,
         uint32_t bits = size_ / pageSize_;
         metaPage_.bitmap = std::make_shared<Bitmap>(bits);
     }
+    uint32_t regionSize = options.regionHashSize;
+    if (regionSize > 0) {
+        if (regionSize % pageSize_ == 0 && size_ % regionSize == 0) {
+            regionHash_ = std::make_shared<ChunkRegionHash>(
+                regionSize, size_ / regionSize);
+        } else {
+            LOG(WARNING) << "Invalid region hash size, region hash disabled."
+                         << " ChunkID: " << chunkId_
+                         << ", region size: " << regionSize
+                         << ", chunk size: " << size_
+                         << ", page size: " << pageSize_;
+        }
+    }
     if (metric_ != nullptr) {
         metric_->chunkFileCount << 1;
     }
@@ -170,6 +212,7 @@ CSChunkFile::~CSChunkFile() {
 
     if (metric_ != nullptr) {
         metric_->chunkFileCount << -1;
+        metric_->unsyncedBytes << -unsyncedBytes_.load();
         if (isCloneChunk_) {
             metric_->cloneChunkCount << -1;
         }
@@ -201,39 +244,50 @@ CSErrorCode CSChunkFile::Open(bool createFile) {
             return CSErrorCode::InternalError;
         }
     }
-    int rc = lfs_->Open(chunkFilePath, O_RDWR|O_NOATIME|O_DSYNC);
-    if (rc < 0) {
-        LOG(ERROR) << "Error occured when opening file."
-                   << " filepath = " << chunkFilePath;
-        return CSErrorCode::InternalError;
+    CSErrorCode errCode = openFile();
+    if (errCode != CSErrorCode::Success) {
+        return errCode;
     }
-    fd_ = rc;
+
+    errCode = loadMetaPage();
+    // After restarting, only after reopening and loading the metapage,
+    // can we know whether it is a clone chunk
+    checkCloneChunk();
+    return errCode;
+}
+
+CSErrorCode CSChunkFile::Open(const ChunkFileMetaPage& metaPage) {
+    WriteLockGuard writeGuard(rwLock_);
     struct stat fileInfo;
-    rc = lfs_->Fstat(fd_, &fileInfo);
-    if (rc < 0) {
-        LOG(ERROR) << "Error occured when stating file."
-                   << " filepath = " << chunkFilePath;
-        return CSErrorCode::InternalError;
+    CSErrorCode errCode = openFile(&fileInfo);
+    if (errCode != CSErrorCode::Success) {
+        return errCode;
     }
 
-    if (fileInfo.st_size != fileSize()) {
-        LOG(ERROR) << "Wrong file size."
-                   << " filepath = " << chunkFilePath
-                   << ", real filesize = " << fileInfo.st_size
-                   << ", expect filesize = " << fileSize();
-        return CSErrorCode::FileFormatError;
+    // Any write to the chunk file after the index was saved changes the
+    // ctime, even if it is written by a version which does not maintain
+    // the index, so the recorded metapage can not be trusted then
+    if (metaPage.inode != fileInfo.st_ino
+        || metaPage.ctime != toNanoSeconds(fileInfo.st_ctim)) {
+        LOG(WARNING) << "Chunk file modified after metapage index saved,"
+                     << " load metapage from chunk file."
+                     << " ChunkID: " << chunkId_;
+        errCode = loadMetaPage();
+        checkCloneChunk();
+        return errCode;
     }
 
-    CSErrorCode errCode = loadMetaPage();
-    // After restarting, only after reopening and loading the metapage,
-    // can we know whether it is a clone chunk
-    if (!metaPage_.location.empty() && !isCloneChunk_) {
-        if (metric_ != nullptr) {
-            metric_->cloneChunkCount << 1;
-        }
-        isCloneChunk_ = true;
+    metaPage_ = metaPage;
+    // The region hash recorded in the index is kept by regionHash_,
+    // it is adopted only if the region size is not changed
+    metaPage_.regionHash = nullptr;
+    if (regionHash_ != nullptr && metaPage.regionHash != nullptr
+        && metaPage.regionHash->regionSize == regionHash_->regionSize
+        && metaPage.regionHash->crcs.size() == regionHash_->crcs.size()) {
+        *regionHash_ = *metaPage.regionHash;
     }
-    return errCode;
+    checkCloneChunk();
+    return CSErrorCode::Success;
 }
 
 CSErrorCode CSChunkFile::LoadSnapshot(SequenceNum sn) {
@@ -275,6 +329,7 @@ CSErrorCode CSChunkFile::Write(SequenceNum sn,
                                size_t length,
                                uint32_t* cost) {
     WriteLockGuard writeGuard(rwLock_);
+    waitInflightWrites();
     if (!CheckOffsetAndLength(offset, length)) {
         LOG(ERROR) << "Write chunk failed, invalid offset or length."
                    << "ChunkID: " << chunkId_
@@ -387,8 +442,62 @@ CSErrorCode CSChunkFile::Write(SequenceNum sn,
     return CSErrorCode::Success;
 }
 
+void CSChunkFile::WriteAsync(SequenceNum sn,
+                             const butil::IOBuf& buf,
+                             off_t offset,
+                             size_t length,
+                             CSWriteCallback done) {
+    bool plainWrite = false;
+    {
+        WriteLockGuard writeGuard(rwLock_);
+        waitInflightWrites();
+        // The write can not be rejected or change the metapage, otherwise
+        // it is left to Write
+        plainWrite = CheckOffsetAndLength(offset, length)
+                     && !isCloneChunk_
+                     && sn == metaPage_.sn
+                     && sn >= metaPage_.correctedSn
+                     && !needCreateSnapshot(sn)
+                     && !needCow(sn);
+        if (plainWrite) {
+            std::lock_guard<std::mutex> lk(inflightMtx_);
+            ++inflightWrites_;
+        }
+    }
+    if (!plainWrite) {
+        uint32_t cost;
+        done(Write(sn, buf, offset, length, &cost));
+        return;
+    }
+
+    // fd_ is only closed when the chunk file is destroyed, the caller
+    // keeps the chunk file until done is called
+    lfs_->WriteAsync(fd_, buf, offset + pageSize_, length,
+        [this, sn, offset, length, done](int rc) {
+            CSErrorCode errorCode = CSErrorCode::Success;
+            if (rc < 0) {
+                LOG(ERROR) << "Write data to chunk file failed."
+                           << "ChunkID: " << chunkId_
+                           << ",request sn: " << sn
+                           << ",offset: " << offset
+                           << ",length: " << length;
+                errorCode = CSErrorCode::InternalError;
+            } else {
+                addUnsyncedBytes(length);
+                invalidateRegionHash(offset, length);
+            }
+            {
+                std::lock_guard<std::mutex> lk(inflightMtx_);
+                --inflightWrites_;
+            }
+            inflightCond_.notify_all();
+            done(errorCode);
+        });
+}
+
 CSErrorCode CSChunkFile::Paste(const char * buf, off_t offset, size_t length) {
     WriteLockGuard writeGuard(rwLock_);
+    waitInflightWrites();
     if (!CheckOffsetAndLength(offset, length)) {
         LOG(ERROR) << "Paste chunk failed, invalid offset or length."
                    << "ChunkID: " << chunkId_
@@ -445,6 +554,53 @@ CSErrorCode CSChunkFile::Paste(const char * buf, off_t offset, size_t length) {
 
 CSErrorCode CSChunkFile::Read(char * buf, off_t offset, size_t length) {
     ReadLockGuard readGuard(rwLock_);
+    waitInflightWrites();
+    CSErrorCode errorCode = checkReadable(offset, length);
+    if (errorCode != CSErrorCode::Success) {
+        return errorCode;
+    }
+
+    int rc = readData(buf, offset, length);
+    if (rc < 0) {
+        LOG(ERROR) << "Read chunk file failed."
+                   << "ChunkID: " << chunkId_
+                   << ",chunk sn: " << metaPage_.sn;
+        return CSErrorCode::InternalError;
+    }
+    return CSErrorCode::Success;
+}
+
+CSErrorCode CSChunkFile::Read(butil::IOBuf* buf,
+                              off_t offset,
+                              size_t length) {
+    ReadLockGuard readGuard(rwLock_);
+    waitInflightWrites();
+    CSErrorCode errorCode = checkReadable(offset, length);
+    if (errorCode != CSErrorCode::Success) {
+        return errorCode;
+    }
+
+    int rc = readData(buf, offset, length);
+    if (rc < 0) {
+        LOG(ERROR) << "Read chunk file failed."
+                   << "ChunkID: " << chunkId_
+                   << ",chunk sn: " << metaPage_.sn;
+        return CSErrorCode::InternalError;
+    }
+    // 读到文件末尾时补0，与char*接口一样返回请求长度的数据，
+    // 避免response的attachment比请求的长度短
+    if (static_cast<size_t>(rc) < length) {
+        LOG(WARNING) << "Read chunk file returns less than expected."
+                     << "ChunkID: " << chunkId_
+                     << ", offset: " << offset
+                     << ", length: " << length
+                     << ", return: " << rc;
+        buf->resize(buf->size() + length - rc);
+    }
+    return CSErrorCode::Success;
+}
+
+CSErrorCode CSChunkFile::checkReadable(off_t offset, size_t length) {
     if (!CheckOffsetAndLength(offset, length)) {
         LOG(ERROR) << "Read chunk failed, invalid offset or length."
                    << "ChunkID: " << chunkId_
@@ -472,14 +628,6 @@ CSErrorCode CSChunkFile::Read(char * buf, off_t offset, size_t length) {
             return CSErrorCode::PageNerverWrittenError;
         }
     }
-
-    int rc = readData(buf, offset, length);
-    if (rc < 0) {
-        LOG(ERROR) << "Read chunk file failed."
-                   << "ChunkID: " << chunkId_
-                   << ",chunk sn: " << metaPage_.sn;
-        return CSErrorCode::InternalError;
-    }
     return CSErrorCode::Success;
 }
 
@@ -488,6 +636,7 @@ CSErrorCode CSChunkFile::ReadSpecifiedChunk(SequenceNum sn,
                                             off_t offset,
                                             size_t length)  {
     ReadLockGuard readGuard(rwLock_);
+    waitInflightWrites();
     if (!CheckOffsetAndLength(offset, length)) {
         LOG(ERROR) << "Read specified chunk failed, invalid offset or length."
                    << "ChunkID: " << chunkId_
@@ -561,7 +710,26 @@ CSErrorCode CSChunkFile::ReadSpecifiedChunk(SequenceNum sn,
 }
 
 CSErrorCode CSChunkFile::Delete(SequenceNum sn)  {
+    string recyclePath;
+    CSErrorCode errorCode = Delete(sn, &recyclePath);
+    if (errorCode != CSErrorCode::Success) {
+        return errorCode;
+    }
+
+    int ret = chunkFilePool_->RecycleFile(recyclePath);
+    if (ret < 0)
+        return CSErrorCode::InternalError;
+
+    LOG(INFO) << "Chunk deleted."
+              << "ChunkID: " << chunkId_
+              << ", request sn: " << sn
+              << ", chunk sn: " << metaPage_.sn;
+    return CSErrorCode::Success;
+}
+
+CSErrorCode CSChunkFile::Delete(SequenceNum sn, string* recyclePath)  {
     WriteLockGuard writeGuard(rwLock_);
+    waitInflightWrites();
     // If sn is less than the current sequence of the chunk, can not be deleted
     if (sn < metaPage_.sn) {
         LOG(WARNING) << "Delete chunk failed, backward request."
@@ -593,19 +761,83 @@ CSErrorCode CSChunkFile::Delete(SequenceNum sn)  {
         lfs_->Close(fd_);
         fd_ = -1;
     }
-    int ret = chunkFilePool_->RecycleFile(path());
-    if (ret < 0)
-        return CSErrorCode::InternalError;
+    *recyclePath = path();
+    return CSErrorCode::Success;
+}
 
-    LOG(INFO) << "Chunk deleted."
-              << "ChunkID: " << chunkId_
-              << ", request sn: " << sn
-              << ", chunk sn: " << metaPage_.sn;
+CSErrorCode CSChunkFile::Discard(SequenceNum sn,
+                                 off_t offset,
+                                 size_t length) {
+    WriteLockGuard writeGuard(rwLock_);
+    waitInflightWrites();
+    if (!CheckOffsetAndLength(offset, length)) {
+        LOG(ERROR) << "Discard chunk failed, invalid offset or length."
+                   << "ChunkID: " << chunkId_
+                   << ", offset: " << offset
+                   << ", length: " << length
+                   << ", page size: " << pageSize_
+                   << ", chunk size: " << size_;
+        return CSErrorCode::InvalidArgError;
+    }
+    if (sn < metaPage_.sn || sn < metaPage_.correctedSn) {
+        LOG(WARNING) << "Backward discard request."
+                     << "ChunkID: " << chunkId_
+                     << ",request sn: " << sn
+                     << ",chunk sn: " << metaPage_.sn
+                     << ",correctedSn: " << metaPage_.correctedSn;
+        return CSErrorCode::BackwardRequestError;
+    }
+    if (needKeepData(sn)) {
+        DVLOG(9) << "Discard skipped."
+                 << "ChunkID: " << chunkId_
+                 << ",request sn: " << sn
+                 << ",chunk sn: " << metaPage_.sn;
+        return CSErrorCode::DiscardSkippedError;
+    }
+
+    // Punching a hole releases the blocks, and the later writes to the
+    // range have to allocate them again, which undoes the preallocation
+    // of the chunk file pool. Zeroing the range keeps the blocks.
+    int mode = discardPunchHole_ ? FALLOC_FL_PUNCH_HOLE : FALLOC_FL_ZERO_RANGE;
+    int rc = lfs_->Fallocate(fd_,
+                             mode | FALLOC_FL_KEEP_SIZE,
+                             offset + pageSize_,
+                             length);
+    if (rc == -EOPNOTSUPP && !discardPunchHole_) {
+        // the file system does not support FALLOC_FL_ZERO_RANGE
+        std::unique_ptr<char[]> zeroBuf(new char[length]);
+        memset(zeroBuf.get(), 0, length);
+        rc = lfs_->Write(fd_, zeroBuf.get(), offset + pageSize_, length);
+    }
+    if (rc < 0) {
+        LOG(ERROR) << "Discard range in chunk file failed."
+                   << "ChunkID: " << chunkId_
+                   << ", offset: " << offset
+                   << ", length: " << length
+                   << ", punch hole: " << discardPunchHole_;
+        return CSErrorCode::InternalError;
+    }
+    invalidateRegionHash(offset, length);
+    // O_DSYNC does not cover fallocate, the hole is persisted by the
+    // next sync if the chunk is not opened with syncWrite
+    if (syncWrite_) {
+        return syncFile();
+    }
+    addUnsyncedBytes(length);
     return CSErrorCode::Success;
 }
 
+bool CSChunkFile::CanDiscard(SequenceNum sn) {
+    ReadLockGuard readGuard(rwLock_);
+    if (sn < metaPage_.sn || sn < metaPage_.correctedSn) {
+        return false;
+    }
+    return !needKeepData(sn);
+}
+
 CSErrorCode CSChunkFile::DeleteSnapshotOrCorrectSn(SequenceNum correctedSn)  {
     WriteLockGuard writeGuard(rwLock_);
+    waitInflightWrites();
 
     // If it is a clone chunk, theoretically this interface should not be called
     if (isCloneChunk_) {
@@ -710,30 +942,123 @@ CSErrorCode CSChunkFile::GetHash(off_t offset,
                                  size_t length,
                                  std::string* hash)  {
     ReadLockGuard readGuard(rwLock_);
+    waitInflightWrites();
+    uint32_t crc32c = 0;
+    CSErrorCode errorCode = hashData(offset, length, true, &crc32c);
+    if (errorCode != CSErrorCode::Success) {
+        return errorCode;
+    }
+    *hash = std::to_string(crc32c);
+    return CSErrorCode::Success;
+}
+
+CSErrorCode CSChunkFile::GetDataHash(off_t offset,
+                                     size_t length,
+                                     std::string* hash)  {
+    ReadLockGuard readGuard(rwLock_);
+    waitInflightWrites();
     uint32_t crc32c = 0;
+    CSErrorCode errorCode = hashData(offset, length, false, &crc32c);
+    if (errorCode != CSErrorCode::Success) {
+        return errorCode;
+    }
+    *hash = std::to_string(crc32c);
+    return CSErrorCode::Success;
+}
 
-    char *buf = new(std::nothrow) char[length];
-    if (nullptr == buf) {
-        return CSErrorCode::InternalError;
+CSErrorCode CSChunkFile::GetRegionHash(uint32_t* regionSize,
+                                       std::vector<uint32_t>* crcs) {
+    if (regionHash_ == nullptr) {
+        return CSErrorCode::InvalidArgError;
     }
 
-    int rc = lfs_->Read(fd_, buf, offset, length);
+    ReadLockGuard readGuard(rwLock_);
+    waitInflightWrites();
+    std::lock_guard<std::mutex> lock(regionHashMtx_);
+    Bitmap& valid = regionHash_->valid;
+    uint32_t size = regionHash_->regionSize;
+    for (uint32_t i = valid.NextClearBit(0);
+         i != Bitmap::NO_POS;
+         i = valid.NextClearBit(i + 1)) {
+        CSErrorCode errorCode =
+            hashData(static_cast<off_t>(i) * size, size, false,
+                     &regionHash_->crcs[i]);
+        if (errorCode != CSErrorCode::Success) {
+            return errorCode;
+        }
+        valid.Set(i);
+    }
+    *regionSize = size;
+    *crcs = regionHash_->crcs;
+    return CSErrorCode::Success;
+}
+
+std::shared_ptr<ChunkRegionHash> CSChunkFile::GetCachedRegionHash() {
+    if (regionHash_ == nullptr) {
+        return nullptr;
+    }
+    ReadLockGuard readGuard(rwLock_);
+    waitInflightWrites();
+    std::lock_guard<std::mutex> lock(regionHashMtx_);
+    return std::make_shared<ChunkRegionHash>(*regionHash_);
+}
+
+CSErrorCode CSChunkFile::GetFileStamp(uint64_t* inode, uint64_t* ctime) {
+    ReadLockGuard readGuard(rwLock_);
+    struct stat fileInfo;
+    int rc = lfs_->Fstat(fd_, &fileInfo);
     if (rc < 0) {
-        LOG(ERROR) << "Read chunk file failed."
-                   << "ChunkID: " << chunkId_
-                   << ",chunk sn: " << metaPage_.sn;
-        delete[] buf;
+        LOG(ERROR) << "Error occured when stating file."
+                   << " ChunkID: " << chunkId_;
         return CSErrorCode::InternalError;
     }
+    *inode = fileInfo.st_ino;
+    *ctime = toNanoSeconds(fileInfo.st_ctim);
+    return CSErrorCode::Success;
+}
 
-    crc32c = curve::common::CRC32(crc32c, buf, length);
-    *hash = std::to_string(crc32c);
-
-    delete[] buf;
+CSErrorCode CSChunkFile::hashData(off_t offset,
+                                  size_t length,
+                                  bool fileOffset,
+                                  uint32_t* crc) {
+    // Read the range in fixed-size blocks and extend the crc block by block,
+    // so hashing a whole chunk does not allocate a chunk-sized buffer
+    size_t bufSize = std::min(length, kHashReadSize);
+    std::unique_ptr<char[]> buf(new(std::nothrow) char[bufSize]);
+    if (nullptr == buf) {
+        return CSErrorCode::InternalError;
+    }
 
+    uint32_t crc32c = 0;
+    size_t hashed = 0;
+    while (hashed < length) {
+        size_t readSize = std::min(length - hashed, bufSize);
+        int rc = fileOffset
+                 ? lfs_->Read(fd_, buf.get(), offset + hashed, readSize)
+                 : readData(buf.get(), offset + hashed, readSize);
+        if (rc < 0) {
+            LOG(ERROR) << "Read chunk file failed."
+                       << "ChunkID: " << chunkId_
+                       << ",chunk sn: " << metaPage_.sn;
+            return CSErrorCode::InternalError;
+        }
+        crc32c = curve::common::CRC32(crc32c, buf.get(), readSize);
+        hashed += readSize;
+    }
+    *crc = crc32c;
     return CSErrorCode::Success;
 }
 
+void CSChunkFile::invalidateRegionHash(off_t offset, size_t length) {
+    if (regionHash_ == nullptr || length == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(regionHashMtx_);
+    uint32_t beginIndex = offset / regionHash_->regionSize;
+    uint32_t endIndex = (offset + length - 1) / regionHash_->regionSize;
+    regionHash_->valid.Clear(beginIndex, endIndex);
+}
+
 bool CSChunkFile::needCreateSnapshot(SequenceNum sn) {
     // The maximum value of correctSn_ and sn_ can represent
     // the true sequence number of the chunk file
@@ -769,6 +1094,16 @@ bool CSChunkFile::needCreateSnapshot(SequenceNum sn) {
     return true;
 }
 
+bool CSChunkFile::needKeepData(SequenceNum sn) {
+    // The pages of clone chunk not written yet are read from the source
+    if (isCloneChunk_) {
+        return true;
+    }
+    // The snapshot still needs the data of the chunk, or the next write
+    // will take a snapshot of the chunk
+    return snapshot_ != nullptr || needCreateSnapshot(sn);
+}
+
 bool CSChunkFile::needCow(SequenceNum sn) {
     SequenceNum chunkSn = std::max(metaPage_.correctedSn, metaPage_.sn);
     // Requests smaller than chunkSn will be rejected directly
@@ -818,9 +1153,99 @@ CSErrorCode CSChunkFile::updateMetaPage(ChunkFileMetaPage* metaPage) {
                    << ",chunk sn: " << metaPage_.sn;
         return CSErrorCode::InternalError;
     }
+    // The sn and the bitmap in metapage decide how the replayed raft log
+    // is applied after restart, so they must be durable before the request
+    // returns. Syncing the file also persists the data written before,
+    // so the bitmap never points to pages whose data is lost.
+    if (!syncWrite_) {
+        return syncFile();
+    }
+    return CSErrorCode::Success;
+}
+
+CSErrorCode CSChunkFile::Sync() {
+    ReadLockGuard readGuard(rwLock_);
+    waitInflightWrites();
+    if (fd_ < 0 || unsyncedBytes_.load() == 0) {
+        return CSErrorCode::Success;
+    }
+    return syncFile();
+}
+
+CSErrorCode CSChunkFile::syncFile() {
+    uint64_t unsynced = unsyncedBytes_.exchange(0);
+    int rc = lfs_->Fsync(fd_);
+    if (rc < 0) {
+        LOG(ERROR) << "Sync chunk file failed."
+                   << "ChunkID: " << chunkId_
+                   << ",chunk sn: " << metaPage_.sn;
+        unsyncedBytes_.fetch_add(unsynced);
+        return CSErrorCode::InternalError;
+    }
+    if (metric_ != nullptr) {
+        metric_->unsyncedBytes << -unsynced;
+    }
     return CSErrorCode::Success;
 }
 
+void CSChunkFile::waitInflightWrites() {
+    std::unique_lock<std::mutex> lk(inflightMtx_);
+    inflightCond_.wait(lk, [this] { return inflightWrites_ == 0; });
+}
+
+void CSChunkFile::addUnsyncedBytes(size_t length) {
+    if (syncWrite_) {
+        return;
+    }
+    unsyncedBytes_.fetch_add(length);
+    if (metric_ != nullptr) {
+        metric_->unsyncedBytes << length;
+    }
+}
+
+CSErrorCode CSChunkFile::openFile(struct stat* fileInfo) {
+    string chunkFilePath = path();
+    int flags = O_RDWR|O_NOATIME;
+    if (syncWrite_) {
+        flags |= O_DSYNC;
+    }
+    int rc = lfs_->Open(chunkFilePath, flags);
+    if (rc < 0) {
+        LOG(ERROR) << "Error occured when opening file."
+                   << " filepath = " << chunkFilePath;
+        return CSErrorCode::InternalError;
+    }
+    fd_ = rc;
+    struct stat info;
+    rc = lfs_->Fstat(fd_, &info);
+    if (rc < 0) {
+        LOG(ERROR) << "Error occured when stating file."
+                   << " filepath = " << chunkFilePath;
+        return CSErrorCode::InternalError;
+    }
+
+    if (info.st_size != fileSize()) {
+        LOG(ERROR) << "Wrong file size."
+                   << " filepath = " << chunkFilePath
+                   << ", real filesize = " << info.st_size
+                   << ", expect filesize = " << fileSize();
+        return CSErrorCode::FileFormatError;
+    }
+    if (fileInfo != nullptr) {
+        *fileInfo = info;
+    }
+    return CSErrorCode::Success;
+}
+
+void CSChunkFile::checkCloneChunk() {
+    if (!metaPage_.location.empty() && !isCloneChunk_) {
+        if (metric_ != nullptr) {
+            metric_->cloneChunkCount << 1;
+        }
+        isCloneChunk_ = true;
+    }
+}
+
 CSErrorCode CSChunkFile::loadMetaPage() {
     char buf[pageSize_];  // NOLINT
     memset(buf, 0, sizeof(buf));
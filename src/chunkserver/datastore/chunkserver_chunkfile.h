@@ -28,8 +28,10 @@
 #include <vector>
 #include <set>
 #include <atomic>
+#include <condition_variable>  // NOLINT
 #include <functional>
 #include <memory>
+#include <mutex>  // NOLINT
 
 #include "include/curve_compiler_specific.h"
 #include "include/chunkserver/chunkserver_common.h"
@@ -54,6 +56,9 @@ class FilePool;
 class CSSnapshot;
 struct DataStoreMetric;
 
+// Called with the result when an asynchronous write finishes
+using CSWriteCallback = std::function<void(CSErrorCode)>;
+
 /**
  * Chunkfile Metapage Format
  * version: 1 byte
@@ -62,6 +67,28 @@ struct DataStoreMetric;
  * crc: 4 bytes
  * padding: 4075 bytes
  */
+/**
+ * The crc32c of every fixed-size region of the chunk data.
+ * A write only invalidates the regions it touches, and the invalid regions
+ * are recomputed when the region hash is requested, so comparing replicas
+ * only re-reads the regions written since the last comparison.
+ * It is not a part of the metapage in the chunk file, it is only persisted
+ * in the metapage index.
+ */
+struct ChunkRegionHash {
+    // The size of each region
+    uint32_t regionSize;
+    // The crc32c of each region, only meaningful if the region is valid
+    std::vector<uint32_t> crcs;
+    // Whether the crc of each region is up to date
+    Bitmap valid;
+
+    ChunkRegionHash(uint32_t regionSize, uint32_t regions)
+        : regionSize(regionSize)
+        , crcs(regions, 0)
+        , valid(regions) {}
+};
+
 struct ChunkFileMetaPage {
     // File format version
     uint8_t version;
@@ -75,12 +102,23 @@ struct ChunkFileMetaPage {
     // Indicates the state of the page in the current Chunk,
     // if it is not CloneChunk, it is nullptr
     std::shared_ptr<Bitmap> bitmap;
+    // The region hash of the chunk, it is not encoded into the metapage,
+    // only the metapage index records it. nullptr if not recorded
+    std::shared_ptr<ChunkRegionHash> regionHash;
+    // The inode number and the ctime(in nanoseconds) of the chunk file when
+    // the metapage is recorded, they are not encoded into the metapage,
+    // only the metapage index records them to detect stale entries
+    uint64_t inode;
+    uint64_t ctime;
 
     ChunkFileMetaPage() : version(FORMAT_VERSION)
                         , sn(0)
                         , correctedSn(0)
                         , location("")
-                        , bitmap(nullptr) {}
+                        , bitmap(nullptr)
+                        , regionHash(nullptr)
+                        , inode(0)
+                        , ctime(0) {}
     ChunkFileMetaPage(const ChunkFileMetaPage& metaPage);
     ChunkFileMetaPage& operator = (const ChunkFileMetaPage& metaPage);
 
@@ -107,6 +145,18 @@ struct ChunkOptions {
     PageSizeType    pageSize;
     // datastore internal statistical metric
     std::shared_ptr<DataStoreMetric> metric;
+    // If true, the chunk file is opened with O_DSYNC and every write is
+    // durable when it returns; otherwise the writes stay in the page cache
+    // until Sync is called
+    bool            syncWrite;
+    // The size of the region whose crc is cached for GetRegionHash,
+    // must be a multiple of pageSize and divide chunkSize,
+    // 0 means the region hash is disabled
+    uint32_t        regionHashSize;
+    // If true, the blocks of a discarded range are released by punching
+    // a hole; otherwise the range is zeroed and the blocks preallocated
+    // by the chunk file pool are kept
+    bool            discardPunchHole;
 
     ChunkOptions() : id(0)
                    , sn(0)
@@ -115,7 +165,10 @@ struct ChunkOptions {
                    , location("")
                    , chunkSize(0)
                    , pageSize(0)
-                   , metric(nullptr) {}
+                   , metric(nullptr)
+                   , syncWrite(true)
+                   , regionHashSize(0)
+                   , discardPunchHole(false) {}
 };
 
 class CSChunkFile {
@@ -135,6 +188,18 @@ class CSChunkFile {
      * @return returns the error code
      */
     CSErrorCode Open(bool createFile);
+    /**
+     * Open an existing chunk file with the metapage recorded in the
+     * metapage index, the metapage is not read from the chunk file.
+     * If the inode or the ctime of the chunk file differs from the one
+     * recorded, the file has been modified after the index was saved,
+     * the metapage is read from the chunk file instead
+     * Normally, there is no concurrency, mutually exclusive with other
+     * operations, add write lock
+     * @param metaPage: the metapage of the chunk file
+     * @return returns the error code
+     */
+    CSErrorCode Open(const ChunkFileMetaPage& metaPage);
     /**
      * Called when a snapshot file is found during Datastore initialization
      * Load the metapage of the snapshot file into the memory inside the
@@ -164,6 +229,27 @@ class CSChunkFile {
                       off_t offset,
                       size_t length,
                       uint32_t* cost);
+    /**
+     * Write chunk files asynchronously
+     * Only the overwrite of a non-clone chunk that needs neither snapshot,
+     * cow nor metapage update is submitted to the local file system
+     * asynchronously, and done is called when the data is written, maybe
+     * in another thread. The other writes are executed by Write and done is
+     * called before returning.
+     * Same as Write, there is no concurrent write on the same chunk, the
+     * next write is issued after done is called. The other operations on
+     * the chunk wait until the asynchronous write finishes.
+     * @param sn: The file sequence number of the current write request
+     * @param buf: data requested to be written
+     * @param offset: The offset position of the request to write
+     * @param length: The length of the data requested to be written
+     * @param done: called with the error code when the write finishes
+     */
+    void WriteAsync(SequenceNum sn,
+                    const butil::IOBuf& buf,
+                    off_t offset,
+                    size_t length,
+                    CSWriteCallback done);
     /**
      * Write the copied data into Chunk
      * Only write areas that have not been written, and will not overwrite
@@ -184,6 +270,17 @@ class CSChunkFile {
      * @return: return error code
      */
     CSErrorCode Read(char * buf, off_t offset, size_t length);
+    /**
+     * Read chunk files into IOBuf
+     * The data is read directly into the blocks of IOBuf through preadv,
+     * no extra buffer is allocated
+     * There may be concurrency, add read lock
+     * @param buf: the data read will be appended to buf
+     * @param offset: the starting offset of the data requested to be read
+     * @param length: The length of the data requested to be read
+     * @return: return error code
+     */
+    CSErrorCode Read(butil::IOBuf* buf, off_t offset, size_t length);
     /**
      * Read the chunk of the specified Sequence
      * There may be concurrency, add read lock
@@ -206,6 +303,39 @@ class CSChunkFile {
      * @return: return error code
      */
     CSErrorCode Delete(SequenceNum sn);
+    /**
+     * Delete chunk files without recycling the chunk file, the path of
+     * the chunk file is returned so that the caller can recycle the files
+     * of many chunks to the chunkfile pool in bulk.
+     * The chunk file can not be used after it returns successfully.
+     * @param sn: The file sequence number when calling the DeleteChunks
+     *            interface
+     * @param recyclePath: the path of the chunk file to be recycled
+     * @return: return error code
+     */
+    CSErrorCode Delete(SequenceNum sn, string* recyclePath);
+    /**
+     * Discard the data in the range, the range reads as zero afterwards.
+     * The blocks of the range are released by punching a hole if
+     * discardPunchHole is set, otherwise they are zeroed in place, so the
+     * preallocation of the chunk file pool is not undone.
+     * The data of a clone chunk may still be read from the clone source,
+     * and the data of a chunk with snapshot may still be copied to the
+     * snapshot, so the discard is skipped in these cases.
+     * Mutually exclusive with other operations, add write lock.
+     * @param sn: The file sequence number when the request is issued
+     * @param offset: the offset of the range, must be page aligned
+     * @param length: the length of the range, must be page aligned
+     * @return: return error code, DiscardSkippedError if the data is kept
+     */
+    CSErrorCode Discard(SequenceNum sn, off_t offset, size_t length);
+    /**
+     * Determine whether the whole chunk can be recycled for the discard
+     * request, that is the discard would not be ignored.
+     * @param sn: The file sequence number when the request is issued
+     * @return: true means the chunk file can be recycled
+     */
+    bool CanDiscard(SequenceNum sn);
     /**
      * Delete snapshots generated during this dump or left over from history.
      * If no snapshot is generated during the dump, modify the correctedSn of
@@ -226,13 +356,67 @@ class CSChunkFile {
      */
     void GetInfo(CSChunkInfo* info);
     /**
-     * Get the hash value of the chunk, this interface is used for test
+     * Get the crc32c of the range [offset, offset + length) of the chunk
+     * file, the offset starts from the metapage, used by consistency check.
+     * Keep it unchanged so that chunkservers of different versions return
+     * the same hash
      * @param[out]: chunk hash value
      * @return: error code
      */
     CSErrorCode GetHash(off_t offset,
                         size_t length,
                         std::string *hash);
+    /**
+     * Get the crc32c of the range [offset, offset + length) of the chunk
+     * data, the metapage is not included, used by scrub
+     * @param[out]: chunk hash value
+     * @return: error code
+     */
+    CSErrorCode GetDataHash(off_t offset,
+                            size_t length,
+                            std::string *hash);
+    /**
+     * Get the crc32c of every region of the chunk data, only the regions
+     * written since they were hashed last time are read from the chunk file.
+     * The crc of the whole region is computed even if only part of it has
+     * been written, the same as GetDataHash on the region.
+     * There may be concurrency, add read lock
+     * @param regionSize[out]: the size of each region
+     * @param crcs[out]: the crc32c of each region
+     * @return: return error code, InvalidArgError if the region hash is
+     *          disabled
+     */
+    CSErrorCode GetRegionHash(uint32_t* regionSize,
+                              std::vector<uint32_t>* crcs);
+    /**
+     * Get a copy of the region hash without reading the chunk file,
+     * the regions not hashed yet are left invalid, used by the metapage index
+     * @return: nullptr if the region hash is disabled
+     */
+    std::shared_ptr<ChunkRegionHash> GetCachedRegionHash();
+    /**
+     * Get the inode number and the ctime(in nanoseconds) of the chunk file,
+     * used by the metapage index to detect the modification of the file
+     * There may be concurrency, add read lock
+     * @param inode[out]: the inode number of the chunk file
+     * @param ctime[out]: the ctime of the chunk file
+     * @return: return error code
+     */
+    CSErrorCode GetFileStamp(uint64_t* inode, uint64_t* ctime);
+    /**
+     * Flush the data written since the last sync to disk.
+     * Only makes sense when the chunk is not opened with syncWrite,
+     * otherwise there are never unsynced bytes and it returns directly.
+     * There may be concurrency, add read lock
+     * @return: return error code
+     */
+    CSErrorCode Sync();
+    /**
+     * Get the number of bytes written but not yet synced to disk
+     */
+    uint64_t GetUnsyncedBytes() {
+        return unsyncedBytes_.load(std::memory_order_relaxed);
+    }
 
  private:
     /**
@@ -248,6 +432,13 @@ class CSChunkFile {
      * @return: true means cow is required; false means cow is not required
      */
     bool needCow(SequenceNum sn);
+    /**
+     * Determine whether the data of the chunk must be kept for discard
+     * Should be called with lock held
+     * @param sn: discard request sequence number
+     * @return: true means the data can not be discarded
+     */
+    bool needKeepData(SequenceNum sn);
     /**
      * Persist metapage
      * @param metaPage: the metapage that needs to be persisted to disk,
@@ -256,10 +447,25 @@ class CSChunkFile {
      * If it fails, it will not be changed
      */
     CSErrorCode updateMetaPage(ChunkFileMetaPage* metaPage);
+    /**
+     * Open the chunk file and check the size of the file
+     * @param fileInfo[out]: the stat of the chunk file if not nullptr
+     */
+    CSErrorCode openFile(struct stat* fileInfo = nullptr);
     /**
      * Load metapage into memory
      */
     CSErrorCode loadMetaPage();
+    /**
+     * Mark the chunk as clone chunk if the location is not empty
+     */
+    void checkCloneChunk();
+    /**
+     * Check whether the read request is valid, and for clone chunk,
+     * whether the pages requested have all been written
+     * Should be called with read lock held
+     */
+    CSErrorCode checkReadable(off_t offset, size_t length);
     /**
      * Copy the uncopied data in the specified area from the chunk file
      * to the snapshot file
@@ -274,6 +480,34 @@ class CSChunkFile {
      * to a normal chunk
      */
     CSErrorCode flush();
+    /**
+     * Fsync the chunk file and reset the unsynced bytes
+     * Should be called with lock held
+     */
+    CSErrorCode syncFile();
+    /**
+     * Account the bytes just written which are not durable yet
+     */
+    void addUnsyncedBytes(size_t length);
+    /**
+     * Wait until the asynchronous write of the chunk finishes
+     * Should be called with lock held, so that no new write is submitted
+     */
+    void waitInflightWrites();
+    /**
+     * Compute the crc32c of the chunk data in [offset, offset + length),
+     * the offset is relative to the chunk file if fileOffset is true
+     * Should be called with lock held
+     */
+    CSErrorCode hashData(off_t offset,
+                         size_t length,
+                         bool fileOffset,
+                         uint32_t* crc);
+    /**
+     * Mark the regions overlapping with the range as invalid
+     * Should be called with write lock held
+     */
+    void invalidateRegionHash(off_t offset, size_t length);
 
     inline string path() {
         return baseDir_ + "/" +
@@ -288,6 +522,10 @@ class CSChunkFile {
         return lfs_->Read(fd_, buf, 0, pageSize_);
     }
 
+    inline int readData(butil::IOBuf* buf, off_t offset, size_t length) {
+        return lfs_->ReadToIOBuf(fd_, buf, offset + pageSize_, length);
+    }
+
     inline int writeMetaPage(const char* buf) {
         return lfs_->Write(fd_, buf, 0, pageSize_);
     }
@@ -301,6 +539,8 @@ class CSChunkFile {
         if (rc < 0) {
             return rc;
         }
+        addUnsyncedBytes(length);
+        invalidateRegionHash(offset, length);
         // If it is a clone chunk, you need to determine whether you need to
         // change the bitmap and update the metapage
         if (isCloneChunk_) {
@@ -321,6 +561,8 @@ class CSChunkFile {
         if (rc < 0) {
             return rc;
         }
+        addUnsyncedBytes(length);
+        invalidateRegionHash(offset, length);
         // If it is a clone chunk, you need to determine whether you need to
         // change the bitmap and update the metapage
         if (isCloneChunk_) {
@@ -383,6 +625,21 @@ class CSChunkFile {
     std::shared_ptr<LocalFileSystem> lfs_;
     // datastore internal statistical indicators
     std::shared_ptr<DataStoreMetric> metric_;
+    // Whether the chunk file is opened with O_DSYNC
+    bool syncWrite_;
+    // Whether to punch a hole or zero the range for the discard
+    bool discardPunchHole_;
+    // The number of bytes written to the page cache but not synced yet
+    std::atomic<uint64_t> unsyncedBytes_;
+    // The crc of each region of the chunk, nullptr if it is disabled
+    std::shared_ptr<ChunkRegionHash> regionHash_;
+    // Protect regionHash_ from the concurrent GetRegionHash
+    std::mutex regionHashMtx_;
+    // The number of asynchronous writes not finished yet, the completion
+    // does not take rwLock_, so the waiters can hold it
+    uint32_t inflightWrites_;
+    std::mutex inflightMtx_;
+    std::condition_variable inflightCond_;
 };
 }  // namespace chunkserver
 }  // namespace curve
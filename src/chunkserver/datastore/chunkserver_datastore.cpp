@@ -22,6 +22,8 @@
 
 #include <gflags/gflags.h>
 #include <fcntl.h>
+#include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <iostream>
 #include <list>
@@ -30,10 +32,22 @@
 #include "src/chunkserver/datastore/chunkserver_datastore.h"
 #include "src/chunkserver/datastore/filename_operator.h"
 #include "src/common/location_operator.h"
+#include "src/common/concurrent/count_down_event.h"
 
 namespace curve {
 namespace chunkserver {
 
+using curve::common::CountDownEvent;
+
+// Number of chunk files loaded by a single task of the load pool
+const size_t kLoadChunkBatchSize = 256;
+
+// Progress of loading chunk files when the chunkserver starts
+static bvar::Adder<uint64_t> g_load_chunk_file_total(
+    "chunkserver_load_chunk_file_total");
+static bvar::Adder<uint64_t> g_load_chunk_file_finished(
+    "chunkserver_load_chunk_file_finished");
+
 CSDataStore::CSDataStore(std::shared_ptr<LocalFileSystem> lfs,
                          std::shared_ptr<FilePool> chunkFilePool,
                          const DataStoreOptions& options)
@@ -41,11 +55,19 @@ CSDataStore::CSDataStore(std::shared_ptr<LocalFileSystem> lfs,
       pageSize_(options.pageSize),
       baseDir_(options.baseDir),
       locationLimit_(options.locationLimit),
+      syncWrite_(options.syncWrite),
+      regionHashSize_(options.regionHashSize),
+      discardPunchHole_(options.discardPunchHole),
       chunkFilePool_(chunkFilePool),
-      lfs_(lfs) {
+      lfs_(lfs),
+      loadPool_(options.loadPool) {
     CHECK(!baseDir_.empty()) << "Create datastore failed";
     CHECK(lfs_ != nullptr) << "Create datastore failed";
     CHECK(chunkFilePool_ != nullptr) << "Create datastore failed";
+    if (!options.metaIndexPath.empty()) {
+        metaIndex_ = std::make_shared<CSMetaIndex>(lfs_,
+                                                   options.metaIndexPath);
+    }
 }
 
 CSDataStore::~CSDataStore() {
@@ -71,43 +93,76 @@ bool CSDataStore::Initialize() {
     // If loaded before, reload here
     metaCache_.Clear();
     metric_ = std::make_shared<DataStoreMetric>();
+    // Scan all the file names first, the chunk files are loaded in batches
+    // before the snapshot files, so that the metapages of chunk files can
+    // be read concurrently
+    vector<ChunkID> chunkIds;
+    vector<size_t> snapshotIndexes;
     for (size_t i = 0; i < files.size(); ++i) {
         FileNameOperator::FileInfo info =
             FileNameOperator::ParseFileName(files[i]);
         if (info.type == FileNameOperator::FileType::CHUNK) {
-            // If the chunk file has not been loaded yet, load it to metaCache
-            CSErrorCode errorCode = loadChunkFile(info.id);
-            if (errorCode != CSErrorCode::Success) {
-                LOG(ERROR) << "Load chunk file failed: " << files[i];
-                return false;
-            }
+            chunkIds.push_back(info.id);
         } else if (info.type == FileNameOperator::FileType::SNAPSHOT) {
-            string chunkFilePath = baseDir_ + "/" +
-                        FileNameOperator::GenerateChunkFileName(info.id);
-
-            // If the chunk file does not exist, print the log
-            if (!lfs_->FileExists(chunkFilePath)) {
-                LOG(WARNING) << "Can't find snapshot "
-                             << files[i] << "' chunk.";
-                continue;
-            }
-            // If the chunk file exists, load the chunk file to metaCache first
-            CSErrorCode errorCode = loadChunkFile(info.id);
-            if (errorCode != CSErrorCode::Success) {
-                LOG(ERROR) << "Load chunk file failed.";
-                return false;
-            }
-
-            // Load snapshot to memory
-            errorCode = metaCache_.Get(info.id)->LoadSnapshot(info.sn);
-            if (errorCode != CSErrorCode::Success) {
-                LOG(ERROR) << "Load snapshot failed.";
-                return false;
-            }
+            snapshotIndexes.push_back(i);
         } else {
             LOG(WARNING) << "Unknown file: " << files[i];
         }
     }
+
+    // The metapage index is used only if it records exactly the chunk files
+    // in the directory, otherwise all metapages are read from chunk files
+    MetaPageMap metaPages;
+    bool useMetaIndex = false;
+    if (metaIndex_ != nullptr) {
+        useMetaIndex = metaIndex_->Load(&metaPages)
+                       && metaPages.size() == chunkIds.size();
+        for (size_t i = 0; useMetaIndex && i < chunkIds.size(); ++i) {
+            useMetaIndex = (metaPages.find(chunkIds[i]) != metaPages.end());
+        }
+        LOG(INFO) << "Load chunk files of " << baseDir_
+                  << (useMetaIndex ? " with" : " without")
+                  << " metapage index.";
+        // The index will be stale once the chunk files are modified,
+        // so remove it before the datastore is used
+        if (metaIndex_->Invalidate() != CSErrorCode::Success) {
+            LOG(ERROR) << "Invalidate metapage index failed.";
+            return false;
+        }
+    }
+
+    g_load_chunk_file_total << chunkIds.size();
+    if (!loadChunkFiles(chunkIds, useMetaIndex ? &metaPages : nullptr)) {
+        LOG(ERROR) << "Load chunk files failed.";
+        return false;
+    }
+
+    for (size_t i : snapshotIndexes) {
+        FileNameOperator::FileInfo info =
+            FileNameOperator::ParseFileName(files[i]);
+        string chunkFilePath = baseDir_ + "/" +
+                    FileNameOperator::GenerateChunkFileName(info.id);
+
+        // If the chunk file does not exist, print the log
+        if (!lfs_->FileExists(chunkFilePath)) {
+            LOG(WARNING) << "Can't find snapshot "
+                         << files[i] << "' chunk.";
+            continue;
+        }
+        // If the chunk file exists, load the chunk file to metaCache first
+        CSErrorCode errorCode = loadChunkFile(info.id);
+        if (errorCode != CSErrorCode::Success) {
+            LOG(ERROR) << "Load chunk file failed.";
+            return false;
+        }
+
+        // Load snapshot to memory
+        errorCode = metaCache_.Get(info.id)->LoadSnapshot(info.sn);
+        if (errorCode != CSErrorCode::Success) {
+            LOG(ERROR) << "Load snapshot failed.";
+            return false;
+        }
+    }
     LOG(INFO) << "Initialize data store success.";
     return true;
 }
@@ -126,6 +181,64 @@ CSErrorCode CSDataStore::DeleteChunk(ChunkID id, SequenceNum sn) {
     return CSErrorCode::Success;
 }
 
+CSErrorCode CSDataStore::DeleteChunks(const std::vector<ChunkID>& ids,
+                                      SequenceNum sn) {
+    CSErrorCode result = CSErrorCode::Success;
+    std::vector<string> recyclePaths;
+    recyclePaths.reserve(ids.size());
+    for (auto id : ids) {
+        auto chunkFile = metaCache_.Get(id);
+        if (chunkFile == nullptr) {
+            continue;
+        }
+        string recyclePath;
+        CSErrorCode errorCode = chunkFile->Delete(sn, &recyclePath);
+        if (errorCode != CSErrorCode::Success) {
+            LOG(WARNING) << "Delete chunk file failed."
+                         << "ChunkID = " << id;
+            if (result == CSErrorCode::Success) {
+                result = errorCode;
+            }
+            continue;
+        }
+        metaCache_.Remove(id);
+        recyclePaths.push_back(recyclePath);
+    }
+
+    if (!recyclePaths.empty() &&
+        chunkFilePool_->RecycleFiles(recyclePaths) < 0) {
+        return CSErrorCode::InternalError;
+    }
+    LOG(INFO) << "Chunks deleted, count = " << recyclePaths.size()
+              << ", request count = " << ids.size()
+              << ", request sn: " << sn;
+    return result;
+}
+
+CSErrorCode CSDataStore::DiscardChunk(ChunkID id,
+                                      SequenceNum sn,
+                                      off_t offset,
+                                      size_t length) {
+    auto chunkFile = metaCache_.Get(id);
+    if (chunkFile == nullptr) {
+        return CSErrorCode::Success;
+    }
+    // The operations of the same chunk are applied one by one, so the chunk
+    // can not be changed between CanDiscard and DeleteChunk
+    if (offset == 0 && length == chunkSize_ && chunkFile->CanDiscard(sn)) {
+        return DeleteChunk(id, sn);
+    }
+    CSErrorCode errorCode = chunkFile->Discard(sn, offset, length);
+    if (errorCode != CSErrorCode::Success
+        && errorCode != CSErrorCode::DiscardSkippedError) {
+        LOG(WARNING) << "Discard chunk file failed."
+                     << "ChunkID = " << id
+                     << ", offset = " << offset
+                     << ", length = " << length;
+    }
+    return errorCode;
+}
+
 CSErrorCode CSDataStore::DeleteSnapshotChunkOrCorrectSn(
     ChunkID id, SequenceNum correctedSn) {
     auto chunkFile = metaCache_.Get(id);
@@ -160,6 +273,25 @@ CSErrorCode CSDataStore::ReadChunk(ChunkID id,
     return CSErrorCode::Success;
 }
 
+CSErrorCode CSDataStore::ReadChunkToIOBuf(ChunkID id,
+                                          SequenceNum sn,
+                                          butil::IOBuf* buf,
+                                          off_t offset,
+                                          size_t length) {
+    auto chunkFile = metaCache_.Get(id);
+    if (chunkFile == nullptr) {
+        return CSErrorCode::ChunkNotExistError;
+    }
+
+    CSErrorCode errorCode = chunkFile->Read(buf, offset, length);
+    if (errorCode != CSErrorCode::Success) {
+        LOG(WARNING) << "Read chunk file failed."
+                     << "ChunkID = " << id;
+        return errorCode;
+    }
+    return CSErrorCode::Success;
+}
+
 CSErrorCode CSDataStore::ReadSnapshotChunk(ChunkID id,
                                            SequenceNum sn,
                                            char * buf,
@@ -233,6 +365,9 @@ CSErrorCode CSDataStore::WriteChunk(ChunkID id,
         options.location = cloneSourceLocation;
         options.pageSize = pageSize_;
         options.metric = metric_;
+        options.syncWrite = syncWrite_;
+        options.regionHashSize = regionHashSize_;
+        options.discardPunchHole = discardPunchHole_;
         CSErrorCode errorCode = CreateChunkFile(options, &chunkFile);
         if (errorCode != CSErrorCode::Success) {
             return errorCode;
@@ -252,6 +387,33 @@ CSErrorCode CSDataStore::WriteChunk(ChunkID id,
     return CSErrorCode::Success;
 }
 
+void CSDataStore::WriteChunkAsync(ChunkID id,
+                                  SequenceNum sn,
+                                  const butil::IOBuf& buf,
+                                  off_t offset,
+                                  size_t length,
+                                  const std::string& cloneSourceLocation,
+                                  CSWriteCallback done) {
+    auto chunkFile = metaCache_.Get(id);
+    // Creating the chunk file is synchronous, the same as WriteChunk
+    if (sn == kInvalidSeq || chunkFile == nullptr) {
+        uint32_t cost;
+        done(WriteChunk(id, sn, buf, offset, length, &cost,
+                        cloneSourceLocation));
+        return;
+    }
+    // The chunk file is held by the callback, so that it will not be
+    // destroyed by a concurrent delete before the write finishes
+    chunkFile->WriteAsync(sn, buf, offset, length,
+        [id, chunkFile, done](CSErrorCode errorCode) {
+            if (errorCode != CSErrorCode::Success) {
+                LOG(WARNING) << "Write chunk file failed."
+                             << "ChunkID = " << id;
+            }
+            done(errorCode);
+        });
+}
+
 CSErrorCode CSDataStore::CreateCloneChunk(ChunkID id,
                                           SequenceNum sn,
                                           SequenceNum correctedSn,
@@ -281,6 +443,9 @@ CSErrorCode CSDataStore::CreateCloneChunk(ChunkID id,
         options.chunkSize = chunkSize_;
         options.pageSize = pageSize_;
         options.metric = metric_;
+        options.syncWrite = syncWrite_;
+        options.regionHashSize = regionHashSize_;
+        options.discardPunchHole = discardPunchHole_;
         CSErrorCode errorCode = CreateChunkFile(options, &chunkFile);
         if (errorCode != CSErrorCode::Success) {
             return errorCode;
@@ -355,15 +520,146 @@ CSErrorCode CSDataStore::GetChunkHash(ChunkID id,
     return chunkFile->GetHash(offset, length, hash);
 }
 
+CSErrorCode CSDataStore::GetChunkDataHash(ChunkID id,
+                                          off_t offset,
+                                          size_t length,
+                                          std::string* hash) {
+    auto chunkFile = metaCache_.Get(id);
+    if (chunkFile == nullptr) {
+        LOG(INFO) << "Get ChunkDataHash failed, Chunk not exists."
+                  << "ChunkID = " << id;
+        return CSErrorCode::ChunkNotExistError;
+    }
+    return chunkFile->GetDataHash(offset, length, hash);
+}
+
+CSErrorCode CSDataStore::GetChunkRegionHash(ChunkID id,
+                                            uint32_t* regionSize,
+                                            std::vector<uint32_t>* crcs) {
+    auto chunkFile = metaCache_.Get(id);
+    if (chunkFile == nullptr) {
+        LOG(INFO) << "Get chunk region hash failed, Chunk not exists."
+                  << "ChunkID = " << id;
+        return CSErrorCode::ChunkNotExistError;
+    }
+    return chunkFile->GetRegionHash(regionSize, crcs);
+}
+
+void CSDataStore::ListChunks(std::vector<ChunkID>* ids) {
+    ChunkMap chunkMap = metaCache_.GetMap();
+    ids->clear();
+    ids->reserve(chunkMap.size());
+    for (const auto& item : chunkMap) {
+        ids->push_back(item.first);
+    }
+    std::sort(ids->begin(), ids->end());
+}
+
 DataStoreStatus CSDataStore::GetStatus() {
     DataStoreStatus status;
     status.chunkFileCount = metric_->chunkFileCount.get_value();
     status.cloneChunkCount = metric_->cloneChunkCount.get_value();
     status.snapshotCount = metric_->snapshotCount.get_value();
+    status.unsyncedBytes = metric_->unsyncedBytes.get_value();
     return status;
 }
 
-CSErrorCode CSDataStore::loadChunkFile(ChunkID id) {
+CSErrorCode CSDataStore::SyncChunks() {
+    if (syncWrite_) {
+        return CSErrorCode::Success;
+    }
+
+    ChunkMap chunkMap = metaCache_.GetMap();
+    for (const auto& item : chunkMap) {
+        CSErrorCode errorCode = item.second->Sync();
+        if (errorCode != CSErrorCode::Success) {
+            LOG(ERROR) << "Sync chunk file failed."
+                       << " ChunkID: " << item.first
+                       << ", baseDir: " << baseDir_;
+            return errorCode;
+        }
+    }
+    return CSErrorCode::Success;
+}
+
+CSErrorCode CSDataStore::SaveMetaIndex() {
+    if (metaIndex_ == nullptr) {
+        return CSErrorCode::Success;
+    }
+
+    MetaPageMap metaPages;
+    ChunkMap chunkMap = metaCache_.GetMap();
+    for (const auto& item : chunkMap) {
+        CSChunkInfo info;
+        item.second->GetInfo(&info);
+        ChunkFileMetaPage& metaPage = metaPages[item.first];
+        metaPage.sn = info.curSn;
+        metaPage.correctedSn = info.correctedSn;
+        metaPage.location = info.location;
+        metaPage.bitmap = info.bitmap;
+        metaPage.regionHash = item.second->GetCachedRegionHash();
+        CSErrorCode errorCode =
+            item.second->GetFileStamp(&metaPage.inode, &metaPage.ctime);
+        if (errorCode != CSErrorCode::Success) {
+            LOG(ERROR) << "Get chunk file stamp failed, skip saving index."
+                       << " ChunkID: " << item.first
+                       << ", baseDir: " << baseDir_;
+            return errorCode;
+        }
+    }
+    CSErrorCode errorCode = metaIndex_->Save(metaPages);
+    if (errorCode != CSErrorCode::Success) {
+        LOG(ERROR) << "Save metapage index failed."
+                   << " baseDir: " << baseDir_;
+        return errorCode;
+    }
+    LOG(INFO) << "Save metapage index success, chunk count: "
+              << metaPages.size() << ", baseDir: " << baseDir_;
+    return CSErrorCode::Success;
+}
+
+bool CSDataStore::loadChunkFiles(const vector<ChunkID>& ids,
+                                 const MetaPageMap* metaPages) {
+    if (loadPool_ == nullptr || ids.size() <= kLoadChunkBatchSize) {
+        return loadChunkFileBatch(ids, metaPages, 0, ids.size());
+    }
+
+    std::atomic<bool> success(true);
+    CountDownEvent event(
+        (ids.size() + kLoadChunkBatchSize - 1) / kLoadChunkBatchSize);
+    for (size_t begin = 0; begin < ids.size(); begin += kLoadChunkBatchSize) {
+        size_t end = std::min(begin + kLoadChunkBatchSize, ids.size());
+        loadPool_->Enqueue([&, begin, end]() {
+            // No need to load the remaining batches if any batch failed
+            if (success.load(std::memory_order_acquire)
+                && !loadChunkFileBatch(ids, metaPages, begin, end)) {
+                success.store(false, std::memory_order_release);
+            }
+            event.Signal();
+        });
+    }
+    event.Wait();
+    return success.load(std::memory_order_acquire);
+}
+
+bool CSDataStore::loadChunkFileBatch(const vector<ChunkID>& ids,
+                                     const MetaPageMap* metaPages,
+                                     size_t begin,
+                                     size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        CSErrorCode errorCode = loadChunkFile(ids[i], metaPages);
+        if (errorCode != CSErrorCode::Success) {
+            LOG(ERROR) << "Load chunk file failed: "
+                       << FileNameOperator::GenerateChunkFileName(ids[i]);
+            return false;
+        }
+        g_load_chunk_file_finished << 1;
+    }
+    return true;
+}
+
+CSErrorCode CSDataStore::loadChunkFile(ChunkID id,
+                                       const MetaPageMap* metaPages) {
     // If the chunk file has not been loaded yet, load it into metaCache
     if (metaCache_.Get(id) == nullptr) {
         ChunkOptions options;
@@ -373,11 +669,27 @@ CSErrorCode CSDataStore::loadChunkFile(ChunkID id) {
         options.chunkSize = chunkSize_;
         options.pageSize = pageSize_;
         options.metric = metric_;
+        options.syncWrite = syncWrite_;
+        options.regionHashSize = regionHashSize_;
+        options.discardPunchHole = discardPunchHole_;
         CSChunkFilePtr chunkFilePtr =
             std::make_shared<CSChunkFile>(lfs_,
                                           chunkFilePool_,
                                           options);
-        CSErrorCode errorCode = chunkFilePtr->Open(false);
+        const ChunkFileMetaPage* metaPage = nullptr;
+        if (metaPages != nullptr) {
+            auto iter = metaPages->find(id);
+            // The bitmap of clone chunk should match the chunk size,
+            // otherwise read the metapage from the chunk file
+            if (iter != metaPages->end()
+                && (iter->second.bitmap == nullptr
+                    || iter->second.bitmap->Size() == chunkSize_ / pageSize_)) {
+                metaPage = &iter->second;
+            }
+        }
+        CSErrorCode errorCode = metaPage != nullptr
+                                ? chunkFilePtr->Open(*metaPage)
+                                : chunkFilePtr->Open(false);
         if (errorCode != CSErrorCode::Success)
             return errorCode;
         metaCache_.Set(id, chunkFilePtr);
@@ -35,8 +35,10 @@
 #include "include/chunkserver/chunkserver_common.h"
 #include "src/common/concurrent/rw_lock.h"
 #include "src/common/concurrent/concurrent.h"
+#include "src/common/concurrent/task_thread_pool.h"
 #include "src/chunkserver/datastore/define.h"
 #include "src/chunkserver/datastore/chunkserver_chunkfile.h"
+#include "src/chunkserver/datastore/chunkserver_metaindex.h"
 #include "src/chunkserver/datastore/file_pool.h"
 #include "src/fs/local_filesystem.h"
 
@@ -44,6 +46,7 @@ namespace curve {
 namespace chunkserver {
 using curve::fs::LocalFileSystem;
 using ::curve::common::Atomic;
+using ::curve::common::TaskThreadPool;
 using CSChunkFilePtr = std::shared_ptr<CSChunkFile>;
 
 inline void TrivialDeleter(void* ptr) {}
@@ -53,12 +56,35 @@ inline void TrivialDeleter(void* ptr) {}
  * baseDir: Directory path managed by DataStore
  * chunkSize: The size of the chunk file or snapshot file in the DataStore
  * pageSize: the size of the smallest read-write unit
+ * loadPool: thread pool used to load chunk files concurrently when
+ *           initializing, chunk files are loaded serially if it is nullptr
+ * metaIndexPath: path of the metapage index, the metapage index is not
+ *                used if it is empty
+ * regionHashSize: the size of the region whose crc is cached by each
+ *                 chunk file, 0 means the region hash is disabled
+ * discardPunchHole: whether a discarded range of a chunk file is released
+ *                   by punching a hole or zeroed in place
  */
 struct DataStoreOptions {
     std::string                         baseDir;
     ChunkSizeType                       chunkSize;
     PageSizeType                        pageSize;
     uint32_t                            locationLimit;
+    std::shared_ptr<TaskThreadPool<>>   loadPool;
+    std::string                         metaIndexPath;
+    // whether chunk files are opened with O_DSYNC, if false the written
+    // data is persisted in batches by SyncChunks
+    bool                                syncWrite;
+    uint32_t                            regionHashSize;
+    bool                                discardPunchHole;
+
+    DataStoreOptions() : chunkSize(0)
+                       , pageSize(0)
+                       , locationLimit(0)
+                       , loadPool(nullptr)
+                       , syncWrite(true)
+                       , regionHashSize(0)
+                       , discardPunchHole(false) {}
 };
 
 /**
@@ -66,14 +92,17 @@ struct DataStoreOptions {
  * chunkFileCount: the number of chunks in the DataStore
  * snapshotCount: the number of snapshots in the DataStore
  * cloneChunkCount: the number of clone chunks
+ * unsyncedBytes: the bytes written to chunk files but not synced to disk
  */
 struct DataStoreStatus {
     uint32_t chunkFileCount;
     uint32_t snapshotCount;
     uint32_t cloneChunkCount;
+    uint64_t unsyncedBytes;
     DataStoreStatus() : chunkFileCount(0)
                     , snapshotCount(0)
-                    , cloneChunkCount(0) {}
+                    , cloneChunkCount(0)
+                    , unsyncedBytes(0) {}
 };
 
 /**
@@ -81,11 +110,13 @@ struct DataStoreStatus {
  * chunkFileCount: the number of chunks in the DataStore
  * snapshotCount: the number of snapshots in the DataStore
  * cloneChunkCount: the number of clone chunks
+ * unsyncedBytes: the bytes written to chunk files but not synced to disk
  */
 struct DataStoreMetric {
     bvar::Adder<uint32_t> chunkFileCount;
     bvar::Adder<uint32_t> snapshotCount;
     bvar::Adder<uint32_t> cloneChunkCount;
+    bvar::Adder<uint64_t> unsyncedBytes;
 };
 using DataStoreMetricPtr = std::shared_ptr<DataStoreMetric>;
 
@@ -160,6 +191,31 @@ class CSDataStore {
      * @return: return error code
      */
     virtual CSErrorCode DeleteChunk(ChunkID id, SequenceNum sn);
+    /**
+     * Delete many chunks of the copyset together, the chunk files are
+     * recycled to the chunkfile pool in bulk.
+     * A chunk that can not be deleted does not stop the others.
+     * @param ids: the ids of the chunks to be deleted
+     * @param sn: the sequence number of the file when the request is issued
+     * @return: return the error code of the first chunk failed
+     */
+    virtual CSErrorCode DeleteChunks(const std::vector<ChunkID>& ids,
+                                     SequenceNum sn);
+    /**
+     * Discard the data of the chunk in the range
+     * If the whole chunk is discarded, the chunk file is recycled,
+     * otherwise the blocks of the range are released by punching a hole.
+     * @param id: the id of the chunk to be discarded
+     * @param sn: the sequence number of the file when the request is issued
+     * @param offset: the offset of the range
+     * @param length: the length of the range
+     * @return: return error code, DiscardSkippedError if the data of the
+     *          chunk is kept for the clone source or the snapshot
+     */
+    virtual CSErrorCode DiscardChunk(ChunkID id,
+                                     SequenceNum sn,
+                                     off_t offset,
+                                     size_t length);
     /**
      * Delete snapshots generated during this dump or before
      * If no snapshot is generated during the dump, modify the correctedSn
@@ -187,6 +243,23 @@ class CSDataStore {
                                   char * buf,
                                   off_t offset,
                                   size_t length);
+    /**
+     * Read the contents of the current chunk into IOBuf
+     * The data is read directly into the pooled blocks of IOBuf, so there
+     * is no heap allocation or memcpy for each request
+     * @param id: the chunk id to be read
+     * @param sn: used to record trace, not used in actual logic processing,
+     *             indicating the sequence number of the current user file
+     * @param buf: the data read will be appended to buf
+     * @param offset: the logical offset of the data requested to be read in the chunk
+     * @param length: the length of the data requested to be read
+     * @return: return error code
+     */
+    virtual CSErrorCode ReadChunkToIOBuf(ChunkID id,
+                                         SequenceNum sn,
+                                         butil::IOBuf* buf,
+                                         off_t offset,
+                                         size_t length);
     /**
      * Read the data of the specified sequence, it may read the current
      * chunk file, or it may read the snapshot file
@@ -223,6 +296,31 @@ class CSDataStore {
                                 uint32_t* cost,
                                 const std::string & cloneSourceLocation = "");
 
+    /**
+     * Write data asynchronously, done is called with the error code when
+     * the data is written, maybe in the io completion thread.
+     * The plain overwrite of an existing chunk is submitted asynchronously,
+     * the other writes are executed like WriteChunk and done is called
+     * before returning. The next operation on the same chunk should be
+     * issued after done is called.
+     * @param id: the chunk id to be written
+     * @param sn: The sequence number of the user file when the current
+     *            write request is issued
+     * @param buf: the content of the data to be written
+     * @param offset: the offset address requested to write
+     * @param length: the length of the data requested to be written
+     * @param cloneSourceLocation: indicates the address of the clone from
+     *                             curvefs
+     * @param done: called with the error code when the write finishes
+     */
+    virtual void WriteChunkAsync(ChunkID id,
+                                 SequenceNum sn,
+                                 const butil::IOBuf& buf,
+                                 off_t offset,
+                                 size_t length,
+                                 const std::string& cloneSourceLocation,
+                                 CSWriteCallback done);
+
     // Deprecated, only use for unit & integration test
     virtual CSErrorCode WriteChunk(
         ChunkID id, SequenceNum sn, const char* buf, off_t offset,
@@ -276,7 +374,8 @@ class CSDataStore {
                                      CSChunkInfo* chunkInfo);
 
     /**
-     * Get the hash value of Chunk
+     * Get the hash value of Chunk, the offset is relative to the chunk file
+     * and includes the metapage
      * @param id[in]: chunk id
      * @param hash[out]: chunk hash value
      * @return: return error code
@@ -285,14 +384,80 @@ class CSDataStore {
                                      off_t offset,
                                      size_t length,
                                      std::string* hash);
+    /**
+     * Get the hash value of the chunk data, the offset is relative to the
+     * chunk data and the metapage is not included
+     * @param id[in]: chunk id
+     * @param hash[out]: chunk hash value
+     * @return: return error code
+     */
+    virtual CSErrorCode GetChunkDataHash(ChunkID id,
+                                         off_t offset,
+                                         size_t length,
+                                         std::string* hash);
+    /**
+     * Get the crc32c of every region of the chunk, the regions not written
+     * since the last call are not read again
+     * @param id: the id of the chunk
+     * @param regionSize[out]: the size of each region
+     * @param crcs[out]: the crc32c of each region
+     * @return: return error code, InvalidArgError if the region hash is
+     *          disabled
+     */
+    virtual CSErrorCode GetChunkRegionHash(ChunkID id,
+                                           uint32_t* regionSize,
+                                           std::vector<uint32_t>* crcs);
+    /**
+     * Get the ids of all chunks in the datastore
+     * @param ids[out]: chunk ids, in ascending order
+     */
+    virtual void ListChunks(std::vector<ChunkID>* ids);
     /**
      * Get internal statistics of DataStore
      * @return: internal statistics of datastore
      */
     virtual DataStoreStatus GetStatus();
+    /**
+     * Save the metapages of all chunk files to the metapage index,
+     * so that the metapages need not be read from chunk files when
+     * initializing next time
+     * Should be called when no more requests will be applied to the datastore
+     * @return: return error code
+     */
+    virtual CSErrorCode SaveMetaIndex();
+    /**
+     * Sync the data written to all chunk files to disk
+     * Only useful when syncWrite is disabled, the raft log before the
+     * sync point can be truncated only after this succeeds
+     * @return: return error code
+     */
+    virtual CSErrorCode SyncChunks();
 
  private:
-    CSErrorCode loadChunkFile(ChunkID id);
+    /**
+     * Load the chunk file into metaCache
+     * @param id: id of the chunk file
+     * @param metaPages: metapages loaded from the metapage index, if the
+     *                   chunk is found in it, the metapage will not be read
+     *                   from the chunk file, may be nullptr
+     * @return: return error code
+     */
+    CSErrorCode loadChunkFile(ChunkID id,
+                              const MetaPageMap* metaPages = nullptr);
+    /**
+     * Load the chunk files in batches, if loadPool_ is set, batches are
+     * loaded concurrently by the threads of the pool
+     * @param ids: ids of the chunk files to be loaded
+     * @param metaPages: metapages loaded from the metapage index,
+     *                   may be nullptr
+     * @return: return true if all chunk files are loaded successfully
+     */
+    bool loadChunkFiles(const vector<ChunkID>& ids,
+                        const MetaPageMap* metaPages);
+    bool loadChunkFileBatch(const vector<ChunkID>& ids,
+                            const MetaPageMap* metaPages,
+                            size_t begin,
+                            size_t end);
     CSErrorCode CreateChunkFile(const ChunkOptions & ops,
                                 CSChunkFilePtr* chunkFile);
 
@@ -303,6 +468,12 @@ class CSDataStore {
     PageSizeType pageSize_;
     // clone chunk location length limit
     uint32_t locationLimit_;
+    // whether chunk files are opened with O_DSYNC
+    bool syncWrite_;
+    // the size of the region whose crc is cached, 0 means disabled
+    uint32_t regionHashSize_;
+    // whether to punch a hole or zero the range for the discard
+    bool discardPunchHole_;
     // datastore management directory
     std::string baseDir_;
     // the mapping of chunkid->chunkfile
@@ -314,6 +485,10 @@ class CSDataStore {
     std::shared_ptr<LocalFileSystem> lfs_;
     // internal statistics of datastore
     DataStoreMetricPtr metric_;
+    // thread pool to load chunk files when initializing, may be nullptr
+    std::shared_ptr<TaskThreadPool<>> loadPool_;
+    // metapage index of all chunk files, nullptr if it is not used
+    std::shared_ptr<CSMetaIndex> metaIndex_;
 };
 
 }  // namespace chunkserver
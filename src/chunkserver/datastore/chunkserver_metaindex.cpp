@@ -0,0 +1,273 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <memory>
+
+#include "src/chunkserver/datastore/chunkserver_metaindex.h"
+#include "src/common/crc32.h"
+
+namespace curve {
+namespace chunkserver {
+
+namespace {
+
+// The magic is changed from "CSMI" since the region hash is recorded,
+// and from "CSM2" since the file stamps are recorded,
+// the index written by older versions is ignored
+const uint32_t kMetaIndexMagic = 0x334d5343;  // "CSM3"
+
+template <typename T>
+inline void AppendValue(std::string* buf, const T& value) {
+    buf->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+inline bool ParseValue(const char* buf, size_t length, size_t* pos, T* value) {
+    if (*pos + sizeof(T) > length) {
+        return false;
+    }
+    memcpy(value, buf + *pos, sizeof(T));
+    *pos += sizeof(T);
+    return true;
+}
+
+}  // namespace
+
+CSMetaIndex::CSMetaIndex(std::shared_ptr<LocalFileSystem> lfs,
+                         const std::string& path)
+    : lfs_(lfs),
+      path_(path) {
+    CHECK(lfs_ != nullptr) << "Create meta index failed";
+    CHECK(!path_.empty()) << "Create meta index failed";
+}
+
+void CSMetaIndex::Encode(const MetaPageMap& metaPages, std::string* buf) {
+    buf->clear();
+    AppendValue(buf, kMetaIndexMagic);
+    AppendValue(buf, FORMAT_VERSION);
+    AppendValue(buf, static_cast<uint64_t>(metaPages.size()));
+    for (const auto& item : metaPages) {
+        const ChunkFileMetaPage& metaPage = item.second;
+        AppendValue(buf, item.first);
+        AppendValue(buf, metaPage.sn);
+        AppendValue(buf, metaPage.correctedSn);
+        AppendValue(buf, metaPage.inode);
+        AppendValue(buf, metaPage.ctime);
+        uint32_t locSize = metaPage.location.size();
+        AppendValue(buf, locSize);
+        // Only CloneChunk has location and bitmap
+        if (locSize > 0) {
+            buf->append(metaPage.location);
+            uint32_t bits = metaPage.bitmap->Size();
+            AppendValue(buf, bits);
+            buf->append(metaPage.bitmap->GetBitmap(), (bits + 8 - 1) >> 3);
+        }
+        const auto& regionHash = metaPage.regionHash;
+        uint32_t regionSize = regionHash == nullptr
+                              ? 0 : regionHash->regionSize;
+        AppendValue(buf, regionSize);
+        if (regionSize > 0) {
+            uint32_t regions = regionHash->crcs.size();
+            AppendValue(buf, regions);
+            buf->append(regionHash->valid.GetBitmap(), (regions + 8 - 1) >> 3);
+            buf->append(reinterpret_cast<const char*>(regionHash->crcs.data()),
+                        regions * sizeof(uint32_t));
+        }
+    }
+    uint32_t crc = ::curve::common::CRC32(buf->data(), buf->size());
+    AppendValue(buf, crc);
+}
+
+CSErrorCode CSMetaIndex::Decode(const char* buf,
+                                size_t length,
+                                MetaPageMap* metaPages) {
+    if (length < sizeof(uint32_t)) {
+        LOG(ERROR) << "Meta index is too short, length: " << length;
+        return CSErrorCode::FileFormatError;
+    }
+    size_t dataLen = length - sizeof(uint32_t);
+    uint32_t crc = ::curve::common::CRC32(buf, dataLen);
+    uint32_t recordCrc;
+    memcpy(&recordCrc, buf + dataLen, sizeof(recordCrc));
+    if (crc != recordCrc) {
+        LOG(ERROR) << "Checking meta index crc32 failed.";
+        return CSErrorCode::CrcCheckError;
+    }
+
+    size_t pos = 0;
+    uint32_t magic = 0;
+    uint8_t version = 0;
+    uint64_t count = 0;
+    if (!ParseValue(buf, dataLen, &pos, &magic)
+        || !ParseValue(buf, dataLen, &pos, &version)
+        || !ParseValue(buf, dataLen, &pos, &count)
+        || magic != kMetaIndexMagic) {
+        LOG(ERROR) << "Invalid meta index header.";
+        return CSErrorCode::FileFormatError;
+    }
+    if (version != FORMAT_VERSION) {
+        LOG(ERROR) << "Meta index format version incompatible."
+                   << "index version: " << static_cast<uint32_t>(version)
+                   << ", format version: "
+                   << static_cast<uint32_t>(FORMAT_VERSION);
+        return CSErrorCode::IncompatibleError;
+    }
+
+    metaPages->clear();
+    for (uint64_t i = 0; i < count; ++i) {
+        ChunkID id;
+        ChunkFileMetaPage metaPage;
+        uint32_t locSize = 0;
+        metaPage.version = version;
+        if (!ParseValue(buf, dataLen, &pos, &id)
+            || !ParseValue(buf, dataLen, &pos, &metaPage.sn)
+            || !ParseValue(buf, dataLen, &pos, &metaPage.correctedSn)
+            || !ParseValue(buf, dataLen, &pos, &metaPage.inode)
+            || !ParseValue(buf, dataLen, &pos, &metaPage.ctime)
+            || !ParseValue(buf, dataLen, &pos, &locSize)
+            || pos + locSize > dataLen) {
+            LOG(ERROR) << "Meta index is truncated, entry index: " << i;
+            return CSErrorCode::FileFormatError;
+        }
+        if (locSize > 0) {
+            metaPage.location = std::string(buf + pos, locSize);
+            pos += locSize;
+            uint32_t bits = 0;
+            if (!ParseValue(buf, dataLen, &pos, &bits)
+                || pos + ((bits + 8 - 1) >> 3) > dataLen) {
+                LOG(ERROR) << "Meta index is truncated, entry index: " << i;
+                return CSErrorCode::FileFormatError;
+            }
+            metaPage.bitmap = std::make_shared<Bitmap>(bits, buf + pos);
+            pos += (bits + 8 - 1) >> 3;
+        }
+        uint32_t regionSize = 0;
+        if (!ParseValue(buf, dataLen, &pos, &regionSize)) {
+            LOG(ERROR) << "Meta index is truncated, entry index: " << i;
+            return CSErrorCode::FileFormatError;
+        }
+        if (regionSize > 0) {
+            uint32_t regions = 0;
+            size_t validBytes = 0;
+            size_t crcBytes = 0;
+            if (ParseValue(buf, dataLen, &pos, &regions)) {
+                validBytes = (regions + 8 - 1) >> 3;
+                crcBytes = static_cast<size_t>(regions) * sizeof(uint32_t);
+            }
+            if (regions == 0 || pos + validBytes + crcBytes > dataLen) {
+                LOG(ERROR) << "Meta index is truncated, entry index: " << i;
+                return CSErrorCode::FileFormatError;
+            }
+            metaPage.regionHash =
+                std::make_shared<ChunkRegionHash>(regionSize, regions);
+            metaPage.regionHash->valid = Bitmap(regions, buf + pos);
+            pos += validBytes;
+            memcpy(metaPage.regionHash->crcs.data(), buf + pos, crcBytes);
+            pos += crcBytes;
+        }
+        (*metaPages)[id] = metaPage;
+    }
+    if (pos != dataLen) {
+        LOG(ERROR) << "Meta index has unexpected trailing data.";
+        return CSErrorCode::FileFormatError;
+    }
+    return CSErrorCode::Success;
+}
+
+CSErrorCode CSMetaIndex::Save(const MetaPageMap& metaPages) {
+    std::string buf;
+    Encode(metaPages, &buf);
+
+    std::string tmpPath = path_ + ".tmp";
+    int fd = lfs_->Open(tmpPath, O_RDWR|O_CREAT|O_TRUNC);
+    if (fd < 0) {
+        LOG(ERROR) << "Open meta index failed, path: " << tmpPath;
+        return CSErrorCode::InternalError;
+    }
+    int rc = lfs_->Write(fd, buf.data(), 0, buf.size());
+    if (rc != static_cast<int>(buf.size())) {
+        LOG(ERROR) << "Write meta index failed, path: " << tmpPath
+                   << ", rc: " << rc;
+        lfs_->Close(fd);
+        return CSErrorCode::InternalError;
+    }
+    rc = lfs_->Fsync(fd);
+    lfs_->Close(fd);
+    if (rc < 0) {
+        LOG(ERROR) << "Fsync meta index failed, path: " << tmpPath;
+        return CSErrorCode::InternalError;
+    }
+    rc = lfs_->Rename(tmpPath, path_);
+    if (rc < 0) {
+        LOG(ERROR) << "Rename meta index failed, path: " << tmpPath;
+        return CSErrorCode::InternalError;
+    }
+    return CSErrorCode::Success;
+}
+
+bool CSMetaIndex::Load(MetaPageMap* metaPages) {
+    if (!lfs_->FileExists(path_)) {
+        return false;
+    }
+    int fd = lfs_->Open(path_, O_RDONLY);
+    if (fd < 0) {
+        LOG(WARNING) << "Open meta index failed, path: " << path_;
+        return false;
+    }
+    struct stat fileInfo;
+    int rc = lfs_->Fstat(fd, &fileInfo);
+    if (rc < 0) {
+        LOG(WARNING) << "Stat meta index failed, path: " << path_;
+        lfs_->Close(fd);
+        return false;
+    }
+    size_t length = fileInfo.st_size;
+    std::unique_ptr<char[]> buf(new char[length]);
+    rc = lfs_->Read(fd, buf.get(), 0, length);
+    lfs_->Close(fd);
+    if (rc != static_cast<int>(length)) {
+        LOG(WARNING) << "Read meta index failed, path: " << path_
+                     << ", rc: " << rc;
+        return false;
+    }
+    if (Decode(buf.get(), length, metaPages) != CSErrorCode::Success) {
+        LOG(WARNING) << "Decode meta index failed, path: " << path_;
+        return false;
+    }
+    return true;
+}
+
+CSErrorCode CSMetaIndex::Invalidate() {
+    if (!lfs_->FileExists(path_)) {
+        return CSErrorCode::Success;
+    }
+    int rc = lfs_->Delete(path_);
+    if (rc < 0) {
+        LOG(ERROR) << "Delete meta index failed, path: " << path_;
+        return CSErrorCode::InternalError;
+    }
+    return CSErrorCode::Success;
+}
+
+}  // namespace chunkserver
+}  // namespace curve
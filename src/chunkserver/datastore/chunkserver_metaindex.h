@@ -0,0 +1,115 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#ifndef SRC_CHUNKSERVER_DATASTORE_CHUNKSERVER_METAINDEX_H_
+#define SRC_CHUNKSERVER_DATASTORE_CHUNKSERVER_METAINDEX_H_
+
+#include <glog/logging.h>
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+#include "include/chunkserver/chunkserver_common.h"
+#include "src/chunkserver/datastore/define.h"
+#include "src/chunkserver/datastore/chunkserver_chunkfile.h"
+#include "src/fs/local_filesystem.h"
+
+namespace curve {
+namespace chunkserver {
+
+using curve::fs::LocalFileSystem;
+
+// The file name of the metapage index in the copyset directory
+const char kChunkMetaIndexFilename[] = "chunk_meta.index";
+
+using MetaPageMap = std::unordered_map<ChunkID, ChunkFileMetaPage>;
+
+/**
+ * Meta Index Format
+ * magic: 4 bytes
+ * version: 1 byte
+ * count: 8 bytes
+ * entries: count entries, each entry is:
+ *     id: 8 bytes
+ *     sn: 8 bytes
+ *     correctedSn: 8 bytes
+ *     inode: 8 bytes
+ *     ctime: 8 bytes
+ *     locationSize: 4 bytes
+ *     location: locationSize bytes
+ *     bits: 4 bytes, only exists when locationSize > 0
+ *     bitmap: (bits + 8 - 1) / 8 bytes, only exists when locationSize > 0
+ *     regionSize: 4 bytes, 0 if the region hash is not recorded
+ *     regions: 4 bytes, only exists when regionSize > 0
+ *     valid: (regions + 8 - 1) / 8 bytes, only exists when regionSize > 0
+ *     crcs: regions * 4 bytes, only exists when regionSize > 0
+ * crc: 4 bytes
+ *
+ * The index records the metapages of all the chunk files in a datastore,
+ * so that the datastore can be restored from one sequential read instead of
+ * reading the metapage of every chunk file.
+ * The index is only written when the datastore is closed cleanly, and it is
+ * removed as soon as it is loaded, so a crash always falls back to loading
+ * the metapages from the chunk files.
+ * Each entry also records the inode and the ctime of the chunk file, an
+ * entry is ignored if the chunk file has been modified since the index was
+ * saved, e.g. by a version running with the index disabled.
+ */
+class CSMetaIndex {
+ public:
+    CSMetaIndex(std::shared_ptr<LocalFileSystem> lfs,
+                const std::string& path);
+    virtual ~CSMetaIndex() {}
+
+    /**
+     * Persist the metapages, the index is written to a temporary file
+     * first and then renamed, so a half written index will never be used
+     * @param metaPages: the metapages of all chunk files
+     * @return: return error code
+     */
+    CSErrorCode Save(const MetaPageMap& metaPages);
+    /**
+     * Load the metapages from the index
+     * @param metaPages: the metapages loaded from the index
+     * @return: return true if the index exists and is valid
+     */
+    bool Load(MetaPageMap* metaPages);
+    /**
+     * Remove the index, after that the index will not be used
+     * until the next Save
+     * @return: return error code
+     */
+    CSErrorCode Invalidate();
+
+    static void Encode(const MetaPageMap& metaPages, std::string* buf);
+    static CSErrorCode Decode(const char* buf,
+                              size_t length,
+                              MetaPageMap* metaPages);
+
+ private:
+    std::shared_ptr<LocalFileSystem> lfs_;
+    // The path of the index file
+    std::string path_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_DATASTORE_CHUNKSERVER_METAINDEX_H_
@@ -70,6 +70,9 @@ enum CSErrorCode {
     // The page has not been written, it will appear when the page that has not
     // been written is read when the clone chunk is read
     PageNerverWrittenError = 13,
+    // The data of the chunk is still needed by the clone source or the
+    // snapshot, the discard request is skipped and nothing is released
+    DiscardSkippedError = 14,
 };
 
 // Chunk details
@@ -30,6 +30,7 @@
 
 #include <algorithm>
 #include <cctype>
+#include <chrono>  // NOLINT
 #include <climits>
 #include <memory>
 #include <vector>
@@ -37,8 +38,10 @@
 #include "src/common/configuration.h"
 #include "src/common/crc32.h"
 #include "src/common/curve_define.h"
+#include "src/common/timeutility.h"
 
 using curve::common::kFilePoolMaigic;
+using curve::common::TimeUtility;
 
 namespace curve {
 namespace chunkserver {
@@ -196,10 +199,18 @@ int FilePoolHelper::DecodeMetaInfoFromMetaFile(
 }
 
 FilePool::FilePool(std::shared_ptr<LocalFileSystem> fsptr)
-    : currentmaxfilenum_(0) {
+    : nextShard_(0),
+      cleanCount_(0),
+      dirtyCount_(0),
+      cleanRunning_(false),
+      currentmaxfilenum_(0) {
     CHECK(fsptr != nullptr) << "fs ptr allocate failed!";
     fsptr_ = fsptr;
-    tmpChunkvec_.clear();
+    currentState_.preallocatedChunksLeft = 0;
+}
+
+FilePool::~FilePool() {
+    StopCleaner();
 }
 
 bool FilePool::Initialize(const FilePoolOptions& cfopt) {
@@ -210,7 +221,9 @@ bool FilePool::Initialize(const FilePoolOptions& cfopt) {
             return false;
         }
         if (fsptr_->DirExists(currentdir_.c_str())) {
-            return ScanInternal();
+            if (!ScanInternal()) {
+                return false;
+            }
         } else {
             LOG(ERROR) << "chunkfile pool not exists, inited failed!"
                        << " chunkfile pool path = " << currentdir_.c_str();
@@ -219,9 +232,14 @@ bool FilePool::Initialize(const FilePoolOptions& cfopt) {
     } else {
         currentdir_ = poolOpt_.filePoolDir;
         if (!fsptr_->DirExists(currentdir_.c_str())) {
-            return fsptr_->Mkdir(currentdir_.c_str()) == 0;
+            if (fsptr_->Mkdir(currentdir_.c_str()) != 0) {
+                return false;
+            }
+        } else if (!ScanAllocated()) {
+            return false;
         }
     }
+    StartCleaner();
     return true;
 }
 
@@ -252,15 +270,15 @@ int FilePool::GetFile(const std::string& targetpath, char* metapage) {
         uint64_t chunkID;
         std::string srcpath;
         if (poolOpt_.getFileFromPool) {
-            std::unique_lock<std::mutex> lk(mtx_);
-            if (tmpChunkvec_.empty()) {
+            if (!PopFile(&chunkID)) {
                 LOG(ERROR) << "no avaliable chunk!";
                 break;
             }
-            chunkID = tmpChunkvec_.back();
             srcpath = currentdir_ + "/" + std::to_string(chunkID);
-            tmpChunkvec_.pop_back();
-            --currentState_.preallocatedChunksLeft;
+        } else if (PopFile(&chunkID)) {
+            // the file is allocated by the cleaner in background
+            srcpath = currentdir_ + "/" + std::to_string(chunkID);
+            NotifyCleaner();
         } else {
             srcpath = currentdir_ + "/" +
                       std::to_string(currentmaxfilenum_.fetch_add(1));
@@ -293,8 +311,7 @@ int FilePool::GetFile(const std::string& targetpath, char* metapage) {
                 LOG(ERROR) << "file rename failed, " << srcpath.c_str();
             } else {
                 LOG(INFO) << "get file " << targetpath
-                          << " success! now pool size = "
-                          << tmpChunkvec_.size();
+                          << " success! now pool size = " << Size();
                 break;
             }
         } else {
@@ -390,66 +407,329 @@ int FilePool::RecycleFile(const std::string& chunkpath) {
             return -1;
         }
     } else {
-        // Check whether the size of the file to be recovered meets the
-        // requirements, and delete it if it does not
-        uint64_t chunklen = poolOpt_.fileSize + poolOpt_.metaPageSize;
-        int fd = fsptr_->Open(chunkpath.c_str(), O_RDWR);
-        if (fd < 0) {
-            LOG(ERROR) << "file open failed! delete file dirctly"
-                       << ", filename = " << chunkpath.c_str();
+        if (!IsRecyclable(chunkpath)) {
             return fsptr_->Delete(chunkpath.c_str());
         }
 
-        struct stat info;
-        int ret = fsptr_->Fstat(fd, &info);
-        if (ret != 0) {
-            LOG(ERROR) << "Fstat file " << chunkpath.c_str()
-                       << "failed, ret = " << ret << ", delete file dirctly";
-            fsptr_->Close(fd);
-            return fsptr_->Delete(chunkpath.c_str());
+        uint64_t newfilenum = currentmaxfilenum_.fetch_add(1) + 1;
+        std::string targetpath = currentdir_ + "/" +
+                                 std::to_string(newfilenum);
+
+        int ret = fsptr_->Rename(chunkpath.c_str(), targetpath.c_str());
+        if (ret < 0) {
+            LOG(ERROR) << "file rename failed, " << chunkpath.c_str();
+            return -1;
+        } else {
+            LOG(INFO) << "Recycle " << chunkpath.c_str() << ", success!"
+                      << ", now chunkpool size = " << Size() + 1;
+        }
+        // The recycled file still has the data written before, it is
+        // cleaned in background before it is used again
+        if (poolOpt_.needClean) {
+            PushDirtyFile(newfilenum);
+        } else {
+            PushCleanFile(newfilenum);
         }
+    }
+    return 0;
+}
 
-        if (info.st_size != chunklen) {
-            LOG(ERROR) << "file size illegal, " << chunkpath.c_str()
-                       << ", delete file dirctly"
-                       << ", standard size = " << chunklen
-                       << ", current file size = " << info.st_size;
-            fsptr_->Close(fd);
-            return fsptr_->Delete(chunkpath.c_str());
+int FilePool::RecycleFiles(const std::vector<std::string>& chunkpaths) {
+    int result = 0;
+    if (!poolOpt_.getFileFromPool) {
+        for (const auto& chunkpath : chunkpaths) {
+            if (fsptr_->Delete(chunkpath.c_str()) < 0) {
+                LOG(ERROR) << "Recycle chunk failed, " << chunkpath.c_str();
+                result = -1;
+            }
+        }
+        return result;
+    }
+
+    std::vector<std::string> recyclable;
+    recyclable.reserve(chunkpaths.size());
+    for (const auto& chunkpath : chunkpaths) {
+        if (IsRecyclable(chunkpath)) {
+            recyclable.push_back(chunkpath);
+        } else if (fsptr_->Delete(chunkpath.c_str()) < 0) {
+            result = -1;
+        }
+    }
+    if (recyclable.empty()) {
+        return result;
+    }
+
+    // Take the file numbers of all the files at once
+    uint64_t firstfilenum =
+        currentmaxfilenum_.fetch_add(recyclable.size()) + 1;
+    std::vector<uint64_t> filenums;
+    filenums.reserve(recyclable.size());
+    for (size_t i = 0; i < recyclable.size(); ++i) {
+        uint64_t newfilenum = firstfilenum + i;
+        std::string targetpath = currentdir_ + "/" +
+                                 std::to_string(newfilenum);
+        if (fsptr_->Rename(recyclable[i].c_str(), targetpath.c_str()) < 0) {
+            LOG(ERROR) << "file rename failed, " << recyclable[i].c_str();
+            result = -1;
+            continue;
+        }
+        filenums.push_back(newfilenum);
+    }
+
+    if (poolOpt_.needClean) {
+        PushDirtyFiles(filenums);
+    } else {
+        for (auto filenum : filenums) {
+            PushCleanFile(filenum);
         }
+    }
+    LOG(INFO) << "Recycle " << filenums.size() << " files"
+              << ", failed " << chunkpaths.size() - filenums.size()
+              << ", now chunkpool size = " << Size();
+    return result;
+}
+
+bool FilePool::IsRecyclable(const std::string& chunkpath) {
+    // Check whether the size of the file to be recovered meets the
+    // requirements, and delete it if it does not
+    uint64_t chunklen = poolOpt_.fileSize + poolOpt_.metaPageSize;
+    int fd = fsptr_->Open(chunkpath.c_str(), O_RDWR);
+    if (fd < 0) {
+        LOG(ERROR) << "file open failed! delete file dirctly"
+                   << ", filename = " << chunkpath.c_str();
+        return false;
+    }
 
+    struct stat info;
+    int ret = fsptr_->Fstat(fd, &info);
+    if (ret != 0) {
+        LOG(ERROR) << "Fstat file " << chunkpath.c_str()
+                   << "failed, ret = " << ret << ", delete file dirctly";
         fsptr_->Close(fd);
+        return false;
+    }
+
+    if (info.st_size != chunklen) {
+        LOG(ERROR) << "file size illegal, " << chunkpath.c_str()
+                   << ", delete file dirctly"
+                   << ", standard size = " << chunklen
+                   << ", current file size = " << info.st_size;
+        fsptr_->Close(fd);
+        return false;
+    }
+
+    fsptr_->Close(fd);
+    return true;
+}
+
+void FilePool::UnInitialize() {
+    StopCleaner();
+    currentdir_ = "";
+
+    for (auto& shard : shards_) {
+        std::unique_lock<std::mutex> lk(shard.mtx);
+        cleanDepth_ << -static_cast<int64_t>(shard.files.size());
+        shard.files.clear();
+    }
+    cleanCount_.store(0);
+    std::unique_lock<std::mutex> lk(dirtyMtx_);
+    dirtyDepth_ << -static_cast<int64_t>(dirtyFiles_.size());
+    dirtyFiles_.clear();
+    dirtyCount_.store(0);
+}
+
+void FilePool::ExposeMetric(const std::string& prefix) {
+    // The wal pool may share the chunk pool, keep the names exposed first
+    if (!cleanDepth_.is_hidden()) {
+        return;
+    }
+    cleanDepth_.expose(prefix + "_clean_depth");
+    dirtyDepth_.expose(prefix + "_dirty_depth");
+    refillLatency_.expose(prefix + "_refill");
+}
 
-        uint64_t newfilenum = 0;
-        std::string newfilename;
+bool FilePool::PopFile(uint64_t* filenum) {
+    if (cleanCount_.load() > 0) {
+        uint32_t start = nextShard_.fetch_add(1);
+        for (uint32_t i = 0; i < kFileShardNum; ++i) {
+            FileShard& shard = shards_[(start + i) % kFileShardNum];
+            std::unique_lock<std::mutex> lk(shard.mtx);
+            if (shard.files.empty()) {
+                continue;
+            }
+            *filenum = shard.files.back();
+            shard.files.pop_back();
+            cleanCount_.fetch_sub(1);
+            cleanDepth_ << -1;
+            return true;
+        }
+    }
+    // All the clean files are used up, use the file not cleaned yet
+    // rather than failing the request
+    std::unique_lock<std::mutex> lk(dirtyMtx_);
+    if (dirtyFiles_.empty()) {
+        return false;
+    }
+    *filenum = dirtyFiles_.back();
+    dirtyFiles_.pop_back();
+    dirtyCount_.fetch_sub(1);
+    dirtyDepth_ << -1;
+    LOG(WARNING) << "No clean file in pool, use the file not cleaned, "
+                 << "filenum = " << *filenum;
+    return true;
+}
+
+void FilePool::PushCleanFile(uint64_t filenum) {
+    FileShard& shard = shards_[filenum % kFileShardNum];
+    std::unique_lock<std::mutex> lk(shard.mtx);
+    shard.files.push_back(filenum);
+    cleanCount_.fetch_add(1);
+    cleanDepth_ << 1;
+}
+
+void FilePool::PushDirtyFile(uint64_t filenum) {
+    {
+        std::unique_lock<std::mutex> lk(dirtyMtx_);
+        dirtyFiles_.push_back(filenum);
+        dirtyCount_.fetch_add(1);
+        dirtyDepth_ << 1;
+    }
+    cleanCond_.notify_one();
+}
+
+void FilePool::PushDirtyFiles(const std::vector<uint64_t>& filenums) {
+    if (filenums.empty()) {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lk(dirtyMtx_);
+        dirtyFiles_.insert(dirtyFiles_.end(), filenums.begin(),
+                           filenums.end());
+        dirtyCount_.fetch_add(filenums.size());
+        dirtyDepth_ << static_cast<int64_t>(filenums.size());
+    }
+    cleanCond_.notify_one();
+}
+
+void FilePool::StartCleaner() {
+    bool needRefill = !poolOpt_.getFileFromPool && poolOpt_.lowWaterMark > 0;
+    if (!poolOpt_.needClean && !needRefill) {
+        return;
+    }
+    if (cleanRunning_.exchange(true)) {
+        return;
+    }
+    cleanThread_ = std::thread(&FilePool::CleanWorker, this);
+    LOG(INFO) << "Start file pool cleaner, pool dir = " << currentdir_
+              << ", low water mark = " << poolOpt_.lowWaterMark;
+}
+
+void FilePool::StopCleaner() {
+    {
+        std::unique_lock<std::mutex> lk(dirtyMtx_);
+        if (!cleanRunning_.exchange(false)) {
+            return;
+        }
+    }
+    cleanCond_.notify_all();
+    cleanThread_.join();
+}
+
+void FilePool::NotifyCleaner() {
+    // Take the lock so that the cleaner will not miss the notification
+    // between checking the condition and waiting
+    { std::unique_lock<std::mutex> lk(dirtyMtx_); }
+    cleanCond_.notify_one();
+}
+
+bool FilePool::NeedRefill() const {
+    return !poolOpt_.getFileFromPool
+        && cleanCount_.load() < poolOpt_.lowWaterMark;
+}
+
+void FilePool::CleanWorker() {
+    while (cleanRunning_.load()) {
+        uint64_t filenum = 0;
+        bool dirty = false;
         {
-            std::unique_lock<std::mutex> lk(mtx_);
-            currentmaxfilenum_.fetch_add(1);
-            newfilenum = currentmaxfilenum_.load();
-            newfilename = std::to_string(newfilenum);
+            std::unique_lock<std::mutex> lk(dirtyMtx_);
+            cleanCond_.wait(lk, [this]() {
+                return !cleanRunning_.load() || !dirtyFiles_.empty()
+                    || NeedRefill();
+            });
+            if (!cleanRunning_.load()) {
+                break;
+            }
+            // Files recycled first are cleaned first
+            if (!dirtyFiles_.empty()) {
+                filenum = dirtyFiles_.front();
+                dirtyFiles_.pop_front();
+                dirtyCount_.fetch_sub(1);
+                dirtyDepth_ << -1;
+                dirty = true;
+            }
         }
-        std::string targetpath = currentdir_ + "/" + newfilename;
 
-        ret = fsptr_->Rename(chunkpath.c_str(), targetpath.c_str());
-        if (ret < 0) {
-            LOG(ERROR) << "file rename failed, " << chunkpath.c_str();
-            return -1;
+        uint64_t startUs = TimeUtility::GetTimeofDayUs();
+        if (dirty) {
+            if (!CleanFile(filenum)) {
+                // Drop the file, the same as the file with illegal size
+                // when it is recycled
+                std::string path = currentdir_ + "/" + std::to_string(filenum);
+                LOG(ERROR) << "Clean file failed, delete file directly, "
+                           << path;
+                fsptr_->Delete(path.c_str());
+                continue;
+            }
         } else {
-            LOG(INFO) << "Recycle " << chunkpath.c_str() << ", success!"
-                      << ", now chunkpool size = " << tmpChunkvec_.size() + 1;
+            filenum = currentmaxfilenum_.fetch_add(1);
+            std::string path = currentdir_ + "/" + std::to_string(filenum);
+            if (AllocateChunk(path) < 0) {
+                LOG(ERROR) << "Refill file pool failed, " << path;
+                fsptr_->Delete(path.c_str());
+                // Wait for a while before retrying
+                std::unique_lock<std::mutex> lk(dirtyMtx_);
+                cleanCond_.wait_for(lk, std::chrono::seconds(1), [this]() {
+                    return !cleanRunning_.load();
+                });
+                continue;
+            }
         }
-        std::unique_lock<std::mutex> lk(mtx_);
-        tmpChunkvec_.push_back(newfilenum);
-        ++currentState_.preallocatedChunksLeft;
+        refillLatency_ << TimeUtility::GetTimeofDayUs() - startUs;
+        PushCleanFile(filenum);
     }
-    return 0;
 }
 
-void FilePool::UnInitialize() {
-    currentdir_ = "";
+bool FilePool::CleanFile(uint64_t filenum) {
+    std::string path = currentdir_ + "/" + std::to_string(filenum);
+    int fd = fsptr_->Open(path.c_str(), O_RDWR);
+    if (fd < 0) {
+        LOG(ERROR) << "file open failed, " << path;
+        return false;
+    }
 
-    std::unique_lock<std::mutex> lk(mtx_);
-    tmpChunkvec_.clear();
+    uint64_t chunklen = poolOpt_.fileSize + poolOpt_.metaPageSize;
+    uint32_t bytesPerWrite = std::max(poolOpt_.bytesPerWrite, 4096u);
+    std::unique_ptr<char[]> zero(new char[bytesPerWrite]);
+    memset(zero.get(), 0, bytesPerWrite);
+    for (uint64_t offset = 0; offset < chunklen; offset += bytesPerWrite) {
+        int length = std::min<uint64_t>(bytesPerWrite, chunklen - offset);
+        int ret = fsptr_->Write(fd, zero.get(), offset, length);
+        if (ret != length) {
+            LOG(ERROR) << "write zero failed, " << path
+                       << ", offset = " << offset << ", ret = " << ret;
+            fsptr_->Close(fd);
+            return false;
+        }
+    }
+
+    int ret = fsptr_->Fsync(fd);
+    fsptr_->Close(fd);
+    if (ret < 0) {
+        LOG(ERROR) << "fsync failed, " << path;
+        return false;
+    }
+    return true;
 }
 
 bool FilePool::ScanInternal() {
@@ -498,29 +778,75 @@ bool FilePool::ScanInternal() {
         fsptr_->Close(fd);
         uint64_t filenum = atoll(iter.c_str());
         if (filenum != 0) {
-            tmpChunkvec_.push_back(filenum);
+            PushCleanFile(filenum);
             if (filenum > maxnum) {
                 maxnum = filenum;
             }
         }
     }
 
-    currentState_.preallocatedChunksLeft = tmpvec.size();
-
-    std::unique_lock<std::mutex> lk(mtx_);
     currentmaxfilenum_.store(maxnum + 1);
 
-    LOG(INFO) << "scan done, pool size = " << tmpChunkvec_.size();
+    LOG(INFO) << "scan done, pool size = " << Size();
+    return true;
+}
+
+bool FilePool::ScanAllocated() {
+    std::vector<std::string> tmpvec;
+    int ret = fsptr_->List(currentdir_.c_str(), &tmpvec);
+    if (ret < 0) {
+        LOG(ERROR) << "list file pool dir failed, " << currentdir_;
+        return false;
+    }
+
+    // The directory is shared with other files, e.g. the data directory of
+    // the chunkserver, only the files named by numbers belong to the pool
+    uint64_t maxnum = 0;
+    uint64_t chunklen = poolOpt_.fileSize + poolOpt_.metaPageSize;
+    for (auto& iter : tmpvec) {
+        auto it = std::find_if(iter.begin(), iter.end(), [](unsigned char c) {
+            return !std::isdigit(c);
+        });
+        if (iter.empty() || it != iter.end()) {
+            continue;
+        }
+        std::string filepath = currentdir_ + "/" + iter;
+        if (!fsptr_->FileExists(filepath)) {
+            continue;
+        }
+        uint64_t filenum = atoll(iter.c_str());
+        maxnum = std::max(maxnum, filenum);
+
+        // Only the files with the right size are reused, the others are
+        // left alone, their names are skipped anyway
+        struct stat info;
+        int fd = fsptr_->Open(filepath.c_str(), O_RDWR);
+        if (fd >= 0) {
+            ret = fsptr_->Fstat(fd, &info);
+            fsptr_->Close(fd);
+        }
+        if (fd < 0 || ret != 0 || info.st_size != chunklen) {
+            LOG(WARNING) << "Skip file with illegal size, " << filepath;
+            continue;
+        }
+        PushCleanFile(filenum);
+    }
+
+    currentmaxfilenum_.store(maxnum + 1);
+    LOG(INFO) << "scan allocated files done, dir = " << currentdir_
+              << ", count = " << Size()
+              << ", current max file num = " << maxnum;
     return true;
 }
 
 size_t FilePool::Size() {
-    std::unique_lock<std::mutex> lk(mtx_);
-    return tmpChunkvec_.size();
+    return cleanCount_.load() + dirtyCount_.load();
 }
 
 FilePoolState_t FilePool::GetState() {
-    return currentState_;
+    FilePoolState_t state = currentState_;
+    state.preallocatedChunksLeft = Size();
+    return state;
 }
 
 }  // namespace chunkserver
@@ -24,6 +24,7 @@
 #define SRC_CHUNKSERVER_DATASTORE_FILE_POOL_H_
 
 #include <glog/logging.h>
+#include <bvar/bvar.h>
 
 #include <set>
 #include <mutex>  // NOLINT
@@ -32,6 +33,8 @@
 #include <memory>
 #include <deque>
 #include <atomic>
+#include <thread>  // NOLINT
+#include <condition_variable>  // NOLINT
 
 #include "src/fs/local_filesystem.h"
 #include "include/curve_compiler_specific.h"
@@ -50,6 +53,13 @@ struct FilePoolOptions {
     uint32_t    metaFileSize;
     // retry times for get file
     uint16_t    retryTimes;
+    // zero the recycled files in background before they are reused
+    bool        needClean;
+    // bytes written each time when zeroing a recycled file
+    uint32_t    bytesPerWrite;
+    // keep at least lowWaterMark files allocated in background,
+    // only works when getFileFromPool=false
+    uint32_t    lowWaterMark;
 
     FilePoolOptions() {
         getFileFromPool = true;
@@ -57,6 +67,9 @@ struct FilePoolOptions {
         fileSize = 0;
         metaPageSize = 0;
         retryTimes = 5;
+        needClean = false;
+        bytesPerWrite = 4096;
+        lowWaterMark = 0;
         ::memset(metaPath, 0, 256);
         ::memset(filePoolDir, 0, 256);
     }
@@ -67,6 +80,9 @@ struct FilePoolOptions {
         fileSize    = other.fileSize;
         retryTimes   = other.retryTimes;
         metaPageSize = other.metaPageSize;
+        needClean = other.needClean;
+        bytesPerWrite = other.bytesPerWrite;
+        lowWaterMark = other.lowWaterMark;
         ::memcpy(metaPath, other.metaPath, 256);
         ::memcpy(filePoolDir, other.filePoolDir, 256);
         return *this;
@@ -78,6 +94,9 @@ struct FilePoolOptions {
         fileSize    = other.fileSize;
         retryTimes   = other.retryTimes;
         metaPageSize = other.metaPageSize;
+        needClean = other.needClean;
+        bytesPerWrite = other.bytesPerWrite;
+        lowWaterMark = other.lowWaterMark;
         ::memcpy(metaPath, other.metaPath, 256);
         ::memcpy(filePoolDir, other.filePoolDir, 256);
     }
@@ -137,7 +156,7 @@ class FilePoolHelper {
 class CURVE_CACHELINE_ALIGNMENT FilePool {
  public:
     explicit FilePool(std::shared_ptr<LocalFileSystem> fsptr);
-    virtual ~FilePool() = default;
+    virtual ~FilePool();
 
     /**
      * Initialization function
@@ -156,6 +175,13 @@ class CURVE_CACHELINE_ALIGNMENT FilePool {
      * @param: chunkpath is the chunk path that needs to be recycled
      */
     virtual int RecycleFile(const std::string& chunkpath);
+    /**
+     * Recycle the files of many chunks deleted together, the file numbers
+     * are taken and the files are handed to the cleaner at once
+     * @param: chunkpaths are the chunk paths that need to be recycled
+     * @return: 0 if all the files are recycled, otherwise -1
+     */
+    virtual int RecycleFiles(const std::vector<std::string>& chunkpaths);
     /**
      * Get the current chunkfile pool size
      */
@@ -175,6 +201,12 @@ class CURVE_CACHELINE_ALIGNMENT FilePool {
      */
     virtual void UnInitialize();
 
+    /**
+     * Expose the depth of the pool and the latency of refilling a file
+     * @param: prefix is the prefix of the metric names
+     */
+    void ExposeMetric(const std::string& prefix);
+
     /**
      * Test use
      */
@@ -187,6 +219,10 @@ class CURVE_CACHELINE_ALIGNMENT FilePool {
     // Traverse the pre-allocated chunk information from the
     // chunkfile pool directory
     bool ScanInternal();
+    // Take back the files allocated in background before the restart
+    // when not getting files from the pool, so that the new files
+    // will not reuse their names
+    bool ScanAllocated();
     // Check whether the chunkfile pool pre-allocation is legal
     bool CheckValid();
     /**
@@ -202,10 +238,50 @@ class CURVE_CACHELINE_ALIGNMENT FilePool {
      * @return: return 0 if successful, otherwise return less than 0
      */
     int AllocateChunk(const std::string& chunkpath);
+    /**
+     * Check whether the file to be recycled has the right size
+     * @param: chunkpath is the path of the file to be recycled
+     * @return: returns false if the file should be deleted directly
+     */
+    bool IsRecyclable(const std::string& chunkpath);
+
+    /**
+     * Take a file from the pool, the cleaned files are preferred
+     * @param: filenum is the number of the file taken
+     * @return: returns false if there is no file in the pool
+     */
+    bool PopFile(uint64_t* filenum);
+    void PushCleanFile(uint64_t filenum);
+    void PushDirtyFile(uint64_t filenum);
+    void PushDirtyFiles(const std::vector<uint64_t>& filenums);
+
+    void StartCleaner();
+    void StopCleaner();
+    void NotifyCleaner();
+    bool NeedRefill() const;
+    // Background thread to clean the recycled files and refill the pool
+    void CleanWorker();
+    /**
+     * Write zero to the whole file
+     * @param: filenum is the number of the file to clean
+     * @return: returns true if successful, otherwise false
+     */
+    bool CleanFile(uint64_t filenum);
 
  private:
-    // Protect tmpChunkvec_
-    std::mutex mtx_;
+    static const uint32_t kFileShardNum = 16;
+
+    // The numeric format of the file names in the chunkfile pool held in
+    // memory, the files are spread over the shards to reduce lock contention
+    struct CURVE_CACHELINE_ALIGNMENT FileShard {
+        std::mutex mtx;
+        std::vector<uint64_t> files;
+    };
+    FileShard shards_[kFileShardNum];
+    // The shard to take the next file from
+    std::atomic<uint32_t> nextShard_;
+    // Number of the files ready to use
+    std::atomic<uint64_t> cleanCount_;
 
     // Current FilePool pre-allocated files, folder path
     std::string currentdir_;
@@ -214,8 +290,15 @@ class CURVE_CACHELINE_ALIGNMENT FilePool {
     // which provides the basic interface for manipulating files
     std::shared_ptr<LocalFileSystem> fsptr_;
 
-    // The numeric format of the file name in the chunkfile pool held in memory
-    std::vector<uint64_t> tmpChunkvec_;
+    // Protect dirtyFiles_
+    std::mutex dirtyMtx_;
+    // Files recycled but not cleaned yet
+    std::deque<uint64_t> dirtyFiles_;
+    // Number of the files recycled but not cleaned yet
+    std::atomic<uint64_t> dirtyCount_;
+    std::condition_variable cleanCond_;
+    std::thread cleanThread_;
+    std::atomic<bool> cleanRunning_;
 
     // The current largest file name number format
     std::atomic<uint64_t> currentmaxfilenum_;
@@ -225,6 +308,11 @@ class CURVE_CACHELINE_ALIGNMENT FilePool {
 
     // FilePool allocation status
     FilePoolState_t currentState_;
+
+    // Metrics of the pool
+    bvar::Adder<int64_t> cleanDepth_;
+    bvar::Adder<int64_t> dirtyDepth_;
+    bvar::LatencyRecorder refillLatency_;
 };
 }   // namespace chunkserver
 }   // namespace curve
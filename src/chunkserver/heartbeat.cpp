@@ -32,6 +32,7 @@
 
 #include "src/fs/fs_common.h"
 #include "src/common/timeutility.h"
+#include "src/common/copyset_fingerprint.h"
 #include "src/chunkserver/heartbeat.h"
 #include "src/chunkserver/uri_paser.h"
 #include "src/chunkserver/heartbeat_helper.h"
@@ -279,9 +280,71 @@ int Heartbeat::BuildRequest(HeartbeatRequest* req) {
     }
     req->set_leadercount(leaders);
 
+    if (options_.enableDelta) {
+        BuildDeltaRequest(req);
+    }
+
     return 0;
 }
 
+void Heartbeat::BuildDeltaRequest(HeartbeatRequest* req) {
+    bool full = needFullHeartbeat_ ||
+                deltaCount_ >= options_.fullHeartbeatInterval;
+
+    uint32_t digest = 0;
+    int kept = 0;
+    auto infos = req->mutable_copysetinfos();
+    pendingCopysets_.clear();
+    for (int i = 0; i < infos->size(); ++i) {
+        const curve::mds::heartbeat::CopySetInfo& info = infos->Get(i);
+        uint64_t key = (static_cast<uint64_t>(info.logicalpoolid()) << 32) |
+                       info.copysetid();
+        uint32_t fingerprint = curve::common::CopySetFingerprint(info);
+        pendingCopysets_[key] = fingerprint;
+        digest ^= fingerprint;
+
+        // 配置变更中的copyset每次都上报，mds根据变更的进度推进operator
+        auto it = reportedCopysets_.find(key);
+        if (full || it == reportedCopysets_.end() ||
+            it->second != fingerprint || info.has_configchangeinfo()) {
+            infos->SwapElements(i, kept++);
+        }
+    }
+    infos->DeleteSubrange(kept, infos->size() - kept);
+
+    if (!full) {
+        for (const auto& item : reportedCopysets_) {
+            if (pendingCopysets_.count(item.first) == 0) {
+                req->add_removedcopysets(item.first);
+            }
+        }
+    }
+    req->set_isdelta(!full);
+    req->set_copysetdigest(digest);
+}
+
+void Heartbeat::OnHeartbeatSent(const HeartbeatRequest& request,
+                                const HeartbeatResponse& response) {
+    if (!options_.enableDelta) {
+        return;
+    }
+
+    // mds没有正确处理本次心跳，或者记录的copyset不一致，下次发送全量心跳
+    if (response.needfullheartbeat() ||
+        (response.statuscode() != curve::mds::heartbeat::hbOK &&
+         response.statuscode() != curve::mds::heartbeat::hbRequestNoCopyset)) {
+        LOG(INFO) << "Send full heartbeat next time, statusCode: "
+                  << response.statuscode() << ", needFullHeartbeat: "
+                  << response.needfullheartbeat();
+        needFullHeartbeat_ = true;
+        return;
+    }
+
+    deltaCount_ = request.isdelta() ? deltaCount_ + 1 : 0;
+    needFullHeartbeat_ = false;
+    reportedCopysets_.swap(pendingCopysets_);
+}
+
 void Heartbeat::DumpHeartbeatRequest(const HeartbeatRequest& request) {
     DVLOG(6) << "Heartbeat request: Chunkserver ID: "
              << request.chunkserverid()
@@ -522,6 +585,7 @@ void Heartbeat::HeartbeatWorker() {
             ::sleep(errorIntervalSec);
             continue;
         }
+        OnHeartbeatSent(req, resp);
 
         LOG(INFO) << "executing heartbeat info";
         ret = ExecTask(resp);
@@ -33,6 +33,7 @@
 #include <atomic>
 #include <memory>
 #include <thread>  //NOLINT
+#include <unordered_map>
 
 #include "include/chunkserver/chunkserver_common.h"
 #include "src/chunkserver/copyset_node_manager.h"
@@ -70,6 +71,10 @@ struct HeartbeatOptions {
     uint32_t                port;
     uint32_t                intervalSec;
     uint32_t                timeout;
+    // 是否发送增量心跳
+    bool                    enableDelta = false;
+    // 发送增量心跳时，每隔多少次心跳发送一次全量心跳
+    uint32_t                fullHeartbeatInterval = 30;
     CopysetNodeManager*     copysetNodeManager;
 
     std::shared_ptr<LocalFileSystem> fs;
@@ -80,7 +85,7 @@ struct HeartbeatOptions {
  */
 class Heartbeat {
  public:
-    Heartbeat() {}
+    Heartbeat() : deltaCount_(0), needFullHeartbeat_(true) {}
     ~Heartbeat() {}
 
     /**
@@ -130,6 +135,18 @@ class Heartbeat {
      */
     int BuildRequest(HeartbeatRequest* request);
 
+    /*
+     * 构建增量心跳，去掉请求中上次心跳之后没有变化的copyset，并设置所有
+     * copyset的摘要，mds合并后的摘要与chunkserver不一致时会要求发送全量心跳
+     */
+    void BuildDeltaRequest(HeartbeatRequest* request);
+
+    /*
+     * 心跳发送成功后更新已上报的copyset摘要
+     */
+    void OnHeartbeatSent(const HeartbeatRequest& request,
+                         const HeartbeatResponse& response);
+
     /*
      * 发送心跳消息
      */
@@ -186,6 +203,15 @@ class Heartbeat {
 
     // 模块初始化时间, unix时间
     uint64_t startUpTime_;
+
+    // mds已经记录的copyset摘要，key为(logicalPoolId << 32) | copysetId
+    std::unordered_map<uint64_t, uint32_t> reportedCopysets_;
+    // 本次心跳上报的copyset摘要，心跳成功后替换reportedCopysets_
+    std::unordered_map<uint64_t, uint32_t> pendingCopysets_;
+    // 上次全量心跳之后发送的增量心跳个数
+    uint32_t deltaCount_;
+    // 下次心跳是否发送全量心跳
+    bool needFullHeartbeat_;
 };
 
 }  // namespace chunkserver
@@ -138,7 +138,6 @@ bool HeartbeatHelper::ChunkServerLoadCopySetFin(const std::string peerId) {
 
     return rep.copysetloadfin();
 }
-
 }  // namespace chunkserver
 }  // namespace curve
 
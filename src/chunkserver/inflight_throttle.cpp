@@ -0,0 +1,168 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "src/chunkserver/inflight_throttle.h"
+
+namespace curve {
+namespace chunkserver {
+
+const uint64_t InflightThrottle::kAdjustSamples;
+constexpr double InflightThrottle::kDecreaseRatio;
+const uint64_t InflightThrottle::kIncreaseDivisor;
+const uint32_t InflightThrottle::kCopysetSlotNum;
+
+namespace {
+
+InflightThrottleOptions FixedLimitOptions(uint64_t maxInflight) {
+    InflightThrottleOptions options;
+    options.maxInflight = maxInflight;
+    return options;
+}
+
+}  // namespace
+
+InflightThrottle::InflightThrottle(uint64_t maxInflight)
+    : InflightThrottle(FixedLimitOptions(maxInflight)) {}
+
+InflightThrottle::InflightThrottle(const InflightThrottleOptions& options)
+    : options_(options),
+      inflightRequestCount_(0),
+      limit_(options.maxInflight),
+      copysetInflight_(new std::atomic<uint64_t>[kCopysetSlotNum]),
+      latencySumUs_(0),
+      latencyCount_(0),
+      lastAvgLatencyUs_(0) {
+    options_.minInflight = std::min(options_.minInflight,
+                                    options_.maxInflight);
+    options_.copysetPercent = std::min(options_.copysetPercent, 100u);
+    options_.backgroundPercent = std::min(options_.backgroundPercent, 100u);
+    for (uint32_t i = 0; i < kCopysetSlotNum; ++i) {
+        copysetInflight_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool InflightThrottle::IsOverLoad(LogicPoolID logicPoolId,
+                                  CopysetID copysetId) {
+    if (IsOverLoad()) {
+        return true;
+    }
+    if (options_.copysetPercent >= 100) {
+        return false;
+    }
+
+    // 单个copyset不能占满整个chunkserver的inflight，避免热点copyset
+    // 拖慢其他copyset上的请求
+    uint64_t copysetLimit = std::max<uint64_t>(
+        GetLimit() * options_.copysetPercent / 100, 1);
+    return CopysetInflight(logicPoolId, copysetId).load(
+        std::memory_order_relaxed) > copysetLimit;
+}
+
+bool InflightThrottle::IsBackgroundOverLoad() {
+    uint64_t backgroundLimit = GetLimit() * options_.backgroundPercent / 100;
+    return inflightRequestCount_.load(std::memory_order_relaxed) >
+           backgroundLimit;
+}
+
+void InflightThrottle::Increment(LogicPoolID logicPoolId,
+                                 CopysetID copysetId) {
+    Increment();
+    CopysetInflight(logicPoolId, copysetId).fetch_add(
+        1, std::memory_order_relaxed);
+}
+
+void InflightThrottle::Decrement(LogicPoolID logicPoolId,
+                                 CopysetID copysetId) {
+    Decrement();
+    CopysetInflight(logicPoolId, copysetId).fetch_sub(
+        1, std::memory_order_relaxed);
+}
+
+void InflightThrottle::OnLatency(uint64_t latencyUs) {
+    if (!options_.enableAdaptive) {
+        return;
+    }
+
+    latencySumUs_.fetch_add(latencyUs, std::memory_order_relaxed);
+    uint64_t count =
+        latencyCount_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (count != kAdjustSamples) {
+        return;
+    }
+
+    // 重置期间其他线程的统计可能被计入下一个周期，对平均值影响不大
+    uint64_t sum = latencySumUs_.exchange(0, std::memory_order_relaxed);
+    latencyCount_.store(0, std::memory_order_relaxed);
+    Adjust(sum / kAdjustSamples);
+}
+
+void InflightThrottle::Adjust(uint64_t avgLatencyUs) {
+    lastAvgLatencyUs_.store(avgLatencyUs, std::memory_order_relaxed);
+    uint64_t limit = GetLimit();
+    uint64_t newLimit = limit;
+    if (avgLatencyUs > options_.targetLatencyUs) {
+        // 延时超过目标，乘性减小
+        newLimit = std::max(static_cast<uint64_t>(limit * kDecreaseRatio),
+                            options_.minInflight);
+    } else if (inflightRequestCount_.load(std::memory_order_relaxed) * 2 >=
+               limit) {
+        // 延时满足要求且上限已经被用到一半以上，加性增大
+        newLimit = std::min(limit + std::max<uint64_t>(
+                                limit / kIncreaseDivisor, 1),
+                            options_.maxInflight);
+    }
+
+    if (newLimit != limit) {
+        limit_.store(newLimit, std::memory_order_relaxed);
+        VLOG(3) << "inflight limit changed from " << limit
+                << " to " << newLimit
+                << ", average latency: " << avgLatencyUs << "us";
+    }
+}
+
+void InflightThrottle::ExposeMetric(const std::string& prefix) {
+    limitMetric_.reset(new bvar::PassiveStatus<uint64_t>(
+        prefix, "inflight_limit", GetLimitFunc, this));
+    inflightMetric_.reset(new bvar::PassiveStatus<uint64_t>(
+        prefix, "inflight_requests", GetInflightFunc, this));
+    latencyMetric_.reset(new bvar::PassiveStatus<uint64_t>(
+        prefix, "inflight_avg_latency_us", GetLatencyFunc, this));
+}
+
+uint64_t InflightThrottle::GetLimitFunc(void* arg) {
+    return reinterpret_cast<InflightThrottle*>(arg)->GetLimit();
+}
+
+uint64_t InflightThrottle::GetInflightFunc(void* arg) {
+    return reinterpret_cast<InflightThrottle*>(arg)
+        ->inflightRequestCount_.load(std::memory_order_relaxed);
+}
+
+uint64_t InflightThrottle::GetLatencyFunc(void* arg) {
+    return reinterpret_cast<InflightThrottle*>(arg)
+        ->lastAvgLatencyUs_.load(std::memory_order_relaxed);
+}
+
+}  // namespace chunkserver
+}  // namespace curve
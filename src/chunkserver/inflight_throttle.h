@@ -20,8 +20,14 @@
  * Author: wudemiao
  */
 
+#include <bvar/bvar.h>
+
 #include <atomic>
 #include <cstdint>
+#include <memory>
+#include <string>
+
+#include "include/chunkserver/chunkserver_common.h"
 
 #ifndef SRC_CHUNKSERVER_INFLIGHT_THROTTLE_H_
 #define SRC_CHUNKSERVER_INFLIGHT_THROTTLE_H_
@@ -29,14 +35,41 @@
 namespace curve {
 namespace chunkserver {
 
+struct InflightThrottleOptions {
+    // 最大的inflight request数量，不开启自适应时即为固定的上限
+    uint64_t maxInflight;
+    // 是否根据读写请求的延时自适应的调整上限
+    bool enableAdaptive;
+    // 自适应调整时上限的最小值
+    uint64_t minInflight;
+    // 读写请求的目标延时，单位us，平均延时超过目标时减小上限，否则增大上限
+    uint64_t targetLatencyUs;
+    // 单个copyset的inflight数量最多占上限的百分比，为100时不单独限制
+    uint32_t copysetPercent;
+    // inflight数量超过上限的这个百分比时，scrub等后台任务暂停，为前台IO让路
+    uint32_t backgroundPercent;
+
+    InflightThrottleOptions()
+        : maxInflight(5000),
+          enableAdaptive(false),
+          minInflight(64),
+          targetLatencyUs(50000),
+          copysetPercent(100),
+          backgroundPercent(100) {}
+};
+
 /**
  * 负责控制最大inflight request数量
+ *
+ * 开启自适应时按照AIMD调整上限：每统计kAdjustSamples个读写请求的延时调整一次，
+ * 平均延时超过目标延时时上限乘以kDecreaseRatio，否则在上限被用到一半以上时
+ * 增加上限的1/kIncreaseDivisor，上限始终在[minInflight, maxInflight]之间。
+ * 一个chunkserver对应一块盘，所以整体的上限也就是每块盘的上限。
  */
 class InflightThrottle {
  public:
-    explicit InflightThrottle(uint64_t maxInflight)
-        : inflightRequestCount_(0),
-          kMaxInflightRequest_(maxInflight) { }
+    explicit InflightThrottle(uint64_t maxInflight);
+    explicit InflightThrottle(const InflightThrottleOptions& options);
     virtual ~InflightThrottle() = default;
 
     /**
@@ -44,7 +77,7 @@ class InflightThrottle {
      * @return true，过载，false没有过载
      */
     inline bool IsOverLoad() {
-        if (kMaxInflightRequest_ >=
+        if (limit_.load(std::memory_order_relaxed) >=
             inflightRequestCount_.load(std::memory_order_relaxed)) {
             return false;
         } else {
@@ -52,6 +85,18 @@ class InflightThrottle {
         }
     }
 
+    /**
+     * @brief: 判断chunkserver或者请求所在的copyset是否过载
+     * @return true，过载，false没有过载
+     */
+    bool IsOverLoad(LogicPoolID logicPoolId, CopysetID copysetId);
+
+    /**
+     * @brief: 判断后台任务是否需要为前台IO让路
+     * @return true，需要暂停后台任务，false不需要
+     */
+    bool IsBackgroundOverLoad();
+
     /**
      * @brief: inflight request计数加1
      */
@@ -66,11 +111,71 @@ class InflightThrottle {
         inflightRequestCount_.fetch_sub(1, std::memory_order_relaxed);
     }
 
+    /**
+     * @brief: inflight request计数加1，同时统计到请求所在的copyset
+     */
+    void Increment(LogicPoolID logicPoolId, CopysetID copysetId);
+
+    /**
+     * @brief: inflight request计数减1，同时统计到请求所在的copyset
+     */
+    void Decrement(LogicPoolID logicPoolId, CopysetID copysetId);
+
+    /**
+     * @brief: 记录一个读写请求的延时，用于自适应调整上限
+     * @param latencyUs 请求从收到到返回的延时
+     */
+    void OnLatency(uint64_t latencyUs);
+
+    uint64_t GetLimit() {
+        return limit_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief: 以bvar导出上限、inflight数量和平均延时
+     * @param prefix bvar名字的前缀
+     */
+    void ExposeMetric(const std::string& prefix);
+
  private:
+    // 根据当前周期的平均延时调整上限
+    void Adjust(uint64_t avgLatencyUs);
+
+    std::atomic<uint64_t>& CopysetInflight(LogicPoolID logicPoolId,
+                                           CopysetID copysetId) {
+        GroupNid nid = ToGroupNid(logicPoolId, copysetId);
+        return copysetInflight_[nid % kCopysetSlotNum];
+    }
+
+    static uint64_t GetLimitFunc(void* arg);
+    static uint64_t GetInflightFunc(void* arg);
+    static uint64_t GetLatencyFunc(void* arg);
+
+ private:
+    // 每个调整周期统计的请求数
+    static const uint64_t kAdjustSamples = 256;
+    static constexpr double kDecreaseRatio = 0.9;
+    static const uint64_t kIncreaseDivisor = 32;
+    // copyset按照id散列到固定数量的槽中计数，冲突时按照更严格的方式限制
+    static const uint32_t kCopysetSlotNum = 1024;
+
+    InflightThrottleOptions options_;
     // 当前inflight request数量
     std::atomic<uint64_t> inflightRequestCount_;
-    // 最大的inflight request数量
-    const uint64_t kMaxInflightRequest_;
+    // 当前的inflight request上限
+    std::atomic<uint64_t> limit_;
+    // 每个copyset槽的inflight request数量
+    std::unique_ptr<std::atomic<uint64_t>[]> copysetInflight_;
+
+    // 当前调整周期内的延时统计，统计满kAdjustSamples个请求的线程负责调整
+    std::atomic<uint64_t> latencySumUs_;
+    std::atomic<uint64_t> latencyCount_;
+    // 上一个调整周期的平均延时
+    std::atomic<uint64_t> lastAvgLatencyUs_;
+
+    std::unique_ptr<bvar::PassiveStatus<uint64_t>> limitMetric_;
+    std::unique_ptr<bvar::PassiveStatus<uint64_t>> inflightMetric_;
+    std::unique_ptr<bvar::PassiveStatus<uint64_t>> latencyMetric_;
 };
 
 }  // namespace chunkserver
@@ -0,0 +1,105 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <brpc/closure_guard.h>
+#include <brpc/controller.h>
+#include <glog/logging.h>
+
+#include <vector>
+
+#include "src/chunkserver/integrity_service.h"
+
+namespace curve {
+namespace chunkserver {
+
+static void SetStatus(int ret, IntegrityResponse *response) {
+    response->set_status(ret == 0 ?
+        INTEGRITY_OP_STATUS::INTEGRITY_OP_STATUS_SUCCESS :
+        INTEGRITY_OP_STATUS::INTEGRITY_OP_STATUS_FAILURE_UNKNOWN);
+}
+
+void IntegrityServiceImpl::ScheduleJob(RpcController *controller,
+                                       const IntegrityRequest *request,
+                                       IntegrityResponse *response,
+                                       Closure *done) {
+    brpc::ClosureGuard doneGuard(done);
+
+    IntegrityJob job;
+    int ret = scrubManager_->ScheduleJob(request->job().copyset(), &job);
+    SetStatus(ret, response);
+    if (ret == 0) {
+        *response->add_job() = job;
+    }
+    LOG(INFO) << "Schedule integrity job, copyset: "
+              << request->job().copyset() << ", ret: " << ret;
+}
+
+void IntegrityServiceImpl::CancelJob(RpcController *controller,
+                                     const IntegrityRequest *request,
+                                     IntegrityResponse *response,
+                                     Closure *done) {
+    brpc::ClosureGuard doneGuard(done);
+
+    int ret = scrubManager_->CancelJob(request->job().id());
+    SetStatus(ret, response);
+    LOG(INFO) << "Cancel integrity job " << request->job().id()
+              << ", ret: " << ret;
+}
+
+void IntegrityServiceImpl::PauseJob(RpcController *controller,
+                                    const IntegrityRequest *request,
+                                    IntegrityResponse *response,
+                                    Closure *done) {
+    brpc::ClosureGuard doneGuard(done);
+
+    int ret = scrubManager_->PauseJob(request->job().id());
+    SetStatus(ret, response);
+    LOG(INFO) << "Pause integrity job " << request->job().id()
+              << ", ret: " << ret;
+}
+
+void IntegrityServiceImpl::ResumeJob(RpcController *controller,
+                                     const IntegrityRequest *request,
+                                     IntegrityResponse *response,
+                                     Closure *done) {
+    brpc::ClosureGuard doneGuard(done);
+
+    int ret = scrubManager_->ResumeJob(request->job().id());
+    SetStatus(ret, response);
+    LOG(INFO) << "Resume integrity job " << request->job().id()
+              << ", ret: " << ret;
+}
+
+void IntegrityServiceImpl::ListJobs(RpcController *controller,
+                                    const IntegrityRequest *request,
+                                    IntegrityResponse *response,
+                                    Closure *done) {
+    brpc::ClosureGuard doneGuard(done);
+
+    std::vector<IntegrityJob> jobs;
+    scrubManager_->ListJobs(&jobs);
+    for (const auto& job : jobs) {
+        *response->add_job() = job;
+    }
+    SetStatus(0, response);
+}
+
+}  // namespace chunkserver
+}  // namespace curve
@@ -0,0 +1,74 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#ifndef SRC_CHUNKSERVER_INTEGRITY_SERVICE_H_
+#define SRC_CHUNKSERVER_INTEGRITY_SERVICE_H_
+
+#include "proto/integrity.pb.h"
+#include "src/chunkserver/scrub_manager.h"
+
+namespace curve {
+namespace chunkserver {
+
+using ::google::protobuf::RpcController;
+using ::google::protobuf::Closure;
+
+/**
+ * 后台数据校验任务的管理接口，任务由ScrubManager执行
+ * 请求中只有job.id(取消、暂停、恢复)和job.copyset(提交)有意义
+ */
+class IntegrityServiceImpl : public IntegrityService {
+ public:
+    explicit IntegrityServiceImpl(ScrubManager* scrubManager)
+        : scrubManager_(scrubManager) {}
+
+    void ScheduleJob(RpcController *controller,
+                     const IntegrityRequest *request,
+                     IntegrityResponse *response,
+                     Closure *done);
+
+    void CancelJob(RpcController *controller,
+                   const IntegrityRequest *request,
+                   IntegrityResponse *response,
+                   Closure *done);
+
+    void PauseJob(RpcController *controller,
+                  const IntegrityRequest *request,
+                  IntegrityResponse *response,
+                  Closure *done);
+
+    void ResumeJob(RpcController *controller,
+                   const IntegrityRequest *request,
+                   IntegrityResponse *response,
+                   Closure *done);
+
+    void ListJobs(RpcController *controller,
+                  const IntegrityRequest *request,
+                  IntegrityResponse *response,
+                  Closure *done);
+
+ private:
+    ScrubManager *scrubManager_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_INTEGRITY_SERVICE_H_
@@ -29,6 +29,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "src/chunkserver/copyset_node.h"
 #include "src/chunkserver/chunk_closure.h"
@@ -159,6 +160,8 @@ std::shared_ptr<ChunkOpRequest> ChunkOpRequest::Decode(butil::IOBuf log,
             return std::make_shared<WriteChunkRequest>();
         case CHUNK_OP_TYPE::CHUNK_OP_DELETE:
             return std::make_shared<DeleteChunkRequest>();
+        case CHUNK_OP_TYPE::CHUNK_OP_DELETE_BATCH:
+            return std::make_shared<DeleteChunksRequest>();
         case CHUNK_OP_TYPE::CHUNK_OP_READ_SNAP:
             return std::make_shared<ReadSnapshotRequest>();
         case CHUNK_OP_TYPE::CHUNK_OP_DELETE_SNAP:
@@ -167,6 +170,8 @@ std::shared_ptr<ChunkOpRequest> ChunkOpRequest::Decode(butil::IOBuf log,
             return std::make_shared<PasteChunkInternalRequest>();
         case CHUNK_OP_TYPE::CHUNK_OP_CREATE_CLONE:
             return std::make_shared<CreateCloneChunkRequest>();
+        case CHUNK_OP_TYPE::CHUNK_OP_DISCARD:
+            return std::make_shared<DiscardChunkRequest>();
         default:LOG(ERROR) << "Unknown chunk op";
             return nullptr;
     }
@@ -225,6 +230,61 @@ void DeleteChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
     }
 }
 
+void DeleteChunksRequest::OnApply(uint64_t index,
+                                  ::google::protobuf::Closure *done) {
+    brpc::ClosureGuard doneGuard(done);
+
+    std::vector<ChunkID> chunkIds(request_->chunkids().begin(),
+                                  request_->chunkids().end());
+    auto ret = datastore_->DeleteChunks(chunkIds, request_->sn());
+    if (CSErrorCode::Success == ret) {
+        response_->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS);
+        node_->UpdateAppliedIndex(index);
+    } else if (CSErrorCode::InternalError == ret) {
+        LOG(FATAL) << "delete chunks failed: "
+                   << " logic pool id: " << request_->logicpoolid()
+                   << " copyset id: " << request_->copysetid()
+                   << " chunk count: " << request_->chunkids_size()
+                   << " data store return: " << ret;
+    } else {
+        LOG(ERROR) << "delete chunks failed: "
+                   << " logic pool id: " << request_->logicpoolid()
+                   << " copyset id: " << request_->copysetid()
+                   << " chunk count: " << request_->chunkids_size()
+                   << " data store return: " << ret;
+        response_->set_status(
+            CHUNK_OP_STATUS::CHUNK_OP_STATUS_FAILURE_UNKNOWN);
+    }
+    auto maxIndex =
+        (index > node_->GetAppliedIndex() ? index : node_->GetAppliedIndex());
+    response_->set_appliedindex(maxIndex);
+}
+
+void DeleteChunksRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
+                                         const ChunkRequest &request,
+                                         const butil::IOBuf &data) {
+    // NOTE: 处理过程中优先使用参数传入的datastore/request
+    std::vector<ChunkID> chunkIds(request.chunkids().begin(),
+                                  request.chunkids().end());
+    auto ret = datastore->DeleteChunks(chunkIds, request.sn());
+    if (CSErrorCode::Success == ret)
+        return;
+
+    if (CSErrorCode::InternalError == ret) {
+        LOG(FATAL) << "delete chunks failed: "
+                   << request.logicpoolid() << ", "
+                   << request.copysetid()
+                   << " chunk count: " << request.chunkids_size()
+                   << " data store return: " << ret;
+    } else {
+        LOG(ERROR) << "delete chunks failed: "
+                   << request.logicpoolid() << ", "
+                   << request.copysetid()
+                   << " chunk count: " << request.chunkids_size()
+                   << " data store return: " << ret;
+    }
+}
+
 ReadChunkRequest::ReadChunkRequest(std::shared_ptr<CopysetNode> nodePtr,
                                    CloneManager* cloneMgr,
                                    RpcController *cntl,
@@ -283,8 +343,8 @@ void ReadChunkRequest::Process() {
                               thisPtr,
                               node_->GetAppliedIndex(),
                               doneGuard.release());
-        concurrentApplyModule_->Push(
-            request_->chunkid(), request_->optype(), task);
+        concurrentApplyModule_->Push(request_->chunkid(), request_->fileid(),
+                                     request_->optype(), task);
         return;
     }
 
@@ -394,22 +454,17 @@ static void ReadBufferDeleter(void* ptr) {
 }
 
 void ReadChunkRequest::ReadChunk() {
-    char *readBuffer = nullptr;
     size_t size = request_->size();
 
-    readBuffer = new(std::nothrow)char[size];
-    CHECK(nullptr != readBuffer)
-        << "new readBuffer failed " << strerror(errno);
-
-    auto ret = datastore_->ReadChunk(request_->chunkid(),
-                                     request_->sn(),
-                                     readBuffer,
-                                     request_->offset(),
-                                     size);
-    butil::IOBuf wrapper;
-    wrapper.append_user_data(readBuffer, size, ReadBufferDeleter);
+    // 数据直接读到IOBuf池化的block中，不需要为每个请求分配buffer
+    butil::IOBuf readBuffer;
+    auto ret = datastore_->ReadChunkToIOBuf(request_->chunkid(),
+                                            request_->sn(),
+                                            &readBuffer,
+                                            request_->offset(),
+                                            size);
     if (CSErrorCode::Success == ret) {
-        cntl_->response_attachment().append(wrapper);
+        cntl_->response_attachment().append(readBuffer);
         response_->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS);
     } else if (CSErrorCode::ChunkNotExistError == ret) {
         response_->set_status(
@@ -455,6 +510,38 @@ void WriteChunkRequest::OnApply(uint64_t index,
                                       &cost,
                                       cloneSourceLocation);
 
+    OnWriteApplied(index, ret);
+}
+
+void WriteChunkRequest::OnApplyAsync(uint64_t index,
+                                     ::google::protobuf::Closure *done,
+                                     std::function<void()> applied) {
+    std::string  cloneSourceLocation;
+    if (existCloneInfo(request_)) {
+        auto func = ::curve::common::LocationOperator::GenerateCurveLocation;
+        cloneSourceLocation =  func(request_->clonefilesource(),
+                            request_->clonefileoffset());
+    }
+
+    // 回调中持有request，保证写完成之前request不会被释放
+    auto self = std::dynamic_pointer_cast<WriteChunkRequest>(
+        shared_from_this());
+    datastore_->WriteChunkAsync(request_->chunkid(),
+                                request_->sn(),
+                                cntl_->request_attachment(),
+                                request_->offset(),
+                                request_->size(),
+                                cloneSourceLocation,
+        [self, index, done, applied](CSErrorCode ret) {
+            {
+                brpc::ClosureGuard doneGuard(done);
+                self->OnWriteApplied(index, ret);
+            }
+            applied();
+        });
+}
+
+void WriteChunkRequest::OnWriteApplied(uint64_t index, CSErrorCode ret) {
     if (CSErrorCode::Success == ret) {
         response_->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS);
         node_->UpdateAppliedIndex(index);
@@ -518,9 +605,39 @@ void WriteChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
                                      request.size(),
                                      &cost,
                                      cloneSourceLocation);
-     if (CSErrorCode::Success == ret) {
-         return;
-     } else if (CSErrorCode::BackwardRequestError == ret) {
+    OnWriteAppliedFromLog(request, ret);
+}
+
+void WriteChunkRequest::OnApplyFromLogAsync(
+    std::shared_ptr<CSDataStore> datastore,
+    const ChunkRequest &request,
+    const butil::IOBuf &data,
+    std::function<void()> applied) {
+    std::string  cloneSourceLocation;
+    if (existCloneInfo(&request)) {
+        auto func = ::curve::common::LocationOperator::GenerateCurveLocation;
+        cloneSourceLocation =  func(request.clonefilesource(),
+                            request.clonefileoffset());
+    }
+
+    // request在apply任务返回后会被释放，回调中保存一份拷贝
+    datastore->WriteChunkAsync(request.chunkid(),
+                               request.sn(),
+                               data,
+                               request.offset(),
+                               request.size(),
+                               cloneSourceLocation,
+        [request, applied](CSErrorCode ret) {
+            OnWriteAppliedFromLog(request, ret);
+            applied();
+        });
+}
+
+void WriteChunkRequest::OnWriteAppliedFromLog(const ChunkRequest &request,
+                                              CSErrorCode ret) {
+    if (CSErrorCode::Success == ret) {
+        return;
+    } else if (CSErrorCode::BackwardRequestError == ret) {
         LOG(WARNING) << "write failed: "
                      << " logic pool id: " << request.logicpoolid()
                      << " copyset id: " << request.copysetid()
@@ -546,6 +663,84 @@ void WriteChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
     }
 }
 
+void DiscardChunkRequest::OnApply(uint64_t index,
+                                  ::google::protobuf::Closure *done) {
+    brpc::ClosureGuard doneGuard(done);
+
+    auto ret = datastore_->DiscardChunk(request_->chunkid(),
+                                        request_->sn(),
+                                        request_->offset(),
+                                        request_->size());
+    if (CSErrorCode::Success == ret) {
+        response_->set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS);
+        node_->UpdateAppliedIndex(index);
+    } else if (CSErrorCode::DiscardSkippedError == ret) {
+        // 数据没有被释放，告诉客户端不能归还chunk所在的segment
+        response_->set_status(
+            CHUNK_OP_STATUS::CHUNK_OP_STATUS_DISCARD_SKIPPED);
+        node_->UpdateAppliedIndex(index);
+    } else if (CSErrorCode::BackwardRequestError == ret) {
+        // 和写请求一样，返回错误给客户端，让客户端带新版本来重试
+        LOG(WARNING) << "discard failed: "
+                     << " logic pool id: " << request_->logicpoolid()
+                     << " copyset id: " << request_->copysetid()
+                     << " chunkid: " << request_->chunkid()
+                     << " offset: " << request_->offset()
+                     << " size: " << request_->size()
+                     << " data store return: " << ret;
+        response_->set_status(
+            CHUNK_OP_STATUS::CHUNK_OP_STATUS_BACKWARD);
+    } else if (CSErrorCode::InternalError == ret) {
+        LOG(FATAL) << "discard failed: "
+                   << " logic pool id: " << request_->logicpoolid()
+                   << " copyset id: " << request_->copysetid()
+                   << " chunkid: " << request_->chunkid()
+                   << " offset: " << request_->offset()
+                   << " size: " << request_->size()
+                   << " data store return: " << ret;
+    } else {
+        LOG(ERROR) << "discard failed: "
+                   << " logic pool id: " << request_->logicpoolid()
+                   << " copyset id: " << request_->copysetid()
+                   << " chunkid: " << request_->chunkid()
+                   << " offset: " << request_->offset()
+                   << " size: " << request_->size()
+                   << " data store return: " << ret;
+        response_->set_status(
+            CHUNK_OP_STATUS::CHUNK_OP_STATUS_FAILURE_UNKNOWN);
+    }
+    auto maxIndex =
+        (index > node_->GetAppliedIndex() ? index : node_->GetAppliedIndex());
+    response_->set_appliedindex(maxIndex);
+}
+
+void DiscardChunkRequest::OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
+                                         const ChunkRequest &request,
+                                         const butil::IOBuf &data) {
+    // NOTE: 处理过程中优先使用参数传入的datastore/request
+    auto ret = datastore->DiscardChunk(request.chunkid(),
+                                       request.sn(),
+                                       request.offset(),
+                                       request.size());
+    if (CSErrorCode::Success == ret
+        || CSErrorCode::DiscardSkippedError == ret)
+        return;
+
+    if (CSErrorCode::InternalError == ret) {
+        LOG(FATAL) << "discard failed: "
+                   << request.logicpoolid() << ", "
+                   << request.copysetid()
+                   << " chunkid: " << request.chunkid()
+                   << " data store return: " << ret;
+    } else {
+        LOG(ERROR) << "discard failed: "
+                   << request.logicpoolid() << ", "
+                   << request.copysetid()
+                   << " chunkid: " << request.chunkid()
+                   << " data store return: " << ret;
+    }
+}
+
 void ReadSnapshotRequest::OnApply(uint64_t index,
                                   ::google::protobuf::Closure *done) {
     brpc::ClosureGuard doneGuard(done);
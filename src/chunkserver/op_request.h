@@ -27,7 +27,9 @@
 #include <butil/iobuf.h>
 #include <brpc/controller.h>
 
+#include <functional>
 #include <memory>
+#include <vector>
 
 #include "proto/chunk.pb.h"
 #include "include/chunkserver/chunkserver_common.h"
@@ -95,6 +97,37 @@ class ChunkOpRequest : public std::enable_shared_from_this<ChunkOpRequest> {
                                 const ChunkRequest &request,
                                 const butil::IOBuf &data) = 0;
 
+    /**
+     * 异步的OnApply，apply完成时调用applied，之前同一个chunk上后续的
+     * 请求不会被apply，但apply线程不需要等待，applied可能在其他线程中调用
+     * 默认同步执行OnApply之后调用applied
+     * @param index:此op log entry的index
+     * @param done:对应的ChunkClosure
+     * @param applied:apply完成的回调
+     */
+    virtual void OnApplyAsync(uint64_t index,
+                              ::google::protobuf::Closure *done,
+                              std::function<void()> applied) {
+        OnApply(index, done);
+        applied();
+    }
+
+    /**
+     * 异步的OnApplyFromLog，apply完成时调用applied，
+     * 默认同步执行OnApplyFromLog之后调用applied
+     * @param datastore:chunk数据持久化层
+     * @param request:反序列化后得到的request 细信息
+     * @param data:反序列化后得到的request要处理的数据
+     * @param applied:apply完成的回调
+     */
+    virtual void OnApplyFromLogAsync(std::shared_ptr<CSDataStore> datastore,
+                                     const ChunkRequest &request,
+                                     const butil::IOBuf &data,
+                                     std::function<void()> applied) {
+        OnApplyFromLog(datastore, request, data);
+        applied();
+    }
+
     /**
      * 返回request的done成员
      */
@@ -105,11 +138,24 @@ class ChunkOpRequest : public std::enable_shared_from_this<ChunkOpRequest> {
      */
     ChunkID ChunkId() { return request_->chunkid(); }
 
+    /**
+     * 返回批量请求中的所有chunk id
+     */
+    std::vector<ChunkID> ChunkIds() {
+        return std::vector<ChunkID>(request_->chunkids().begin(),
+                                    request_->chunkids().end());
+    }
+
     /**
      * 返回请求类型
      */
     CHUNK_OP_TYPE OpType() { return request_->optype(); }
 
+    /**
+     * 返回请求所属的文件id，老版本client的请求没有携带时返回0
+     */
+    uint64_t FileId() { return request_->fileid(); }
+
     /**
      * 返回请求大小
      */
@@ -199,6 +245,28 @@ class DeleteChunkRequest : public ChunkOpRequest {
                         const butil::IOBuf &data) override;
 };
 
+class DeleteChunksRequest : public ChunkOpRequest {
+ public:
+    DeleteChunksRequest() :
+        ChunkOpRequest() {}
+    DeleteChunksRequest(std::shared_ptr<CopysetNode> nodePtr,
+                        RpcController *cntl,
+                        const ChunkRequest *request,
+                        ChunkResponse *response,
+                        ::google::protobuf::Closure *done) :
+        ChunkOpRequest(nodePtr,
+                       cntl,
+                       request,
+                       response,
+                       done) {}
+    virtual ~DeleteChunksRequest() = default;
+
+    void OnApply(uint64_t index, ::google::protobuf::Closure *done) override;
+    void OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
+                        const ChunkRequest &request,
+                        const butil::IOBuf &data) override;
+};
+
 class ReadChunkRequest : public ChunkOpRequest {
     friend class CloneCore;
     friend class PasteChunkInternalRequest;
@@ -259,6 +327,47 @@ class WriteChunkRequest : public ChunkOpRequest {
     void OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
                         const ChunkRequest &request,
                         const butil::IOBuf &data) override;
+    /**
+     * 数据通过datastore异步写入，写完成后在io完成线程中设置response
+     * 并调用done和applied
+     */
+    void OnApplyAsync(uint64_t index,
+                      ::google::protobuf::Closure *done,
+                      std::function<void()> applied) override;
+    void OnApplyFromLogAsync(std::shared_ptr<CSDataStore> datastore,
+                             const ChunkRequest &request,
+                             const butil::IOBuf &data,
+                             std::function<void()> applied) override;
+
+ private:
+    /**
+     * 根据写的结果设置response
+     */
+    void OnWriteApplied(uint64_t index, CSErrorCode ret);
+    static void OnWriteAppliedFromLog(const ChunkRequest &request,
+                                      CSErrorCode ret);
+};
+
+class DiscardChunkRequest : public ChunkOpRequest {
+ public:
+    DiscardChunkRequest() :
+        ChunkOpRequest() {}
+    DiscardChunkRequest(std::shared_ptr<CopysetNode> nodePtr,
+                        RpcController *cntl,
+                        const ChunkRequest *request,
+                        ChunkResponse *response,
+                        ::google::protobuf::Closure *done) :
+        ChunkOpRequest(nodePtr,
+                       cntl,
+                       request,
+                       response,
+                       done) {}
+    virtual ~DiscardChunkRequest() = default;
+
+    void OnApply(uint64_t index, ::google::protobuf::Closure *done) override;
+    void OnApplyFromLog(std::shared_ptr<CSDataStore> datastore,
+                        const ChunkRequest &request,
+                        const butil::IOBuf &data) override;
 };
 
 class ReadSnapshotRequest : public ChunkOpRequest {
@@ -78,6 +78,16 @@ uint32_t GetDatastoreCloneChunkCountFunc(void* arg) {
     return cloneChunkCount;
 }
 
+uint64_t GetDatastoreUnsyncedBytesFunc(void* arg) {
+    CSDataStore* dataStore = reinterpret_cast<CSDataStore*>(arg);
+    uint64_t unsyncedBytes = 0;
+    if (dataStore != nullptr) {
+        DataStoreStatus status = dataStore->GetStatus();
+        unsyncedBytes = status.unsyncedBytes;
+    }
+    return unsyncedBytes;
+}
+
 uint32_t GetChunkTrashedFunc(void* arg) {
     Trash* trash = reinterpret_cast<Trash*>(arg);
     uint32_t chunkTrashed = 0;
@@ -117,5 +127,15 @@ uint32_t GetTotalCloneChunkCountFunc(void* arg) {
     return cloneChunkCount;
 }
 
+uint64_t GetTotalUnsyncedBytesFunc(void* arg) {
+    uint64_t unsyncedBytes = 0;
+    ChunkServerMetric* csMetric = reinterpret_cast<ChunkServerMetric*>(arg);
+    auto copysetMetricMap = csMetric->GetCopysetMetricMap()->GetMap();
+    for (auto metricPair : copysetMetricMap) {
+        unsyncedBytes += metricPair.second->GetUnsyncedBytes();
+    }
+    return unsyncedBytes;
+}
+
 }  // namespace chunkserver
 }  // namespace curve
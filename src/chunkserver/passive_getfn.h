@@ -45,6 +45,11 @@ namespace chunkserver {
      * @param arg: datastore的对象指针
      */
     uint32_t GetDatastoreCloneChunkCountFunc(void* arg);
+    /**
+     * 获取datastore中已写入但还没有sync到磁盘的字节数
+     * @param arg: datastore的对象指针
+     */
+    uint64_t GetDatastoreUnsyncedBytesFunc(void* arg);
     /**
      * 获取chunkserver上chunk文件的数量
      * @param arg: nullptr
@@ -60,6 +65,11 @@ namespace chunkserver {
      * @param arg: nullptr
      */
     uint32_t GetTotalCloneChunkCountFunc(void* arg);
+    /**
+     * 获取chunkserver上已写入但还没有sync到磁盘的字节数
+     * @param arg: chunkserver metric的对象指针
+     */
+    uint64_t GetTotalUnsyncedBytesFunc(void* arg);
     /**
      * 获取chunkfilepool中剩余chunk的数量
      * @param arg: chunkfilepool的对象指针
@@ -39,8 +39,12 @@
 //          Xiong,Kai(xiongkai@baidu.com)
 
 #include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <bvar/bvar.h>
 #include <butil/fd_utility.h>
 #include <butil/raw_pack.h>
+#include <butil/synchronization/lock.h>
 #include <braft/local_storage.pb.h>
 #include <braft/fsync.h>
 #include "src/chunkserver/raftlog/curve_segment.h"
@@ -52,9 +56,88 @@ namespace chunkserver {
 DEFINE_bool(raftSyncSegments, true, "call fsync when a segment is closed");
 DEFINE_bool(enableWalDirectWrite, true, "enable wal direct write or not");
 DEFINE_uint32(walAlignSize, 4096, "wal align size to write");
+DEFINE_uint32(walBatchBufferSize, 1024 * 1024,
+              "size of the buffer to pack wal entries for direct write");
+DEFINE_uint32(walBatchBufferPoolSize, 32,
+              "max number of the idle wal batch buffers kept in the pool");
 
 std::shared_ptr<FilePool> kWalFilePool = nullptr;
 
+namespace {
+
+// number of entries appended to a segment at one time
+bvar::LatencyRecorder g_wal_batch_entries("raft_wal_batch_entries");
+// bytes written to the segment by one write syscall
+bvar::LatencyRecorder g_wal_write_bytes("raft_wal_write_bytes");
+
+struct WriteBuffer {
+    char* buf;
+    size_t used;
+    bool pooled;
+};
+
+// Pool of the aligned buffers used by direct write, so that appending
+// entries does not need to allocate and free aligned memory every time
+class AlignedBufferPool {
+ public:
+    static AlignedBufferPool* GetInstance() {
+        static AlignedBufferPool pool;
+        return &pool;
+    }
+
+    char* Get() {
+        {
+            BAIDU_SCOPED_LOCK(_mutex);
+            if (!_buffers.empty()) {
+                char* buf = _buffers.back();
+                _buffers.pop_back();
+                return buf;
+            }
+        }
+        char* buf = nullptr;
+        int ret = posix_memalign(reinterpret_cast<void **>(&buf),
+                                 FLAGS_walAlignSize, _buffer_size);
+        LOG_IF(FATAL, ret != 0 || buf == nullptr)
+            << "posix_memalign WAL batch buffer failed " << strerror(ret);
+        return buf;
+    }
+
+    void Put(char* buf) {
+        {
+            BAIDU_SCOPED_LOCK(_mutex);
+            if (_buffers.size() < FLAGS_walBatchBufferPoolSize) {
+                _buffers.push_back(buf);
+                return;
+            }
+        }
+        free(buf);
+    }
+
+    size_t buffer_size() const {
+        return _buffer_size;
+    }
+
+ private:
+    AlignedBufferPool() {
+        // the buffer can hold one aligned entry at least
+        _buffer_size = std::max(FLAGS_walBatchBufferSize, FLAGS_walAlignSize);
+        _buffer_size = (_buffer_size + FLAGS_walAlignSize - 1) /
+                            FLAGS_walAlignSize * FLAGS_walAlignSize;
+    }
+
+    ~AlignedBufferPool() {
+        for (char* buf : _buffers) {
+            free(buf);
+        }
+    }
+
+    size_t _buffer_size;
+    butil::Mutex _mutex;
+    std::vector<char*> _buffers;
+};
+
+}  // namespace
+
 int CurveSegment::create() {
     if (!_is_open) {
         CHECK(false) << "Create on a closed segment at first_index="
@@ -371,25 +454,72 @@ int CurveSegment::_load_entry(off_t offset, EntryHeader* head,
 }
 
 int CurveSegment::append(const braft::LogEntry* entry) {
-    if (BAIDU_UNLIKELY(!entry || !_is_open)) {
+    std::vector<braft::LogEntry*> entries(
+        1, const_cast<braft::LogEntry*>(entry));
+    return append_entries(entries);
+}
+
+int CurveSegment::append_entries(
+                        const std::vector<braft::LogEntry*>& entries) {
+    if (BAIDU_UNLIKELY(entries.empty() || !_is_open)) {
         return EINVAL;
-    } else if (entry->id.index !=
-                    _last_index.load(butil::memory_order_consume) + 1) {
-        CHECK(false) << "entry->index=" << entry->id.index
-                  << " _last_index=" << _last_index
-                  << " _first_index=" << _first_index;
-        return ERANGE;
-    }
-    butil::IOBuf data;
+    }
+    int64_t last_index = _last_index.load(butil::memory_order_consume);
+    std::vector<butil::IOBuf> headers(entries.size());
+    std::vector<butil::IOBuf> datas(entries.size());
+    // the buffered write path drains datas, so the encoded size of every
+    // entry is kept aside for updating the offsets afterwards
+    std::vector<size_t> entry_sizes(entries.size());
+    size_t to_write = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const braft::LogEntry* entry = entries[i];
+        if (BAIDU_UNLIKELY(!entry)) {
+            return EINVAL;
+        } else if (entry->id.index != last_index + 1 + (int64_t)i) {
+            CHECK(false) << "entry->index=" << entry->id.index
+                      << " _last_index=" << _last_index
+                      << " _first_index=" << _first_index;
+            return ERANGE;
+        }
+        char header[kEntryHeaderSize];
+        int ret = _encode_entry(entry, header, &datas[i]);
+        if (ret != 0) {
+            return ret;
+        }
+        headers[i].append(header, kEntryHeaderSize);
+        entry_sizes[i] = kEntryHeaderSize + datas[i].length();
+        to_write += entry_sizes[i];
+    }
+
+    int ret = _write_entries(headers, &datas, to_write);
+    if (ret != 0) {
+        return ret;
+    }
+    g_wal_batch_entries << entries.size();
+    {
+        BAIDU_SCOPED_LOCK(_mutex);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            _offset_and_term.push_back(
+                std::make_pair(_meta.bytes, entries[i]->id.term));
+            _meta.bytes += entry_sizes[i];
+        }
+        _last_index.fetch_add(entries.size(), butil::memory_order_relaxed);
+    }
+    // the meta page is updated only once for the whole batch
+    return _update_meta_page();
+}
+
+int CurveSegment::_encode_entry(const braft::LogEntry* entry,
+                                char* header, butil::IOBuf* data) {
     switch (entry->type) {
     case braft::ENTRY_TYPE_DATA:
-        data.append(entry->data);
+        data->append(entry->data);
         break;
     case braft::ENTRY_TYPE_NO_OP:
         break;
     case braft::ENTRY_TYPE_CONFIGURATION:
         {
-            butil::Status status = serialize_configuration_meta(entry, data);
+            butil::Status status = serialize_configuration_meta(entry, *data);
             if (!status.ok()) {
                 LOG(ERROR) << "Fail to serialize ConfigurationPBMeta, path: "
                            << _path;
@@ -402,72 +532,119 @@ int CurveSegment::append(const braft::LogEntry* entry) {
                    << ", path: " << _path;
         return -1;
     }
-    uint32_t data_check_sum = get_checksum(_checksum_type, data);
-    uint32_t real_length = data.length();
-    size_t to_write = kEntryHeaderSize + data.length();
+    uint32_t data_check_sum = get_checksum(_checksum_type, *data);
+    uint32_t real_length = data->length();
+    size_t to_write = kEntryHeaderSize + data->length();
     uint32_t zero_bytes_num = 0;
     // 4KB alignment
     if (to_write % FLAGS_walAlignSize != 0) {
         zero_bytes_num = (to_write / FLAGS_walAlignSize + 1) *
                                         FLAGS_walAlignSize - to_write;
     }
-    data.resize(data.length() + zero_bytes_num);
-    to_write = kEntryHeaderSize + data.length();
-    CHECK_LE(data.length(), 1ul << 56ul);
-    char* write_buf = nullptr;
-    if (FLAGS_enableWalDirectWrite) {
-        int ret = posix_memalign(reinterpret_cast<void **>(&write_buf),
-                                 FLAGS_walAlignSize, to_write);
-        LOG_IF(FATAL, ret < 0 || write_buf == nullptr)
-        << "posix_memalign WAL write buffer failed " << strerror(ret);
-    } else {
-        write_buf = new char[kEntryHeaderSize];
-    }
+    data->resize(data->length() + zero_bytes_num);
+    CHECK_LE(data->length(), 1ul << 56ul);
 
     const uint32_t meta_field = (entry->type << 24) | (_checksum_type << 16);
-    butil::RawPacker packer(write_buf);
+    butil::RawPacker packer(header);
     packer.pack64(entry->id.term)
           .pack32(meta_field)
-          .pack32((uint32_t)data.length())
+          .pack32((uint32_t)data->length())
           .pack32(real_length)
           .pack32(data_check_sum);
     packer.pack32(get_checksum(
-                  _checksum_type, write_buf, kEntryHeaderSize - 4));
+                  _checksum_type, header, kEntryHeaderSize - 4));
+    return 0;
+}
+
+int CurveSegment::_write_entries(const std::vector<butil::IOBuf>& headers,
+                                 std::vector<butil::IOBuf>* datas,
+                                 size_t to_write) {
     if (FLAGS_enableWalDirectWrite) {
-        data.copy_to(write_buf + kEntryHeaderSize, real_length);
-        int ret = ::pwrite(_direct_fd, write_buf, to_write, _meta.bytes);
-        free(write_buf);
-        if (ret != to_write) {
-            LOG(ERROR) << "Fail to write directly to fd=" << _direct_fd;
+        return _direct_write_entries(headers, *datas);
+    }
+
+    std::vector<butil::IOBuf> pieces(headers);
+    std::vector<butil::IOBuf*> ptrs;
+    ptrs.reserve(headers.size() * 2);
+    for (size_t i = 0; i < headers.size(); ++i) {
+        ptrs.push_back(&pieces[i]);
+        ptrs.push_back(&(*datas)[i]);
+    }
+    size_t start = 0;
+    ssize_t written = 0;
+    while (written < (ssize_t)to_write) {
+        const ssize_t n = butil::IOBuf::cut_multiple_into_file_descriptor(
+                _fd, ptrs.data() + start, ptrs.size() - start);
+        if (n < 0) {
+            LOG(ERROR) << "Fail to write to fd=" << _fd
+                       << ", path: " << _path << berror();
             return -1;
         }
-    } else {
-        butil::IOBuf header;
-        header.append(write_buf, kEntryHeaderSize);
-        delete write_buf;
-        butil::IOBuf* pieces[2] = { &header, &data };
-        size_t start = 0;
-        ssize_t written = 0;
-        while (written < (ssize_t)to_write) {
-            const ssize_t n = butil::IOBuf::cut_multiple_into_file_descriptor(
-                    _fd, pieces + start, ARRAY_SIZE(pieces) - start);
-            if (n < 0) {
-                LOG(ERROR) << "Fail to write to fd=" << _fd
-                           << ", path: " << _path << berror();
-                return -1;
-            }
-            written += n;
-            for (; start < ARRAY_SIZE(pieces) && pieces[start]->empty();
-                    ++start) {}
+        g_wal_write_bytes << n;
+        written += n;
+        for (; start < ptrs.size() && ptrs[start]->empty(); ++start) {}
+    }
+    return 0;
+}
+
+int CurveSegment::_direct_write_entries(
+                                const std::vector<butil::IOBuf>& headers,
+                                const std::vector<butil::IOBuf>& datas) {
+    AlignedBufferPool* pool = AlignedBufferPool::GetInstance();
+    // entries are packed into the pooled buffers, an entry larger than
+    // the pooled buffer gets a buffer of its own
+    std::vector<WriteBuffer> buffers;
+    for (size_t i = 0; i < headers.size(); ++i) {
+        size_t entry_size = kEntryHeaderSize + datas[i].length();
+        if (entry_size > pool->buffer_size()) {
+            char* buf = nullptr;
+            int ret = posix_memalign(reinterpret_cast<void **>(&buf),
+                                     FLAGS_walAlignSize, entry_size);
+            LOG_IF(FATAL, ret != 0 || buf == nullptr)
+                << "posix_memalign WAL write buffer failed " << strerror(ret);
+            buffers.push_back({buf, 0, false});
+        } else if (buffers.empty() || !buffers.back().pooled
+                   || buffers.back().used + entry_size > pool->buffer_size()) {
+            buffers.push_back({pool->Get(), 0, true});
+        }
+        WriteBuffer& buffer = buffers.back();
+        headers[i].copy_to(buffer.buf + buffer.used, kEntryHeaderSize);
+        datas[i].copy_to(buffer.buf + buffer.used + kEntryHeaderSize);
+        buffer.used += entry_size;
+    }
+
+    int rc = 0;
+    off_t offset = _meta.bytes;
+    size_t index = 0;
+    while (index < buffers.size()) {
+        struct iovec iov[IOV_MAX];
+        int iovcnt = 0;
+        size_t expected = 0;
+        for (; index < buffers.size() && iovcnt < IOV_MAX; ++index, ++iovcnt) {
+            iov[iovcnt].iov_base = buffers[index].buf;
+            iov[iovcnt].iov_len = buffers[index].used;
+            expected += buffers[index].used;
         }
+        ssize_t ret = ::pwritev(_direct_fd, iov, iovcnt, offset);
+        if (ret != (ssize_t)expected) {
+            LOG(ERROR) << "Fail to write directly to fd=" << _direct_fd
+                       << ", path: " << _path << ", ret: " << ret
+                       << ", expected: " << expected << berror();
+            rc = -1;
+            break;
+        }
+        g_wal_write_bytes << ret;
+        offset += ret;
     }
-    {
-        BAIDU_SCOPED_LOCK(_mutex);
-        _offset_and_term.push_back(std::make_pair(_meta.bytes, entry->id.term));
-        _last_index.fetch_add(1, butil::memory_order_relaxed);
-        _meta.bytes += to_write;
+
+    for (auto& buffer : buffers) {
+        if (buffer.pooled) {
+            pool->Put(buffer.buf);
+        } else {
+            free(buffer.buf);
+        }
     }
-    return _update_meta_page();
+    return rc;
 }
 
 int CurveSegment::_update_meta_page() {
@@ -59,6 +59,8 @@ namespace curve {
 namespace chunkserver {
 
 DECLARE_bool(enableWalDirectWrite);
+DECLARE_uint32(walAlignSize);
+DECLARE_uint32(walBatchBufferSize);
 
 extern std::shared_ptr<FilePool> kWalFilePool;
 
@@ -108,6 +110,10 @@ class BAIDU_CACHELINE_ALIGNMENT CurveSegment:
     // serialize entry, and append to open segment
     int append(const braft::LogEntry* entry) override;
 
+    // serialize a batch of continuous entries, and append to open segment
+    // with as few writes as possible, the meta page is updated once
+    int append_entries(const std::vector<braft::LogEntry*>& entries) override;
+
     // get entry by index
     braft::LogEntry* get(const int64_t index) const override;
 
@@ -159,6 +165,17 @@ class BAIDU_CACHELINE_ALIGNMENT CurveSegment:
 
     int _update_meta_page();
 
+    // serialize the entry into header and data, data is padded with zero
+    // so that header + data is aligned to walAlignSize
+    int _encode_entry(const braft::LogEntry* entry,
+                      char* header, butil::IOBuf* data);
+
+    // write the encoded entries at the end of the segment
+    int _write_entries(const std::vector<butil::IOBuf>& headers,
+                       std::vector<butil::IOBuf>* datas, size_t to_write);
+    int _direct_write_entries(const std::vector<butil::IOBuf>& headers,
+                              const std::vector<butil::IOBuf>& datas);
+
     std::string _path;
     CurveSegmentMeta _meta;
     mutable braft::raft_mutex_t _mutex;
@@ -46,6 +46,17 @@
 namespace curve {
 namespace chunkserver {
 
+namespace {
+
+// estimate the bytes of the entry written into the segment
+inline size_t aligned_entry_size(const braft::LogEntry* entry) {
+    size_t size = entry->data.size() + kEntryHeaderSize;
+    return (size + FLAGS_walAlignSize - 1) /
+                FLAGS_walAlignSize * FLAGS_walAlignSize;
+}
+
+}  // namespace
+
 void RegisterCurveSegmentLogStorageOrDie() {
     static CurveSegmentLogStorage logStorage;
     braft::log_storage_extension()->RegisterOrDie(
@@ -418,20 +429,32 @@ int CurveSegmentLogStorage::append_entries(
                    << " _last_log_index path: " << _path;
         return -1;
     }
+    const uint32_t maxTotalFileSize = kWalFilePool->GetFilePoolOpt().fileSize
+                                + kWalFilePool->GetFilePoolOpt().metaPageSize;
     scoped_refptr<Segment> last_segment = NULL;
-    for (size_t i = 0; i < entries.size(); i++) {
-        braft::LogEntry* entry = entries[i];
-
-        scoped_refptr<Segment> segment =
-                    open_segment(entry->data.size() + kEntryHeaderSize);
+    size_t appended = 0;
+    while (appended < entries.size()) {
+        size_t to_write = aligned_entry_size(entries[appended]);
+        scoped_refptr<Segment> segment = open_segment(to_write);
         if (NULL == segment) {
-            return i;
+            return appended;
+        }
+        // append the following entries fit in the open segment together
+        std::vector<braft::LogEntry*> batch(1, entries[appended]);
+        for (size_t i = appended + 1; i < entries.size(); ++i) {
+            size_t size = aligned_entry_size(entries[i]);
+            if (segment->bytes() + to_write + size > maxTotalFileSize) {
+                break;
+            }
+            to_write += size;
+            batch.push_back(entries[i]);
         }
-        int ret = segment->append(entry);
+        int ret = segment->append_entries(batch);
         if (0 != ret) {
-            return i;
+            return appended;
         }
-        _last_log_index.fetch_add(1, butil::memory_order_release);
+        _last_log_index.fetch_add(batch.size(), butil::memory_order_release);
+        appended += batch.size();
         last_segment = segment;
     }
     last_segment->sync(_enable_sync);
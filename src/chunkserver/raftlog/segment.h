@@ -27,6 +27,7 @@
 #include <braft/storage.h>
 #include <braft/util.h>
 #include <string>
+#include <vector>
 
 namespace curve {
 namespace chunkserver {
@@ -44,6 +45,17 @@ class Segment : public butil::RefCountedThreadSafe<Segment> {
     // serialize entry, and append to open segment
     virtual int append(const braft::LogEntry* entry) = 0;
 
+    // serialize a batch of continuous entries, and append to open segment
+    virtual int append_entries(const std::vector<braft::LogEntry*>& entries) {
+        for (size_t i = 0; i < entries.size(); ++i) {
+            int ret = append(entries[i]);
+            if (ret != 0) {
+                return ret;
+            }
+        }
+        return 0;
+    }
+
     // get entry by index
     virtual braft::LogEntry* get(const int64_t index) const = 0;
 
@@ -0,0 +1,116 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <fcntl.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include "src/chunkserver/raftsnapshot/curve_file_adaptor.h"
+
+namespace curve {
+namespace chunkserver {
+
+ssize_t CurveZeroFillFileAdaptor::write(const butil::IOBuf& data,
+                                        off_t offset) {
+    ssize_t ret = CurveFileAdaptor::write(data, offset);
+    if (ret <= 0) {
+        return ret;
+    }
+
+    off_t start = offset;
+    off_t end = offset + ret;
+    curve::common::LockGuard lock(mtx_);
+    // 和前后相邻或者重叠的区域合并
+    auto iter = written_.upper_bound(start);
+    if (iter != written_.begin()) {
+        auto prev = std::prev(iter);
+        if (prev->second >= start) {
+            start = prev->first;
+            end = std::max(end, prev->second);
+            iter = written_.erase(prev);
+        }
+    }
+    while (iter != written_.end() && iter->first <= end) {
+        end = std::max(end, iter->second);
+        iter = written_.erase(iter);
+    }
+    written_[start] = end;
+    return ret;
+}
+
+bool CurveZeroFillFileAdaptor::sync() {
+    {
+        curve::common::LockGuard lock(mtx_);
+        if (!written_.empty()) {
+            // 找出最后一次写入之前的空洞，文件末尾之后的区域不需要处理
+            std::vector<std::pair<off_t, off_t>> holes;
+            off_t pos = 0;
+            for (const auto& range : written_) {
+                if (range.first > pos) {
+                    holes.emplace_back(pos, range.first - pos);
+                }
+                pos = range.second;
+            }
+            for (const auto& hole : holes) {
+                int rc = ZeroRange(hole.first, hole.second);
+                if (rc < 0) {
+                    LOG(ERROR) << "Fail to zero range [" << hole.first
+                               << ", " << hole.first + hole.second
+                               << "), fd: " << fd_ << ", rc: " << rc;
+                    return false;
+                }
+            }
+            // 清零之后整个区域都是有效数据，重复sync时不再清零
+            off_t end = written_.rbegin()->second;
+            written_.clear();
+            written_[0] = end;
+        }
+    }
+    return CurveFileAdaptor::sync();
+}
+
+int CurveZeroFillFileAdaptor::ZeroRange(off_t offset, off_t length) {
+    // 只修改extent的状态，不需要写入数据
+    int rc = lfs_->Fallocate(fd_, FALLOC_FL_ZERO_RANGE | FALLOC_FL_KEEP_SIZE,
+                             offset, length);
+    if (rc != -EOPNOTSUPP) {
+        return rc;
+    }
+
+    // 文件系统不支持FALLOC_FL_ZERO_RANGE时写零
+    const off_t kZeroBufSize = 1024 * 1024;
+    std::unique_ptr<char[]> zeroBuf(new char[kZeroBufSize]);
+    memset(zeroBuf.get(), 0, kZeroBufSize);
+    for (off_t off = 0; off < length; off += kZeroBufSize) {
+        off_t len = std::min(kZeroBufSize, length - off);
+        rc = lfs_->Write(fd_, zeroBuf.get(), offset + off, len);
+        if (rc < 0) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+}  // namespace chunkserver
+}  // namespace curve
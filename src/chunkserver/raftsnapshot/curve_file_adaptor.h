@@ -25,6 +25,12 @@
 
 #include <braft/file_system_adaptor.h>
 
+#include <map>
+#include <memory>
+
+#include "src/common/concurrent/concurrent.h"
+#include "src/fs/local_filesystem.h"
+
 namespace curve {
 namespace chunkserver {
 
@@ -37,6 +43,30 @@ class CurveFileAdaptor : public braft::PosixFileAdaptor {
     }
 };
 
+/**
+ * install snapshot时从chunkfilepool中取出的文件，可能是回收的旧文件。
+ * 发送方打开了snapshot_skip_zero_pages时会跳过全零的页(文件末尾的页总是发送)，
+ * 因此记录收到数据的区域，sync时把最后一次写入之前没有收到数据的区域清零
+ */
+class CurveZeroFillFileAdaptor : public CurveFileAdaptor {
+ public:
+    CurveZeroFillFileAdaptor(int fd,
+                             std::shared_ptr<curve::fs::LocalFileSystem> lfs)
+        : CurveFileAdaptor(fd), fd_(fd), lfs_(lfs) {}
+    ssize_t write(const butil::IOBuf& data, off_t offset) override;
+    bool sync() override;
+
+ private:
+    // 把[offset, offset + length)清零，文件大小不变
+    int ZeroRange(off_t offset, off_t length);
+
+    int fd_;
+    std::shared_ptr<curve::fs::LocalFileSystem> lfs_;
+    curve::common::Mutex mtx_;
+    // 已经写入数据的区域，key为起始偏移，value为结束偏移，相邻的区域会合并
+    std::map<off_t, off_t> written_;
+};
+
 }  // namespace chunkserver
 }  // namespace curve
 
@@ -43,12 +43,19 @@
 #include <brpc/closure_guard.h>
 #include <brpc/controller.h>
 #include <braft/util.h>
+#include <bvar/bvar.h>
+#include <algorithm>
+#include <cstring>
 #include <stack>
 #include "src/chunkserver/raftsnapshot/curve_file_service.h"
 
 namespace curve {
 namespace chunkserver {
 
+// 发送snapshot时跳过的全零数据量
+static bvar::Adder<int64_t> g_snapshot_skipped_zero_bytes(
+                            "chunkserver_snapshot_skipped_zero_bytes");
+
 CurveFileService& kCurveFileService = CurveFileService::GetInstance();
 
 void CurveFileService::get_file(::google::protobuf::RpcController* controller,
@@ -172,16 +179,62 @@ void CurveFileService::get_file(::google::protobuf::RpcController* controller,
     }
 
     braft::FileSegData seg_data;
-    seg_data.append(buf, request->offset());
+    // snapshot meta和attach meta由接收方拷贝到内存中，不做稀疏处理
+    if (_skip_zero_pages &&
+        request->filename() != BRAFT_SNAPSHOT_META_FILE &&
+        request->filename() != BRAFT_SNAPSHOT_ATTACH_META_FILE) {
+        append_non_zero_pages(buf, request->offset(), is_eof, &seg_data);
+    } else {
+        seg_data.append(buf, request->offset());
+    }
     cntl->response_attachment().swap(seg_data.data());
 }
 
+void CurveFileService::append_non_zero_pages(const butil::IOBuf& buf,
+                                             off_t offset,
+                                             bool is_eof,
+                                             braft::FileSegData* seg_data) {
+    static const size_t kPageSize = 4096;
+    static const char kZeroPage[kPageSize] = {0};
+    char page[kPageSize];
+    const size_t size = buf.size();
+    // 当前连续的非零区域的起始位置
+    size_t segStart = 0;
+    bool inSeg = false;
+    size_t skipped = 0;
+    for (size_t pos = 0; pos < size; pos += kPageSize) {
+        size_t len = std::min(kPageSize, size - pos);
+        bool isLastPage = (pos + len == size);
+        buf.copy_to(page, len, pos);
+        bool isZero = (memcmp(page, kZeroPage, len) == 0) &&
+                      !(is_eof && isLastPage);
+        if (!isZero && !inSeg) {
+            segStart = pos;
+            inSeg = true;
+        } else if (isZero && inSeg) {
+            butil::IOBuf seg;
+            buf.append_to(&seg, pos - segStart, segStart);
+            seg_data->append(seg, offset + segStart);
+            inSeg = false;
+        }
+        if (isZero) {
+            skipped += len;
+        }
+    }
+    if (inSeg) {
+        butil::IOBuf seg;
+        buf.append_to(&seg, size - segStart, segStart);
+        seg_data->append(seg, offset + segStart);
+    }
+    g_snapshot_skipped_zero_bytes << skipped;
+}
+
 void CurveFileService::set_snapshot_attachment(
                 SnapshotAttachment *snapshot_attachment) {
     _snapshot_attachment = snapshot_attachment;
 }
 
-CurveFileService::CurveFileService() {
+CurveFileService::CurveFileService() : _skip_zero_pages(false) {
     _next_id = ((int64_t)getpid() << 45) |
             (butil::gettimeofday_us() << 17 >> 17);
 }
@@ -42,6 +42,7 @@
 #include <butil/memory/singleton.h>
 #include <braft/file_service.pb.h>
 #include <braft/util.h>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -72,15 +73,31 @@ class BAIDU_CACHELINE_ALIGNMENT CurveFileService : public braft::FileService {
         BAIDU_SCOPED_LOCK(_mutex);
         auto ret = _snapshot_attachment.release();
     }
+    // 发送文件时是否跳过全零的页，接收方需要支持稀疏接收
+    void set_skip_zero_pages(bool skip) {
+        _skip_zero_pages = skip;
+    }
 
  private:
     CurveFileService();
     ~CurveFileService() {}
+    /**
+     * 把读取到的数据按页拆分成多个segment，跳过全零的页，只发送非零的数据。
+     * 接收方按segment的偏移写入，未写入的区域需要由接收方保证为零。
+     * 读到文件末尾时总是发送最后一页，保证接收方的文件长度正确
+     * @param buf 从offset开始读取到的数据
+     * @param offset 数据在文件中的偏移
+     * @param is_eof 是否读到了文件末尾
+     * @param seg_data 返回的segment
+     */
+    void append_non_zero_pages(const butil::IOBuf& buf, off_t offset,
+                               bool is_eof, braft::FileSegData* seg_data);
     typedef std::map<int64_t, scoped_refptr<braft::FileReader> > Map;
     braft::raft_mutex_t _mutex;
     int64_t _next_id;
     Map _reader_map;
     scoped_refptr<SnapshotAttachment> _snapshot_attachment;
+    std::atomic<bool> _skip_zero_pages;
 };
 
 extern CurveFileService &kCurveFileService;
@@ -75,6 +75,7 @@ braft::FileAdaptor* CurveFilesystemAdaptor::open(const std::string& path,
     // 先判断当前文件是否需要过滤，如果需要过滤，就直接走下面逻辑，不走chunkfilepool
     // 如果open操作携带create标志，则从chunkfilepool取，否则保持原来语意
     // 如果待打开的文件已经存在，则直接使用原有语意
+    bool fromPool = false;
     if (!NeedFilter(path) &&
         (oflag & O_CREAT) &&
         false == lfs_->FileExists(path)) {
@@ -87,6 +88,7 @@ braft::FileAdaptor* CurveFilesystemAdaptor::open(const std::string& path,
         } else {
             oflag &= (~O_CREAT);
             oflag &= (~O_TRUNC);
+            fromPool = true;
         }
     }
 
@@ -111,6 +113,12 @@ braft::FileAdaptor* CurveFilesystemAdaptor::open(const std::string& path,
         butil::make_close_on_exec(fd);
     }
 
+    // 发送方可能跳过全零的页，而从chunkfilepool中取出的可能是回收的旧文件，
+    // sync时需要把没有收到数据的区域清零。是否跳过由发送方的配置决定，
+    // 接收方无法得知，所以总是记录收到数据的区域，没有空洞时不会清零
+    if (fromPool) {
+        return new CurveZeroFillFileAdaptor(fd, lfs_);
+    }
     return new CurveFileAdaptor(fd);
 }
 
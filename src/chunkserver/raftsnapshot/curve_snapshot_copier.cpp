@@ -39,15 +39,89 @@
 //          Zheng,Pengfei(zhengpengfei@baidu.com)
 //          Xiong,Kai(xiongkai@baidu.com)
 
+#include <bvar/bvar.h>
+#include <butil/file_util.h>
+
+#include <algorithm>
+
 #include "src/chunkserver/raftsnapshot/curve_snapshot_copier.h"
+#include "src/common/timeutility.h"
 
 namespace curve {
 namespace chunkserver {
 
+// install snapshot的下载进度，所有copyset汇总
+static bvar::Adder<int64_t> g_snapshot_copy_inflight_files(
+                            "chunkserver_snapshot_copy_inflight_files");
+static bvar::Adder<int64_t> g_snapshot_copied_files(
+                            "chunkserver_snapshot_copied_files");
+static bvar::Adder<int64_t> g_snapshot_copied_bytes(
+                            "chunkserver_snapshot_copied_bytes");
+static bvar::PerSecond<bvar::Adder<int64_t>> g_snapshot_copy_bytes_second(
+                            "chunkserver_snapshot_copy_bytes_second",
+                            &g_snapshot_copied_bytes);
+
+// 令牌透支时最多等待这么久就重试，以便及时响应cancel
+static const int64_t kMaxRetryIntervalMs = 100;
+
+CopysetSnapshotThrottle::CopysetSnapshotThrottle(
+        braft::SnapshotThrottle* inner, uint64_t throughputBytes)
+    : _inner(inner)
+    , _bucket(throughputBytes, 0) {}
+
+size_t CopysetSnapshotThrottle::throttled_by_throughput(int64_t bytes) {
+    // 上一次rpc扣除的令牌还没有补充回来，先不发起rpc
+    if (_bucket.Acquire(0) > 0) {
+        return 0;
+    }
+    size_t available = bytes;
+    if (_inner) {
+        available = _inner->throttled_by_throughput(bytes);
+        if (available == 0) {
+            return 0;
+        }
+    }
+    // 允许透支，rpc的大小可能超过一秒的令牌数，透支的部分由后面的rpc等待
+    _bucket.Acquire(available);
+    return available;
+}
+
+bool CopysetSnapshotThrottle::add_one_more_task(bool is_leader) {
+    return _inner ? _inner->add_one_more_task(is_leader) : true;
+}
+
+void CopysetSnapshotThrottle::finish_one_task(bool is_leader) {
+    if (_inner) {
+        _inner->finish_one_task(is_leader);
+    }
+}
+
+int64_t CopysetSnapshotThrottle::get_retry_interval_ms() {
+    int64_t waitMs = _bucket.Acquire(0) / 1000;
+    waitMs = std::max<int64_t>(1, std::min(waitMs, kMaxRetryIntervalMs));
+    if (_inner) {
+        waitMs = std::max(waitMs, _inner->get_retry_interval_ms());
+    }
+    return waitMs;
+}
+
+void CopysetSnapshotThrottle::return_unused_throughput(int64_t acquired,
+        int64_t consumed, int64_t elapsed_time_us) {
+    // 文件末尾或者rpc失败时，未用完的令牌留给后面的rpc
+    if (acquired > consumed) {
+        _bucket.Return(acquired - consumed);
+    }
+    if (_inner) {
+        _inner->return_unused_throughput(acquired, consumed,
+                                         elapsed_time_us);
+    }
+}
+
 CurveSnapshotCopier::CurveSnapshotCopier(CurveSnapshotStorage* storage,
                                          bool filter_before_copy_remote,
                                          braft::FileSystemAdaptor* fs,
-                                         braft::SnapshotThrottle* throttle)
+                                         braft::SnapshotThrottle* throttle,
+                            const CurveSnapshotCopierOptions& options)
     : _tid(INVALID_BTHREAD)
     , _cancelled(false)
     , _filter_before_copy_remote(filter_before_copy_remote)
@@ -56,8 +130,17 @@ CurveSnapshotCopier::CurveSnapshotCopier(CurveSnapshotStorage* storage,
     , _writer(NULL)
     , _storage(storage)
     , _reader(NULL)
-    , _cur_session(NULL)
-{}
+    , _options(options)
+    , _copied_files(0)
+    , _copied_bytes(0) {
+    if (_options.copyConcurrency == 0) {
+        _options.copyConcurrency = 1;
+    }
+    if (_options.throughputBytes > 0) {
+        _copyset_throttle = new CopysetSnapshotThrottle(
+                                    throttle, _options.throughputBytes);
+    }
+}
 
 CurveSnapshotCopier::~CurveSnapshotCopier() {
     CHECK(!_writer);
@@ -70,6 +153,7 @@ void *CurveSnapshotCopier::start_copy(void* arg) {
 }
 
 void CurveSnapshotCopier::copy() {
+    uint64_t startUs = curve::common::TimeUtility::GetTimeofDayUs();
     do {
         // 下载snapshot meta中记录的文件
         load_meta_table();
@@ -82,8 +166,9 @@ void CurveSnapshotCopier::copy() {
         }
         std::vector<std::string> files;
         _remote_snapshot.list_files(&files);
-        for (size_t i = 0; i < files.size() && ok(); ++i) {
-            copy_file(files[i]);
+        copy_files(files, false);
+        if (!ok()) {
+            break;
         }
 
         // 下载snapshot attachment文件
@@ -93,10 +178,14 @@ void CurveSnapshotCopier::copy() {
         }
         std::vector<std::string> attachFiles;
         _remote_snapshot.list_attach_files(&attachFiles);
-        for (size_t i = 0; i < attachFiles.size() && ok(); ++i) {
-            copy_file(attachFiles[i], true);
-        }
+        copy_files(attachFiles, true);
     } while (0);
+    LOG(INFO) << "Copy snapshot " << (ok() ? "success" : "failed")
+              << ", copied files: " << _copied_files
+              << ", copied bytes: " << _copied_bytes
+              << ", cost: "
+              << (curve::common::TimeUtility::GetTimeofDayUs() - startUs) / 1000
+              << "ms";
     if (!ok() && _writer && _writer->ok()) {
         LOG(WARNING) << "Fail to copy, error_code " << error_code()
                      << " error_msg " << error_cstr()
@@ -126,11 +215,11 @@ void CurveSnapshotCopier::load_meta_table() {
     scoped_refptr<braft::RemoteFileCopier::Session> session
             = _copier.start_to_copy_to_iobuf(BRAFT_SNAPSHOT_META_FILE,
                                             &meta_buf, NULL);
-    _cur_session = session.get();
+    _sessions.insert(session.get());
     lck.unlock();
     session->join();
     lck.lock();
-    _cur_session = NULL;
+    _sessions.erase(session.get());
     lck.unlock();
     if (!session->status().ok()) {
         LOG(WARNING) << "Fail to copy meta file : " << session->status();
@@ -156,11 +245,11 @@ void CurveSnapshotCopier::load_attach_meta_table() {
     scoped_refptr<braft::RemoteFileCopier::Session> session
         = _copier.start_to_copy_to_iobuf(BRAFT_SNAPSHOT_ATTACH_META_FILE,
                                          &meta_buf, NULL);
-    _cur_session = session.get();
+    _sessions.insert(session.get());
     lck.unlock();
     session->join();
     lck.lock();
-    _cur_session = NULL;
+    _sessions.erase(session.get());
     lck.unlock();
     if (!session->status().ok()) {
         LOG(WARNING) << "Fail to copy attach meta file : " << session->status();
@@ -305,11 +394,43 @@ void CurveSnapshotCopier::filter() {
     }
 }
 
-void CurveSnapshotCopier::copy_file(const std::string& filename, bool attch) {
+void CurveSnapshotCopier::copy_files(const std::vector<std::string>& files,
+                                     bool attach) {
+    std::deque<FileCopyTask> inflight;
+    for (size_t i = 0; i < files.size() && ok(); ++i) {
+        if (inflight.size() >= _options.copyConcurrency) {
+            finish_copy_file(&inflight.front());
+            inflight.pop_front();
+            if (!ok()) {
+                break;
+            }
+        }
+        FileCopyTask task;
+        if (start_copy_file(files[i], attach, &task)) {
+            inflight.push_back(task);
+        }
+    }
+
+    // 出错时取消其余的下载，但仍然要等待它们结束才能关闭writer
+    if (!ok()) {
+        BAIDU_SCOPED_LOCK(_mutex);
+        for (auto& task : inflight) {
+            task.session->cancel();
+        }
+    }
+    while (!inflight.empty()) {
+        finish_copy_file(&inflight.front());
+        inflight.pop_front();
+    }
+}
+
+bool CurveSnapshotCopier::start_copy_file(const std::string& filename,
+                                          bool attach,
+                                          FileCopyTask* task) {
     if (_writer->get_file_meta(filename, NULL) == 0) {
         LOG(INFO) << "Skipped downloading " << filename
                   << " path: " << _writer->get_path();
-        return;
+        return false;
     }
     std::string rfilename = get_rfilename(filename);
     std::string file_path = _writer->get_path() + '/' + rfilename;
@@ -333,30 +454,38 @@ void CurveSnapshotCopier::copy_file(const std::string& filename, bool attch) {
                       "Fail to create directory");
         }
     }
-    braft::LocalFileMeta meta;
-    _remote_snapshot.get_file_meta(filename, &meta);
+    task->filename = filename;
+    task->file_path = file_path;
+    task->attach = attach;
+    _remote_snapshot.get_file_meta(filename, &task->meta);
     std::unique_lock<braft::raft_mutex_t> lck(_mutex);
     if (_cancelled) {
         set_error(ECANCELED, "%s", berror(ECANCELED));
-        return;
+        return false;
     }
-    scoped_refptr<braft::RemoteFileCopier::Session> session
-        = _copier.start_to_copy_to_file(filename, file_path, NULL);
-    if (session == NULL) {
+    task->session = _copier.start_to_copy_to_file(filename, file_path, NULL);
+    if (task->session == NULL) {
         LOG(WARNING) << "Fail to copy " << filename
                      << " path: " << _writer->get_path();
         set_error(-1, "Fail to copy %s", filename.c_str());
-        return;
+        return false;
     }
-    _cur_session = session.get();
-    lck.unlock();
-    session->join();
-    lck.lock();
-    _cur_session = NULL;
+    _sessions.insert(task->session.get());
+    g_snapshot_copy_inflight_files << 1;
+    return true;
+}
+
+void CurveSnapshotCopier::finish_copy_file(FileCopyTask* task) {
+    task->session->join();
+    std::unique_lock<braft::raft_mutex_t> lck(_mutex);
+    _sessions.erase(task->session.get());
     lck.unlock();
-    if (!session->status().ok()) {
+    g_snapshot_copy_inflight_files << -1;
+
+    const std::string& file_path = task->file_path;
+    if (!task->session->status().ok()) {
         // 如果是文件不存在，那么删除刚开始open的文件
-        if (session->status().error_code() == ENOENT) {
+        if (task->session->status().error_code() == ENOENT) {
             bool rc = _fs->delete_file(file_path, false);
             if (!rc) {
                 LOG(ERROR) << "Fail to delete file" << file_path
@@ -367,12 +496,29 @@ void CurveSnapshotCopier::copy_file(const std::string& filename, bool attch) {
             return;
         }
 
-        set_error(session->status().error_code(),
-                  session->status().error_cstr());
+        // 已经出错时保留第一个错误
+        if (ok()) {
+            set_error(task->session->status().error_code(),
+                      task->session->status().error_cstr());
+        }
+        return;
+    }
+    if (!ok()) {
         return;
     }
+
+    // chunk文件是从chunkfilepool中预分配的，按照本地文件的大小统计，
+    // 是实际传输数据量的上限。限流已经在每次rpc之前完成，这里只统计进度
+    int64_t size = 0;
+    if (butil::GetFileSize(butil::FilePath(file_path), &size)) {
+        _copied_bytes += size;
+        g_snapshot_copied_bytes << size;
+    }
+    ++_copied_files;
+    g_snapshot_copied_files << 1;
+
     // 如果是attach file，那么不需要持久化file meta信息
-    if (!attch && _writer->add_file(filename, &meta) != 0) {
+    if (!task->attach && _writer->add_file(task->filename, &task->meta) != 0) {
         set_error(EIO, "Fail to add file to writer");
         return;
     }
@@ -411,12 +557,15 @@ void CurveSnapshotCopier::cancel() {
         return;
     }
     _cancelled = true;
-    if (_cur_session) {
-        _cur_session->cancel();
+    for (auto session : _sessions) {
+        session->cancel();
     }
 }
 
 int CurveSnapshotCopier::init(const std::string& uri) {
+    if (_copyset_throttle) {
+        return _copier.init(uri, _fs, _copyset_throttle.get());
+    }
     return _copier.init(uri, _fs, _throttle);
 }
 
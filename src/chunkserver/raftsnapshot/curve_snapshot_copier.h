@@ -43,22 +43,49 @@
 #define SRC_CHUNKSERVER_RAFTSNAPSHOT_CURVE_SNAPSHOT_COPIER_H_
 
 #include <braft/storage.h>
+#include <braft/snapshot_throttle.h>
+#include <deque>
+#include <memory>
+#include <set>
 #include <vector>
 #include <string>
 #include "src/chunkserver/raftsnapshot/curve_snapshot.h"
 #include "src/chunkserver/raftsnapshot/curve_snapshot_storage.h"
+#include "src/common/token_bucket.h"
 
 namespace curve {
 namespace chunkserver {
 
 class CurveSnapshotStorage;
 
+// 单个copyset下载snapshot的限流，braft的session在每次发起GetFile rpc之前
+// 调用throttled_by_throughput，因此令牌在读取数据之前扣除。
+// inner为chunkserver整体的snapshot throttle，可以为空
+class CopysetSnapshotThrottle : public braft::SnapshotThrottle {
+ public:
+    CopysetSnapshotThrottle(braft::SnapshotThrottle* inner,
+                            uint64_t throughputBytes);
+    // 令牌透支时返回0，由session在get_retry_interval_ms之后重试，
+    // 否则先由inner限流，再按照实际允许的字节数扣除令牌
+    size_t throttled_by_throughput(int64_t bytes) override;
+    bool add_one_more_task(bool is_leader) override;
+    void finish_one_task(bool is_leader) override;
+    int64_t get_retry_interval_ms() override;
+    void return_unused_throughput(int64_t acquired, int64_t consumed,
+                                  int64_t elapsed_time_us) override;
+
+ private:
+    scoped_refptr<braft::SnapshotThrottle> _inner;
+    curve::common::TokenBucket _bucket;
+};
+
 class CurveSnapshotCopier : public braft::SnapshotCopier {
  public:
     CurveSnapshotCopier(CurveSnapshotStorage* storage,
                         bool filter_before_copy_remote,
                         braft::FileSystemAdaptor* fs,
-                        braft::SnapshotThrottle* throttle);
+                        braft::SnapshotThrottle* throttle,
+                        const CurveSnapshotCopierOptions& options);
     ~CurveSnapshotCopier();
     virtual void cancel();
     virtual void join();
@@ -67,6 +94,15 @@ class CurveSnapshotCopier : public braft::SnapshotCopier {
     int init(const std::string& uri);
 
  private:
+    // 正在下载的文件
+    struct FileCopyTask {
+        std::string filename;
+        std::string file_path;
+        bool attach;
+        braft::LocalFileMeta meta;
+        scoped_refptr<braft::RemoteFileCopier::Session> session;
+    };
+
     static void* start_copy(void* arg);
     void copy();
     void load_meta_table();
@@ -74,7 +110,13 @@ class CurveSnapshotCopier : public braft::SnapshotCopier {
     int filter_before_copy(CurveSnapshotWriter* writer,
                            braft::SnapshotReader* last_snapshot);
     void filter();
-    void copy_file(const std::string& filename, bool attach = false);
+    // 以copyConcurrency为窗口并发下载files，按发起的顺序等待下载完成
+    void copy_files(const std::vector<std::string>& files, bool attach);
+    // 发起文件的下载，文件已经存在或者发起失败时返回false
+    bool start_copy_file(const std::string& filename, bool attach,
+                         FileCopyTask* task);
+    // 等待文件下载完成，并把文件加入writer
+    void finish_copy_file(FileCopyTask* task);
     // 这里的filename是相对于快照目录的路径，为了先把文件下载到临时目录，需要把前面的..去掉
     std::string get_rfilename(const std::string& filename);
 
@@ -87,9 +129,16 @@ class CurveSnapshotCopier : public braft::SnapshotCopier {
     CurveSnapshotWriter* _writer;
     CurveSnapshotStorage* _storage;
     braft::SnapshotReader* _reader;
-    braft::RemoteFileCopier::Session* _cur_session;
+    // 所有正在进行的下载，cancel时需要全部取消
+    std::set<braft::RemoteFileCopier::Session*> _sessions;
     CurveSnapshot _remote_snapshot;
     braft::RemoteFileCopier _copier;
+    CurveSnapshotCopierOptions _options;
+    // copyset的带宽上限，throughputBytes为0时为空，直接使用_throttle
+    scoped_refptr<CopysetSnapshotThrottle> _copyset_throttle;
+    // 下载进度
+    size_t _copied_files;
+    int64_t _copied_bytes;
 };
 }  // namespace chunkserver
 }  // namespace curve
@@ -55,6 +55,7 @@ void RegisterCurveSnapshotStorageOrDie() {
 }
 
 butil::EndPoint CurveSnapshotStorage::_addr;
+CurveSnapshotCopierOptions CurveSnapshotStorage::_copier_options;
 
 const char* CurveSnapshotStorage::_s_temp_path = "temp";
 
@@ -191,7 +192,8 @@ braft::SnapshotWriter* CurveSnapshotStorage::create(bool from_empty) {
 braft::SnapshotCopier* CurveSnapshotStorage::start_to_copy_from(
                                         const std::string& uri) {
     CurveSnapshotCopier* copier = new CurveSnapshotCopier(this,
-            _filter_before_copy_remote, _fs.get(), _snapshot_throttle.get());
+            _filter_before_copy_remote, _fs.get(), _snapshot_throttle.get(),
+            _copier_options);
     if (copier->init(uri) != 0) {
         LOG(ERROR) << "Fail to init copier from " << uri
                    << " path: " << _path;
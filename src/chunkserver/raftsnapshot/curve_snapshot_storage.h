@@ -88,6 +88,10 @@ friend class CurveSnapshotCopier;
         _addr = server_addr;
     }
     static bool has_server_addr() { return _addr != butil::EndPoint(); }
+    static void set_copier_options(
+                    const CurveSnapshotCopierOptions& options) {
+        _copier_options = options;
+    }
 
  private:
     braft::SnapshotWriter* create(bool from_empty) WARN_UNUSED_RESULT;
@@ -104,6 +108,7 @@ friend class CurveSnapshotCopier;
     scoped_refptr<braft::FileSystemAdaptor> _fs;
     scoped_refptr<braft::SnapshotThrottle> _snapshot_throttle;
     static butil::EndPoint _addr;
+    static CurveSnapshotCopierOptions _copier_options;
 };
 
 }  // namespace chunkserver
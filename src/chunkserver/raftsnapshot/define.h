@@ -23,6 +23,8 @@
 #ifndef SRC_CHUNKSERVER_RAFTSNAPSHOT_DEFINE_H_
 #define SRC_CHUNKSERVER_RAFTSNAPSHOT_DEFINE_H_
 
+#include <stdint.h>
+
 namespace curve {
 namespace chunkserver {
 
@@ -38,6 +40,18 @@ const char RAFT_LOG_DIR[]  = "log";
 #define BRAFT_SNAPSHOT_ATTACH_META_FILE "__raft_snapshot_attach_meta"
 #define BRAFT_PROTOBUF_FILE_TEMP ".tmp"
 
+struct CurveSnapshotCopierOptions {
+    // 同时下载的文件数，为1时逐个文件下载
+    uint32_t copyConcurrency;
+    // 单个copyset下载snapshot的带宽上限，单位byte/s，为0表示不限制，
+    // chunkserver整体的带宽由snapshot throttle限制
+    uint64_t throughputBytes;
+
+    CurveSnapshotCopierOptions()
+        : copyConcurrency(1),
+          throughputBytes(0) {}
+};
+
 }  // namespace chunkserver
 }  // namespace curve
 
@@ -0,0 +1,537 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <glog/logging.h>
+#include <brpc/channel.h>
+#include <brpc/controller.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+
+#include "proto/chunk.pb.h"
+#include "src/chunkserver/scrub_manager.h"
+#include "src/common/timeutility.h"
+
+namespace curve {
+namespace chunkserver {
+
+using curve::common::LockGuard;
+using curve::common::UniqueLock;
+using curve::common::TimeUtility;
+
+// 最多保留的已结束任务数
+const size_t kMaxFinishedJobs = 1024;
+// 前台请求过载时的等待间隔
+const uint32_t kOverloadWaitMs = 10;
+
+static bool IsFinished(INTEGRITY_JOB_STATE state) {
+    return state == INTEGRITY_OP_STATE_CANCELED ||
+           state == INTEGRITY_OP_STATE_FINISHED ||
+           state == INTEGRITY_OP_STATE_FAILED;
+}
+
+int ScrubPeerClient::GetChunkHash(const butil::EndPoint& peer,
+                                  LogicPoolID logicPoolId,
+                                  CopysetID copysetId,
+                                  ChunkID chunkId,
+                                  off_t offset,
+                                  size_t length,
+                                  std::string* hash,
+                                  CHUNK_HASH_VERSION* version) {
+    ChannelPtr channel;
+    if (channelPool_.GetOrInitChannel(butil::endpoint2str(peer).c_str(),
+                                      &channel) != 0) {
+        LOG(ERROR) << "Init channel to " << butil::endpoint2str(peer)
+                   << " failed";
+        return -1;
+    }
+
+    ChunkService_Stub stub(channel.get());
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(timeoutMs_);
+    GetChunkHashRequest request;
+    GetChunkHashResponse response;
+    request.set_logicpoolid(logicPoolId);
+    request.set_copysetid(copysetId);
+    request.set_chunkid(chunkId);
+    request.set_offset(offset);
+    request.set_length(length);
+    request.set_hashversion(CHUNK_HASH_VERSION::CHUNK_HASH_VERSION_DATA);
+    stub.GetChunkHash(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+        LOG(WARNING) << "Get chunk hash from " << butil::endpoint2str(peer)
+                     << " failed, error: " << cntl.ErrorText();
+        return -1;
+    }
+    if (response.status() != CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS) {
+        LOG(WARNING) << "Get chunk hash from " << butil::endpoint2str(peer)
+                     << " failed, status: " << response.status();
+        return -1;
+    }
+
+    *hash = response.hash();
+    *version = response.hashversion();
+    return 0;
+}
+
+ScrubManager::ScrubManager()
+    : nextJobId_(1),
+      running_(false) {}
+
+ScrubManager::~ScrubManager() {
+    Fini();
+}
+
+int ScrubManager::Init(const ScrubOptions& options) {
+    if (options.copysetNodeManager == nullptr) {
+        LOG(ERROR) << "Init scrub manager failed, copyset node manager is null";
+        return -1;
+    }
+    if (options.readSize == 0 || options.readSize > options.chunkSize) {
+        LOG(ERROR) << "Init scrub manager failed, invalid read size: "
+                   << options.readSize;
+        return -1;
+    }
+
+    options_ = options;
+    peerClient_ = options.peerClient;
+    if (peerClient_ == nullptr) {
+        peerClient_ = std::make_shared<ScrubPeerClient>();
+    }
+    peerClient_->SetTimeout(options.rpcTimeoutMs);
+    // 桶的容量为一次读取的大小，避免空闲一段时间后突发大量读取
+    bucket_.reset(new TokenBucket(options.bytesPerSecond, options.readSize));
+    return 0;
+}
+
+int ScrubManager::Run() {
+    running_ = true;
+    thread_ = curve::common::Thread(&ScrubManager::ScrubFunc, this);
+    LOG(INFO) << "Scrub manager started, read size: " << options_.readSize
+              << ", bytes per second: " << options_.bytesPerSecond;
+    return 0;
+}
+
+int ScrubManager::Fini() {
+    if (!running_.exchange(false)) {
+        return 0;
+    }
+
+    {
+        LockGuard lock(mtx_);
+        cond_.notify_all();
+    }
+    sleeper_.interrupt();
+    thread_.join();
+    LOG(INFO) << "Scrub manager stopped";
+    return 0;
+}
+
+int ScrubManager::ScheduleJob(CopysetID copysetId, IntegrityJob* job) {
+    std::vector<CopysetNodePtr> nodes;
+    options_.copysetNodeManager->GetAllCopysetNodes(&nodes);
+    bool exist = std::any_of(nodes.begin(), nodes.end(),
+        [copysetId](const CopysetNodePtr& node) {
+            return node->GetCopysetId() == copysetId;
+        });
+    if (!exist) {
+        LOG(WARNING) << "Schedule scrub job failed, copyset " << copysetId
+                     << " not found";
+        return -1;
+    }
+
+    auto newJob = std::make_shared<IntegrityJob>();
+    LockGuard lock(mtx_);
+    newJob->set_id(nextJobId_++);
+    newJob->set_copyset(copysetId);
+    newJob->set_state(INTEGRITY_OP_STATE_WAITING);
+    newJob->set_progress(0);
+    newJob->set_sched_time(TimeUtility::GetTimeofDaySec());
+    newJob->set_start_time(0);
+    newJob->set_inconsistent_chunks(0);
+    jobs_.push_back(newJob);
+    TrimFinishedJobs();
+    cond_.notify_all();
+
+    *job = *newJob;
+    LOG(INFO) << "Schedule scrub job " << job->id()
+              << ", copyset: " << copysetId;
+    return 0;
+}
+
+int ScrubManager::CancelJob(int32_t jobId) {
+    LockGuard lock(mtx_);
+    ScrubJobPtr job = FindJob(jobId);
+    if (job == nullptr || IsFinished(job->state())) {
+        return -1;
+    }
+    job->set_state(INTEGRITY_OP_STATE_CANCELED);
+    // 唤醒等待恢复的任务
+    cond_.notify_all();
+    LOG(INFO) << "Cancel scrub job " << jobId;
+    return 0;
+}
+
+int ScrubManager::PauseJob(int32_t jobId) {
+    LockGuard lock(mtx_);
+    ScrubJobPtr job = FindJob(jobId);
+    if (job == nullptr ||
+        (job->state() != INTEGRITY_OP_STATE_WAITING &&
+         job->state() != INTEGRITY_OP_STATE_RUNNING)) {
+        return -1;
+    }
+    job->set_state(INTEGRITY_OP_STATE_PAUSED);
+    LOG(INFO) << "Pause scrub job " << jobId;
+    return 0;
+}
+
+int ScrubManager::ResumeJob(int32_t jobId) {
+    LockGuard lock(mtx_);
+    ScrubJobPtr job = FindJob(jobId);
+    if (job == nullptr || job->state() != INTEGRITY_OP_STATE_PAUSED) {
+        return -1;
+    }
+    // 还没有开始执行的任务重新排队
+    job->set_state(job->start_time() == 0 ? INTEGRITY_OP_STATE_WAITING
+                                          : INTEGRITY_OP_STATE_RUNNING);
+    cond_.notify_all();
+    LOG(INFO) << "Resume scrub job " << jobId;
+    return 0;
+}
+
+void ScrubManager::ListJobs(std::vector<IntegrityJob>* jobs) {
+    LockGuard lock(mtx_);
+    jobs->clear();
+    for (const auto& job : jobs_) {
+        jobs->push_back(*job);
+    }
+}
+
+void ScrubManager::ScrubFunc() {
+    while (running_) {
+        ScrubJobPtr job;
+        {
+            UniqueLock lock(mtx_);
+            cond_.wait(lock, [this, &job]() {
+                job = NextWaitingJob();
+                return !running_ || job != nullptr;
+            });
+            if (!running_) {
+                break;
+            }
+            job->set_state(INTEGRITY_OP_STATE_RUNNING);
+            job->set_start_time(TimeUtility::GetTimeofDaySec());
+        }
+
+        ScrubCopyset(job);
+    }
+}
+
+void ScrubManager::ScrubCopyset(const ScrubJobPtr& job) {
+    int32_t jobId;
+    CopysetID copysetId;
+    {
+        LockGuard lock(mtx_);
+        jobId = job->id();
+        copysetId = job->copyset();
+    }
+
+    std::vector<CopysetNodePtr> allNodes;
+    std::vector<CopysetNodePtr> nodes;
+    options_.copysetNodeManager->GetAllCopysetNodes(&allNodes);
+    for (const auto& node : allNodes) {
+        if (node->GetCopysetId() == copysetId) {
+            nodes.push_back(node);
+        }
+    }
+    if (nodes.empty()) {
+        LOG(ERROR) << "Scrub job " << jobId << " failed, copyset "
+                   << copysetId << " not found";
+        FinishJob(job, INTEGRITY_OP_STATE_FAILED);
+        return;
+    }
+
+    // 不同逻辑池中相同id的copyset都属于这个任务
+    std::vector<std::vector<ChunkID>> chunks(nodes.size());
+    size_t total = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i]->GetDataStore()->ListChunks(&chunks[i]);
+        total += chunks[i].size();
+    }
+
+    size_t scrubbed = 0;
+    int32_t inconsistent = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        const CopysetNodePtr& node = nodes[i];
+        std::vector<Peer> members;
+        std::vector<butil::EndPoint> peers;
+        node->ListPeers(&members);
+        for (const auto& member : members) {
+            PeerId peerId;
+            if (peerId.parse(member.address()) != 0) {
+                LOG(ERROR) << "Scrub job " << jobId << " failed, "
+                           << "invalid peer: " << member.address();
+                FinishJob(job, INTEGRITY_OP_STATE_FAILED);
+                return;
+            }
+            if (peerId.addr != options_.localAddr) {
+                peers.push_back(peerId.addr);
+            }
+        }
+
+        for (ChunkID chunkId : chunks[i]) {
+            if (!WaitIfPaused(job)) {
+                return;
+            }
+
+            // 克隆chunk未写过的区域还没有从源端拷贝，各副本的内容可能不同
+            CSChunkInfo info;
+            CSErrorCode ret = node->GetDataStore()->GetChunkInfo(chunkId,
+                                                                 &info);
+            bool skip = (ret == CSErrorCode::ChunkNotExistError) ||
+                        (ret == CSErrorCode::Success && info.isClone);
+            for (uint32_t offset = 0;
+                 !skip && offset < options_.chunkSize;
+                 offset += options_.readSize) {
+                size_t length = std::min(options_.readSize,
+                                         options_.chunkSize - offset);
+                SliceResult result = CheckSlice(job, node, peers, chunkId,
+                                                offset, length);
+                switch (result) {
+                case SliceResult::Consistent:
+                    break;
+                case SliceResult::Inconsistent:
+                    LOG(ERROR) << "Scrub job " << jobId
+                               << " found inconsistent chunk, "
+                               << ToGroupIdString(node->GetLogicPoolId(),
+                                                  copysetId)
+                               << ", chunk id: " << chunkId
+                               << ", offset: " << offset
+                               << ", length: " << length;
+                    ++inconsistent;
+                    skip = true;
+                    break;
+                case SliceResult::Deleted:
+                    skip = true;
+                    break;
+                case SliceResult::Failed:
+                    LOG(ERROR) << "Scrub job " << jobId << " failed, "
+                               << ToGroupIdString(node->GetLogicPoolId(),
+                                                  copysetId)
+                               << ", chunk id: " << chunkId;
+                    FinishJob(job, INTEGRITY_OP_STATE_FAILED);
+                    return;
+                case SliceResult::Stopped:
+                    return;
+                }
+            }
+
+            ++scrubbed;
+            SetProgress(job, scrubbed * 100 / total, inconsistent);
+        }
+    }
+
+    SetProgress(job, 100, inconsistent);
+    FinishJob(job, inconsistent > 0 ? INTEGRITY_OP_STATE_FAILED
+                                    : INTEGRITY_OP_STATE_FINISHED);
+    LOG(INFO) << "Scrub job " << jobId << " finished, copyset: " << copysetId
+              << ", chunks: " << total
+              << ", inconsistent chunks: " << inconsistent;
+}
+
+ScrubManager::SliceResult ScrubManager::CheckSlice(
+    const ScrubJobPtr& job,
+    const CopysetNodePtr& node,
+    const std::vector<butil::EndPoint>& peers,
+    ChunkID chunkId,
+    off_t offset,
+    size_t length) {
+    for (uint32_t retry = 0; ; ++retry) {
+        // 每个副本都要读取length大小的数据计算hash，一起计入令牌桶
+        if (!Throttle(length * (peers.size() + 1))) {
+            return SliceResult::Stopped;
+        }
+
+        std::string localHash;
+        CSErrorCode ret = node->GetDataStore()->GetChunkDataHash(chunkId,
+                                                                 offset,
+                                                                 length,
+                                                                 &localHash);
+        if (ret == CSErrorCode::ChunkNotExistError) {
+            return SliceResult::Deleted;
+        } else if (ret != CSErrorCode::Success) {
+            LOG(ERROR) << "Get local chunk hash failed, chunk id: "
+                       << chunkId << ", offset: " << offset
+                       << ", length: " << length << ", ret: " << ret;
+            return SliceResult::Failed;
+        }
+
+        // 升级过程中老版本的副本按chunk文件的偏移计算hash，
+        // 本地按相同的方式重新计算后再比较
+        std::string localFileHash;
+        bool rpcFailed = false;
+        bool consistent = true;
+        for (const auto& peer : peers) {
+            std::string hash;
+            CHUNK_HASH_VERSION version =
+                CHUNK_HASH_VERSION::CHUNK_HASH_VERSION_DATA;
+            if (peerClient_->GetChunkHash(peer, node->GetLogicPoolId(),
+                                          node->GetCopysetId(), chunkId,
+                                          offset, length, &hash,
+                                          &version) != 0) {
+                rpcFailed = true;
+                break;
+            }
+
+            const std::string* expected = &localHash;
+            if (version != CHUNK_HASH_VERSION::CHUNK_HASH_VERSION_DATA) {
+                if (localFileHash.empty()) {
+                    if (!Throttle(length)) {
+                        return SliceResult::Stopped;
+                    }
+                    ret = node->GetDataStore()->GetChunkHash(chunkId,
+                                                             offset,
+                                                             length,
+                                                             &localFileHash);
+                    if (ret == CSErrorCode::ChunkNotExistError) {
+                        return SliceResult::Deleted;
+                    } else if (ret != CSErrorCode::Success) {
+                        LOG(ERROR) << "Get local chunk file hash failed, "
+                                   << "chunk id: " << chunkId
+                                   << ", offset: " << offset
+                                   << ", length: " << length
+                                   << ", ret: " << ret;
+                        return SliceResult::Failed;
+                    }
+                }
+                expected = &localFileHash;
+            }
+
+            if (hash != *expected) {
+                LOG(WARNING) << "Chunk hash mismatch, chunk id: " << chunkId
+                             << ", offset: " << offset
+                             << ", length: " << length
+                             << ", local hash: " << *expected
+                             << ", peer: " << butil::endpoint2str(peer)
+                             << ", peer hash: " << hash
+                             << ", hash version: " << version
+                             << ", retry: " << retry;
+                consistent = false;
+                break;
+            }
+        }
+
+        if (!rpcFailed && consistent) {
+            return SliceResult::Consistent;
+        }
+        if (retry >= options_.retryTimes) {
+            return rpcFailed ? SliceResult::Failed
+                             : SliceResult::Inconsistent;
+        }
+
+        // 不一致可能是由于各副本apply写请求的进度不同，等待后重新比较
+        if (!sleeper_.wait_for(
+                std::chrono::milliseconds(options_.retryIntervalMs))) {
+            return SliceResult::Stopped;
+        }
+        if (!WaitIfPaused(job)) {
+            return SliceResult::Stopped;
+        }
+    }
+}
+
+bool ScrubManager::WaitIfPaused(const ScrubJobPtr& job) {
+    UniqueLock lock(mtx_);
+    cond_.wait(lock, [this, &job]() {
+        return !running_ || job->state() != INTEGRITY_OP_STATE_PAUSED;
+    });
+    return running_ && job->state() == INTEGRITY_OP_STATE_RUNNING;
+}
+
+bool ScrubManager::Throttle(size_t length) {
+    uint64_t waitUs = bucket_->Acquire(length);
+    if (waitUs > 0 &&
+        !sleeper_.wait_for(std::chrono::microseconds(waitUs))) {
+        return false;
+    }
+
+    // 前台请求较多时让出磁盘
+    while (options_.inflightThrottle != nullptr &&
+           options_.inflightThrottle->IsBackgroundOverLoad()) {
+        if (!sleeper_.wait_for(std::chrono::milliseconds(kOverloadWaitMs))) {
+            return false;
+        }
+    }
+    return running_;
+}
+
+void ScrubManager::SetProgress(const ScrubJobPtr& job,
+                               int32_t progress,
+                               int32_t inconsistentChunks) {
+    LockGuard lock(mtx_);
+    job->set_progress(progress);
+    job->set_inconsistent_chunks(inconsistentChunks);
+}
+
+void ScrubManager::FinishJob(const ScrubJobPtr& job,
+                             INTEGRITY_JOB_STATE state) {
+    LockGuard lock(mtx_);
+    // 已经取消的任务保持取消状态
+    if (!IsFinished(job->state())) {
+        job->set_state(state);
+    }
+}
+
+ScrubManager::ScrubJobPtr ScrubManager::NextWaitingJob() {
+    for (const auto& job : jobs_) {
+        if (job->state() == INTEGRITY_OP_STATE_WAITING) {
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+ScrubManager::ScrubJobPtr ScrubManager::FindJob(int32_t jobId) {
+    for (const auto& job : jobs_) {
+        if (job->id() == jobId) {
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void ScrubManager::TrimFinishedJobs() {
+    size_t finished = std::count_if(jobs_.begin(), jobs_.end(),
+        [](const ScrubJobPtr& job) {
+            return IsFinished(job->state());
+        });
+    for (auto iter = jobs_.begin();
+         iter != jobs_.end() && finished > kMaxFinishedJobs;) {
+        if (IsFinished((*iter)->state())) {
+            iter = jobs_.erase(iter);
+            --finished;
+        } else {
+            ++iter;
+        }
+    }
+}
+
+}  // namespace chunkserver
+}  // namespace curve
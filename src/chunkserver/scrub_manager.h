@@ -0,0 +1,219 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#ifndef SRC_CHUNKSERVER_SCRUB_MANAGER_H_
+#define SRC_CHUNKSERVER_SCRUB_MANAGER_H_
+
+#include <butil/endpoint.h>
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "proto/chunk.pb.h"
+#include "proto/integrity.pb.h"
+#include "src/chunkserver/copyset_node_manager.h"
+#include "src/chunkserver/inflight_throttle.h"
+#include "src/common/channel_pool.h"
+#include "src/common/concurrent/concurrent.h"
+#include "src/common/interruptible_sleeper.h"
+#include "src/common/token_bucket.h"
+
+namespace curve {
+namespace chunkserver {
+
+using curve::common::InterruptibleSleeper;
+using curve::common::TokenBucket;
+using CopysetNodePtr = std::shared_ptr<CopysetNode>;
+
+/**
+ * 获取其他副本上chunk的hash
+ */
+class ScrubPeerClient {
+ public:
+    virtual ~ScrubPeerClient() = default;
+
+    /**
+     * @brief 通过ChunkService获取peer上chunk指定区域的hash
+     * @param peer 副本所在的chunkserver
+     * @param hash 返回的hash，chunk不存在时为"0"
+     * @param version 返回hash的计算方式，老版本的chunkserver只支持
+     *        CHUNK_HASH_VERSION_FILE
+     * @return 成功返回0，失败返回-1
+     */
+    virtual int GetChunkHash(const butil::EndPoint& peer,
+                             LogicPoolID logicPoolId,
+                             CopysetID copysetId,
+                             ChunkID chunkId,
+                             off_t offset,
+                             size_t length,
+                             std::string* hash,
+                             CHUNK_HASH_VERSION* version);
+
+    void SetTimeout(uint32_t timeoutMs) {
+        timeoutMs_ = timeoutMs;
+    }
+
+ private:
+    uint32_t timeoutMs_ = 5000;
+    // 按peer地址缓存channel，避免每次比较都重新建立连接
+    curve::common::ChannelPool channelPool_;
+};
+
+struct ScrubOptions {
+    CopysetNodeManager* copysetNodeManager;
+    // 本chunkserver的地址，比较时跳过自己
+    butil::EndPoint localAddr;
+    uint32_t chunkSize;
+    // 每次读取和比较的数据大小，需要4KB对齐
+    uint32_t readSize;
+    // 读取限速，单位byte/s，为0表示不限速，包括其他副本上的读取
+    uint64_t bytesPerSecond;
+    // hash不一致时的重试次数和间隔，用于排除写入中的数据导致的误报
+    uint32_t retryTimes;
+    uint32_t retryIntervalMs;
+    // 获取其他副本hash的rpc超时时间
+    uint32_t rpcTimeoutMs;
+    // 前台请求的inflight限制，过载时暂停扫描，可以为nullptr
+    std::shared_ptr<InflightThrottle> inflightThrottle;
+    // 为nullptr时使用默认的ScrubPeerClient
+    std::shared_ptr<ScrubPeerClient> peerClient;
+
+    ScrubOptions()
+        : copysetNodeManager(nullptr),
+          chunkSize(16 * 1024 * 1024),
+          readSize(4 * 1024 * 1024),
+          bytesPerSecond(20 * 1024 * 1024),
+          retryTimes(3),
+          retryIntervalMs(1000),
+          rpcTimeoutMs(5000),
+          inflightThrottle(nullptr),
+          peerClient(nullptr) {}
+};
+
+/**
+ * 后台数据校验，实现IntegrityService的任务管理
+ *
+ * 每个任务校验一个copyset：按chunk id顺序遍历本地的所有chunk，每次读取
+ * readSize大小的数据计算crc，并通过GetChunkHash获取其他副本相同区域的
+ * crc进行比较，顺序的大块读取避免了逐个chunk随机读的开销。
+ * 读取速度由令牌桶限制，其他副本为计算hash的读取也计入令牌桶，
+ * 前台请求过载时暂停扫描，为前台IO让路。
+ * 任务由一个后台线程按提交顺序逐个执行，可以暂停、恢复和取消。
+ */
+class ScrubManager {
+ public:
+    ScrubManager();
+    virtual ~ScrubManager();
+
+    int Init(const ScrubOptions& options);
+
+    int Run();
+
+    int Fini();
+
+    /**
+     * @brief 提交校验任务
+     * @param copysetId 要校验的copyset
+     * @param job 返回提交的任务
+     * @return 成功返回0，copyset不存在返回-1
+     */
+    int ScheduleJob(CopysetID copysetId, IntegrityJob* job);
+
+    /**
+     * @brief 取消、暂停、恢复任务
+     * @return 成功返回0，任务不存在或者状态不允许返回-1
+     */
+    int CancelJob(int32_t jobId);
+    int PauseJob(int32_t jobId);
+    int ResumeJob(int32_t jobId);
+
+    /**
+     * @brief 列出所有任务，包括已经结束的任务
+     */
+    void ListJobs(std::vector<IntegrityJob>* jobs);
+
+ private:
+    // 任务的状态由mtx_保护
+    using ScrubJobPtr = std::shared_ptr<IntegrityJob>;
+
+    enum class SliceResult {
+        Consistent,
+        Inconsistent,
+        // chunk在校验过程中被删除
+        Deleted,
+        Failed,
+        // 任务被取消或者manager退出
+        Stopped,
+    };
+
+    void ScrubFunc();
+
+    void ScrubCopyset(const ScrubJobPtr& job);
+
+    SliceResult CheckSlice(const ScrubJobPtr& job,
+                           const CopysetNodePtr& node,
+                           const std::vector<butil::EndPoint>& peers,
+                           ChunkID chunkId,
+                           off_t offset,
+                           size_t length);
+
+    // 任务暂停时等待恢复，任务取消或者manager退出时返回false
+    bool WaitIfPaused(const ScrubJobPtr& job);
+
+    // 按照令牌桶和前台负载等待，manager退出时返回false
+    bool Throttle(size_t length);
+
+    void SetProgress(const ScrubJobPtr& job,
+                     int32_t progress,
+                     int32_t inconsistentChunks);
+
+    void FinishJob(const ScrubJobPtr& job, INTEGRITY_JOB_STATE state);
+
+    // 取出下一个等待执行的任务，调用方需要持有mtx_
+    ScrubJobPtr NextWaitingJob();
+
+    // 调用方需要持有mtx_
+    ScrubJobPtr FindJob(int32_t jobId);
+
+    // 清理过多的已结束任务，调用方需要持有mtx_
+    void TrimFinishedJobs();
+
+ private:
+    ScrubOptions options_;
+    std::shared_ptr<ScrubPeerClient> peerClient_;
+    std::unique_ptr<TokenBucket> bucket_;
+
+    curve::common::Mutex mtx_;
+    curve::common::ConditionVariable cond_;
+    // 所有任务，按提交顺序排列
+    std::list<ScrubJobPtr> jobs_;
+    int32_t nextJobId_;
+
+    curve::common::Atomic<bool> running_;
+    curve::common::Thread thread_;
+    InterruptibleSleeper sleeper_;
+};
+
+}  // namespace chunkserver
+}  // namespace curve
+
+#endif  // SRC_CHUNKSERVER_SCRUB_MANAGER_H_
@@ -173,8 +173,14 @@ void ClientClosure::Run() {
     bool needRetry = false;
 
     if (cntl_->Failed()) {
-        needRetry = true;
-        OnRpcFailed();
+        // 旧版本chunkserver没有discard接口，discard只是提示，不用重试
+        if (reqCtx_->optype_ == OpType::DISCARD &&
+            cntlstatus_ == brpc::ENOMETHOD) {
+            OnDiscardSkipped();
+        } else {
+            needRetry = true;
+            OnRpcFailed();
+        }
     } else {
         // 只要rpc正常返回，就清空超时计数器
         metaCache_->GetUnstableHelper().ClearTimeout(
@@ -213,7 +219,8 @@ void ClientClosure::Run() {
 
         // 2.5 返回backward
         case CHUNK_OP_STATUS::CHUNK_OP_STATUS_BACKWARD:
-            if (reqCtx_->optype_ == OpType::WRITE) {
+            if (reqCtx_->optype_ == OpType::WRITE ||
+                reqCtx_->optype_ == OpType::DISCARD) {
                 needRetry = true;
                 OnBackward();
             } else {
@@ -234,6 +241,11 @@ void ClientClosure::Run() {
             OnChunkExist();
             break;
 
+        // 2.7 discard没有释放chunk的数据，直接返回，不用重试
+        case CHUNK_OP_STATUS::CHUNK_OP_STATUS_DISCARD_SKIPPED:
+            OnDiscardSkipped();
+            break;
+
         default:
             needRetry = true;
             LOG(WARNING) << OpTypeToString(reqCtx_->optype_)
@@ -279,7 +291,8 @@ void ClientClosure::OnRpcFailed() {
         << butil::endpoint2str(cntl_->remote_side()).c_str();
 
     // it will be invoked in brpc's bthread
-    if (reqCtx_->optype_ == OpType::WRITE) {
+    if (reqCtx_->optype_ == OpType::WRITE ||
+        reqCtx_->optype_ == OpType::DISCARD) {
         metaCache_->UpdateAppliedIndex(
             chunkIdInfo_.lpid_, chunkIdInfo_.cpid_, 0);
     }
@@ -343,6 +356,20 @@ void ClientClosure::OnChunkNotExist() {
         fileMetric_, reqCtx_->rawlength_, reqCtx_->optype_);
 }
 
+void ClientClosure::OnDiscardSkipped() {
+    // 对用户来说discard是成功的，但是chunk所在的segment不能归还给mds
+    reqDone_->SetFailed(CHUNK_OP_STATUS::CHUNK_OP_STATUS_DISCARD_SKIPPED);
+
+    LOG_EVERY_SECOND(WARNING) << OpTypeToString(reqCtx_->optype_)
+        << " skipped, " << *reqCtx_
+        << ", status=" << status_
+        << ", rpc error code: " << cntlstatus_
+        << ", IO id = " << reqDone_->GetIOTracker()->GetID()
+        << ", request id = " << reqCtx_->id_
+        << ", remote side = "
+        << butil::endpoint2str(cntl_->remote_side()).c_str();
+}
+
 void ClientClosure::OnChunkExist() {
     reqDone_->SetFailed(status_);
 
@@ -485,6 +512,22 @@ void WriteChunkClosure::OnSuccess() {
         response_->appliedindex());
 }
 
+void DiscardChunkClosure::SendRetryRequest() {
+    client_->DiscardChunk(reqCtx_->idinfo_, reqCtx_->seq_,
+                          reqCtx_->offset_,
+                          reqCtx_->rawlength_,
+                          done_);
+}
+
+void DiscardChunkClosure::OnSuccess() {
+    ClientClosure::OnSuccess();
+
+    metaCache_->UpdateAppliedIndex(
+        chunkIdInfo_.lpid_,
+        chunkIdInfo_.cpid_,
+        response_->appliedindex());
+}
+
 void ReadChunkClosure::SendRetryRequest() {
     client_->ReadChunk(reqCtx_->idinfo_, reqCtx_->seq_,
                        reqCtx_->offset_,
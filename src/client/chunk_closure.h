@@ -110,6 +110,9 @@ class ClientClosure : public Closure {
     // 返回chunk存在 处理函数
     void OnChunkExist();
 
+    // discard没有释放数据，包括chunkserver不支持discard的情况
+    void OnDiscardSkipped();
+
     // 非法参数
     void OnInvalidRequest();
 
@@ -241,6 +244,15 @@ class WriteChunkClosure : public ClientClosure {
     void SendRetryRequest() override;
 };
 
+class DiscardChunkClosure : public ClientClosure {
+ public:
+    DiscardChunkClosure(CopysetClient* client, Closure* done)
+        : ClientClosure(client, done) {}
+
+    void OnSuccess() override;
+    void SendRetryRequest() override;
+};
+
 class ReadChunkClosure : public ClientClosure {
  public:
     ReadChunkClosure(CopysetClient* client, Closure* done)
@@ -56,6 +56,7 @@ enum class OpType {
     CREATE_CLONE,
     RECOVER_CHUNK,
     GET_CHUNK_INFO,
+    DISCARD,
     UNKNOWN
 };
 
@@ -122,6 +123,16 @@ typedef struct SegmentInfo {
     LogicalPoolCopysetIDInfo lpcpIDInfo;
 } SegmentInfo_t;
 
+// 文件的QoS限制，由mds下发，为0表示不限制
+struct ThrottleParams {
+    uint64_t iopsLimit = 0;
+    // 允许的突发，为0时等于limit
+    uint64_t iopsBurst = 0;
+    // 单位byte/s
+    uint64_t bpsLimit = 0;
+    uint64_t bpsBurst = 0;
+};
+
 typedef struct FInfo {
     uint64_t        id;
     uint64_t        parentid;
@@ -140,6 +151,7 @@ typedef struct FInfo {
     FileStatus      filestatus;
     std::string     cloneSource;
     uint64_t        cloneLength{0};
+    ThrottleParams  throttleParams;
 
     FInfo() {
         id = 0;
@@ -218,6 +230,8 @@ inline const char* OpTypeToString(OpType optype) {
         return "RecoverChunk";
     case OpType::GET_CHUNK_INFO:
         return "GetChunkInfo";
+    case OpType::DISCARD:
+        return "Discard";
     case OpType::UNKNOWN:
     default:
         return "Unknown";
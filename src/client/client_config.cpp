@@ -120,6 +120,12 @@ int ClientConfig::Init(const char* configpath) {
         &fileServiceOption_.ioOpt.ioSenderOpt.failRequestOpt.chunkserverMaxRetryTimesBeforeConsiderSuspend);   // NOLINT
     LOG_IF(ERROR, ret == false) << "config no chunkserver.maxRetryTimesBeforeConsiderSuspend info";             // NOLINT
 
+    ret = conf_.GetBoolValue("global.enableDiscard",
+        &fileServiceOption_.ioOpt.discardOpt.enableDiscard);
+    LOG_IF(WARNING, ret == false)
+        << "config no global.enableDiscard info, using default value "
+        << fileServiceOption_.ioOpt.discardOpt.enableDiscard;
+
     ret = conf_.GetUInt64Value("global.fileMaxInFlightRPCNum",
         &fileServiceOption_.ioOpt.ioSenderOpt.inflightOpt.fileMaxInFlightRPCNum);   // NOLINT
     LOG_IF(ERROR, ret == false) << "config no global.fileMaxInFlightRPCNum info";   // NOLINT
@@ -140,6 +146,27 @@ int ClientConfig::Init(const char* configpath) {
     LOG_IF(ERROR, ret == false) << "config no metacache.getLeaderTimeOutMS info";   // NOLINT
     RETURN_IF_FALSE(ret);
 
+    ret = conf_.GetBoolValue("metacache.enableSegmentPrefetch",
+        &fileServiceOption_.ioOpt.segmentPrefetchOpt.enableSegmentPrefetch);
+    LOG_IF(WARNING, ret == false)
+        << "config no metacache.enableSegmentPrefetch info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.segmentPrefetchOpt.enableSegmentPrefetch;
+
+    ret = conf_.GetUInt32Value("metacache.prefetchSegmentNum",
+        &fileServiceOption_.ioOpt.segmentPrefetchOpt.prefetchSegmentNum);
+    LOG_IF(WARNING, ret == false)
+        << "config no metacache.prefetchSegmentNum info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.segmentPrefetchOpt.prefetchSegmentNum;
+
+    ret = conf_.GetBoolValue("metacache.prefetchAllocateSegment",
+        &fileServiceOption_.ioOpt.segmentPrefetchOpt.prefetchAllocateSegment);
+    LOG_IF(WARNING, ret == false)
+        << "config no metacache.prefetchAllocateSegment info, "
+        << "using default value "
+        << fileServiceOption_.ioOpt.segmentPrefetchOpt.prefetchAllocateSegment;
+
     ret = conf_.GetUInt32Value("schedule.queueCapacity",
         &fileServiceOption_.ioOpt.reqSchdulerOpt.scheduleQueueCapacity);
     LOG_IF(ERROR, ret == false) << "config no schedule.queueCapacity info";
@@ -120,6 +120,9 @@ struct FileMetric {
     // 当前文件上的悬挂IO数量
     IOSuspendMetric suspendRPCMetric;
 
+    // QoS限速导致用户IO等待的总时间，单位us
+    bvar::Adder<uint64_t> throttleWaitUs;
+
     explicit FileMetric(const std::string& name)
         : filename(name),
           inflightRPCNum(prefix, filename + "_inflight_rpc_num"),
@@ -130,7 +133,8 @@ struct FileMetric {
           userRead(prefix, filename + "_read"),
           userWrite(prefix, filename + "_write"),
           getLeaderRetryQPS(prefix, filename + "_get_leader_retry_rpc"),
-          suspendRPCMetric(prefix, filename + "_suspend_io_num") {}
+          suspendRPCMetric(prefix, filename + "_suspend_io_num"),
+          throttleWaitUs(prefix, filename + "_throttle_wait_us") {}
 };
 
 // 用于全局mds接口统计信息调用信息统计
@@ -155,6 +159,10 @@ struct MDSClientMetric {
     InterfaceMetric getServerList;
     // GetOrAllocateSegment接口统计信息
     InterfaceMetric getOrAllocateSegment;
+    // DeAllocateSegment接口统计信息
+    InterfaceMetric deAllocateSegment;
+    // GetSegments接口统计信息
+    InterfaceMetric getSegments;
     // RenameFile接口统计信息
     InterfaceMetric renameFile;
     // Extend接口统计信息
@@ -185,6 +193,8 @@ struct MDSClientMetric {
           refreshSession(prefix, "refreshSession"),
           getServerList(prefix, "getServerList"),
           getOrAllocateSegment(prefix, "getOrAllocateSegment"),
+          deAllocateSegment(prefix, "deAllocateSegment"),
+          getSegments(prefix, "getSegments"),
           renameFile(prefix, "renameFile"),
           extendFile(prefix, "extendFile"),
           deleteFile(prefix, "deleteFile"),
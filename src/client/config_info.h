@@ -223,6 +223,30 @@ struct CloseFdThreadOption {
     uint32_t fdCloseTimeInterval = 600;
 };
 
+/**
+ * segment元数据预取配置信息
+ * 检测到顺序IO时，提前批量从mds获取后续segment的chunk信息以及copyset的leader，
+ * 避免IO第一次访问segment时同步查询mds。
+ * @enableSegmentPrefetch: 是否开启预取
+ * @prefetchSegmentNum: 预取当前segment之后的segment数量
+ * @prefetchAllocateSegment: 顺序写时是否让mds在预取时分配还未分配的segment
+ */
+struct SegmentPrefetchOption {
+    bool enableSegmentPrefetch = false;
+    uint32_t prefetchSegmentNum = 4;
+    bool prefetchAllocateSegment = false;
+};
+
+/**
+ * discard配置信息
+ * @enableDiscard: 是否将discard请求下发到chunkserver，关闭时discard
+ *                 直接返回成功。旧版本chunkserver不能识别discard请求，
+ *                 只有在所有chunkserver都升级之后才能开启
+ */
+struct DiscardOption {
+    bool enableDiscard = false;
+};
+
 /**
  * IOOption存储了当前io 操作所需要的所有配置信息
  */
@@ -233,6 +257,8 @@ struct IOOption {
     TaskThreadOption taskThreadOpt;
     RequestScheduleOption reqSchdulerOpt;
     CloseFdThreadOption closeFdThreadOption;
+    SegmentPrefetchOption segmentPrefetchOpt;
+    DiscardOption discardOpt;
 };
 
 /**
@@ -180,6 +180,40 @@ int CopysetClient::WriteChunk(const ChunkIDInfo& idinfo, uint64_t sn,
     return DoRPCTask(idinfo, task, doneGuard.release());
 }
 
+int CopysetClient::DiscardChunk(const ChunkIDInfo& idinfo, uint64_t sn,
+                                off_t offset, size_t length,
+                                google::protobuf::Closure* done) {
+    RequestClosure* reqclosure = static_cast<RequestClosure*>(done);
+
+    brpc::ClosureGuard doneGuard(done);
+
+    // session过期的处理与WriteChunk相同
+    if (sessionNotValid_ == true) {
+        if (exitFlag_) {
+            LOG(WARNING) << " return directly for session not valid at exit!"
+                        << ", copyset id = " << idinfo.cpid_
+                        << ", logical pool id = " << idinfo.lpid_
+                        << ", chunk id = " << idinfo.cid_
+                        << ", offset = " << offset
+                        << ", len = " << length;
+            return 0;
+        } else {
+            LOG(WARNING) << "session not valid, discard rpc ReSchedule!";
+            doneGuard.release();
+            reqclosure->ReleaseInflightRPCToken();
+            scheduler_->ReSchedule(reqclosure->GetReqCtx());
+            return 0;
+        }
+    }
+
+    auto task = [&](Closure* done, std::shared_ptr<RequestSender> senderPtr) {
+        DiscardChunkClosure* discardDone = new DiscardChunkClosure(this, done);
+        senderPtr->DiscardChunk(idinfo, sn, offset, length, discardDone);
+    };
+
+    return DoRPCTask(idinfo, task, doneGuard.release());
+}
+
 int CopysetClient::ReadChunkSnapshot(const ChunkIDInfo& idinfo,
     uint64_t sn, off_t offset, size_t length, Closure *done) {
 
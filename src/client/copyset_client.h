@@ -114,6 +114,20 @@ class CopysetClient {
                   const RequestSourceInfo& sourceInfo,
                   Closure *done);
 
+    /**
+     * 释放Chunk上指定范围的空间
+     * @param idinfo为chunk相关的id信息
+     * @param sn:文件版本号
+     * @param offset:discard的偏移
+     * @param length:discard的长度
+     * @param done:上一层异步回调的closure
+     */
+    int DiscardChunk(const ChunkIDInfo& idinfo,
+                     uint64_t sn,
+                     off_t offset,
+                     size_t length,
+                     Closure *done);
+
     /**
      * 读Chunk快照文件
      * @param idinfo为chunk相关的id信息
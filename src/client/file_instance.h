@@ -108,6 +108,12 @@ class CURVE_CACHELINE_ALIGNMENT FileInstance {
      * @return: 0为成功，小于0为失败
      */
     int AioWrite(CurveAioContext* aioctx, UserDataType dataType);
+    /**
+     * 异步模式discard
+     * @param: aioctx为异步读写的io上下文，保存基本的io信息
+     * @return: 0为成功，小于0为失败
+     */
+    int AioDiscard(CurveAioContext* aioctx);
 
     int Close();
 
@@ -0,0 +1,55 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "src/client/io_throttle.h"
+
+namespace curve {
+namespace client {
+
+IOThrottle::IOThrottle()
+    : iopsBucket_(0, 0),
+      bpsBucket_(0, 0) {}
+
+void IOThrottle::UpdateParams(const ThrottleParams& params) {
+    if (params.iopsLimit != iopsBucket_.GetRate() ||
+        params.bpsLimit != bpsBucket_.GetRate()) {
+        LOG(INFO) << "update file throttle params, iops limit = "
+                  << params.iopsLimit << ", iops burst = " << params.iopsBurst
+                  << ", bps limit = " << params.bpsLimit
+                  << ", bps burst = " << params.bpsBurst;
+    }
+    iopsBucket_.SetRate(params.iopsLimit, params.iopsBurst);
+    bpsBucket_.SetRate(params.bpsLimit, params.bpsBurst);
+}
+
+uint64_t IOThrottle::Acquire(size_t length) {
+    // 两个桶的透支在同一段时间内偿还，等待较长的一个即可
+    uint64_t iopsWaitUs = iopsBucket_.Acquire(1);
+    uint64_t bpsWaitUs = bpsBucket_.Acquire(length);
+    return std::max(iopsWaitUs, bpsWaitUs);
+}
+
+}   // namespace client
+}   // namespace curve
@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+
+#ifndef SRC_CLIENT_IO_THROTTLE_H_
+#define SRC_CLIENT_IO_THROTTLE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "src/client/client_common.h"
+#include "src/common/token_bucket.h"
+
+namespace curve {
+namespace client {
+
+/**
+ * 文件级别的QoS限速
+ *
+ * iops和bps各用一个令牌桶限制，桶的容量即允许的突发。每个用户IO下发前
+ * 从两个桶中取令牌，令牌不足时透支，由下发IO的线程等待两者中较长的
+ * 时间，因此大IO也只会被延迟而不会被拒绝。限速参数来自mds的FileInfo，
+ * 在open和续约时更新，参数为0表示不限制。
+ */
+class IOThrottle {
+ public:
+    IOThrottle();
+
+    /**
+     * @brief 更新限速参数，已经积攒和透支的令牌保留
+     */
+    void UpdateParams(const ThrottleParams& params);
+
+    /**
+     * @brief 为一个用户IO取令牌
+     * @param length IO的长度
+     * @return 需要等待的时间，单位us，不需要限速时返回0
+     */
+    uint64_t Acquire(size_t length);
+
+ private:
+    curve::common::TokenBucket iopsBucket_;
+    curve::common::TokenBucket bpsBucket_;
+};
+
+}   // namespace client
+}   // namespace curve
+
+#endif  // SRC_CLIENT_IO_THROTTLE_H_
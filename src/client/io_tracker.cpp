@@ -50,6 +50,8 @@ IOTracker::IOTracker(IOManager* iomanager,
       fileMetric_(clientMetric) {
     id_         = tracekerID_.fetch_add(1, std::memory_order_relaxed);
     scc_        = nullptr;
+    mdsclient_  = nullptr;
+    fileInfo_   = nullptr;
     aioctx_     = nullptr;
     data_       = nullptr;
     type_       = OpType::UNKNOWN;
@@ -206,6 +208,112 @@ void IOTracker::DoWrite(MDSClient* mdsclient, const FInfo_t* fileInfo) {
     }
 }
 
+void IOTracker::StartAioDiscard(CurveAioContext* ctx, MDSClient* mdsclient,
+                                const FInfo_t* fileInfo) {
+    aioctx_ = ctx;
+    offset_ = ctx->offset;
+    length_ = ctx->length;
+    type_ = OpType::DISCARD;
+
+    DVLOG(9) << "aiodiscard op, offset = " << ctx->offset
+             << ", length = " << ctx->length;
+
+    DoDiscard(mdsclient, fileInfo);
+}
+
+void IOTracker::DoDiscard(MDSClient* mdsclient, const FInfo_t* fileInfo) {
+    // the data of a clone file may still be in the clone source,
+    // discard is only a hint, so just ignore it
+    if (!fileInfo->cloneSource.empty() ||
+        fileInfo->filestatus != FileStatus::Created) {
+        DVLOG(9) << "discard ignored, filename = " << fileInfo->filename;
+        Done();
+        return;
+    }
+
+    mdsclient_ = mdsclient;
+    fileInfo_ = fileInfo;
+    int ret = Splitor::IO2ChunkRequests(this, mc_, &reqlist_, nullptr,
+                                        offset_, length_, mdsclient, fileInfo);
+    if (ret == 0) {
+        // all the chunks in the range are not allocated
+        if (reqlist_.empty()) {
+            Done();
+            return;
+        }
+
+        uint32_t subIoIndex = 0;
+
+        reqcount_.store(reqlist_.size(), std::memory_order_release);
+        std::for_each(reqlist_.begin(), reqlist_.end(), [&](RequestContext* r) {
+            r->done_->SetFileMetric(fileMetric_);
+            r->done_->SetIOManager(iomanager_);
+            r->subIoIndex_ = subIoIndex++;
+        });
+        ret = scheduler_->ScheduleRequest(reqlist_);
+    } else {
+        LOG(ERROR) << "splitor discard io failed, "
+                   << "offset = " << offset_ << ", length = " << length_;
+    }
+
+    if (ret == -1) {
+        LOG(ERROR) << "split or schedule failed, return and recycle resource!";
+        ReturnOnFail();
+    }
+}
+
+void IOTracker::DeAllocateSegments() {
+    if (mdsclient_ == nullptr || fileInfo_ == nullptr) {
+        return;
+    }
+
+    const uint64_t segmentSize = fileInfo_->segmentsize;
+    const uint64_t chunkSize = fileInfo_->chunksize;
+    const uint64_t end = offset_ + length_;
+    uint64_t segOffset =
+        (offset_ + segmentSize - 1) / segmentSize * segmentSize;
+    for (; segOffset + segmentSize <= end; segOffset += segmentSize) {
+        ChunkIndex chunkIdx = segOffset / chunkSize;
+        ChunkIDInfo chunkIdInfo;
+        if (mc_->GetChunkInfoByIndex(chunkIdx, &chunkIdInfo) !=
+                MetaCacheErrorType::OK || !chunkIdInfo.chunkExist) {
+            continue;
+        }
+        if (HasSkippedChunk(chunkIdx, segmentSize / chunkSize)) {
+            DVLOG(9) << "segment keeps data, filename = "
+                     << fileInfo_->filename << ", offset = " << segOffset;
+            continue;
+        }
+
+        LIBCURVE_ERROR ret = mdsclient_->DeAllocateSegment(segOffset,
+                                                           fileInfo_);
+        if (ret != LIBCURVE_ERROR::OK) {
+            LOG(WARNING) << "DeAllocateSegment failed, filename = "
+                         << fileInfo_->filename << ", offset = " << segOffset
+                         << ", ret = " << ret;
+            continue;
+        }
+
+        mc_->InvalidateChunkInfoByIndex(chunkIdx, segmentSize / chunkSize);
+    }
+}
+
+bool IOTracker::HasSkippedChunk(ChunkIndex chunkIdx, uint64_t count) {
+    std::lock_guard<std::mutex> lk(skippedMtx_);
+    if (skippedChunks_.empty()) {
+        return false;
+    }
+    for (uint64_t i = 0; i < count; ++i) {
+        ChunkIDInfo chunkIdInfo;
+        if (mc_->GetChunkInfoByIndex(chunkIdx + i, &chunkIdInfo) ==
+                MetaCacheErrorType::OK &&
+            skippedChunks_.count(chunkIdInfo.cid_) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void IOTracker::ReadSnapChunk(const ChunkIDInfo &cinfo,
     uint64_t seq, uint64_t offset, uint64_t len,
     char *buf, SnapCloneClosure* scc) {
@@ -362,7 +470,10 @@ void IOTracker::FillCommonFields(ChunkIDInfo idinfo, RequestContext* req) {
 
 void IOTracker::HandleResponse(RequestContext* reqctx) {
     int errorcode = reqctx->done_->GetErrorCode();
-    if (errorcode != 0) {
+    if (errorcode == CHUNK_OP_STATUS::CHUNK_OP_STATUS_DISCARD_SKIPPED) {
+        std::lock_guard<std::mutex> lk(skippedMtx_);
+        skippedChunks_.insert(reqctx->idinfo_.cid_);
+    } else if (errorcode != 0) {
         ChunkServerErr2LibcurveErr(static_cast<CHUNK_OP_STATUS>(errorcode),
                                    &errcode_);
     }
@@ -422,7 +533,8 @@ void IOTracker::Done() {
         }
     } else {
         MetricHelper::IncremUserEPSCount(fileMetric_, type_);
-        if (type_ == OpType::READ || type_ == OpType::WRITE) {
+        if (type_ == OpType::READ || type_ == OpType::WRITE ||
+            type_ == OpType::DISCARD) {
             LOG(ERROR) << "file [" << fileMetric_->filename << "]"
                     << ", IO Error, OpType = " << OpTypeToString(type_)
                     << ", offset = " << offset_
@@ -441,6 +553,22 @@ void IOTracker::Done() {
         return;
     }
 
+    // 归还segment需要同步访问mds，不能阻塞io返回的线程，交给iomanager
+    // 在后台归还之后再回调用户
+    if (NeedDeAllocateSegments()) {
+        iomanager_->HandleDiscardResponse(this);
+        return;
+    }
+
+    DoCallback();
+}
+
+void IOTracker::FinishDiscard() {
+    DeAllocateSegments();
+    DoCallback();
+}
+
+void IOTracker::DoCallback() {
     // 异步函数调用，在此处发起回调
     if (aioctx_ != nullptr) {
         aioctx_->ret = errcode_ == LIBCURVE_ERROR::OK ? length_ : -errcode_;
@@ -25,6 +25,8 @@
 #include <butil/iobuf.h>
 
 #include <atomic>
+#include <mutex>  // NOLINT
+#include <set>
 #include <string>
 #include <vector>
 
@@ -99,6 +101,15 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
      */
     void StartAioWrite(CurveAioContext* ctx, MDSClient* mdsclient,
                        const FInfo_t* fileInfo);
+
+    /**
+     * @brief start an async discard operation
+     * @param ctx async discard context
+     * @param mdsclient used to communicate with MDS
+     * @param fileInfo current file info
+     */
+    void StartAioDiscard(CurveAioContext* ctx, MDSClient* mdsclient,
+                         const FInfo_t* fileInfo);
     /**
      * chunk相关接口是提供给snapshot使用的，上层的snapshot和file
      * 接口是分开的，在IOTracker这里会将其统一，这样对下层来说不用
@@ -206,12 +217,23 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
         readDatas_[subIoIndex] = data;
     }
 
+    /**
+     * discard成功后归还segment并更新metacache，然后回调用户，
+     * 由iomanager在后台线程调用
+     */
+    void FinishDiscard();
+
  private:
     /**
      * 当IO返回的时候调用done，由done负责向上返回
      */
     void Done();
 
+    /**
+     * 回调用户并通知iomanager回收当前io tracker
+     */
+    void DoCallback();
+
     /**
      * 在io拆分或者，io分发失败的时候需要调用，设置返回状态，并向上返回
      */
@@ -258,6 +280,27 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
     // perform write operation
     void DoWrite(MDSClient* mdsclient, const FInfo_t* fileInfo);
 
+    // perform discard operation
+    void DoDiscard(MDSClient* mdsclient, const FInfo_t* fileInfo);
+
+    /**
+     * discard成功后是否需要归还segment
+     */
+    bool NeedDeAllocateSegments() const {
+        return type_ == OpType::DISCARD && errcode_ == LIBCURVE_ERROR::OK &&
+               mdsclient_ != nullptr;
+    }
+
+    /**
+     * 将discard完全覆盖的segment归还给mds，失败只打印日志，
+     * segment中的chunk已经被删除，不影响discard的结果。
+     * segment中有chunk的discard被跳过时，数据仍然保留，不能归还
+     */
+    void DeAllocateSegments();
+
+    // 从chunkIdx开始的count个chunk中是否有discard被跳过的chunk
+    bool HasSkippedChunk(ChunkIndex chunkIdx, uint64_t count);
+
  private:
     // io 类型
     OpType  type_;
@@ -319,6 +362,14 @@ class CURVE_CACHELINE_ALIGNMENT IOTracker {
     // 快照克隆系统异步调用回调指针
     SnapCloneClosure* scc_;
 
+    // discard完成后用于归还segment
+    MDSClient* mdsclient_;
+    const FInfo_t* fileInfo_;
+
+    // discard没有释放数据的chunk，这些chunk所在的segment不能归还
+    std::mutex skippedMtx_;
+    std::set<ChunkID> skippedChunks_;
+
     // id生成器
     static std::atomic<uint64_t> tracekerID_;
 };
@@ -66,6 +66,12 @@ class IOManager {
      */
     virtual void HandleAsyncIOResponse(IOTracker* iotracker) = 0;
 
+    /**
+     * @brief 处理成功返回的discard，归还segment之后再回调用户
+     * @param: iotracker是当前discard的归属
+     */
+    virtual void HandleDiscardResponse(IOTracker* iotracker) = 0;
+
  protected:
     // iomanager id目的是为了让底层RPC知道自己归属于哪个iomanager
     IOManagerID id_;
@@ -102,5 +102,9 @@ void IOManager4Chunk::HandleAsyncIOResponse(IOTracker* iotracker) {
     delete iotracker;
 }
 
+void IOManager4Chunk::HandleDiscardResponse(IOTracker* iotracker) {
+    iotracker->FinishDiscard();
+}
+
 }   // namespace client
 }   // namespace curve
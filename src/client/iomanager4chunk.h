@@ -115,6 +115,12 @@ class IOManager4Chunk : public IOManager {
      * @param: 是异步返回的io
      */
     void HandleAsyncIOResponse(IOTracker* iotracker) override;
+
+    /**
+     * chunk粒度的接口不会下发discard，直接回调用户
+     * @param: 是成功返回的discard
+     */
+    void HandleDiscardResponse(IOTracker* iotracker) override;
    /**
     * 析构，回收资源
     */
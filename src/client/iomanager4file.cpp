@@ -20,9 +20,14 @@
  * Author: tongguangxun
  */
 
+#include <bthread/bthread.h>
+#include <bthread/unstable.h>
+#include <butil/time.h>
 #include <glog/logging.h>
 
 #include <chrono>   // NOLINT
+#include <memory>
+#include <utility>
 
 #include "src/client/metacache.h"
 #include "src/client/iomanager4file.h"
@@ -32,6 +37,32 @@
 
 namespace curve {
 namespace client {
+
+namespace {
+
+// 限速等待结束之后下发IO的任务
+struct ThrottledTask {
+    std::function<void()> task;
+};
+
+void* RunThrottledTask(void* arg) {
+    std::unique_ptr<ThrottledTask> throttled(
+        static_cast<ThrottledTask*>(arg));
+    throttled->task();
+    return nullptr;
+}
+
+void OnThrottleTimer(void* arg) {
+    // 定时器线程不能阻塞，下发IO时可能等待scheduler的队列，放到bthread中执行
+    bthread_t tid;
+    if (bthread_start_background(&tid, nullptr, RunThrottledTask, arg) != 0) {
+        LOG(ERROR) << "start bthread failed, run throttled io in timer thread";
+        RunThrottledTask(arg);
+    }
+}
+
+}  // namespace
+
 Atomic<uint64_t> IOManager::idRecorder_(1);
 IOManager4File::IOManager4File(): scheduler_(nullptr), exit_(false) {
 }
@@ -78,11 +109,29 @@ bool IOManager4File::Initialize(const std::string& filename,
         return false;
     }
 
+    if (ioopt_.discardOpt.enableDiscard) {
+        ret = discardTaskPool_.Start(1);
+        if (ret != 0) {
+            LOG(ERROR) << "discard task thread pool start failed!";
+            return false;
+        }
+    }
+
+    ret = prefetcher_.Init(ioopt_.segmentPrefetchOpt, &mc_, mdsclient);
+    if (ret != 0) {
+        LOG(ERROR) << "segment prefetcher init failed!";
+        return false;
+    }
+
     LOG(INFO) << "iomanager init success! conf info: "
               << "isolationTaskThreadPoolSize = "
               << ioopt_.taskThreadOpt.isolationTaskThreadPoolSize
               << ", isolationTaskQueueCapacity = "
-              << ioopt_.taskThreadOpt.isolationTaskQueueCapacity;
+              << ioopt_.taskThreadOpt.isolationTaskQueueCapacity
+              << ", enableSegmentPrefetch = "
+              << ioopt_.segmentPrefetchOpt.enableSegmentPrefetch
+              << ", prefetchSegmentNum = "
+              << ioopt_.segmentPrefetchOpt.prefetchSegmentNum;
     return true;
 }
 
@@ -104,12 +153,14 @@ void IOManager4File::UnInitialize() {
     }
 
     taskPool_.Stop();
+    prefetcher_.UnInit();
 
     if (scheduler_ != nullptr) {
         scheduler_->WakeupBlockQueueAtExit();
         inflightCntl_.WaitInflightAllComeBack();
         scheduler_->Fini();
     }
+    discardTaskPool_.Stop();
 
     {
         // 这个锁保证设置exit_和delete scheduler_是原子的
@@ -128,6 +179,8 @@ int IOManager4File::Read(char* buf, off_t offset,
     size_t length, MDSClient* mdsclient) {
     MetricHelper::IncremUserRPSCount(fileMetric_, OpType::READ);
     FlightIOGuard guard(this);
+    prefetcher_.OnIO(offset, length, OpType::READ);
+    Throttle(length);
 
     butil::IOBuf data;
 
@@ -151,6 +204,8 @@ int IOManager4File::Write(const char* buf,
                           MDSClient* mdsclient) {
     MetricHelper::IncremUserRPSCount(fileMetric_, OpType::WRITE);
     FlightIOGuard guard(this);
+    prefetcher_.OnIO(offset, length, OpType::WRITE);
+    Throttle(length);
 
     butil::IOBuf data;
     data.append_user_data(const_cast<char*>(buf), length, TrivialDeleter);
@@ -163,6 +218,42 @@ int IOManager4File::Write(const char* buf,
     return rc;
 }
 
+uint64_t IOManager4File::AcquireThrottle(size_t length) {
+    uint64_t waitUs = throttle_.Acquire(length);
+    if (waitUs != 0 && fileMetric_ != nullptr) {
+        fileMetric_->throttleWaitUs << waitUs;
+    }
+    return waitUs;
+}
+
+void IOManager4File::Throttle(size_t length) {
+    uint64_t waitUs = AcquireThrottle(length);
+    if (waitUs != 0) {
+        bthread_usleep(waitUs);
+    }
+}
+
+void IOManager4File::ThrottleAsync(size_t length,
+                                   std::function<void()> task) {
+    uint64_t waitUs = AcquireThrottle(length);
+    if (waitUs == 0) {
+        task();
+        return;
+    }
+
+    // 令牌不足时不占用taskPool_的线程，定时器到期后再下发IO。
+    // IO已经计入inflightCntl_，UnInitialize会等待它返回
+    ThrottledTask* throttled = new ThrottledTask{std::move(task)};
+    bthread_timer_t timer;
+    if (bthread_timer_add(&timer, butil::microseconds_from_now(waitUs),
+                          OnThrottleTimer, throttled) != 0) {
+        LOG(WARNING) << "add throttle timer failed, wait " << waitUs
+                     << "us in task thread";
+        bthread_usleep(waitUs);
+        RunThrottledTask(throttled);
+    }
+}
+
 int IOManager4File::AioRead(CurveAioContext* ctx, MDSClient* mdsclient,
                             UserDataType dataType) {
     MetricHelper::IncremUserRPSCount(fileMetric_, OpType::READ);
@@ -178,8 +269,11 @@ int IOManager4File::AioRead(CurveAioContext* ctx, MDSClient* mdsclient,
 
     temp->SetUserDataType(dataType);
     inflightCntl_.IncremInflightNum();
+    prefetcher_.OnIO(ctx->offset, ctx->length, OpType::READ);
     auto task = [this, ctx, mdsclient, temp]() {
-        temp->StartAioRead(ctx, mdsclient, this->GetFileInfo());
+        ThrottleAsync(ctx->length, [this, ctx, mdsclient, temp]() {
+            temp->StartAioRead(ctx, mdsclient, this->GetFileInfo());
+        });
     };
 
     taskPool_.Enqueue(task);
@@ -201,8 +295,39 @@ int IOManager4File::AioWrite(CurveAioContext* ctx, MDSClient* mdsclient,
 
     temp->SetUserDataType(dataType);
     inflightCntl_.IncremInflightNum();
+    prefetcher_.OnIO(ctx->offset, ctx->length, OpType::WRITE);
     auto task = [this, ctx, mdsclient, temp]() {
-        temp->StartAioWrite(ctx, mdsclient, this->GetFileInfo());
+        ThrottleAsync(ctx->length, [this, ctx, mdsclient, temp]() {
+            temp->StartAioWrite(ctx, mdsclient, this->GetFileInfo());
+        });
+    };
+
+    taskPool_.Enqueue(task);
+    return LIBCURVE_ERROR::OK;
+}
+
+int IOManager4File::AioDiscard(CurveAioContext* ctx, MDSClient* mdsclient) {
+    // discard只是提示，没有开启时直接返回成功
+    if (!ioopt_.discardOpt.enableDiscard) {
+        ctx->ret = ctx->length;
+        ctx->cb(ctx);
+        return LIBCURVE_ERROR::OK;
+    }
+
+    MetricHelper::IncremUserRPSCount(fileMetric_, OpType::DISCARD);
+
+    IOTracker* temp = new (std::nothrow) IOTracker(this, &mc_,
+                                                   scheduler_, fileMetric_);
+    if (temp == nullptr) {
+        ctx->ret = -LIBCURVE_ERROR::FAILED;
+        ctx->cb(ctx);
+        LOG(ERROR) << "allocate tracker failed!";
+        return LIBCURVE_ERROR::OK;
+    }
+
+    inflightCntl_.IncremInflightNum();
+    auto task = [this, ctx, mdsclient, temp]() {
+        temp->StartAioDiscard(ctx, mdsclient, this->GetFileInfo());
     };
 
     taskPool_.Enqueue(task);
@@ -211,6 +336,7 @@ int IOManager4File::AioWrite(CurveAioContext* ctx, MDSClient* mdsclient,
 
 void IOManager4File::UpdateFileInfo(const FInfo_t& fi) {
     mc_.UpdateFileInfo(fi);
+    throttle_.UpdateParams(fi.throttleParams);
 }
 
 void IOManager4File::HandleAsyncIOResponse(IOTracker* iotracker) {
@@ -218,6 +344,12 @@ void IOManager4File::HandleAsyncIOResponse(IOTracker* iotracker) {
     delete iotracker;
 }
 
+void IOManager4File::HandleDiscardResponse(IOTracker* iotracker) {
+    discardTaskPool_.Enqueue([iotracker]() {
+        iotracker->FinishDiscard();
+    });
+}
+
 void IOManager4File::LeaseTimeoutBlockIO() {
     std::unique_lock<std::mutex> lk(exitMtx_);
     if (exit_ == false) {
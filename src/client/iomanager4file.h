@@ -28,16 +28,19 @@
 
 #include <atomic>
 #include <condition_variable>  // NOLINT
+#include <functional>
 #include <mutex>               // NOLINT
 #include <string>
 
 #include "include/curve_compiler_specific.h"
 #include "src/client/client_common.h"
 #include "src/client/inflight_controller.h"
+#include "src/client/io_throttle.h"
 #include "src/client/iomanager.h"
 #include "src/client/mds_client.h"
 #include "src/client/metacache.h"
 #include "src/client/request_scheduler.h"
+#include "src/client/segment_prefetcher.h"
 #include "src/common/concurrent/concurrent.h"
 #include "src/common/concurrent/task_thread_pool.h"
 
@@ -101,6 +104,13 @@ class IOManager4File : public IOManager {
      */
     int AioWrite(CurveAioContext* aioctx, MDSClient* mdsclient,
                  UserDataType dataType);
+    /**
+     * 异步模式discard
+     * @param: mdsclient透传给底层，在必要的时候与mds通信
+     * @param: aioctx为异步读写的io上下文，保存基本的io信息
+     * @return： 0为成功，小于0为失败
+     */
+    int AioDiscard(CurveAioContext* aioctx, MDSClient* mdsclient);
 
     /**
      * 析构，回收资源
@@ -157,6 +167,14 @@ class IOManager4File : public IOManager {
      */
     void UpdateFileInfo(const FInfo_t& fi);
 
+    /**
+     * lease excutor续约成功时，需要更新mds下发的QoS限速参数
+     * @param: params为文件最新的限速参数
+     */
+    void UpdateThrottleParams(const ThrottleParams& params) {
+        throttle_.UpdateParams(params);
+    }
+
     const FInfo* GetFileInfo() const {
         return mc_.GetFileInfo();
     }
@@ -202,6 +220,34 @@ class IOManager4File : public IOManager {
      */
     void HandleAsyncIOResponse(IOTracker* iotracker) override;
 
+    /**
+     * discard成功之后需要同步访问mds归还segment，不能阻塞io返回的线程，
+     * 放到后台归还segment并更新metacache之后再回调用户，保证回调之后
+     * 下发的io不会使用已经归还的chunk
+     * @param: iotracker是成功返回的discard
+     */
+    void HandleDiscardResponse(IOTracker* iotracker) override;
+
+    /**
+     * 用户IO下发前按照文件的QoS限速，令牌不足时等待
+     * @param: length为用户IO的长度
+     */
+    void Throttle(size_t length);
+
+    /**
+     * 异步IO下发前按照文件的QoS限速，令牌不足时通过bthread定时器延迟下发，
+     * 不阻塞taskPool_的线程
+     * @param: length为用户IO的长度
+     * @param: task为下发IO的任务
+     */
+    void ThrottleAsync(size_t length, std::function<void()> task);
+
+    /**
+     * 从限速器中获取令牌并记录等待时间
+     * @return: 需要等待的时间，单位为us
+     */
+    uint64_t AcquireThrottle(size_t length);
+
     class FlightIOGuard {
      public:
         explicit FlightIOGuard(IOManager4File* iomana) {
@@ -234,12 +280,21 @@ class IOManager4File : public IOManager {
     curve::common::TaskThreadPool<bthread::Mutex, bthread::ConditionVariable>
         taskPool_;
 
+    // discard完成后在后台归还segment再回调用户，与io返回的线程隔离
+    curve::common::TaskThreadPool<> discardTaskPool_;
+
     // inflight IO控制
     InflightControl inflightCntl_;
 
     // inflight rpc控制
     InflightControl inflightRpcCntl_;
 
+    // 顺序IO时预取segment元数据
+    SegmentPrefetcher prefetcher_;
+
+    // 文件的QoS限速
+    IOThrottle throttle_;
+
     // 是否退出
     bool exit_;
 
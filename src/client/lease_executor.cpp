@@ -105,6 +105,7 @@ bool LeaseExecutor::RefreshLease() {
 
     if (response.status == LeaseRefreshResult::Status::OK) {
         CheckNeedUpdateVersion(response.finfo.seqnum);
+        iomanager_->UpdateThrottleParams(response.finfo.throttleParams);
         failedrefreshcount_.store(0);
         isleaseAvaliable_.store(true);
         iomanager_->RefeshSuccAndResumeIO();
@@ -362,6 +362,28 @@ int FileClient::AioWrite(int fd, CurveAioContext* aioctx,
     return ret;
 }
 
+int FileClient::AioDiscard(int fd, CurveAioContext* aioctx) {
+    // 长度为0，直接返回，不做任何操作
+    if (aioctx->length == 0) {
+        return -LIBCURVE_ERROR::OK;
+    }
+
+    if (CheckAligned(aioctx->offset, aioctx->length) == false) {
+        return -LIBCURVE_ERROR::NOT_ALIGNED;
+    }
+
+    int ret = -LIBCURVE_ERROR::FAILED;
+    ReadLockGuard lk(rwlock_);
+    if (CURVE_UNLIKELY(fileserviceMap_.find(fd) == fileserviceMap_.end())) {
+        LOG(ERROR) << "invalid fd!";
+        ret = -LIBCURVE_ERROR::BAD_FD;
+    } else {
+        ret = fileserviceMap_[fd]->AioDiscard(aioctx);
+    }
+
+    return ret;
+}
+
 int FileClient::Rename(const UserInfo_t& userinfo,
     const std::string& oldpath, const std::string& newpath) {
     LIBCURVE_ERROR ret;
@@ -721,6 +743,18 @@ int AioWrite(int fd, CurveAioContext* aioctx) {
     return globalclient->AioWrite(fd, aioctx);
 }
 
+int AioDiscard(int fd, CurveAioContext* aioctx) {
+    if (globalclient == nullptr) {
+        LOG(ERROR) << "not inited!";
+        return -LIBCURVE_ERROR::FAILED;
+    }
+
+    DVLOG(9) << "offset: " << aioctx->offset
+        << " length: " << aioctx->length
+        << " op: " << aioctx->op;
+    return globalclient->AioDiscard(fd, aioctx);
+}
+
 int Create(const char* filename, const C_UserInfo_t* userinfo, size_t size) {
     if (globalclient == nullptr) {
         LOG(ERROR) << "not inited!";
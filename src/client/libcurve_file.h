@@ -151,6 +151,14 @@ class FileClient {
     virtual int AioWrite(int fd, CurveAioContext* aioctx,
                          UserDataType dataType = UserDataType::RawBuffer);
 
+    /**
+     * 异步模式discard
+     * @param: fd为当前open返回的文件描述符
+     * @param: aioctx为异步读写的io上下文，保存基本的io信息
+     * @return: 成功返回0,否则返回小于0的错误码
+     */
+    virtual int AioDiscard(int fd, CurveAioContext* aioctx);
+
     /**
      * 重命名文件
      * @param: userinfo是用户信息
@@ -47,6 +47,7 @@ using curve::mds::CreateFileResponse;
 using curve::mds::DeleteFileResponse;
 using curve::mds::GetFileInfoResponse;
 using curve::mds::GetOrAllocateSegmentResponse;
+using curve::mds::GetSegmentsResponse;
 using curve::mds::RenameFileResponse;
 using curve::mds::ExtendFileResponse;
 using curve::mds::ChangeOwnerResponse;
@@ -898,30 +899,92 @@ LIBCURVE_ERROR MDSClient::GetOrAllocateSegment(bool allocate,
             default: break;
         }
 
-        PageFileSegment pfs = response.pagefilesegment();
-        segInfo->chunksize = pfs.chunksize();
-        segInfo->segmentsize = pfs.segmentsize();
-        segInfo->startoffset = pfs.startoffset();
-        LogicPoolID logicpoolid = pfs.logicalpoolid();
-        segInfo->lpcpIDInfo.lpid = pfs.logicalpoolid();
-
-        int chunksNum = pfs.chunks_size();
-        if (allocate && chunksNum <= 0) {
+        const PageFileSegment& pfs = response.pagefilesegment();
+        if (allocate && pfs.chunks_size() <= 0) {
             LOG(WARNING) << "MDS allocate segment, but no chunkinfo!";
             return LIBCURVE_ERROR::FAILED;
         }
 
-        for (int i = 0; i < chunksNum; i++) {
-            ChunkID chunkid = pfs.chunks(i).chunkid();
-            CopysetID copysetid = pfs.chunks(i).copysetid();
-            segInfo->lpcpIDInfo.cpidVec.push_back(copysetid);
-            segInfo->chunkvec.emplace_back(chunkid, logicpoolid, copysetid);
-        }
+        PageFileSegment2SegmentInfo(pfs, segInfo);
         return LIBCURVE_ERROR::OK;
     };
     return rpcExcutor.DoRPCTask(task, IOPathMaxRetryMS);
 }
 
+LIBCURVE_ERROR MDSClient::DeAllocateSegment(uint64_t offset,
+                                            const FInfo_t* fi) {
+    auto task = RPCTaskDefine {
+        DeAllocateSegmentResponse response;
+        mdsClientMetric_.deAllocateSegment.qps.count << 1;
+        LatencyGuard lg(&mdsClientMetric_.deAllocateSegment.latency);
+        mdsClientBase_.DeAllocateSegment(offset, fi, &response, cntl, channel);
+        if (cntl->Failed()) {
+            mdsClientMetric_.deAllocateSegment.eps.count << 1;
+            LOG(WARNING) << "DeAllocateSegment invoke failed, errcorde = "
+                << cntl->ErrorCode()  << ", error content:"
+                << cntl->ErrorText() << ", log id = " << cntl->log_id();
+            return -cntl->ErrorCode();
+        }
+
+        LIBCURVE_ERROR retcode;
+        StatusCode stcode = response.statuscode();
+        MDSStatusCode2LibcurveError(stcode, &retcode);
+        LOG_IF(WARNING, retcode != LIBCURVE_ERROR::OK)
+                << "DeAllocateSegment: filename = " << fi->fullPathName
+                << ", offset = " << offset
+                << ", errocde = " << retcode
+                << ", error msg = " << StatusCode_Name(stcode)
+                << ", log id = " << cntl->log_id();
+        return retcode;
+    };
+    return rpcExcutor.DoRPCTask(task, metaServerOpt_.mdsMaxRetryMS);
+}
+
+LIBCURVE_ERROR MDSClient::GetSegments(uint64_t offset,
+                                      uint32_t count,
+                                      bool allocate,
+                                      const FInfo_t* fi,
+                                      std::vector<SegmentInfo>* segInfos) {
+    auto task = RPCTaskDefine {
+        GetSegmentsResponse response;
+        mdsClientMetric_.getSegments.qps.count << 1;
+        LatencyGuard lg(&mdsClientMetric_.getSegments.latency);
+        mdsClientBase_.GetSegments(offset, count, allocate, fi, &response,
+                                   cntl, channel);
+        if (cntl->Failed()) {
+            mdsClientMetric_.getSegments.eps.count << 1;
+            LOG(WARNING) << "GetSegments invoke failed, errcorde = "
+                << cntl->ErrorCode()  << ", error content:"
+                << cntl->ErrorText() << ", log id = " << cntl->log_id();
+            return -cntl->ErrorCode();
+        }
+
+        LIBCURVE_ERROR retcode;
+        StatusCode stcode = response.statuscode();
+        MDSStatusCode2LibcurveError(stcode, &retcode);
+        if (retcode != LIBCURVE_ERROR::OK) {
+            LOG(WARNING) << "GetSegments: filename = " << fi->fullPathName
+                << ", offset = " << offset
+                << ", count = " << count
+                << ", allocate = " << allocate
+                << ", errocde = " << retcode
+                << ", error msg = " << StatusCode_Name(stcode)
+                << ", log id = " << cntl->log_id();
+            return retcode;
+        }
+
+        segInfos->clear();
+        for (int i = 0; i < response.pagefilesegments_size(); i++) {
+            SegmentInfo segInfo;
+            PageFileSegment2SegmentInfo(response.pagefilesegments(i),
+                                        &segInfo);
+            segInfos->emplace_back(std::move(segInfo));
+        }
+        return LIBCURVE_ERROR::OK;
+    };
+    return rpcExcutor.DoRPCTask(task, metaServerOpt_.mdsMaxRetryMS);
+}
+
 LIBCURVE_ERROR MDSClient::RenameFile(const UserInfo_t& userinfo,
                                      const std::string& origin,
                                      const std::string& destination,
@@ -1284,5 +1347,21 @@ void MDSClient::MDSStatusCode2LibcurveError(const StatusCode& status,
     }
 }
 
+void MDSClient::PageFileSegment2SegmentInfo(const PageFileSegment& pfs,
+                                            SegmentInfo* segInfo) {
+    segInfo->chunksize = pfs.chunksize();
+    segInfo->segmentsize = pfs.segmentsize();
+    segInfo->startoffset = pfs.startoffset();
+    LogicPoolID logicpoolid = pfs.logicalpoolid();
+    segInfo->lpcpIDInfo.lpid = pfs.logicalpoolid();
+
+    for (int i = 0; i < pfs.chunks_size(); i++) {
+        ChunkID chunkid = pfs.chunks(i).chunkid();
+        CopysetID copysetid = pfs.chunks(i).copysetid();
+        segInfo->lpcpIDInfo.cpidVec.push_back(copysetid);
+        segInfo->chunkvec.emplace_back(chunkid, logicpoolid, copysetid);
+    }
+}
+
 }   // namespace client
 }   // namespace curve
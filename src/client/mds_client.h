@@ -127,6 +127,29 @@ class MDSClient {
                                         uint64_t offset,
                                         const FInfo_t* fi,
                                         SegmentInfo* segInfo);
+    /**
+     * 释放segment，segment中的chunk需要先通过discard删除
+     * @param: offset为segment在文件内的偏移
+     * @param: fi是当前文件的基本信息
+     * @return: 成功返回LIBCURVE_ERROR::OK,如果认证失败返回LIBCURVE_ERROR::AUTHFAIL，
+     *          否则返回LIBCURVE_ERROR::FAILED
+     */
+    LIBCURVE_ERROR DeAllocateSegment(uint64_t offset, const FInfo_t* fi);
+    /**
+     * 批量获取segment的chunk信息，用于顺序IO时预取元数据
+     * @param: offset为第一个segment在文件内的偏移
+     * @param: count为获取的segment数量，超出文件大小的部分被忽略
+     * @param: allocate为true时mds会分配其中还未分配的segment
+     * @param: fi是当前文件的基本信息
+     * @param[out]: segInfos返回其中已经分配的segment的chunk信息
+     * @return: 成功返回LIBCURVE_ERROR::OK,如果认证失败返回LIBCURVE_ERROR::AUTHFAIL，
+     *          否则返回LIBCURVE_ERROR::FAILED
+     */
+    LIBCURVE_ERROR GetSegments(uint64_t offset,
+                               uint32_t count,
+                               bool allocate,
+                               const FInfo_t* fi,
+                               std::vector<SegmentInfo>* segInfos);
     /**
      * 获取文件信息，fi是出参
      * @param: filename是文件名
@@ -507,6 +530,14 @@ class MDSClient {
     void MDSStatusCode2LibcurveError(const ::curve::mds::StatusCode& statcode,
                                      LIBCURVE_ERROR* errcode);
 
+    /**
+     * 将mds返回的segment信息转换为client一侧的segment信息
+     * @param: pfs为mds返回的segment信息
+     * @param[out]: segInfo为转换后的segment信息
+     */
+    void PageFileSegment2SegmentInfo(const ::curve::mds::PageFileSegment& pfs,
+                                     SegmentInfo* segInfo);
+
  private:
     // 初始化标志，放置重复初始化
     bool inited_ = false;
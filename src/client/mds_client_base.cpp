@@ -364,6 +364,50 @@ void MDSClientBase::GetOrAllocateSegment(bool allocate,
     stub.GetOrAllocateSegment(cntl, &request, response, NULL);
 }
 
+void MDSClientBase::DeAllocateSegment(uint64_t offset,
+                                      const FInfo_t* fi,
+                                      DeAllocateSegmentResponse* response,
+                                      brpc::Controller* cntl,
+                                      brpc::Channel* channel) {
+    DeAllocateSegmentRequest request;
+    request.set_filename(fi->fullPathName);
+    request.set_offset(offset);
+    FillUserInfo(&request, fi->userinfo);
+
+    LOG(INFO) << "DeAllocateSegment: filename = " << fi->fullPathName
+                << ", owner = " << fi->owner
+                << ", segment offset = " << offset
+                << ", log id = " << cntl->log_id();
+
+    curve::mds::CurveFSService_Stub stub(channel);
+    stub.DeAllocateSegment(cntl, &request, response, NULL);
+}
+
+void MDSClientBase::GetSegments(uint64_t offset,
+                                uint32_t count,
+                                bool allocate,
+                                const FInfo_t* fi,
+                                GetSegmentsResponse* response,
+                                brpc::Controller* cntl,
+                                brpc::Channel* channel) {
+    GetSegmentsRequest request;
+    request.set_filename(fi->fullPathName);
+    request.set_offset(offset);
+    request.set_count(count);
+    request.set_allocateifnotexist(allocate);
+    FillUserInfo(&request, fi->userinfo);
+
+    LOG(INFO) << "GetSegments: filename = " << fi->fullPathName
+                << ", owner = " << fi->owner
+                << ", segment offset = " << offset
+                << ", count = " << count
+                << ", allocate = " << allocate
+                << ", log id = " << cntl->log_id();
+
+    curve::mds::CurveFSService_Stub stub(channel);
+    stub.GetSegments(cntl, &request, response, NULL);
+}
+
 void MDSClientBase::RenameFile(const UserInfo_t& userinfo,
                                const std::string& origin,
                                const std::string& destination,
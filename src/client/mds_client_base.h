@@ -76,6 +76,10 @@ using curve::mds::SetCloneFileStatusRequest;
 using curve::mds::SetCloneFileStatusResponse;
 using curve::mds::GetOrAllocateSegmentRequest;
 using curve::mds::GetOrAllocateSegmentResponse;
+using curve::mds::DeAllocateSegmentRequest;
+using curve::mds::DeAllocateSegmentResponse;
+using curve::mds::GetSegmentsRequest;
+using curve::mds::GetSegmentsResponse;
 using curve::mds::CheckSnapShotStatusRequest;
 using curve::mds::CheckSnapShotStatusResponse;
 using curve::mds::ListSnapShotFileInfoRequest;
@@ -330,6 +334,37 @@ class MDSClientBase {
                               GetOrAllocateSegmentResponse* response,
                               brpc::Controller* cntl,
                               brpc::Channel* channel);
+    /**
+     * 释放已经被discard的segment
+     * @param: offset为segment在文件内的偏移
+     * @param: fi是当前文件的基本信息
+     * @param[out]: response为该rpc的response，提供给外部处理
+     * @param[in|out]: cntl既是入参，也是出参，返回RPC状态
+     * @param[in]:channel是当前与mds建立的通道
+     */
+    void DeAllocateSegment(uint64_t offset,
+                           const FInfo_t* fi,
+                           DeAllocateSegmentResponse* response,
+                           brpc::Controller* cntl,
+                           brpc::Channel* channel);
+    /**
+     * 批量获取从offset开始的count个segment
+     * @param: offset为第一个segment在文件内的偏移
+     * @param: count为获取的segment数量
+     * @param: allocate为false时只返回已经分配的segment，
+     *         为true时mds会分配其中还未分配的segment
+     * @param: fi是当前文件的基本信息
+     * @param[out]: response为该rpc的response，提供给外部处理
+     * @param[in|out]: cntl既是入参，也是出参，返回RPC状态
+     * @param[in]:channel是当前与mds建立的通道
+     */
+    void GetSegments(uint64_t offset,
+                     uint32_t count,
+                     bool allocate,
+                     const FInfo_t* fi,
+                     GetSegmentsResponse* response,
+                     brpc::Controller* cntl,
+                     brpc::Channel* channel);
     /**
      * @brief 重名文件
      * @param:userinfo 用户信息
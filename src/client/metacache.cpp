@@ -268,6 +268,36 @@ void MetaCache::UpdateChunkInfoByIndex(ChunkIndex cindex,
     chunkindex2idMap_[cindex] = cinfo;
 }
 
+uint64_t MetaCache::GetChunkInfoEpoch() {
+    ReadLockGuard rdlk(rwlock4ChunkInfo_);
+    return chunkInfoEpoch_;
+}
+
+bool MetaCache::UpdateChunkInfoIfEpochMatch(
+    ChunkIndex cindex, const std::vector<ChunkIDInfo>& cinfos,
+    uint64_t epoch) {
+    WriteLockGuard wrlk(rwlock4ChunkInfo_);
+    if (epoch != chunkInfoEpoch_) {
+        return false;
+    }
+    for (const auto& cinfo : cinfos) {
+        chunkindex2idMap_[cindex++] = cinfo;
+    }
+    return true;
+}
+
+void MetaCache::InvalidateChunkInfoByIndex(ChunkIndex cindex,
+                                           uint64_t count) {
+    // this chunkIdInfo(0, 0, 0) identify the unallocated chunk
+    ChunkIDInfo unallocated(0, 0, 0);
+    unallocated.chunkExist = false;
+    WriteLockGuard wrlk(rwlock4ChunkInfo_);
+    for (uint64_t i = 0; i < count; ++i) {
+        chunkindex2idMap_[cindex + i] = unallocated;
+    }
+    ++chunkInfoEpoch_;
+}
+
 void MetaCache::UpdateCopysetInfo(LogicPoolID logicPoolid, CopysetID copysetid,
                                   const CopysetInfo& csinfo) {
     const auto key = CalcLogicPoolCopysetID(logicPoolid, copysetid);
@@ -25,6 +25,7 @@
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "src/client/client_common.h"
 #include "src/client/client_config.h"
@@ -128,6 +129,32 @@ class MetaCache {
      */
     virtual void UpdateChunkInfoByIndex(ChunkIndex cindex,
                                         const ChunkIDInfo& chunkinfo);
+
+    /**
+     * 获取chunk index信息的版本，chunk信息被置为未分配时版本增加
+     * @return: 当前版本
+     */
+    uint64_t GetChunkInfoEpoch();
+
+    /**
+     * 版本没有变化时，从cindex开始依次更新chunkid信息，用于后台预取，
+     * 避免预取期间被置为未分配的chunk又被预取到的旧信息覆盖
+     * @param: cindex为第一个待更新的chunk index
+     * @param: chunkinfos为需要更新的info信息
+     * @param: epoch为获取chunk信息之前的版本
+     * @return: 版本变化时不更新，返回false
+     */
+    bool UpdateChunkInfoIfEpochMatch(ChunkIndex cindex,
+                                     const std::vector<ChunkIDInfo>& chunkinfos,
+                                     uint64_t epoch);
+
+    /**
+     * 将chunk index对应的chunk置为未分配，用于segment归还之后，
+     * 同时增加chunk信息的版本
+     * @param: cindex为第一个chunk index
+     * @param: count为chunk数量
+     */
+    void InvalidateChunkInfoByIndex(ChunkIndex cindex, uint64_t count);
     /**
      * 通过chunk id更新chunkid信息
      * @param: cid为chunkid
@@ -276,6 +303,9 @@ class MetaCache {
     // chunkindex到chunkidinfo的映射表
     CURVE_CACHELINE_ALIGNMENT ChunkIndexInfoMap     chunkindex2idMap_;
 
+    // chunkindex2idMap_中的chunk被置为未分配的次数，由rwlock4ChunkInfo_保护
+    uint64_t chunkInfoEpoch_ = 0;
+
     // logicalpoolid和copysetid到copysetinfo的映射表
     CURVE_CACHELINE_ALIGNMENT CopysetInfoMap        lpcsid2CopsetInfoMap_;
 
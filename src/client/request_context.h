@@ -38,6 +38,8 @@ namespace client {
 struct RequestSourceInfo {
     std::string cloneFileSource;
     uint64_t cloneFileOffset{0};
+    // 请求所属的文件，chunkserver按照文件公平调度，为0表示不携带
+    uint64_t fileId{0};
 
     RequestSourceInfo() = default;
     RequestSourceInfo(const std::string& source, uint64_t offset)
@@ -175,6 +175,11 @@ void RequestScheduler::ProcessOne(RequestContext* ctx) {
                                ctx->offset_, ctx->rawlength_, ctx->sourceInfo_,
                                guard.release());
             break;
+        case OpType::DISCARD:
+            ctx->done_->GetInflightRPCToken();
+            client_.DiscardChunk(ctx->idinfo_, ctx->seq_, ctx->offset_,
+                                 ctx->rawlength_, guard.release());
+            break;
         case OpType::READ_SNAP:
             client_.ReadChunkSnapshot(ctx->idinfo_, ctx->seq_, ctx->offset_,
                                       ctx->rawlength_, guard.release());
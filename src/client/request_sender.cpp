@@ -100,6 +100,10 @@ int RequestSender::ReadChunk(const ChunkIDInfo& idinfo,
         request.set_clonefileoffset(sourceInfo.cloneFileOffset);
     }
 
+    if (sourceInfo.fileId != 0) {
+        request.set_fileid(sourceInfo.fileId);
+    }
+
     if (iosenderopt_.chunkserverEnableAppliedIndexRead && appliedindex > 0) {
         request.set_appliedindex(appliedindex);
     }
@@ -141,6 +145,10 @@ int RequestSender::WriteChunk(const ChunkIDInfo& idinfo,
         request.set_clonefileoffset(sourceInfo.cloneFileOffset);
     }
 
+    if (sourceInfo.fileId != 0) {
+        request.set_fileid(sourceInfo.fileId);
+    }
+
     cntl->request_attachment().append(data);
     ChunkService_Stub stub(&channel_);
     stub.WriteChunk(cntl, &request, response, doneGuard.release());
@@ -148,6 +156,32 @@ int RequestSender::WriteChunk(const ChunkIDInfo& idinfo,
     return 0;
 }
 
+int RequestSender::DiscardChunk(const ChunkIDInfo& idinfo,
+                                uint64_t sn,
+                                off_t offset,
+                                size_t length,
+                                ClientClosure *done) {
+    brpc::ClosureGuard doneGuard(done);
+    brpc::Controller *cntl = new brpc::Controller();
+    ChunkResponse *response = new ChunkResponse();
+
+    UpdateRpcRPS(done, OpType::DISCARD);
+    SetRpcStuff(done, cntl, response);
+
+    ChunkRequest request;
+    request.set_optype(curve::chunkserver::CHUNK_OP_TYPE::CHUNK_OP_DISCARD);
+    request.set_logicpoolid(idinfo.lpid_);
+    request.set_copysetid(idinfo.cpid_);
+    request.set_chunkid(idinfo.cid_);
+    request.set_sn(sn);
+    request.set_offset(offset);
+    request.set_size(length);
+    ChunkService_Stub stub(&channel_);
+    stub.DiscardChunk(cntl, &request, response, doneGuard.release());
+
+    return 0;
+}
+
 int RequestSender::ReadChunkSnapshot(const ChunkIDInfo& idinfo,
                                      uint64_t sn,
                                      off_t offset,
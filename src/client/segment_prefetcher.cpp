@@ -0,0 +1,262 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <map>
+
+#include "src/client/segment_prefetcher.h"
+
+namespace curve {
+namespace client {
+
+SegmentPrefetcher::SegmentPrefetcher()
+    : metaCache_(nullptr),
+      mdsClient_(nullptr),
+      enabled_(false),
+      lastIOEnd_(0),
+      prefetchEnd_(0),
+      prefetching_(false) {}
+
+int SegmentPrefetcher::Init(const SegmentPrefetchOption& option,
+                            MetaCache* metaCache,
+                            MDSClient* mdsClient) {
+    option_ = option;
+    metaCache_ = metaCache;
+    mdsClient_ = mdsClient;
+
+    if (!option_.enableSegmentPrefetch || option_.prefetchSegmentNum == 0 ||
+        mdsClient_ == nullptr) {
+        LOG(INFO) << "segment prefetch disabled";
+        return 0;
+    }
+
+    // 同一时间只有一个预取任务，一个线程就足够
+    int ret = taskPool_.Start(1, 1);
+    if (ret != 0) {
+        LOG(ERROR) << "segment prefetch thread pool start failed!";
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> lk(mtx_);
+    enabled_ = true;
+    return 0;
+}
+
+void SegmentPrefetcher::UnInit() {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        enabled_ = false;
+    }
+    taskPool_.Stop();
+}
+
+void SegmentPrefetcher::OnIO(off_t offset, size_t length, OpType type) {
+    if (length == 0) {
+        return;
+    }
+
+    const FInfo* fi = metaCache_->GetFileInfo();
+    const uint64_t segmentSize = fi->segmentsize;
+    if (segmentSize == 0) {
+        return;
+    }
+    const uint64_t segmentNum = fi->length / segmentSize;
+
+    uint64_t startSegIndex = 0;
+    uint64_t endSegIndex = 0;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        if (!enabled_) {
+            return;
+        }
+
+        bool sequential = (static_cast<uint64_t>(offset) == lastIOEnd_);
+        lastIOEnd_ = offset + length;
+        if (!sequential) {
+            // 随机IO，之后重新开始顺序检测
+            prefetchEnd_ = 0;
+            return;
+        }
+        if (prefetching_) {
+            return;
+        }
+
+        // IO所在的最后一个segment之后的segment都需要预取
+        uint64_t nextSegIndex = (offset + length - 1) / segmentSize + 1;
+        if (prefetchEnd_ > nextSegIndex &&
+            prefetchEnd_ - nextSegIndex > option_.prefetchSegmentNum / 2) {
+            return;
+        }
+
+        startSegIndex = std::max(prefetchEnd_, nextSegIndex);
+        endSegIndex = std::min(nextSegIndex + option_.prefetchSegmentNum,
+                               segmentNum);
+        if (startSegIndex >= endSegIndex) {
+            return;
+        }
+
+        prefetchEnd_ = endSegIndex;
+        prefetching_ = true;
+    }
+
+    const bool allocate =
+        option_.prefetchAllocateSegment && type == OpType::WRITE;
+    taskPool_.Enqueue([this, startSegIndex, endSegIndex, allocate]() {
+        Prefetch(startSegIndex, endSegIndex, allocate);
+    });
+}
+
+void SegmentPrefetcher::Prefetch(uint64_t startSegIndex,
+                                 uint64_t endSegIndex,
+                                 bool allocate) {
+    FInfo fi = *metaCache_->GetFileInfo();
+
+    // 跳过两端已经在metacache中的segment
+    while (startSegIndex < endSegIndex && IsSegmentCached(startSegIndex, fi)) {
+        ++startSegIndex;
+    }
+    while (endSegIndex > startSegIndex &&
+           IsSegmentCached(endSegIndex - 1, fi)) {
+        --endSegIndex;
+    }
+    if (startSegIndex == endSegIndex) {
+        FinishPrefetch(true);
+        return;
+    }
+
+    // 预取期间segment可能被discard归还，chunk信息被置为未分配，
+    // 这时预取到的是旧信息，不能再写回metacache
+    uint64_t epoch = metaCache_->GetChunkInfoEpoch();
+    std::vector<SegmentInfo> segInfos;
+    LIBCURVE_ERROR ret = mdsClient_->GetSegments(
+        startSegIndex * fi.segmentsize, endSegIndex - startSegIndex,
+        allocate, &fi, &segInfos);
+    if (ret != LIBCURVE_ERROR::OK) {
+        LOG(WARNING) << "prefetch segments failed, filename = "
+                     << fi.fullPathName
+                     << ", start segment = " << startSegIndex
+                     << ", end segment = " << endSegIndex
+                     << ", allocate = " << allocate
+                     << ", error = " << ret;
+        FinishPrefetch(false);
+        return;
+    }
+
+    // 先更新copyset信息再更新chunk信息，保证IO从metacache中查到chunk时
+    // 对应的copyset已经可用
+    std::map<LogicPoolID, std::set<CopysetID>> copysets;
+    for (const auto& segInfo : segInfos) {
+        copysets[segInfo.lpcpIDInfo.lpid].insert(
+            segInfo.lpcpIDInfo.cpidVec.begin(),
+            segInfo.lpcpIDInfo.cpidVec.end());
+    }
+    for (const auto& item : copysets) {
+        if (!PrefetchCopysets(item.first, item.second)) {
+            FinishPrefetch(false);
+            return;
+        }
+    }
+
+    for (const auto& segInfo : segInfos) {
+        ChunkIndex chunkIdx = segInfo.startoffset / fi.chunksize;
+        if (!metaCache_->UpdateChunkInfoIfEpochMatch(chunkIdx,
+                                                     segInfo.chunkvec,
+                                                     epoch)) {
+            LOG(INFO) << "chunk info changed during prefetch, filename = "
+                      << fi.fullPathName
+                      << ", start segment = " << startSegIndex
+                      << ", end segment = " << endSegIndex;
+            FinishPrefetch(false);
+            return;
+        }
+    }
+
+    VLOG(3) << "prefetch segments success, filename = " << fi.fullPathName
+            << ", start segment = " << startSegIndex
+            << ", end segment = " << endSegIndex
+            << ", allocate = " << allocate
+            << ", allocated segments = " << segInfos.size();
+    FinishPrefetch(true);
+}
+
+bool SegmentPrefetcher::IsSegmentCached(uint64_t segIndex, const FInfo& fi) {
+    ChunkIDInfo chunkIdInfo;
+    ChunkIndex chunkIdx = segIndex * fi.segmentsize / fi.chunksize;
+    return metaCache_->GetChunkInfoByIndex(chunkIdx, &chunkIdInfo) ==
+           MetaCacheErrorType::OK;
+}
+
+bool SegmentPrefetcher::PrefetchCopysets(LogicPoolID lpid,
+                                         const std::set<CopysetID>& cpids) {
+    std::vector<CopysetID> unknownCopysets;
+    for (const auto& cpid : cpids) {
+        if (!metaCache_->GetCopysetinfo(lpid, cpid).IsValid()) {
+            unknownCopysets.push_back(cpid);
+        }
+    }
+
+    if (!unknownCopysets.empty()) {
+        std::vector<CopysetInfo> copysetInfos;
+        LIBCURVE_ERROR ret = mdsClient_->GetServerList(lpid, unknownCopysets,
+                                                       &copysetInfos);
+        if (ret != LIBCURVE_ERROR::OK) {
+            LOG(WARNING) << "prefetch copyset server list failed"
+                         << ", logicpool id = " << lpid;
+            return false;
+        }
+
+        for (const auto& copysetInfo : copysetInfos) {
+            for (const auto& peerInfo : copysetInfo.csinfos_) {
+                metaCache_->AddCopysetIDInfo(
+                    peerInfo.chunkserverID,
+                    CopysetIDInfo(lpid, copysetInfo.cpid_));
+            }
+            metaCache_->UpdateCopysetInfo(lpid, copysetInfo.cpid_,
+                                          copysetInfo);
+        }
+    }
+
+    // leader获取失败不影响预取，IO下发时会重新获取
+    for (const auto& cpid : cpids) {
+        if (metaCache_->GetCopysetinfo(lpid, cpid).GetCurrentLeaderIndex()
+            >= 0) {
+            continue;
+        }
+        ChunkServerID csid;
+        EndPoint ep;
+        metaCache_->GetLeader(lpid, cpid, &csid, &ep, true);
+    }
+
+    return true;
+}
+
+void SegmentPrefetcher::FinishPrefetch(bool success) {
+    std::lock_guard<std::mutex> lk(mtx_);
+    prefetching_ = false;
+    if (!success) {
+        // 下次顺序IO时重新预取
+        prefetchEnd_ = 0;
+    }
+}
+
+}   // namespace client
+}   // namespace curve
@@ -0,0 +1,125 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#ifndef SRC_CLIENT_SEGMENT_PREFETCHER_H_
+#define SRC_CLIENT_SEGMENT_PREFETCHER_H_
+
+#include <mutex>  // NOLINT
+#include <set>
+#include <vector>
+
+#include "src/client/client_common.h"
+#include "src/client/config_info.h"
+#include "src/client/mds_client.h"
+#include "src/client/metacache.h"
+#include "src/common/concurrent/task_thread_pool.h"
+
+namespace curve {
+namespace client {
+
+/**
+ * segment元数据预取
+ *
+ * IO第一次访问某个segment时，splitor需要同步向mds查询segment的chunk信息以及
+ * copyset的chunkserver列表，然后再获取leader，顺序读写时每跨过一个segment
+ * IO就要等待这几次rpc。预取器根据IO的offset检测顺序访问，在后台通过
+ * GetSegments批量获取当前segment之后的prefetchSegmentNum个segment，
+ * 并提前获取其中copyset的chunkserver列表和leader，更新到metacache中。
+ *
+ * 默认只预取已经分配的segment，未分配的segment仍然由IO路径处理；开启
+ * prefetchAllocateSegment后，顺序写触发的预取会让mds一并分配后续的segment，
+ * 首次顺序写也不需要每个segment同步分配一次。
+ * 同一时间最多只有一个预取任务，剩余的预取量不足一半时才发起下一次预取。
+ */
+class SegmentPrefetcher {
+ public:
+    SegmentPrefetcher();
+    ~SegmentPrefetcher() = default;
+
+    /**
+     * @brief 初始化并启动后台线程
+     * @param option 预取的配置信息
+     * @param metaCache 预取的信息更新到metacache
+     * @param mdsClient 向mds获取segment信息，为nullptr时不预取
+     * @return 成功返回0，失败返回-1
+     */
+    int Init(const SegmentPrefetchOption& option,
+             MetaCache* metaCache,
+             MDSClient* mdsClient);
+
+    /**
+     * @brief 停止预取，等待正在执行的预取任务结束
+     */
+    void UnInit();
+
+    /**
+     * @brief 读写IO下发时调用，检测到顺序IO时在后台预取后续的segment
+     * @param offset IO在文件内的偏移
+     * @param length IO的长度
+     * @param type IO的类型，写IO才会预分配segment
+     */
+    void OnIO(off_t offset, size_t length, OpType type);
+
+ private:
+    /**
+     * @brief 预取[startSegIndex, endSegIndex)范围内的segment
+     * @param allocate 是否分配其中还未分配的segment
+     */
+    void Prefetch(uint64_t startSegIndex, uint64_t endSegIndex,
+                  bool allocate);
+
+    /**
+     * @brief segment的chunk信息是否已经在metacache中
+     */
+    bool IsSegmentCached(uint64_t segIndex, const FInfo& fi);
+
+    /**
+     * @brief 获取copyset的chunkserver列表，以及leader信息，更新到metacache
+     * @param lpid 逻辑池id
+     * @param cpids segment中的copyset
+     * @return 成功返回true，获取chunkserver列表失败返回false
+     */
+    bool PrefetchCopysets(LogicPoolID lpid, const std::set<CopysetID>& cpids);
+
+    void FinishPrefetch(bool success);
+
+ private:
+    SegmentPrefetchOption option_;
+    MetaCache* metaCache_;
+    MDSClient* mdsClient_;
+
+    // 保护下面的状态
+    std::mutex mtx_;
+    bool enabled_;
+    // 上一个IO的结束位置，用于检测顺序IO
+    uint64_t lastIOEnd_;
+    // 已经发起预取的segment范围的结束位置
+    uint64_t prefetchEnd_;
+    // 是否有正在执行的预取任务
+    bool prefetching_;
+
+    // 执行预取任务的后台线程，避免阻塞IO
+    curve::common::TaskThreadPool<> taskPool_;
+};
+
+}   // namespace client
+}   // namespace curve
+
+#endif  // SRC_CLIENT_SEGMENT_PREFETCHER_H_
@@ -78,6 +78,13 @@ void ServiceHelper::ProtoFileInfo2Local(const curve::mds::FileInfo* finfo,
     if (finfo->has_clonelength()) {
         fi->cloneLength = finfo->clonelength();
     }
+    if (finfo->has_throttleparams()) {
+        const auto& params = finfo->throttleparams();
+        fi->throttleParams.iopsLimit = params.iopslimit();
+        fi->throttleParams.iopsBurst = params.iopsburst();
+        fi->throttleParams.bpsLimit = params.bpslimit();
+        fi->throttleParams.bpsBurst = params.bpsburst();
+    }
 }
 
 class GetLeaderProxy : public std::enable_shared_from_this<GetLeaderProxy> {
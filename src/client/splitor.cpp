@@ -128,7 +128,10 @@ int Splitor::SingleChunkIO2ChunkRequests(
     uint64_t currentOffset = offset;
     uint64_t leftLength = length;
     while (leftLength > 0) {
-        uint64_t requestLength = std::min(leftLength, maxSplitSizeBytes);
+        // discard carries no data, so it is sent as a whole
+        uint64_t requestLength = iotracker->Optype() == OpType::DISCARD
+                                     ? leftLength
+                                     : std::min(leftLength, maxSplitSizeBytes);
 
         RequestContext* newreqNode = RequestContext::NewInitedRequestContext();
         if (newreqNode == nullptr) {
@@ -183,8 +186,9 @@ bool Splitor::AssignInternal(IOTracker* iotracker, MetaCache* metaCache,
     if (errCode == MetaCacheErrorType::CHUNKINFO_NOT_FOUND ||
        (errCode == MetaCacheErrorType::OK && !chunkIdInfo.chunkExist &&
        iotracker->Optype() == OpType::WRITE)) {
-        bool isAllocateSegment =
-            iotracker->Optype() == OpType::READ ? false : true;
+        // only write allocates segment, read and discard on the
+        // unallocated segment need nothing to do
+        bool isAllocateSegment = iotracker->Optype() == OpType::WRITE;
         if (false == GetOrAllocateSegment(
                          isAllocateSegment,
                          static_cast<uint64_t>(chunkidx) * fileinfo->chunksize,
@@ -196,6 +200,12 @@ bool Splitor::AssignInternal(IOTracker* iotracker, MetaCache* metaCache,
     }
 
     if (errCode == MetaCacheErrorType::OK) {
+        // the chunk is not allocated, there is nothing to discard
+        if (iotracker->Optype() == OpType::DISCARD &&
+            !chunkIdInfo.chunkExist) {
+            return true;
+        }
+
         int ret = 0;
         uint64_t appliedindex_ = 0;
 
@@ -214,6 +224,7 @@ bool Splitor::AssignInternal(IOTracker* iotracker, MetaCache* metaCache,
             ctx->appliedindex_ = appliedindex_;
             ctx->sourceInfo_ =
                 CalcRequestSourceInfo(iotracker, metaCache, chunkidx);
+            ctx->sourceInfo_.fileId = fileinfo->id;
         }
 
         targetlist->insert(targetlist->end(), templist.begin(),
@@ -0,0 +1,257 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+
+#include <butil/third_party/snappy/snappy.h>
+#include <glog/logging.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "src/common/compressed_object.h"
+#include "src/common/crc32.h"
+
+namespace curve {
+namespace common {
+
+namespace {
+
+const char kMagic[] = "CURVECMP";
+const uint32_t kMagicLen = 8;
+// magic(8) + type(1) + reserved(3) + frameSize(4) + frameNum(4) + crc(4)
+const uint32_t kFixedLen = 24;
+const uint32_t kTypeOffset = 8;
+const uint32_t kFrameSizeOffset = 12;
+const uint32_t kFrameNumOffset = 16;
+const uint32_t kCrcOffset = 20;
+
+inline void EncodeUint32(char *buf, uint32_t value) {
+    buf[0] = (value >> 24) & 0xff;
+    buf[1] = (value >> 16) & 0xff;
+    buf[2] = (value >> 8) & 0xff;
+    buf[3] = value & 0xff;
+}
+
+inline uint32_t DecodeUint32(const char *buf) {
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(buf);
+    return (static_cast<uint32_t>(p[0]) << 24) |
+           (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) |
+           static_cast<uint32_t>(p[3]);
+}
+
+// header中除crc以外所有内容的crc
+inline uint32_t HeaderCrc(const char *buf, size_t len) {
+    uint32_t crc = CRC32(buf, kCrcOffset);
+    return CRC32(crc, buf + kFixedLen, len - kFixedLen);
+}
+
+}  // namespace
+
+bool StringToCompressType(const std::string &str, CompressType *type) {
+    if (str == "none") {
+        *type = CompressType::None;
+    } else if (str == "snappy") {
+        *type = CompressType::Snappy;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+CompressedObjectHeader::CompressedObjectHeader()
+    : type_(CompressType::None),
+      frameSize_(0) {
+    BuildFrameOffsets();
+}
+
+CompressedObjectHeader::CompressedObjectHeader(
+    CompressType type,
+    uint32_t frameSize,
+    const std::vector<uint32_t> &frameLens)
+    : type_(type),
+      frameSize_(frameSize),
+      frameLens_(frameLens) {
+    BuildFrameOffsets();
+}
+
+void CompressedObjectHeader::BuildFrameOffsets() {
+    frameOffsets_.resize(frameLens_.size() + 1);
+    uint64_t offset = GetHeaderLength();
+    for (size_t i = 0; i < frameLens_.size(); ++i) {
+        frameOffsets_[i] = offset;
+        offset += frameLens_[i];
+    }
+    frameOffsets_[frameLens_.size()] = offset;
+}
+
+uint32_t CompressedObjectHeader::GetHeaderLength() const {
+    return kFixedLen + sizeof(uint32_t) * frameLens_.size();
+}
+
+bool CompressedObjectHeader::HasMagic(const char *buf, size_t len) {
+    return len >= kMagicLen && memcmp(buf, kMagic, kMagicLen) == 0;
+}
+
+uint32_t CompressedObjectHeader::GetHeaderLength(const char *buf,
+                                                 size_t len,
+                                                 uint64_t maxDataLength) {
+    if (len < kFixedLen || !HasMagic(buf, len)) {
+        return 0;
+    }
+    uint64_t frameSize = DecodeUint32(buf + kFrameSizeOffset);
+    uint64_t frameNum = DecodeUint32(buf + kFrameNumOffset);
+    if (frameSize == 0 || frameNum > maxDataLength / frameSize) {
+        LOG(WARNING) << "invalid compressed object header, frame size = "
+                     << frameSize << ", frame num = " << frameNum
+                     << ", max data length = " << maxDataLength;
+        return 0;
+    }
+    uint64_t headerLen = kFixedLen + sizeof(uint32_t) * frameNum;
+    if (headerLen > UINT32_MAX) {
+        LOG(WARNING) << "compressed object header too long, frame num = "
+                     << frameNum;
+        return 0;
+    }
+    return headerLen;
+}
+
+void CompressedObjectHeader::Encode(std::string *out) const {
+    out->assign(GetHeaderLength(), 0);
+    char *buf = &(*out)[0];
+    memcpy(buf, kMagic, kMagicLen);
+    buf[kTypeOffset] = static_cast<char>(type_);
+    EncodeUint32(buf + kFrameSizeOffset, frameSize_);
+    EncodeUint32(buf + kFrameNumOffset, frameLens_.size());
+    for (size_t i = 0; i < frameLens_.size(); ++i) {
+        EncodeUint32(buf + kFixedLen + sizeof(uint32_t) * i, frameLens_[i]);
+    }
+    EncodeUint32(buf + kCrcOffset, HeaderCrc(buf, out->size()));
+}
+
+bool CompressedObjectHeader::Decode(const char *buf, size_t len,
+                                    uint64_t maxDataLength) {
+    uint32_t headerLen = GetHeaderLength(buf, len, maxDataLength);
+    if (headerLen == 0 || len < headerLen) {
+        return false;
+    }
+    if (DecodeUint32(buf + kCrcOffset) != HeaderCrc(buf, headerLen)) {
+        LOG(ERROR) << "compressed object header crc mismatch";
+        return false;
+    }
+
+    CompressType type = static_cast<CompressType>(buf[kTypeOffset]);
+    if (type != CompressType::None && type != CompressType::Snappy) {
+        LOG(ERROR) << "unknown compress type "
+                   << static_cast<int>(buf[kTypeOffset]);
+        return false;
+    }
+    uint32_t frameSize = DecodeUint32(buf + kFrameSizeOffset);
+    uint32_t frameNum = DecodeUint32(buf + kFrameNumOffset);
+    std::vector<uint32_t> frameLens(frameNum);
+    for (uint32_t i = 0; i < frameNum; ++i) {
+        frameLens[i] = DecodeUint32(buf + kFixedLen + sizeof(uint32_t) * i);
+        if (frameLens[i] == 0 || frameLens[i] > frameSize) {
+            LOG(ERROR) << "invalid frame length " << frameLens[i]
+                       << ", frame size = " << frameSize;
+            return false;
+        }
+    }
+
+    type_ = type;
+    frameSize_ = frameSize;
+    frameLens_.swap(frameLens);
+    BuildFrameOffsets();
+    return true;
+}
+
+bool CompressedObjectHeader::GetFrameRange(uint64_t offset, uint64_t len,
+                                           uint32_t *begin,
+                                           uint32_t *end) const {
+    if (len == 0 || offset + len > GetDataLength()) {
+        return false;
+    }
+    *begin = offset / frameSize_;
+    *end = (offset + len - 1) / frameSize_ + 1;
+    return true;
+}
+
+bool CompressedObjectHeader::DecompressFrames(const char *data,
+                                              uint32_t begin,
+                                              uint32_t end,
+                                              uint64_t offset,
+                                              uint64_t len,
+                                              char *buf) const {
+    std::string frame(frameSize_, 0);
+    for (uint32_t i = begin; i < end; ++i) {
+        const char *src = data + frameOffsets_[i] - frameOffsets_[begin];
+        if (!DecompressFrame(type_, src, frameLens_[i],
+                             frameSize_, &frame[0])) {
+            LOG(ERROR) << "decompress frame " << i << " failed";
+            return false;
+        }
+
+        // frame与[offset, offset + len)重叠的部分
+        uint64_t frameStart = static_cast<uint64_t>(i) * frameSize_;
+        uint64_t copyStart = std::max(frameStart, offset);
+        uint64_t copyEnd = std::min(frameStart + frameSize_, offset + len);
+        memcpy(buf + copyStart - offset,
+               frame.data() + copyStart - frameStart,
+               copyEnd - copyStart);
+    }
+    return true;
+}
+
+void CompressFrame(CompressType type, const char *buf, size_t len,
+                   std::string *out) {
+    out->clear();
+    if (type == CompressType::Snappy) {
+        butil::snappy::Compress(buf, len, out);
+    }
+    // 压缩后没有变小的frame保存原始数据
+    if (out->empty() || out->size() >= len) {
+        out->assign(buf, len);
+    }
+}
+
+bool DecompressFrame(CompressType type, const char *buf, size_t len,
+                     uint32_t frameSize, char *out) {
+    if (len == frameSize) {
+        memcpy(out, buf, len);
+        return true;
+    }
+
+    switch (type) {
+    case CompressType::Snappy: {
+        size_t uncompressedLen = 0;
+        if (!butil::snappy::GetUncompressedLength(buf, len,
+                                                  &uncompressedLen) ||
+            uncompressedLen != frameSize) {
+            return false;
+        }
+        return butil::snappy::RawUncompress(buf, len, out);
+    }
+    default:
+        return false;
+    }
+}
+
+}  // namespace common
+}  // namespace curve
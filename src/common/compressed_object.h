@@ -0,0 +1,180 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+
+#ifndef SRC_COMMON_COMPRESSED_OBJECT_H_
+#define SRC_COMMON_COMPRESSED_OBJECT_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace curve {
+namespace common {
+
+enum class CompressType : uint8_t {
+    None = 0,
+    // brpc自带的snappy，与lz4同属快速的LZ77类压缩
+    Snappy = 1,
+};
+
+/**
+ * @brief 解析配置中的压缩类型
+ * @param str "none"或者"snappy"
+ * @param[out] type 解析出的压缩类型
+ * @return 成功返回true，不支持的类型返回false
+ */
+bool StringToCompressType(const std::string &str, CompressType *type);
+
+// 读取压缩对象时先读取对象开头这么多的数据，通常足够容纳整个header
+const uint32_t kCompressedObjectHeaderReadSize = 4096;
+
+/**
+ * 压缩对象的格式
+ *
+ * | header | frame 0 | frame 1 | ... | frame n-1 |
+ *
+ * 对象的原始数据按frameSize切分成frame，每个frame单独压缩，压缩后没有变小的
+ * frame保存原始数据，此时其长度等于frameSize。header中记录了每个frame压缩后
+ * 的长度，由此可以算出原始数据的任意偏移所在的frame在对象中的位置，读取一段
+ * 原始数据只需要读取并解压覆盖它的几个frame。
+ *
+ * header的格式如下，整数按大端存储：
+ * | magic(8) | type(1) | reserved(3) | frameSize(4) | frameNum(4) | crc(4) |
+ * | frameLen(4) * frameNum |
+ * crc是header中除crc以外所有内容的crc32，用于区分压缩对象和未压缩的旧对象
+ */
+class CompressedObjectHeader {
+ public:
+    CompressedObjectHeader();
+    CompressedObjectHeader(CompressType type,
+                           uint32_t frameSize,
+                           const std::vector<uint32_t> &frameLens);
+
+    /**
+     * @brief 对象开头是否为压缩对象的magic
+     *        没有magic的是未压缩的旧对象，有magic但header无效的是损坏的对象
+     * @param buf 对象开头的数据
+     * @param len buf的长度
+     */
+    static bool HasMagic(const char *buf, size_t len);
+
+    /**
+     * @brief 根据对象开头的数据计算header的长度
+     *        frameNum来自对象本身，不可信，原始数据超过maxDataLength时
+     *        认为header无效，避免计算header长度时溢出或者分配过大的内存
+     * @param buf 对象开头的数据
+     * @param len buf的长度
+     * @param maxDataLength 原始数据长度的上限，通常为chunk的大小
+     * @return header的长度，不是压缩对象或者header无效时返回0
+     */
+    static uint32_t GetHeaderLength(const char *buf, size_t len,
+                                    uint64_t maxDataLength);
+
+    void Encode(std::string *out) const;
+
+    /**
+     * @brief 解析header
+     * @param buf 对象开头的数据，长度不小于GetHeaderLength的返回值
+     * @param len buf的长度
+     * @param maxDataLength 原始数据长度的上限，同GetHeaderLength
+     * @return 成功返回true，不是压缩对象或者header损坏返回false
+     */
+    bool Decode(const char *buf, size_t len, uint64_t maxDataLength);
+
+    /**
+     * @brief 计算原始数据[offset, offset + len)所在的frame
+     * @param[out] begin 第一个frame
+     * @param[out] end 最后一个frame的下一个
+     * @return 超出原始数据的范围返回false
+     */
+    bool GetFrameRange(uint64_t offset, uint64_t len,
+                       uint32_t *begin, uint32_t *end) const;
+
+    /**
+     * @brief 解压从对象中读取的[begin, end)个frame，并将原始数据
+     *        [offset, offset + len)拷贝到buf
+     * @param data 从GetFrameOffset(begin)开始读取的frame数据
+     * @return 成功返回true，解压失败返回false
+     */
+    bool DecompressFrames(const char *data, uint32_t begin, uint32_t end,
+                          uint64_t offset, uint64_t len, char *buf) const;
+
+    CompressType GetType() const {
+        return type_;
+    }
+
+    uint32_t GetFrameSize() const {
+        return frameSize_;
+    }
+
+    uint32_t GetFrameNum() const {
+        return frameLens_.size();
+    }
+
+    uint32_t GetHeaderLength() const;
+
+    // frame在对象中的偏移，index为frameNum时返回对象的长度
+    uint64_t GetFrameOffset(uint32_t index) const {
+        return frameOffsets_[index];
+    }
+
+    // 原始数据的长度
+    uint64_t GetDataLength() const {
+        return static_cast<uint64_t>(frameSize_) * frameLens_.size();
+    }
+
+ private:
+    void BuildFrameOffsets();
+
+ private:
+    CompressType type_;
+    uint32_t frameSize_;
+    std::vector<uint32_t> frameLens_;
+    std::vector<uint64_t> frameOffsets_;
+};
+
+/**
+ * @brief 压缩一个frame
+ * @param type 压缩类型
+ * @param buf frame的原始数据
+ * @param len 原始数据的长度，即frameSize
+ * @param[out] out 压缩后的数据，压缩后没有变小时为原始数据
+ */
+void CompressFrame(CompressType type, const char *buf, size_t len,
+                   std::string *out);
+
+/**
+ * @brief 解压一个frame
+ * @param type 压缩类型
+ * @param buf 压缩后的数据
+ * @param len 压缩后的长度，等于frameSize时为原始数据
+ * @param frameSize frame的原始长度
+ * @param[out] out 解压后的数据，长度为frameSize
+ * @return 成功返回true，数据损坏返回false
+ */
+bool DecompressFrame(CompressType type, const char *buf, size_t len,
+                     uint32_t frameSize, char *out);
+
+}  // namespace common
+}  // namespace curve
+
+#endif  // SRC_COMMON_COMPRESSED_OBJECT_H_
@@ -0,0 +1,38 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <string>
+
+#include "src/common/copyset_fingerprint.h"
+#include "src/common/crc32.h"
+
+namespace curve {
+namespace common {
+
+uint32_t CopySetFingerprint(const ::curve::mds::heartbeat::CopySetInfo &info) {
+    // 性能统计每次心跳都会变化，不计入摘要
+    ::curve::mds::heartbeat::CopySetInfo copy = info;
+    copy.clear_stats();
+    std::string data = copy.SerializeAsString();
+    return CRC32(data.c_str(), data.size());
+}
+
+}  // namespace common
+}  // namespace curve
@@ -0,0 +1,42 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#ifndef SRC_COMMON_COPYSET_FINGERPRINT_H_
+#define SRC_COMMON_COPYSET_FINGERPRINT_H_
+
+#include <stdint.h>
+
+#include "proto/heartbeat.pb.h"
+
+namespace curve {
+namespace common {
+
+/**
+ * @brief 计算copyset心跳信息的摘要，用于增量心跳。chunkserver和mds
+ *        都通过该函数计算，保证两端的结果一致
+ * @param info copyset的心跳信息
+ * @return 去掉stats之后info序列化结果的crc32
+ */
+uint32_t CopySetFingerprint(const ::curve::mds::heartbeat::CopySetInfo &info);
+
+}  // namespace common
+}  // namespace curve
+
+#endif  // SRC_COMMON_COPYSET_FINGERPRINT_H_
@@ -0,0 +1,97 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <algorithm>
+
+#include "src/common/token_bucket.h"
+#include "src/common/timeutility.h"
+
+namespace curve {
+namespace common {
+
+TokenBucket::TokenBucket(uint64_t rate, uint64_t burst)
+    : rate_(rate),
+      burst_(burst == 0 ? rate : burst),
+      tokens_(burst_),
+      lastRefillUs_(TimeUtility::GetTimeofDayUs()) {}
+
+void TokenBucket::SetRate(uint64_t rate, uint64_t burst) {
+    LockGuard lock(mtx_);
+    Refill();
+    rate_ = rate;
+    burst_ = (burst == 0 ? rate : burst);
+    tokens_ = std::min(tokens_, static_cast<double>(burst_));
+}
+
+uint64_t TokenBucket::GetRate() {
+    LockGuard lock(mtx_);
+    return rate_;
+}
+
+uint64_t TokenBucket::Acquire(uint64_t tokens) {
+    LockGuard lock(mtx_);
+    if (rate_ == 0) {
+        return 0;
+    }
+
+    Refill();
+    tokens_ -= tokens;
+    if (tokens_ >= 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(-tokens_ * 1000000 / rate_);
+}
+
+bool TokenBucket::TryAcquire(uint64_t tokens) {
+    LockGuard lock(mtx_);
+    if (rate_ == 0) {
+        return true;
+    }
+
+    Refill();
+    if (tokens_ < tokens) {
+        return false;
+    }
+    tokens_ -= tokens;
+    return true;
+}
+
+void TokenBucket::Return(uint64_t tokens) {
+    LockGuard lock(mtx_);
+    if (rate_ == 0) {
+        return;
+    }
+
+    Refill();
+    tokens_ = std::min(tokens_ + tokens, static_cast<double>(burst_));
+}
+
+void TokenBucket::Refill() {
+    uint64_t now = TimeUtility::GetTimeofDayUs();
+    if (now <= lastRefillUs_) {
+        return;
+    }
+    tokens_ += static_cast<double>(now - lastRefillUs_) * rate_ / 1000000;
+    tokens_ = std::min(tokens_, static_cast<double>(burst_));
+    lastRefillUs_ = now;
+}
+
+}  // namespace common
+}  // namespace curve
@@ -0,0 +1,86 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#ifndef SRC_COMMON_TOKEN_BUCKET_H_
+#define SRC_COMMON_TOKEN_BUCKET_H_
+
+#include <stdint.h>
+
+#include "src/common/concurrent/concurrent.h"
+
+namespace curve {
+namespace common {
+
+/**
+ * 令牌桶限速
+ * 令牌按照rate匀速产生，桶中最多积攒burst个令牌。取令牌时允许透支，
+ * 透支的部分由调用方按照返回的等待时间sleep来偿还，这样大于burst的
+ * 请求也能被限速，而不会永远等不到足够的令牌。
+ */
+class TokenBucket {
+ public:
+    /**
+     * @param rate 每秒产生的令牌数，为0表示不限速
+     * @param burst 桶的容量，为0时取rate
+     */
+    TokenBucket(uint64_t rate, uint64_t burst);
+
+    /**
+     * @brief 修改限速参数，已经积攒和透支的令牌保留
+     */
+    void SetRate(uint64_t rate, uint64_t burst);
+
+    uint64_t GetRate();
+
+    /**
+     * @brief 取出tokens个令牌，令牌不足时透支
+     * @return 偿还透支需要等待的时间，单位us，令牌足够时返回0
+     */
+    uint64_t Acquire(uint64_t tokens);
+
+    /**
+     * @brief 令牌足够时取出tokens个令牌，否则不做任何操作
+     * @return 取到令牌返回true，否则返回false
+     */
+    bool TryAcquire(uint64_t tokens);
+
+    /**
+     * @brief 归还取出后没有用完的令牌，桶中的令牌不超过burst
+     */
+    void Return(uint64_t tokens);
+
+ private:
+    // 根据距离上次补充的时间补充令牌，调用方需要持有mtx_
+    void Refill();
+
+ private:
+    Mutex mtx_;
+    uint64_t rate_;
+    uint64_t burst_;
+    // 当前的令牌数，透支时为负数
+    double tokens_;
+    // 上次补充令牌的时间，单位us
+    uint64_t lastRefillUs_;
+};
+
+}  // namespace common
+}  // namespace curve
+
+#endif  // SRC_COMMON_TOKEN_BUCKET_H_
@@ -303,6 +303,41 @@ int Ext4FileSystemImpl::Read(int fd,
     return length - remainLength;
 }
 
+int Ext4FileSystemImpl::ReadToIOBuf(int fd,
+                                    butil::IOBuf* buf,
+                                    uint64_t offset,
+                                    int length) {
+    // IOPortal通过preadv直接读到IOBuf内部池化的block中
+    butil::IOPortal portal;
+    int remainLength = length;
+    int retryTimes = 0;
+    while (remainLength > 0) {
+        ssize_t ret = portal.pappend_from_file_descriptor(fd,
+                                                          offset,
+                                                          remainLength);
+        // 如果offset大于文件长度，preadv会返回0
+        if (ret == 0) {
+            LOG(WARNING) << "preadv returns zero."
+                         << "offset: " << offset
+                         << ", length: " << remainLength;
+            break;
+        }
+        if (ret < 0) {
+            if (errno == EINTR && retryTimes < MAX_RETYR_TIME) {
+                ++retryTimes;
+                continue;
+            }
+            LOG(ERROR) << "IOPortal::pappend_from_file_descriptor failed: "
+                       << strerror(errno);
+            return -errno;
+        }
+        remainLength -= ret;
+        offset += ret;
+    }
+    buf->append(portal);
+    return length - remainLength;
+}
+
 int Ext4FileSystemImpl::Write(int fd,
                               const char *buf,
                               uint64_t offset,
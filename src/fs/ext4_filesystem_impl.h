@@ -53,6 +53,8 @@ class Ext4FileSystemImpl : public LocalFileSystem {
     bool FileExists(const string& filePath) override;
     int List(const string& dirPath, vector<std::string>* names) override;
     int Read(int fd, char* buf, uint64_t offset, int length) override;
+    int ReadToIOBuf(int fd, butil::IOBuf* buf,
+                    uint64_t offset, int length) override;
     int Write(int fd, const char* buf, uint64_t offset, int length) override;
     int Write(int fd, butil::IOBuf buf, uint64_t offset, int length) override;
     int Append(int fd, const char* buf, int length) override;
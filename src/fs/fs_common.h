@@ -29,6 +29,8 @@ namespace fs {
 enum class FileSystemType {
     // SFS,
     EXT4,
+    // 元数据操作同EXT4，数据读写通过io_uring提交
+    EXT4_IOURING,
 };
 
 struct FileSystemInfo {
@@ -0,0 +1,778 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <glog/logging.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <limits.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "src/common/concurrent/count_down_event.h"
+#include "src/fs/ext4_filesystem_impl.h"
+#include "src/fs/io_uring_filesystem_impl.h"
+
+namespace curve {
+namespace fs {
+
+using ::curve::common::CountDownEvent;
+
+namespace {
+
+int sys_io_uring_setup(unsigned entries, struct io_uring_params* p) {
+    return ::syscall(__NR_io_uring_setup, entries, p);
+}
+
+int sys_io_uring_enter(int fd, unsigned toSubmit,
+                       unsigned minComplete, unsigned flags) {
+    return ::syscall(__NR_io_uring_enter, fd, toSubmit,
+                     minComplete, flags, nullptr, 0);
+}
+
+int sys_io_uring_register(int fd, unsigned opcode,
+                          const void* arg, unsigned nrArgs) {
+    return ::syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs);
+}
+
+// 已经完成n个字节的读写，调整iovec数组，返回剩余的iovec个数
+int AdvanceIovec(struct iovec** iov, int iovcnt, size_t n) {
+    while (iovcnt > 0 && n >= (*iov)->iov_len) {
+        n -= (*iov)->iov_len;
+        ++(*iov);
+        --iovcnt;
+    }
+    if (iovcnt > 0 && n > 0) {
+        (*iov)->iov_base = static_cast<char*>((*iov)->iov_base) + n;
+        (*iov)->iov_len -= n;
+    }
+    return iovcnt;
+}
+
+}  // namespace
+
+struct IoUringRequest {
+    uint8_t opcode;
+    int fd;
+    uint64_t offset;
+    int length;
+    // 已经完成的字节数
+    int done;
+    int retryTimes;
+    // 向量读写的iovec，iov指向第一个还没有完成的iovec
+    std::vector<struct iovec> iovs;
+    struct iovec* iov;
+    int iovcnt;
+    // 固定buffer读写的buffer地址及下标，非fixed操作下标为-1
+    char* fixedBuf;
+    int bufIndex;
+    // 异步写持有写入的数据，保证iovec指向的内存在完成前有效
+    butil::IOBuf data;
+    // 完成回调，参数为读写的字节数或者-errno
+    WriteCallback callback;
+    // 由reap线程在调用回调前释放
+    bool detached;
+
+    IoUringRequest(uint8_t op, int f, uint64_t off, int len)
+        : opcode(op), fd(f), offset(off), length(len), done(0),
+          retryTimes(0), iov(nullptr), iovcnt(0), fixedBuf(nullptr),
+          bufIndex(-1), detached(false) {}
+
+    bool IsWrite() const {
+        return opcode == IORING_OP_WRITEV || opcode == IORING_OP_WRITE_FIXED;
+    }
+
+    void SetIovec(const char* buf, int len) {
+        struct iovec vec;
+        vec.iov_base = const_cast<char*>(buf);
+        vec.iov_len = len;
+        iovs.push_back(vec);
+        iov = iovs.data();
+        iovcnt = iovs.size();
+    }
+
+    // 以IOBuf的block作为iovec，调用方需要保证block个数不超过IOV_MAX
+    void SetIovec(const butil::IOBuf& buf) {
+        size_t blockNum = buf.backing_block_num();
+        iovs.reserve(blockNum);
+        size_t remain = length;
+        for (size_t i = 0; i < blockNum && remain > 0; ++i) {
+            auto block = buf.backing_block(i);
+            struct iovec vec;
+            vec.iov_base = const_cast<char*>(block.data());
+            vec.iov_len = std::min(remain, block.size());
+            remain -= vec.iov_len;
+            iovs.push_back(vec);
+        }
+        iov = iovs.data();
+        iovcnt = iovs.size();
+    }
+};
+
+std::shared_ptr<IoUringFileSystemImpl> IoUringFileSystemImpl::self_ = nullptr;
+std::mutex IoUringFileSystemImpl::mutex_;
+
+IoUringFileSystemImpl::IoUringFileSystemImpl(
+    std::shared_ptr<LocalFileSystem> base)
+    : base_(base)
+    , ringFd_(-1)
+    , sqRingPtr_(MAP_FAILED)
+    , sqRingSize_(0)
+    , cqRingPtr_(MAP_FAILED)
+    , cqRingSize_(0)
+    , sqes_(static_cast<struct io_uring_sqe*>(MAP_FAILED))
+    , sqesSize_(0)
+    , sqHead_(nullptr)
+    , sqTail_(nullptr)
+    , sqMask_(nullptr)
+    , sqArray_(nullptr)
+    , sqEntries_(0)
+    , cqHead_(nullptr)
+    , cqTail_(nullptr)
+    , cqMask_(nullptr)
+    , cqes_(nullptr)
+    , inflight_(0)
+    , fixedBufferBase_(nullptr)
+    , fixedBufferSize_(0)
+    , fixedBufferNum_(0)
+    , buffersReleased_(false)
+    , running_(false) {
+    CHECK(base_ != nullptr) << "Base local fs is null";
+}
+
+IoUringFileSystemImpl::~IoUringFileSystemImpl() {
+    Fini();
+}
+
+std::shared_ptr<IoUringFileSystemImpl> IoUringFileSystemImpl::getInstance() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (self_ == nullptr) {
+        self_ = std::shared_ptr<IoUringFileSystemImpl>(
+            new(std::nothrow) IoUringFileSystemImpl(
+                Ext4FileSystemImpl::getInstance()));
+        CHECK(self_ != nullptr) << "Failed to new io_uring local fs.";
+    }
+    return self_;
+}
+
+int IoUringFileSystemImpl::Init(const LocalFileSystemOption& option) {
+    int rc = base_->Init(option);
+    if (rc < 0) {
+        return rc;
+    }
+    if (running_.load()) {
+        return 0;
+    }
+
+    if (option.ioUringQueueDepth == 0) {
+        LOG(ERROR) << "io_uring queue depth must be greater than 0.";
+        return -EINVAL;
+    }
+    rc = SetupRing(option.ioUringQueueDepth);
+    if (rc < 0) {
+        ReleaseRing();
+        return rc;
+    }
+    RegisterFixedBuffers(option.ioUringFixedBufferNum,
+                         option.ioUringFixedBufferSize);
+
+    running_.store(true);
+    reapThread_ = std::thread(&IoUringFileSystemImpl::ReapLoop, this);
+    LOG(INFO) << "Init io_uring local fs success"
+              << ", queue depth: " << sqEntries_
+              << ", fixed buffer num: " << fixedBufferNum_
+              << ", fixed buffer size: " << fixedBufferSize_;
+    return 0;
+}
+
+int IoUringFileSystemImpl::SetupRing(uint32_t queueDepth) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ringFd_ = sys_io_uring_setup(queueDepth, &params);
+    if (ringFd_ < 0) {
+        // 5.12之前的内核ring的内存也计入RLIMIT_MEMLOCK
+        int err = errno;
+        LOG(ERROR) << "io_uring_setup failed: " << strerror(err)
+                   << (err == ENOMEM ? ", RLIMIT_MEMLOCK may be too low "
+                       "for the ring, try a smaller fs.io_uring_queue_depth"
+                       : "");
+        return -err;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    cqRingSize_ = params.cq_off.cqes +
+                  params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        sqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+        cqRingSize_ = sqRingSize_;
+    }
+
+    sqRingPtr_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQ_RING);
+    if (sqRingPtr_ == MAP_FAILED) {
+        LOG(ERROR) << "mmap io_uring sq ring failed: " << strerror(errno);
+        return -errno;
+    }
+    if (singleMmap) {
+        cqRingPtr_ = sqRingPtr_;
+    } else {
+        cqRingPtr_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ringFd_,
+                          IORING_OFF_CQ_RING);
+        if (cqRingPtr_ == MAP_FAILED) {
+            LOG(ERROR) << "mmap io_uring cq ring failed: " << strerror(errno);
+            return -errno;
+        }
+    }
+
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = static_cast<struct io_uring_sqe*>(
+        mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES));
+    if (sqes_ == MAP_FAILED) {
+        LOG(ERROR) << "mmap io_uring sqes failed: " << strerror(errno);
+        return -errno;
+    }
+
+    char* sq = static_cast<char*>(sqRingPtr_);
+    sqHead_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+    sqMask_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+    sqEntries_ = params.sq_entries;
+
+    char* cq = static_cast<char*>(cqRingPtr_);
+    cqHead_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+    cqMask_ = reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+    return 0;
+}
+
+void IoUringFileSystemImpl::RegisterFixedBuffers(uint32_t num, uint32_t size) {
+    if (num == 0 || size == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lk(bufferMutex_);
+    if (fixedBufferBase_ != nullptr) {
+        // 上次Fini时挂在IOBuf上的buffer还没有全部归还
+        LOG(WARNING) << "Fixed buffers of the last ring are still in use, "
+                     << "will read without fixed buffers.";
+        return;
+    }
+    // 注册的buffer会被锁定在内存中，超过RLIMIT_MEMLOCK时注册必然失败，
+    // 提前检查以给出明确的提示
+    uint64_t total = static_cast<uint64_t>(num) * size;
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0
+        && limit.rlim_cur != RLIM_INFINITY && total > limit.rlim_cur) {
+        LOG(WARNING) << "io_uring fixed buffers need " << total
+                     << " bytes of locked memory, but RLIMIT_MEMLOCK is "
+                     << limit.rlim_cur << " bytes, will read without fixed "
+                     << "buffers. Raise the limit or set "
+                     << "fs.io_uring_fixed_buffer_num to 0.";
+        return;
+    }
+
+    const size_t kAlignment = 4096;
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, kAlignment, total) != 0) {
+        LOG(WARNING) << "Alloc io_uring fixed buffers failed, size: "
+                     << total << ", will read without fixed buffers.";
+        return;
+    }
+    char* base = static_cast<char*>(ptr);
+    std::vector<struct iovec> iovs(num);
+    for (uint32_t i = 0; i < num; ++i) {
+        iovs[i].iov_base = base + static_cast<uint64_t>(i) * size;
+        iovs[i].iov_len = size;
+    }
+    int rc = sys_io_uring_register(ringFd_, IORING_REGISTER_BUFFERS,
+                                   iovs.data(), iovs.size());
+    if (rc < 0) {
+        LOG(WARNING) << "Register io_uring fixed buffers failed: "
+                     << strerror(errno) << ", size: " << total
+                     << ", RLIMIT_MEMLOCK: " << limit.rlim_cur
+                     << ", will read without fixed buffers.";
+        free(base);
+        return;
+    }
+    fixedBufferBase_ = base;
+    fixedBufferSize_ = size;
+    fixedBufferNum_ = num;
+    buffersReleased_ = false;
+    freeBuffers_.clear();
+    for (uint32_t i = 0; i < num; ++i) {
+        freeBuffers_.push_back(i);
+    }
+}
+
+void IoUringFileSystemImpl::Fini() {
+    std::unique_lock<std::mutex> lk(sqMutex_);
+    if (running_.load()) {
+        // 先停止接收新的请求，唤醒等待sq空位的提交方，使其返回-ESHUTDOWN
+        running_.store(false);
+        sqCond_.notify_all();
+        // 等待已经提交的请求全部完成，reap线程在此期间继续收割
+        sqCond_.wait(lk, [this] { return inflight_ == 0; });
+
+        // 提交一个user_data为0的NOP，reap线程收到后退出
+        uint32_t tail = *sqTail_;
+        uint32_t index = tail & *sqMask_;
+        struct io_uring_sqe* sqe = &sqes_[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = 0;
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        ++inflight_;
+        int rc = 0;
+        do {
+            rc = sys_io_uring_enter(ringFd_, 1, 0, 0);
+        } while (rc < 0 && errno == EINTR);
+        if (rc < 0) {
+            // 无法通知reap线程退出，分离该线程并保留ring不释放，
+            // 避免线程访问已经unmap的内存
+            LOG(ERROR) << "Submit io_uring exit request failed: "
+                       << strerror(errno);
+            reapThread_.detach();
+            ringFd_ = -1;
+            sqRingPtr_ = MAP_FAILED;
+            cqRingPtr_ = MAP_FAILED;
+            sqes_ = static_cast<struct io_uring_sqe*>(MAP_FAILED);
+        } else {
+            lk.unlock();
+            if (reapThread_.joinable()) {
+                reapThread_.join();
+            }
+        }
+    }
+    // running_已经为false，提交方拿到sqMutex_后直接返回，不会再访问ring；
+    // 释放ring时需要等待固定buffer归还，不能持有sqMutex_
+    if (lk.owns_lock()) {
+        lk.unlock();
+    }
+    ReleaseRing();
+}
+
+void IoUringFileSystemImpl::ReleaseRing() {
+    if (sqes_ != MAP_FAILED) {
+        munmap(sqes_, sqesSize_);
+        sqes_ = static_cast<struct io_uring_sqe*>(MAP_FAILED);
+    }
+    if (cqRingPtr_ != MAP_FAILED && cqRingPtr_ != sqRingPtr_) {
+        munmap(cqRingPtr_, cqRingSize_);
+    }
+    cqRingPtr_ = MAP_FAILED;
+    if (sqRingPtr_ != MAP_FAILED) {
+        munmap(sqRingPtr_, sqRingSize_);
+        sqRingPtr_ = MAP_FAILED;
+    }
+    if (ringFd_ >= 0) {
+        // 关闭ring时内核会自动注销固定buffer
+        ::close(ringFd_);
+        ringFd_ = -1;
+    }
+    // 挂在IOBuf上的固定buffer可能还没有归还，全部归还后再释放内存
+    std::lock_guard<std::mutex> lk(bufferMutex_);
+    if (fixedBufferBase_ == nullptr) {
+        return;
+    }
+    buffersReleased_ = true;
+    if (freeBuffers_.size() == fixedBufferNum_) {
+        free(fixedBufferBase_);
+        fixedBufferBase_ = nullptr;
+        fixedBufferNum_ = 0;
+        fixedBufferSize_ = 0;
+        freeBuffers_.clear();
+    }
+}
+
+void IoUringFileSystemImpl::ReapLoop() {
+    const int ringFd = ringFd_;
+    bool exit = false;
+    std::vector<IoUringRequest*> completed;
+    std::vector<IoUringRequest*> resubmit;
+    while (!exit) {
+        int rc = sys_io_uring_enter(ringFd, 0, 1, IORING_ENTER_GETEVENTS);
+        if (rc < 0 && errno != EINTR) {
+            LOG(ERROR) << "io_uring wait completion failed: "
+                       << strerror(errno);
+        }
+
+        uint32_t head = *cqHead_;
+        uint32_t tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        uint32_t reaped = 0;
+        for (; head != tail; ++head) {
+            struct io_uring_cqe* cqe = &cqes_[head & *cqMask_];
+            ++reaped;
+            if (cqe->user_data == 0) {
+                exit = true;
+                continue;
+            }
+            IoUringRequest* req =
+                reinterpret_cast<IoUringRequest*>(cqe->user_data);
+            if (OnComplete(req, cqe->res)) {
+                resubmit.push_back(req);
+            } else {
+                completed.push_back(req);
+            }
+        }
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+
+        if (reaped > 0) {
+            std::lock_guard<std::mutex> lk(sqMutex_);
+            inflight_ -= reaped;
+            // 重新提交的请求复用刚刚释放的位置，不需要等待sq的空位，
+            // Fini时inflight_也不会在重新提交前降为0
+            for (auto req : resubmit) {
+                uint32_t sqTail = *sqTail_;
+                PrepareSqe(req);
+                do {
+                    rc = sys_io_uring_enter(ringFd, 1, 0, 0);
+                } while (rc < 0 && errno == EINTR);
+                if (rc < 0) {
+                    req->done = -errno;
+                    __atomic_store_n(sqTail_, sqTail, __ATOMIC_RELEASE);
+                    LOG(ERROR) << "io_uring resubmit failed: "
+                               << strerror(-req->done);
+                    completed.push_back(req);
+                    continue;
+                }
+                ++inflight_;
+            }
+            sqCond_.notify_all();
+        }
+        resubmit.clear();
+
+        // 回调在释放sq位置之后执行，回调中可以继续提交异步请求
+        for (auto req : completed) {
+            WriteCallback callback = std::move(req->callback);
+            int result = req->done;
+            if (req->detached) {
+                delete req;
+            }
+            callback(result);
+        }
+        completed.clear();
+    }
+}
+
+bool IoUringFileSystemImpl::OnComplete(IoUringRequest* req, int res) {
+    if (res < 0) {
+        if ((res == -EINTR || res == -EAGAIN)
+            && req->retryTimes < MAX_RETYR_TIME) {
+            ++req->retryTimes;
+            return true;
+        }
+        LOG(ERROR) << (req->IsWrite() ? "io_uring write" : "io_uring read")
+                   << " failed: " << strerror(-res)
+                   << ", offset: " << req->offset + req->done
+                   << ", length: " << req->length - req->done;
+        req->done = res;
+        return false;
+    }
+    if (res == 0) {
+        // 写不应该返回0，避免重复提交造成死循环
+        if (req->IsWrite()) {
+            LOG(ERROR) << "io_uring write returns zero."
+                       << "offset: " << req->offset + req->done
+                       << ", length: " << req->length - req->done;
+            req->done = -EIO;
+            return false;
+        }
+        // 如果offset大于文件长度，读会返回0
+        LOG(WARNING) << "io_uring read returns zero."
+                     << "offset: " << req->offset + req->done
+                     << ", length: " << req->length - req->done;
+        return false;
+    }
+    req->done += res;
+    if (req->done >= req->length) {
+        return false;
+    }
+    if (req->bufIndex < 0) {
+        req->iovcnt = AdvanceIovec(&req->iov, req->iovcnt, res);
+        if (req->iovcnt == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void IoUringFileSystemImpl::PrepareSqe(IoUringRequest* req) {
+    uint32_t tail = *sqTail_;
+    uint32_t index = tail & *sqMask_;
+    struct io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = req->opcode;
+    sqe->fd = req->fd;
+    sqe->off = req->offset + req->done;
+    if (req->bufIndex >= 0) {
+        sqe->addr = reinterpret_cast<uint64_t>(req->fixedBuf + req->done);
+        sqe->len = req->length - req->done;
+        sqe->buf_index = req->bufIndex;
+    } else {
+        sqe->addr = reinterpret_cast<uint64_t>(req->iov);
+        sqe->len = req->iovcnt;
+    }
+    sqe->user_data = reinterpret_cast<uint64_t>(req);
+    sqArray_[index] = index;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+}
+
+int IoUringFileSystemImpl::Submit(IoUringRequest* req) {
+    std::unique_lock<std::mutex> lk(sqMutex_);
+    // cq的大小是sq的两倍，限制inflight不超过sq大小即可保证cq不会溢出
+    sqCond_.wait(lk, [this] {
+        return inflight_ < sqEntries_ || !running_.load();
+    });
+    if (!running_.load()) {
+        return -ESHUTDOWN;
+    }
+    uint32_t tail = *sqTail_;
+    PrepareSqe(req);
+    int rc = 0;
+    do {
+        rc = sys_io_uring_enter(ringFd_, 1, 0, 0);
+    } while (rc < 0 && errno == EINTR);
+    if (rc < 0) {
+        // 提交失败，sqe没有被内核消费，回滚tail
+        int err = errno;
+        __atomic_store_n(sqTail_, tail, __ATOMIC_RELEASE);
+        LOG(ERROR) << "io_uring submit failed: " << strerror(err);
+        return -err;
+    }
+    ++inflight_;
+    return 0;
+}
+
+int IoUringFileSystemImpl::SubmitAndWait(IoUringRequest* req) {
+    int result = 0;
+    CountDownEvent event(1);
+    req->callback = [&result, &event](int res) {
+        result = res;
+        event.Signal();
+    };
+    int rc = Submit(req);
+    if (rc < 0) {
+        return rc;
+    }
+    event.Wait();
+    return result;
+}
+
+int IoUringFileSystemImpl::AcquireFixedBuffer(int length, char** buf) {
+    std::lock_guard<std::mutex> lk(bufferMutex_);
+    if (buffersReleased_ || freeBuffers_.empty()
+        || static_cast<uint32_t>(length) > fixedBufferSize_) {
+        return -1;
+    }
+    int index = freeBuffers_.back();
+    freeBuffers_.pop_back();
+    *buf = fixedBufferBase_ + static_cast<uint64_t>(index) * fixedBufferSize_;
+    return index;
+}
+
+void IoUringFileSystemImpl::ReleaseFixedBuffer(int index) {
+    std::lock_guard<std::mutex> lk(bufferMutex_);
+    freeBuffers_.push_back(index);
+    if (buffersReleased_ && freeBuffers_.size() == fixedBufferNum_) {
+        free(fixedBufferBase_);
+        fixedBufferBase_ = nullptr;
+        fixedBufferNum_ = 0;
+        fixedBufferSize_ = 0;
+        freeBuffers_.clear();
+    }
+}
+
+void IoUringFileSystemImpl::ReturnFixedBuffer(void* data) {
+    auto lfs = getInstance();
+    char* base = nullptr;
+    uint32_t size = 0;
+    {
+        std::lock_guard<std::mutex> lk(lfs->bufferMutex_);
+        base = lfs->fixedBufferBase_;
+        size = lfs->fixedBufferSize_;
+    }
+    CHECK(base != nullptr && size > 0)
+        << "Return fixed buffer after the buffers are released.";
+    lfs->ReleaseFixedBuffer((static_cast<char*>(data) - base) / size);
+}
+
+int IoUringFileSystemImpl::Read(int fd,
+                                char *buf,
+                                uint64_t offset,
+                                int length) {
+    IoUringRequest req(IORING_OP_READV, fd, offset, length);
+    req.SetIovec(buf, length);
+    return SubmitAndWait(&req);
+}
+
+int IoUringFileSystemImpl::ReadToIOBuf(int fd,
+                                       butil::IOBuf* buf,
+                                       uint64_t offset,
+                                       int length) {
+    // 没有可用的固定buffer时，复用ext4的preadv直接读到IOBuf的block中
+    char* fixedBuf = nullptr;
+    int index = AcquireFixedBuffer(length, &fixedBuf);
+    if (index < 0) {
+        return base_->ReadToIOBuf(fd, buf, offset, length);
+    }
+    IoUringRequest req(IORING_OP_READ_FIXED, fd, offset, length);
+    req.fixedBuf = fixedBuf;
+    req.bufIndex = index;
+    int ret = SubmitAndWait(&req);
+    if (ret <= 0) {
+        ReleaseFixedBuffer(index);
+        return ret;
+    }
+    // buffer挂到IOBuf上，IOBuf释放时归还
+    buf->append_user_data(req.fixedBuf, ret, ReturnFixedBuffer);
+    return ret;
+}
+
+int IoUringFileSystemImpl::Write(int fd,
+                                 const char *buf,
+                                 uint64_t offset,
+                                 int length) {
+    IoUringRequest req(IORING_OP_WRITEV, fd, offset, length);
+    req.SetIovec(buf, length);
+    int ret = SubmitAndWait(&req);
+    if (ret >= 0 && ret < length) {
+        LOG(ERROR) << "io_uring write incomplete, written: "
+                   << ret << ", length: " << length;
+        return -EIO;
+    }
+    return ret;
+}
+
+int IoUringFileSystemImpl::Write(int fd,
+                                 butil::IOBuf buf,
+                                 uint64_t offset,
+                                 int length) {
+    if (buf.backing_block_num() > IOV_MAX) {
+        return base_->Write(fd, buf, offset, length);
+    }
+    // 直接以IOBuf的block作为iovec提交
+    IoUringRequest req(IORING_OP_WRITEV, fd, offset, length);
+    req.SetIovec(buf);
+    int ret = SubmitAndWait(&req);
+    if (ret >= 0 && ret < length) {
+        LOG(ERROR) << "io_uring write incomplete, written: "
+                   << ret << ", length: " << length;
+        return -EIO;
+    }
+    return ret;
+}
+
+void IoUringFileSystemImpl::WriteAsync(int fd,
+                                       butil::IOBuf buf,
+                                       uint64_t offset,
+                                       int length,
+                                       WriteCallback done) {
+    if (buf.backing_block_num() > IOV_MAX) {
+        done(base_->Write(fd, buf, offset, length));
+        return;
+    }
+    IoUringRequest* req =
+        new IoUringRequest(IORING_OP_WRITEV, fd, offset, length);
+    req->data.swap(buf);
+    req->SetIovec(req->data);
+    req->detached = true;
+    req->callback = [length, done](int res) {
+        if (res >= 0 && res < length) {
+            LOG(ERROR) << "io_uring write incomplete, written: "
+                       << res << ", length: " << length;
+            res = -EIO;
+        }
+        done(res);
+    };
+    int rc = Submit(req);
+    if (rc < 0) {
+        delete req;
+        done(rc);
+    }
+}
+
+int IoUringFileSystemImpl::Statfs(const string& path,
+                                  struct FileSystemInfo *info) {
+    return base_->Statfs(path, info);
+}
+
+int IoUringFileSystemImpl::Open(const string& path, int flags) {
+    return base_->Open(path, flags);
+}
+
+int IoUringFileSystemImpl::Close(int fd) {
+    return base_->Close(fd);
+}
+
+int IoUringFileSystemImpl::Delete(const string& path) {
+    return base_->Delete(path);
+}
+
+int IoUringFileSystemImpl::Mkdir(const string& dirName) {
+    return base_->Mkdir(dirName);
+}
+
+bool IoUringFileSystemImpl::DirExists(const string& dirName) {
+    return base_->DirExists(dirName);
+}
+
+bool IoUringFileSystemImpl::FileExists(const string& filePath) {
+    return base_->FileExists(filePath);
+}
+
+int IoUringFileSystemImpl::DoRename(const string& oldPath,
+                                    const string& newPath,
+                                    unsigned int flags) {
+    return base_->Rename(oldPath, newPath, flags);
+}
+
+int IoUringFileSystemImpl::List(const string& dirName,
+                                vector<std::string> *names) {
+    return base_->List(dirName, names);
+}
+
+int IoUringFileSystemImpl::Append(int fd,
+                                  const char *buf,
+                                  int length) {
+    return base_->Append(fd, buf, length);
+}
+
+int IoUringFileSystemImpl::Fallocate(int fd,
+                                     int op,
+                                     uint64_t offset,
+                                     int length) {
+    return base_->Fallocate(fd, op, offset, length);
+}
+
+int IoUringFileSystemImpl::Fstat(int fd, struct stat *info) {
+    return base_->Fstat(fd, info);
+}
+
+int IoUringFileSystemImpl::Fsync(int fd) {
+    return base_->Fsync(fd);
+}
+
+}  // namespace fs
+}  // namespace curve
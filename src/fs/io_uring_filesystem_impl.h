@@ -0,0 +1,182 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#ifndef SRC_FS_IO_URING_FILESYSTEM_IMPL_H_
+#define SRC_FS_IO_URING_FILESYSTEM_IMPL_H_
+
+#include <butil/iobuf.h>
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "src/fs/local_filesystem.h"
+
+namespace curve {
+namespace fs {
+
+struct IoUringRequest;
+
+/**
+ * 基于io_uring的本地文件系统实现
+ * 目录、元数据等操作直接复用Ext4FileSystemImpl，
+ * Read/Write通过共享的io_uring提交，多个apply线程的请求会在同一个
+ * 提交队列上合并，由后台的reap线程统一收割完成事件。
+ * WriteAsync提交后立即返回，reap线程在写完成后调用请求的回调，
+ * 同步接口也是提交后等待回调完成。短读短写以及EINTR/EAGAIN由reap线程
+ * 重新提交剩余部分。回调在reap线程中执行，不能在回调中同步等待本文件系统
+ * 的IO，否则会阻塞完成事件的收割。
+ * IOBuf的写入直接以IOBuf的block作为iovec提交，不进行拷贝。
+ * 初始化时可以向内核注册一组固定buffer，ReadToIOBuf优先以
+ * IORING_OP_READ_FIXED读到固定buffer中，再将buffer挂到IOBuf上，
+ * IOBuf释放时归还，避免每次IO都进行用户页的pin/unpin。
+ * 如果内核不支持io_uring，Init会返回失败。
+ */
+class IoUringFileSystemImpl : public LocalFileSystem {
+ public:
+    virtual ~IoUringFileSystemImpl();
+    static std::shared_ptr<IoUringFileSystemImpl> getInstance();
+
+    int Init(const LocalFileSystemOption& option) override;
+    int Statfs(const string& path, struct FileSystemInfo* info) override;
+    int Open(const string& path, int flags) override;
+    int Close(int fd) override;
+    int Delete(const string& path) override;
+    int Mkdir(const string& dirPath) override;
+    bool DirExists(const string& dirPath) override;
+    bool FileExists(const string& filePath) override;
+    int List(const string& dirPath, vector<std::string>* names) override;
+    int Read(int fd, char* buf, uint64_t offset, int length) override;
+    int ReadToIOBuf(int fd, butil::IOBuf* buf,
+                    uint64_t offset, int length) override;
+    int Write(int fd, const char* buf, uint64_t offset, int length) override;
+    int Write(int fd, butil::IOBuf buf, uint64_t offset, int length) override;
+    void WriteAsync(int fd, butil::IOBuf buf, uint64_t offset,
+                    int length, WriteCallback done) override;
+    int Append(int fd, const char* buf, int length) override;
+    int Fallocate(int fd, int op, uint64_t offset,
+                  int length) override;
+    int Fstat(int fd, struct stat* info) override;
+    int Fsync(int fd) override;
+
+    /**
+     * 停止接收新的请求，等待已经提交的请求完成后停止reap线程并释放ring，
+     * 之后的读写返回-ESHUTDOWN，析构时会自动调用
+     */
+    void Fini();
+
+ private:
+    explicit IoUringFileSystemImpl(std::shared_ptr<LocalFileSystem> base);
+    int DoRename(const string& oldPath,
+                 const string& newPath,
+                 unsigned int flags) override;
+
+    int SetupRing(uint32_t queueDepth);
+    void RegisterFixedBuffers(uint32_t num, uint32_t size);
+    void ReleaseRing();
+
+    /**
+     * 将请求提交到sq，sq满时等待，提交成功后由reap线程在完成时调用回调
+     * @param req: 待提交的请求
+     * @return 成功返回0，失败返回-errno，失败时不会调用回调
+     */
+    int Submit(IoUringRequest* req);
+    /**
+     * 在sq中填充请求剩余部分的sqe，需要持有sqMutex_
+     */
+    void PrepareSqe(IoUringRequest* req);
+    /**
+     * 提交请求并等待其完成
+     * @return 成功返回读写的字节数，失败返回-errno
+     */
+    int SubmitAndWait(IoUringRequest* req);
+    /**
+     * 处理请求的一个完成事件，对短读/短写以及EINTR/EAGAIN进行重试
+     * @param req: 完成的请求
+     * @param res: cqe的返回值
+     * @return 需要重新提交剩余部分返回true，请求完成返回false
+     */
+    bool OnComplete(IoUringRequest* req, int res);
+    void ReapLoop();
+
+    /**
+     * 获取一个可以容纳length字节的固定buffer
+     * @param[out] buf 成功时返回buffer的起始地址，和下标在同一把锁下取得
+     * @return 成功返回buffer的下标，没有可用的固定buffer返回-1
+     */
+    int AcquireFixedBuffer(int length, char** buf);
+    void ReleaseFixedBuffer(int index);
+    // 挂到IOBuf上的固定buffer的deleter，IOBuf释放时归还buffer
+    static void ReturnFixedBuffer(void* data);
+
+ private:
+    static std::shared_ptr<IoUringFileSystemImpl> self_;
+    static std::mutex mutex_;
+    // 元数据及其他非数据路径操作的实现
+    std::shared_ptr<LocalFileSystem> base_;
+
+    int ringFd_;
+    // sq/cq ring的mmap区域
+    void* sqRingPtr_;
+    size_t sqRingSize_;
+    void* cqRingPtr_;
+    size_t cqRingSize_;
+    struct io_uring_sqe* sqes_;
+    size_t sqesSize_;
+    uint32_t* sqHead_;
+    uint32_t* sqTail_;
+    uint32_t* sqMask_;
+    uint32_t* sqArray_;
+    uint32_t sqEntries_;
+    uint32_t* cqHead_;
+    uint32_t* cqTail_;
+    uint32_t* cqMask_;
+    struct io_uring_cqe* cqes_;
+
+    // 保护sq的提交以及inflight计数
+    std::mutex sqMutex_;
+    std::condition_variable sqCond_;
+    uint32_t inflight_;
+
+    // 固定buffer，所有buffer在一段连续的内存上，下标为i的buffer起始于
+    // fixedBufferBase_ + i * fixedBufferSize_
+    char* fixedBufferBase_;
+    uint32_t fixedBufferSize_;
+    uint32_t fixedBufferNum_;
+    std::vector<int> freeBuffers_;
+    // ring已经释放，不再分配固定buffer，buffer全部归还后释放内存
+    bool buffersReleased_;
+    std::mutex bufferMutex_;
+
+    std::atomic<bool> running_;
+    std::thread reapThread_;
+};
+
+}  // namespace fs
+}  // namespace curve
+
+#endif  // SRC_FS_IO_URING_FILESYSTEM_IMPL_H_
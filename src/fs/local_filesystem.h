@@ -32,6 +32,7 @@
 #include <map>
 #include <string>
 #include <cstring>
+#include <functional>
 #include <mutex>  // NOLINT
 
 #include "src/fs/fs_common.h"
@@ -45,9 +46,23 @@ namespace fs {
 
 struct LocalFileSystemOption {
     bool enableRenameat2;
-    LocalFileSystemOption() : enableRenameat2(false) {}
+    // 以下参数仅对FileSystemType::EXT4_IOURING生效
+    // io_uring提交队列的深度
+    uint32_t ioUringQueueDepth;
+    // 向内核注册的固定buffer个数，为0则不使用固定buffer，
+    // 注册的内存受RLIMIT_MEMLOCK限制，需要num * size不超过该限制
+    uint32_t ioUringFixedBufferNum;
+    // 每个固定buffer的大小，读取超过该大小的请求不使用固定buffer
+    uint32_t ioUringFixedBufferSize;
+    LocalFileSystemOption() : enableRenameat2(false)
+                            , ioUringQueueDepth(128)
+                            , ioUringFixedBufferNum(0)
+                            , ioUringFixedBufferSize(128 * 1024) {}
 };
 
+// 异步写的完成回调，参数为写入的数据长度，失败为-errno
+using WriteCallback = std::function<void(int)>;
+
 class LocalFileSystem {
  public:
      LocalFileSystem() {}
@@ -150,6 +165,18 @@ class LocalFileSystem {
      */
     virtual int Read(int fd, char* buf, uint64_t offset, int length) = 0;
 
+    /**
+     * 从文件指定区域读取数据，数据直接读入IOBuf的block中
+     * 通过preadv读到IOBuf内部池化的block，不需要额外分配和拷贝buffer
+     * @param fd：文件句柄id，通过Open接口获取
+     * @param buf[out]：读取的数据会追加到buf末尾
+     * @param offset：读取区域的起始偏移
+     * @param length：读取数据的长度
+     * @return 返回成功读取到的数据长度，失败返回-errno
+     */
+    virtual int ReadToIOBuf(int fd, butil::IOBuf* buf,
+                            uint64_t offset, int length) = 0;
+
     /**
      * 向文件指定区域写入数据
      * @param fd：文件句柄id，通过Open接口获取
@@ -171,6 +198,21 @@ class LocalFileSystem {
     virtual int Write(int fd, butil::IOBuf buf, uint64_t offset,
                       int length) = 0;
 
+    /**
+     * 异步向文件指定区域写入数据，写完成后调用done，
+     * done可能在其他线程中被调用，也可能在返回前被调用
+     * 默认实现同步调用Write后调用done
+     * @param fd：文件句柄id，通过Open接口获取
+     * @param buf：待写入数据，完成之前由请求持有
+     * @param offset：写入区域的起始偏移
+     * @param length：写入数据的长度
+     * @param done：完成回调，参数为写入的数据长度，失败为-errno
+     */
+    virtual void WriteAsync(int fd, butil::IOBuf buf, uint64_t offset,
+                            int length, WriteCallback done) {
+        done(Write(fd, buf, offset, length));
+    }
+
     /**
      * 向文件末尾追加数据
      * @param fd：文件句柄id，通过Open接口获取
@@ -101,7 +101,11 @@ int PosixWrapper::fstat(int fd, struct stat *buf) {
 }
 
 int PosixWrapper::fallocate(int fd, int mode, off_t offset, off_t len) {
-    return ::posix_fallocate(fd, offset, len);
+    // mode为0时只是预分配空间，punch hole、zero range等需要linux的fallocate
+    if (mode == 0) {
+        return ::posix_fallocate(fd, offset, len);
+    }
+    return ::fallocate(fd, mode, offset, len);
 }
 
 int PosixWrapper::fsync(int fd) {
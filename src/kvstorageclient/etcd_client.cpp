@@ -273,6 +273,26 @@ int EtcdClientImp::CompareAndSwap(const std::string &key,
     return errCode;
 }
 
+int EtcdClientImp::CompareAndDelete(const std::string &cmpKey,
+    const std::string &cmpValue, const std::string &key, int64_t *revision) {
+    bool needRetry = false;
+    int retry = 0;
+    int errCode;
+    do {
+        EtcdClientCompareAndDelete_return res = EtcdClientCompareAndDelete(
+            timeout_, const_cast<char*>(cmpKey.c_str()),
+            const_cast<char*>(cmpValue.c_str()),
+            const_cast<char*>(key.c_str()),
+            cmpKey.size(), cmpValue.size(), key.size());
+        if (res.r0 == EtcdErrCode::EtcdOK) {
+            *revision = res.r1;
+        }
+        errCode = res.r0;
+        needRetry = NeedRetry(errCode);
+    } while (needRetry && ++retry <= retryTimes_);
+    return errCode;
+}
+
 int EtcdClientImp::CampaignLeader(
     const std::string &pfx, const std::string &leaderName,
     uint32_t sessionInterSec, uint32_t electionTimeoutMs, uint64_t *leaderOid) {
@@ -318,6 +338,7 @@ bool EtcdClientImp::NeedRetry(int errCode) {
         case EtcdErrCode::EtcdUnauthenticated:
         case EtcdErrCode::EtcdTxnUnkownOp:
         case EtcdErrCode::EtcdKeyNotExist:
+        case EtcdErrCode::EtcdTxnCompareFailed:
             return false;
 
         case EtcdErrCode::EtcdDeadlineExceeded:
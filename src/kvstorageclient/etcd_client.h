@@ -118,6 +118,21 @@ class KVStorageClient {
      */
     virtual int CompareAndSwap(const std::string &key, const std::string &preV,
         const std::string &target) = 0;
+
+    /**
+     * @brief CompareAndDelete Transaction, delete the key only if the value
+     *        of cmpKey is equal to cmpValue
+     *
+     * @param[in] cmpKey
+     * @param[in] cmpValue Value conditions to be fulfilled
+     * @param[in] key The key to be deleted
+     * @param[out] revision Version number returned
+     *
+     * @return error code, EtcdTxnCompareFailed if the condition is not met
+     */
+    virtual int CompareAndDelete(const std::string &cmpKey,
+        const std::string &cmpValue, const std::string &key,
+        int64_t *revision) = 0;
 };
 
 // encapsulate the c header file of etcd generated by go compilation
@@ -161,6 +176,10 @@ class EtcdClientImp : public KVStorageClient {
     int CompareAndSwap(const std::string &key, const std::string &preV,
         const std::string &target) override;
 
+    int CompareAndDelete(const std::string &cmpKey,
+        const std::string &cmpValue, const std::string &key,
+        int64_t *revision) override;
+
     virtual int GetCurrentRevision(int64_t *revision);
 
     /**
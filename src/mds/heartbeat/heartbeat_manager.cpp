@@ -24,6 +24,7 @@
 #include <utility>
 #include <set>
 #include "src/mds/heartbeat/heartbeat_manager.h"
+#include "src/common/copyset_fingerprint.h"
 #include "src/common/string_util.h"
 #include "src/mds/topology/topology_stat.h"
 
@@ -37,6 +38,8 @@ using ::curve::mds::topology::ChunkServerStatus;
 using ::curve::mds::topology::ChunkServerStat;
 using ::curve::mds::topology::CopysetStat;
 using ::curve::mds::topology::SplitPeerId;
+using ::curve::common::LockGuard;
+using ::curve::common::CopySetFingerprint;
 
 namespace curve {
 namespace mds {
@@ -46,7 +49,8 @@ HeartbeatManager::HeartbeatManager(HeartbeatOption option,
     std::shared_ptr<TopologyStat> topologyStat,
     std::shared_ptr<Coordinator> coordinator)
     : topology_(topology),
-      topologyStat_(topologyStat) {
+      topologyStat_(topologyStat),
+      coordinator_(coordinator) {
     healthyChecker_ =
         std::make_shared<ChunkserverHealthyChecker>(option, topology);
 
@@ -93,6 +97,7 @@ void HeartbeatManager::ChunkServerHealthyChecker() {
     while (sleeper_.wait_for(
         std::chrono::milliseconds(chunkserverHealthyCheckerRunInter_))) {
         healthyChecker_->CheckHeartBeatInterval();
+        CleanChunkServerReports();
     }
 }
 
@@ -119,8 +124,47 @@ void HeartbeatManager::UpdateChunkServerDiskStatus(
     }
 }
 
+void HeartbeatManager::BuildCopysetStat(
+    const ChunkServerHeartbeatRequest &request,
+    const ::curve::mds::heartbeat::CopySetInfo &info,
+    CopysetStat *cstat) {
+    cstat->logicalPoolId = info.logicalpoolid();
+    cstat->copysetId = info.copysetid();
+
+    // TODO(xuchaojie): use id instead when new protocol supported
+    std::string leaderPeer = info.leaderpeer().address();
+    std::string leaderIp;
+    uint32_t leaderPort;
+    if (SplitPeerId(leaderPeer, &leaderIp, &leaderPort)) {
+        cstat->leader =
+            topology_->FindChunkServerNotRetired(leaderIp, leaderPort);
+        if (UNINTIALIZE_ID == cstat->leader) {
+            LOG(INFO) << "hearbeat receive from chunkserver(id:"
+                << request.chunkserverid()
+                << ",ip:"<< request.ip() << ",port:" << request.port()
+                << "), in which copyset(" << cstat->logicalPoolId
+                << "," << cstat->copysetId << ") dose not have leader.";
+        }
+    } else {
+        LOG(ERROR) << "hearbeat failed on SplitPeerId, "
+                   << "peerId string = " << leaderPeer;
+    }
+    if (info.has_stats()) {
+        cstat->readRate = info.stats().readrate();
+        cstat->writeRate = info.stats().writerate();
+        cstat->readIOPS = info.stats().readiops();
+        cstat->writeIOPS = info.stats().writeiops();
+    } else {
+        LOG(WARNING) << "hearbeat manager receive request "
+                     << "copyset {" << cstat->logicalPoolId
+                     << ", " << cstat->copysetId << "} "
+                     << "do not have CopysetStatistics";
+    }
+}
+
 void HeartbeatManager::UpdateChunkServerStatistics(
-    const ChunkServerHeartbeatRequest &request) {
+    const ChunkServerHeartbeatRequest &request,
+    std::vector<CopysetStat> copysetStats) {
     ChunkServerStat stat;
     stat.leaderCount = request.leadercount();
     stat.copysetCount = request.copysetcount();
@@ -133,46 +177,7 @@ void HeartbeatManager::UpdateChunkServerStatistics(
         stat.chunkSizeUsedBytes = request.stats().chunksizeusedbytes();
         stat.chunkSizeLeftBytes = request.stats().chunksizeleftbytes();
         stat.chunkSizeTrashedBytes = request.stats().chunksizetrashedbytes();
-
-        for (int i = 0; i < request.copysetinfos_size(); i++) {
-            CopysetStat cstat;
-            cstat.logicalPoolId = request.copysetinfos(i).logicalpoolid();
-            cstat.copysetId = request.copysetinfos(i).copysetid();
-
-            // TODO(xuchaojie): use id instead when new protocol supported
-            std::string leaderPeer =
-                request.copysetinfos(i).leaderpeer().address();
-            std::string leaderIp;
-            uint32_t leaderPort;
-            if (SplitPeerId(leaderPeer, &leaderIp, &leaderPort)) {
-                cstat.leader =
-                    topology_->FindChunkServerNotRetired(
-                    leaderIp, leaderPort);
-                if (UNINTIALIZE_ID == cstat.leader) {
-                    LOG(INFO) << "hearbeat receive from chunkserver(id:"
-                        << request.chunkserverid()
-                        << ",ip:"<< request.ip() << ",port:" << request.port()
-                        << "), in which copyset(" << cstat.logicalPoolId
-                        << "," << cstat.copysetId << ") dose not have leader.";
-                }
-            } else {
-                LOG(ERROR) << "hearbeat failed on SplitPeerId, "
-                           << "peerId string = " << leaderPeer;
-            }
-            if (request.copysetinfos(i).has_stats()) {
-                cstat.readRate = request.copysetinfos(i).stats().readrate();
-                cstat.writeRate = request.copysetinfos(i).stats().writerate();
-                cstat.readIOPS = request.copysetinfos(i).stats().readiops();
-                cstat.writeIOPS = request.copysetinfos(i).stats().writeiops();
-            } else {
-                LOG(WARNING) << "hearbeat manager receive request "
-                             << "copyset {" << cstat.logicalPoolId
-                             << ", " << cstat.copysetId << "} "
-                             << "do not have CopysetStatistics";
-            }
-            stat.copysetStats.push_back(cstat);
-        }
-
+        stat.copysetStats = std::move(copysetStats);
     } else {
         LOG(WARNING) << "hearbeat manager receive request "
                      << "do not have ChunkServerStatisticInfo";
@@ -188,6 +193,10 @@ void HeartbeatManager::ChunkServerHeartbeat(
     HeartbeatStatusCode ret = CheckRequest(request);
     if (ret != HeartbeatStatusCode::hbOK) {
         LOG(ERROR) << "heartbeatManager get error request";
+        if (ret == HeartbeatStatusCode::hbChunkserverUnknown ||
+            ret == HeartbeatStatusCode::hbChunkserverRetired) {
+            RemoveChunkServerReport(request.chunkserverid());
+        }
         response->set_statuscode(ret);
         return;
     }
@@ -204,7 +213,21 @@ void HeartbeatManager::ChunkServerHeartbeat(
 
     UpdateChunkServerDiskStatus(request);
 
-    UpdateChunkServerStatistics(request);
+    // chunkserver supports delta heartbeats
+    if (request.has_copysetdigest()) {
+        DeltaChunkServerHeartbeat(request, response);
+        return;
+    }
+
+    std::vector<CopysetStat> copysetStats;
+    if (request.has_stats()) {
+        for (auto &value : request.copysetinfos()) {
+            CopysetStat cstat;
+            BuildCopysetStat(request, value, &cstat);
+            copysetStats.emplace_back(cstat);
+        }
+    }
+    UpdateChunkServerStatistics(request, std::move(copysetStats));
     // no copyset info in the request
     if (request.copysetinfos_size() == 0) {
         response->set_statuscode(HeartbeatStatusCode::hbRequestNoCopyset);
@@ -231,20 +254,160 @@ void HeartbeatManager::ChunkServerHeartbeat(
             continue;
         }
 
-        // forward reported copyset info to CopysetConfGenerator
-        CopySetConf conf;
-        ConfigChangeInfo configChInfo;
-        if (copysetConfGenerator_->GenCopysetConf(
-                request.chunkserverid(), reportCopySetInfo,
-                value.configchangeinfo(), &conf)) {
-            CopySetConf *res = response->add_needupdatecopysets();
-            *res = conf;
+        HandleCopySetInfo(request.chunkserverid(), value,
+            reportCopySetInfo, response);
+    }
+}
+
+void HeartbeatManager::DeltaChunkServerHeartbeat(
+    const ChunkServerHeartbeatRequest &request,
+    ChunkServerHeartbeatResponse *response) {
+    ChunkServerIdType csId = request.chunkserverid();
+    auto report = GetChunkServerReport(csId);
+    LockGuard guard(report->mtx);
+
+    // full heartbeat replaces the record
+    if (!request.isdelta()) {
+        report->copysets.clear();
+        report->digest = 0;
+    }
+
+    for (auto removed : request.removedcopysets()) {
+        CopySetKey key(static_cast<PoolIdType>(removed >> 32),
+                       static_cast<CopySetIdType>(removed));
+        auto it = report->copysets.find(key);
+        if (it != report->copysets.end()) {
+            report->digest ^= it->second.fingerprint;
+            report->copysets.erase(it);
+        }
+    }
+
+    std::set<CopySetKey> changed;
+    for (auto &value : request.copysetinfos()) {
+        CopySetKey key(value.logicalpoolid(), value.copysetid());
+        auto it = report->copysets.find(key);
+        if (it != report->copysets.end()) {
+            report->digest ^= it->second.fingerprint;
+            report->copysets.erase(it);
         }
 
-        // if a copyset is the leader, update (e.g. epoch) topology according
-        // to its info
-        if (request.chunkserverid() == reportCopySetInfo.GetLeader()) {
-            topoUpdater_->UpdateTopo(reportCopySetInfo);
+        // copyset that can not be converted is not recorded, so the digest
+        // mismatches and chunkserver will report it again
+        CopySetReport item;
+        if (!FromHeartbeatCopySetInfoToTopologyOne(value, &item.topoInfo)) {
+            LOG(ERROR) << "heartbeatManager receive copyset("
+                       << value.logicalpoolid() << ","
+                       << value.copysetid()
+                       << ") information, but can not transfer to topology one";
+            response->set_statuscode(
+                            HeartbeatStatusCode::hbAnalyseCopysetError);
+            continue;
+        }
+        item.info = value;
+        BuildCopysetStat(request, value, &item.stat);
+        item.fingerprint = CopySetFingerprint(value);
+        report->digest ^= item.fingerprint;
+        report->copysets.emplace(key, std::move(item));
+        changed.emplace(key);
+    }
+
+    if (report->copysets.size() != request.copysetcount() ||
+        report->digest != request.copysetdigest()) {
+        LOG(WARNING) << "heartbeatManager receive heartbeat from chunkserver "
+                     << csId << ", isDelta: " << request.isdelta()
+                     << ", but record copyset num: "
+                     << report->copysets.size()
+                     << ", digest: " << report->digest
+                     << " do not match report copyset num: "
+                     << request.copysetcount()
+                     << ", digest: " << request.copysetdigest()
+                     << ", ask for full heartbeat";
+        response->set_needfullheartbeat(true);
+    }
+
+    std::vector<CopysetStat> copysetStats;
+    copysetStats.reserve(report->copysets.size());
+    for (auto &item : report->copysets) {
+        copysetStats.emplace_back(item.second.stat);
+    }
+    UpdateChunkServerStatistics(request, std::move(copysetStats));
+    if (report->copysets.empty()) {
+        response->set_statuscode(HeartbeatStatusCode::hbRequestNoCopyset);
+    }
+
+    // an unchanged copyset needs to be dealt with only if there may be a
+    // config to dispatch: the chunkserver is not a member of it in topology,
+    // or the chunkserver is the leader and there's an operator on it
+    std::vector<CopySetKey> keys = topology_->GetCopySetsInChunkServer(csId);
+    std::set<CopySetKey> members(keys.begin(), keys.end());
+    for (auto &item : report->copysets) {
+        const auto &topoInfo = item.second.topoInfo;
+        if (changed.count(item.first) == 0 &&
+            members.count(item.first) != 0 &&
+            (topoInfo.GetLeader() != csId ||
+                !coordinator_->HasOperator(item.first))) {
+            continue;
+        }
+
+        const auto &value = item.second.info;
+        // discard copysets of invalid logical pool
+        ::curve::mds::topology::LogicalPool lPool;
+        if (topology_->GetLogicalPool(value.logicalpoolid(), &lPool)) {
+            if (lPool.GetLogicalPoolAvaliableFlag() != true) {
+                continue;
+            }
+        }
+
+        HandleCopySetInfo(csId, value, topoInfo, response);
+    }
+}
+
+void HeartbeatManager::HandleCopySetInfo(ChunkServerIdType csId,
+    const ::curve::mds::heartbeat::CopySetInfo &info,
+    const ::curve::mds::topology::CopySetInfo &reportCopySetInfo,
+    ChunkServerHeartbeatResponse *response) {
+    // forward reported copyset info to CopysetConfGenerator
+    CopySetConf conf;
+    if (copysetConfGenerator_->GenCopysetConf(
+            csId, reportCopySetInfo, info.configchangeinfo(), &conf)) {
+        CopySetConf *res = response->add_needupdatecopysets();
+        *res = conf;
+    }
+
+    // if a copyset is the leader, update (e.g. epoch) topology according
+    // to its info
+    if (csId == reportCopySetInfo.GetLeader()) {
+        topoUpdater_->UpdateTopo(reportCopySetInfo);
+    }
+}
+
+std::shared_ptr<ChunkServerReport> HeartbeatManager::GetChunkServerReport(
+    ChunkServerIdType csId) {
+    LockGuard guard(reportsMtx_);
+    auto &report = reports_[csId];
+    if (report == nullptr) {
+        report = std::make_shared<ChunkServerReport>();
+    }
+    return report;
+}
+
+void HeartbeatManager::RemoveChunkServerReport(ChunkServerIdType csId) {
+    LockGuard guard(reportsMtx_);
+    reports_.erase(csId);
+}
+
+void HeartbeatManager::CleanChunkServerReports() {
+    LockGuard guard(reportsMtx_);
+    for (auto it = reports_.begin(); it != reports_.end();) {
+        ChunkServer cs;
+        if (!topology_->GetChunkServer(it->first, &cs) ||
+            cs.GetStatus() == ChunkServerStatus::RETIRED) {
+            LOG(INFO) << "heartbeatManager drop copysets reported by "
+                      << "chunkserver " << it->first
+                      << ", which is retired or removed";
+            it = reports_.erase(it);
+        } else {
+            ++it;
         }
     }
 }
@@ -25,9 +25,11 @@
 
 #include <vector>
 #include <map>
+#include <set>
 #include <atomic>
 #include <string>
 #include <memory>
+#include <unordered_map>
 
 #include "src/mds/topology/topology.h"
 #include "src/mds/common/mds_define.h"
@@ -43,12 +45,15 @@
 using ::curve::mds::topology::CopySetInfo;
 using ::curve::mds::topology::PoolIdType;
 using ::curve::mds::topology::CopySetIdType;
+using ::curve::mds::topology::CopySetKey;
 using ::curve::mds::topology::Topology;
 using ::curve::mds::topology::TopologyStat;
+using ::curve::mds::topology::CopysetStat;
 using ::curve::mds::schedule::Coordinator;
 
 using ::curve::common::Thread;
 using ::curve::common::Atomic;
+using ::curve::common::Mutex;
 using ::curve::common::RWLock;
 using ::curve::common::InterruptibleSleeper;
 
@@ -56,6 +61,28 @@ namespace curve {
 namespace mds {
 namespace heartbeat {
 
+// copyset last reported by a chunkserver that sends delta heartbeats
+struct CopySetReport {
+    // copyset info in heartbeat format, stats of it is updated only when
+    // the copyset changes or on full heartbeats
+    ::curve::mds::heartbeat::CopySetInfo info;
+    // info converted to topology format
+    ::curve::mds::topology::CopySetInfo topoInfo;
+    // statistical data built from info
+    CopysetStat stat;
+    // crc32 of info without stats, see ChunkServerHeartbeatRequest
+    uint32_t fingerprint;
+};
+
+// all copysets of a chunkserver, delta heartbeats are merged into it
+struct ChunkServerReport {
+    // heartbeats of the same chunkserver are handled one by one
+    Mutex mtx;
+    std::map<CopySetKey, CopySetReport> copysets;
+    // xor of the fingerprint of all copysets
+    uint32_t digest = 0;
+};
+
 // the responsibilities of heartbeat manager including:
 // 1. background threads inspection
 //    - update lastest heartbeat timestamp of chunkserver
@@ -123,10 +150,67 @@ class HeartbeatManager {
      * @brief Update statistical data of chunkserver
      *
      * @param request Heartbeat request
-     * @param response response of heartbeat request
+     * @param copysetStats Statistical data of all copysets on the chunkserver
      */
     void UpdateChunkServerStatistics(
-        const ChunkServerHeartbeatRequest &request);
+        const ChunkServerHeartbeatRequest &request,
+        std::vector<CopysetStat> copysetStats);
+
+    /**
+     * @brief Build statistical data of a copyset reported by heartbeat
+     *
+     * @param[in] request Heartbeat request
+     * @param[in] info Copyset data reported by heartbeat
+     * @param[out] cstat Statistical data of the copyset
+     */
+    void BuildCopysetStat(const ChunkServerHeartbeatRequest &request,
+        const ::curve::mds::heartbeat::CopySetInfo &info,
+        CopysetStat *cstat);
+
+    /**
+     * @brief Deal with heartbeat from chunkserver that supports delta
+     *        heartbeats. Reported copysets are merged into the record of
+     *        the chunkserver, and only changed copysets, copysets with
+     *        operator on leader and copysets that chunkserver is not a
+     *        member of are passed to CopysetConfGenerator, so the cost
+     *        scales with the churn instead of the copyset number.
+     *        If the merged record doesn't match the digest, a full
+     *        heartbeat is requested.
+     *
+     * @param[in] request Heartbeat request
+     * @param[out] response Response of heartbeat request
+     */
+    void DeltaChunkServerHeartbeat(
+        const ChunkServerHeartbeatRequest &request,
+        ChunkServerHeartbeatResponse *response);
+
+    /**
+     * @brief Generate config of a reported copyset for the chunkserver and
+     *        update topology if the chunkserver is the leader
+     *
+     * @param[in] csId Chunkserver that reports the copyset
+     * @param[in] info Copyset data reported by heartbeat
+     * @param[in] reportCopySetInfo Copyset data in topology format
+     * @param[out] response Response of heartbeat request
+     */
+    void HandleCopySetInfo(ChunkServerIdType csId,
+        const ::curve::mds::heartbeat::CopySetInfo &info,
+        const ::curve::mds::topology::CopySetInfo &reportCopySetInfo,
+        ChunkServerHeartbeatResponse *response);
+
+    std::shared_ptr<ChunkServerReport> GetChunkServerReport(
+        ChunkServerIdType csId);
+
+    /**
+     * @brief Drop the copysets recorded for a chunkserver
+     */
+    void RemoveChunkServerReport(ChunkServerIdType csId);
+
+    /**
+     * @brief Drop the copysets recorded for chunkservers that are retired
+     *        or no longer in topology
+     */
+    void CleanChunkServerReports();
 
     /**
      * @brief Background thread for heartbeat timeout inspection
@@ -183,6 +267,11 @@ class HeartbeatManager {
     // 3. chunkserver in not included in latest copyset
     std::shared_ptr<CopysetConfGenerator> copysetConfGenerator_;
 
+    // copysets reported by chunkservers that send delta heartbeats
+    Mutex reportsMtx_;
+    std::unordered_map<ChunkServerIdType,
+                       std::shared_ptr<ChunkServerReport>> reports_;
+
     // Manage chunkserverHealthyChecker threads
     Thread backEndThread_;
 
@@ -22,59 +22,246 @@
 
 #include "src/mds/nameserver2/clean_core.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <map>
+#include <utility>
+
+using ::curve::common::LockGuard;
+using ::curve::common::UniqueLock;
+using ::curve::mds::topology::CopySetInfo;
+using ::curve::mds::topology::CopySetKey;
+using ::curve::mds::topology::UNINTIALIZE_ID;
+
 namespace curve {
 namespace mds {
+
+// 一次DeleteChunks调用中的chunk删除状态
+struct CleanCore::DeleteContext {
+    curve::common::Mutex mtx;
+    curve::common::ConditionVariable cond;
+    // 已经下发还没有返回的删除请求数量
+    uint64_t inflight = 0;
+    // 删除成功的chunk数量
+    uint64_t finished = 0;
+    bool failed = false;
+    // 每个segment中还没有删除成功的chunk数量
+    std::vector<uint32_t> segmentLeft;
+};
+
+CleanCore::CleanCore(std::shared_ptr<NameServerStorage> storage,
+                     std::shared_ptr<CopysetClient> copysetClient,
+                     std::shared_ptr<AllocStatistic> allocStatistic,
+                     std::shared_ptr<Topology> topology,
+                     const CleanOption& option)
+    : storage_(storage),
+      copysetClient_(copysetClient),
+      allocStatistic_(allocStatistic),
+      topology_(topology),
+      option_(option) {
+    option_.deleteChunkConcurrency =
+        std::max(option_.deleteChunkConcurrency, 1u);
+    option_.chunkserverDeleteConcurrency =
+        std::max(option_.chunkserverDeleteConcurrency, 1u);
+    deletePool_.Start(option_.deleteChunkConcurrency,
+                      option_.deleteChunkConcurrency);
+}
+
+CleanCore::~CleanCore() {
+    deletePool_.Stop();
+}
+
+ChunkServerIdType CleanCore::GetLeader(LogicalPoolID logicalPoolId,
+                                       CopysetID copysetId) {
+    CopySetInfo copyset;
+    if (topology_ == nullptr ||
+        !topology_->GetCopySet(CopySetKey(logicalPoolId, copysetId),
+                               &copyset)) {
+        return UNINTIALIZE_ID;
+    }
+    return copyset.GetLeader();
+}
+
+void CleanCore::AcquireChunkServer(ChunkServerIdType csId) {
+    UniqueLock lk(csMutex_);
+    csCond_.wait(lk, [&]() {
+        return csInflight_[csId] < option_.chunkserverDeleteConcurrency;
+    });
+    ++csInflight_[csId];
+}
+
+void CleanCore::ReleaseChunkServer(ChunkServerIdType csId) {
+    LockGuard lk(csMutex_);
+    if (--csInflight_[csId] == 0) {
+        csInflight_.erase(csId);
+    }
+    csCond_.notify_all();
+}
+
+bool CleanCore::DeleteChunks(const std::vector<PageFileSegment>& segments,
+                             uint32_t batchSize,
+                             const DeleteChunkFunc& deleteChunk,
+                             TaskProgress* progress,
+                             std::vector<bool>* segmentDone) {
+    // 同一个copyset中一起删除的chunk，以及它们所在的segment
+    struct ChunkBatch {
+        LogicalPoolID logicalPoolId;
+        CopysetID copysetId;
+        std::vector<ChunkID> chunkIds;
+        std::vector<size_t> segmentIndexes;
+    };
+
+    DeleteContext ctx;
+    uint64_t totalChunks = 0;
+    for (const auto& segment : segments) {
+        ctx.segmentLeft.push_back(segment.chunks_size());
+        totalChunks += segment.chunks_size();
+    }
+    progress->SetTotalChunks(totalChunks);
+    batchSize = std::max(batchSize, 1u);
+
+    auto updateProgress = [&]() {
+        // 调用方需要持有ctx.mtx
+        progress->SetFinishedChunks(ctx.finished);
+        if (totalChunks != 0) {
+            progress->SetProgress(100 * ctx.finished / totalChunks);
+        }
+    };
+
+    // 下发一批chunk的删除，已经有删除失败时返回false
+    auto sendBatch = [&](std::shared_ptr<ChunkBatch> batch) {
+        {
+            LockGuard lk(ctx.mtx);
+            if (ctx.failed) {
+                return false;
+            }
+            updateProgress();
+            ++ctx.inflight;
+        }
+
+        ChunkServerIdType leader =
+            GetLeader(batch->logicalPoolId, batch->copysetId);
+        AcquireChunkServer(leader);
+        deletePool_.Enqueue([&, batch, leader]() {
+            int ret = deleteChunk(batch->logicalPoolId, batch->copysetId,
+                                  batch->chunkIds);
+            ReleaseChunkServer(leader);
+
+            LockGuard lk(ctx.mtx);
+            if (ret == 0) {
+                ctx.finished += batch->chunkIds.size();
+                for (auto index : batch->segmentIndexes) {
+                    --ctx.segmentLeft[index];
+                }
+            } else {
+                ctx.failed = true;
+            }
+            if (--ctx.inflight == 0) {
+                ctx.cond.notify_all();
+            }
+        });
+        return true;
+    };
+
+    std::map<std::pair<LogicalPoolID, CopysetID>,
+             std::shared_ptr<ChunkBatch>> pending;
+    bool stopped = false;
+    for (size_t i = 0; i < segments.size() && !stopped; i++) {
+        LogicalPoolID logicalPoolID = segments[i].logicalpoolid();
+        for (const auto& chunk : segments[i].chunks()) {
+            auto& batch = pending[{logicalPoolID, chunk.copysetid()}];
+            if (batch == nullptr) {
+                batch = std::make_shared<ChunkBatch>();
+                batch->logicalPoolId = logicalPoolID;
+                batch->copysetId = chunk.copysetid();
+            }
+            batch->chunkIds.push_back(chunk.chunkid());
+            batch->segmentIndexes.push_back(i);
+            if (batch->chunkIds.size() >= batchSize) {
+                auto full = std::move(batch);
+                pending.erase({logicalPoolID, chunk.copysetid()});
+                if (!sendBatch(full)) {
+                    stopped = true;
+                    break;
+                }
+            }
+        }
+    }
+    for (auto& item : pending) {
+        if (stopped || !sendBatch(item.second)) {
+            break;
+        }
+    }
+
+    // 等待所有下发的删除返回，ctx在栈上，必须等待
+    UniqueLock lk(ctx.mtx);
+    while (ctx.inflight > 0) {
+        ctx.cond.wait_for(lk, std::chrono::seconds(1));
+        updateProgress();
+    }
+    updateProgress();
+
+    segmentDone->clear();
+    for (const auto& left : ctx.segmentLeft) {
+        segmentDone->push_back(left == 0);
+    }
+    return !ctx.failed;
+}
+
 StatusCode CleanCore::CleanSnapShotFile(const FileInfo & fileInfo,
                                         TaskProgress* progress) {
     if (fileInfo.segmentsize() == 0) {
         LOG(ERROR) << "cleanSnapShot File Error, segmentsize = 0";
         return StatusCode::KInternalError;
     }
-    uint32_t  segmentNum = fileInfo.length() / fileInfo.segmentsize();
-    uint64_t segmentSize = fileInfo.segmentsize();
-    for (uint32_t i = 0; i < segmentNum; i++) {
-        // load  segment
-        PageFileSegment segment;
-        StoreStatus storeRet = storage_->GetSegment(fileInfo.parentid(),
-                                                    i * segmentSize,
-                                                    &segment);
-        if (storeRet == StoreStatus::KeyNotExist) {
-            continue;
-        } else if (storeRet !=  StoreStatus::OK) {
-            LOG(ERROR) << "cleanSnapShot File Error: "
-            << "GetSegment Error, inodeid = " << fileInfo.id()
+
+    // 快照文件共享源文件的segment，使用parentid查找，
+    // 源文件在快照之后扩容的部分不属于快照
+    std::vector<PageFileSegment> segments;
+    StoreStatus storeRet = storage_->ListSegment(fileInfo.parentid(),
+                                                 &segments);
+    if (storeRet != StoreStatus::OK) {
+        LOG(ERROR) << "cleanSnapShot File Error: "
+            << "ListSegment Error, inodeid = " << fileInfo.id()
             << ", filename = " << fileInfo.filename()
-            << ", offset = " << i * segmentSize
             << ", sequenceNum = " << fileInfo.seqnum();
-            progress->SetStatus(TaskStatus::FAILED);
-            return StatusCode::kSnapshotFileDeleteError;
-        }
+        progress->SetStatus(TaskStatus::FAILED);
+        return StatusCode::kSnapshotFileDeleteError;
+    }
+    segments.erase(std::remove_if(segments.begin(), segments.end(),
+        [&](const PageFileSegment& segment) {
+            return segment.startoffset() >= fileInfo.length();
+        }), segments.end());
 
-        // delete chunks in chunkserver
-        LogicalPoolID logicalPoolID = segment.logicalpoolid();
-        uint32_t chunkNum = segment.chunks_size();
-        for (uint32_t j = 0; j != chunkNum; j++) {
-            // 删除快照时如果chunk不存在快照，则需要修改chunk的correctedSn
-            // 防止删除快照后，后续的写触发chunk的快照
-            // correctSn为创建快照后文件的版本号，也就是快照版本号+1
-            SeqNum correctSn = fileInfo.seqnum() + 1;
+    // 删除快照时如果chunk不存在快照，则需要修改chunk的correctedSn
+    // 防止删除快照后，后续的写触发chunk的快照
+    // correctSn为创建快照后文件的版本号，也就是快照版本号+1
+    SeqNum correctSn = fileInfo.seqnum() + 1;
+    auto deleteChunk = [&](LogicalPoolID logicalPoolID,
+                           CopysetID copysetId,
+                           const std::vector<ChunkID>& chunkIds) {
+        for (auto chunkId : chunkIds) {
             int ret = copysetClient_->DeleteChunkSnapshotOrCorrectSn(
-                logicalPoolID,
-                segment.chunks()[j].copysetid(),
-                segment.chunks()[j].chunkid(),
-                correctSn);
+                logicalPoolID, copysetId, chunkId, correctSn);
             if (ret != 0) {
                 LOG(ERROR) << "CleanSnapShotFile Error: "
                     << "DeleteChunkSnapshotOrCorrectSn Error"
                     << ", ret = " << ret
                     << ", inodeid = " << fileInfo.id()
                     << ", filename = " << fileInfo.filename()
-                    << ", correctSn = " << correctSn;
-                progress->SetStatus(TaskStatus::FAILED);
-                return StatusCode::kSnapshotFileDeleteError;
+                    << ", correctSn = " << correctSn
+                    << ", chunkid = " << chunkId;
+                return ret;
             }
         }
-        progress->SetProgress(100 * (i+1) / segmentNum);
+        return 0;
+    };
+
+    // 快照chunk的删除没有批量接口，每个chunk单独下发
+    std::vector<bool> segmentDone;
+    if (!DeleteChunks(segments, 1, deleteChunk, progress, &segmentDone)) {
+        progress->SetStatus(TaskStatus::FAILED);
+        return StatusCode::kSnapshotFileDeleteError;
     }
 
     // delete the storage
@@ -87,7 +274,9 @@ StatusCode CleanCore::CleanSnapShotFile(const FileInfo & fileInfo,
     } else {
         LOG(INFO) << "inodeid = " << fileInfo.id()
             << ", filename = " << fileInfo.filename()
-            << ", seq = " << fileInfo.seqnum() << ", deleted";
+            << ", seq = " << fileInfo.seqnum() << ", deleted"
+            << ", chunks = " << progress->GetFinishedChunks()
+            << ", chunks per second = " << progress->GetChunksPerSecond();
     }
 
     progress->SetProgress(100);
@@ -102,61 +291,87 @@ StatusCode CleanCore::CleanFile(const FileInfo & commonFile,
         return StatusCode::KInternalError;
     }
 
-    int  segmentNum = commonFile.length() / commonFile.segmentsize();
-    uint64_t segmentSize = commonFile.segmentsize();
-    for (int i = 0; i != segmentNum; i++) {
-        // load  segment
-        PageFileSegment segment;
-        StoreStatus storeRet = storage_->GetSegment(commonFile.id(),
-                                    i * segmentSize, &segment);
-        if (storeRet == StoreStatus::KeyNotExist) {
-            continue;
-        } else if (storeRet !=  StoreStatus::OK) {
+    std::vector<PageFileSegment> segments;
+    StoreStatus storeRet = storage_->ListSegment(commonFile.id(), &segments);
+    if (storeRet != StoreStatus::OK) {
+        LOG(ERROR) << "Clean common File Error: "
+            << "ListSegment Error, inodeid = " << commonFile.id()
+            << ", filename = " << commonFile.filename();
+        progress->SetStatus(TaskStatus::FAILED);
+        return StatusCode::kCommonFileDeleteError;
+    }
+
+    SeqNum seq = commonFile.seqnum();
+    auto deleteChunk = [&](LogicalPoolID logicalPoolID,
+                           CopysetID copysetId,
+                           const std::vector<ChunkID>& chunkIds) {
+        int ret = kMdsSuccess;
+        bool oneByOne = chunkIds.size() <= 1;
+        if (!oneByOne) {
+            ret = copysetClient_->DeleteChunks(logicalPoolID, copysetId,
+                                               chunkIds, seq);
+            // leader是不支持DeleteChunks的老版本chunkserver，改为逐个删除
+            if (ret == kCsClientNotSupported) {
+                LOG(WARNING) << "DeleteChunks is not supported, delete "
+                             << chunkIds.size() << " chunks one by one"
+                             << ", copysetid = " << copysetId;
+                oneByOne = true;
+            }
+        }
+        if (oneByOne) {
+            for (auto chunkId : chunkIds) {
+                ret = copysetClient_->DeleteChunk(logicalPoolID, copysetId,
+                                                  chunkId, seq);
+                if (ret != 0) {
+                    break;
+                }
+            }
+        }
+        if (ret != 0) {
             LOG(ERROR) << "Clean common File Error: "
-                << "GetSegment Error, inodeid = " << commonFile.id()
+                << "DeleteChunks Error"
+                << ", ret = " << ret
+                << ", inodeid = " << commonFile.id()
                 << ", filename = " << commonFile.filename()
-                << ", offset = " << i * segmentSize;
-            progress->SetStatus(TaskStatus::FAILED);
-            return StatusCode::kCommonFileDeleteError;
+                << ", sequenceNum = " << seq
+                << ", copysetid = " << copysetId
+                << ", first chunkid = " << chunkIds.front()
+                << ", chunk count = " << chunkIds.size();
         }
+        return ret;
+    };
 
-        // delete chunks in chunkserver
-        LogicalPoolID logicalPoolID = segment.logicalpoolid();
-        uint32_t chunkNum = segment.chunks_size();
-        for (uint32_t j = 0; j != chunkNum; j++) {
-            SeqNum seq = commonFile.seqnum();
-            int ret = copysetClient_->DeleteChunk(logicalPoolID,
-                segment.chunks()[j].copysetid(),
-                segment.chunks()[j].chunkid(),
-                seq);
-            if (ret != 0) {
-                LOG(ERROR) << "Clean common File Error: "
-                    << "DeleteChunk Error"
-                    << ", ret = " << ret
-                    << ", inodeid = " << commonFile.id()
-                    << ", filename = " << commonFile.filename()
-                    << ", sequenceNum = " << seq;
-                progress->SetStatus(TaskStatus::FAILED);
-                return StatusCode::kCommonFileDeleteError;
-            }
+    std::vector<bool> segmentDone;
+    bool deleteOk = DeleteChunks(segments, option_.deleteChunkBatchSize,
+                                 deleteChunk, progress, &segmentDone);
+
+    // chunk已经全部删除的segment即使有其他segment失败也可以删除，
+    // 重试时不需要再处理
+    for (size_t i = 0; i < segments.size(); i++) {
+        if (!segmentDone[i]) {
+            continue;
         }
 
         // delete segment
         int64_t revision;
         storeRet = storage_->DeleteSegment(
-            commonFile.id(), i * segmentSize, &revision);
+            commonFile.id(), segments[i].startoffset(), &revision);
         if (storeRet != StoreStatus::OK) {
             LOG(ERROR) << "Clean common File Error: "
             << "DeleteSegment Error, inodeid = " << commonFile.id()
             << ", filename = " << commonFile.filename()
-            << ", offset = " << i * segmentSize
+            << ", offset = " << segments[i].startoffset()
             << ", sequenceNum = " << commonFile.seqnum();
             progress->SetStatus(TaskStatus::FAILED);
             return StatusCode::kCommonFileDeleteError;
         }
-        allocStatistic_->DeAllocSpace(segment.logicalpoolid(),
-            segment.segmentsize(), revision);
-        progress->SetProgress(100 * (i + 1) / segmentNum);
+        allocStatistic_->DeAllocSpace(segments[i].logicalpoolid(),
+            segments[i].segmentsize(), revision);
+    }
+
+    if (!deleteOk) {
+        progress->SetStatus(TaskStatus::FAILED);
+        return StatusCode::kCommonFileDeleteError;
     }
 
     // delete the storage
@@ -169,7 +384,9 @@ StatusCode CleanCore::CleanFile(const FileInfo & commonFile,
     } else {
         LOG(INFO) << "inodeid = " << commonFile.id()
             << ", filename = " << commonFile.filename()
-            << ", seq = " << commonFile.seqnum() << ", deleted";
+            << ", seq = " << commonFile.seqnum() << ", deleted"
+            << ", chunks = " << progress->GetFinishedChunks()
+            << ", chunks per second = " << progress->GetChunksPerSecond();
     }
 
     progress->SetProgress(100);
@@ -23,28 +23,61 @@
 #ifndef SRC_MDS_NAMESERVER2_CLEAN_CORE_H_
 #define SRC_MDS_NAMESERVER2_CLEAN_CORE_H_
 
+#include <functional>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 #include "src/mds/nameserver2/namespace_storage.h"
 #include "src/mds/common/mds_define.h"
 #include "src/mds/nameserver2/task_progress.h"
 #include "src/mds/chunkserverclient/copyset_client.h"
 #include "src/mds/topology/topology.h"
 #include "src/mds/nameserver2/allocstatistic/alloc_statistic.h"
+#include "src/common/concurrent/concurrent.h"
+#include "src/common/concurrent/task_thread_pool.h"
 
 using ::curve::mds::chunkserverclient::CopysetClient;
 using ::curve::mds::topology::Topology;
+using ::curve::mds::topology::ChunkServerIdType;
 
 namespace curve {
 namespace mds {
 
+struct CleanOption {
+    // 同时删除的chunk的最大数量，所有清理任务共享
+    uint32_t deleteChunkConcurrency;
+    // 每个chunkserver上同时删除的chunk的最大数量
+    uint32_t chunkserverDeleteConcurrency;
+    // 删除文件时一个请求中最多删除的同一个copyset的chunk数量，
+    // 为1时逐个删除。老版本的chunkserver无法apply批量删除的日志，
+    // 所有chunkserver都升级之后才能调大
+    uint32_t deleteChunkBatchSize;
+
+    CleanOption()
+        : deleteChunkConcurrency(32),
+          chunkserverDeleteConcurrency(4),
+          deleteChunkBatchSize(1) {}
+};
+
+/**
+ * 清理文件和快照文件
+ *
+ * 一次性从存储中列出文件的所有segment，chunk的删除交给后台线程池并发执行，
+ * 线程池的大小限制了总的并发，同时根据copyset的leader限制每个chunkserver
+ * 上的并发，避免删除大文件时压垮个别chunkserver。
+ */
 class CleanCore {
  public:
+    /**
+     * @param topology 用于获取copyset的leader，为nullptr时不区分chunkserver
+     */
     CleanCore(std::shared_ptr<NameServerStorage> storage,
         std::shared_ptr<CopysetClient> copysetClient,
-        std::shared_ptr<AllocStatistic> allocStatistic)
-        : storage_(storage),
-          copysetClient_(copysetClient),
-          allocStatistic_(allocStatistic) {}
+        std::shared_ptr<AllocStatistic> allocStatistic,
+        std::shared_ptr<Topology> topology = nullptr,
+        const CleanOption& option = CleanOption());
+
+    ~CleanCore();
 
     /**
      * @brief 删除快照文件，更新task状态
@@ -65,10 +98,50 @@ class CleanCore {
     StatusCode CleanFile(const FileInfo & commonFile,
                         TaskProgress* progress);
 
+ private:
+    struct DeleteContext;
+
+    using DeleteChunkFunc = std::function<int(LogicalPoolID, CopysetID,
+                                              const std::vector<ChunkID>&)>;
+
+    /**
+     * @brief 并发删除segment中的所有chunk，有chunk删除失败后不再下发新的删除
+     * @param segments: 需要删除chunk的segment
+     * @param batchSize: 同一个copyset的chunk每batchSize个一起删除
+     * @param deleteChunk: 删除同一个copyset中的一批chunk，成功返回0
+     * @param progress: 根据已删除的chunk数量更新进度
+     * @param[out] segmentDone: 返回每个segment的chunk是否全部删除成功
+     * @return 所有chunk都删除成功返回true
+     */
+    bool DeleteChunks(const std::vector<PageFileSegment>& segments,
+                      uint32_t batchSize,
+                      const DeleteChunkFunc& deleteChunk,
+                      TaskProgress* progress,
+                      std::vector<bool>* segmentDone);
+
+    // 获取copyset的leader，获取不到时返回UNINTIALIZE_ID
+    ChunkServerIdType GetLeader(LogicalPoolID logicalPoolId,
+                                CopysetID copysetId);
+
+    // 等待chunkserver上的删除并发低于限制，并占用一个并发
+    void AcquireChunkServer(ChunkServerIdType csId);
+
+    void ReleaseChunkServer(ChunkServerIdType csId);
+
  private:
     std::shared_ptr<NameServerStorage> storage_;
     std::shared_ptr<CopysetClient> copysetClient_;
     std::shared_ptr<AllocStatistic> allocStatistic_;
+    std::shared_ptr<Topology> topology_;
+    CleanOption option_;
+
+    // 执行chunk删除的线程池
+    curve::common::TaskThreadPool<> deletePool_;
+
+    // 每个chunkserver上正在删除的chunk数量
+    curve::common::Mutex csMutex_;
+    curve::common::ConditionVariable csCond_;
+    std::unordered_map<ChunkServerIdType, uint32_t> csInflight_;
 };
 
 }  // namespace mds
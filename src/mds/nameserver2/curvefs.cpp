@@ -955,6 +955,30 @@ StatusCode CurveFS::ChangeOwner(const std::string &filename,
     return PutFile(fileInfo);
 }
 
+StatusCode CurveFS::UpdateFileThrottleParams(const std::string &filename,
+                                             const FileThrottleParams &params) {
+    FileInfo  fileInfo;
+    StatusCode ret = GetFileInfo(filename, &fileInfo);
+    if (ret != StatusCode::kOK) {
+        LOG(INFO) << "get source file error, errCode = " << ret;
+        return  ret;
+    }
+
+    if (fileInfo.filetype() != FileType::INODE_PAGEFILE) {
+        LOG(ERROR) << "file type not support throttle"
+                   << ", filename = " << filename;
+        return StatusCode::kNotSupported;
+    }
+
+    if (fileInfo.filestatus() == FileStatus::kFileDeleting) {
+        LOG(WARNING) << "file is being deleted, filename = " << filename;
+        return StatusCode::kFileUnderDeleting;
+    }
+
+    *fileInfo.mutable_throttleparams() = params;
+    return PutFile(fileInfo);
+}
+
 StatusCode CurveFS::GetOrAllocateSegment(const std::string & filename,
         offset_t offset, bool allocateIfNoExist,
         PageFileSegment *segment) {
@@ -1022,6 +1046,161 @@ StatusCode CurveFS::GetOrAllocateSegment(const std::string & filename,
     }
 }
 
+StatusCode CurveFS::GetSegments(const std::string& filename,
+                                offset_t offset,
+                                uint32_t count,
+                                bool allocateIfNotExist,
+                                std::vector<PageFileSegment>* segments) {
+    assert(segments != nullptr);
+
+    FileInfo fileInfo;
+    auto ret = GetFileInfo(filename, &fileInfo);
+    if (ret != StatusCode::kOK) {
+        LOG(INFO) << "get source file error, errCode = " << ret;
+        return ret;
+    }
+
+    if (fileInfo.filetype() != FileType::INODE_PAGEFILE) {
+        LOG(INFO) << "not pageFile, can't do this";
+        return StatusCode::kParaError;
+    }
+
+    if (offset % fileInfo.segmentsize() != 0) {
+        LOG(INFO) << "offset not align with segment";
+        return StatusCode::kParaError;
+    }
+
+    if (offset + fileInfo.segmentsize() > fileInfo.length()) {
+        LOG(INFO) << "bigger than file length";
+        return StatusCode::kParaError;
+    }
+
+    uint64_t left = (fileInfo.length() - offset) / fileInfo.segmentsize();
+    if (count > left) {
+        count = left;
+    }
+
+    // the unallocated segments are not in the storage, list the range once
+    // instead of getting the segments one by one
+    segments->clear();
+    offset_t endOffset =
+        offset + static_cast<uint64_t>(count) * fileInfo.segmentsize();
+    auto storeRet = storage_->ListSegmentInRange(fileInfo.id(), offset,
+                                                 endOffset, segments);
+    if (storeRet != StoreStatus::OK) {
+        LOG(ERROR) << "ListSegmentInRange fail, fileInfo.id() = "
+                   << fileInfo.id() << ", offset = " << offset
+                   << ", count = " << count;
+        segments->clear();
+        return StatusCode::KInternalError;
+    }
+
+    if (!allocateIfNotExist ||
+        segments->size() == static_cast<size_t>(count)) {
+        return StatusCode::kOK;
+    }
+
+    // allocate the holes of the range, so that a sequential writer gets
+    // the following segments with a single rpc
+    std::vector<PageFileSegment> allocated;
+    allocated.reserve(count);
+    auto iter = segments->begin();
+    for (offset_t off = offset; off < endOffset;
+         off += fileInfo.segmentsize()) {
+        if (iter != segments->end() &&
+            static_cast<offset_t>(iter->startoffset()) == off) {
+            allocated.emplace_back(std::move(*iter));
+            ++iter;
+            continue;
+        }
+        PageFileSegment segment;
+        ret = GetOrAllocateSegment(filename, off, true, &segment);
+        if (ret != StatusCode::kOK) {
+            LOG(ERROR) << "allocate segment fail, filename = " << filename
+                       << ", offset = " << off << ", errCode = " << ret;
+            segments->clear();
+            return ret;
+        }
+        allocated.emplace_back(std::move(segment));
+    }
+    segments->swap(allocated);
+    return StatusCode::kOK;
+}
+
+StatusCode CurveFS::DeAllocateSegment(const std::string& filename,
+                                      offset_t offset) {
+    FileInfo fileInfo;
+    auto ret = GetFileInfo(filename, &fileInfo);
+    if (ret != StatusCode::kOK) {
+        LOG(INFO) << "get source file error, errCode = " << ret;
+        return ret;
+    }
+
+    if (fileInfo.filetype() != FileType::INODE_PAGEFILE) {
+        LOG(INFO) << "not pageFile, can't do this";
+        return StatusCode::kParaError;
+    }
+
+    if (offset % fileInfo.segmentsize() != 0) {
+        LOG(INFO) << "offset not align with segment";
+        return StatusCode::kParaError;
+    }
+
+    // the chunks of clone file or clone source may still be read by others
+    if (fileInfo.filestatus() != FileStatus::kFileCreated
+        || !fileInfo.clonesource().empty()) {
+        LOG(INFO) << "file = " << filename << ", status = "
+                  << FileStatus_Name(fileInfo.filestatus())
+                  << ", can't deallocate segment";
+        return StatusCode::kNotSupported;
+    }
+
+    // the chunks are kept by chunkserver for snapshot
+    std::vector<FileInfo> snapShotFiles;
+    if (storage_->ListSnapshotFile(fileInfo.id(),
+                  fileInfo.id() + 1, &snapShotFiles) != StoreStatus::OK) {
+        LOG(ERROR) << filename << " listFile fail";
+        return StatusCode::kStorageError;
+    }
+    if (snapShotFiles.size() != 0) {
+        LOG(INFO) << filename << " exist snapshotfile, num = "
+                  << snapShotFiles.size() << ", can't deallocate segment";
+        return StatusCode::kFileUnderSnapShot;
+    }
+
+    PageFileSegment segment;
+    auto storeRet = storage_->GetSegment(fileInfo.id(), offset, &segment);
+    if (storeRet == StoreStatus::KeyNotExist) {
+        return StatusCode::kOK;
+    } else if (storeRet != StoreStatus::OK) {
+        LOG(ERROR) << "GetSegment fail, fileInfo.id() = " << fileInfo.id()
+                   << ", offset = " << offset;
+        return StatusCode::kStorageError;
+    }
+
+    // a snapshot taken after the check above changes the file info,
+    // the segment is deleted only if the file info is not changed
+    int64_t revision;
+    storeRet = storage_->DeleteSegmentIfFileUnchanged(fileInfo, offset,
+                                                      &revision);
+    if (storeRet == StoreStatus::ConditionNotMatch) {
+        LOG(INFO) << "file = " << filename << " changed during dealloc"
+                  << ", can't deallocate segment";
+        return StatusCode::kFileUnderSnapShot;
+    } else if (storeRet != StoreStatus::OK) {
+        LOG(ERROR) << "DeleteSegment fail, fileInfo.id() = " << fileInfo.id()
+                   << ", offset = " << offset;
+        return StatusCode::kStorageError;
+    }
+    allocStatistic_->DeAllocSpace(segment.logicalpoolid(),
+                                  segment.segmentsize(),
+                                  revision);
+
+    LOG(INFO) << "dealloc segment success, fileInfo.id() = " << fileInfo.id()
+              << ", offset = " << offset;
+    return StatusCode::kOK;
+}
+
 StatusCode CurveFS::CreateSnapShotFile(const std::string &fileName,
                                     FileInfo *snapshotFileInfo) {
     FileInfo  parentFileInfo;
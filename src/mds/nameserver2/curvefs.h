@@ -211,6 +211,16 @@ class CurveFS {
     StatusCode ChangeOwner(const std::string &filename,
                            const std::string &newOwner);
 
+    /**
+     *  @brief modify the qos limits of the file, the clients which opened
+     *         the file get the new limits when refreshing session
+     *  @param filename
+     *  @param params: new limits, replace the old ones
+     *  @return StatusCode::kOK if succeeded
+     */
+    StatusCode UpdateFileThrottleParams(const std::string &filename,
+                                        const FileThrottleParams &params);
+
     // segment(chunk) ops
 
     /**
@@ -229,6 +239,37 @@ class CurveFS {
         offset_t offset,
         bool allocateIfNoExist, PageFileSegment *segment);
 
+    /**
+     *  @brief release the segment whose data has been discarded, the chunks
+     *         of the segment should have been deleted by the client, and the
+     *         space of the segment is given back to the logical pool
+     *
+     *  @param filename
+     *  @param offset: offset of the segment
+     *  @return StatusCode::kOK if succeeded or the segment is not allocated,
+     *          StatusCode::kFileUnderSnapShot if the file has snapshot
+     */
+    StatusCode DeAllocateSegment(const std::string& filename,
+                                 offset_t offset);
+
+    /**
+     *  @brief query the allocated segments in [offset, offset + count *
+     *         segmentsize), the range is truncated at the end of the file
+     *
+     *  @param filename
+     *  @param offset: offset of the first segment
+     *  @param count: number of segments to query
+     *  @param allocateIfNotExist: allocate the segments not allocated yet,
+     *         otherwise they are skipped
+     *  @param segments: return the allocated segments in order of offset
+     *  @return StatusCode::kOK if succeeded
+     */
+    StatusCode GetSegments(const std::string& filename,
+                           offset_t offset,
+                           uint32_t count,
+                           bool allocateIfNotExist,
+                           std::vector<PageFileSegment>* segments);
+
     /**
      *  @brief get the root file info
      *  @param
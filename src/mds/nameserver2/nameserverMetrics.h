@@ -62,6 +62,25 @@ class NameserverCacheMetrics {
     bvar::Adder<uint64_t> cacheMiss;
 };
 
+// metric of each shard of the cache, for finding hot shards
+class NameserverCacheShardMetrics {
+ public:
+    explicit NameserverCacheShardMetrics(int shard) :
+        cacheCount(NameServerMetricsPrefix,
+            "shard_" + std::to_string(shard) + "_cache_count"),
+        cacheHit(NameServerMetricsPrefix,
+            "shard_" + std::to_string(shard) + "_cache_hit"),
+        cacheMiss(NameServerMetricsPrefix,
+            "shard_" + std::to_string(shard) + "_cache_miss") {}
+
+ public:
+    const std::string NameServerMetricsPrefix = "mds_nameserver_cache_metric";
+
+    bvar::Adder<int64_t> cacheCount;
+    bvar::Adder<uint64_t> cacheHit;
+    bvar::Adder<uint64_t> cacheMiss;
+};
+
 }  // namespace mds
 }  // namespace curve
 
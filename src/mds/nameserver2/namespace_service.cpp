@@ -355,6 +355,186 @@ void NameSpaceService::GetOrAllocateSegment(
     return;
 }
 
+void NameSpaceService::DeAllocateSegment(
+                    ::google::protobuf::RpcController* controller,
+                    const ::curve::mds::DeAllocateSegmentRequest* request,
+                    ::curve::mds::DeAllocateSegmentResponse* response,
+                    ::google::protobuf::Closure* done) {
+    brpc::ClosureGuard doneGuard(done);
+    brpc::Controller* cntl = static_cast<brpc::Controller*>(controller);
+    ExpiredTime expiredTime;
+
+    if (!isPathValid(request->filename())) {
+        response->set_statuscode(StatusCode::kParaError);
+        LOG(ERROR) << "logid = " << cntl->log_id()
+            << ", DeAllocateSegment request path is invalid, filename = "
+            << request->filename()
+            << ", offset = " << request->offset();
+        return;
+    }
+
+    LOG(INFO) << "logid = " << cntl->log_id()
+        << ", DeAllocateSegment request, filename = " << request->filename()
+        << ", offset = " << request->offset();
+
+    FileWriteLockGuard guard(fileLockManager_, request->filename());
+
+    std::string signature;
+    if (request->has_signature()) {
+        signature = request->signature();
+    }
+
+    StatusCode retCode;
+    retCode = kCurveFS.CheckFileOwner(request->filename(), request->owner(),
+                                      signature, request->date());
+    if (retCode != StatusCode::kOK) {
+        response->set_statuscode(retCode);
+        if (google::ERROR != GetMdsLogLevel(retCode)) {
+            LOG(WARNING) << "logid = " << cntl->log_id()
+                << ", CheckFileOwner fail, filename = " <<  request->filename()
+                << ", owner = " << request->owner()
+                << ", statusCode = " << retCode;
+        } else {
+            LOG(ERROR) << "logid = " << cntl->log_id()
+                << ", CheckFileOwner fail, filename = " <<  request->filename()
+                << ", owner = " << request->owner()
+                << ", statusCode = " << retCode;
+        }
+        return;
+    }
+
+    retCode = kCurveFS.DeAllocateSegment(request->filename(),
+                                         request->offset());
+    response->set_statuscode(retCode);
+    if (retCode != StatusCode::kOK)  {
+        if (google::ERROR != GetMdsLogLevel(retCode)) {
+            LOG(WARNING) << "logid = " << cntl->log_id()
+                << ", DeAllocateSegment fail, filename = "
+                <<  request->filename()
+                << ", offset = " << request->offset()
+                << ", statusCode = " << retCode
+                << ", StatusCode_Name = " << StatusCode_Name(retCode)
+                << ", cost " << expiredTime.ExpiredMs() << " ms";
+        } else {
+            LOG(ERROR) << "logid = " << cntl->log_id()
+                << ", DeAllocateSegment fail, filename = "
+                <<  request->filename()
+                << ", offset = " << request->offset()
+                << ", statusCode = " << retCode
+                << ", StatusCode_Name = " << StatusCode_Name(retCode)
+                << ", cost " << expiredTime.ExpiredMs() << " ms";
+        }
+    } else {
+        LOG(INFO) << "logid = " << cntl->log_id()
+                  << ", DeAllocateSegment ok, filename = "
+                  << request->filename() << ", offset = " << request->offset()
+                  << ", cost " << expiredTime.ExpiredMs() << " ms";
+    }
+}
+
+void NameSpaceService::GetSegments(
+                    ::google::protobuf::RpcController* controller,
+                    const ::curve::mds::GetSegmentsRequest* request,
+                    ::curve::mds::GetSegmentsResponse* response,
+                    ::google::protobuf::Closure* done) {
+    brpc::ClosureGuard doneGuard(done);
+    brpc::Controller* cntl = static_cast<brpc::Controller*>(controller);
+    ExpiredTime expiredTime;
+
+    if (!isPathValid(request->filename())) {
+        response->set_statuscode(StatusCode::kParaError);
+        LOG(ERROR) << "logid = " << cntl->log_id()
+            << ", GetSegments request path is invalid, filename = "
+            << request->filename()
+            << ", offset = " << request->offset()
+            << ", count = " << request->count()
+            << ", allocateTag = " << request->allocateifnotexist();
+        return;
+    }
+
+    LOG(INFO) << "logid = " << cntl->log_id()
+        << ", GetSegments request, filename = " << request->filename()
+        << ", offset = " << request->offset()
+        << ", count = " << request->count()
+        << ", allocateTag = " << request->allocateifnotexist();
+
+    // allocating the holes modifies the file, take the write lock as
+    // GetOrAllocateSegment does
+    std::unique_ptr<FileReadLockGuard> readGuard;
+    std::unique_ptr<FileWriteLockGuard> writeGuard;
+    if (request->allocateifnotexist()) {
+        writeGuard.reset(
+            new FileWriteLockGuard(fileLockManager_, request->filename()));
+    } else {
+        readGuard.reset(
+            new FileReadLockGuard(fileLockManager_, request->filename()));
+    }
+
+    std::string signature;
+    if (request->has_signature()) {
+        signature = request->signature();
+    }
+
+    StatusCode retCode;
+    retCode = kCurveFS.CheckFileOwner(request->filename(), request->owner(),
+                                      signature, request->date());
+    if (retCode != StatusCode::kOK) {
+        response->set_statuscode(retCode);
+        if (google::ERROR != GetMdsLogLevel(retCode)) {
+            LOG(WARNING) << "logid = " << cntl->log_id()
+                << ", CheckFileOwner fail, filename = " <<  request->filename()
+                << ", owner = " << request->owner()
+                << ", statusCode = " << retCode;
+        } else {
+            LOG(ERROR) << "logid = " << cntl->log_id()
+                << ", CheckFileOwner fail, filename = " <<  request->filename()
+                << ", owner = " << request->owner()
+                << ", statusCode = " << retCode;
+        }
+        return;
+    }
+
+    std::vector<PageFileSegment> segments;
+    retCode = kCurveFS.GetSegments(request->filename(), request->offset(),
+                                   request->count(),
+                                   request->allocateifnotexist(), &segments);
+    response->set_statuscode(retCode);
+    if (retCode != StatusCode::kOK)  {
+        if (google::ERROR != GetMdsLogLevel(retCode)) {
+            LOG(WARNING) << "logid = " << cntl->log_id()
+                << ", GetSegments fail, filename = "
+                <<  request->filename()
+                << ", offset = " << request->offset()
+                << ", count = " << request->count()
+                << ", allocateTag = " << request->allocateifnotexist()
+                << ", statusCode = " << retCode
+                << ", StatusCode_Name = " << StatusCode_Name(retCode)
+                << ", cost " << expiredTime.ExpiredMs() << " ms";
+        } else {
+            LOG(ERROR) << "logid = " << cntl->log_id()
+                << ", GetSegments fail, filename = "
+                <<  request->filename()
+                << ", offset = " << request->offset()
+                << ", count = " << request->count()
+                << ", allocateTag = " << request->allocateifnotexist()
+                << ", statusCode = " << retCode
+                << ", StatusCode_Name = " << StatusCode_Name(retCode)
+                << ", cost " << expiredTime.ExpiredMs() << " ms";
+        }
+    } else {
+        for (auto& segment : segments) {
+            response->add_pagefilesegments()->Swap(&segment);
+        }
+        LOG(INFO) << "logid = " << cntl->log_id()
+                  << ", GetSegments ok, filename = "
+                  << request->filename() << ", offset = " << request->offset()
+                  << ", count = " << request->count()
+                  << ", allocateTag = " << request->allocateifnotexist()
+                  << ", allocated = " << response->pagefilesegments_size()
+                  << ", cost " << expiredTime.ExpiredMs() << " ms";
+    }
+}
+
 void NameSpaceService::RenameFile(::google::protobuf::RpcController* controller,
                          const ::curve::mds::RenameFileRequest* request,
                          ::curve::mds::RenameFileResponse* response,
@@ -702,6 +882,81 @@ void NameSpaceService::ListDir(::google::protobuf::RpcController* controller,
     return;
 }
 
+void NameSpaceService::UpdateFileThrottleParams(
+                ::google::protobuf::RpcController* controller,
+                const ::curve::mds::UpdateFileThrottleParamsRequest* request,
+                ::curve::mds::UpdateFileThrottleParamsResponse* response,
+                ::google::protobuf::Closure* done) {
+    brpc::ClosureGuard doneGuard(done);
+    brpc::Controller* cntl = static_cast<brpc::Controller*>(controller);
+    ExpiredTime expiredTime;
+
+    if (!isPathValid(request->filename())) {
+        response->set_statuscode(StatusCode::kParaError);
+        LOG(ERROR) << "logid = " << cntl->log_id()
+                << ", UpdateFileThrottleParams request path is invalid"
+                << ", filename = " << request->filename();
+        return;
+    }
+
+    LOG(INFO) << "logid = " << cntl->log_id()
+              << ", UpdateFileThrottleParams request, filename = "
+              << request->filename()
+              << ", params = "
+              << request->throttleparams().ShortDebugString();
+
+    FileWriteLockGuard guard(fileLockManager_, request->filename());
+
+    StatusCode retCode;
+    // only root user can change the qos of the file
+    retCode = kCurveFS.CheckRootOwner(request->filename(), request->rootowner(),
+                                      request->signature(), request->date());
+    if (retCode != StatusCode::kOK) {
+        response->set_statuscode(retCode);
+        if (google::ERROR != GetMdsLogLevel(retCode)) {
+            LOG(WARNING) << "logid = " << cntl->log_id()
+                << ", CheckRootOwner fail, filename = " <<  request->filename()
+                << ", owner = " << request->rootowner()
+                << ", statusCode = " << retCode;
+        } else {
+            LOG(ERROR) << "logid = " << cntl->log_id()
+                << ", CheckRootOwner fail, filename = " <<  request->filename()
+                << ", owner = " << request->rootowner()
+                << ", statusCode = " << retCode;
+        }
+        return;
+    }
+
+    retCode = kCurveFS.UpdateFileThrottleParams(request->filename(),
+                                                request->throttleparams());
+    if (retCode != StatusCode::kOK)  {
+        response->set_statuscode(retCode);
+        if (google::ERROR != GetMdsLogLevel(retCode)) {
+            LOG(WARNING) << "logid = " << cntl->log_id()
+                         << ", UpdateFileThrottleParams fail, filename = "
+                         << request->filename()
+                         << ", statusCode = " << retCode
+                         << ", StatusCode_Name = " << StatusCode_Name(retCode)
+                         << ", cost " << expiredTime.ExpiredMs() << " ms";
+        } else {
+            LOG(ERROR) << "logid = " << cntl->log_id()
+                       << ", UpdateFileThrottleParams fail, filename = "
+                       << request->filename()
+                       << ", statusCode = " << retCode
+                       << ", StatusCode_Name = " << StatusCode_Name(retCode)
+                       << ", cost " << expiredTime.ExpiredMs() << " ms";
+        }
+    } else {
+        response->set_statuscode(StatusCode::kOK);
+        LOG(INFO) << "logid = " << cntl->log_id()
+                  << ", UpdateFileThrottleParams ok, filename = "
+                  << request->filename() << ", cost "
+                  << expiredTime.ExpiredMs() << " ms";
+    }
+
+    return;
+}
+
 void NameSpaceService::CreateSnapShot(
                         ::google::protobuf::RpcController* controller,
                        const ::curve::mds::CreateSnapShotRequest* request,
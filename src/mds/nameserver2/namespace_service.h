@@ -91,6 +91,16 @@ class NameSpaceService: public CurveFSService {
                        ::curve::mds::GetOrAllocateSegmentResponse* response,
                        ::google::protobuf::Closure* done) override;
 
+    void DeAllocateSegment(::google::protobuf::RpcController* controller,
+                       const ::curve::mds::DeAllocateSegmentRequest* request,
+                       ::curve::mds::DeAllocateSegmentResponse* response,
+                       ::google::protobuf::Closure* done) override;
+
+    void GetSegments(::google::protobuf::RpcController* controller,
+                       const ::curve::mds::GetSegmentsRequest* request,
+                       ::curve::mds::GetSegmentsResponse* response,
+                       ::google::protobuf::Closure* done) override;
+
     void RenameFile(::google::protobuf::RpcController* controller,
                        const ::curve::mds::RenameFileRequest* request,
                        ::curve::mds::RenameFileResponse* response,
@@ -111,6 +121,12 @@ class NameSpaceService: public CurveFSService {
                        ::curve::mds::ListDirResponse* response,
                        ::google::protobuf::Closure* done) override;
 
+    void UpdateFileThrottleParams(
+                ::google::protobuf::RpcController* controller,
+                const ::curve::mds::UpdateFileThrottleParamsRequest* request,
+                ::curve::mds::UpdateFileThrottleParamsResponse* response,
+                ::google::protobuf::Closure* done) override;
+
     void CreateSnapShot(::google::protobuf::RpcController* controller,
                        const ::curve::mds::CreateSnapShotRequest* request,
                        ::curve::mds::CreateSnapShotResponse* response,
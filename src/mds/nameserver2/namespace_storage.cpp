@@ -64,7 +64,7 @@ StoreStatus NameServerStorageImp::PutFile(const FileInfo &fileInfo) {
                     << errCode;
     } else {
         // update to cache
-        cache_->Put(storeKey, encodeFileInfo);
+        cache_->Put(storeKey, std::make_shared<FileInfo>(fileInfo));
     }
 
     return getErrorCode(errCode);
@@ -80,19 +80,25 @@ StoreStatus NameServerStorageImp::GetFile(InodeID parentid,
         return StoreStatus::InternalError;
     }
 
-    int errCode = EtcdErrCode::EtcdOK;
-    std::string out;
-    if (!cache_->Get(storeKey, &out)) {
-        errCode = client_->Get(storeKey, &out);
-
-        if (errCode == EtcdErrCode::EtcdOK) {
-            cache_->Put(storeKey, out);
+    // the cached object is parsed already, just copy it out
+    CacheValue value;
+    if (cache_->Get(storeKey, &value)) {
+        auto cached = std::dynamic_pointer_cast<const FileInfo>(value);
+        if (cached != nullptr) {
+            *fileInfo = *cached;
+            return StoreStatus::OK;
         }
     }
 
+    std::string out;
+    int errCode = client_->Get(storeKey, &out);
     if (errCode == EtcdErrCode::EtcdOK) {
-        bool decodeOK = NameSpaceStorageCodec::DecodeFileInfo(out, fileInfo);
+        auto decoded = std::make_shared<FileInfo>();
+        bool decodeOK =
+            NameSpaceStorageCodec::DecodeFileInfo(out, decoded.get());
         if (decodeOK) {
+            cache_->Put(storeKey, decoded);
+            *fileInfo = *decoded;
             return StoreStatus::OK;
         } else {
             LOG(ERROR) << "decode info error. parentid: " << parentid
@@ -207,7 +213,7 @@ StoreStatus NameServerStorageImp::RenameFile(const FileInfo &oldFInfo,
                    << errCode;
     } else {
         // update to cache at last
-        cache_->Put(newStoreKey, encodeNewFileInfo);
+        cache_->Put(newStoreKey, std::make_shared<FileInfo>(newFInfo));
     }
     return getErrorCode(errCode);
 }
@@ -298,8 +304,9 @@ StoreStatus NameServerStorageImp::ReplaceFileAndRecycleOldFile(
                    << errCode;
     } else {
         // update to cache
-        cache_->Put(recycleStoreKey, encodeRecycleFInfo);
-        cache_->Put(newStoreKey, encodeNewFInfo);
+        cache_->Put(recycleStoreKey,
+                    std::make_shared<FileInfo>(recycleFInfo));
+        cache_->Put(newStoreKey, std::make_shared<FileInfo>(newFInfo));
     }
     return getErrorCode(errCode);
 }
@@ -355,7 +362,8 @@ StoreStatus NameServerStorageImp::MoveFileToRecycle(
                    << errCode;
     } else {
         // update to cache
-        cache_->Put(recycleFileInfoKey, encodeRecycleFInfo);
+        cache_->Put(recycleFileInfoKey,
+                    std::make_shared<FileInfo>(recycleFileInfo));
     }
     return getErrorCode(errCode);
 }
@@ -411,6 +419,37 @@ StoreStatus NameServerStorageImp::ListSegment(InodeID id,
     return StoreStatus::OK;
 }
 
+StoreStatus NameServerStorageImp::ListSegmentInRange(InodeID id,
+                                    uint64_t startOff,
+                                    uint64_t endOff,
+                                    std::vector<PageFileSegment> *segments) {
+    // segment key is encoded in big endian, so the segments of the range
+    // are between the keys of startOff and endOff
+    std::string startStoreKey =
+                NameSpaceStorageCodec::EncodeSegmentStoreKey(id, startOff);
+    std::string endStoreKey =
+                NameSpaceStorageCodec::EncodeSegmentStoreKey(id, endOff);
+
+    std::vector<std::string> out;
+    int errCode = client_->List(startStoreKey, endStoreKey, &out);
+    if (errCode != EtcdErrCode::EtcdOK) {
+        LOG(ERROR) << "list segment of inodeid: " << id
+                   << ", range: [" << startOff << ", " << endOff << ")"
+                   << ", err:" << errCode;
+        return getErrorCode(errCode);
+    }
+
+    for (const auto &value : out) {
+        PageFileSegment segment;
+        if (!NameSpaceStorageCodec::DecodeSegment(value, &segment)) {
+            LOG(ERROR) << "decode one segment err";
+            return StoreStatus::InternalError;
+        }
+        segments->emplace_back(std::move(segment));
+    }
+    return StoreStatus::OK;
+}
+
 StoreStatus NameServerStorageImp::ListSnapshotFile(InodeID startid,
                                            InodeID endid,
                                            std::vector<FileInfo> *files) {
@@ -476,7 +515,7 @@ StoreStatus NameServerStorageImp::PutSegment(InodeID id,
         LOG(ERROR) << "put segment of logicalPoolId:"
                    << segment->logicalpoolid() << "err:" << errCode;
     } else {
-        cache_->Put(storeKey, encodeSegment);
+        cache_->Put(storeKey, std::make_shared<PageFileSegment>(*segment));
     }
     return getErrorCode(errCode);
 }
@@ -486,12 +525,17 @@ StoreStatus NameServerStorageImp::GetSegment(InodeID id,
                                              PageFileSegment *segment) {
     std::string storeKey =
         NameSpaceStorageCodec::EncodeSegmentStoreKey(id, off);
-    int errCode = EtcdErrCode::EtcdOK;
-    std::string out;
-    if (!cache_->Get(storeKey, &out)) {
-        errCode = client_->Get(storeKey, &out);
+    CacheValue value;
+    if (cache_->Get(storeKey, &value)) {
+        auto cached = std::dynamic_pointer_cast<const PageFileSegment>(value);
+        if (cached != nullptr) {
+            *segment = *cached;
+            return StoreStatus::OK;
+        }
     }
 
+    std::string out;
+    int errCode = client_->Get(storeKey, &out);
     if (errCode == EtcdErrCode::EtcdOK) {
         bool decodeOK = NameSpaceStorageCodec::DecodeSegment(out, segment);
         if (decodeOK) {
@@ -525,6 +569,42 @@ StoreStatus NameServerStorageImp::DeleteSegment(
     return getErrorCode(errCode);
 }
 
+StoreStatus NameServerStorageImp::DeleteSegmentIfFileUnchanged(
+    const FileInfo &fileInfo, uint64_t off, int64_t *revision) {
+    std::string fileKey;
+    if (GetStoreKey(fileInfo.filetype(), fileInfo.parentid(),
+                    fileInfo.filename(), &fileKey) != StoreStatus::OK) {
+        LOG(ERROR) << "get store key failed, filename = "
+                   << fileInfo.filename();
+        return StoreStatus::InternalError;
+    }
+
+    std::string encodeFileInfo;
+    if (!NameSpaceStorageCodec::EncodeFileInfo(fileInfo, &encodeFileInfo)) {
+        LOG(ERROR) << "encode file: " << fileInfo.filename() << "err";
+        return StoreStatus::InternalError;
+    }
+
+    std::string storeKey =
+        NameSpaceStorageCodec::EncodeSegmentStoreKey(fileInfo.id(), off);
+    int errCode = client_->CompareAndDelete(fileKey, encodeFileInfo,
+                                            storeKey, revision);
+
+    // Etcd is updated first and the cache after it, so that a concurrent
+    // reader can not refill the cache with the segment being deleted
+    cache_->Remove(storeKey);
+    if (errCode == EtcdErrCode::EtcdTxnCompareFailed) {
+        // the cached file info may be the stale one
+        cache_->Remove(fileKey);
+        LOG(INFO) << "file " << fileInfo.filename() << " changed, keep "
+                  << "segment of inodeid: " << fileInfo.id() << "off: " << off;
+    } else if (errCode != EtcdErrCode::EtcdOK) {
+        LOG(ERROR) << "delete segment of inodeid: " << fileInfo.id()
+                   << "off: " << off << ", err:" << errCode;
+    }
+    return getErrorCode(errCode);
+}
+
 StoreStatus NameServerStorageImp::SnapShotFile(const FileInfo *originFInfo,
                                             const FileInfo *snapshotFInfo) {
     std::string originFileKey;
@@ -584,8 +664,9 @@ StoreStatus NameServerStorageImp::SnapShotFile(const FileInfo *originFInfo,
                    << ", fileinfo: " << originFInfo->filename() << "err";
     } else {
         // update cache at last
-        cache_->Put(originFileKey, encodeFileInfo);
-        cache_->Put(snapshotFileKey, encodeSnapshot);
+        cache_->Put(originFileKey, std::make_shared<FileInfo>(*originFInfo));
+        cache_->Put(snapshotFileKey,
+                    std::make_shared<FileInfo>(*snapshotFInfo));
     }
     return getErrorCode(errCode);
 }
@@ -604,6 +685,9 @@ StoreStatus NameServerStorageImp::getErrorCode(int errCode) {
         case EtcdErrCode::EtcdKeyNotExist:
             return StoreStatus::KeyNotExist;
 
+        case EtcdErrCode::EtcdTxnCompareFailed:
+            return StoreStatus::ConditionNotMatch;
+
         case EtcdErrCode::EtcdUnknown:
         case EtcdErrCode::EtcdInvalidArgument:
         case EtcdErrCode::EtcdAlreadyExists:
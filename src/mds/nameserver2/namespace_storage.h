@@ -45,6 +45,8 @@ enum class StoreStatus {
     OK = 0,
     KeyNotExist,
     InternalError,
+    // the condition of a conditional update is not met
+    ConditionNotMatch,
 };
 std::ostream& operator << (std::ostream & os, StoreStatus &s);
 
@@ -167,6 +169,22 @@ class NameServerStorage {
     virtual StoreStatus ListSegment(InodeID id,
                                     std::vector<PageFileSegment> *segments) = 0;
 
+    /**
+     * @brief ListSegmentInRange: Get the segments of the file whose offset
+     *        is in [startOff, endOff) with one list request
+     *
+     * @param[in] id: Inode ID of the file
+     * @param[in] startOff: Offset of the first segment
+     * @param[in] endOff: End offset of the range, not included
+     * @param[out] segments: Segment list, ordered by offset
+     *
+     * @return StoreStatus: error code
+     */
+    virtual StoreStatus ListSegmentInRange(InodeID id,
+                                    uint64_t startOff,
+                                    uint64_t endOff,
+                                    std::vector<PageFileSegment> *segments) = 0;
+
     /**
      * @brief ListSnapshotFile: Get all snapshot files between [startid, endid)
      *
@@ -220,6 +238,22 @@ class NameServerStorage {
     virtual StoreStatus DeleteSegment(
         InodeID id, uint64_t off, int64_t *revision) = 0;
 
+    /**
+     * @brief DeleteSegmentIfFileUnchanged: Delete the specified segment
+     *        metadata only if the stored metadata of the file is still the
+     *        same as fileInfo, the check and the deletion are done in one
+     *        transaction
+     *
+     * @param[in] fileInfo: Metadata of the file that the check is based on
+     * @param[in] off: Offset of the target segment
+     * @param[out] revision: The version number of this operation
+     *
+     * @return StoreStatus: error code, ConditionNotMatch if the metadata of
+     *                      the file has been changed
+     */
+    virtual StoreStatus DeleteSegmentIfFileUnchanged(
+        const FileInfo &fileInfo, uint64_t off, int64_t *revision) = 0;
+
     /**
      * @brief SnapShotFile: Transaction for storing metadata of snapshotFile,
      *                      and update source file metadata
@@ -279,6 +313,11 @@ class NameServerStorageImp : public NameServerStorage {
     StoreStatus ListSegment(InodeID id,
                             std::vector<PageFileSegment> *segments) override;
 
+    StoreStatus ListSegmentInRange(InodeID id,
+                            uint64_t startOff,
+                            uint64_t endOff,
+                            std::vector<PageFileSegment> *segments) override;
+
     StoreStatus ListSnapshotFile(InodeID startid,
                         InodeID endid,
                         std::vector<FileInfo> * files) override;
@@ -295,6 +334,9 @@ class NameServerStorageImp : public NameServerStorage {
     StoreStatus DeleteSegment(
         InodeID id, uint64_t off, int64_t *revision) override;
 
+    StoreStatus DeleteSegmentIfFileUnchanged(
+        const FileInfo &fileInfo, uint64_t off, int64_t *revision) override;
+
     StoreStatus SnapShotFile(const FileInfo *originalFileInfo,
                             const FileInfo * snapshotFileInfo) override;
 
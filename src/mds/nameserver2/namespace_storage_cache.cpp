@@ -21,87 +21,108 @@
  */
 
 #include <glog/logging.h>
+#include <functional>
 #include "src/mds/nameserver2/namespace_storage_cache.h"
 
 namespace curve {
 namespace mds {
-void LRUCache::Put(const std::string &key, const std::string &value) {
-    ::curve::common::WriteLockGuard guard(lock_);
-    PutLocked(key, value);
+LRUCache::LRUCache(int maxCount, int shardNum) {
+    cacheMetrics_ = std::make_shared<NameserverCacheMetrics>();
+    if (shardNum <= 0) {
+        shardNum = 1;
+    }
+    for (int i = 0; i < shardNum; i++) {
+        shards_.emplace_back(new Shard(i));
+        if (maxCount > 0) {
+            shards_[i]->maxCount = (maxCount + shardNum - 1) / shardNum;
+        }
+    }
 }
 
-bool LRUCache::Get(const std::string &key, std::string *value) {
-    ::curve::common::WriteLockGuard guard(lock_);
-    auto iter = cache_.find(key);
-    if (iter == cache_.end()) {
+void LRUCache::Put(const std::string &key, const CacheValue &value) {
+    Shard *shard = GetShard(key);
+    ::curve::common::LockGuard guard(shard->lock);
+    PutLocked(shard, key, value);
+}
+
+bool LRUCache::Get(const std::string &key, CacheValue *value) {
+    Shard *shard = GetShard(key);
+    ::curve::common::LockGuard guard(shard->lock);
+    auto iter = shard->cache.find(key);
+    if (iter == shard->cache.end()) {
         cacheMetrics_->OnCacheMiss();
+        shard->metrics.cacheMiss << 1;
         return false;
     }
 
     cacheMetrics_->OnCacheHit();
+    shard->metrics.cacheHit << 1;
 
     // update the position of the target item in the list
-    MoveToFront(iter->second);
-    *value = cache_[key]->value;
+    shard->ll.splice(shard->ll.begin(), shard->ll, iter->second);
+    *value = iter->second->value;
     return true;
 }
 
 void LRUCache::Remove(const std::string &key) {
-    ::curve::common::WriteLockGuard guard(lock_);
-    RemoveLocked(key);
+    Shard *shard = GetShard(key);
+    ::curve::common::LockGuard guard(shard->lock);
+    RemoveLocked(shard, key);
 }
 
 std::shared_ptr<NameserverCacheMetrics> LRUCache::GetCacheMetrics() const {
     return  cacheMetrics_;
 }
 
-void LRUCache::PutLocked(const std::string &key, const std::string &value) {
-    auto iter = cache_.find(key);
+LRUCache::Shard *LRUCache::GetShard(const std::string &key) {
+    if (shards_.size() == 1) {
+        return shards_[0].get();
+    }
+    return shards_[std::hash<std::string>()(key) % shards_.size()].get();
+}
+
+void LRUCache::PutLocked(Shard *shard, const std::string &key,
+                         const CacheValue &value) {
+    auto iter = shard->cache.find(key);
 
     // delete the old value if already exist
-    if (iter != cache_.end()) {
-        RemoveElement(iter->second);
+    if (iter != shard->cache.end()) {
+        RemoveElement(shard, iter->second);
     }
 
     // put new value
-    Item kv{key, value};
-    ll_.push_front(kv);
-    cache_[key] = ll_.begin();
+    uint64_t size = key.size() + value->ByteSizeLong();
+    shard->ll.push_front(Item{key, value, size});
+    shard->cache[key] = shard->ll.begin();
+    shard->metrics.cacheCount << 1;
     cacheMetrics_->UpdateAddToCacheCount();
-    cacheMetrics_->UpdateAddToCacheBytes(key.size() + value.size());
-    if (maxCount_ != 0 && ll_.size() > maxCount_) {
-        RemoveOldest();
+    cacheMetrics_->UpdateAddToCacheBytes(size);
+    if (shard->maxCount != 0 && shard->ll.size() > shard->maxCount) {
+        RemoveOldest(shard);
     }
 }
 
-void LRUCache::RemoveLocked(const std::string &key) {
-    auto iter = cache_.find(key);
-    if (iter != cache_.end()) {
-        RemoveElement(iter->second);
+void LRUCache::RemoveLocked(Shard *shard, const std::string &key) {
+    auto iter = shard->cache.find(key);
+    if (iter != shard->cache.end()) {
+        RemoveElement(shard, iter->second);
     }
 }
 
-void LRUCache::MoveToFront(const std::list<Item>::iterator &elem) {
-    Item duplica{elem->key, elem->value};
-    ll_.erase(elem);
-    ll_.push_front(duplica);
-    cache_[duplica.key] = ll_.begin();
-}
-
-void LRUCache::RemoveOldest() {
-    if (ll_.begin() != ll_.end()) {
-        RemoveElement(--ll_.end());
+void LRUCache::RemoveOldest(Shard *shard) {
+    if (shard->ll.begin() != shard->ll.end()) {
+        RemoveElement(shard, --shard->ll.end());
     }
 }
 
-void LRUCache::RemoveElement(const std::list<Item>::iterator &elem) {
+void LRUCache::RemoveElement(Shard *shard,
+                             const std::list<Item>::iterator &elem) {
+    shard->metrics.cacheCount << -1;
     cacheMetrics_->UpdateRemoveFromCacheCount();
-    cacheMetrics_->UpdateRemoveFromCacheBytes(
-        elem->key.size() + elem->value.size());
+    cacheMetrics_->UpdateRemoveFromCacheBytes(elem->size);
 
-    auto iter = cache_.find(elem->key);
-    cache_.erase(iter);
-    ll_.erase(elem);
+    shard->cache.erase(elem->key);
+    shard->ll.erase(elem);
 }
 
 }  // namespace mds
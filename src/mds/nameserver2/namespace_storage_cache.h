@@ -23,29 +23,40 @@
 #ifndef SRC_MDS_NAMESERVER2_NAMESPACE_STORAGE_CACHE_H_
 #define SRC_MDS_NAMESERVER2_NAMESPACE_STORAGE_CACHE_H_
 
+#include <google/protobuf/message.h>
+
 #include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include "src/common/concurrent/concurrent.h"
 #include "src/mds/nameserver2/nameserverMetrics.h"
 
 namespace curve {
 namespace mds {
+// Parsed FileInfo or PageFileSegment. Cached objects are shared by the
+// cache and the readers, so they must not be modified after put
+using CacheValue = std::shared_ptr<const ::google::protobuf::Message>;
+
 struct Item {
     std::string key;
-    std::string value;
+    CacheValue value;
+    // size of key and encoded value, for cache bytes metric
+    uint64_t size;
 };
 
 class Cache {
  public:
+    virtual ~Cache() = default;
+
     /*
     * @brief Store key-value to the cache
     *
     * @param[in] key
     * @param[in] value
     */
-    virtual void Put(const std::string &key, const std::string &value) = 0;
+    virtual void Put(const std::string &key, const CacheValue &value) = 0;
 
     /*
     * @brief Get corresponding value of the key from the cache
@@ -55,7 +66,7 @@ class Cache {
     *
     * @return false if failed, true if succeeded
     */
-    virtual bool Get(const std::string &key, std::string *value) = 0;
+    virtual bool Get(const std::string &key, CacheValue *value) = 0;
 
     /*
     * @brief Remove Remove key-value from cache
@@ -65,64 +76,71 @@ class Cache {
     virtual void Remove(const std::string &key) = 0;
 };
 
+// Keys are distributed to shards by hash, each shard has its own lock
+// and LRU list, so lookups of different files don't contend on one lock
 class LRUCache : public Cache {
  public:
-    LRUCache() : maxCount_(0) {
-        cacheMetrics_ = std::make_shared<NameserverCacheMetrics>();
-    }
-    explicit LRUCache(int maxCount) : maxCount_(maxCount) {
-        cacheMetrics_ = std::make_shared<NameserverCacheMetrics>();
-    }
-
-    void Put(const std::string &key, const std::string &value) override;
-    bool Get(const std::string &key, std::string *value) override;
+    LRUCache() : LRUCache(0) {}
+    /*
+    * @param[in] maxCount the maximum number of items, 0 indicates unlimited
+    * @param[in] shardNum number of shards, maxCount is divided evenly
+    */
+    explicit LRUCache(int maxCount, int shardNum = 1);
+
+    void Put(const std::string &key, const CacheValue &value) override;
+    bool Get(const std::string &key, CacheValue *value) override;
     void Remove(const std::string &key) override;
     std::shared_ptr<NameserverCacheMetrics> GetCacheMetrics() const;
 
  private:
+    struct Shard {
+        explicit Shard(int index) : maxCount(0), metrics(index) {}
+
+        ::curve::common::Mutex lock;
+        // the maximum length of the queue. 0 indicates unlimited length
+        uint64_t maxCount;
+        // dequeue for storing items
+        std::list<Item> ll;
+        // record the position of the item corresponding to the key
+        std::unordered_map<std::string, std::list<Item>::iterator> cache;
+        NameserverCacheShardMetrics metrics;
+    };
+
+    Shard *GetShard(const std::string &key);
+
     /*
-    * @brief PutLocked Store key-value in cache, not thread safe
+    * @brief PutLocked Store key-value in shard, not thread safe
     *
+    * @param[in] shard
     * @param[in] key
     * @param[in] value
     */
-    void PutLocked(const std::string &key, const std::string &value);
+    void PutLocked(Shard *shard, const std::string &key,
+                   const CacheValue &value);
 
     /*
-    * @brief RemoveLocked Remove key-value from the cache, not thread safe
+    * @brief RemoveLocked Remove key-value from the shard, not thread safe
     *
+    * @param[in] shard
     * @param[in] key
     */
-    void RemoveLocked(const std::string &key);
-
-    /*
-    * @brief MoveToFront Move the element hit this to the head of the list
-    *
-    * @param[in] elem Target element
-    */
-    void MoveToFront(const std::list<Item>::iterator &elem);
+    void RemoveLocked(Shard *shard, const std::string &key);
 
     /*
     * @brief RemoveOldest Remove elements exceeded maxCount
     */
-    void RemoveOldest();
+    void RemoveOldest(Shard *shard);
 
     /*
     * @brief RemoveElement Remove specified element
     *
+    * @param[in] shard
     * @param[in] elem Specified element
     */
-    void RemoveElement(const std::list<Item>::iterator &elem);
+    void RemoveElement(Shard *shard, const std::list<Item>::iterator &elem);
 
  private:
-    ::curve::common::RWLock lock_;
-
-    // the maximum length of the queue. 0 indicates unlimited length
-    int maxCount_;
-    // dequeue for storing items
-    std::list<Item> ll_;
-    // record the position of the item corresponding to the key in the dequeue
-    std::unordered_map<std::string, std::list<Item>::iterator> cache_;
+    std::vector<std::unique_ptr<Shard>> shards_;
 
     // cache related metric data
     std::shared_ptr<NameserverCacheMetrics> cacheMetrics_;
@@ -39,6 +39,8 @@ class TaskProgress {
     TaskProgress() {
         progress_ = 0;
         status_ = TaskStatus::PROGRESSING;
+        totalChunks_ = 0;
+        finishedChunks_ = 0;
         startTime_ = ::curve::common::TimeUtility::GetTimeofDayUs();
     }
 
@@ -58,10 +60,41 @@ class TaskProgress {
         status_ = status;
     }
 
+    void SetTotalChunks(uint64_t totalChunks) {
+        totalChunks_ = totalChunks;
+    }
+
+    uint64_t GetTotalChunks() const {
+        return totalChunks_;
+    }
+
+    void SetFinishedChunks(uint64_t finishedChunks) {
+        finishedChunks_ = finishedChunks;
+    }
+
+    uint64_t GetFinishedChunks() const {
+        return finishedChunks_;
+    }
+
+    /**
+     * @brief 从任务开始到现在平均每秒处理的chunk数量
+     */
+    double GetChunksPerSecond() const {
+        uint64_t elapsedUs =
+            ::curve::common::TimeUtility::GetTimeofDayUs() - startTime_;
+        if (elapsedUs == 0) {
+            return 0;
+        }
+        return finishedChunks_ * 1000000.0 / elapsedUs;
+    }
+
  private:
     uint32_t progress_;
     TaskStatus status_;
     uint64_t startTime_;
+    // 需要删除的chunk数量和已经删除的chunk数量
+    uint64_t totalChunks_;
+    uint64_t finishedChunks_;
 };
 
 }   //  namespace mds
@@ -85,6 +85,13 @@ class Coordinator {
      */
     virtual bool ChunkserverGoingToAdd(ChunkServerIdType csId, CopySetKey key);
 
+    /**
+     * @brief determine whether there's any operator on specified copyset
+     *
+     * @param[in] key Copyset specified
+     */
+    virtual bool HasOperator(CopySetKey key);
+
     /**
      * @brief Initialize the scheduler according to the configuration
      *
@@ -39,7 +39,7 @@ int RecoverScheduler::Schedule() {
     std::set<ChunkServerIdType> excludes;
     CalculateExcludesChunkServer(&excludes);
 
-    for (auto copysetInfo : topo_->GetCopySetInfos()) {
+    for (const auto &copysetInfo : topo_->GetCopySetInfos()) {
         // skip the copyset under configuration change
         Operator op;
         if (opController_->GetOperatorById(copysetInfo.id, &op)) {
@@ -32,7 +32,7 @@ namespace schedule {
 int ReplicaScheduler::Schedule() {
     LOG(INFO) << "replicaScheduelr begin.";
     int oneRoundGenOp = 0;
-    for (auto info : topo_->GetCopySetInfos()) {
+    for (const auto &info : topo_->GetCopySetInfos()) {
         // skip if there's any operator on a copyset
         Operator op;
         if (opController_->GetOperatorById(info.id, &op)) {
@@ -79,6 +79,10 @@ struct ScheduleOption {
     // operation arrive, the operation will wait for the replay and will be
     // stuck and exceed the 'leadertimeout' if the replay takes too long time.
     uint32_t chunkserverCoolingTimeSec;
+    // copysets and chunkservers used by schedulers are converted from
+    // topology into a shared snapshot at most once in this interval,
+    // 0 means every scheduler traverses topology by itself
+    uint32_t topoSnapshotRefreshIntervalMs;
 };
 
 }  // namespace schedule
@@ -148,13 +148,70 @@ bool ChunkServerInfo::IsHealthy() const {
            status == ChunkServerStatus::READWRITE;
 }
 
+std::vector<CopySetInfo> TopoSnapshot::GetCopySetInfos() const {
+    std::vector<CopySetInfo> infos;
+    infos.reserve(copysets.size());
+    for (const auto &info : copysets) {
+        if (info.logicalPoolWork) {
+            infos.emplace_back(info);
+        }
+    }
+    return infos;
+}
+
+std::vector<CopySetInfo> TopoSnapshot::GetCopySetInfosInChunkServer(
+    ChunkServerIdType id) const {
+    std::vector<CopySetInfo> infos;
+    auto it = copysetsInChunkServer.find(id);
+    if (it == copysetsInChunkServer.end()) {
+        return infos;
+    }
+
+    infos.reserve(it->second.size());
+    for (size_t index : it->second) {
+        infos.emplace_back(copysets[index]);
+    }
+    return infos;
+}
+
+std::vector<CopySetInfo> TopoSnapshot::GetCopySetInfosInLogicalPool(
+    PoolIdType lid) const {
+    auto it = copysetRanges.find(lid);
+    if (it == copysetRanges.end()) {
+        return {};
+    }
+    return std::vector<CopySetInfo>(copysets.begin() + it->second.first,
+                                    copysets.begin() + it->second.second);
+}
+
+std::vector<ChunkServerInfo> TopoSnapshot::GetChunkServerInfos() const {
+    return chunkservers;
+}
+
+std::vector<ChunkServerInfo> TopoSnapshot::GetChunkServersInLogicalPool(
+    PoolIdType lid) const {
+    std::vector<ChunkServerInfo> infos;
+    auto it = chunkserversInPool.find(lid);
+    if (it == chunkserversInPool.end()) {
+        return infos;
+    }
+
+    infos.reserve(it->second.size());
+    for (size_t index : it->second) {
+        infos.emplace_back(chunkservers[index]);
+    }
+    return infos;
+}
+
 TopoAdapterImpl::TopoAdapterImpl(
     std::shared_ptr<Topology> topo,
     std::shared_ptr<TopologyServiceManager> manager,
-    std::shared_ptr<TopologyStat> stat) {
+    std::shared_ptr<TopologyStat> stat,
+    uint32_t snapshotRefreshIntervalMs) {
     this->topo_ = topo;
     this->topoServiceManager_ = manager;
     this->topoStat_ = stat;
+    this->snapshotRefreshIntervalMs_ = snapshotRefreshIntervalMs;
 }
 
 std::vector<PoolIdType> TopoAdapterImpl::GetLogicalpools() {
@@ -183,6 +240,116 @@ bool TopoAdapterImpl::GetCopySetInfo(const CopySetKey &id, CopySetInfo *info) {
 }
 
 std::vector<CopySetInfo> TopoAdapterImpl::GetCopySetInfos() {
+    auto snapshot = GetSnapshot();
+    if (snapshot != nullptr) {
+        return snapshot->GetCopySetInfos();
+    }
+    return GetCopySetInfosFromTopo();
+}
+
+std::vector<CopySetInfo> TopoAdapterImpl::GetCopySetInfosInChunkServer(
+    ChunkServerIdType id) {
+    auto snapshot = GetSnapshot();
+    if (snapshot != nullptr) {
+        return snapshot->GetCopySetInfosInChunkServer(id);
+    }
+    return GetCopySetInfosInChunkServerFromTopo(id);
+}
+
+std::vector<CopySetInfo> TopoAdapterImpl::GetCopySetInfosInLogicalPool(
+    PoolIdType lid) {
+    auto snapshot = GetSnapshot();
+    if (snapshot != nullptr) {
+        return snapshot->GetCopySetInfosInLogicalPool(lid);
+    }
+    return GetCopySetInfosInLogicalPoolFromTopo(lid);
+}
+
+std::vector<ChunkServerInfo> TopoAdapterImpl::GetChunkServerInfos() {
+    auto snapshot = GetSnapshot();
+    if (snapshot != nullptr) {
+        return snapshot->GetChunkServerInfos();
+    }
+    return GetChunkServerInfosFromTopo();
+}
+
+std::vector<ChunkServerInfo> TopoAdapterImpl::GetChunkServersInLogicalPool(
+    PoolIdType lid) {
+    auto snapshot = GetSnapshot();
+    if (snapshot != nullptr) {
+        return snapshot->GetChunkServersInLogicalPool(lid);
+    }
+    return GetChunkServersInLogicalPoolFromTopo(lid);
+}
+
+std::shared_ptr<const TopoSnapshot> TopoAdapterImpl::GetSnapshot() {
+    if (snapshotRefreshIntervalMs_ == 0) {
+        return nullptr;
+    }
+
+    ::curve::common::LockGuard guard(snapshotMutex_);
+    auto now = std::chrono::steady_clock::now();
+    if (snapshot_ == nullptr || now - snapshot_->buildTime >=
+        std::chrono::milliseconds(snapshotRefreshIntervalMs_)) {
+        snapshot_ = BuildSnapshot();
+    }
+    return snapshot_;
+}
+
+std::shared_ptr<const TopoSnapshot> TopoAdapterImpl::BuildSnapshot() {
+    auto snapshot = std::make_shared<TopoSnapshot>();
+    snapshot->version = ++snapshotVersion_;
+    snapshot->buildTime = std::chrono::steady_clock::now();
+
+    snapshot->chunkservers = GetChunkServerInfosFromTopo();
+    std::unordered_map<ChunkServerIdType, size_t> chunkserverIndex;
+    for (size_t i = 0; i < snapshot->chunkservers.size(); i++) {
+        chunkserverIndex[snapshot->chunkservers[i].info.id] = i;
+    }
+
+    for (auto lid : topo_->GetLogicalPoolInCluster()) {
+        ::curve::mds::topology::LogicalPool lpool;
+        if (!topo_->GetLogicalPool(lid, &lpool)) {
+            continue;
+        }
+        bool work = lpool.GetLogicalPoolAvaliableFlag();
+
+        // copysets of the pool are converted at once, and stored together
+        size_t begin = snapshot->copysets.size();
+        for (auto &origin : topo_->GetCopySetInfosInLogicalPool(lid)) {
+            CopySetInfo info;
+            if (!CopySetFromTopoToSchedule(origin, &info)) {
+                continue;
+            }
+            info.logicalPoolWork = work;
+            if (work) {
+                for (auto &peer : info.peers) {
+                    snapshot->copysetsInChunkServer[peer.id].emplace_back(
+                        snapshot->copysets.size());
+                }
+            }
+            snapshot->copysets.emplace_back(info);
+        }
+        snapshot->copysetRanges[lid] =
+            std::make_pair(begin, snapshot->copysets.size());
+
+        auto &csInPool = snapshot->chunkserversInPool[lid];
+        auto ids = topo_->GetChunkServerInLogicalPool(lid,
+            [](const ChunkServer &chunkserver) {
+                return chunkserver.GetStatus() != ChunkServerStatus::RETIRED;
+            });
+        for (auto id : ids) {
+            auto it = chunkserverIndex.find(id);
+            if (it != chunkserverIndex.end()) {
+                csInPool.emplace_back(it->second);
+            }
+        }
+    }
+
+    return snapshot;
+}
+
+std::vector<CopySetInfo> TopoAdapterImpl::GetCopySetInfosFromTopo() {
     std::vector<CopySetInfo> infos;
     for (auto copySetKey : topo_->GetCopySetsInCluster()) {
         CopySetInfo copySetInfo;
@@ -195,8 +362,8 @@ std::vector<CopySetInfo> TopoAdapterImpl::GetCopySetInfos() {
     return infos;
 }
 
-std::vector<CopySetInfo> TopoAdapterImpl::GetCopySetInfosInChunkServer(
-    ChunkServerIdType id) {
+std::vector<CopySetInfo>
+TopoAdapterImpl::GetCopySetInfosInChunkServerFromTopo(ChunkServerIdType id) {
     std::vector<CopySetKey> keys = topo_->GetCopySetsInChunkServer(id);
 
     std::vector<CopySetInfo> out;
@@ -211,8 +378,8 @@ std::vector<CopySetInfo> TopoAdapterImpl::GetCopySetInfosInChunkServer(
     return out;
 }
 
-std::vector<CopySetInfo> TopoAdapterImpl::GetCopySetInfosInLogicalPool(
-    PoolIdType lid) {
+std::vector<CopySetInfo>
+TopoAdapterImpl::GetCopySetInfosInLogicalPoolFromTopo(PoolIdType lid) {
     std::vector<CopySetInfo> infos;
     for (auto &copysetInfo : topo_->GetCopySetInfosInLogicalPool(lid)) {
         ::curve::mds::schedule::CopySetInfo out;
@@ -236,7 +403,7 @@ bool TopoAdapterImpl::GetChunkServerInfo(ChunkServerIdType id,
     return ChunkServerFromTopoToSchedule(cs, out);
 }
 
-std::vector<ChunkServerInfo> TopoAdapterImpl::GetChunkServerInfos() {
+std::vector<ChunkServerInfo> TopoAdapterImpl::GetChunkServerInfosFromTopo() {
     std::vector<ChunkServerInfo> infos;
     for (auto chunkServerId : topo_->GetChunkServerInCluster(
         [] (const ChunkServer &cs) {
@@ -251,8 +418,8 @@ std::vector<ChunkServerInfo> TopoAdapterImpl::GetChunkServerInfos() {
     return infos;
 }
 
-std::vector<ChunkServerInfo> TopoAdapterImpl::GetChunkServersInLogicalPool(
-    PoolIdType lid) {
+std::vector<ChunkServerInfo>
+TopoAdapterImpl::GetChunkServersInLogicalPoolFromTopo(PoolIdType lid) {
     std::vector<ChunkServerInfo> infos;
     auto ids = topo_->GetChunkServerInLogicalPool(lid,
         [](const ChunkServer &chunkserver) {
@@ -27,6 +27,10 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <chrono>  //NOLINT
+#include <unordered_map>
+#include <utility>
+#include "src/common/concurrent/concurrent.h"
 #include "src/mds/topology/topology.h"
 #include "src/mds/topology/topology_service_manager.h"
 #include "src/mds/topology/topology_stat.h"
@@ -155,6 +159,46 @@ struct ChunkServerInfo {
     ChunkServerStatisticInfo statisticInfo;
 };
 
+/**
+ * @brief TopoSnapshot is a read-only view of copysets and chunkservers
+ *        converted in one pass over topology. It is shared by all the
+ *        schedulers until it is rebuilt, and must not be modified after
+ *        being published.
+ */
+struct TopoSnapshot {
+ public:
+    // copysets in available logical pools
+    std::vector<CopySetInfo> GetCopySetInfos() const;
+
+    std::vector<CopySetInfo> GetCopySetInfosInChunkServer(
+        ChunkServerIdType id) const;
+
+    std::vector<CopySetInfo> GetCopySetInfosInLogicalPool(
+        PoolIdType lid) const;
+
+    std::vector<ChunkServerInfo> GetChunkServerInfos() const;
+
+    std::vector<ChunkServerInfo> GetChunkServersInLogicalPool(
+        PoolIdType lid) const;
+
+    // increased by one every time the snapshot is rebuilt
+    uint64_t version = 0;
+    std::chrono::steady_clock::time_point buildTime;
+
+    // copysets of all logical pools, grouped by logical pool
+    std::vector<CopySetInfo> copysets;
+    // logical pool id => [begin, end) of its copysets
+    std::map<PoolIdType, std::pair<size_t, size_t>> copysetRanges;
+    // chunkserver id => index of copysets it's in, only for available pools
+    std::unordered_map<ChunkServerIdType, std::vector<size_t>>
+        copysetsInChunkServer;
+
+    // all the chunkservers not retired
+    std::vector<ChunkServerInfo> chunkservers;
+    // logical pool id => index of chunkservers in the pool
+    std::map<PoolIdType, std::vector<size_t>> chunkserversInPool;
+};
+
 /**
  * @brief TopoAdapter is the interface for providing topology info
  */
@@ -319,9 +363,16 @@ class TopoAdapter {
 class TopoAdapterImpl : public TopoAdapter {
  public:
     TopoAdapterImpl() = default;
+    /**
+     * @param[in] snapshotRefreshIntervalMs if not zero, GetCopySetInfos*
+     *            and GetChunkServerInfos/GetChunkServersInLogicalPool are
+     *            served from a shared snapshot rebuilt at most once in this
+     *            interval, otherwise topology is traversed on every call
+     */
     explicit TopoAdapterImpl(std::shared_ptr<Topology> topo,
                              std::shared_ptr<TopologyServiceManager> manager,
-                             std::shared_ptr<TopologyStat> stat);
+                             std::shared_ptr<TopologyStat> stat,
+                             uint32_t snapshotRefreshIntervalMs = 0);
 
     std::vector<PoolIdType> GetLogicalpools() override;
 
@@ -364,13 +415,45 @@ class TopoAdapterImpl : public TopoAdapter {
     void GetChunkServerScatterMap(const ChunkServerIdType &cs,
         std::map<ChunkServerIdType, int> *out) override;
 
+    /**
+     * @brief GetSnapshot get the snapshot shared by schedulers, rebuild it
+     *                    if it's older than snapshotRefreshIntervalMs.
+     *                    schedulers running at the same time wait for the
+     *                    same rebuild instead of traversing topology by
+     *                    themselves
+     *
+     * @return the snapshot, nullptr if snapshot is disabled
+     */
+    std::shared_ptr<const TopoSnapshot> GetSnapshot();
+
  private:
     bool GetPeerInfo(ChunkServerIdType id, PeerInfo *peerInfo);
 
+    std::shared_ptr<const TopoSnapshot> BuildSnapshot();
+
+    std::vector<CopySetInfo> GetCopySetInfosFromTopo();
+
+    std::vector<CopySetInfo> GetCopySetInfosInChunkServerFromTopo(
+        ChunkServerIdType id);
+
+    std::vector<CopySetInfo> GetCopySetInfosInLogicalPoolFromTopo(
+        PoolIdType lid);
+
+    std::vector<ChunkServerInfo> GetChunkServerInfosFromTopo();
+
+    std::vector<ChunkServerInfo> GetChunkServersInLogicalPoolFromTopo(
+        PoolIdType lid);
+
  private:
     std::shared_ptr<Topology> topo_;
     std::shared_ptr<TopologyServiceManager> topoServiceManager_;
     std::shared_ptr<TopologyStat> topoStat_;
+
+    uint32_t snapshotRefreshIntervalMs_ = 0;
+    // protect snapshot_ and snapshotVersion_, and is held during rebuilding
+    ::curve::common::Mutex snapshotMutex_;
+    std::shared_ptr<const TopoSnapshot> snapshot_;
+    uint64_t snapshotVersion_ = 0;
 };
 }  // namespace schedule
 }  // namespace mds
@@ -50,6 +50,7 @@ void MDS::InitMdsOptions(std::shared_ptr<Configuration> conf) {
     InitCopysetOption(&options_.copysetOption);
     InitChunkServerClientOption(&options_.chunkServerClientOption);
     InitSnapshotCloneClientOption(&options_.snapshotCloneClientOption);
+    InitCleanOption(&options_.cleanOption);
 
     conf_->GetValueFatalIfFail(
         "mds.segment.alloc.retryInterMs", &options_.retryInterTimes);
@@ -59,6 +60,8 @@ void MDS::InitMdsOptions(std::shared_ptr<Configuration> conf) {
 
     // cache size of namestorage
     conf_->GetValueFatalIfFail("mds.cache.count", &options_.mdsCacheCount);
+    conf_->GetValueFatalIfFail(
+        "mds.cache.shardNum", &options_.mdsCacheShardNum);
 
     conf_->GetValueFatalIfFail("mds.listen.addr", &options_.mdsListenAddr);
 
@@ -115,7 +118,7 @@ void MDS::StartCompaginLeader() {
 void MDS::Init() {
     InitSegmentAllocStatistic(options_.retryInterTimes,
                               options_.periodicPersistInterMs);
-    InitNameServerStorage(options_.mdsCacheCount);
+    InitNameServerStorage(options_.mdsCacheCount, options_.mdsCacheShardNum);
     InitTopology(options_.topologyOption);
     InitTopologyStat();
     InitTopologyChunkAllocator(options_.topologyOption);
@@ -378,9 +381,9 @@ void MDS::InitTopologyChunkAllocator(const TopologyOption& option) {
     LOG(INFO) << "init topologyChunkAllocator success.";
 }
 
-void MDS::InitNameServerStorage(int mdsCacheCount) {
+void MDS::InitNameServerStorage(int mdsCacheCount, int mdsCacheShardNum) {
     // init LRUCache
-    auto cache = std::make_shared<LRUCache>(mdsCacheCount);
+    auto cache = std::make_shared<LRUCache>(mdsCacheCount, mdsCacheShardNum);
     LOG(INFO) << "init LRUCache success.";
 
     // init NameServerStorage
@@ -474,7 +477,9 @@ void MDS::InitCleanManager() {
 
     auto cleanCore = std::make_shared<CleanCore>(nameServerStorage_,
                                                  copysetClient,
-                                                 segmentAllocStatistic_);
+                                                 segmentAllocStatistic_,
+                                                 topology_,
+                                                 options_.cleanOption);
 
     cleanManager_ = std::make_shared<CleanManager>(cleanCore,
                                             taskManager, nameServerStorage_);
@@ -495,6 +500,15 @@ void MDS::InitChunkServerClientOption(ChunkServerClientOption *option) {
         &option->updateLeaderRetryIntervalMs);
 }
 
+void MDS::InitCleanOption(CleanOption *option) {
+    conf_->GetValueFatalIfFail("mds.clean.deleteChunkConcurrency",
+        &option->deleteChunkConcurrency);
+    conf_->GetValueFatalIfFail("mds.clean.chunkserverDeleteConcurrency",
+        &option->chunkserverDeleteConcurrency);
+    conf_->GetValueFatalIfFail("mds.clean.deleteChunkBatchSize",
+        &option->deleteChunkBatchSize);
+}
+
 void MDS::InitCoordinator() {
     // init option
     ScheduleOption scheduleOption;
@@ -502,7 +516,8 @@ void MDS::InitCoordinator() {
 
     auto scheduleMetrics = std::make_shared<ScheduleMetrics>(topology_);
     auto topoAdapter = std::make_shared<TopoAdapterImpl>(
-        topology_, topologyServiceManager_, topologyStat_);
+        topology_, topologyServiceManager_, topologyStat_,
+        scheduleOption.topoSnapshotRefreshIntervalMs);
     coordinator_ = std::make_shared<Coordinator>(topoAdapter);
     coordinator_->InitScheduler(scheduleOption, scheduleMetrics);
 }
@@ -543,6 +558,8 @@ void MDS::InitScheduleOption(ScheduleOption *scheduleOption) {
         &scheduleOption->chunkserverFailureTolerance);
     conf_->GetValueFatalIfFail("mds.scheduler.chunkserver.cooling.timeSec",
         &scheduleOption->chunkserverCoolingTimeSec);
+    conf_->GetValueFatalIfFail("mds.scheduler.topoSnapshot.refreshIntervalMs",
+        &scheduleOption->topoSnapshotRefreshIntervalMs);
 }
 
 void MDS::InitHeartbeatManager() {
@@ -93,6 +93,8 @@ struct MDSOptions {
     uint64_t periodicPersistInterMs;
     // cache size of namestorage
     int mdsCacheCount;
+    // shard number of namestorage cache
+    int mdsCacheShardNum;
     int mdsFilelockBucketNum;
 
     FileRecordOptions fileRecordOptions;
@@ -104,6 +106,7 @@ struct MDSOptions {
     CopysetOption copysetOption;
     ChunkServerClientOption chunkServerClientOption;
     SnapshotCloneClientOption snapshotCloneClientOption;
+    CleanOption cleanOption;
 };
 
 class MDS {
@@ -165,6 +168,8 @@ class MDS {
 
     void InitChunkServerClientOption(ChunkServerClientOption *option);
 
+    void InitCleanOption(CleanOption *option);
+
     void InitSnapshotCloneClientOption(SnapshotCloneClientOption *option);
 
     void InitEtcdClient(const EtcdConf& etcdConf,
@@ -176,7 +181,7 @@ class MDS {
     void InitSegmentAllocStatistic(uint64_t retryInterTimes,
                                    uint64_t periodicPersistInterMs);
 
-    void InitNameServerStorage(int mdsCacheCount);
+    void InitNameServerStorage(int mdsCacheCount, int mdsCacheShardNum);
 
     void StartServer();
 
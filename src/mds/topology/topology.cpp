@@ -22,11 +22,13 @@
 #include "src/mds/topology/topology.h"
 
 #include <glog/logging.h>
+#include <algorithm>
 #include <chrono>  //NOLINT
 
 #include "src/common/uuid.h"
 
 using ::curve::common::UUIDGenerator;
+using ::curve::common::LockGuard;
 
 namespace curve {
 namespace mds {
@@ -302,7 +304,10 @@ int TopologyImpl::UpdateZone(const Zone &data) {
         if (!storage_->UpdateZone(data)) {
             return kTopoErrCodeStorgeFail;
         }
+        // the server list is maintained by topology, keep it
+        std::list<ServerIdType> serverList = it->second.GetServerList();
         it->second = data;
+        it->second.SetServerList(serverList);
         return kTopoErrCodeSuccess;
     } else {
         return kTopoErrCodeZoneNotFound;
@@ -316,7 +321,11 @@ int TopologyImpl::UpdateServer(const Server &data) {
         if (!storage_->UpdateServer(data)) {
             return kTopoErrCodeStorgeFail;
         }
+        // the chunkserver list is maintained by topology, keep it
+        std::list<ChunkServerIdType> csList =
+            it->second.GetChunkServerList();
         it->second = data;
+        it->second.SetChunkServerList(csList);
         return kTopoErrCodeSuccess;
     } else {
         return kTopoErrCodeServerNotFound;
@@ -324,11 +333,13 @@ int TopologyImpl::UpdateServer(const Server &data) {
 }
 
 int TopologyImpl::UpdateChunkServerTopo(const ChunkServer &data) {
+    WriteLockGuard wlockServer(serverMutex_);
     ReadLockGuard rlockChunkServerMap(chunkServerMutex_);
     auto it = chunkServerMap_.find(data.GetId());
     if (it != chunkServerMap_.end()) {
         WriteLockGuard wlockChunkServer(it->second.GetRWLockRef());
         ChunkServer temp = it->second;
+        ServerIdType oldServerId = temp.GetServerId();
         temp.SetServerId(data.GetServerId());
         temp.SetHostIp(data.GetHostIp());
         temp.SetPort(data.GetPort());
@@ -338,6 +349,17 @@ int TopologyImpl::UpdateChunkServerTopo(const ChunkServer &data) {
         }
         it->second = temp;
         it->second.SetDirtyFlag(false);
+        // move the chunkserver to the list of the new server
+        if (oldServerId != data.GetServerId()) {
+            auto ix = serverMap_.find(oldServerId);
+            if (ix != serverMap_.end()) {
+                ix->second.RemoveChunkServer(data.GetId());
+            }
+            ix = serverMap_.find(data.GetServerId());
+            if (ix != serverMap_.end()) {
+                ix->second.AddChunkServer(data.GetId());
+            }
+        }
         return kTopoErrCodeSuccess;
     } else {
         return kTopoErrCodeChunkServerNotFound;
@@ -734,12 +756,19 @@ std::list<ChunkServerIdType> TopologyImpl::GetChunkServerInServer(
     ServerIdType id,
     ChunkServerFilter filter) const {
     std::list<ChunkServerIdType> ret;
+    ReadLockGuard rlockServer(serverMutex_);
     ReadLockGuard rlockChunkServerMap(chunkServerMutex_);
-    for (auto it = chunkServerMap_.begin();
-         it != chunkServerMap_.end();
-         it++) {
+    auto ix = serverMap_.find(id);
+    if (ix == serverMap_.end()) {
+        return ret;
+    }
+    for (ChunkServerIdType csId : ix->second.GetChunkServerList()) {
+        auto it = chunkServerMap_.find(csId);
+        if (it == chunkServerMap_.end()) {
+            continue;
+        }
         ReadLockGuard rlockChunkServer(it->second.GetRWLockRef());
-        if (filter(it->second) && it->second.GetServerId() == id) {
+        if (filter(it->second)) {
             ret.push_back(it->first);
         }
     }
@@ -773,9 +802,15 @@ std::list<ChunkServerIdType> TopologyImpl::GetChunkServerInPhysicalPool(
 std::list<ServerIdType> TopologyImpl::GetServerInZone(ZoneIdType id,
     ServerFilter filter) const {
     std::list<ServerIdType> ret;
+    ReadLockGuard rlockZone(zoneMutex_);
     ReadLockGuard rlockServer(serverMutex_);
-    for (auto it = serverMap_.begin(); it != serverMap_.end(); it++) {
-        if (filter(it->second) && it->second.GetZoneId() == id) {
+    auto ix = zoneMap_.find(id);
+    if (ix == zoneMap_.end()) {
+        return ret;
+    }
+    for (ServerIdType serverId : ix->second.GetServerList()) {
+        auto it = serverMap_.find(serverId);
+        if (it != serverMap_.end() && filter(it->second)) {
             ret.push_back(it->first);
         }
     }
@@ -977,6 +1012,12 @@ int TopologyImpl::Init(const TopologyOption &option) {
     }
     LOG(INFO) << "Clean Invalid LogicalPool and copyset success.";
 
+    chunkServerCopySetIndex_.clear();
+    for (const auto &it : copySetMap_) {
+        UpdateCopySetIndex(it.first, std::set<ChunkServerIdType>(),
+                           it.second.GetCopySetMembers());
+    }
+
     return kTopoErrCodeSuccess;
 }
 
@@ -1027,6 +1068,8 @@ int TopologyImpl::AddCopySet(const CopySetInfo &data) {
                 return kTopoErrCodeStorgeFail;
             }
             copySetMap_[key] = data;
+            UpdateCopySetIndex(key, std::set<ChunkServerIdType>(),
+                               data.GetCopySetMembers());
             return kTopoErrCodeSuccess;
         } else {
             return kTopoErrCodeIdDuplicated;
@@ -1043,7 +1086,9 @@ int TopologyImpl::RemoveCopySet(CopySetKey key) {
         if (!storage_->DeleteCopySet(key)) {
             return kTopoErrCodeStorgeFail;
         }
-        copySetMap_.erase(key);
+        UpdateCopySetIndex(key, it->second.GetCopySetMembers(),
+                           std::set<ChunkServerIdType>());
+        copySetMap_.erase(it);
         return kTopoErrCodeSuccess;
     } else {
         return kTopoErrCodeCopySetNotFound;
@@ -1058,7 +1103,13 @@ int TopologyImpl::UpdateCopySetTopo(const CopySetInfo &data) {
         WriteLockGuard wlockCopySet(it->second.GetRWLockRef());
         it->second.SetLeader(data.GetLeader());
         it->second.SetEpoch(data.GetEpoch());
-        it->second.SetCopySetMembers(data.GetCopySetMembers());
+        std::set<ChunkServerIdType> oldMembers =
+            it->second.GetCopySetMembers();
+        std::set<ChunkServerIdType> newMembers = data.GetCopySetMembers();
+        if (oldMembers != newMembers) {
+            UpdateCopySetIndex(key, oldMembers, newMembers);
+            it->second.SetCopySetMembers(newMembers);
+        }
         if (data.HasCandidate()) {
             it->second.SetCandidate(data.GetCandidate());
         } else {
@@ -1091,9 +1142,13 @@ std::vector<CopySetIdType> TopologyImpl::GetCopySetsInLogicalPool(
     CopySetFilter filter) const {
     std::vector<CopySetIdType> ret;
     ReadLockGuard rlockCopySet(copySetMutex_);
-    for (auto it : copySetMap_) {
-        if (filter(it.second) && it.first.first == logicalPoolId) {
-            ret.push_back(it.first.second);
+    // copysets of the logical pool are adjacent in copySetMap_
+    auto it = copySetMap_.lower_bound(CopySetKey(logicalPoolId, 0));
+    for (; it != copySetMap_.end() && it->first.first == logicalPoolId;
+         ++it) {
+        ReadLockGuard rlockCopySetInfo(it->second.GetRWLockRef());
+        if (filter(it->second)) {
+            ret.push_back(it->first.second);
         }
     }
     return ret;
@@ -1104,9 +1159,12 @@ std::vector<CopySetInfo> TopologyImpl::GetCopySetInfosInLogicalPool(
     CopySetFilter filter) const {
     std::vector<CopySetInfo> ret;
     ReadLockGuard rlockCopySet(copySetMutex_);
-    for (auto it : copySetMap_) {
-        if (filter(it.second) && it.first.first == logicalPoolId) {
-            ret.push_back(it.second);
+    auto it = copySetMap_.lower_bound(CopySetKey(logicalPoolId, 0));
+    for (; it != copySetMap_.end() && it->first.first == logicalPoolId;
+         ++it) {
+        ReadLockGuard rlockCopySetInfo(it->second.GetRWLockRef());
+        if (filter(it->second)) {
+            ret.push_back(it->second);
         }
     }
     return ret;
@@ -1116,7 +1174,8 @@ std::vector<CopySetKey> TopologyImpl::GetCopySetsInCluster(
     CopySetFilter filter) const {
     std::vector<CopySetKey> ret;
     ReadLockGuard rlockCopySet(copySetMutex_);
-    for (auto it : copySetMap_) {
+    for (const auto &it : copySetMap_) {
+        ReadLockGuard rlockCopySetInfo(it.second.GetRWLockRef());
         if (filter(it.second)) {
             ret.push_back(it.first);
         }
@@ -1129,14 +1188,52 @@ std::vector<CopySetKey> TopologyImpl::GetCopySetsInChunkServer(
     CopySetFilter filter) const {
     std::vector<CopySetKey> ret;
     ReadLockGuard rlockCopySet(copySetMutex_);
-    for (auto it : copySetMap_) {
-        if (filter(it.second) && it.second.GetCopySetMembers().count(id) > 0) {
-            ret.push_back(it.first);
+    {
+        LockGuard lockIndex(copySetIndexMutex_);
+        auto ix = chunkServerCopySetIndex_.find(id);
+        if (ix == chunkServerCopySetIndex_.end()) {
+            return ret;
         }
-    }
+        ret.assign(ix->second.begin(), ix->second.end());
+    }
+    // the copysets can not be removed while holding copySetMutex_,
+    // filter them without holding the index lock
+    auto end = std::remove_if(ret.begin(), ret.end(),
+        [this, &filter](const CopySetKey &key) {
+            auto it = copySetMap_.find(key);
+            if (it == copySetMap_.end()) {
+                return true;
+            }
+            ReadLockGuard rlockCopySetInfo(it->second.GetRWLockRef());
+            return !filter(it->second);
+        });
+    ret.erase(end, ret.end());
     return ret;
 }
 
+void TopologyImpl::UpdateCopySetIndex(const CopySetKey &key,
+    const std::set<ChunkServerIdType> &oldMembers,
+    const std::set<ChunkServerIdType> &newMembers) {
+    LockGuard lockIndex(copySetIndexMutex_);
+    for (ChunkServerIdType csId : oldMembers) {
+        if (newMembers.count(csId) > 0) {
+            continue;
+        }
+        auto ix = chunkServerCopySetIndex_.find(csId);
+        if (ix != chunkServerCopySetIndex_.end()) {
+            ix->second.erase(key);
+            if (ix->second.empty()) {
+                chunkServerCopySetIndex_.erase(ix);
+            }
+        }
+    }
+    for (ChunkServerIdType csId : newMembers) {
+        if (oldMembers.count(csId) == 0) {
+            chunkServerCopySetIndex_[csId].insert(key);
+        }
+    }
+}
+
 int TopologyImpl::Run() {
     if (isStop_.exchange(false)) {
         backEndThread_ = curve::common::Thread(
@@ -28,6 +28,7 @@
 #include <memory>
 #include <vector>
 #include <map>
+#include <set>
 
 #include "proto/topology.pb.h"
 #include "src/mds/common/mds_define.h"
@@ -555,6 +556,18 @@ class TopologyImpl : public Topology {
 
     void SetChunkServerExternalIp();
 
+    /**
+     * @brief update the chunkserver index of the copyset when its members
+     *        change, the caller should hold copySetMutex_
+     *
+     * @param key copyset
+     * @param oldMembers members before the change, empty when added
+     * @param newMembers members after the change, empty when removed
+     */
+    void UpdateCopySetIndex(const CopySetKey &key,
+                            const std::set<ChunkServerIdType> &oldMembers,
+                            const std::set<ChunkServerIdType> &newMembers);
+
  private:
     std::unordered_map<PoolIdType, LogicalPool> logicalPoolMap_;
     std::unordered_map<PoolIdType, PhysicalPool> physicalPoolMap_;
@@ -564,6 +577,16 @@ class TopologyImpl : public Topology {
 
     std::map<CopySetKey, CopySetInfo> copySetMap_;
 
+    // secondary index of copySetMap_, chunkserver -> copysets it belongs
+    // to, so that the copysets of a chunkserver can be found without
+    // scanning all the copysets. The copysets of a logical pool are found
+    // by the key range of copySetMap_, and the chunkservers of a server by
+    // the chunkserver list of the server.
+    // Copyset members are updated under the read lock of copySetMutex_,
+    // so the index is protected by copySetIndexMutex_ additionally.
+    std::unordered_map<ChunkServerIdType, std::set<CopySetKey>>
+        chunkServerCopySetIndex_;
+
     // cluster info
     ClusterInformation clusterInfo;
 
@@ -578,6 +601,7 @@ class TopologyImpl : public Topology {
     mutable curve::common::RWLock serverMutex_;
     mutable curve::common::RWLock chunkServerMutex_;
     mutable curve::common::RWLock copySetMutex_;
+    mutable curve::common::Mutex copySetIndexMutex_;
 
     TopologyOption option_;
     curve::common::Thread backEndThread_;
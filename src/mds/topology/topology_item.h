@@ -321,6 +321,9 @@ class Zone {
     std::list<ServerIdType> GetServerList() const {
         return serverList_;
     }
+    void SetServerList(const std::list<ServerIdType> &serverList) {
+        serverList_ = serverList;
+    }
 
     bool SerializeToString(std::string *value) const;
 
@@ -408,6 +411,9 @@ class Server {
     std::list<ChunkServerIdType> GetChunkServerList() const {
         return chunkserverList_;
     }
+    void SetChunkServerList(const std::list<ChunkServerIdType> &csList) {
+        chunkserverList_ = csList;
+    }
 
     bool SerializeToString(std::string *value) const;
 
@@ -67,6 +67,10 @@ struct SnapshotCloneServerOptions {
     uint32_t mdsSessionTimeUs;
     // ReadChunkSnapshot同时进行的异步请求数量
     uint32_t readChunkSnapshotConcurrency;
+    // 转储chunk的压缩类型，none或者snappy
+    std::string snapshotCompressType;
+    // 转储chunk压缩的frame大小
+    uint32_t snapshotCompressFrameSize;
 
     // 用于Lazy克隆元数据部分的线程池线程数
     int stage1PoolThreadNum;
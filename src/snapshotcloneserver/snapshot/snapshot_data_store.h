@@ -31,6 +31,7 @@
 #include <list>
 #include <string>
 #include <memory>
+#include <utility>
 
 #include "src/common/concurrent/concurrent.h"
 
@@ -164,6 +165,12 @@ class ChunkData{
     std::string data_;
 };
 
+// 压缩转储的一个分片，frameLens为分片中每个frame压缩后的长度
+struct CompressedPart {
+    std::vector<uint32_t> frameLens;
+    std::string data;
+};
+
 class TransferTask {
  public:
      TransferTask() {}
@@ -179,10 +186,38 @@ class TransferTask {
          return partInfo_;
      }
 
+     void AddCompressedPart(int partNum, std::vector<uint32_t> frameLens,
+                            std::string data) {
+         m_.Lock();
+         compressedParts_.emplace(partNum,
+             CompressedPart{std::move(frameLens), std::move(data)});
+         m_.UnLock();
+     }
+
+     /**
+      * 按分片序号取出所有压缩后的分片，取出后task中不再保留
+      */
+     std::map<int, CompressedPart> TakeCompressedParts() {
+         m_.Lock();
+         std::map<int, CompressedPart> parts;
+         parts.swap(compressedParts_);
+         m_.UnLock();
+         return parts;
+     }
+
+     size_t GetCompressedPartNum() {
+         m_.Lock();
+         size_t num = compressedParts_.size();
+         m_.UnLock();
+         return num;
+     }
+
  private:
      mutable SpinLock m_;
      // partnumber <=> etag
      std::map<int, std::string> partInfo_;
+     // 压缩转储时分片的序号 <=> 分片压缩后的数据
+     std::map<int, CompressedPart> compressedParts_;
 };
 
 class SnapshotDataStore {
@@ -22,6 +22,7 @@
 
 #include "src/snapshotcloneserver/snapshot/snapshot_data_store_s3.h"
 #include <utility>
+#include <vector>
 #include <memory>
 #include <glog/logging.h>    //NOLINT
 #include <aws/core/utils/memory/stl/AWSString.h>  //NOLINT
@@ -144,6 +145,11 @@ int S3SnapshotDataStore::GetSnapshotFlag(const ChunkIndexDataName &name) {
 */
 int S3SnapshotDataStore::DataChunkTranferInit(const ChunkDataName &name,
                                     std::shared_ptr<TransferTask> task) {
+    if (compressType_ != CompressType::None) {
+        // 压缩后的分片大小不确定，可能小于s3 multipart的最小分片限制，
+        // 因此压缩时不使用multipart，Complete时整体PutObject
+        return 0;
+    }
     std::string key = name.ToDataChunkKey();
     const Aws::String aws_key(key.c_str(), key.size());
     Aws::String aws_uploadId = s3Adapter4Data_->MultiUploadInit(aws_key);
@@ -163,10 +169,41 @@ int S3SnapshotDataStore::DataChunkTranferAddPart(const ChunkDataName &name,
                                         const char *buf) {
     std::string key = name.ToDataChunkKey();
     const Aws::String aws_key(key.c_str(), key.size());
-    const Aws::String uploadId(task->uploadId_.c_str(), task->uploadId_.size());
+    if (compressType_ == CompressType::None) {
+        const Aws::String uploadId(task->uploadId_.c_str(),
+                                   task->uploadId_.size());
+        return UploadPart(aws_key, uploadId, task, partNum + 1, partSize, buf);
+    }
+
+    if (compressFrameSize_ == 0 || partSize % compressFrameSize_ != 0) {
+        LOG(ERROR) << "partSize " << partSize
+                   << " is not align to compress frame size "
+                   << compressFrameSize_;
+        return -1;
+    }
+    std::string compressed;
+    std::string frame;
+    std::vector<uint32_t> frameLens;
+    for (int off = 0; off < partSize; off += compressFrameSize_) {
+        curve::common::CompressFrame(compressType_, buf + off,
+                                     compressFrameSize_, &frame);
+        frameLens.push_back(frame.size());
+        compressed.append(frame);
+    }
+    task->AddCompressedPart(partNum, std::move(frameLens),
+                            std::move(compressed));
+    return 0;
+}
+
+int S3SnapshotDataStore::UploadPart(const Aws::String &key,
+                                    const Aws::String &uploadId,
+                                    std::shared_ptr<TransferTask> task,
+                                    int partNum,
+                                    int partSize,
+                                    const char *buf) {
     Aws::S3::Model::CompletedPart cp =
         s3Adapter4Data_->UploadOnePart(
-            aws_key, uploadId, partNum + 1, partSize, buf);
+            key, uploadId, partNum, partSize, buf);
     std::string etag(cp.GetETag().c_str(), cp.GetETag().size());
     int tmp_partnum = cp.GetPartNumber();
     if (etag == "errorTag" && tmp_partnum == -1) {
@@ -181,6 +218,9 @@ int S3SnapshotDataStore::DataChunkTranferComplete(const ChunkDataName &name,
                                         std::shared_ptr<TransferTask> task) {
     std::string key = name.ToDataChunkKey();
     const Aws::String aws_key(key.c_str(), key.size());
+    if (compressType_ != CompressType::None) {
+        return PutCompressedObject(aws_key, task);
+    }
     const Aws::String uploadId(task->uploadId_.c_str(), task->uploadId_.size());
     Aws::Vector<Aws::S3::Model::CompletedPart> cp_v;
     for (auto &v : task->GetPartInfo()) {
@@ -192,8 +232,41 @@ int S3SnapshotDataStore::DataChunkTranferComplete(const ChunkDataName &name,
     return s3Adapter4Data_->CompleteMultiUpload(aws_key, uploadId, cp_v);
 }
 
+int S3SnapshotDataStore::PutCompressedObject(const Aws::String &key,
+                                    std::shared_ptr<TransferTask> task) {
+    // 按分片顺序拼接所有frame的长度生成header，header在对象的头部
+    std::map<int, CompressedPart> parts = task->TakeCompressedParts();
+    std::vector<uint32_t> frameLens;
+    size_t dataSize = 0;
+    int expectPartNum = 0;
+    for (auto &v : parts) {
+        if (v.first != expectPartNum++) {
+            LOG(ERROR) << "compressed part " << expectPartNum - 1
+                       << " missing, key = " << key;
+            return -1;
+        }
+        frameLens.insert(frameLens.end(),
+                         v.second.frameLens.begin(), v.second.frameLens.end());
+        dataSize += v.second.data.size();
+    }
+    curve::common::CompressedObjectHeader header(
+        compressType_, compressFrameSize_, frameLens);
+    std::string object;
+    header.Encode(&object);
+    object.reserve(object.size() + dataSize);
+    for (auto &v : parts) {
+        object.append(v.second.data);
+    }
+    return s3Adapter4Data_->PutObject(key, object);
+}
+
 int S3SnapshotDataStore::DataChunkTranferAbort(const ChunkDataName &name,
                                     std::shared_ptr<TransferTask> task) {
+    if (compressType_ != CompressType::None) {
+        // 压缩时数据只缓存在task中，没有需要终止的multipart上传
+        task->TakeCompressedParts();
+        return 0;
+    }
     std::string key = name.ToDataChunkKey();
     const Aws::String aws_key(key.c_str(), key.size());
     const Aws::String uploadId(task->uploadId_.c_str(), task->uploadId_.size());
@@ -30,14 +30,18 @@
 #include <memory>
 #include "src/snapshotcloneserver/snapshot/snapshot_data_store.h"
 #include "src/common/s3_adapter.h"
+#include "src/common/compressed_object.h"
 
 using ::curve::common::S3Adapter;
+using ::curve::common::CompressType;
 namespace curve {
 namespace snapshotcloneserver {
 
 class S3SnapshotDataStore : public SnapshotDataStore {
  public:
-     S3SnapshotDataStore() {
+     S3SnapshotDataStore()
+        : compressType_(CompressType::None),
+          compressFrameSize_(0) {
         s3Adapter4Meta_ = std::make_shared<S3Adapter>();
         s3Adapter4Data_ = std::make_shared<S3Adapter>();
     }
@@ -84,9 +88,47 @@ class S3SnapshotDataStore : public SnapshotDataStore {
          return s3Adapter4Data_;
      }
 
+     /**
+      * 设置转储chunk的压缩方式，CompressType::None时不压缩
+      * 压缩时每个分片按frameSize切分成frame分别压缩并缓存在task中，
+      * Complete时将记录了所有frame长度的header放在头部，与所有frame
+      * 拼接后通过一次PutObject上传。压缩后的分片可能小于s3 multipart
+      * 要求的最小分片大小，所以压缩时不使用multipart上传
+      * @param type 压缩类型
+      * @param frameSize frame大小，需要整除分片大小
+      */
+     void SetCompressOption(CompressType type, uint32_t frameSize) {
+         compressType_ = type;
+         compressFrameSize_ = frameSize;
+     }
+
+ private:
+    /**
+     * 上传一个part，成功后记录到task中
+     * @param partNum s3的part编号，从1开始
+     * @return 0 成功/ -1 失败
+     */
+    int UploadPart(const Aws::String &key,
+                   const Aws::String &uploadId,
+                   std::shared_ptr<TransferTask> task,
+                   int partNum,
+                   int partSize,
+                   const char *buf);
+
+    /**
+     * 将task中缓存的压缩分片和header拼接成一个对象上传
+     * @return 0 成功/ -1 失败
+     */
+    int PutCompressedObject(const Aws::String &key,
+                            std::shared_ptr<TransferTask> task);
+
  private:
     std::shared_ptr<curve::common::S3Adapter> s3Adapter4Data_;
     std::shared_ptr<curve::common::S3Adapter> s3Adapter4Meta_;
+    // 转储chunk的压缩类型
+    CompressType compressType_;
+    // 转储chunk压缩的frame大小
+    uint32_t compressFrameSize_;
 };
 
 }   // namespace snapshotcloneserver
@@ -30,6 +30,8 @@
 #include "src/common/curve_version.h"
 
 using LeaderElectionOptions = ::curve::election::LeaderElectionOptions;
+using ::curve::common::CompressType;
+using ::curve::common::StringToCompressType;
 
 namespace curve {
 namespace snapshotcloneserver {
@@ -81,6 +83,10 @@ void InitSnapshotCloneServerOptions(std::shared_ptr<Configuration> conf,
                                         &serverOption->mdsSessionTimeUs);
     conf->GetValueFatalIfFail("server.readChunkSnapshotConcurrency",
             &serverOption->readChunkSnapshotConcurrency);
+    conf->GetValueFatalIfFail("server.snapshotCompressType",
+                                        &serverOption->snapshotCompressType);
+    conf->GetValueFatalIfFail("server.snapshotCompressFrameSize",
+            &serverOption->snapshotCompressFrameSize);
 
     conf->GetValueFatalIfFail("server.stage1PoolThreadNum",
                                      &serverOption->stage1PoolThreadNum);
@@ -242,7 +248,29 @@ bool SnapShotCloneServer::Init() {
         return false;
     }
 
-    dataStore_ = std::make_shared<S3SnapshotDataStore>();
+    const SnapshotCloneServerOptions &serverOption =
+        snapshotCloneServerOptions_.serverOption;
+    CompressType compressType;
+    if (!StringToCompressType(serverOption.snapshotCompressType,
+                              &compressType)) {
+        LOG(ERROR) << "unsupported snapshot compress type: "
+                   << serverOption.snapshotCompressType;
+        return false;
+    }
+    if (compressType != CompressType::None &&
+        (serverOption.snapshotCompressFrameSize == 0 ||
+         serverOption.chunkSplitSize %
+             serverOption.snapshotCompressFrameSize != 0)) {
+        LOG(ERROR) << "snapshotCompressFrameSize "
+                   << serverOption.snapshotCompressFrameSize
+                   << " must divide chunkSplitSize "
+                   << serverOption.chunkSplitSize;
+        return false;
+    }
+    auto s3DataStore = std::make_shared<S3SnapshotDataStore>();
+    s3DataStore->SetCompressOption(compressType,
+                                   serverOption.snapshotCompressFrameSize);
+    dataStore_ = s3DataStore;
     if (dataStore_->Init(snapshotCloneServerOptions_.s3ConfPath) < 0) {
         LOG(ERROR) << "dataStore init fail.";
         return false;
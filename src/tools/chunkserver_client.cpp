@@ -165,5 +165,48 @@ int ChunkServerClient::GetChunkHash(const Chunk& chunk,
     return -1;
 }
 
+int ChunkServerClient::GetChunkRegionHash(const Chunk& chunk,
+                                          uint32_t* regionSize,
+                                          std::vector<uint32_t>* regionHashes) {
+    brpc::Controller cntl;
+    curve::chunkserver::ChunkService_Stub stub(&channel_);
+    uint64_t retryTimes = 0;
+    while (retryTimes < FLAGS_rpcRetryTimes) {
+        cntl.Reset();
+        cntl.set_timeout_ms(FLAGS_rpcTimeout);
+        GetChunkHashRequest request;
+        request.set_logicpoolid(chunk.logicPoolId);
+        request.set_copysetid(chunk.copysetId);
+        request.set_chunkid(chunk.chunkId);
+        // 未开启region hash的chunkserver会计算指定区域的hash，
+        // 长度为0时不需要读取数据
+        request.set_offset(0);
+        request.set_length(0);
+        request.set_regionhash(true);
+        GetChunkHashResponse response;
+        stub.GetChunkHash(&cntl, &request, &response, nullptr);
+        if (cntl.Failed()) {
+            retryTimes++;
+            continue;
+        }
+        if (response.status() != CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS) {
+            std::cout << "GetChunkRegionHash fail, request: "
+                      << request.DebugString()
+                      << ", errCode: "
+                      << response.status() << std::endl;
+            return -1;
+        } else {
+            *regionSize = response.regionsize();
+            regionHashes->assign(response.regionhashes().begin(),
+                                 response.regionhashes().end());
+            return 0;
+        }
+    }
+    // 只打最后一次失败的原因
+    std::cout << "Send RPC to chunkserver fail, error content: "
+              << cntl.ErrorText() << std::endl;
+    return -1;
+}
+
 }  // namespace tool
 }  // namespace curve
@@ -29,6 +29,7 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
 
 #include "proto/chunk.pb.h"
 #include "proto/copyset.pb.h"
@@ -94,6 +95,19 @@ class ChunkServerClient {
     */
     virtual int GetChunkHash(const Chunk& chunk, std::string* chunkHash);
 
+    /**
+    *  @brief 从chunkserver获取chunk每个region的hash值，chunkserver只需
+    *         重新读取上次获取之后写过的region
+    *  @param chunk 要查询的chunk
+    *  @param[out] regionSize region的大小，chunkserver未开启region hash
+    *              或者chunk不存在时为0
+    *  @param[out] regionHashes 每个region的hash值
+    *  @return 成功返回0，失败返回-1
+    */
+    virtual int GetChunkRegionHash(const Chunk& chunk,
+                                   uint32_t* regionSize,
+                                   std::vector<uint32_t>* regionHashes);
+
  private:
     brpc::Channel channel_;
     std::string csAddr_;
@@ -236,6 +236,55 @@ int ConsistencyCheck::CheckCopysetHash(const CopySet& copyset,
 
 int ConsistencyCheck::CheckChunkHash(const Chunk& chunk,
                                      const CsAddrsType& csAddrs) {
+    // 优先比较region hash，chunkserver只需要重新读取上次比较之后写过的region
+    uint32_t preRegionSize = 0;
+    std::vector<uint32_t> preRegionHashes;
+    bool first = true;
+    for (const auto& csAddr : csAddrs) {
+        int res = csClient_->Init(csAddr);
+        if (res != 0) {
+            std::cout << "Init chunkserverClient to " << csAddr
+                      << " fail!" << std::endl;
+            return -1;
+        }
+        uint32_t regionSize = 0;
+        std::vector<uint32_t> regionHashes;
+        res = csClient_->GetChunkRegionHash(chunk, &regionSize,
+                                            &regionHashes);
+        if (res != 0) {
+            std::cout << "GetChunkRegionHash from " << csAddr
+                      << " fail" << std::endl;
+            return -1;
+        }
+        // 有副本未开启region hash或者region大小不同时，比较整个chunk的hash
+        if (regionSize == 0 || (!first && regionSize != preRegionSize)) {
+            return CheckChunkFullHash(chunk, csAddrs);
+        }
+        if (first) {
+            preRegionSize = regionSize;
+            preRegionHashes.swap(regionHashes);
+            first = false;
+            continue;
+        }
+        if (regionHashes != preRegionHashes) {
+            std::cout << "Chunk region hash not equal!" << std::endl;
+            for (size_t i = 0; i < regionHashes.size()
+                               && i < preRegionHashes.size(); ++i) {
+                if (regionHashes[i] != preRegionHashes[i]) {
+                    std::cout << "region offset = " << i * regionSize
+                              << ", previous hash = " << preRegionHashes[i]
+                              << ", current hash = " << regionHashes[i]
+                              << std::endl;
+                }
+            }
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int ConsistencyCheck::CheckChunkFullHash(const Chunk& chunk,
+                                         const CsAddrsType& csAddrs) {
     std::string preHash;
     std::string curHash;
     bool first = true;
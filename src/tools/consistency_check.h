@@ -147,6 +147,16 @@ class ConsistencyCheck : public CurveTool {
     int CheckChunkHash(const Chunk& chunk,
                        const CsAddrsType& csAddrs);
 
+    /**
+     *  @brief 比较chunk在三个副本上整个chunk的hash，用于有副本
+     *         未开启region hash的情况
+     *  @param chunk 要检查的chunk
+     *  @param csAddrs copyset对应的chunkserver的地址
+     *  @return 一致返回0，否则返回-1
+     */
+    int CheckChunkFullHash(const Chunk& chunk,
+                           const CsAddrsType& csAddrs);
+
     /**
      *  @brief 检查副本间applyindex的一致性
      *  @param copysetId 要检查的copysetId
@@ -574,6 +574,27 @@ TEST_F(ChunkserverTest, normal_read_write_test) {
                       response.status());
             ASSERT_STREQ("650595490", response.hash().c_str());
         }
+
+        // get hash : 未开启region hash时返回指定区域的hash
+        {
+            brpc::Controller cntl;
+            cntl.set_timeout_ms(rpcTimeoutMs);
+            GetChunkHashRequest request;
+            GetChunkHashResponse response;
+            request.set_logicpoolid(logicPoolId);
+            request.set_copysetid(copysetId);
+            request.set_chunkid(chunkId);
+            request.set_offset(0);
+            request.set_length(kOpRequestAlignSize);
+            request.set_regionhash(true);
+            stub.GetChunkHash(&cntl, &request, &response, nullptr);
+            ASSERT_FALSE(cntl.Failed());
+            ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS,
+                      response.status());
+            ASSERT_STREQ("650595490", response.hash().c_str());
+            ASSERT_FALSE(response.has_regionsize());
+            ASSERT_EQ(0, response.regionhashes_size());
+        }
     }
 
     /* 多 chunk read/write/delete */
@@ -24,6 +24,10 @@
 #include <gmock/gmock.h>
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "include/client/libcurve.h"
 #include "src/chunkserver/clone_copyer.h"
 #include "src/chunkserver/clone_core.h"
@@ -195,11 +199,12 @@ TEST_F(CloneCopyerTest, BasicTest) {
 
 
         /* 用例:读s3上的数据，读取成功
-         * 预期:返回0
+         * 预期:返回0，第一次读取对象时先读取header，判断对象是否压缩
          */
         context.location = "test@s3";
         EXPECT_CALL(*s3Client_, GetObjectAsync(_))
-            .WillOnce(Invoke(
+            .Times(2)
+            .WillRepeatedly(Invoke(
                 [&] (const std::shared_ptr<GetObjectAsyncContext>& context) {
                     context->retCode = 0;
                     context->cb(s3Client_.get(), context);
@@ -240,6 +245,182 @@ TEST_F(CloneCopyerTest, BasicTest) {
     }
 }
 
+TEST_F(CloneCopyerTest, CompressedS3Test) {
+    OriginCopyer copyer;
+    CopyerOptions options;
+    options.curveConf = CURVE_CONF;
+    options.s3Conf = S3_CONF;
+    options.curveUser.owner = ROOT_OWNER;
+    options.curveUser.password = ROOT_PWD;
+    options.curveClient = nullptr;
+    options.s3Client = s3Client_;
+    options.chunkSize = 16 * 1024 * 1024;
+    ASSERT_EQ(0, copyer.Init(options));
+
+    // 构造按4KB的frame压缩的对象，前4个frame可压缩，后4个frame不可压缩
+    const uint32_t frameSize = 4096;
+    std::string data(4 * frameSize, 'a');
+    unsigned int seed = 1;
+    for (uint32_t i = 0; i < 4 * frameSize; ++i) {
+        data.push_back(static_cast<char>(rand_r(&seed)));
+    }
+    std::vector<uint32_t> frameLens;
+    std::string frames;
+    for (size_t off = 0; off < data.size(); off += frameSize) {
+        std::string frame;
+        curve::common::CompressFrame(curve::common::CompressType::Snappy,
+                                     data.data() + off, frameSize, &frame);
+        frameLens.push_back(frame.size());
+        frames += frame;
+    }
+    CompressedObjectHeader header(curve::common::CompressType::Snappy,
+                                  frameSize, frameLens);
+    std::string object;
+    header.Encode(&object);
+    object += frames;
+
+    auto readObject =
+        [&] (const std::shared_ptr<GetObjectAsyncContext>& context) {
+            size_t len = 0;
+            if (static_cast<size_t>(context->offset) < object.size()) {
+                len = std::min(context->len,
+                               object.size() - context->offset);
+                memcpy(context->buf, object.data() + context->offset, len);
+            }
+            context->retCode = 0;
+            context->cb(s3Client_.get(), context);
+        };
+
+    char* buf = new char[2 * frameSize];
+    AsyncDownloadContext context;
+    context.location = "test@s3";
+    context.buf = buf;
+    MockDownloadClosure closure(&context);
+
+    /* 用例:第一次读取压缩对象
+     * 预期:先读取header，再读取覆盖请求范围的frame，解压出原始数据
+     */
+    context.offset = frameSize / 2;
+    context.size = frameSize;
+    EXPECT_CALL(*s3Client_, GetObjectAsync(_))
+        .Times(2)
+        .WillRepeatedly(Invoke(readObject));
+    copyer.DownloadAsync(&closure);
+    ASSERT_TRUE(closure.IsRun());
+    ASSERT_FALSE(closure.IsFailed());
+    ASSERT_EQ(0, memcmp(buf, data.data() + context.offset, context.size));
+    closure.Reset();
+
+    /* 用例:再次读取，跨越压缩和未压缩的frame
+     * 预期:header已缓存，只读取一次frame
+     */
+    context.offset = 3 * frameSize + 100;
+    context.size = 2 * frameSize;
+    EXPECT_CALL(*s3Client_, GetObjectAsync(_))
+        .WillOnce(Invoke(readObject));
+    copyer.DownloadAsync(&closure);
+    ASSERT_TRUE(closure.IsRun());
+    ASSERT_FALSE(closure.IsFailed());
+    ASSERT_EQ(0, memcmp(buf, data.data() + context.offset, context.size));
+    closure.Reset();
+
+    /* 用例:读取范围超出对象的原始数据
+     * 预期:返回失败，不读取s3
+     */
+    context.offset = 7 * frameSize;
+    context.size = 2 * frameSize;
+    EXPECT_CALL(*s3Client_, GetObjectAsync(_))
+        .Times(0);
+    copyer.DownloadAsync(&closure);
+    ASSERT_TRUE(closure.IsRun());
+    ASSERT_TRUE(closure.IsFailed());
+    closure.Reset();
+
+    /* 用例:读取到的frame数据损坏
+     * 预期:解压失败，返回失败
+     */
+    context.offset = 0;
+    context.size = frameSize;
+    EXPECT_CALL(*s3Client_, GetObjectAsync(_))
+        .WillOnce(Invoke(
+            [&] (const std::shared_ptr<GetObjectAsyncContext>& context) {
+                memset(context->buf, 'x', context->len);
+                context->retCode = 0;
+                context->cb(s3Client_.get(), context);
+            }));
+    copyer.DownloadAsync(&closure);
+    ASSERT_TRUE(closure.IsRun());
+    ASSERT_TRUE(closure.IsFailed());
+    closure.Reset();
+
+    /* 用例:对象开头是magic，但是header的crc不匹配
+     * 预期:只读取header，返回失败，并且不缓存header
+     */
+    std::string broken = object;
+    broken[header.GetHeaderLength() - 1] ^= 0x1;
+    auto readBroken =
+        [&] (const std::shared_ptr<GetObjectAsyncContext>& context) {
+            size_t len = 0;
+            if (static_cast<size_t>(context->offset) < broken.size()) {
+                len = std::min(context->len,
+                               broken.size() - context->offset);
+                memcpy(context->buf, broken.data() + context->offset, len);
+            }
+            context->retCode = 0;
+            context->cb(s3Client_.get(), context);
+        };
+    context.location = "crc@s3";
+    context.offset = 100;
+    context.size = frameSize;
+    EXPECT_CALL(*s3Client_, GetObjectAsync(_))
+        .Times(2)
+        .WillRepeatedly(Invoke(readBroken));
+    copyer.DownloadAsync(&closure);
+    ASSERT_TRUE(closure.IsRun());
+    ASSERT_TRUE(closure.IsFailed());
+    closure.Reset();
+    copyer.DownloadAsync(&closure);
+    ASSERT_TRUE(closure.IsRun());
+    ASSERT_TRUE(closure.IsFailed());
+    closure.Reset();
+
+    /* 用例:header中的frameNum超过chunk的大小
+     * 预期:不重新读取header，返回失败
+     */
+    broken = object;
+    memset(&broken[16], 0xff, 4);
+    context.location = "framenum@s3";
+    EXPECT_CALL(*s3Client_, GetObjectAsync(_))
+        .WillOnce(Invoke(readBroken));
+    copyer.DownloadAsync(&closure);
+    ASSERT_TRUE(closure.IsRun());
+    ASSERT_TRUE(closure.IsFailed());
+    closure.Reset();
+
+    /* 用例:对象开头不是magic
+     * 预期:按未压缩的对象读取，之后不再读取header
+     */
+    broken = std::string(object.size(), 'r');
+    context.location = "raw@s3";
+    EXPECT_CALL(*s3Client_, GetObjectAsync(_))
+        .Times(3)
+        .WillRepeatedly(Invoke(readBroken));
+    copyer.DownloadAsync(&closure);
+    ASSERT_TRUE(closure.IsRun());
+    ASSERT_FALSE(closure.IsFailed());
+    ASSERT_EQ(0, memcmp(buf, broken.data() + context.offset, context.size));
+    closure.Reset();
+    copyer.DownloadAsync(&closure);
+    ASSERT_TRUE(closure.IsRun());
+    ASSERT_FALSE(closure.IsFailed());
+    closure.Reset();
+
+    delete [] buf;
+    EXPECT_CALL(*s3Client_, Deinit())
+        .Times(1);
+    ASSERT_EQ(0, copyer.Fini());
+}
+
 TEST_F(CloneCopyerTest, DisableTest) {
     OriginCopyer copyer;
     CopyerOptions options;
@@ -38,6 +38,12 @@ using curve::chunkserver::CHUNK_OP_TYPE;
 
 const char PEER_STRING[] = "127.0.0.1:8200:0";
 
+ACTION_TEMPLATE(AppendToIOBuf,
+                HAS_1_TEMPLATE_PARAMS(int, k),
+                AND_2_VALUE_PARAMS(data, length)) {
+    ::testing::get<k>(args)->append(data, length);
+}
+
 class FakeConcurrentApplyModule : public ConcurrentApplyModule {
  public:
     bool Init(int concurrentsize, int queuedepth) {
@@ -687,9 +693,8 @@ TEST_F(OpRequestTest, ReadChunkTest) {
         // 读chunk文件
         char chunkData[length];  // NOLINT
         memset(chunkData, 'a', length);
-        EXPECT_CALL(*datastore_, ReadChunk(_, _, _, offset, length))
-            .WillOnce(DoAll(SetArrayArgument<2>(chunkData,
-                                                chunkData + length),
+        EXPECT_CALL(*datastore_, ReadChunkToIOBuf(_, _, _, offset, length))
+            .WillOnce(DoAll(AppendToIOBuf<2>(chunkData, length),
                             Return(CSErrorCode::Success)));
         EXPECT_CALL(*node_, UpdateAppliedIndex(_))
             .Times(1);
@@ -724,9 +729,8 @@ TEST_F(OpRequestTest, ReadChunkTest) {
         // 读chunk文件
         char chunkData[length];  // NOLINT
         memset(chunkData, 'a', length);
-        EXPECT_CALL(*datastore_, ReadChunk(_, _, _, offset, length))
-            .WillOnce(DoAll(SetArrayArgument<2>(chunkData,
-                                                chunkData + length),
+        EXPECT_CALL(*datastore_, ReadChunkToIOBuf(_, _, _, offset, length))
+            .WillOnce(DoAll(AppendToIOBuf<2>(chunkData, length),
                             Return(CSErrorCode::Success)));
         EXPECT_CALL(*node_, UpdateAppliedIndex(_))
             .Times(1);
@@ -759,7 +763,7 @@ TEST_F(OpRequestTest, ReadChunkTest) {
             .WillOnce(DoAll(SetArgPointee<1>(info),
                             Return(CSErrorCode::Success)));
         // 读chunk文件
-        EXPECT_CALL(*datastore_, ReadChunk(_, _, _, _, _))
+        EXPECT_CALL(*datastore_, ReadChunkToIOBuf(_, _, _, _, _))
             .Times(0);
         EXPECT_CALL(*node_, UpdateAppliedIndex(_))
             .Times(0);
@@ -791,7 +795,7 @@ TEST_F(OpRequestTest, ReadChunkTest) {
         EXPECT_CALL(*datastore_, GetChunkInfo(_, _))
             .WillOnce(Return(CSErrorCode::ChunkNotExistError));
         // 不会读chunk文件
-        EXPECT_CALL(*datastore_, ReadChunk(_, _, _, offset, length))
+        EXPECT_CALL(*datastore_, ReadChunkToIOBuf(_, _, _, offset, length))
             .Times(0);
         EXPECT_CALL(*node_, UpdateAppliedIndex(_))
             .Times(0);
@@ -820,7 +824,7 @@ TEST_F(OpRequestTest, ReadChunkTest) {
         EXPECT_CALL(*datastore_, GetChunkInfo(_, _))
             .WillOnce(Return(CSErrorCode::ChunkNotExistError));
         // 读chunk文件
-        EXPECT_CALL(*datastore_, ReadChunk(_, _, _, _, _))
+        EXPECT_CALL(*datastore_, ReadChunkToIOBuf(_, _, _, _, _))
             .Times(0);
         EXPECT_CALL(*node_, UpdateAppliedIndex(_))
             .Times(0);
@@ -860,9 +864,8 @@ TEST_F(OpRequestTest, ReadChunkTest) {
         // 读chunk文件
         char chunkData[length];  // NOLINT
         memset(chunkData, 'a', length);
-        EXPECT_CALL(*datastore_, ReadChunk(_, _, _, offset, length))
-            .WillOnce(DoAll(SetArrayArgument<2>(chunkData,
-                                                chunkData + length),
+        EXPECT_CALL(*datastore_, ReadChunkToIOBuf(_, _, _, offset, length))
+            .WillOnce(DoAll(AppendToIOBuf<2>(chunkData, length),
                             Return(CSErrorCode::Success)));
         EXPECT_CALL(*node_, UpdateAppliedIndex(_))
             .Times(1);
@@ -892,7 +895,7 @@ TEST_F(OpRequestTest, ReadChunkTest) {
         EXPECT_CALL(*datastore_, GetChunkInfo(_, _))
             .WillOnce(Return(CSErrorCode::InternalError));
         // 不会读chunk文件
-        EXPECT_CALL(*datastore_, ReadChunk(_, _, _, offset, length))
+        EXPECT_CALL(*datastore_, ReadChunkToIOBuf(_, _, _, offset, length))
             .Times(0);
         EXPECT_CALL(*node_, UpdateAppliedIndex(_))
             .Times(0);
@@ -920,7 +923,7 @@ TEST_F(OpRequestTest, ReadChunkTest) {
             .WillRepeatedly(DoAll(SetArgPointee<1>(info),
                             Return(CSErrorCode::Success)));
         // 读chunk文件失败
-        EXPECT_CALL(*datastore_, ReadChunk(_, _, _, offset, length))
+        EXPECT_CALL(*datastore_, ReadChunkToIOBuf(_, _, _, offset, length))
             .WillRepeatedly(Return(CSErrorCode::InternalError));
         EXPECT_CALL(*node_, UpdateAppliedIndex(_))
             .Times(0);
@@ -944,7 +947,7 @@ TEST_F(OpRequestTest, ReadChunkTest) {
             .WillOnce(DoAll(SetArgPointee<1>(info),
                             Return(CSErrorCode::Success)));
         // 读chunk文件
-        EXPECT_CALL(*datastore_, ReadChunk(_, _, _, _, _))
+        EXPECT_CALL(*datastore_, ReadChunkToIOBuf(_, _, _, _, _))
             .Times(0);
         EXPECT_CALL(*node_, UpdateAppliedIndex(_))
             .Times(0);
@@ -24,6 +24,8 @@
 
 #include <atomic>
 #include <functional>
+#include <mutex>  // NOLINT
+#include <vector>
 
 #include "proto/chunk.pb.h"
 #include "src/common/timeutility.h"
@@ -31,6 +33,7 @@
 
 using curve::chunkserver::concurrent::ConcurrentApplyModule;
 using curve::chunkserver::concurrent::ConcurrentApplyOption;
+using curve::chunkserver::concurrent::ApplyPool;
 using curve::chunkserver::CHUNK_OP_TYPE;
 
 TEST(ConcurrentApplyModule, InitTest) {
@@ -110,12 +113,22 @@ TEST(ConcurrentApplyModule, FlushTest) {
     auto task = [&testnum]() {
         testnum.fetch_add(1);
     };
+    // the first task does not finish until Flush is called
+    std::atomic<bool> flushing(false);
+    auto blockTask = [&testnum, &flushing]() {
+        while (!flushing.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        testnum.fetch_add(1);
+    };
 
-    for (int i = 0; i < 5000; i++) {
+    concurrentapply.Push(0, CHUNK_OP_TYPE::CHUNK_OP_WRITE, blockTask);
+    for (int i = 1; i < 5000; i++) {
         concurrentapply.Push(i, CHUNK_OP_TYPE::CHUNK_OP_WRITE, task);
     }
 
     ASSERT_LT(testnum, 5000);
+    flushing.store(true);
     concurrentapply.Flush();
     ASSERT_EQ(5000, testnum);
 
@@ -166,3 +179,212 @@ TEST(ConcurrentApplyModule, ConcurrentTest) {
     concurrentapply.Stop();
 }
 
+
+TEST(ConcurrentApplyModule, OrderTest) {
+    // tasks of the same key are executed in push order
+    ConcurrentApplyModule concurrentapply;
+    ConcurrentApplyOption opt{4, 10, 1, 1};
+    ASSERT_TRUE(concurrentapply.Init(opt));
+
+    const int kKeyNum = 8;
+    const int kTaskNum = 10000;
+    std::vector<int> lastSeq(kKeyNum, -1);
+    std::atomic<int> disorder(0);
+    for (int i = 0; i < kTaskNum; i++) {
+        int key = i % kKeyNum;
+        int seq = i / kKeyNum;
+        auto task = [&lastSeq, &disorder, key, seq]() {
+            if (lastSeq[key] + 1 != seq) {
+                disorder.fetch_add(1);
+            }
+            lastSeq[key] = seq;
+        };
+        concurrentapply.Push(key, CHUNK_OP_TYPE::CHUNK_OP_WRITE, task);
+    }
+    concurrentapply.Flush();
+    ASSERT_EQ(0, disorder.load());
+    for (int i = 0; i < kKeyNum; i++) {
+        ASSERT_EQ(kTaskNum / kKeyNum - 1, lastSeq[i]);
+    }
+
+    concurrentapply.Stop();
+}
+
+TEST(ApplyPool, StealTest) {
+    // key 0 and key 2 are hashed to the same queue, the task of key 2
+    // is stolen by the idle thread while key 0 is blocked
+    ApplyPool pool("apply_pool_steal_test", 2, 10);
+    pool.Start();
+
+    std::atomic<bool> release(false);
+    std::atomic<int> done(0);
+    pool.Push(0, [&release, &done]() {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        done.fetch_add(1);
+    });
+    pool.Push(0, [&done]() { done.fetch_add(1); });
+    pool.Push(2, [&done]() { done.fetch_add(1); });
+
+    uint64_t start = curve::common::TimeUtility::GetTimeofDayMs();
+    while (done.load() < 1 &&
+           curve::common::TimeUtility::GetTimeofDayMs() - start < 5000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    // only the task of key 2 is executed, the second task of key 0
+    // is still waiting in the queue
+    ASSERT_EQ(1, done.load());
+    ASSERT_EQ(1, pool.GetQueueDepth(0));
+    ASSERT_EQ(0, pool.GetQueueDepth(1));
+    ASSERT_GE(pool.GetStealCount(), 1);
+
+    release.store(true);
+    pool.Flush();
+    ASSERT_EQ(3, done.load());
+    ASSERT_EQ(0, pool.GetQueueDepth(0));
+    pool.Stop();
+}
+
+TEST(ApplyPool, VolumeFairTest) {
+    // volume 1 has lots of runnable chunks, the task of volume 2 pushed
+    // after them is executed before most of them
+    ApplyPool pool("apply_pool_fair_test", 1, 100);
+    pool.Start();
+
+    std::atomic<bool> started(false);
+    std::atomic<bool> release(false);
+    pool.Push(100, [&started, &release]() {
+        started.store(true);
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }, 1);
+    while (!started.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    std::mutex mtx;
+    std::vector<uint64_t> order;
+    for (uint64_t key = 0; key < 10; ++key) {
+        pool.Push(key, [key, &mtx, &order]() {
+            std::lock_guard<std::mutex> lk(mtx);
+            order.push_back(key);
+        }, 1);
+    }
+    pool.Push(20, [&mtx, &order]() {
+        std::lock_guard<std::mutex> lk(mtx);
+        order.push_back(20);
+    }, 2);
+
+    release.store(true);
+    pool.Flush();
+    ASSERT_EQ(11, order.size());
+    ASSERT_EQ(0, order[0]);
+    ASSERT_EQ(20, order[1]);
+    for (int i = 2; i < 11; ++i) {
+        ASSERT_EQ(i - 1, order[i]);
+    }
+    pool.Stop();
+}
+
+TEST(ApplyPool, FlushKeysTest) {
+    // flushing key 1 and key 3 does not wait for the blocked key 0
+    ApplyPool pool("apply_pool_flush_keys_test", 2, 10);
+    pool.Start();
+
+    std::atomic<bool> release(false);
+    std::atomic<int> done(0);
+    pool.Push(0, [&release, &done]() {
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        done.fetch_add(1);
+    });
+    for (int i = 0; i < 5; ++i) {
+        pool.Push(1, [&done]() { done.fetch_add(1); });
+        pool.Push(3, [&done]() { done.fetch_add(1); });
+    }
+
+    // key 5 has no task, key 3 is flushed only once
+    pool.Flush({1, 3, 3, 5});
+    ASSERT_EQ(10, done.load());
+
+    release.store(true);
+    pool.Flush();
+    ASSERT_EQ(11, done.load());
+    pool.Stop();
+}
+
+TEST(ApplyPool, AsyncTaskTest) {
+    // the async task of key 0 parks its chain without occupying the only
+    // thread, key 1 is executed while the next task of key 0 waits
+    ApplyPool pool("apply_pool_async_test", 1, 10);
+    pool.Start();
+
+    std::mutex mtx;
+    std::function<void()> finish;
+    std::vector<uint64_t> order;
+    pool.PushAsync(0, [&mtx, &finish, &order](std::function<void()> cb) {
+        std::lock_guard<std::mutex> lk(mtx);
+        order.push_back(0);
+        finish = cb;
+    });
+    pool.Push(0, [&mtx, &order]() {
+        std::lock_guard<std::mutex> lk(mtx);
+        order.push_back(10);
+    });
+    pool.Push(1, [&mtx, &order]() {
+        std::lock_guard<std::mutex> lk(mtx);
+        order.push_back(1);
+    });
+    pool.Flush({1});
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        ASSERT_EQ(2, order.size());
+        ASSERT_EQ(0, order[0]);
+        ASSERT_EQ(1, order[1]);
+        ASSERT_TRUE(finish != nullptr);
+    }
+
+    // finish the task in another thread, the chain of key 0 goes on
+    std::thread th([&mtx, &finish]() {
+        std::lock_guard<std::mutex> lk(mtx);
+        finish();
+    });
+    th.join();
+    pool.Flush();
+    ASSERT_EQ(3, order.size());
+    ASSERT_EQ(10, order[2]);
+
+    // the task finished before it returns
+    std::atomic<int> done(0);
+    for (int i = 0; i < 5; ++i) {
+        pool.PushAsync(2, [&done](std::function<void()> cb) {
+            done.fetch_add(1);
+            cb();
+        });
+    }
+    pool.Flush();
+    ASSERT_EQ(5, done.load());
+
+    // Stop waits for the parked chain
+    finish = nullptr;
+    pool.PushAsync(3, [&mtx, &finish](std::function<void()> cb) {
+        std::lock_guard<std::mutex> lk(mtx);
+        finish = cb;
+    });
+    pool.Push(3, [&done]() { done.fetch_add(1); });
+    std::thread stopThread([&pool]() { pool.Stop(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_EQ(5, done.load());
+    while (true) {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (finish != nullptr) {
+            finish();
+            break;
+        }
+    }
+    stopThread.join();
+    ASSERT_EQ(6, done.load());
+}
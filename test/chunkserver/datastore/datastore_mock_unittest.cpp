@@ -22,8 +22,11 @@
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <fcntl.h>
 #include <string>
 #include <memory>
+#include <atomic>
+#include <thread>  // NOLINT
 
 #include "include/chunkserver/chunkserver_common.h"
 #include "src/common/bitmap.h"
@@ -52,6 +55,8 @@ using ::testing::ReturnArg;
 using ::testing::ElementsAre;
 using ::testing::SetArgPointee;
 using ::testing::SetArrayArgument;
+using ::testing::Invoke;
+using ::testing::SaveArg;
 
 using std::shared_ptr;
 using std::make_shared;
@@ -81,10 +86,14 @@ const char chunk2snap1Path[]
 const char temp1[] = "chunk_1_tmp";
 const char temp1Path[]
     = "/home/chunkserver/copyset/data/chunk_1_tmp";
+const char metaIndexPath[] = "/home/chunkserver/copyset/chunk_meta.index";
+const char metaIndexTmpPath[]
+    = "/home/chunkserver/copyset/chunk_meta.index.tmp";
 const char location[] = "/file1/0@curve";
 const int UT_ERRNO = 1234;
 
 bool hasCreatFlag(int flag) {return flag & O_CREAT;}
+bool hasDsyncFlag(int flag) {return (flag & O_DSYNC) == O_DSYNC;}
 
 ACTION_TEMPLATE(SetVoidArrayArgument,
                 HAS_1_TEMPLATE_PARAMS(int, k),
@@ -200,6 +209,7 @@ class CSDataStore_test : public testing::Test {
                 .WillByDefault(Return(0));
             // fake Fstat
             struct stat fileInfo;
+            memset(&fileInfo, 0, sizeof(fileInfo));
             fileInfo.st_size = CHUNK_SIZE + PAGE_SIZE;
             EXPECT_CALL(*lfs_, Fstat(_, _))
                 .WillRepeatedly(DoAll(SetArgPointee<1>(fileInfo),
@@ -379,6 +389,216 @@ TEST_F(CSDataStore_test, InitializeTest5) {
         .Times(1);
 }
 
+/**
+ * InitializeTest
+ * case:指定了加载线程池，chunk文件数量超过一个批次
+ * 预期结果:所有chunk文件并发加载完成，返回true
+ */
+TEST_F(CSDataStore_test, InitializeTest6) {
+    auto loadPool = std::make_shared<TaskThreadPool<>>();
+    ASSERT_EQ(0, loadPool->Start(4));
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = CHUNK_SIZE;
+    options.pageSize = PAGE_SIZE;
+    options.locationLimit = kLocationLimit;
+    options.loadPool = loadPool;
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+
+    // 其他chunk文件都以fd 100打开，并读到相同的metapage
+    EXPECT_CALL(*lfs_, Open(_, _))
+        .WillRepeatedly(Return(100));
+    FakeEnv();
+    const int kChunkNum = 600;
+    vector<string> fileNames;
+    fileNames.push_back(chunk1);
+    fileNames.push_back(chunk1snap1);
+    fileNames.push_back(chunk2);
+    for (int i = 0; i < kChunkNum; ++i) {
+        fileNames.push_back(FileNameOperator::GenerateChunkFileName(10 + i));
+    }
+    EXPECT_CALL(*lfs_, List(baseDir, NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(fileNames),
+                        Return(0)));
+    EXPECT_CALL(*lfs_, Read(100, NotNull(), 0, PAGE_SIZE))
+        .Times(kChunkNum)
+        .WillRepeatedly(DoAll(
+                        SetArrayArgument<1>(chunk2MetaPage,
+                        chunk2MetaPage + PAGE_SIZE),
+                        Return(PAGE_SIZE)));
+    EXPECT_TRUE(dataStore->Initialize());
+    DataStoreStatus status = dataStore->GetStatus();
+    ASSERT_EQ(kChunkNum + 2, status.chunkFileCount);
+    ASSERT_EQ(1, status.snapshotCount);
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(100))
+        .Times(kChunkNum);
+    dataStore = nullptr;
+    loadPool->Stop();
+}
+
+/**
+ * InitializeTest
+ * case1:metapage索引中记录的chunk与目录中的chunk一致
+ * 预期结果1:chunk文件的metapage从索引中加载，不读取chunk文件的metapage，
+ *          并且加载后索引被删除
+ * case2:保存metapage索引
+ * 预期结果2:索引先写入临时文件，再rename为索引文件
+ * case3:metapage索引中记录的chunk与目录中的chunk不一致
+ * 预期结果3:从chunk文件中读取metapage
+ */
+TEST_F(CSDataStore_test, InitializeTest7) {
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = CHUNK_SIZE;
+    options.pageSize = PAGE_SIZE;
+    options.locationLimit = kLocationLimit;
+    options.metaIndexPath = metaIndexPath;
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+    FakeEnv();
+
+    // case1
+    MetaPageMap metaPages;
+    metaPages[1].sn = 2;
+    metaPages[2].sn = 2;
+    std::string index;
+    CSMetaIndex::Encode(metaPages, &index);
+    struct stat indexInfo;
+    indexInfo.st_size = index.size();
+    EXPECT_CALL(*lfs_, FileExists(metaIndexPath))
+        .WillRepeatedly(Return(true));
+    EXPECT_CALL(*lfs_, Open(metaIndexPath, _))
+        .WillOnce(Return(50));
+    EXPECT_CALL(*lfs_, Fstat(50, NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(indexInfo),
+                        Return(0)));
+    EXPECT_CALL(*lfs_, Read(50, NotNull(), 0, index.size()))
+        .WillOnce(DoAll(SetArrayArgument<1>(index.begin(), index.end()),
+                        Return(index.size())));
+    EXPECT_CALL(*lfs_, Close(50))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Delete(metaIndexPath))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), 0, PAGE_SIZE))
+        .Times(0);
+    EXPECT_CALL(*lfs_, Read(3, NotNull(), 0, PAGE_SIZE))
+        .Times(0);
+    EXPECT_TRUE(dataStore->Initialize());
+    CSChunkInfo info;
+    ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(1, &info));
+    ASSERT_EQ(2, info.curSn);
+    ASSERT_EQ(1, info.snapSn);
+
+    // case2
+    EXPECT_CALL(*lfs_, Open(metaIndexTmpPath, _))
+        .WillOnce(Return(51));
+    EXPECT_CALL(*lfs_, Write(51, Matcher<const char*>(NotNull()), 0, _))
+        .WillOnce(ReturnArg<3>());
+    EXPECT_CALL(*lfs_, Fsync(51))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Close(51))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Rename(metaIndexTmpPath, metaIndexPath, _))
+        .WillOnce(Return(0));
+    ASSERT_EQ(CSErrorCode::Success, dataStore->SaveMetaIndex());
+
+    // case3
+    metaPages.erase(2);
+    CSMetaIndex::Encode(metaPages, &index);
+    indexInfo.st_size = index.size();
+    EXPECT_CALL(*lfs_, Open(metaIndexPath, _))
+        .WillOnce(Return(50));
+    EXPECT_CALL(*lfs_, Fstat(50, NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(indexInfo),
+                        Return(0)));
+    EXPECT_CALL(*lfs_, Read(50, NotNull(), 0, index.size()))
+        .WillOnce(DoAll(SetArrayArgument<1>(index.begin(), index.end()),
+                        Return(index.size())));
+    EXPECT_CALL(*lfs_, Close(50))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Delete(metaIndexPath))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), 0, PAGE_SIZE))
+        .WillOnce(DoAll(SetArrayArgument<1>(chunk1MetaPage,
+                        chunk1MetaPage + PAGE_SIZE),
+                        Return(PAGE_SIZE)));
+    EXPECT_CALL(*lfs_, Read(3, NotNull(), 0, PAGE_SIZE))
+        .WillOnce(DoAll(SetArrayArgument<1>(chunk2MetaPage,
+                        chunk2MetaPage + PAGE_SIZE),
+                        Return(PAGE_SIZE)));
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(2);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(2);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(2);
+    EXPECT_TRUE(dataStore->Initialize());
+}
+
+/**
+ * InitializeTest
+ * case:存在metapage index，但chunk1在index保存后被修改过
+ * 预期结果:chunk1的metapage从chunk文件加载，chunk2的metapage从index加载
+ */
+TEST_F(CSDataStore_test, InitializeTest8) {
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = CHUNK_SIZE;
+    options.pageSize = PAGE_SIZE;
+    options.locationLimit = kLocationLimit;
+    options.metaIndexPath = metaIndexPath;
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+    FakeEnv();
+
+    MetaPageMap metaPages;
+    metaPages[1].sn = 3;
+    metaPages[1].ctime = 1;
+    metaPages[2].sn = 3;
+    std::string index;
+    CSMetaIndex::Encode(metaPages, &index);
+    struct stat indexInfo;
+    indexInfo.st_size = index.size();
+    EXPECT_CALL(*lfs_, FileExists(metaIndexPath))
+        .WillRepeatedly(Return(true));
+    EXPECT_CALL(*lfs_, Open(metaIndexPath, _))
+        .WillOnce(Return(50));
+    EXPECT_CALL(*lfs_, Fstat(50, NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(indexInfo),
+                        Return(0)));
+    EXPECT_CALL(*lfs_, Read(50, NotNull(), 0, index.size()))
+        .WillOnce(DoAll(SetArrayArgument<1>(index.begin(), index.end()),
+                        Return(index.size())));
+    EXPECT_CALL(*lfs_, Close(50))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Delete(metaIndexPath))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), 0, PAGE_SIZE))
+        .WillOnce(DoAll(SetArrayArgument<1>(chunk1MetaPage,
+                        chunk1MetaPage + PAGE_SIZE),
+                        Return(PAGE_SIZE)));
+    EXPECT_CALL(*lfs_, Read(3, NotNull(), 0, PAGE_SIZE))
+        .Times(0);
+    EXPECT_TRUE(dataStore->Initialize());
+    CSChunkInfo info;
+    ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(1, &info));
+    ASSERT_EQ(2, info.curSn);
+    ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(2, &info));
+    ASSERT_EQ(3, info.curSn);
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
 /**
  * InitializeErrorTest
  * case:data目录不存在，创建目录时失败
@@ -522,6 +742,9 @@ TEST_F(CSDataStore_test, InitializeErrorTest3) {
 TEST_F(CSDataStore_test, InitializeErrorTest4) {
     // test chunk open failed
     FakeEnv();
+    // chunk文件会先于快照文件加载，每次重新初始化以及析构时都会关闭chunk2
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(6);
     // set open snapshot file failed
     EXPECT_CALL(*lfs_, Open(chunk1snap1Path, _))
         .WillOnce(Return(-UT_ERRNO));
@@ -722,6 +945,101 @@ TEST_F(CSDataStore_test, WriteChunkTest1) {
         .Times(1);
 }
 
+/**
+ * WriteChunkAsyncTest
+ * case:chunk存在，请求sn等于chunk的sn，且不需要cow
+ * 预期结果:异步提交写请求，写完成时调用回调，完成前同一个chunk上的读等待
+ * case:需要cow或者sn非法
+ * 预期结果:同步写入，返回前调用回调
+ */
+TEST_F(CSDataStore_test, WriteChunkAsyncTest) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    off_t offset = 0;
+    size_t length = PAGE_SIZE;
+    char buf[length];  // NOLINT
+    memset(buf, 0, sizeof(buf));
+    butil::IOBuf data;
+    data.append(buf, length);
+
+    // chunk2 sn为2，没有快照，异步写入
+    curve::fs::WriteCallback ioDone;
+    EXPECT_CALL(*lfs_, WriteAsync(3, _, PAGE_SIZE + offset, length, _))
+        .WillOnce(SaveArg<4>(&ioDone));
+    EXPECT_CALL(*lfs_, Write(3, Matcher<butil::IOBuf>(_), _, _))
+        .Times(0);
+    CSErrorCode result = CSErrorCode::InternalError;
+    std::atomic<bool> written(false);
+    dataStore->WriteChunkAsync(2, 2, data, offset, length, "",
+        [&result, &written](CSErrorCode errorCode) {
+            result = errorCode;
+            written.store(true);
+        });
+    ASSERT_FALSE(written.load());
+    ASSERT_TRUE(ioDone != nullptr);
+
+    // 写完成之前读等待
+    EXPECT_CALL(*lfs_, Read(3, NotNull(), PAGE_SIZE + offset, length))
+        .WillOnce(Return(length));
+    std::atomic<bool> read(false);
+    std::thread reader([&]() {
+        char readBuf[PAGE_SIZE];
+        ASSERT_EQ(CSErrorCode::Success,
+                  dataStore->ReadChunk(2, 2, readBuf, offset, length));
+        read.store(true);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_FALSE(read.load());
+    ioDone(length);
+    reader.join();
+    ASSERT_TRUE(written.load());
+    ASSERT_TRUE(read.load());
+    ASSERT_EQ(CSErrorCode::Success, result);
+
+    // io失败，返回InternalError
+    EXPECT_CALL(*lfs_, WriteAsync(3, _, PAGE_SIZE + offset, length, _))
+        .WillOnce(Invoke([](int, butil::IOBuf, uint64_t, int,
+                            curve::fs::WriteCallback done) {
+            done(-EIO);
+        }));
+    dataStore->WriteChunkAsync(2, 2, data, offset, length, "",
+        [&result](CSErrorCode errorCode) {
+            result = errorCode;
+        });
+    ASSERT_EQ(CSErrorCode::InternalError, result);
+
+    // chunk1存在快照，需要cow，同步写入
+    EXPECT_CALL(*lfs_, WriteAsync(_, _, _, _, _))
+        .Times(0);
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), PAGE_SIZE + offset, length))
+        .WillOnce(Return(length));
+    EXPECT_CALL(*lfs_, Write(1, Matcher<butil::IOBuf>(_),
+                             PAGE_SIZE + offset, length))
+        .Times(1);
+    result = CSErrorCode::InternalError;
+    dataStore->WriteChunkAsync(1, 2, data, offset, length, "",
+        [&result](CSErrorCode errorCode) {
+            result = errorCode;
+        });
+    ASSERT_EQ(CSErrorCode::Success, result);
+
+    // sn为0，返回InvalidArgError
+    dataStore->WriteChunkAsync(2, 0, data, offset, length, "",
+        [&result](CSErrorCode errorCode) {
+            result = errorCode;
+        });
+    ASSERT_EQ(CSErrorCode::InvalidArgError, result);
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
 /**
  * WriteChunkTest
  * case:chunk存在,请求sn小于chunk的sn
@@ -2568,6 +2886,71 @@ TEST_F(CSDataStore_test, ReadChunkErrorTest1) {
         .Times(1);
 }
 
+/**
+ * ReadChunkToIOBufTest
+ * case1:chunk不存在
+ * 预期结果1:返回ChunkNotExistError错误码
+ * case2:读取区域未对齐
+ * 预期结果2:返回InvalidArgError错误码
+ * case3:正常读取存在的chunk
+ * 预期结果3:直接读到IOBuf中，读取成功
+ * case4:读chunk文件时出错
+ * 预期结果4:读取失败，返回InternalError
+ * case5:读到文件末尾，返回的长度小于请求长度
+ * 预期结果5:读取成功，不足的部分补0
+ */
+TEST_F(CSDataStore_test, ReadChunkToIOBufTest1) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    SequenceNum sn = 2;
+    off_t offset = PAGE_SIZE;
+    size_t length = PAGE_SIZE;
+    butil::IOBuf buf;
+    // case1
+    EXPECT_EQ(CSErrorCode::ChunkNotExistError,
+              dataStore->ReadChunkToIOBuf(3, sn, &buf, offset, length));
+
+    // case2
+    EXPECT_CALL(*lfs_, ReadToIOBuf(_, _, _, _))
+        .Times(0);
+    EXPECT_EQ(CSErrorCode::InvalidArgError,
+              dataStore->ReadChunkToIOBuf(1, sn, &buf, offset + 1, length));
+
+    // case3
+    EXPECT_CALL(*lfs_, ReadToIOBuf(1, &buf, offset + PAGE_SIZE, length))
+        .WillOnce(Return(length));
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->ReadChunkToIOBuf(1, sn, &buf, offset, length));
+
+    // case4
+    EXPECT_CALL(*lfs_, ReadToIOBuf(1, &buf, offset + PAGE_SIZE, length))
+        .WillOnce(Return(-UT_ERRNO));
+    EXPECT_EQ(CSErrorCode::InternalError,
+              dataStore->ReadChunkToIOBuf(1, sn, &buf, offset, length));
+
+    // case5
+    butil::IOBuf shortBuf;
+    EXPECT_CALL(*lfs_, ReadToIOBuf(1, &shortBuf, offset + PAGE_SIZE, length))
+        .WillOnce(Invoke([](int, butil::IOBuf* buf, uint64_t, int length) {
+            buf->append(std::string(length / 2, 'a'));
+            return length / 2;
+        }));
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->ReadChunkToIOBuf(1, sn, &shortBuf, offset, length));
+    ASSERT_EQ(length, shortBuf.size());
+    ASSERT_EQ(std::string(length / 2, 'a') + std::string(length / 2, '\0'),
+              shortBuf.to_string());
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
 /**
  * ReadSnapshotChunkTest
  * case:chunk不存在
@@ -3031,6 +3414,316 @@ TEST_F(CSDataStore_test, DeleteChunkErrorTest1) {
         .Times(1);
 }
 
+/**
+ * DeleteChunksTest
+ * case:chunk2存在，chunk3不存在
+ * 预期结果:返回成功，chunk2通过RecycleFiles回收
+ */
+TEST_F(CSDataStore_test, DeleteChunksTest1) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    std::vector<ChunkID> ids = {2, 3};
+    SequenceNum sn = 2;
+
+    // chunk will be closed
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+    // expect to recycle the chunk files together
+    EXPECT_CALL(*fpool_, RecycleFile(_))
+        .Times(0);
+    EXPECT_CALL(*fpool_, RecycleFiles(ElementsAre(string(chunk2Path))))
+        .WillOnce(Return(0));
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->DeleteChunks(ids, sn));
+    CSChunkInfo info;
+    ASSERT_EQ(CSErrorCode::ChunkNotExistError,
+              dataStore->GetChunkInfo(2, &info));
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+}
+
+/**
+ * DeleteChunksTest
+ * case:sn<chunkinfo.sn
+ * 预期结果:返回BackwardRequestError，chunk不被删除
+ */
+TEST_F(CSDataStore_test, DeleteChunksTest2) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    std::vector<ChunkID> ids = {2};
+
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(0);
+    EXPECT_CALL(*fpool_, RecycleFiles(_))
+        .Times(0);
+    EXPECT_EQ(CSErrorCode::BackwardRequestError,
+              dataStore->DeleteChunks(ids, 1));
+    CSChunkInfo info;
+    ASSERT_EQ(CSErrorCode::Success,
+              dataStore->GetChunkInfo(2, &info));
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
+/**
+ * DeleteChunksErrorTest
+ * case:recycle chunk时出错
+ * 预期结果:返回InternalError
+ */
+TEST_F(CSDataStore_test, DeleteChunksErrorTest1) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    std::vector<ChunkID> ids = {2};
+    SequenceNum sn = 2;
+
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+    EXPECT_CALL(*fpool_, RecycleFiles(ElementsAre(string(chunk2Path))))
+        .WillOnce(Return(-1));
+    EXPECT_EQ(CSErrorCode::InternalError,
+              dataStore->DeleteChunks(ids, sn));
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+}
+
+/**
+ * DiscardChunkTest
+ * case:chunk不存在
+ * 预期结果:返回成功
+ */
+TEST_F(CSDataStore_test, DiscardChunkTest1) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    ChunkID id = 3;
+    SequenceNum sn = 2;
+
+    EXPECT_CALL(*lfs_, Fallocate(_, _, _, _))
+        .Times(0);
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->DiscardChunk(id, sn, 0, PAGE_SIZE));
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
+/**
+ * DiscardChunkTest
+ * chunk存在,快照文件不存在
+ * case1: discard部分区域
+ * 预期结果1:对应区域被置零，保留预分配的空间
+ * case2: 文件系统不支持FALLOC_FL_ZERO_RANGE
+ * 预期结果2:对应区域写零
+ * case3: discard整个chunk
+ * 预期结果3:chunk被删除
+ */
+TEST_F(CSDataStore_test, DiscardChunkTest2) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    ChunkID id = 2;
+    SequenceNum sn = 2;
+
+    // case1
+    {
+        off_t offset = PAGE_SIZE;
+        size_t length = 2 * PAGE_SIZE;
+        EXPECT_CALL(*lfs_, Fallocate(3,
+                                     FALLOC_FL_ZERO_RANGE|FALLOC_FL_KEEP_SIZE,
+                                     PAGE_SIZE + offset,
+                                     length))
+            .WillOnce(Return(0));
+        EXPECT_CALL(*fpool_, RecycleFile(chunk2Path))
+            .Times(0);
+        EXPECT_EQ(CSErrorCode::Success,
+                  dataStore->DiscardChunk(id, sn, offset, length));
+    }
+
+    // case2
+    {
+        off_t offset = PAGE_SIZE;
+        size_t length = 2 * PAGE_SIZE;
+        EXPECT_CALL(*lfs_, Fallocate(3,
+                                     FALLOC_FL_ZERO_RANGE|FALLOC_FL_KEEP_SIZE,
+                                     PAGE_SIZE + offset,
+                                     length))
+            .WillOnce(Return(-EOPNOTSUPP));
+        EXPECT_CALL(*lfs_, Write(3, Matcher<const char*>(NotNull()),
+                                 PAGE_SIZE + offset, length))
+            .WillOnce(Return(length));
+        EXPECT_EQ(CSErrorCode::Success,
+                  dataStore->DiscardChunk(id, sn, offset, length));
+    }
+
+    // case3
+    {
+        EXPECT_CALL(*lfs_, Fallocate(_, _, _, _))
+            .Times(0);
+        EXPECT_CALL(*lfs_, Close(3))
+            .Times(1);
+        EXPECT_CALL(*fpool_, RecycleFile(chunk2Path))
+            .WillOnce(Return(0));
+        EXPECT_EQ(CSErrorCode::Success,
+                  dataStore->DiscardChunk(id, sn, 0, CHUNK_SIZE));
+        CSChunkInfo info;
+        ASSERT_EQ(CSErrorCode::ChunkNotExistError,
+                  dataStore->GetChunkInfo(id, &info));
+    }
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+}
+
+/**
+ * DiscardChunkTest
+ * case:开启discardPunchHole，discard部分区域
+ * 预期结果:对应区域被punch hole
+ */
+TEST_F(CSDataStore_test, DiscardChunkPunchHoleTest) {
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = CHUNK_SIZE;
+    options.pageSize = PAGE_SIZE;
+    options.locationLimit = kLocationLimit;
+    options.discardPunchHole = true;
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    off_t offset = PAGE_SIZE;
+    size_t length = 2 * PAGE_SIZE;
+    EXPECT_CALL(*lfs_, Fallocate(3,
+                                 FALLOC_FL_PUNCH_HOLE|FALLOC_FL_KEEP_SIZE,
+                                 PAGE_SIZE + offset,
+                                 length))
+        .WillOnce(Return(0));
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->DiscardChunk(2, 2, offset, length));
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
+/**
+ * DiscardChunkTest
+ * case1: chunk存在快照文件
+ * 预期结果1:返回DiscardSkippedError，数据被保留
+ * case2: sn>chunkinfo.sn，需要转储快照
+ * 预期结果2:返回DiscardSkippedError，数据被保留
+ * case3: sn<chunkinfo.sn
+ * 预期结果3:返回BackwardRequestError
+ */
+TEST_F(CSDataStore_test, DiscardChunkTest3) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    EXPECT_CALL(*lfs_, Fallocate(_, _, _, _))
+        .Times(0);
+    EXPECT_CALL(*fpool_, RecycleFile(_))
+        .Times(0);
+
+    // case1
+    EXPECT_EQ(CSErrorCode::DiscardSkippedError,
+              dataStore->DiscardChunk(1, 2, 0, CHUNK_SIZE));
+    EXPECT_EQ(CSErrorCode::DiscardSkippedError,
+              dataStore->DiscardChunk(1, 2, 0, PAGE_SIZE));
+    // case2
+    EXPECT_EQ(CSErrorCode::DiscardSkippedError,
+              dataStore->DiscardChunk(2, 3, 0, CHUNK_SIZE));
+    EXPECT_EQ(CSErrorCode::DiscardSkippedError,
+              dataStore->DiscardChunk(2, 3, 0, PAGE_SIZE));
+    // case3
+    EXPECT_EQ(CSErrorCode::BackwardRequestError,
+              dataStore->DiscardChunk(2, 1, 0, CHUNK_SIZE));
+    EXPECT_EQ(CSErrorCode::BackwardRequestError,
+              dataStore->DiscardChunk(2, 1, 0, PAGE_SIZE));
+
+    CSChunkInfo info;
+    ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(1, &info));
+    ASSERT_EQ(CSErrorCode::Success, dataStore->GetChunkInfo(2, &info));
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
+/**
+ * DiscardChunkErrorTest
+ * case1: offset或length未对齐
+ * 预期结果1:返回InvalidArgError
+ * case2: fallocate失败
+ * 预期结果2:返回InternalError
+ */
+TEST_F(CSDataStore_test, DiscardChunkErrorTest1) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    ChunkID id = 2;
+    SequenceNum sn = 2;
+
+    // case1
+    {
+        EXPECT_CALL(*lfs_, Fallocate(_, _, _, _))
+            .Times(0);
+        EXPECT_EQ(CSErrorCode::InvalidArgError,
+                  dataStore->DiscardChunk(id, sn, 1, PAGE_SIZE));
+        EXPECT_EQ(CSErrorCode::InvalidArgError,
+                  dataStore->DiscardChunk(id, sn, 0, PAGE_SIZE - 1));
+        EXPECT_EQ(CSErrorCode::InvalidArgError,
+                  dataStore->DiscardChunk(id, sn, PAGE_SIZE, CHUNK_SIZE));
+    }
+
+    // case2
+    {
+        EXPECT_CALL(*lfs_, Fallocate(3, _, PAGE_SIZE, PAGE_SIZE))
+            .WillOnce(Return(-UT_ERRNO));
+        EXPECT_EQ(CSErrorCode::InternalError,
+                  dataStore->DiscardChunk(id, sn, 0, PAGE_SIZE));
+    }
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
 /**
  * DeleteSnapshotChunkOrCorrectSnTest
  * case:chunk不存在
@@ -4106,6 +4799,172 @@ TEST_F(CSDataStore_test, GetHashErrorTest2) {
         .Times(1);
 }
 
+/*
+ * 按固定大小分段读取计算hash
+ * case1:GetChunkHash按chunk文件的偏移读取，包含metapage
+ * case2:GetChunkDataHash跳过metapage读取chunk数据
+ * 预期结果:分两次读取，结果与一次计算的crc相同
+ */
+TEST_F(CSDataStore_test, GetHashTest) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    ChunkID id = 1;
+    std::string hash;
+    const size_t kBlockSize = 1024 * 1024;
+    std::string data(kBlockSize, 'a');
+    uint32_t crc = curve::common::CRC32(data.c_str(), kBlockSize);
+    crc = curve::common::CRC32(crc, data.c_str(), kBlockSize);
+
+    // case1
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), 0, kBlockSize))
+        .WillOnce(DoAll(SetArrayArgument<1>(data.begin(), data.end()),
+                        Return(kBlockSize)));
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), kBlockSize, kBlockSize))
+        .WillOnce(DoAll(SetArrayArgument<1>(data.begin(), data.end()),
+                        Return(kBlockSize)));
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->GetChunkHash(id, 0, 2 * kBlockSize, &hash));
+    ASSERT_EQ(std::to_string(crc), hash);
+
+    // case2
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), PAGE_SIZE, kBlockSize))
+        .WillOnce(DoAll(SetArrayArgument<1>(data.begin(), data.end()),
+                        Return(kBlockSize)));
+    EXPECT_CALL(*lfs_, Read(1, NotNull(), PAGE_SIZE + kBlockSize, kBlockSize))
+        .WillOnce(DoAll(SetArrayArgument<1>(data.begin(), data.end()),
+                        Return(kBlockSize)));
+    hash.clear();
+    EXPECT_EQ(CSErrorCode::Success,
+              dataStore->GetChunkDataHash(id, 0, 2 * kBlockSize, &hash));
+    ASSERT_EQ(std::to_string(crc), hash);
+    ASSERT_EQ(CSErrorCode::ChunkNotExistError,
+              dataStore->GetChunkDataHash(3, 0, kBlockSize, &hash));
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
+/*
+ * 获取所有chunk id
+ */
+TEST_F(CSDataStore_test, ListChunksTest) {
+    // initialize
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+
+    std::vector<ChunkID> ids;
+    dataStore->ListChunks(&ids);
+    ASSERT_EQ(2, ids.size());
+    ASSERT_EQ(1, ids[0]);
+    ASSERT_EQ(2, ids[1]);
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
+/*
+ * region hash测试
+ * case1:未开启region hash
+ * 预期结果1:返回InvalidArgError
+ * case2:第一次获取时计算所有region的crc
+ * 预期结果2:读取整个chunk，每个region的crc与GetChunkDataHash的结果相同
+ * case3:写入之后再次获取
+ * 预期结果3:只重新读取被写入的region
+ */
+TEST_F(CSDataStore_test, GetRegionHashTest) {
+    const uint32_t kRegionSize = 4 * 1024 * 1024;
+    const size_t kBlockSize = 1024 * 1024;
+    std::string data(kBlockSize, 'a');
+    uint32_t regionSize = 0;
+    std::vector<uint32_t> crcs;
+
+    // case1
+    FakeEnv();
+    EXPECT_TRUE(dataStore->Initialize());
+    ASSERT_EQ(CSErrorCode::InvalidArgError,
+              dataStore->GetChunkRegionHash(2, &regionSize, &crcs));
+
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = CHUNK_SIZE;
+    options.pageSize = PAGE_SIZE;
+    options.locationLimit = kLocationLimit;
+    options.regionHashSize = kRegionSize;
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+    EXPECT_TRUE(dataStore->Initialize());
+    ASSERT_EQ(CSErrorCode::ChunkNotExistError,
+              dataStore->GetChunkRegionHash(3, &regionSize, &crcs));
+
+    // case2
+    EXPECT_CALL(*lfs_, Read(3, NotNull(), Ge(PAGE_SIZE), kBlockSize))
+        .Times(CHUNK_SIZE / kBlockSize)
+        .WillRepeatedly(DoAll(SetArrayArgument<1>(data.begin(), data.end()),
+                              Return(kBlockSize)));
+    ASSERT_EQ(CSErrorCode::Success,
+              dataStore->GetChunkRegionHash(2, &regionSize, &crcs));
+    ASSERT_EQ(kRegionSize, regionSize);
+    ASSERT_EQ(CHUNK_SIZE / kRegionSize, crcs.size());
+    uint32_t crc = 0;
+    for (size_t i = 0; i < kRegionSize / kBlockSize; ++i) {
+        crc = curve::common::CRC32(crc, data.c_str(), kBlockSize);
+    }
+    for (uint32_t regionCrc : crcs) {
+        ASSERT_EQ(crc, regionCrc);
+    }
+
+    // case3
+    char buf[PAGE_SIZE];  // NOLINT
+    memset(buf, 0, sizeof(buf));
+    off_t offset = kRegionSize + PAGE_SIZE;
+    ASSERT_EQ(CSErrorCode::Success, dataStore->WriteChunk(2,
+                                                          2,
+                                                          buf,
+                                                          offset,
+                                                          PAGE_SIZE,
+                                                          nullptr));
+    std::string other(kBlockSize, 'b');
+    EXPECT_CALL(*lfs_, Read(3, NotNull(), Ge(PAGE_SIZE), kBlockSize))
+        .Times(0);
+    EXPECT_CALL(*lfs_, Read(3, NotNull(), Ge(PAGE_SIZE + kRegionSize),
+                            kBlockSize))
+        .Times(0);
+    for (size_t i = 0; i < kRegionSize / kBlockSize; ++i) {
+        EXPECT_CALL(*lfs_, Read(3, NotNull(),
+                                PAGE_SIZE + kRegionSize + i * kBlockSize,
+                                kBlockSize))
+            .WillOnce(DoAll(SetArrayArgument<1>(other.begin(), other.end()),
+                            Return(kBlockSize)));
+    }
+    std::vector<uint32_t> newCrcs;
+    ASSERT_EQ(CSErrorCode::Success,
+              dataStore->GetChunkRegionHash(2, &regionSize, &newCrcs));
+    ASSERT_EQ(crcs.size(), newCrcs.size());
+    for (size_t i = 0; i < crcs.size(); ++i) {
+        if (i == 1) {
+            ASSERT_NE(crcs[i], newCrcs[i]);
+        } else {
+            ASSERT_EQ(crcs[i], newCrcs[i]);
+        }
+    }
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
 /*
  * 获取datastore状态测试
  */
@@ -4127,5 +4986,77 @@ TEST_F(CSDataStore_test, GetStatusTest) {
         .Times(1);
 }
 
+/*
+ * group commit测试
+ * chunk文件不以O_DSYNC打开，写入的数据在SyncChunks时统一sync
+ */
+TEST_F(CSDataStore_test, SyncChunksTest1) {
+    DataStoreOptions options;
+    options.baseDir = baseDir;
+    options.chunkSize = CHUNK_SIZE;
+    options.pageSize = PAGE_SIZE;
+    options.locationLimit = kLocationLimit;
+    options.syncWrite = false;
+    dataStore = std::make_shared<CSDataStore>(lfs_, fpool_, options);
+    // initialize
+    FakeEnv();
+    EXPECT_CALL(*lfs_, Open(chunk1Path, Truly(hasDsyncFlag)))
+        .Times(0);
+    EXPECT_CALL(*lfs_, Open(chunk2Path, Truly(hasDsyncFlag)))
+        .Times(0);
+    EXPECT_TRUE(dataStore->Initialize());
+
+    // 没有写入时不需要sync
+    EXPECT_CALL(*lfs_, Fsync(_))
+        .Times(0);
+    ASSERT_EQ(CSErrorCode::Success, dataStore->SyncChunks());
+    ASSERT_EQ(0, dataStore->GetStatus().unsyncedBytes);
+
+    ChunkID id = 2;
+    SequenceNum sn = 2;
+    off_t offset = 0;
+    size_t length = PAGE_SIZE;
+    char buf[length];  // NOLINT
+    memset(buf, 0, sizeof(buf));
+    EXPECT_CALL(*lfs_,
+                Write(3, Matcher<butil::IOBuf>(_), PAGE_SIZE + offset, length))
+        .Times(2);
+    ASSERT_EQ(CSErrorCode::Success, dataStore->WriteChunk(id,
+                                                          sn,
+                                                          buf,
+                                                          offset,
+                                                          length,
+                                                          nullptr));
+    ASSERT_EQ(length, dataStore->GetStatus().unsyncedBytes);
+
+    // sync成功，未sync的数据清零
+    EXPECT_CALL(*lfs_, Fsync(3))
+        .WillOnce(Return(0));
+    ASSERT_EQ(CSErrorCode::Success, dataStore->SyncChunks());
+    ASSERT_EQ(0, dataStore->GetStatus().unsyncedBytes);
+
+    // sync失败，未sync的数据保留，下次重新sync
+    ASSERT_EQ(CSErrorCode::Success, dataStore->WriteChunk(id,
+                                                          sn,
+                                                          buf,
+                                                          offset,
+                                                          length,
+                                                          nullptr));
+    EXPECT_CALL(*lfs_, Fsync(3))
+        .WillOnce(Return(-UT_ERRNO))
+        .WillOnce(Return(0));
+    ASSERT_EQ(CSErrorCode::InternalError, dataStore->SyncChunks());
+    ASSERT_EQ(length, dataStore->GetStatus().unsyncedBytes);
+    ASSERT_EQ(CSErrorCode::Success, dataStore->SyncChunks());
+    ASSERT_EQ(0, dataStore->GetStatus().unsyncedBytes);
+
+    EXPECT_CALL(*lfs_, Close(1))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(2))
+        .Times(1);
+    EXPECT_CALL(*lfs_, Close(3))
+        .Times(1);
+}
+
 }  // namespace chunkserver
 }  // namespace curve
@@ -984,5 +984,79 @@ TEST_F(CSChunkfilePoolMockTest, RecycleFileTest) {
     }
 }
 
+TEST_F(CSChunkfilePoolMockTest, RecycleFilesTest) {
+    // 初始化options
+    FilePoolOptions options;
+    memcpy(options.filePoolDir, poolDir.c_str(), poolDir.size());
+    options.fileSize = CHUNK_SIZE;
+    options.metaPageSize = PAGE_SIZE;
+    memcpy(options.metaPath, poolMetaPath.c_str(), poolMetaPath.size());
+    options.metaFileSize = metaFileSize;
+    options.retryTimes = 3;
+    const std::string targetPath2 = "./data/chunk_2";
+
+    /****************getFileFromPool为false**************/
+    options.getFileFromPool = false;
+    // 有文件delete失败时返回-1，其他文件仍然删除
+    {
+        FilePool pool(lfs_);
+        FakePool(&pool, options, 0);
+        EXPECT_CALL(*lfs_, Delete(targetPath))
+            .WillOnce(Return(-1));
+        EXPECT_CALL(*lfs_, Delete(targetPath2))
+            .WillOnce(Return(0));
+        ASSERT_EQ(-1, pool.RecycleFiles({targetPath, targetPath2}));
+    }
+
+    /****************getFileFromPool为true**************/
+    options.getFileFromPool = true;
+    // 大小不匹配的文件直接删除，其他文件rename到pool中
+    {
+        FilePool pool(lfs_);
+        FakePool(&pool, options, 0);
+        struct stat fileInfo;
+        fileInfo.st_size = CHUNK_SIZE + PAGE_SIZE;
+
+        EXPECT_CALL(*lfs_, Open(targetPath, _))
+            .WillOnce(Return(-1));
+        EXPECT_CALL(*lfs_, Delete(targetPath))
+            .WillOnce(Return(0));
+        EXPECT_CALL(*lfs_, Open(targetPath2, _))
+            .WillOnce(Return(1));
+        EXPECT_CALL(*lfs_, Fstat(1, _))
+            .WillOnce(DoAll(SetArgPointee<1>(fileInfo),
+                            Return(0)));
+        EXPECT_CALL(*lfs_, Close(1))
+            .Times(1);
+        EXPECT_CALL(*lfs_, Rename(_, _, _))
+            .WillOnce(Return(0));
+        ASSERT_EQ(0, pool.RecycleFiles({targetPath, targetPath2}));
+        ASSERT_EQ(1, pool.Size());
+    }
+
+    // rename失败的文件不会放入pool
+    {
+        FilePool pool(lfs_);
+        FakePool(&pool, options, 0);
+        struct stat fileInfo;
+        fileInfo.st_size = CHUNK_SIZE + PAGE_SIZE;
+
+        EXPECT_CALL(*lfs_, Open(_, _))
+            .WillOnce(Return(1))
+            .WillOnce(Return(2));
+        EXPECT_CALL(*lfs_, Fstat(_, _))
+            .Times(2)
+            .WillRepeatedly(DoAll(SetArgPointee<1>(fileInfo),
+                                  Return(0)));
+        EXPECT_CALL(*lfs_, Close(_))
+            .Times(2);
+        EXPECT_CALL(*lfs_, Rename(_, _, _))
+            .WillOnce(Return(-1))
+            .WillOnce(Return(0));
+        ASSERT_EQ(-1, pool.RecycleFiles({targetPath, targetPath2}));
+        ASSERT_EQ(1, pool.Size());
+    }
+}
+
 }  // namespace chunkserver
 }  // namespace curve
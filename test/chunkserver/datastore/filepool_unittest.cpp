@@ -26,9 +26,12 @@
 #include <gtest/gtest.h>
 #include <json/json.h>
 
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <climits>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include "src/chunkserver/datastore/file_pool.h"
 #include "src/common/crc32.h"
@@ -454,6 +457,109 @@ TEST_F(CSFilePool_test, WithoutPoolConcurrentGetAndRecycle) {
     }
 }
 
+TEST_F(CSFilePool_test, CleanRecycledFileTest) {
+    std::string filePool = "./cspooltest/filePool.meta";
+    const std::string filePoolPath = FILEPOOL_DIR;
+    FilePoolOptions cfop;
+    cfop.fileSize = 4096;
+    cfop.metaPageSize = 4096;
+    cfop.needClean = true;
+    cfop.bytesPerWrite = 4096;
+    memcpy(cfop.metaPath, filePool.c_str(), filePool.size());
+    ASSERT_TRUE(chunkFilePoolPtr_->Initialize(cfop));
+    ASSERT_EQ(50, chunkFilePoolPtr_->Size());
+
+    // 回收的文件会在后台被清零后再放回池中
+    char metapage[4096];
+    memset(metapage, '1', 4096);
+    ASSERT_EQ(0, chunkFilePoolPtr_->GetFile("./new1", metapage));
+    ASSERT_EQ(49, chunkFilePoolPtr_->Size());
+    ASSERT_EQ(0, chunkFilePoolPtr_->RecycleFile("./new1"));
+    ASSERT_EQ(50, chunkFilePoolPtr_->Size());
+    ASSERT_EQ(50, chunkFilePoolPtr_->GetState().preallocatedChunksLeft);
+
+    // 扫描后最大文件编号为51，回收的文件编号为52
+    std::string recycled = filePoolPath + "52";
+    char data[8192];
+    bool cleaned = false;
+    for (int i = 0; i < 100 && !cleaned; ++i) {
+        int fd = fsptr->Open(recycled.c_str(), O_RDWR);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(8192, fsptr->Read(fd, data, 0, 8192));
+        fsptr->Close(fd);
+        cleaned = std::all_of(data, data + 8192,
+                              [](char c) { return c == 0; });
+        if (!cleaned) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    ASSERT_TRUE(cleaned);
+    ASSERT_EQ(50, chunkFilePoolPtr_->Size());
+    chunkFilePoolPtr_->UnInitialize();
+    ASSERT_EQ(0, chunkFilePoolPtr_->Size());
+}
+
+TEST_F(CSFilePool_test, RefillFileTest) {
+    const std::string filePoolPath = FILEPOOL_DIR;
+    FilePoolOptions cfop;
+    memcpy(cfop.filePoolDir, filePoolPath.c_str(), filePoolPath.size());
+    cfop.fileSize = 4096;
+    cfop.metaPageSize = 4096;
+    cfop.getFileFromPool = false;
+    cfop.lowWaterMark = 5;
+    ASSERT_EQ(0, fsptr->Delete(filePoolPath));
+    ASSERT_TRUE(chunkFilePoolPtr_->Initialize(cfop));
+
+    auto waitSize = [this](size_t expect) {
+        for (int i = 0; i < 100; ++i) {
+            if (chunkFilePoolPtr_->Size() == expect) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    };
+    // 后台预先分配文件直到达到低水位
+    ASSERT_TRUE(waitSize(5));
+
+    // 取走文件后会被补齐
+    char metapage[4096];
+    memset(metapage, '1', 4096);
+    ASSERT_EQ(0, chunkFilePoolPtr_->GetFile("./new1", metapage));
+    ASSERT_TRUE(waitSize(5));
+    {
+        std::vector<std::string> filename;
+        fsptr->List(filePoolPath, &filename);
+        ASSERT_EQ(5, filename.size());
+    }
+
+    // 不从池中获取时，回收的文件直接删除
+    ASSERT_EQ(0, chunkFilePoolPtr_->RecycleFile("./new1"));
+    ASSERT_FALSE(fsptr->FileExists("./new1"));
+    ASSERT_EQ(5, chunkFilePoolPtr_->Size());
+
+    // 重启后接管之前预先分配的文件，大小不对的文件保持不变，
+    // 新分配的文件不会与已有文件重名
+    chunkFilePoolPtr_->UnInitialize();
+    std::string stray = filePoolPath + "100";
+    int fd = fsptr->Open(stray.c_str(), O_RDWR | O_CREAT);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(4096, fsptr->Write(fd, metapage, 0, 4096));
+    fsptr->Close(fd);
+    ASSERT_TRUE(chunkFilePoolPtr_->Initialize(cfop));
+    ASSERT_EQ(5, chunkFilePoolPtr_->Size());
+    ASSERT_EQ(0, chunkFilePoolPtr_->GetFile("./new2", metapage));
+    ASSERT_TRUE(waitSize(5));
+    ASSERT_TRUE(fsptr->FileExists(stray));
+    ASSERT_TRUE(fsptr->FileExists(filePoolPath + "101"));
+    {
+        std::vector<std::string> filename;
+        fsptr->List(filePoolPath, &filename);
+        ASSERT_EQ(6, filename.size());
+    }
+    ASSERT_EQ(0, chunkFilePoolPtr_->RecycleFile("./new2"));
+}
+
 TEST(CSFilePool, GetFileDirectlyTest) {
     std::shared_ptr<FilePool> chunkFilePoolPtr_;
     std::shared_ptr<LocalFileSystem> fsptr;
@@ -0,0 +1,167 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <fcntl.h>
+#include <string>
+#include <memory>
+
+#include "src/chunkserver/datastore/chunkserver_metaindex.h"
+#include "src/fs/local_filesystem.h"
+
+using curve::fs::FileSystemType;
+using curve::fs::LocalFileSystem;
+using curve::fs::LocalFsFactory;
+
+namespace curve {
+namespace chunkserver {
+
+const char kMetaIndexPath[] = "./metaindex_unittest.index";  // NOLINT
+
+class CSMetaIndex_test : public testing::Test {
+ public:
+    void SetUp() {
+        lfs_ = LocalFsFactory::CreateFs(FileSystemType::EXT4, "");
+        lfs_->Delete(kMetaIndexPath);
+        metaIndex_ = std::make_shared<CSMetaIndex>(lfs_, kMetaIndexPath);
+
+        // chunk 1为普通chunk，chunk 2为clone chunk
+        metaPages_[1].sn = 2;
+        metaPages_[1].correctedSn = 0;
+        metaPages_[2].sn = 1;
+        metaPages_[2].correctedSn = 3;
+        metaPages_[2].location = "/file1/0@curve";
+        metaPages_[2].bitmap = std::make_shared<Bitmap>(4096);
+        metaPages_[2].bitmap->Set(1);
+        metaPages_[2].bitmap->Set(100, 200);
+        // chunk 1记录了region hash，其中region 1未计算
+        metaPages_[1].regionHash =
+            std::make_shared<ChunkRegionHash>(4096 * 1024, 4);
+        metaPages_[1].regionHash->crcs = {1, 0, 3, 4};
+        metaPages_[1].regionHash->valid.Set();
+        metaPages_[1].regionHash->valid.Clear(1);
+        // 记录chunk文件的inode和ctime
+        metaPages_[1].inode = 1001;
+        metaPages_[1].ctime = 1605000000123456789ULL;
+        metaPages_[2].inode = 1002;
+        metaPages_[2].ctime = 1605000000987654321ULL;
+    }
+
+    void TearDown() {
+        lfs_->Delete(kMetaIndexPath);
+    }
+
+    void AssertEqual(const MetaPageMap& expect, const MetaPageMap& actual) {
+        ASSERT_EQ(expect.size(), actual.size());
+        for (const auto& item : expect) {
+            auto iter = actual.find(item.first);
+            ASSERT_NE(actual.end(), iter);
+            ASSERT_EQ(item.second.sn, iter->second.sn);
+            ASSERT_EQ(item.second.correctedSn, iter->second.correctedSn);
+            ASSERT_EQ(item.second.location, iter->second.location);
+            ASSERT_EQ(item.second.inode, iter->second.inode);
+            ASSERT_EQ(item.second.ctime, iter->second.ctime);
+            if (item.second.bitmap == nullptr) {
+                ASSERT_EQ(nullptr, iter->second.bitmap);
+            } else {
+                ASSERT_NE(nullptr, iter->second.bitmap);
+                ASSERT_EQ(*item.second.bitmap, *iter->second.bitmap);
+            }
+            const auto& expectHash = item.second.regionHash;
+            const auto& actualHash = iter->second.regionHash;
+            if (expectHash == nullptr) {
+                ASSERT_EQ(nullptr, actualHash);
+            } else {
+                ASSERT_NE(nullptr, actualHash);
+                ASSERT_EQ(expectHash->regionSize, actualHash->regionSize);
+                ASSERT_EQ(expectHash->crcs, actualHash->crcs);
+                ASSERT_EQ(expectHash->valid, actualHash->valid);
+            }
+        }
+    }
+
+ protected:
+    std::shared_ptr<LocalFileSystem> lfs_;
+    std::shared_ptr<CSMetaIndex> metaIndex_;
+    MetaPageMap metaPages_;
+};
+
+TEST_F(CSMetaIndex_test, EncodeDecodeTest) {
+    std::string buf;
+    MetaPageMap metaPages;
+    // 空索引
+    CSMetaIndex::Encode(metaPages, &buf);
+    ASSERT_EQ(CSErrorCode::Success,
+              CSMetaIndex::Decode(buf.data(), buf.size(), &metaPages));
+    ASSERT_EQ(0, metaPages.size());
+
+    CSMetaIndex::Encode(metaPages_, &buf);
+    ASSERT_EQ(CSErrorCode::Success,
+              CSMetaIndex::Decode(buf.data(), buf.size(), &metaPages));
+    AssertEqual(metaPages_, metaPages);
+
+    // 数据被修改，crc校验失败
+    std::string damaged = buf;
+    damaged[10] += 1;
+    ASSERT_EQ(CSErrorCode::CrcCheckError,
+              CSMetaIndex::Decode(damaged.data(), damaged.size(), &metaPages));
+    // 数据被截断
+    ASSERT_EQ(CSErrorCode::CrcCheckError,
+              CSMetaIndex::Decode(buf.data(), buf.size() - 1, &metaPages));
+    ASSERT_EQ(CSErrorCode::FileFormatError,
+              CSMetaIndex::Decode(buf.data(), 2, &metaPages));
+}
+
+TEST_F(CSMetaIndex_test, SaveLoadTest) {
+    MetaPageMap metaPages;
+    // 索引不存在
+    ASSERT_FALSE(metaIndex_->Load(&metaPages));
+    ASSERT_EQ(CSErrorCode::Success, metaIndex_->Invalidate());
+
+    // 保存后加载
+    ASSERT_EQ(CSErrorCode::Success, metaIndex_->Save(metaPages_));
+    ASSERT_TRUE(lfs_->FileExists(kMetaIndexPath));
+    ASSERT_FALSE(lfs_->FileExists(std::string(kMetaIndexPath) + ".tmp"));
+    ASSERT_TRUE(metaIndex_->Load(&metaPages));
+    AssertEqual(metaPages_, metaPages);
+
+    // 重复保存会覆盖原来的索引
+    metaPages_[1].sn = 5;
+    metaPages_.erase(2);
+    ASSERT_EQ(CSErrorCode::Success, metaIndex_->Save(metaPages_));
+    ASSERT_TRUE(metaIndex_->Load(&metaPages));
+    AssertEqual(metaPages_, metaPages);
+
+    // 失效以后不能再加载
+    ASSERT_EQ(CSErrorCode::Success, metaIndex_->Invalidate());
+    ASSERT_FALSE(lfs_->FileExists(kMetaIndexPath));
+    ASSERT_FALSE(metaIndex_->Load(&metaPages));
+
+    // 索引文件损坏
+    int fd = lfs_->Open(kMetaIndexPath, O_RDWR|O_CREAT);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(4, lfs_->Write(fd, "test", 0, 4));
+    lfs_->Close(fd);
+    ASSERT_FALSE(metaIndex_->Load(&metaPages));
+}
+
+}  // namespace chunkserver
+}  // namespace curve
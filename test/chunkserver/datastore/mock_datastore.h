@@ -25,6 +25,7 @@
 
 #include <gmock/gmock.h>
 #include <string>
+#include <vector>
 
 #include "src/chunkserver/datastore/chunkserver_datastore.h"
 
@@ -37,6 +38,12 @@ class MockDataStore : public CSDataStore {
     ~MockDataStore() = default;
     MOCK_METHOD0(Initialize, bool());
     MOCK_METHOD2(DeleteChunk, CSErrorCode(ChunkID, SequenceNum));
+    MOCK_METHOD2(DeleteChunks, CSErrorCode(const std::vector<ChunkID>&,
+                                           SequenceNum));
+    MOCK_METHOD4(DiscardChunk, CSErrorCode(ChunkID,
+                                           SequenceNum,
+                                           off_t,
+                                           size_t));
     MOCK_METHOD2(DeleteSnapshotChunkOrCorrectSn, CSErrorCode(ChunkID,
                                                              SequenceNum));
     MOCK_METHOD5(ReadChunk, CSErrorCode(ChunkID,
@@ -44,6 +51,13 @@ class MockDataStore : public CSDataStore {
                                         char*,
                                         off_t,
                                         size_t));
+    MOCK_METHOD5(ReadChunkToIOBuf, CSErrorCode(ChunkID,
+                                               SequenceNum,
+                                               butil::IOBuf*,
+                                               off_t,
+                                               size_t));
+    MOCK_METHOD0(SaveMetaIndex, CSErrorCode());
+    MOCK_METHOD0(SyncChunks, CSErrorCode());
     MOCK_METHOD5(ReadSnapshotChunk, CSErrorCode(ChunkID,
                                                 SequenceNum,
                                                 char*,
@@ -56,6 +70,13 @@ class MockDataStore : public CSDataStore {
                                          size_t,
                                          uint32_t*,
                                          const string&));
+    MOCK_METHOD7(WriteChunkAsync, void(ChunkID,
+                                       SequenceNum,
+                                       const butil::IOBuf&,
+                                       off_t,
+                                       size_t,
+                                       const string&,
+                                       CSWriteCallback));
     MOCK_METHOD5(CreateCloneChunk, CSErrorCode(ChunkID,
                                                SequenceNum,
                                                SequenceNum,
@@ -66,6 +87,18 @@ class MockDataStore : public CSDataStore {
                                          off_t,
                                          size_t));
     MOCK_METHOD2(GetChunkInfo, CSErrorCode(ChunkID, CSChunkInfo*));
+    MOCK_METHOD4(GetChunkHash, CSErrorCode(ChunkID,
+                                           off_t,
+                                           size_t,
+                                           std::string*));
+    MOCK_METHOD4(GetChunkDataHash, CSErrorCode(ChunkID,
+                                               off_t,
+                                               size_t,
+                                               std::string*));
+    MOCK_METHOD3(GetChunkRegionHash, CSErrorCode(ChunkID,
+                                                 uint32_t*,
+                                                 std::vector<uint32_t>*));
+    MOCK_METHOD1(ListChunks, void(std::vector<ChunkID>*));
     MOCK_METHOD0(GetStatus, DataStoreStatus());
 };
 
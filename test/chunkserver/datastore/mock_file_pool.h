@@ -26,6 +26,7 @@
 #include <gmock/gmock.h>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "src/chunkserver/datastore/file_pool.h"
 
@@ -40,6 +41,8 @@ class MockFilePool : public FilePool {
     MOCK_METHOD1(Initialize, bool(FilePoolOptions));
     MOCK_METHOD2(GetFile, int(const std::string&, char*));
     MOCK_METHOD1(RecycleFile, int(const std::string&  chunkpath));
+    MOCK_METHOD1(RecycleFiles,
+                 int(const std::vector<std::string>& chunkpaths));
     MOCK_METHOD0(UnInitialize, void());
     MOCK_METHOD0(Size, size_t());
     MOCK_METHOD0(GetFilePoolOpt, FilePoolOptions());
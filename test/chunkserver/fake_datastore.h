@@ -78,6 +78,32 @@ class FakeCSDataStore : public CSDataStore {
         }
     }
 
+    CSErrorCode DeleteChunks(const std::vector<ChunkID>& ids,
+                             SequenceNum sn) override {
+        CSErrorCode errorCode = HasInjectError();
+        if (errorCode != CSErrorCode::Success) {
+            return errorCode;
+        }
+        for (auto id : ids) {
+            chunkIds_.erase(id);
+        }
+        return CSErrorCode::Success;
+    }
+
+    CSErrorCode DiscardChunk(ChunkID id,
+                             SequenceNum sn,
+                             off_t offset,
+                             size_t length) override {
+        CSErrorCode errorCode = HasInjectError();
+        if (errorCode != CSErrorCode::Success) {
+            return errorCode;
+        }
+        if (offset == 0 && length == chunkSize_) {
+            chunkIds_.erase(id);
+        }
+        return CSErrorCode::Success;
+    }
+
     CSErrorCode DeleteSnapshotChunkOrCorrectSn(
         ChunkID id, SequenceNum correctedSn) override {
         CSErrorCode errorCode = HasInjectError();
@@ -112,6 +138,25 @@ class FakeCSDataStore : public CSDataStore {
         return CSErrorCode::Success;
     }
 
+    CSErrorCode ReadChunkToIOBuf(ChunkID id,
+                                 SequenceNum sn,
+                                 butil::IOBuf *buf,
+                                 off_t offset,
+                                 size_t length) override {
+        CSErrorCode errorCode = HasInjectError();
+        if (errorCode != CSErrorCode::Success) {
+            return errorCode;
+        }
+        if (chunkIds_.find(id) == chunkIds_.end()) {
+            return CSErrorCode::ChunkNotExistError;
+        }
+        buf->append(chunk_+offset, length);
+        if (HasInjectError()) {
+            return CSErrorCode::InternalError;
+        }
+        return CSErrorCode::Success;
+    }
+
     CSErrorCode ReadSnapshotChunk(ChunkID id,
                                   SequenceNum sn,
                                   char *buf,
@@ -146,6 +191,17 @@ class FakeCSDataStore : public CSDataStore {
         return CSErrorCode::Success;
     }
 
+    void WriteChunkAsync(ChunkID id,
+                         SequenceNum sn,
+                         const butil::IOBuf& buf,
+                         off_t offset,
+                         size_t length,
+                         const std::string& csl,
+                         CSWriteCallback done) override {
+        uint32_t cost;
+        done(WriteChunk(id, sn, buf, offset, length, &cost, csl));
+    }
+
     CSErrorCode CreateCloneChunk(ChunkID id,
                                  SequenceNum sn,
                                  SequenceNum correctedSn,
@@ -204,6 +260,10 @@ class FakeCSDataStore : public CSDataStore {
         }
     }
 
+    CSErrorCode SyncChunks() override {
+        return HasInjectError();
+    }
+
     void InjectError(CSErrorCode errorCode = CSErrorCode::InternalError) {
         error_ = errorCode;
     }
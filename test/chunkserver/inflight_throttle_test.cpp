@@ -116,5 +116,91 @@ TEST(InflightThrottleTest, basic) {
     }
 }
 
+TEST(InflightThrottleTest, copyset_and_background) {
+    InflightThrottleOptions options;
+    options.maxInflight = 10;
+    options.copysetPercent = 50;
+    options.backgroundPercent = 50;
+    InflightThrottle inflightThrottle(options);
+
+    // 单个copyset最多占用上限的一半
+    for (int i = 0; i < 5; ++i) {
+        inflightThrottle.Increment(1, 100);
+    }
+    ASSERT_FALSE(inflightThrottle.IsOverLoad(1, 100));
+    ASSERT_FALSE(inflightThrottle.IsBackgroundOverLoad());
+    inflightThrottle.Increment(1, 100);
+    ASSERT_TRUE(inflightThrottle.IsOverLoad(1, 100));
+    ASSERT_FALSE(inflightThrottle.IsOverLoad(1, 101));
+    ASSERT_FALSE(inflightThrottle.IsOverLoad());
+    // 后台任务在inflight超过上限的一半时让路
+    ASSERT_TRUE(inflightThrottle.IsBackgroundOverLoad());
+
+    inflightThrottle.Decrement(1, 100);
+    ASSERT_FALSE(inflightThrottle.IsOverLoad(1, 100));
+    ASSERT_FALSE(inflightThrottle.IsBackgroundOverLoad());
+
+    // 其他copyset的请求占满了chunkserver的上限
+    for (int i = 0; i < 6; ++i) {
+        inflightThrottle.Increment(1, 101);
+    }
+    ASSERT_TRUE(inflightThrottle.IsOverLoad());
+    ASSERT_TRUE(inflightThrottle.IsOverLoad(1, 102));
+}
+
+TEST(InflightThrottleTest, adaptive) {
+    InflightThrottleOptions options;
+    options.maxInflight = 1000;
+    options.minInflight = 100;
+    options.enableAdaptive = true;
+    options.targetLatencyUs = 1000;
+
+    // 关闭自适应时上限不变
+    {
+        InflightThrottleOptions fixed = options;
+        fixed.enableAdaptive = false;
+        InflightThrottle inflightThrottle(fixed);
+        for (int i = 0; i < 10000; ++i) {
+            inflightThrottle.OnLatency(10000);
+        }
+        ASSERT_EQ(1000, inflightThrottle.GetLimit());
+    }
+
+    InflightThrottle inflightThrottle(options);
+    ASSERT_EQ(1000, inflightThrottle.GetLimit());
+
+    // 延时超过目标，上限乘性减小，直到下限
+    for (int i = 0; i < 256; ++i) {
+        inflightThrottle.OnLatency(2000);
+    }
+    ASSERT_EQ(900, inflightThrottle.GetLimit());
+    for (int i = 0; i < 256 * 100; ++i) {
+        inflightThrottle.OnLatency(2000);
+    }
+    ASSERT_EQ(100, inflightThrottle.GetLimit());
+
+    // 延时满足要求但是上限没有用到一半，上限不变
+    for (int i = 0; i < 256; ++i) {
+        inflightThrottle.OnLatency(500);
+    }
+    ASSERT_EQ(100, inflightThrottle.GetLimit());
+
+    // 延时满足要求且上限用到一半以上，上限加性增大，直到上限
+    for (int i = 0; i < 50; ++i) {
+        inflightThrottle.Increment();
+    }
+    for (int i = 0; i < 256; ++i) {
+        inflightThrottle.OnLatency(500);
+    }
+    ASSERT_EQ(103, inflightThrottle.GetLimit());
+    for (int i = 0; i < 600; ++i) {
+        inflightThrottle.Increment();
+    }
+    for (int i = 0; i < 256 * 1000; ++i) {
+        inflightThrottle.OnLatency(500);
+    }
+    ASSERT_EQ(1000, inflightThrottle.GetLimit());
+}
+
 }  // namespace chunkserver
 }  // namespace curve
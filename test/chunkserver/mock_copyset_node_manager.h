@@ -24,6 +24,7 @@
 #define TEST_CHUNKSERVER_MOCK_COPYSET_NODE_MANAGER_H_
 
 #include <gmock/gmock.h>
+#include <vector>
 #include "src/chunkserver/copyset_node_manager.h"
 
 namespace curve {
@@ -34,6 +35,7 @@ class MockCopysetNodeManager : public CopysetNodeManager {
     ~MockCopysetNodeManager() {}
 
     MOCK_METHOD0(LoadFinished, bool());
+    MOCK_CONST_METHOD1(GetAllCopysetNodes, void(std::vector<CopysetNodePtr>*));
 };
 }  // namespace chunkserver
 }  // namespace curve
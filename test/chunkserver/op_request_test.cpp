@@ -603,6 +603,102 @@ TEST(ChunkOpRequestTest, OnApplyErrorTest) {
     }
 }
 
+TEST(ChunkOpRequestTest, OnApplyAsyncTest) {
+    LogicPoolID logicPoolId = 1;
+    CopysetID copysetId = 10001;
+    uint64_t chunkId = 12345;
+    size_t offset = 0;
+    uint32_t size = 16;
+    uint64_t sn = 1;
+    uint64_t appliedIndex = 12;
+
+    Configuration conf;
+    std::shared_ptr<CopysetNode> nodePtr =
+        std::make_shared<CopysetNode>(logicPoolId, copysetId, conf);
+    std::shared_ptr<LocalFileSystem>
+        fs(LocalFsFactory::CreateFs(FileSystemType::EXT4, ""));    //NOLINT
+    DataStoreOptions options;
+    options.baseDir = "./test-temp";
+    options.chunkSize = 16 * 1024 * 1024;
+    options.pageSize = 4 * 1024;
+    std::shared_ptr<FakeCSDataStore> dataStore =
+        std::make_shared<FakeCSDataStore>(options, fs);
+    nodePtr->SetCSDateStore(dataStore);
+
+    ChunkRequest request;
+    request.set_optype(CHUNK_OP_TYPE::CHUNK_OP_WRITE);
+    request.set_logicpoolid(logicPoolId);
+    request.set_copysetid(copysetId);
+    request.set_chunkid(chunkId);
+    request.set_offset(offset);
+    request.set_size(size);
+    request.set_sn(sn);
+
+    // write: the response is set and done is run before applied
+    {
+        ChunkResponse response;
+        brpc::Controller *cntl = new brpc::Controller();
+        cntl->request_attachment().append(std::string(size, 'a'));
+        std::shared_ptr<ChunkOpRequest> opReq =
+            std::make_shared<WriteChunkRequest>(nodePtr,
+                                                cntl,
+                                                &request,
+                                                &response,
+                                                nullptr);
+        OpFakeClosure done;
+        bool applied = false;
+        opReq->OnApplyAsync(appliedIndex, &done, [&]() {
+            ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS,
+                      response.status());
+            applied = true;
+        });
+        ASSERT_TRUE(applied);
+        ASSERT_EQ(appliedIndex, response.appliedindex());
+        delete cntl;
+    }
+    // write: backward request
+    {
+        ChunkResponse response;
+        brpc::Controller *cntl = new brpc::Controller();
+        std::shared_ptr<ChunkOpRequest> opReq =
+            std::make_shared<WriteChunkRequest>(nodePtr,
+                                                cntl,
+                                                &request,
+                                                &response,
+                                                nullptr);
+        dataStore->InjectError(CSErrorCode::BackwardRequestError);
+        OpFakeClosure done;
+        bool applied = false;
+        opReq->OnApplyAsync(appliedIndex, &done, [&]() { applied = true; });
+        ASSERT_TRUE(applied);
+        ASSERT_EQ(CHUNK_OP_STATUS::CHUNK_OP_STATUS_BACKWARD,
+                  response.status());
+        delete cntl;
+    }
+    // write from log
+    {
+        butil::IOBuf data;
+        data.append(std::string(size, 'b'));
+        WriteChunkRequest req;
+        bool applied = false;
+        req.OnApplyFromLogAsync(dataStore, request, data,
+                                [&]() { applied = true; });
+        ASSERT_TRUE(applied);
+        ASSERT_FALSE(dataStore->HasInjectError());
+    }
+    // other requests are applied synchronously by default
+    {
+        ChunkRequest deleteRequest = request;
+        deleteRequest.set_optype(CHUNK_OP_TYPE::CHUNK_OP_DELETE);
+        butil::IOBuf data;
+        DeleteChunkRequest req;
+        bool applied = false;
+        req.OnApplyFromLogAsync(dataStore, deleteRequest, data,
+                                [&]() { applied = true; });
+        ASSERT_TRUE(applied);
+    }
+}
+
 TEST(ChunkOpRequestTest, OnApplyFromLogTest) {
     LogicPoolID logicPoolId = 1;
     CopysetID copysetId = 10001;
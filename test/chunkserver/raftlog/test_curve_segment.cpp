@@ -30,6 +30,8 @@
 #include <gtest/gtest.h>
 #include <braft/log.h>
 #include <memory>
+#include <string>
+#include <vector>
 #include "src/chunkserver/raftlog/curve_segment.h"
 #include "src/chunkserver/raftlog/define.h"
 #include "test/fs/mock_local_filesystem.h"
@@ -236,5 +238,141 @@ TEST_F(CurveSegmentTest, closed_segment) {
     delete configuration_manager;
 }
 
+TEST_F(CurveSegmentTest, append_entries_in_batch) {
+    EXPECT_CALL(*file_pool, GetFilePoolOpt())
+        .WillRepeatedly(Return(fp_option));
+    EXPECT_CALL(*file_pool, GetFile(_, _))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*file_pool, RecycleFile(_))
+        .WillOnce(Return(0));
+    scoped_refptr<CurveSegment> seg1 =
+                new CurveSegment(kRaftLogDataDir, 1, 0);
+
+    // create and open
+    std::string path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN, 1);
+    ASSERT_EQ(0, prepare_segment(path));
+    ASSERT_EQ(0, seg1->create());
+    ASSERT_TRUE(seg1->is_open());
+
+    // small entries share the pooled buffers, the entry larger than
+    // the pooled buffer is written with a buffer of its own
+    std::vector<std::string> datas;
+    std::vector<braft::LogEntry*> entries;
+    for (int i = 0; i < 10; i++) {
+        braft::LogEntry* entry = new braft::LogEntry();
+        entry->AddRef();
+        entry->type = braft::ENTRY_TYPE_DATA;
+        entry->id.term = 1;
+        entry->id.index = i + 1;
+        std::string data(i == 5 ? FLAGS_walBatchBufferSize + 1 : 100 * i,
+                         'a' + i);
+        entry->data.append(data);
+        datas.push_back(data);
+        entries.push_back(entry);
+    }
+    int64_t bytes = seg1->bytes();
+    ASSERT_EQ(0, seg1->append_entries(entries));
+    ASSERT_EQ(10, seg1->last_index());
+    ASSERT_GT(seg1->bytes(), bytes + FLAGS_walBatchBufferSize);
+    ASSERT_EQ(0, seg1->bytes() % FLAGS_walAlignSize);
+    for (auto entry : entries) {
+        entry->Release();
+    }
+
+    braft::ConfigurationManager* configuration_manager =
+                                new braft::ConfigurationManager;
+    // load open segment
+    scoped_refptr<CurveSegment> seg2 =
+                        new CurveSegment(kRaftLogDataDir, 1, 0);
+    ASSERT_EQ(0, seg2->load(configuration_manager));
+    ASSERT_EQ(10, seg2->last_index());
+    for (int i = 0; i < 10; i++) {
+        braft::LogEntry* entry = seg2->get(i + 1);
+        ASSERT_TRUE(entry != NULL);
+        ASSERT_EQ(1, entry->id.term);
+        ASSERT_EQ(datas[i], entry->data.to_string());
+        entry->Release();
+    }
+
+    ASSERT_EQ(0, seg1->close());
+    ASSERT_EQ(0, seg1->unlink());
+    delete configuration_manager;
+}
+
+TEST_F(CurveSegmentTest, append_entries_in_batch_without_direct_write) {
+    FLAGS_enableWalDirectWrite = false;
+    EXPECT_CALL(*file_pool, GetFilePoolOpt())
+        .WillRepeatedly(Return(fp_option));
+    EXPECT_CALL(*file_pool, GetFile(_, _))
+        .WillOnce(Return(0));
+    EXPECT_CALL(*file_pool, RecycleFile(_))
+        .WillOnce(Return(0));
+    scoped_refptr<CurveSegment> seg1 =
+                new CurveSegment(kRaftLogDataDir, 1, 0);
+
+    // create and open
+    std::string path = kRaftLogDataDir;
+    butil::string_appendf(&path, "/" CURVE_SEGMENT_OPEN_PATTERN, 1);
+    ASSERT_EQ(0, prepare_segment(path));
+    ASSERT_EQ(0, seg1->create());
+    ASSERT_TRUE(seg1->is_open());
+
+    // the buffered path drains the entry data while writing, the offsets
+    // of the batch must still follow the encoded size of every entry
+    std::vector<std::string> datas;
+    std::vector<braft::LogEntry*> entries;
+    int64_t expected_bytes = seg1->bytes();
+    for (int i = 0; i < 10; i++) {
+        braft::LogEntry* entry = new braft::LogEntry();
+        entry->AddRef();
+        entry->type = braft::ENTRY_TYPE_DATA;
+        entry->id.term = 1;
+        entry->id.index = i + 1;
+        std::string data(100 * i + 1, 'a' + i);
+        entry->data.append(data);
+        datas.push_back(data);
+        entries.push_back(entry);
+        expected_bytes += FLAGS_walAlignSize;
+    }
+    ASSERT_EQ(0, seg1->append_entries(entries));
+    ASSERT_EQ(10, seg1->last_index());
+    ASSERT_EQ(expected_bytes, seg1->bytes());
+    for (auto entry : entries) {
+        entry->Release();
+    }
+    for (int i = 0; i < 10; i++) {
+        braft::LogEntry* entry = seg1->get(i + 1);
+        ASSERT_TRUE(entry != NULL);
+        ASSERT_EQ(1, entry->id.term);
+        ASSERT_EQ(datas[i], entry->data.to_string());
+        entry->Release();
+    }
+
+    // append one more entry, it must not overwrite the batch
+    append_entries_curve_segment(seg1.get(), "hello, world: %d", 10, 11);
+    ASSERT_EQ(11, seg1->last_index());
+
+    braft::ConfigurationManager* configuration_manager =
+                                new braft::ConfigurationManager;
+    // load open segment
+    scoped_refptr<CurveSegment> seg2 =
+                        new CurveSegment(kRaftLogDataDir, 1, 0);
+    ASSERT_EQ(0, seg2->load(configuration_manager));
+    ASSERT_EQ(11, seg2->last_index());
+    for (int i = 0; i < 10; i++) {
+        braft::LogEntry* entry = seg2->get(i + 1);
+        ASSERT_TRUE(entry != NULL);
+        ASSERT_EQ(datas[i], entry->data.to_string());
+        entry->Release();
+    }
+    read_entries_curve_segment(seg2.get(), "hello, world: %d", 10, 11);
+
+    ASSERT_EQ(0, seg1->close());
+    ASSERT_EQ(0, seg1->unlink());
+    delete configuration_manager;
+    FLAGS_enableWalDirectWrite = true;
+}
+
 }  // namespace chunkserver
 }  // namespace curve
@@ -90,6 +90,58 @@ TEST_F(CurveFileServiceTest, success_normal_file) {
     kCurveFileService.remove_reader(reader_id);
 }
 
+TEST_F(CurveFileServiceTest, success_skip_zero_pages) {
+    int64_t reader_id;
+    ASSERT_EQ(0, kCurveFileService.add_reader(reader_, &reader_id));
+    kCurveFileService.set_skip_zero_pages(true);
+    // 数据布局: 4KB非零 + 8KB零 + 4KB非零 + 4KB零，且没有读到文件末尾
+    std::string data(4096, 'a');
+    data.append(8192, '\0');
+    data.append(4096, 'b');
+    data.append(4096, '\0');
+    butil::IOBuf buf;
+    buf.append(data);
+    EXPECT_CALL(*reader_, read_file(_, _, _, _, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<0>(buf),
+                        SetArgPointee<5>(data.size()),
+                        SetArgPointee<6>(false),
+                        Return(0)));
+    std::string path = "/test";
+    EXPECT_CALL(*reader_, path())
+        .WillRepeatedly(ReturnRef(path));
+    brpc::Channel channel;
+    brpc::Controller cntl;
+    ASSERT_EQ(channel.Init(serverAddr, nullptr), 0);
+    braft::FileService_Stub stub(&channel);
+    braft::GetFileRequest request;
+    request.set_reader_id(reader_id);
+    request.set_filename("test");
+    request.set_count(data.size());
+    request.set_offset(8192);
+    braft::GetFileResponse response;
+    stub.get_file(&cntl, &request, &response, nullptr);
+    ASSERT_FALSE(cntl.Failed());
+    ASSERT_EQ(data.size(), response.read_size());
+    ASSERT_FALSE(response.eof());
+
+    // 只发送了两段非零的数据
+    braft::FileSegData segData(cntl.response_attachment());
+    uint64_t segOffset = 0;
+    butil::IOBuf seg;
+    ASSERT_NE(0, segData.next(&segOffset, &seg));
+    ASSERT_EQ(8192, segOffset);
+    ASSERT_EQ(std::string(4096, 'a'), seg.to_string());
+    seg.clear();
+    ASSERT_NE(0, segData.next(&segOffset, &seg));
+    ASSERT_EQ(8192 + 12288, segOffset);
+    ASSERT_EQ(std::string(4096, 'b'), seg.to_string());
+    seg.clear();
+    ASSERT_EQ(0, segData.next(&segOffset, &seg));
+
+    kCurveFileService.set_skip_zero_pages(false);
+    kCurveFileService.remove_reader(reader_id);
+}
+
 TEST_F(CurveFileServiceTest, success_attach_file) {
     int64_t reader_id;
     ASSERT_EQ(0, kCurveFileService.add_reader(reader_, &reader_id));
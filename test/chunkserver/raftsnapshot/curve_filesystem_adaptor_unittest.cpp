@@ -157,6 +157,50 @@ TEST_F(CurveFilesystemAdaptorTest, open_file_test) {
     ASSERT_EQ(nullptr, fa);
 }
 
+TEST_F(CurveFilesystemAdaptorTest, zero_skipped_ranges_test) {
+    butil::File::Error e;
+    char data[8192];
+    char expect[8192];
+    butil::IOBuf buf;
+    buf.append(std::string(1024, 'b'));
+
+    // FilePool中的文件前4KB是metapage，其余的内容都是'a'
+    // 1. 最后一次写入之前没有收到数据的区域被清零
+    std::string path = "./raftsnap/12";
+    braft::FileAdaptor* fa = fsadaptor->open(path, O_RDWR | O_CREAT,
+                                             nullptr, &e);
+    ASSERT_NE(nullptr, fa);
+    ASSERT_EQ(1024, fa->write(buf, 7168));
+    ASSERT_TRUE(fa->close());
+    delete fa;
+    int fd = fsptr->Open(path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(8192, fsptr->Read(fd, data, 0, 8192));
+    fsptr->Close(fd);
+    memset(expect, 0, 7168);
+    memset(expect + 7168, 'b', 1024);
+    ASSERT_EQ(0, memcmp(data, expect, 8192));
+
+    // 2. 只把最后一次写入之前的空洞清零，之后的区域保持不变
+    path = "./raftsnap/13";
+    fa = fsadaptor->open(path, O_RDWR | O_CREAT, nullptr, &e);
+    ASSERT_NE(nullptr, fa);
+    ASSERT_EQ(1024, fa->write(buf, 0));
+    ASSERT_EQ(1024, fa->write(buf, 5120));
+    ASSERT_EQ(1024, fa->write(buf, 4608));
+    ASSERT_TRUE(fa->close());
+    delete fa;
+    fd = fsptr->Open(path.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(8192, fsptr->Read(fd, data, 0, 8192));
+    fsptr->Close(fd);
+    memset(expect, 'b', 1024);
+    memset(expect + 1024, 0, 3584);
+    memset(expect + 4608, 'b', 1536);
+    memset(expect + 6144, 'a', 2048);
+    ASSERT_EQ(0, memcmp(data, expect, 8192));
+}
+
 TEST_F(CurveFilesystemAdaptorTest, delete_file_test) {
     // 1. 创建一个多层目录，且目录中含有chunk文件
     ASSERT_EQ(0, fsptr->Mkdir("./test_temp"));
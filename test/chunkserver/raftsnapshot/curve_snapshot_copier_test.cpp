@@ -0,0 +1,320 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
+#include <glog/logging.h>
+#include <brpc/server.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "src/chunkserver/raftsnapshot/curve_snapshot_copier.h"
+#include "src/chunkserver/raftsnapshot/curve_snapshot_storage.h"
+#include "src/chunkserver/raftsnapshot/curve_file_service.h"
+#include "src/common/timeutility.h"
+
+namespace curve {
+namespace chunkserver {
+
+using ::testing::Return;
+
+const char kCopierServerAddr[] = "127.0.0.1:9503";
+
+class MockSnapshotThrottle : public braft::SnapshotThrottle {
+ public:
+    MOCK_METHOD1(throttled_by_throughput, size_t(int64_t));
+    MOCK_METHOD1(add_one_more_task, bool(bool));
+    MOCK_METHOD1(finish_one_task, void(bool));
+    MOCK_METHOD0(get_retry_interval_ms, int64_t());
+    MOCK_METHOD3(return_unused_throughput, void(int64_t, int64_t, int64_t));
+};
+
+static std::string file_name(int index) {
+    return "file" + std::to_string(index);
+}
+
+static std::string file_data(int index, size_t size) {
+    return std::string(size, 'a' + index % 26);
+}
+
+static void write_snapshot_file(braft::FileSystemAdaptor* fs,
+                                const std::string& path,
+                                const std::string& data) {
+    braft::FileAdaptor* file = fs->open(
+                    path, O_CREAT | O_TRUNC | O_RDWR, NULL, NULL);
+    CHECK(file != NULL);
+    butil::IOBuf io_buf;
+    io_buf.append(data);
+    CHECK_EQ(data.size(), file->write(io_buf, 0));
+    delete file;
+}
+
+static std::string read_snapshot_file(braft::FileSystemAdaptor* fs,
+                                      const std::string& path) {
+    braft::FileAdaptor* file = fs->open(path, O_RDONLY, NULL, NULL);
+    if (file == NULL) {
+        return "";
+    }
+    butil::IOPortal portal;
+    file->read(&portal, 0, file->size());
+    delete file;
+    return portal.to_string();
+}
+
+class CurveSnapshotCopierTest : public testing::Test {
+ protected:
+    void SetUp() {
+        fs_ = new braft::PosixFileSystemAdaptor();
+        fs_->delete_file("copier_data", true);
+        fs_->delete_file("copier_data2", true);
+        fs_->delete_file("copier_data3", true);
+        ASSERT_EQ(0, server_.AddService(&kCurveFileService,
+                                        brpc::SERVER_DOESNT_OWN_SERVICE));
+        ASSERT_EQ(0, server_.Start(kCopierServerAddr, NULL));
+
+        storage1_ = new CurveSnapshotStorage("./copier_data");
+        ASSERT_EQ(0, storage1_->set_file_system_adaptor(fs_));
+        ASSERT_EQ(0, storage1_->init());
+        butil::EndPoint ep;
+        ASSERT_EQ(0, butil::str2endpoint(kCopierServerAddr, &ep));
+        storage1_->set_server_addr(ep);
+
+        storage2_ = new CurveSnapshotStorage("./copier_data2");
+        ASSERT_EQ(0, storage2_->set_file_system_adaptor(fs_));
+        ASSERT_EQ(0, storage2_->init());
+        reader1_ = NULL;
+    }
+
+    void TearDown() {
+        if (reader1_) {
+            storage1_->close(reader1_);
+        }
+        delete storage2_;
+        delete storage1_;
+        server_.Stop(0);
+        server_.Join();
+        // copier的参数是全局的，恢复默认值以免影响其他测试
+        CurveSnapshotStorage::set_copier_options(CurveSnapshotCopierOptions());
+    }
+
+    // 在storage1中生成包含fileNum个文件的快照，返回下载用的uri
+    std::string PrepareSnapshot(int fileNum, size_t fileSize) {
+        braft::SnapshotMeta meta;
+        meta.set_last_included_index(1000);
+        meta.set_last_included_term(2);
+        *meta.add_peers() = braft::PeerId("1.2.3.4:1000").to_string();
+
+        braft::SnapshotWriter* writer = storage1_->create();
+        CHECK(writer != NULL);
+        for (int i = 0; i < fileNum; ++i) {
+            write_snapshot_file(fs_, writer->get_path() + "/" + file_name(i),
+                                file_data(i, fileSize));
+            braft::LocalFileMeta fileMeta;
+            fileMeta.set_checksum(std::to_string(i));
+            CHECK_EQ(0, writer->add_file(file_name(i), &fileMeta));
+        }
+        CHECK_EQ(0, writer->save_meta(meta));
+        CHECK_EQ(0, storage1_->close(writer));
+
+        reader1_ = storage1_->open();
+        CHECK(reader1_ != NULL);
+        return reader1_->generate_uri_for_copy();
+    }
+
+    scoped_refptr<braft::PosixFileSystemAdaptor> fs_;
+    brpc::Server server_;
+    CurveSnapshotStorage* storage1_;
+    CurveSnapshotStorage* storage2_;
+    braft::SnapshotReader* reader1_;
+};
+
+TEST(CopysetSnapshotThrottleTest, throttle_without_inner) {
+    // 每秒1000字节，桶容量1000
+    scoped_refptr<CopysetSnapshotThrottle> throttle(
+                new CopysetSnapshotThrottle(NULL, 1000));
+    ASSERT_TRUE(throttle->add_one_more_task(false));
+    throttle->finish_one_task(false);
+
+    // 1. rpc可以透支令牌，透支之后的rpc需要等待
+    ASSERT_EQ(2000, throttle->throttled_by_throughput(2000));
+    ASSERT_EQ(0, throttle->throttled_by_throughput(2000));
+    // 透支了1s的令牌，重试间隔不超过100ms，以便及时响应cancel
+    ASSERT_EQ(100, throttle->get_retry_interval_ms());
+
+    // 2. 没有用完的令牌归还之后可以继续下载
+    throttle->return_unused_throughput(2000, 0, 0);
+    ASSERT_EQ(500, throttle->throttled_by_throughput(500));
+
+    // 3. 透支的令牌补充回来之后可以继续下载
+    ASSERT_EQ(1500, throttle->throttled_by_throughput(1500));
+    ASSERT_EQ(0, throttle->throttled_by_throughput(1000));
+    usleep(1100 * 1000);
+    ASSERT_EQ(1000, throttle->throttled_by_throughput(1000));
+}
+
+TEST(CopysetSnapshotThrottleTest, throttle_with_inner) {
+    scoped_refptr<MockSnapshotThrottle> inner(new MockSnapshotThrottle());
+    scoped_refptr<CopysetSnapshotThrottle> throttle(
+                new CopysetSnapshotThrottle(inner.get(), 1000));
+
+    // 1. chunkserver的throttle限流时不扣除copyset的令牌
+    // 2. copyset透支时不再向chunkserver的throttle申请
+    EXPECT_CALL(*inner, throttled_by_throughput(2000))
+        .Times(2)
+        .WillOnce(Return(0))
+        .WillOnce(Return(1500));
+    ASSERT_EQ(0, throttle->throttled_by_throughput(2000));
+    ASSERT_EQ(1500, throttle->throttled_by_throughput(2000));
+    ASSERT_EQ(0, throttle->throttled_by_throughput(2000));
+
+    // 3. 重试间隔取两者中较大的
+    EXPECT_CALL(*inner, get_retry_interval_ms())
+        .WillOnce(Return(10))
+        .WillOnce(Return(200));
+    ASSERT_EQ(100, throttle->get_retry_interval_ms());
+    ASSERT_EQ(200, throttle->get_retry_interval_ms());
+
+    // 4. 其余的接口交给chunkserver的throttle
+    EXPECT_CALL(*inner, add_one_more_task(true))
+        .WillOnce(Return(false));
+    ASSERT_FALSE(throttle->add_one_more_task(true));
+    EXPECT_CALL(*inner, finish_one_task(true))
+        .Times(1);
+    throttle->finish_one_task(true);
+    EXPECT_CALL(*inner, return_unused_throughput(1500, 500, 10))
+        .Times(1);
+    throttle->return_unused_throughput(1500, 500, 10);
+    // 归还了1000字节的令牌，不再透支
+    EXPECT_CALL(*inner, throttled_by_throughput(100))
+        .WillOnce(Return(100));
+    ASSERT_EQ(100, throttle->throttled_by_throughput(100));
+}
+
+TEST_F(CurveSnapshotCopierTest, copy_files_concurrently) {
+    const size_t kFileNum = 32;
+    const size_t kFileSize = 4096;
+    std::string uri = PrepareSnapshot(kFileNum, kFileSize);
+
+    for (uint32_t concurrency : {0, 1, 4, 64}) {
+        LOG(INFO) << "Copy snapshot with concurrency " << concurrency;
+        CurveSnapshotCopierOptions options;
+        options.copyConcurrency = concurrency;
+        CurveSnapshotStorage::set_copier_options(options);
+
+        // 每次都下载到新的目录
+        fs_->delete_file("copier_data3", true);
+        CurveSnapshotStorage storage("./copier_data3");
+        ASSERT_EQ(0, storage.set_file_system_adaptor(fs_));
+        ASSERT_EQ(0, storage.init());
+        braft::SnapshotReader* reader = storage.copy_from(uri);
+        ASSERT_TRUE(reader != NULL);
+        std::vector<std::string> files;
+        reader->list_files(&files);
+        ASSERT_EQ(kFileNum, files.size());
+        for (size_t i = 0; i < kFileNum; ++i) {
+            braft::LocalFileMeta fileMeta;
+            ASSERT_EQ(0, reader->get_file_meta(file_name(i), &fileMeta));
+            ASSERT_EQ(std::to_string(i), fileMeta.checksum());
+            ASSERT_EQ(file_data(i, kFileSize), read_snapshot_file(fs_,
+                        reader->get_path() + "/" + file_name(i)));
+        }
+        ASSERT_EQ(0, storage.close(reader));
+    }
+}
+
+TEST_F(CurveSnapshotCopierTest, skip_missing_file) {
+    const int kFileNum = 8;
+    const size_t kFileSize = 4096;
+    std::string uri = PrepareSnapshot(kFileNum, kFileSize);
+    // 远端快照中已经不存在的文件不下载，也不加入writer
+    ASSERT_TRUE(fs_->delete_file(reader1_->get_path() + "/" + file_name(3),
+                                 false));
+
+    CurveSnapshotCopierOptions options;
+    options.copyConcurrency = 4;
+    CurveSnapshotStorage::set_copier_options(options);
+    braft::SnapshotReader* reader2 = storage2_->copy_from(uri);
+    ASSERT_TRUE(reader2 != NULL);
+    ASSERT_FALSE(fs_->path_exists(reader2->get_path() + "/" + file_name(3)));
+    for (int i = 0; i < kFileNum; ++i) {
+        if (i == 3) {
+            continue;
+        }
+        ASSERT_EQ(file_data(i, kFileSize), read_snapshot_file(fs_,
+                    reader2->get_path() + "/" + file_name(i)));
+    }
+    ASSERT_EQ(0, storage2_->close(reader2));
+}
+
+TEST_F(CurveSnapshotCopierTest, copyset_throughput) {
+    const int kFileNum = 4;
+    const size_t kFileSize = 32 * 1024;
+    std::string uri = PrepareSnapshot(kFileNum, kFileSize);
+
+    // 每秒64KB，桶容量64KB，下载128KB的数据至少需要1s
+    CurveSnapshotCopierOptions options;
+    options.copyConcurrency = 4;
+    options.throughputBytes = 64 * 1024;
+    CurveSnapshotStorage::set_copier_options(options);
+    uint64_t startUs = curve::common::TimeUtility::GetTimeofDayUs();
+    braft::SnapshotReader* reader2 = storage2_->copy_from(uri);
+    uint64_t costUs = curve::common::TimeUtility::GetTimeofDayUs() - startUs;
+    ASSERT_TRUE(reader2 != NULL);
+    ASSERT_GE(costUs, 900 * 1000);
+    for (int i = 0; i < kFileNum; ++i) {
+        ASSERT_EQ(file_data(i, kFileSize), read_snapshot_file(fs_,
+                    reader2->get_path() + "/" + file_name(i)));
+    }
+    ASSERT_EQ(0, storage2_->close(reader2));
+}
+
+TEST_F(CurveSnapshotCopierTest, cancel_inflight_files) {
+    const int kFileNum = 16;
+    const size_t kFileSize = 256 * 1024;
+    std::string uri = PrepareSnapshot(kFileNum, kFileSize);
+
+    // 限速远小于数据量，cancel时有多个文件正在下载或者等待令牌
+    CurveSnapshotCopierOptions options;
+    options.copyConcurrency = 4;
+    options.throughputBytes = 1024;
+    CurveSnapshotStorage::set_copier_options(options);
+    braft::SnapshotCopier* copier = storage2_->start_to_copy_from(uri);
+    ASSERT_TRUE(copier != NULL);
+    usleep(500 * 1000);
+
+    uint64_t startUs = curve::common::TimeUtility::GetTimeofDayUs();
+    copier->cancel();
+    copier->join();
+    uint64_t costUs = curve::common::TimeUtility::GetTimeofDayUs() - startUs;
+    // 等待令牌的session也要及时退出
+    ASSERT_LT(costUs, 2 * 1000 * 1000);
+    ASSERT_FALSE(copier->ok());
+    ASSERT_EQ(ECANCELED, copier->error_code());
+    ASSERT_TRUE(copier->get_reader() == NULL);
+    ASSERT_EQ(0, storage2_->close(copier));
+    // 没有生成新的快照
+    braft::SnapshotReader* reader2 = storage2_->open();
+    ASSERT_TRUE(reader2 == NULL);
+}
+
+}  // namespace chunkserver
+}  // namespace curve
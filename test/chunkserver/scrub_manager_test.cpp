@@ -0,0 +1,364 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/chunkserver/scrub_manager.h"
+#include "src/common/timeutility.h"
+#include "test/chunkserver/mock_copyset_node_manager.h"
+#include "test/chunkserver/datastore/mock_datastore.h"
+
+namespace curve {
+namespace chunkserver {
+
+using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Return;
+using ::testing::SetArgPointee;
+using ::testing::NotNull;
+using ::curve::common::TimeUtility;
+
+const LogicPoolID kLogicPoolId = 1;
+const CopysetID kCopysetId = 100;
+const uint32_t kChunkSize = 16 * 1024 * 1024;
+const uint32_t kReadSize = 8 * 1024 * 1024;
+const CHUNK_HASH_VERSION kDataHash =
+    CHUNK_HASH_VERSION::CHUNK_HASH_VERSION_DATA;
+
+class MockScrubPeerClient : public ScrubPeerClient {
+ public:
+    MOCK_METHOD8(GetChunkHash, int(const butil::EndPoint&,
+                                   LogicPoolID,
+                                   CopysetID,
+                                   ChunkID,
+                                   off_t,
+                                   size_t,
+                                   std::string*,
+                                   CHUNK_HASH_VERSION*));
+};
+
+class ScrubManagerTest : public ::testing::Test {
+ public:
+    void SetUp() {
+        Configuration conf;
+        ASSERT_EQ(0, conf.parse_from(
+            "127.0.0.1:9000:0,127.0.0.1:9001:0,127.0.0.1:9002:0"));
+        dataStore_ = std::make_shared<MockDataStore>();
+        node_ = std::make_shared<CopysetNode>(kLogicPoolId, kCopysetId, conf);
+        node_->SetCSDateStore(dataStore_);
+        std::vector<CopysetNodePtr> nodes{node_};
+        EXPECT_CALL(nodeManager_, GetAllCopysetNodes(NotNull()))
+            .WillRepeatedly(SetArgPointee<0>(nodes));
+
+        peerClient_ = std::make_shared<MockScrubPeerClient>();
+        options_.copysetNodeManager = &nodeManager_;
+        butil::str2endpoint("127.0.0.1:9000", &options_.localAddr);
+        options_.chunkSize = kChunkSize;
+        options_.readSize = kReadSize;
+        options_.bytesPerSecond = 0;
+        options_.retryTimes = 1;
+        options_.retryIntervalMs = 10;
+        options_.peerClient = peerClient_;
+    }
+
+    void TearDown() {
+        scrubManager_.Fini();
+    }
+
+    bool WaitJobFinished(int32_t jobId, IntegrityJob* job) {
+        for (int i = 0; i < 500; ++i) {
+            std::vector<IntegrityJob> jobs;
+            scrubManager_.ListJobs(&jobs);
+            for (const auto& item : jobs) {
+                if (item.id() == jobId &&
+                    item.state() != INTEGRITY_OP_STATE_WAITING &&
+                    item.state() != INTEGRITY_OP_STATE_RUNNING &&
+                    item.state() != INTEGRITY_OP_STATE_PAUSED) {
+                    *job = item;
+                    return true;
+                }
+            }
+            usleep(10 * 1000);
+        }
+        return false;
+    }
+
+ protected:
+    MockCopysetNodeManager nodeManager_;
+    std::shared_ptr<MockDataStore> dataStore_;
+    std::shared_ptr<CopysetNode> node_;
+    std::shared_ptr<MockScrubPeerClient> peerClient_;
+    ScrubOptions options_;
+    ScrubManager scrubManager_;
+};
+
+TEST_F(ScrubManagerTest, InitTest) {
+    ScrubOptions options = options_;
+    options.copysetNodeManager = nullptr;
+    ASSERT_EQ(-1, scrubManager_.Init(options));
+
+    options = options_;
+    options.readSize = kChunkSize * 2;
+    ASSERT_EQ(-1, scrubManager_.Init(options));
+
+    ASSERT_EQ(0, scrubManager_.Init(options_));
+}
+
+TEST_F(ScrubManagerTest, ConsistentTest) {
+    ASSERT_EQ(0, scrubManager_.Init(options_));
+    ASSERT_EQ(0, scrubManager_.Run());
+
+    // copyset不存在
+    IntegrityJob job;
+    ASSERT_EQ(-1, scrubManager_.ScheduleJob(kCopysetId + 1, &job));
+
+    std::vector<ChunkID> chunks{1, 2};
+    CSChunkInfo info;
+    info.isClone = false;
+    EXPECT_CALL(*dataStore_, ListChunks(NotNull()))
+        .WillOnce(SetArgPointee<0>(chunks));
+    EXPECT_CALL(*dataStore_, GetChunkInfo(_, NotNull()))
+        .Times(2)
+        .WillRepeatedly(DoAll(SetArgPointee<1>(info),
+                              Return(CSErrorCode::Success)));
+    // 每个chunk分两次读取，每次与两个副本比较
+    EXPECT_CALL(*dataStore_, GetChunkDataHash(_, _, kReadSize, NotNull()))
+        .Times(4)
+        .WillRepeatedly(DoAll(SetArgPointee<3>("123"),
+                              Return(CSErrorCode::Success)));
+    EXPECT_CALL(*peerClient_, GetChunkHash(_, kLogicPoolId, kCopysetId,
+                                           _, _, kReadSize, NotNull(),
+                                           NotNull()))
+        .Times(8)
+        .WillRepeatedly(DoAll(SetArgPointee<6>("123"),
+                              SetArgPointee<7>(kDataHash), Return(0)));
+
+    ASSERT_EQ(0, scrubManager_.ScheduleJob(kCopysetId, &job));
+    ASSERT_EQ(kCopysetId, job.copyset());
+    ASSERT_EQ(INTEGRITY_OP_STATE_WAITING, job.state());
+
+    IntegrityJob result;
+    ASSERT_TRUE(WaitJobFinished(job.id(), &result));
+    ASSERT_EQ(INTEGRITY_OP_STATE_FINISHED, result.state());
+    ASSERT_EQ(100, result.progress());
+    ASSERT_EQ(0, result.inconsistent_chunks());
+    ASSERT_GT(result.start_time(), 0);
+}
+
+TEST_F(ScrubManagerTest, InconsistentTest) {
+    ASSERT_EQ(0, scrubManager_.Init(options_));
+    ASSERT_EQ(0, scrubManager_.Run());
+
+    std::vector<ChunkID> chunks{1, 2, 3};
+    CSChunkInfo info;
+    info.isClone = false;
+    CSChunkInfo cloneInfo;
+    cloneInfo.isClone = true;
+    EXPECT_CALL(*dataStore_, ListChunks(NotNull()))
+        .WillOnce(SetArgPointee<0>(chunks));
+    EXPECT_CALL(*dataStore_, GetChunkInfo(1, NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(info),
+                        Return(CSErrorCode::Success)));
+    // 克隆chunk不做校验
+    EXPECT_CALL(*dataStore_, GetChunkInfo(2, NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(cloneInfo),
+                        Return(CSErrorCode::Success)));
+    // 校验前chunk已经被删除
+    EXPECT_CALL(*dataStore_, GetChunkInfo(3, NotNull()))
+        .WillOnce(Return(CSErrorCode::ChunkNotExistError));
+
+    // 第一段与其中一个副本不一致，重试一次仍然不一致，跳过剩余的部分
+    EXPECT_CALL(*dataStore_, GetChunkDataHash(1, 0, kReadSize, NotNull()))
+        .Times(2)
+        .WillRepeatedly(DoAll(SetArgPointee<3>("123"),
+                              Return(CSErrorCode::Success)));
+    EXPECT_CALL(*dataStore_, GetChunkDataHash(1, kReadSize, kReadSize, _))
+        .Times(0);
+    EXPECT_CALL(*peerClient_, GetChunkHash(_, _, _, 1, 0, kReadSize,
+                                           NotNull(), NotNull()))
+        .WillOnce(DoAll(SetArgPointee<6>("123"),
+                        SetArgPointee<7>(kDataHash), Return(0)))
+        .WillOnce(DoAll(SetArgPointee<6>("456"),
+                        SetArgPointee<7>(kDataHash), Return(0)))
+        .WillOnce(DoAll(SetArgPointee<6>("123"),
+                        SetArgPointee<7>(kDataHash), Return(0)))
+        .WillOnce(DoAll(SetArgPointee<6>("456"),
+                        SetArgPointee<7>(kDataHash), Return(0)));
+
+    IntegrityJob job;
+    ASSERT_EQ(0, scrubManager_.ScheduleJob(kCopysetId, &job));
+    IntegrityJob result;
+    ASSERT_TRUE(WaitJobFinished(job.id(), &result));
+    ASSERT_EQ(INTEGRITY_OP_STATE_FAILED, result.state());
+    ASSERT_EQ(100, result.progress());
+    ASSERT_EQ(1, result.inconsistent_chunks());
+}
+
+TEST_F(ScrubManagerTest, RpcFailedTest) {
+    ASSERT_EQ(0, scrubManager_.Init(options_));
+    ASSERT_EQ(0, scrubManager_.Run());
+
+    std::vector<ChunkID> chunks{1};
+    CSChunkInfo info;
+    info.isClone = false;
+    EXPECT_CALL(*dataStore_, ListChunks(NotNull()))
+        .WillOnce(SetArgPointee<0>(chunks));
+    EXPECT_CALL(*dataStore_, GetChunkInfo(1, NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(info),
+                        Return(CSErrorCode::Success)));
+    EXPECT_CALL(*dataStore_, GetChunkDataHash(1, 0, kReadSize, NotNull()))
+        .Times(2)
+        .WillRepeatedly(DoAll(SetArgPointee<3>("123"),
+                              Return(CSErrorCode::Success)));
+    EXPECT_CALL(*peerClient_, GetChunkHash(_, _, _, 1, 0, kReadSize,
+                                           NotNull(), NotNull()))
+        .Times(2)
+        .WillRepeatedly(Return(-1));
+
+    IntegrityJob job;
+    ASSERT_EQ(0, scrubManager_.ScheduleJob(kCopysetId, &job));
+    IntegrityJob result;
+    ASSERT_TRUE(WaitJobFinished(job.id(), &result));
+    ASSERT_EQ(INTEGRITY_OP_STATE_FAILED, result.state());
+    ASSERT_EQ(0, result.inconsistent_chunks());
+}
+
+TEST_F(ScrubManagerTest, OldVersionPeerTest) {
+    ASSERT_EQ(0, scrubManager_.Init(options_));
+    ASSERT_EQ(0, scrubManager_.Run());
+
+    std::vector<ChunkID> chunks{1};
+    CSChunkInfo info;
+    info.isClone = false;
+    EXPECT_CALL(*dataStore_, ListChunks(NotNull()))
+        .WillOnce(SetArgPointee<0>(chunks));
+    EXPECT_CALL(*dataStore_, GetChunkInfo(1, NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(info),
+                        Return(CSErrorCode::Success)));
+    EXPECT_CALL(*dataStore_, GetChunkDataHash(1, _, kReadSize, NotNull()))
+        .Times(2)
+        .WillRepeatedly(DoAll(SetArgPointee<3>("123"),
+                              Return(CSErrorCode::Success)));
+    // 老版本的副本按chunk文件的偏移计算hash，本地按同样的方式计算后比较，
+    // 两个副本都是老版本时每段只计算一次
+    EXPECT_CALL(*dataStore_, GetChunkHash(1, _, kReadSize, NotNull()))
+        .Times(2)
+        .WillRepeatedly(DoAll(SetArgPointee<3>("456"),
+                              Return(CSErrorCode::Success)));
+    EXPECT_CALL(*peerClient_, GetChunkHash(_, _, _, 1, _, kReadSize,
+                                           NotNull(), NotNull()))
+        .Times(4)
+        .WillRepeatedly(DoAll(SetArgPointee<6>("456"),
+                              SetArgPointee<7>(
+                                  CHUNK_HASH_VERSION::CHUNK_HASH_VERSION_FILE),
+                              Return(0)));
+
+    IntegrityJob job;
+    ASSERT_EQ(0, scrubManager_.ScheduleJob(kCopysetId, &job));
+    IntegrityJob result;
+    ASSERT_TRUE(WaitJobFinished(job.id(), &result));
+    ASSERT_EQ(INTEGRITY_OP_STATE_FINISHED, result.state());
+    ASSERT_EQ(0, result.inconsistent_chunks());
+}
+
+TEST_F(ScrubManagerTest, ThrottleTest) {
+    // 每段本地和两个副本各读取kReadSize，两段共6 * kReadSize，
+    // 扣除初始的kReadSize个令牌后需要等待5/6秒；
+    // 只计算本地读取时只需要等待1/6秒
+    options_.bytesPerSecond = 6 * kReadSize;
+    ASSERT_EQ(0, scrubManager_.Init(options_));
+    ASSERT_EQ(0, scrubManager_.Run());
+
+    std::vector<ChunkID> chunks{1};
+    CSChunkInfo info;
+    info.isClone = false;
+    EXPECT_CALL(*dataStore_, ListChunks(NotNull()))
+        .WillOnce(SetArgPointee<0>(chunks));
+    EXPECT_CALL(*dataStore_, GetChunkInfo(1, NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(info),
+                        Return(CSErrorCode::Success)));
+    EXPECT_CALL(*dataStore_, GetChunkDataHash(1, _, kReadSize, NotNull()))
+        .Times(2)
+        .WillRepeatedly(DoAll(SetArgPointee<3>("123"),
+                              Return(CSErrorCode::Success)));
+    EXPECT_CALL(*peerClient_, GetChunkHash(_, _, _, 1, _, kReadSize,
+                                           NotNull(), NotNull()))
+        .Times(4)
+        .WillRepeatedly(DoAll(SetArgPointee<6>("123"),
+                              SetArgPointee<7>(kDataHash), Return(0)));
+
+    uint64_t startMs = TimeUtility::GetTimeofDayMs();
+    IntegrityJob job;
+    ASSERT_EQ(0, scrubManager_.ScheduleJob(kCopysetId, &job));
+    IntegrityJob result;
+    ASSERT_TRUE(WaitJobFinished(job.id(), &result));
+    ASSERT_EQ(INTEGRITY_OP_STATE_FINISHED, result.state());
+    ASSERT_GE(TimeUtility::GetTimeofDayMs() - startMs, 600);
+}
+
+TEST_F(ScrubManagerTest, JobStateTest) {
+    ASSERT_EQ(0, scrubManager_.Init(options_));
+
+    // 未启动时任务保持等待
+    IntegrityJob job1;
+    IntegrityJob job2;
+    ASSERT_EQ(0, scrubManager_.ScheduleJob(kCopysetId, &job1));
+    ASSERT_EQ(0, scrubManager_.ScheduleJob(kCopysetId, &job2));
+    ASSERT_NE(job1.id(), job2.id());
+
+    // 任务不存在
+    ASSERT_EQ(-1, scrubManager_.PauseJob(job2.id() + 1));
+    ASSERT_EQ(-1, scrubManager_.ResumeJob(job2.id() + 1));
+    ASSERT_EQ(-1, scrubManager_.CancelJob(job2.id() + 1));
+
+    // 暂停未开始的任务，恢复后重新等待
+    ASSERT_EQ(0, scrubManager_.PauseJob(job1.id()));
+    ASSERT_EQ(-1, scrubManager_.PauseJob(job1.id()));
+    std::vector<IntegrityJob> jobs;
+    scrubManager_.ListJobs(&jobs);
+    ASSERT_EQ(2, jobs.size());
+    ASSERT_EQ(INTEGRITY_OP_STATE_PAUSED, jobs[0].state());
+    ASSERT_EQ(0, scrubManager_.ResumeJob(job1.id()));
+    ASSERT_EQ(-1, scrubManager_.ResumeJob(job1.id()));
+    scrubManager_.ListJobs(&jobs);
+    ASSERT_EQ(INTEGRITY_OP_STATE_WAITING, jobs[0].state());
+
+    // 取消的任务不再执行，也不能恢复
+    ASSERT_EQ(0, scrubManager_.CancelJob(job1.id()));
+    ASSERT_EQ(0, scrubManager_.CancelJob(job2.id()));
+    ASSERT_EQ(-1, scrubManager_.CancelJob(job2.id()));
+    ASSERT_EQ(-1, scrubManager_.ResumeJob(job2.id()));
+    EXPECT_CALL(*dataStore_, ListChunks(_))
+        .Times(0);
+    ASSERT_EQ(0, scrubManager_.Run());
+    usleep(100 * 1000);
+    scrubManager_.ListJobs(&jobs);
+    ASSERT_EQ(INTEGRITY_OP_STATE_CANCELED, jobs[0].state());
+    ASSERT_EQ(INTEGRITY_OP_STATE_CANCELED, jobs[1].state());
+}
+
+}  // namespace chunkserver
+}  // namespace curve
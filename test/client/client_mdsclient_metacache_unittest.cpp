@@ -46,6 +46,7 @@
 #include "src/client/service_helper.h"
 #include "src/client/mds_client.h"
 #include "src/client/config_info.h"
+#include "src/client/segment_prefetcher.h"
 #include "test/client/fake/fakeMDS.h"
 #include "src/client/metacache_struct.h"
 #include "src/common/net_common.h"
@@ -1084,6 +1085,211 @@ TEST_F(MDSClientTest, GetOrAllocateSegment) {
     delete faktopologyeret;
 }
 
+TEST_F(MDSClientTest, GetSegments) {
+    curve::client::FInfo_t fi;
+    fi.userinfo = userinfo;
+    fi.fullPathName = "/1_userinfo_";
+    fi.chunksize   = 4 * 1024 * 1024;
+    fi.segmentsize = 1 * 1024 * 1024 * 1024ul;
+
+    // 1. 认证失败
+    curve::mds::GetSegmentsResponse authFailResp;
+    authFailResp.set_statuscode(::curve::mds::StatusCode::kOwnerAuthFail);
+    FakeReturn* authFailRet = new FakeReturn(nullptr,
+                static_cast<void*>(&authFailResp));
+    curvefsservice.SetGetSegmentsFakeReturn(authFailRet);
+
+    std::vector<SegmentInfo> segInfos;
+    ASSERT_EQ(LIBCURVE_ERROR::AUTHFAIL,
+              mdsclient_.GetSegments(0, 4, false, &fi, &segInfos));
+
+    // 2. 只返回已经分配的segment
+    curve::mds::GetSegmentsResponse response;
+    response.set_statuscode(::curve::mds::StatusCode::kOK);
+    for (int i = 0; i < 2; i++) {
+        auto pfs = response.add_pagefilesegments();
+        pfs->set_logicalpoolid(1234);
+        pfs->set_segmentsize(fi.segmentsize);
+        pfs->set_chunksize(fi.chunksize);
+        pfs->set_startoffset(2 * i * fi.segmentsize);
+        for (int j = 0; j < 4; j++) {
+            auto chunk = pfs->add_chunks();
+            chunk->set_copysetid(j);
+            chunk->set_chunkid(i * 4 + j);
+        }
+    }
+    FakeReturn* fakeret = new FakeReturn(nullptr,
+                static_cast<void*>(&response));
+    curvefsservice.SetGetSegmentsFakeReturn(fakeret);
+
+    ASSERT_EQ(LIBCURVE_ERROR::OK,
+              mdsclient_.GetSegments(0, 4, false, &fi, &segInfos));
+    ASSERT_FALSE(curvefsservice.GetSegmentsAllocate());
+    ASSERT_EQ(2, segInfos.size());
+    for (int i = 0; i < 2; i++) {
+        ASSERT_EQ(2 * i * fi.segmentsize, segInfos[i].startoffset);
+        ASSERT_EQ(1234, segInfos[i].lpcpIDInfo.lpid);
+        ASSERT_EQ(4, segInfos[i].chunkvec.size());
+        ASSERT_EQ(4, segInfos[i].lpcpIDInfo.cpidVec.size());
+        for (int j = 0; j < 4; j++) {
+            ASSERT_EQ(i * 4 + j, segInfos[i].chunkvec[j].cid_);
+            ASSERT_EQ(j, segInfos[i].chunkvec[j].cpid_);
+        }
+    }
+
+    // 3. 请求mds分配未分配的segment
+    ASSERT_EQ(LIBCURVE_ERROR::OK,
+              mdsclient_.GetSegments(0, 4, true, &fi, &segInfos));
+    ASSERT_TRUE(curvefsservice.GetSegmentsAllocate());
+
+    curvefsservice.SetGetSegmentsFakeReturn(nullptr);
+    delete authFailRet;
+    delete fakeret;
+}
+
+TEST_F(MDSClientTest, SegmentPrefetch) {
+    curve::client::FInfo_t fi;
+    fi.userinfo = userinfo;
+    fi.fullPathName = "/1_userinfo_";
+    fi.chunksize   = 4 * 1024 * 1024;
+    fi.segmentsize = 1 * 1024 * 1024 * 1024ul;
+    fi.length = 10 * fi.segmentsize;
+
+    // 第二个segment已经分配
+    curve::mds::GetSegmentsResponse response;
+    response.set_statuscode(::curve::mds::StatusCode::kOK);
+    auto pfs = response.add_pagefilesegments();
+    pfs->set_logicalpoolid(1234);
+    pfs->set_segmentsize(fi.segmentsize);
+    pfs->set_chunksize(fi.chunksize);
+    pfs->set_startoffset(fi.segmentsize);
+    for (int i = 0; i < 4; i++) {
+        auto chunk = pfs->add_chunks();
+        chunk->set_copysetid(i);
+        chunk->set_chunkid(i);
+    }
+    FakeReturn* fakeret = new FakeReturn(nullptr,
+                static_cast<void*>(&response));
+    curvefsservice.SetGetSegmentsFakeReturn(fakeret);
+
+    ::curve::mds::topology::GetChunkServerListInCopySetsResponse response_1;
+    response_1.set_statuscode(0);
+    uint64_t chunkserveridc = 1;
+    for (int i = 0; i < 4; i++) {
+        auto csinfo = response_1.add_csinfo();
+        csinfo->set_copysetid(i);
+
+        for (int j = 0; j < 3; j++) {
+            auto cslocs = csinfo->add_cslocs();
+            cslocs->set_chunkserverid(chunkserveridc++);
+            cslocs->set_hostip("127.0.0.1");
+            cslocs->set_port(5000 + j);
+        }
+    }
+    FakeReturn* faktopologyeret = new FakeReturn(nullptr,
+        static_cast<void*>(&response_1));
+    topologyservice.SetFakeReturn(faktopologyeret);
+
+    MetaCacheOption mcOpt;
+    mcOpt.metacacheGetLeaderRetry = 1;
+    mcOpt.metacacheGetLeaderRPCTimeOutMS = 10;
+    curve::client::MetaCache mc;
+    mc.Init(mcOpt, &mdsclient_);
+    mc.UpdateFileInfo(fi);
+
+    SegmentPrefetchOption opt;
+    opt.enableSegmentPrefetch = true;
+    opt.prefetchSegmentNum = 4;
+    SegmentPrefetcher prefetcher;
+    ASSERT_EQ(0, prefetcher.Init(opt, &mc, &mdsclient_));
+
+    // 1. 随机IO不预取
+    curvefsservice.CleanRetryTimes();
+    prefetcher.OnIO(4096, 4096, OpType::READ);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    ASSERT_EQ(0, curvefsservice.GetRetryTimes());
+
+    // 2. 顺序IO预取之后的segment，chunk和copyset信息更新到metacache
+    prefetcher.OnIO(8192, 4096, OpType::READ);
+    ChunkIDInfo_t cinfo;
+    int retry = 0;
+    while (mc.GetChunkInfoByIndex(256, &cinfo) != MetaCacheErrorType::OK &&
+           retry++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    prefetcher.UnInit();
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(MetaCacheErrorType::OK,
+                  mc.GetChunkInfoByIndex(256 + i, &cinfo));
+        ASSERT_EQ(1234, cinfo.lpid_);
+        ASSERT_EQ(i, cinfo.cpid_);
+        ASSERT_EQ(i, cinfo.cid_);
+        ASSERT_TRUE(mc.GetServerList(1234, i).IsValid());
+    }
+    // 未分配的segment没有缓存
+    ASSERT_EQ(MetaCacheErrorType::CHUNKINFO_NOT_FOUND,
+              mc.GetChunkInfoByIndex(512, &cinfo));
+    ASSERT_EQ(1, curvefsservice.GetRetryTimes());
+    ASSERT_FALSE(curvefsservice.GetSegmentsAllocate());
+
+    // 3. 开启预分配后，顺序写预取时请求mds分配segment，顺序读不分配
+    curve::client::MetaCache mc2;
+    mc2.Init(mcOpt, &mdsclient_);
+    mc2.UpdateFileInfo(fi);
+    opt.prefetchAllocateSegment = true;
+    SegmentPrefetcher writePrefetcher;
+    ASSERT_EQ(0, writePrefetcher.Init(opt, &mc2, &mdsclient_));
+    curvefsservice.CleanRetryTimes();
+    writePrefetcher.OnIO(4096, 4096, OpType::WRITE);
+    writePrefetcher.OnIO(8192, 4096, OpType::WRITE);
+    retry = 0;
+    while (curvefsservice.GetRetryTimes() == 0 && retry++ < 100) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    writePrefetcher.UnInit();
+    ASSERT_EQ(1, curvefsservice.GetRetryTimes());
+    ASSERT_TRUE(curvefsservice.GetSegmentsAllocate());
+
+    curvefsservice.SetGetSegmentsFakeReturn(nullptr);
+    delete fakeret;
+    delete faktopologyeret;
+}
+
+TEST_F(MDSClientTest, ChunkInfoEpoch) {
+    MetaCacheOption mcOpt;
+    curve::client::MetaCache mc;
+    mc.Init(mcOpt, &mdsclient_);
+
+    std::vector<ChunkIDInfo> cinfos;
+    for (int i = 0; i < 4; i++) {
+        cinfos.emplace_back(i + 1, 1234, i);
+    }
+
+    // 1. 版本没有变化，chunk信息更新到metacache
+    uint64_t epoch = mc.GetChunkInfoEpoch();
+    ASSERT_TRUE(mc.UpdateChunkInfoIfEpochMatch(256, cinfos, epoch));
+    ChunkIDInfo_t cinfo;
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(MetaCacheErrorType::OK,
+                  mc.GetChunkInfoByIndex(256 + i, &cinfo));
+        ASSERT_EQ(i + 1, cinfo.cid_);
+        ASSERT_TRUE(cinfo.chunkExist);
+    }
+
+    // 2. 获取chunk信息之后chunk被置为未分配，旧的信息不能写回metacache
+    epoch = mc.GetChunkInfoEpoch();
+    mc.InvalidateChunkInfoByIndex(256, 4);
+    ASSERT_EQ(epoch + 1, mc.GetChunkInfoEpoch());
+    ASSERT_FALSE(mc.UpdateChunkInfoIfEpochMatch(256, cinfos, epoch));
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(MetaCacheErrorType::OK,
+                  mc.GetChunkInfoByIndex(256 + i, &cinfo));
+        ASSERT_EQ(0, cinfo.cid_);
+        ASSERT_FALSE(cinfo.chunkExist);
+    }
+}
+
 TEST_F(MDSClientTest, GetServerList) {
     brpc::Server server;
 
@@ -88,6 +88,8 @@ class FakeMDSCurveFSService : public curve::mds::CurveFSService {
  public:
     FakeMDSCurveFSService() {
         retrytimes_ = 0;
+        fakeGetSegmentsret_ = nullptr;
+        getSegmentsAllocate_ = false;
     }
 
     void ListClient(::google::protobuf::RpcController* controller,
@@ -201,6 +203,30 @@ class FakeMDSCurveFSService : public curve::mds::CurveFSService {
         response->CopyFrom(*resp);
     }
 
+    void GetSegments(::google::protobuf::RpcController* controller,
+                     const ::curve::mds::GetSegmentsRequest* request,
+                     ::curve::mds::GetSegmentsResponse* response,
+                     ::google::protobuf::Closure* done) {
+        brpc::ClosureGuard done_guard(done);
+        getSegmentsAllocate_ = request->allocateifnotexist();
+        // 没有设置返回值时返回空的结果，使开启了预取的测试不受影响
+        if (fakeGetSegmentsret_ == nullptr) {
+            response->set_statuscode(::curve::mds::StatusCode::kOK);
+            return;
+        }
+
+        if (fakeGetSegmentsret_->controller_ != nullptr &&
+             fakeGetSegmentsret_->controller_->Failed()) {
+            controller->SetFailed("failed");
+        }
+
+        retrytimes_++;
+
+        auto resp = static_cast<::curve::mds::GetSegmentsResponse*>(
+                    fakeGetSegmentsret_->response_);
+        response->CopyFrom(*resp);
+    }
+
     void OpenFile(::google::protobuf::RpcController* controller,
                 const ::curve::mds::OpenFileRequest* request,
                 ::curve::mds::OpenFileResponse* response,
@@ -610,6 +636,15 @@ class FakeMDSCurveFSService : public curve::mds::CurveFSService {
         fakeGetOrAllocateSegmentretForClone_ = fakeret;
     }
 
+    void SetGetSegmentsFakeReturn(FakeReturn* fakeret) {
+        fakeGetSegmentsret_ = fakeret;
+    }
+
+    // 最近一次GetSegments请求是否要求分配segment
+    bool GetSegmentsAllocate() {
+        return getSegmentsAllocate_;
+    }
+
     void SetOpenFile(FakeReturn* fakeret) {
         fakeopenfile_ = fakeret;
     }
@@ -717,6 +752,8 @@ class FakeMDSCurveFSService : public curve::mds::CurveFSService {
     FakeReturn* fakeGetAllocatedSizeRet_;
     FakeReturn* fakeGetOrAllocateSegmentret_;
     FakeReturn* fakeGetOrAllocateSegmentretForClone_;
+    FakeReturn* fakeGetSegmentsret_;
+    bool getSegmentsAllocate_;
     FakeReturn* fakeopenfile_;
     FakeReturn* fakeclosefile_;
     FakeReturn* fakerenamefile_;
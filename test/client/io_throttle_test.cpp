@@ -0,0 +1,110 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "proto/nameserver2.pb.h"
+#include "src/client/io_throttle.h"
+#include "src/client/service_helper.h"
+
+namespace curve {
+namespace client {
+
+TEST(IOThrottleTest, NoLimitTest) {
+    IOThrottle throttle;
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_EQ(0, throttle.Acquire(4 * 1024 * 1024));
+    }
+
+    // 参数全为0时不限速
+    ThrottleParams params;
+    throttle.UpdateParams(params);
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_EQ(0, throttle.Acquire(4 * 1024 * 1024));
+    }
+}
+
+TEST(IOThrottleTest, LimitTest) {
+    IOThrottle throttle;
+
+    // iops限制为100，每个IO需要等待10ms
+    ThrottleParams params;
+    params.iopsLimit = 100;
+    throttle.UpdateParams(params);
+    uint64_t waitUs = throttle.Acquire(4096);
+    ASSERT_GT(waitUs, 5000);
+    ASSERT_LE(waitUs, 10000);
+    waitUs = throttle.Acquire(4096);
+    ASSERT_GT(waitUs, 15000);
+    ASSERT_LE(waitUs, 20000);
+
+    // 同时限制bps时取等待时间较长的一个
+    params.bpsLimit = 1024 * 1024;
+    throttle.UpdateParams(params);
+    waitUs = throttle.Acquire(4 * 1024 * 1024);
+    ASSERT_GT(waitUs, 3900000);
+    ASSERT_LE(waitUs, 4000000);
+
+    // 取消限速
+    throttle.UpdateParams(ThrottleParams());
+    ASSERT_EQ(0, throttle.Acquire(4 * 1024 * 1024));
+}
+
+TEST(IOThrottleTest, BurstTest) {
+    IOThrottle throttle;
+
+    ThrottleParams params;
+    params.iopsLimit = 1000;
+    params.iopsBurst = 2000;
+    throttle.UpdateParams(params);
+
+    // 空闲时积攒令牌，突发的IO不需要等待
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    for (int i = 0; i < 1400; ++i) {
+        ASSERT_EQ(0, throttle.Acquire(4096));
+    }
+}
+
+TEST(IOThrottleTest, ProtoParamsTest) {
+    curve::mds::FileInfo protoInfo;
+    FInfo fi;
+    ServiceHelper::ProtoFileInfo2Local(&protoInfo, &fi);
+    ASSERT_EQ(0, fi.throttleParams.iopsLimit);
+    ASSERT_EQ(0, fi.throttleParams.bpsLimit);
+
+    auto params = protoInfo.mutable_throttleparams();
+    params->set_iopslimit(100);
+    params->set_iopsburst(200);
+    params->set_bpslimit(1024);
+    params->set_bpsburst(2048);
+    ServiceHelper::ProtoFileInfo2Local(&protoInfo, &fi);
+    ASSERT_EQ(100, fi.throttleParams.iopsLimit);
+    ASSERT_EQ(200, fi.throttleParams.iopsBurst);
+    ASSERT_EQ(1024, fi.throttleParams.bpsLimit);
+    ASSERT_EQ(2048, fi.throttleParams.bpsBurst);
+}
+
+}   // namespace client
+}   // namespace curve
@@ -0,0 +1,196 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "src/common/compressed_object.h"
+
+namespace curve {
+namespace common {
+
+namespace {
+
+// 按frameSize切分压缩，返回压缩对象
+std::string BuildObject(CompressType type, uint32_t frameSize,
+                        const std::string &data) {
+    std::vector<uint32_t> frameLens;
+    std::string frames;
+    for (size_t off = 0; off < data.size(); off += frameSize) {
+        std::string frame;
+        CompressFrame(type, data.data() + off, frameSize, &frame);
+        frameLens.push_back(frame.size());
+        frames += frame;
+    }
+    CompressedObjectHeader header(type, frameSize, frameLens);
+    std::string object;
+    header.Encode(&object);
+    return object + frames;
+}
+
+// 测试中原始数据长度的上限
+const uint64_t kMaxDataLength = 16 * 1024 * 1024;
+
+}  // namespace
+
+TEST(CompressedObjectTest, test_string_to_type) {
+    CompressType type;
+    ASSERT_TRUE(StringToCompressType("none", &type));
+    ASSERT_EQ(CompressType::None, type);
+    ASSERT_TRUE(StringToCompressType("snappy", &type));
+    ASSERT_EQ(CompressType::Snappy, type);
+    ASSERT_FALSE(StringToCompressType("lz4", &type));
+}
+
+TEST(CompressedObjectTest, test_header_encode_decode) {
+    CompressedObjectHeader header(CompressType::Snappy, 4096,
+                                  {100, 4096, 200});
+    std::string buf;
+    header.Encode(&buf);
+    ASSERT_EQ(header.GetHeaderLength(), buf.size());
+    ASSERT_EQ(buf.size(),
+              CompressedObjectHeader::GetHeaderLength(buf.data(), buf.size(),
+                                                      kMaxDataLength));
+
+    CompressedObjectHeader decoded;
+    ASSERT_TRUE(decoded.Decode(buf.data(), buf.size(), kMaxDataLength));
+    ASSERT_EQ(CompressType::Snappy, decoded.GetType());
+    ASSERT_EQ(4096, decoded.GetFrameSize());
+    ASSERT_EQ(3, decoded.GetFrameNum());
+    ASSERT_EQ(3 * 4096, decoded.GetDataLength());
+    ASSERT_EQ(buf.size(), decoded.GetFrameOffset(0));
+    ASSERT_EQ(buf.size() + 100, decoded.GetFrameOffset(1));
+    ASSERT_EQ(buf.size() + 4396, decoded.GetFrameOffset(3));
+
+    // 1. header不完整
+    ASSERT_FALSE(decoded.Decode(buf.data(), buf.size() - 1, kMaxDataLength));
+    // 2. crc不匹配
+    std::string broken = buf;
+    broken[broken.size() - 1] ^= 0x1;
+    ASSERT_FALSE(decoded.Decode(broken.data(), broken.size(),
+                                kMaxDataLength));
+    // 3. 未压缩的旧对象
+    std::string raw(4096, 'a');
+    ASSERT_TRUE(CompressedObjectHeader::HasMagic(broken.data(),
+                                                 broken.size()));
+    ASSERT_FALSE(CompressedObjectHeader::HasMagic(raw.data(), raw.size()));
+    ASSERT_EQ(0, CompressedObjectHeader::GetHeaderLength(raw.data(),
+                                                         raw.size(),
+                                                         kMaxDataLength));
+    ASSERT_FALSE(decoded.Decode(raw.data(), raw.size(), kMaxDataLength));
+    // 4. 原始数据超过上限
+    ASSERT_EQ(0, CompressedObjectHeader::GetHeaderLength(buf.data(),
+                                                         buf.size(),
+                                                         3 * 4096 - 1));
+    ASSERT_FALSE(decoded.Decode(buf.data(), buf.size(), 3 * 4096 - 1));
+}
+
+TEST(CompressedObjectTest, test_invalid_frame_num) {
+    CompressedObjectHeader header(CompressType::Snappy, 4096, {100});
+    std::string buf;
+    header.Encode(&buf);
+
+    // 1. frameNum为最大值时，header长度不能溢出，也不能按照frameNum分配内存
+    std::string broken = buf;
+    memset(&broken[16], 0xff, 4);
+    ASSERT_EQ(0, CompressedObjectHeader::GetHeaderLength(broken.data(),
+                                                         broken.size(),
+                                                         kMaxDataLength));
+    CompressedObjectHeader decoded;
+    ASSERT_FALSE(decoded.Decode(broken.data(), broken.size(),
+                                kMaxDataLength));
+    // 原始数据长度的上限本身也不能让header长度溢出
+    ASSERT_EQ(0, CompressedObjectHeader::GetHeaderLength(broken.data(),
+                                                         broken.size(),
+                                                         UINT64_MAX));
+
+    // 2. frameSize为0
+    broken = buf;
+    memset(&broken[12], 0, 4);
+    ASSERT_EQ(0, CompressedObjectHeader::GetHeaderLength(broken.data(),
+                                                         broken.size(),
+                                                         kMaxDataLength));
+}
+
+TEST(CompressedObjectTest, test_frame_range) {
+    CompressedObjectHeader header(CompressType::Snappy, 4096,
+                                  {100, 100, 100, 100});
+    uint32_t begin, end;
+    ASSERT_TRUE(header.GetFrameRange(0, 4096, &begin, &end));
+    ASSERT_EQ(0, begin);
+    ASSERT_EQ(1, end);
+    ASSERT_TRUE(header.GetFrameRange(4095, 2, &begin, &end));
+    ASSERT_EQ(0, begin);
+    ASSERT_EQ(2, end);
+    ASSERT_TRUE(header.GetFrameRange(8192, 8192, &begin, &end));
+    ASSERT_EQ(2, begin);
+    ASSERT_EQ(4, end);
+    ASSERT_FALSE(header.GetFrameRange(8192, 8193, &begin, &end));
+    ASSERT_FALSE(header.GetFrameRange(0, 0, &begin, &end));
+}
+
+TEST(CompressedObjectTest, test_ranged_read) {
+    const uint32_t frameSize = 4096;
+    // 前两个frame可压缩，后两个frame不可压缩
+    std::string data(2 * frameSize, 'a');
+    unsigned int seed = 1;
+    for (uint32_t i = 0; i < 2 * frameSize; ++i) {
+        data.push_back(static_cast<char>(rand_r(&seed)));
+    }
+
+    std::string object = BuildObject(CompressType::Snappy, frameSize, data);
+    ASSERT_LT(object.size(), data.size());
+
+    CompressedObjectHeader header;
+    uint32_t headerLen = CompressedObjectHeader::GetHeaderLength(
+        object.data(), object.size(), kMaxDataLength);
+    ASSERT_GT(headerLen, 0);
+    ASSERT_TRUE(header.Decode(object.data(), headerLen, kMaxDataLength));
+    ASSERT_LT(header.GetFrameOffset(1) - header.GetFrameOffset(0),
+              frameSize);
+    ASSERT_EQ(frameSize, header.GetFrameOffset(3) - header.GetFrameOffset(2));
+
+    std::vector<std::pair<uint64_t, uint64_t>> ranges = {
+        {0, data.size()}, {0, 1}, {100, frameSize}, {frameSize - 1, 2},
+        {frameSize + 10, 2 * frameSize}, {3 * frameSize, frameSize}};
+    for (const auto &range : ranges) {
+        uint32_t begin, end;
+        ASSERT_TRUE(header.GetFrameRange(range.first, range.second,
+                                         &begin, &end));
+        std::string buf(range.second, 0);
+        ASSERT_TRUE(header.DecompressFrames(
+            object.data() + header.GetFrameOffset(begin), begin, end,
+            range.first, range.second, &buf[0]));
+        ASSERT_EQ(data.substr(range.first, range.second), buf);
+    }
+
+    // 压缩数据损坏
+    std::string broken(header.GetFrameOffset(1) - header.GetFrameOffset(0),
+                       'x');
+    std::string buf(frameSize, 0);
+    ASSERT_FALSE(header.DecompressFrames(broken.data(), 0, 1,
+                                         0, frameSize, &buf[0]));
+}
+
+}  // namespace common
+}  // namespace curve
@@ -0,0 +1,61 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "src/common/copyset_fingerprint.h"
+
+namespace curve {
+namespace common {
+
+TEST(CopySetFingerprintTest, basic) {
+    ::curve::mds::heartbeat::CopySetInfo info;
+    info.set_logicalpoolid(1);
+    info.set_copysetid(1);
+    info.set_epoch(2);
+    for (int i = 1; i <= 3; i++) {
+        std::string ip = "127.0.0." + std::to_string(i) + ":8200:0";
+        info.add_peers()->set_address(ip);
+    }
+    info.mutable_leaderpeer()->set_address("127.0.0.1:8200:0");
+    uint32_t fingerprint = CopySetFingerprint(info);
+
+    // 1. 性能统计不影响摘要
+    auto stats = info.mutable_stats();
+    stats->set_readrate(1);
+    stats->set_writerate(1);
+    stats->set_readiops(1);
+    stats->set_writeiops(1);
+    ASSERT_EQ(fingerprint, CopySetFingerprint(info));
+
+    // 2. epoch变化
+    info.set_epoch(3);
+    uint32_t newFingerprint = CopySetFingerprint(info);
+    ASSERT_NE(fingerprint, newFingerprint);
+
+    // 3. leader变化
+    info.mutable_leaderpeer()->set_address("127.0.0.2:8200:0");
+    ASSERT_NE(newFingerprint, CopySetFingerprint(info));
+}
+
+}  // namespace common
+}  // namespace curve
@@ -0,0 +1,92 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include "src/common/token_bucket.h"
+
+namespace curve {
+namespace common {
+
+TEST(TokenBucketTest, test_unlimited) {
+    TokenBucket bucket(0, 0);
+    ASSERT_EQ(0, bucket.Acquire(1024 * 1024));
+    ASSERT_TRUE(bucket.TryAcquire(1024 * 1024));
+}
+
+TEST(TokenBucketTest, test_acquire) {
+    // 每秒1000个令牌，桶容量100
+    TokenBucket bucket(1000, 100);
+
+    // 1. 桶中的令牌足够
+    ASSERT_EQ(0, bucket.Acquire(100));
+
+    // 2. 令牌不足时透支，返回偿还透支需要的时间
+    uint64_t waitUs = bucket.Acquire(100);
+    ASSERT_GT(waitUs, 90 * 1000);
+    ASSERT_LE(waitUs, 100 * 1000);
+    ASSERT_FALSE(bucket.TryAcquire(1));
+
+    // 3. 等待之后令牌重新补充
+    usleep(waitUs + 20 * 1000);
+    ASSERT_TRUE(bucket.TryAcquire(1));
+
+    // 4. 令牌最多积攒到桶的容量
+    usleep(300 * 1000);
+    ASSERT_FALSE(bucket.TryAcquire(101));
+    ASSERT_TRUE(bucket.TryAcquire(100));
+}
+
+TEST(TokenBucketTest, test_return) {
+    // 每秒1000个令牌，桶容量100
+    TokenBucket bucket(1000, 100);
+
+    // 1. 归还透支的令牌之后不再需要等待
+    ASSERT_EQ(0, bucket.Acquire(100));
+    ASSERT_GT(bucket.Acquire(100), 0);
+    bucket.Return(100);
+    ASSERT_EQ(0, bucket.Acquire(0));
+
+    // 2. 归还的令牌不超过桶的容量
+    bucket.Return(1000);
+    ASSERT_FALSE(bucket.TryAcquire(101));
+    ASSERT_TRUE(bucket.TryAcquire(100));
+}
+
+TEST(TokenBucketTest, test_set_rate) {
+    TokenBucket bucket(1000, 0);
+    ASSERT_EQ(1000, bucket.GetRate());
+    ASSERT_EQ(0, bucket.Acquire(1000));
+
+    // 透支的令牌在修改限速后按照新的速度偿还
+    bucket.SetRate(10000, 0);
+    ASSERT_EQ(10000, bucket.GetRate());
+    uint64_t waitUs = bucket.Acquire(1000);
+    ASSERT_GT(waitUs, 90 * 1000);
+    ASSERT_LE(waitUs, 100 * 1000);
+
+    // 关闭限速
+    bucket.SetRate(0, 0);
+    ASSERT_EQ(0, bucket.Acquire(1000000));
+}
+
+}  // namespace common
+}  // namespace curve
@@ -0,0 +1,304 @@
+/*
+ *  Copyright (c) 2020 NetEase Inc.
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ */
+
+/*
+ * Project: curve
+ */
+
+#include <gtest/gtest.h>
+#include <glog/logging.h>
+#include <fcntl.h>
+#include <butil/iobuf.h>
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "src/common/concurrent/count_down_event.h"
+#include "src/fs/ext4_filesystem_impl.h"
+#include "src/fs/io_uring_filesystem_impl.h"
+
+namespace curve {
+namespace fs {
+
+using ::curve::common::CountDownEvent;
+
+const char kTestFile[] = "./io_uring_test_file";  // NOLINT
+
+class IoUringFileSystemTest : public testing::Test {
+ public:
+    void SetUp() {
+        // ext4 的单测会替换posix wrapper，这里恢复为真实的实现
+        Ext4FileSystemImpl::getInstance()->SetPosixWrapper(
+            std::make_shared<PosixWrapper>());
+        lfs = IoUringFileSystemImpl::getInstance();
+        LocalFileSystemOption option;
+        option.ioUringQueueDepth = 8;
+        option.ioUringFixedBufferNum = 2;
+        option.ioUringFixedBufferSize = 8192;
+        // 内核不支持io_uring的环境下跳过
+        supported = (lfs->Init(option) == 0);
+        if (supported) {
+            fd = lfs->Open(kTestFile, O_RDWR | O_CREAT);
+            ASSERT_GE(fd, 0);
+        }
+    }
+
+    void TearDown() {
+        if (supported) {
+            lfs->Close(fd);
+            lfs->Delete(kTestFile);
+        }
+    }
+
+ protected:
+    std::shared_ptr<IoUringFileSystemImpl> lfs;
+    bool supported;
+    int fd;
+};
+
+TEST_F(IoUringFileSystemTest, ReadWriteTest) {
+    if (!supported) {
+        LOG(WARNING) << "io_uring is not supported, skip.";
+        return;
+    }
+    // 通过char*写入
+    std::string data(4096, 'a');
+    ASSERT_EQ(4096, lfs->Write(fd, data.c_str(), 0, 4096));
+    std::string readData(4096, 0);
+    ASSERT_EQ(4096, lfs->Read(fd, &readData[0], 0, 4096));
+    ASSERT_EQ(data, readData);
+
+    // 通过IOBuf写入，直接以IOBuf的block作为iovec提交
+    butil::IOBuf buf;
+    std::string data2(8192, 'b');
+    buf.append(data2);
+    ASSERT_EQ(8192, lfs->Write(fd, buf, 4096, 8192));
+    std::string readData2(8192, 0);
+    ASSERT_EQ(8192, lfs->Read(fd, &readData2[0], 4096, 8192));
+    ASSERT_EQ(data2, readData2);
+
+    // 通过IOBuf写入，多个block
+    butil::IOBuf buf3;
+    std::string data3(16384, 'c');
+    buf3.append(data3);
+    ASSERT_EQ(16384, lfs->Write(fd, buf3, 0, 16384));
+    std::string readData3(16384, 0);
+    ASSERT_EQ(16384, lfs->Read(fd, &readData3[0], 0, 16384));
+    ASSERT_EQ(data3, readData3);
+
+    // 直接读到IOBuf中，长度大于固定buffer，不使用固定buffer
+    butil::IOBuf readBuf;
+    ASSERT_EQ(16384, lfs->ReadToIOBuf(fd, &readBuf, 0, 16384));
+    ASSERT_EQ(data3, readBuf.to_string());
+
+    // 读超过文件长度的位置返回0
+    char eof[16];
+    ASSERT_EQ(0, lfs->Read(fd, eof, 1ULL << 30, sizeof(eof)));
+
+    // 非法fd
+    ASSERT_EQ(-EBADF, lfs->Read(-1, eof, 0, sizeof(eof)));
+}
+
+TEST_F(IoUringFileSystemTest, ReadToFixedBufferTest) {
+    if (!supported) {
+        LOG(WARNING) << "io_uring is not supported, skip.";
+        return;
+    }
+    std::string data(16384, 'a');
+    ASSERT_EQ(16384, lfs->Write(fd, data.c_str(), 0, 16384));
+
+    // 两个固定buffer都挂在IOBuf上
+    butil::IOBuf readBuf1;
+    ASSERT_EQ(8192, lfs->ReadToIOBuf(fd, &readBuf1, 0, 8192));
+    butil::IOBuf readBuf2;
+    ASSERT_EQ(4096, lfs->ReadToIOBuf(fd, &readBuf2, 8192, 4096));
+    ASSERT_EQ(data.substr(0, 8192), readBuf1.to_string());
+    ASSERT_EQ(data.substr(8192, 4096), readBuf2.to_string());
+
+    // 没有可用的固定buffer，退化为preadv
+    butil::IOBuf readBuf3;
+    ASSERT_EQ(4096, lfs->ReadToIOBuf(fd, &readBuf3, 12288, 4096));
+    ASSERT_EQ(data.substr(12288, 4096), readBuf3.to_string());
+
+    // IOBuf释放后buffer可以继续使用
+    readBuf1.clear();
+    readBuf2.clear();
+    for (int i = 0; i < 4; ++i) {
+        butil::IOBuf readBuf;
+        ASSERT_EQ(8192, lfs->ReadToIOBuf(fd, &readBuf, 4096, 8192));
+        ASSERT_EQ(data.substr(4096, 8192), readBuf.to_string());
+    }
+
+    // 读超过文件长度的位置返回0，buffer被归还
+    butil::IOBuf eofBuf;
+    ASSERT_EQ(0, lfs->ReadToIOBuf(fd, &eofBuf, 1ULL << 30, 4096));
+    ASSERT_EQ(0, eofBuf.size());
+
+    // Fini时还挂在IOBuf上的buffer在IOBuf释放时才会释放
+    butil::IOBuf heldBuf;
+    ASSERT_EQ(4096, lfs->ReadToIOBuf(fd, &heldBuf, 0, 4096));
+    lfs->Fini();
+    ASSERT_EQ(data.substr(0, 4096), heldBuf.to_string());
+    heldBuf.clear();
+}
+
+TEST_F(IoUringFileSystemTest, WriteAsyncTest) {
+    if (!supported) {
+        LOG(WARNING) << "io_uring is not supported, skip.";
+        return;
+    }
+    // 异步写的数量超过队列深度，提交方在sq满时等待
+    const int kWriteNum = 64;
+    const int kLength = 4096;
+    std::mutex mtx;
+    std::condition_variable cond;
+    int finished = 0;
+    std::atomic<int> failed(0);
+    std::thread::id reapThreadId;
+    for (int i = 0; i < kWriteNum; ++i) {
+        butil::IOBuf buf;
+        buf.append(std::string(kLength, 'a' + i % 26));
+        lfs->WriteAsync(fd, buf, i * kLength, kLength, [&](int res) {
+            if (res != kLength) {
+                failed.fetch_add(1);
+            }
+            std::lock_guard<std::mutex> lk(mtx);
+            reapThreadId = std::this_thread::get_id();
+            ++finished;
+            cond.notify_all();
+        });
+    }
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        cond.wait(lk, [&] { return finished == kWriteNum; });
+        // 回调在reap线程中执行
+        ASSERT_NE(std::this_thread::get_id(), reapThreadId);
+    }
+    ASSERT_EQ(0, failed.load());
+    for (int i = 0; i < kWriteNum; ++i) {
+        std::string readData(kLength, 0);
+        ASSERT_EQ(kLength, lfs->Read(fd, &readData[0], i * kLength, kLength));
+        ASSERT_EQ(std::string(kLength, 'a' + i % 26), readData);
+    }
+
+    // 非法fd，回调返回错误
+    int result = 0;
+    CountDownEvent event(1);
+    butil::IOBuf buf;
+    buf.append(std::string(kLength, 'a'));
+    lfs->WriteAsync(-1, buf, 0, kLength, [&](int res) {
+        result = res;
+        event.Signal();
+    });
+    event.Wait();
+    ASSERT_EQ(-EBADF, result);
+
+    // Fini之后回调直接返回-ESHUTDOWN
+    lfs->Fini();
+    result = 0;
+    lfs->WriteAsync(fd, buf, 0, kLength, [&](int res) {
+        result = res;
+    });
+    ASSERT_EQ(-ESHUTDOWN, result);
+}
+
+TEST_F(IoUringFileSystemTest, ConcurrentReadWriteTest) {
+    if (!supported) {
+        LOG(WARNING) << "io_uring is not supported, skip.";
+        return;
+    }
+    // 并发数大于队列深度以及固定buffer个数
+    const int kThreadNum = 16;
+    const int kLoop = 100;
+    const int kLength = 4096;
+    std::vector<std::thread> threads;
+    std::atomic<int> failed(0);
+    for (int t = 0; t < kThreadNum; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < kLoop; ++i) {
+                uint64_t offset = (t * kLoop + i) * kLength;
+                std::string data(kLength, 'a' + t);
+                int ret;
+                if (i % 2 == 0) {
+                    butil::IOBuf buf;
+                    buf.append(data);
+                    ret = lfs->Write(fd, buf, offset, kLength);
+                } else {
+                    ret = lfs->Write(fd, data.c_str(), offset, kLength);
+                }
+                std::string readData(kLength, 0);
+                if (ret != kLength
+                    || lfs->Read(fd, &readData[0], offset, kLength) != kLength
+                    || readData != data) {
+                    failed.fetch_add(1);
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    ASSERT_EQ(0, failed.load());
+}
+
+TEST_F(IoUringFileSystemTest, FiniWithInflightIOTest) {
+    if (!supported) {
+        LOG(WARNING) << "io_uring is not supported, skip.";
+        return;
+    }
+    // Fini与读写并发，已经提交的请求正常完成，之后的请求返回-ESHUTDOWN，
+    // 不会有请求一直阻塞
+    const int kThreadNum = 16;
+    const int kLength = 4096;
+    std::vector<std::thread> threads;
+    std::atomic<int> failed(0);
+    std::atomic<bool> stop(false);
+    for (int t = 0; t < kThreadNum; ++t) {
+        threads.emplace_back([&, t]() {
+            std::string data(kLength, 'a' + t);
+            uint64_t offset = t * kLength;
+            while (!stop.load()) {
+                int ret = lfs->Write(fd, data.c_str(), offset, kLength);
+                if (ret == -ESHUTDOWN) {
+                    break;
+                }
+                if (ret != kLength) {
+                    failed.fetch_add(1);
+                }
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    lfs->Fini();
+    stop.store(true);
+    for (auto& th : threads) {
+        th.join();
+    }
+    ASSERT_EQ(0, failed.load());
+
+    std::string data(kLength, 'a');
+    ASSERT_EQ(-ESHUTDOWN, lfs->Write(fd, data.c_str(), 0, kLength));
+    ASSERT_EQ(-ESHUTDOWN, lfs->Read(fd, &data[0], 0, kLength));
+}
+
+}  // namespace fs
+}  // namespace curve
@@ -29,6 +29,7 @@
 
 #include <chrono>  //NOLINT
 #include <thread>  //NOLINT
+#include <vector>
 
 #include "proto/cli.pb.h"
 #include "proto/chunk.pb.h"
@@ -610,6 +611,82 @@ TEST_F(TestChunkServerClient, TestDeleteChunkSuccess) {
     ASSERT_EQ(kMdsSuccess, ret);
 }
 
+TEST_F(TestChunkServerClient, TestDeleteChunksSuccess) {
+    uint32_t port = listenAddr_.port;
+
+    ChunkServerIdType csId = 0x01;
+    LogicalPoolID logicalPoolId = 0x11;
+    CopysetID copysetId = 0x21;
+    std::vector<ChunkID> chunkIds = {0x31, 0x32, 0x33};
+    uint64_t sn = 100;
+
+    ChunkServer chunkserver(
+        csId, "", "", 0x101, "127.0.0.1", port, "", READWRITE);
+    ChunkServerState csState;
+    csState.SetDiskState(DISKNORMAL);
+    chunkserver.SetOnlineState(ONLINE);
+    chunkserver.SetChunkServerState(csState);
+
+    EXPECT_CALL(*topo_, GetChunkServer(csId, _))
+        .WillOnce(DoAll(SetArgPointee<1>(chunkserver),
+            Return(true)));
+    ChunkResponse response;
+    response.set_status(CHUNK_OP_STATUS::CHUNK_OP_STATUS_SUCCESS);
+    std::vector<ChunkID> received;
+    EXPECT_CALL(*chunkService, DeleteChunks(_, _, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(response),
+                Invoke([&](RpcController *controller,
+                          const ChunkRequest *request,
+                          ChunkResponse *response,
+                          Closure *done){
+                          brpc::ClosureGuard doneGuard(done);
+                          received.assign(request->chunkids().begin(),
+                                          request->chunkids().end());
+                    })));
+
+    int ret = client_->DeleteChunks(
+        csId, logicalPoolId, copysetId, chunkIds, sn);
+    ASSERT_EQ(kMdsSuccess, ret);
+    ASSERT_EQ(chunkIds, received);
+}
+
+TEST_F(TestChunkServerClient, TestDeleteChunksNotSupported) {
+    uint32_t port = listenAddr_.port;
+
+    ChunkServerIdType csId = 0x01;
+    LogicalPoolID logicalPoolId = 0x11;
+    CopysetID copysetId = 0x21;
+    std::vector<ChunkID> chunkIds = {0x31, 0x32, 0x33};
+    uint64_t sn = 100;
+
+    ChunkServer chunkserver(
+        csId, "", "", 0x101, "127.0.0.1", port, "", READWRITE);
+    ChunkServerState csState;
+    csState.SetDiskState(DISKNORMAL);
+    chunkserver.SetOnlineState(ONLINE);
+    chunkserver.SetChunkServerState(csState);
+
+    EXPECT_CALL(*topo_, GetChunkServer(csId, _))
+        .WillOnce(DoAll(SetArgPointee<1>(chunkserver),
+            Return(true)));
+    // 老版本的chunkserver没有DeleteChunks接口，不再重试
+    EXPECT_CALL(*chunkService, DeleteChunks(_, _, _, _))
+        .WillOnce(Invoke([](RpcController *controller,
+                            const ChunkRequest *request,
+                            ChunkResponse *response,
+                            Closure *done){
+                      brpc::ClosureGuard doneGuard(done);
+                      brpc::Controller *cntl =
+                          static_cast<brpc::Controller*>(controller);
+                      cntl->SetFailed(brpc::ENOMETHOD,
+                                      "Fail to find method");
+                  }));
+
+    int ret = client_->DeleteChunks(
+        csId, logicalPoolId, copysetId, chunkIds, sn);
+    ASSERT_EQ(kCsClientNotSupported, ret);
+}
+
 TEST_F(TestChunkServerClient, TestDeleteChunkGetChunkServerFail) {
     uint32_t port = listenAddr_.port;
 
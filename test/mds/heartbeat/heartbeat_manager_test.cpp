@@ -26,6 +26,7 @@
 #include "src/mds/heartbeat/heartbeat_manager.h"
 #include "src/mds/heartbeat/chunkserver_healthy_checker.h"
 #include "src/common/timeutility.h"
+#include "src/common/copyset_fingerprint.h"
 #include "test/mds/mock/mock_coordinator.h"
 #include "test/mds/mock/mock_topology.h"
 #include "test/mds/mock/mock_topoAdapter.h"
@@ -915,6 +916,144 @@ TEST_F(TestHeartbeatManager, test_patrol_copySetInfo_return_order) {
     ASSERT_EQ(TRANSFER_LEADER, response.needupdatecopysets(0).type());
     ASSERT_EQ(3, response.needupdatecopysets(0).peers_size());
 }
+
+TEST_F(TestHeartbeatManager, test_delta_heartbeat) {
+    auto request = GetChunkServerHeartbeatRequestForTest();
+    ChunkServerHeartbeatResponse response;
+    uint32_t digest =
+        ::curve::common::CopySetFingerprint(request.copysetinfos(0));
+    request.set_copysetcount(1);
+    request.set_copysetdigest(digest);
+
+    ::curve::mds::topology::ChunkServer chunkServer1(
+        1, "hello", "", 1, "192.168.10.1", 9000, "",
+        ::curve::mds::topology::ChunkServerStatus::READWRITE);
+    ::curve::mds::topology::ChunkServer chunkServer2(
+        2, "hello", "", 1, "192.168.10.2", 9000, "",
+        ::curve::mds::topology::ChunkServerStatus::READWRITE);
+    ::curve::mds::topology::ChunkServer chunkServer3(
+        3, "hello", "", 1, "192.168.10.3", 9000, "",
+        ::curve::mds::topology::ChunkServerStatus::READWRITE);
+    EXPECT_CALL(*topology_, GetChunkServer(1, _))
+        .WillRepeatedly(DoAll(SetArgPointee<1>(chunkServer1), Return(true)));
+    // copyset is converted only when it is reported
+    EXPECT_CALL(*topology_, GetChunkServerNotRetired(_, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(chunkServer1), Return(true)))
+        .WillOnce(DoAll(SetArgPointee<2>(chunkServer2), Return(true)))
+        .WillOnce(DoAll(SetArgPointee<2>(chunkServer3), Return(true)));
+    EXPECT_CALL(*topology_, GetCopySetsInChunkServer(1, _))
+        .WillRepeatedly(Return(std::vector<CopySetKey>{CopySetKey(1, 1)}));
+    ::curve::mds::topology::CopySetInfo copySetInfo(1, 1);
+    copySetInfo.SetEpoch(10);
+    copySetInfo.SetLeader(1);
+    copySetInfo.SetCopySetMembers(std::set<ChunkServerIdType>{1, 2, 3});
+    EXPECT_CALL(*topology_, GetCopySet(_, _))
+        .WillRepeatedly(DoAll(SetArgPointee<1>(copySetInfo), Return(true)));
+
+    // 1. full heartbeat, all copysets are dealt with
+    EXPECT_CALL(*coordinator_, CopySetHeartbeat(_, _, _))
+        .WillOnce(Return(::curve::mds::topology::UNINTIALIZE_ID));
+    heartbeatManager_->ChunkServerHeartbeat(request, &response);
+    ASSERT_FALSE(response.needfullheartbeat());
+    ASSERT_EQ(HeartbeatStatusCode::hbOK, response.statuscode());
+    ASSERT_EQ(0, response.needupdatecopysets_size());
+
+    // 2. delta heartbeat without change, leader copyset without operator
+    //    is skipped
+    request.clear_copysetinfos();
+    request.set_isdelta(true);
+    response.Clear();
+    EXPECT_CALL(*coordinator_, HasOperator(CopySetKey(1, 1)))
+        .WillOnce(Return(false));
+    EXPECT_CALL(*coordinator_, CopySetHeartbeat(_, _, _)).Times(0);
+    heartbeatManager_->ChunkServerHeartbeat(request, &response);
+    ASSERT_FALSE(response.needfullheartbeat());
+    ASSERT_EQ(HeartbeatStatusCode::hbOK, response.statuscode());
+
+    // 3. leader copyset with operator is dealt with using the record
+    response.Clear();
+    EXPECT_CALL(*coordinator_, HasOperator(CopySetKey(1, 1)))
+        .WillOnce(Return(true));
+    EXPECT_CALL(*coordinator_, CopySetHeartbeat(_, _, _))
+        .WillOnce(Return(::curve::mds::topology::UNINTIALIZE_ID));
+    heartbeatManager_->ChunkServerHeartbeat(request, &response);
+    ASSERT_FALSE(response.needfullheartbeat());
+
+    // 4. digest mismatch, ask for full heartbeat
+    request.set_copysetdigest(digest + 1);
+    response.Clear();
+    EXPECT_CALL(*coordinator_, HasOperator(CopySetKey(1, 1)))
+        .WillOnce(Return(false));
+    heartbeatManager_->ChunkServerHeartbeat(request, &response);
+    ASSERT_TRUE(response.needfullheartbeat());
+
+    // 5. copyset removed
+    request.set_copysetdigest(0);
+    request.set_copysetcount(0);
+    request.add_removedcopysets((1ULL << 32) | 1);
+    response.Clear();
+    heartbeatManager_->ChunkServerHeartbeat(request, &response);
+    ASSERT_FALSE(response.needfullheartbeat());
+    ASSERT_EQ(HeartbeatStatusCode::hbRequestNoCopyset, response.statuscode());
+}
+
+TEST_F(TestHeartbeatManager, test_delta_heartbeat_chunkserver_retired) {
+    auto request = GetChunkServerHeartbeatRequestForTest();
+    ChunkServerHeartbeatResponse response;
+    uint32_t digest =
+        ::curve::common::CopySetFingerprint(request.copysetinfos(0));
+    request.set_copysetcount(1);
+    request.set_copysetdigest(digest);
+
+    ::curve::mds::topology::ChunkServer chunkServer1(
+        1, "hello", "", 1, "192.168.10.1", 9000, "",
+        ::curve::mds::topology::ChunkServerStatus::READWRITE);
+    ::curve::mds::topology::ChunkServer chunkServer2(
+        2, "hello", "", 1, "192.168.10.2", 9000, "",
+        ::curve::mds::topology::ChunkServerStatus::READWRITE);
+    ::curve::mds::topology::ChunkServer chunkServer3(
+        3, "hello", "", 1, "192.168.10.3", 9000, "",
+        ::curve::mds::topology::ChunkServerStatus::READWRITE);
+    ::curve::mds::topology::ChunkServer retiredCs(
+        1, "hello", "", 1, "192.168.10.1", 9000, "",
+        ::curve::mds::topology::ChunkServerStatus::RETIRED);
+    EXPECT_CALL(*topology_, GetChunkServer(1, _))
+        .WillOnce(DoAll(SetArgPointee<1>(chunkServer1), Return(true)))
+        .WillOnce(DoAll(SetArgPointee<1>(retiredCs), Return(true)))
+        .WillOnce(DoAll(SetArgPointee<1>(chunkServer1), Return(true)));
+    EXPECT_CALL(*topology_, GetChunkServerNotRetired(_, _, _))
+        .WillOnce(DoAll(SetArgPointee<2>(chunkServer1), Return(true)))
+        .WillOnce(DoAll(SetArgPointee<2>(chunkServer2), Return(true)))
+        .WillOnce(DoAll(SetArgPointee<2>(chunkServer3), Return(true)));
+    EXPECT_CALL(*topology_, GetCopySetsInChunkServer(1, _))
+        .WillRepeatedly(Return(std::vector<CopySetKey>{CopySetKey(1, 1)}));
+    ::curve::mds::topology::CopySetInfo copySetInfo(1, 1);
+    copySetInfo.SetEpoch(10);
+    copySetInfo.SetLeader(1);
+    copySetInfo.SetCopySetMembers(std::set<ChunkServerIdType>{1, 2, 3});
+    EXPECT_CALL(*topology_, GetCopySet(_, _))
+        .WillRepeatedly(DoAll(SetArgPointee<1>(copySetInfo), Return(true)));
+    EXPECT_CALL(*coordinator_, CopySetHeartbeat(_, _, _))
+        .WillOnce(Return(::curve::mds::topology::UNINTIALIZE_ID));
+
+    // 1. full heartbeat, copysets are recorded
+    heartbeatManager_->ChunkServerHeartbeat(request, &response);
+    ASSERT_FALSE(response.needfullheartbeat());
+    ASSERT_EQ(HeartbeatStatusCode::hbOK, response.statuscode());
+
+    // 2. chunkserver retired, the record is dropped
+    request.clear_copysetinfos();
+    request.set_isdelta(true);
+    response.Clear();
+    heartbeatManager_->ChunkServerHeartbeat(request, &response);
+    ASSERT_EQ(HeartbeatStatusCode::hbChunkserverRetired,
+              response.statuscode());
+
+    // 3. delta heartbeat does not match the dropped record
+    response.Clear();
+    heartbeatManager_->ChunkServerHeartbeat(request, &response);
+    ASSERT_TRUE(response.needfullheartbeat());
+}
 }  // namespace heartbeat
 }  // namespace mds
 }  // namespace curve
@@ -58,13 +58,15 @@ class MockEtcdClient : public EtcdClientImp {
     MOCK_METHOD3(PutRewithRevision, int(const std::string &,
         const std::string &, int64_t *));
     MOCK_METHOD2(DeleteRewithRevision, int(const std::string &, int64_t *));
+    MOCK_METHOD4(CompareAndDelete, int(const std::string &,
+        const std::string &, const std::string &, int64_t *));
 };
 
 class MockLRUCache : public LRUCache {
  public:
     virtual ~MockLRUCache() {}
-    MOCK_METHOD2(Put, void(const std::string&, const std::string&));
-    MOCK_METHOD2(Get, bool(const std::string&, std::string*));
+    MOCK_METHOD2(Put, void(const std::string&, const CacheValue&));
+    MOCK_METHOD2(Get, bool(const std::string&, CacheValue*));
     MOCK_METHOD1(Remove, void(const std::string&));
 };
 }  // namespace mds
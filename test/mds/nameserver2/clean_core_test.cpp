@@ -23,16 +23,27 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include <glog/logging.h>
+#include <map>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
 #include "src/mds/nameserver2/clean_core.h"
 #include "test/mds/nameserver2/mock/mock_namespace_storage.h"
 #include "test/mds/mock/mock_topology.h"
 #include "src/mds/chunkserverclient/copyset_client.h"
 #include "test/mds/mock/mock_alloc_statistic.h"
+#include "test/mds/chunkserverclient/mock_chunkserverclient.h"
 
 using ::testing::_;
 using ::testing::Return;
+using ::testing::DoAll;
+using ::testing::SetArgPointee;
+using ::testing::Invoke;
 using curve::mds::topology::MockTopology;
 using ::curve::mds::chunkserverclient::ChunkServerClientOption;
+using ::curve::mds::chunkserverclient::MockChunkServerClient;
+using ::curve::mds::topology::CopySetInfo;
+using ::curve::mds::topology::CopySetKey;
 
 namespace curve {
 namespace mds {
@@ -60,11 +71,8 @@ TEST(CleanCore, testcleansnapshotfile) {
 
     {
         // delete ok (no, segment)
-        uint32_t segmentNum = kMiniFileLength / DefaultSegmentSize;
-        for (uint32_t i = 0; i < segmentNum; i++) {
-            EXPECT_CALL(*storage, GetSegment(_, i * DefaultSegmentSize, _))
-            .WillOnce(Return(StoreStatus::KeyNotExist));
-        }
+        EXPECT_CALL(*storage, ListSegment(_, _))
+        .WillOnce(Return(StoreStatus::OK));
 
         EXPECT_CALL(*storage, DeleteSnapshotFile(_, _))
         .Times(1)
@@ -82,11 +90,8 @@ TEST(CleanCore, testcleansnapshotfile) {
     }
     {
         // all ok , but do DeleteFile namespace meta error
-        uint32_t segmentNum = kMiniFileLength / DefaultSegmentSize;
-        for (uint32_t i = 0; i < segmentNum; i++) {
-            EXPECT_CALL(*storage, GetSegment(_, i * DefaultSegmentSize, _))
-            .WillOnce(Return(StoreStatus::KeyNotExist));
-        }
+        EXPECT_CALL(*storage, ListSegment(_, _))
+        .WillOnce(Return(StoreStatus::OK));
 
         EXPECT_CALL(*storage, DeleteSnapshotFile(_, _))
         .WillOnce(Return(StoreStatus::InternalError));
@@ -101,7 +106,7 @@ TEST(CleanCore, testcleansnapshotfile) {
 
     {
         // get segment error
-        EXPECT_CALL(*storage, GetSegment(_, 0, _))
+        EXPECT_CALL(*storage, ListSegment(_, _))
         .Times(1)
         .WillOnce(Return(StoreStatus::InternalError));
 
@@ -115,13 +120,9 @@ TEST(CleanCore, testcleansnapshotfile) {
     {
         // 联调Bug修复：快照文件共享源文件的segment，所以在查询segment的时候需要使用
         // ParentID 进行查找
-        uint32_t segmentNum = kMiniFileLength / DefaultSegmentSize;
         uint64_t expectParentID = 101;
-        for (uint32_t i = 0; i < segmentNum; i++) {
-            EXPECT_CALL(*storage,
-                        GetSegment(expectParentID, i * DefaultSegmentSize, _))
-            .WillOnce(Return(StoreStatus::KeyNotExist));
-        }
+        EXPECT_CALL(*storage, ListSegment(expectParentID, _))
+        .WillOnce(Return(StoreStatus::OK));
 
         EXPECT_CALL(*storage, DeleteSnapshotFile(_, _))
         .Times(1)
@@ -144,11 +145,8 @@ TEST(CleanCore, testcleansnapshotfile) {
 
     {
         // get segment ok, DeleteSnapShotChunk OK
-        uint32_t segmentNum = kMiniFileLength / DefaultSegmentSize;
-        for (uint32_t i = 0; i < segmentNum; i++) {
-            EXPECT_CALL(*storage, GetSegment(_, i * DefaultSegmentSize, _))
-            .WillOnce(Return(StoreStatus::OK));
-        }
+        EXPECT_CALL(*storage, ListSegment(_, _))
+        .WillOnce(Return(StoreStatus::OK));
 
         EXPECT_CALL(*storage, DeleteSnapshotFile(_, _))
         .Times(1)
@@ -189,11 +187,8 @@ TEST(CleanCore, testcleanfile) {
 
     {
         // delete ok (no, segment)
-        uint32_t segmentNum = kMiniFileLength / DefaultSegmentSize;
-        for (uint32_t i = 0; i < segmentNum; i++) {
-            EXPECT_CALL(*storage, GetSegment(_, i * DefaultSegmentSize, _))
-            .WillOnce(Return(StoreStatus::KeyNotExist));
-        }
+        EXPECT_CALL(*storage, ListSegment(_, _))
+        .WillOnce(Return(StoreStatus::OK));
 
         EXPECT_CALL(*storage, DeleteFile(_, _))
         .Times(1)
@@ -212,11 +207,8 @@ TEST(CleanCore, testcleanfile) {
 
     {
         // all ok , but do DeleteFile namespace meta error
-        uint32_t segmentNum = kMiniFileLength / DefaultSegmentSize;
-        for (uint32_t i = 0; i < segmentNum; i++) {
-            EXPECT_CALL(*storage, GetSegment(_, i * DefaultSegmentSize, _))
-            .WillOnce(Return(StoreStatus::KeyNotExist));
-        }
+        EXPECT_CALL(*storage, ListSegment(_, _))
+        .WillOnce(Return(StoreStatus::OK));
 
         EXPECT_CALL(*storage, DeleteFile(_, _))
         .WillOnce(Return(StoreStatus::InternalError));
@@ -232,7 +224,7 @@ TEST(CleanCore, testcleanfile) {
 
     {
         // get segment error
-        EXPECT_CALL(*storage, GetSegment(_, 0, _))
+        EXPECT_CALL(*storage, ListSegment(_, _))
         .Times(1)
         .WillOnce(Return(StoreStatus::InternalError));
 
@@ -249,8 +241,11 @@ TEST(CleanCore, testcleanfile) {
     }
     {
         // get segment ok, DeleteSnapShotChunk ok, DeleteSegment error
-        EXPECT_CALL(*storage, GetSegment(_, 0, _))
-                .WillOnce(Return(StoreStatus::OK));
+        std::vector<PageFileSegment> segments(1);
+        segments[0].set_startoffset(0);
+        EXPECT_CALL(*storage, ListSegment(_, _))
+        .WillOnce(DoAll(SetArgPointee<1>(segments),
+                        Return(StoreStatus::OK)));
 
         EXPECT_CALL(*storage, DeleteSegment(_, _, _))
         .WillOnce(Return(StoreStatus::InternalError));
@@ -264,5 +259,166 @@ TEST(CleanCore, testcleanfile) {
         ASSERT_EQ(progress.GetStatus(), TaskStatus::FAILED);
     }
 }
+
+TEST(CleanCore, testcleanfileconcurrently) {
+    auto storage = std::make_shared<MockNameServerStorage>();
+    auto topology = std::make_shared<MockTopology>();
+    ChunkServerClientOption option;
+    auto channelPool = std::make_shared<ChannelPool>();
+    auto client = std::make_shared<CopysetClient>(topology,
+                                                    option, channelPool);
+    auto csClient = std::make_shared<MockChunkServerClient>(topology,
+                                                    option, channelPool);
+    client->SetChunkServerClient(csClient);
+    auto allocStatistic = std::make_shared<MockAllocStatistic>();
+    CleanOption cleanOption;
+    cleanOption.deleteChunkConcurrency = 8;
+    cleanOption.chunkserverDeleteConcurrency = 2;
+    cleanOption.deleteChunkBatchSize = 2;
+    auto cleanCore = std::make_shared<CleanCore>(storage, client,
+                                    allocStatistic, topology, cleanOption);
+
+    // 4个segment，每个segment 8个chunk，copyset i的leader为chunkserver i % 2，
+    // 同一个copyset中的chunk每2个一起删除
+    const uint32_t segmentNum = 4;
+    const uint32_t chunkNum = 8;
+    std::vector<PageFileSegment> segments(segmentNum);
+    for (uint32_t i = 0; i < segmentNum; i++) {
+        segments[i].set_logicalpoolid(1);
+        segments[i].set_segmentsize(DefaultSegmentSize);
+        segments[i].set_chunksize(16 * 1024 * 1024);
+        segments[i].set_startoffset(i * DefaultSegmentSize);
+        for (uint32_t j = 0; j < chunkNum; j++) {
+            auto chunk = segments[i].add_chunks();
+            chunk->set_copysetid(j);
+            chunk->set_chunkid(i * chunkNum + j + 1);
+        }
+    }
+    EXPECT_CALL(*topology, GetCopySet(_, _))
+        .WillRepeatedly(Invoke([](CopySetKey key, CopySetInfo* info) {
+            *info = CopySetInfo(key.first, key.second);
+            info->SetLeader(key.second % 2);
+            return true;
+        }));
+
+    // 记录每个chunkserver上的并发
+    std::mutex mtx;
+    std::map<ChunkServerIdType, uint32_t> inflight;
+    uint32_t maxInflight = 0;
+    auto deleteChunks = [&](ChunkServerIdType csId, LogicalPoolID,
+                            CopysetID, const std::vector<ChunkID>& chunkIds,
+                            uint64_t) {
+        {
+            std::lock_guard<std::mutex> lk(mtx);
+            maxInflight = std::max(maxInflight, ++inflight[csId]);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::lock_guard<std::mutex> lk(mtx);
+        --inflight[csId];
+        // 最后一个segment中的一个chunk删除失败，
+        // 它和第3个segment中的chunk在同一批中
+        for (auto chunkId : chunkIds) {
+            if (chunkId == 3 * chunkNum + 1) {
+                return kMdsFail;
+            }
+        }
+        return kMdsSuccess;
+    };
+
+    {
+        // 所有chunk删除成功
+        EXPECT_CALL(*storage, ListSegment(_, _))
+        .WillOnce(DoAll(SetArgPointee<1>(segments),
+                        Return(StoreStatus::OK)));
+        EXPECT_CALL(*csClient, DeleteChunk(_, _, _, _, _))
+        .Times(0);
+        EXPECT_CALL(*csClient, DeleteChunks(_, _, _, _, _))
+        .Times(segmentNum * chunkNum / cleanOption.deleteChunkBatchSize)
+        .WillRepeatedly(Invoke([&](ChunkServerIdType csId,
+            LogicalPoolID lpid, CopysetID cpid,
+            const std::vector<ChunkID>& chunkIds, uint64_t sn) {
+            deleteChunks(csId, lpid, cpid, chunkIds, sn);
+            return kMdsSuccess;
+        }));
+        EXPECT_CALL(*storage, DeleteSegment(_, _, _))
+        .Times(segmentNum)
+        .WillRepeatedly(Return(StoreStatus::OK));
+        EXPECT_CALL(*allocStatistic, DeAllocSpace(_, _, _))
+        .Times(segmentNum);
+        EXPECT_CALL(*storage, DeleteFile(_, _))
+        .WillOnce(Return(StoreStatus::OK));
+
+        FileInfo cleanFile;
+        cleanFile.set_length(segmentNum * DefaultSegmentSize);
+        cleanFile.set_segmentsize(DefaultSegmentSize);
+        TaskProgress progress;
+        ASSERT_EQ(cleanCore->CleanFile(cleanFile, &progress),
+            StatusCode::kOK);
+        ASSERT_EQ(progress.GetStatus(), TaskStatus::SUCCESS);
+        ASSERT_EQ(progress.GetProgress(), 100);
+        ASSERT_EQ(progress.GetTotalChunks(), segmentNum * chunkNum);
+        ASSERT_EQ(progress.GetFinishedChunks(), segmentNum * chunkNum);
+        ASSERT_LE(maxInflight, cleanOption.chunkserverDeleteConcurrency);
+    }
+
+    {
+        // 一个chunk删除失败，只删除chunk已经全部删除的segment
+        EXPECT_CALL(*storage, ListSegment(_, _))
+        .WillOnce(DoAll(SetArgPointee<1>(segments),
+                        Return(StoreStatus::OK)));
+        EXPECT_CALL(*csClient, DeleteChunks(_, _, _, _, _))
+        .WillRepeatedly(Invoke(deleteChunks));
+        EXPECT_CALL(*storage, DeleteSegment(_, 2 * DefaultSegmentSize, _))
+        .Times(0);
+        EXPECT_CALL(*storage, DeleteSegment(_, 3 * DefaultSegmentSize, _))
+        .Times(0);
+        EXPECT_CALL(*storage, DeleteSegment(_, 0, _))
+        .WillOnce(Return(StoreStatus::OK));
+        EXPECT_CALL(*storage, DeleteSegment(_, DefaultSegmentSize, _))
+        .WillOnce(Return(StoreStatus::OK));
+        EXPECT_CALL(*allocStatistic, DeAllocSpace(_, _, _))
+        .Times(2);
+        EXPECT_CALL(*storage, DeleteFile(_, _))
+        .Times(0);
+
+        FileInfo cleanFile;
+        cleanFile.set_length(segmentNum * DefaultSegmentSize);
+        cleanFile.set_segmentsize(DefaultSegmentSize);
+        TaskProgress progress;
+        ASSERT_EQ(cleanCore->CleanFile(cleanFile, &progress),
+            StatusCode::kCommonFileDeleteError);
+        ASSERT_EQ(progress.GetStatus(), TaskStatus::FAILED);
+        ASSERT_LE(maxInflight, cleanOption.chunkserverDeleteConcurrency);
+    }
+
+    {
+        // chunkserver不支持DeleteChunks，改为逐个删除
+        EXPECT_CALL(*storage, ListSegment(_, _))
+        .WillOnce(DoAll(SetArgPointee<1>(segments),
+                        Return(StoreStatus::OK)));
+        EXPECT_CALL(*csClient, DeleteChunks(_, _, _, _, _))
+        .Times(segmentNum * chunkNum / cleanOption.deleteChunkBatchSize)
+        .WillRepeatedly(Return(kCsClientNotSupported));
+        EXPECT_CALL(*csClient, DeleteChunk(_, _, _, _, _))
+        .Times(segmentNum * chunkNum)
+        .WillRepeatedly(Return(kMdsSuccess));
+        EXPECT_CALL(*storage, DeleteSegment(_, _, _))
+        .Times(segmentNum)
+        .WillRepeatedly(Return(StoreStatus::OK));
+        EXPECT_CALL(*allocStatistic, DeAllocSpace(_, _, _))
+        .Times(segmentNum);
+        EXPECT_CALL(*storage, DeleteFile(_, _))
+        .WillOnce(Return(StoreStatus::OK));
+
+        FileInfo cleanFile;
+        cleanFile.set_length(segmentNum * DefaultSegmentSize);
+        cleanFile.set_segmentsize(DefaultSegmentSize);
+        TaskProgress progress;
+        ASSERT_EQ(cleanCore->CleanFile(cleanFile, &progress),
+            StatusCode::kOK);
+        ASSERT_EQ(progress.GetStatus(), TaskStatus::SUCCESS);
+        ASSERT_EQ(progress.GetFinishedChunks(), segmentNum * chunkNum);
+    }
+}
 }  // namespace mds
 }  // namespace curve
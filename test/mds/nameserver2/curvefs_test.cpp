@@ -44,6 +44,7 @@ using ::testing::Return;
 using ::testing::ReturnArg;
 using ::testing::DoAll;
 using ::testing::SetArgPointee;
+using ::testing::SaveArg;
 using curve::common::Authenticator;
 
 using curve::common::TimeUtility;
@@ -1701,6 +1702,74 @@ TEST_F(CurveFSTest, testChangeOwner) {
     }
 }
 
+TEST_F(CurveFSTest, testUpdateFileThrottleParams) {
+    FileThrottleParams params;
+    params.set_iopslimit(1000);
+    params.set_bpslimit(100 * 1024 * 1024);
+    params.set_bpsburst(200 * 1024 * 1024);
+
+    // update ok
+    {
+        FileInfo fileInfo1;
+        fileInfo1.set_filetype(FileType::INODE_PAGEFILE);
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)));
+
+        FileInfo saved;
+        EXPECT_CALL(*storage_, PutFile(_))
+        .Times(1)
+        .WillOnce(DoAll(SaveArg<0>(&saved), Return(StoreStatus::OK)));
+
+        ASSERT_EQ(curvefs_->UpdateFileThrottleParams("/file1", params),
+                  StatusCode::kOK);
+        ASSERT_EQ(1000, saved.throttleparams().iopslimit());
+        ASSERT_EQ(0, saved.throttleparams().iopsburst());
+        ASSERT_EQ(100 * 1024 * 1024, saved.throttleparams().bpslimit());
+        ASSERT_EQ(200 * 1024 * 1024, saved.throttleparams().bpsburst());
+    }
+
+    // file not exist
+    {
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::KeyNotExist));
+
+        ASSERT_EQ(curvefs_->UpdateFileThrottleParams("/file1", params),
+                  StatusCode::kFileNotExists);
+    }
+
+    // directory not supported
+    {
+        FileInfo fileInfo1;
+        fileInfo1.set_filetype(FileType::INODE_DIRECTORY);
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)));
+
+        ASSERT_EQ(curvefs_->UpdateFileThrottleParams("/file1", params),
+                  StatusCode::kNotSupported);
+    }
+
+    // put file fail
+    {
+        FileInfo fileInfo1;
+        fileInfo1.set_filetype(FileType::INODE_PAGEFILE);
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, PutFile(_))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::InternalError));
+
+        ASSERT_EQ(curvefs_->UpdateFileThrottleParams("/file1", params),
+                  StatusCode::kStorageError);
+    }
+}
+
 TEST_F(CurveFSTest, testGetOrAllocateSegment) {
     // test normal get exist segment
     {
@@ -1903,6 +1972,357 @@ TEST_F(CurveFSTest, testGetOrAllocateSegment) {
     }
 }
 
+TEST_F(CurveFSTest, testDeAllocateSegment) {
+    FileInfo fileInfo1;
+    fileInfo1.set_filetype(FileType::INODE_DIRECTORY);
+
+    FileInfo fileInfo2;
+    fileInfo2.set_id(10);
+    fileInfo2.set_filetype(FileType::INODE_PAGEFILE);
+    fileInfo2.set_length(kMiniFileLength);
+    fileInfo2.set_segmentsize(DefaultSegmentSize);
+    fileInfo2.set_filestatus(FileStatus::kFileCreated);
+
+    PageFileSegment segment;
+    segment.set_logicalpoolid(1);
+    segment.set_segmentsize(DefaultSegmentSize);
+
+    // test normal deallocate exist segment
+    {
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, ListSnapshotFile(10, 11, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::OK));
+
+        EXPECT_CALL(*storage_, GetSegment(10, DefaultSegmentSize, _))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<2>(segment),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_,
+                    DeleteSegmentIfFileUnchanged(_, DefaultSegmentSize, _))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<2>(1),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*allocStatistic_, DeAllocSpace(1, DefaultSegmentSize, 1))
+        .Times(1);
+
+        ASSERT_EQ(curvefs_->DeAllocateSegment("/user1/file2",
+                  DefaultSegmentSize), StatusCode::kOK);
+    }
+
+    // segment not exist
+    {
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, ListSnapshotFile(_, _, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::OK));
+
+        EXPECT_CALL(*storage_, GetSegment(_, _, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::KeyNotExist));
+
+        EXPECT_CALL(*storage_, DeleteSegmentIfFileUnchanged(_, _, _))
+        .Times(0);
+
+        ASSERT_EQ(curvefs_->DeAllocateSegment("/user1/file2", 0),
+                  StatusCode::kOK);
+    }
+
+    // segment offset not align file segment size
+    {
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        ASSERT_EQ(curvefs_->DeAllocateSegment("/user1/file2", 1),
+                  StatusCode::kParaError);
+    }
+
+    // clone file can't deallocate segment
+    {
+        FileInfo cloneFile = fileInfo2;
+        cloneFile.set_clonesource("/user1/src");
+
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(cloneFile),
+                        Return(StoreStatus::OK)));
+
+        ASSERT_EQ(curvefs_->DeAllocateSegment("/user1/file2", 0),
+                  StatusCode::kNotSupported);
+    }
+
+    // file has snapshot
+    {
+        std::vector<FileInfo> snapShotFiles;
+        snapShotFiles.push_back(fileInfo2);
+
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, ListSnapshotFile(_, _, _))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<2>(snapShotFiles),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, GetSegment(_, _, _))
+        .Times(0);
+
+        ASSERT_EQ(curvefs_->DeAllocateSegment("/user1/file2", 0),
+                  StatusCode::kFileUnderSnapShot);
+    }
+
+    // delete segment fail
+    {
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, ListSnapshotFile(_, _, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::OK));
+
+        EXPECT_CALL(*storage_, GetSegment(_, _, _))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<2>(segment),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, DeleteSegmentIfFileUnchanged(_, _, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::InternalError));
+
+        EXPECT_CALL(*allocStatistic_, DeAllocSpace(_, _, _))
+        .Times(0);
+
+        ASSERT_EQ(curvefs_->DeAllocateSegment("/user1/file2", 0),
+                  StatusCode::kStorageError);
+    }
+
+    // file changed by a snapshot after the check, segment is kept
+    {
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, ListSnapshotFile(_, _, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::OK));
+
+        EXPECT_CALL(*storage_, GetSegment(_, _, _))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<2>(segment),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, DeleteSegmentIfFileUnchanged(_, _, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::ConditionNotMatch));
+
+        EXPECT_CALL(*allocStatistic_, DeAllocSpace(_, _, _))
+        .Times(0);
+
+        ASSERT_EQ(curvefs_->DeAllocateSegment("/user1/file2", 0),
+                  StatusCode::kFileUnderSnapShot);
+    }
+}
+
+TEST_F(CurveFSTest, testGetSegments) {
+    FileInfo fileInfo1;
+    fileInfo1.set_filetype(FileType::INODE_DIRECTORY);
+
+    FileInfo fileInfo2;
+    fileInfo2.set_id(10);
+    fileInfo2.set_filetype(FileType::INODE_PAGEFILE);
+    fileInfo2.set_length(kMiniFileLength);
+    fileInfo2.set_segmentsize(DefaultSegmentSize);
+
+    PageFileSegment segment;
+    segment.set_logicalpoolid(1);
+    segment.set_segmentsize(DefaultSegmentSize);
+    segment.set_startoffset(kMiniFileLength - 2 * DefaultSegmentSize);
+
+    // 1. 只返回已经分配的segment，数量截断到文件末尾
+    {
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        std::vector<PageFileSegment> listed{segment};
+        EXPECT_CALL(*storage_, ListSegmentInRange(10,
+                    kMiniFileLength - 2 * DefaultSegmentSize,
+                    kMiniFileLength, _))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<3>(listed),
+                        Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, GetSegment(_, _, _))
+        .Times(0);
+
+        std::vector<PageFileSegment> segments;
+        ASSERT_EQ(StatusCode::kOK,
+                  curvefs_->GetSegments("/user1/file2",
+                            kMiniFileLength - 2 * DefaultSegmentSize,
+                            5, false, &segments));
+        ASSERT_EQ(1, segments.size());
+        ASSERT_EQ(segment.startoffset(), segments[0].startoffset());
+    }
+
+    // 2. allocateIfNotExist时分配其中还未分配的segment
+    {
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(4)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        std::vector<PageFileSegment> listed{segment};
+        EXPECT_CALL(*storage_, ListSegmentInRange(10,
+                    kMiniFileLength - 2 * DefaultSegmentSize,
+                    kMiniFileLength, _))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<3>(listed),
+                        Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, GetSegment(10,
+                    kMiniFileLength - DefaultSegmentSize, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::KeyNotExist));
+        EXPECT_CALL(*mockChunkAllocator_, AllocateChunkSegment(_, _, _,
+                    kMiniFileLength - DefaultSegmentSize, _))
+        .Times(1)
+        .WillOnce(Return(true));
+        EXPECT_CALL(*storage_, PutSegment(10,
+                    kMiniFileLength - DefaultSegmentSize, _, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::OK));
+
+        std::vector<PageFileSegment> segments;
+        ASSERT_EQ(StatusCode::kOK,
+                  curvefs_->GetSegments("/user1/file2",
+                            kMiniFileLength - 2 * DefaultSegmentSize,
+                            5, true, &segments));
+        ASSERT_EQ(2, segments.size());
+        ASSERT_EQ(segment.startoffset(), segments[0].startoffset());
+    }
+
+    // 3. 分配segment失败
+    {
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(4)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        std::vector<PageFileSegment> listed;
+        EXPECT_CALL(*storage_, ListSegmentInRange(10, 0,
+                    2 * DefaultSegmentSize, _))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<3>(listed),
+                        Return(StoreStatus::OK)));
+        EXPECT_CALL(*storage_, GetSegment(10, 0, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::KeyNotExist));
+        EXPECT_CALL(*mockChunkAllocator_, AllocateChunkSegment(_, _, _, _, _))
+        .Times(1)
+        .WillOnce(Return(false));
+
+        std::vector<PageFileSegment> segments;
+        ASSERT_EQ(StatusCode::kSegmentAllocateError,
+                  curvefs_->GetSegments("/user1/file2", 0, 2, true,
+                                        &segments));
+        ASSERT_TRUE(segments.empty());
+    }
+
+    // 4. offset没有按segment对齐
+    {
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        std::vector<PageFileSegment> segments;
+        ASSERT_EQ(StatusCode::kParaError,
+                  curvefs_->GetSegments("/user1/file2", 1, 2, false,
+                                        &segments));
+    }
+
+    // 5. offset超过文件大小
+    {
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        std::vector<PageFileSegment> segments;
+        ASSERT_EQ(StatusCode::kParaError,
+                  curvefs_->GetSegments("/user1/file2", kMiniFileLength,
+                                        2, false, &segments));
+    }
+
+    // 6. 读取segment失败
+    {
+        EXPECT_CALL(*storage_, GetFile(_, _, _))
+        .Times(2)
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo1),
+                        Return(StoreStatus::OK)))
+        .WillOnce(DoAll(SetArgPointee<2>(fileInfo2),
+                        Return(StoreStatus::OK)));
+
+        EXPECT_CALL(*storage_, ListSegmentInRange(10, 0,
+                    2 * DefaultSegmentSize, _))
+        .Times(1)
+        .WillOnce(Return(StoreStatus::InternalError));
+
+        std::vector<PageFileSegment> segments;
+        ASSERT_EQ(StatusCode::KInternalError,
+                  curvefs_->GetSegments("/user1/file2", 0, 2, false,
+                                        &segments));
+    }
+}
+
 TEST_F(CurveFSTest, testCreateSnapshotFile) {
     {
         // test client time not expired
@@ -308,6 +308,26 @@ class FakeNameServerStorage : public NameServerStorage {
         return StoreStatus::OK;
     }
 
+    StoreStatus ListSegmentInRange(InodeID id,
+                            uint64_t startOff,
+                            uint64_t endOff,
+                            std::vector<PageFileSegment> *segments) override {
+        std::lock_guard<std::mutex> guard(lock_);
+        std::string startStoreKey =
+                NameSpaceStorageCodec::EncodeSegmentStoreKey(id, startOff);
+        std::string endStoreKey =
+                NameSpaceStorageCodec::EncodeSegmentStoreKey(id, endOff);
+
+        for (auto iter = memKvMap_.lower_bound(startStoreKey);
+             iter != memKvMap_.end() && iter->first < endStoreKey; iter++) {
+            PageFileSegment segment;
+            segment.ParseFromString(iter->second);
+            segments->push_back(segment);
+        }
+
+        return StoreStatus::OK;
+    }
+
     StoreStatus ListSnapshotFile(InodeID startid,
                          InodeID endid,
                          std::vector<FileInfo> * files) override {
@@ -373,6 +393,28 @@ class FakeNameServerStorage : public NameServerStorage {
         return StoreStatus::OK;
     }
 
+    StoreStatus DeleteSegmentIfFileUnchanged(
+        const FileInfo &fileInfo, uint64_t off, int64_t *revision) override {
+        std::lock_guard<std::mutex> guard(lock_);
+        std::string fileKey = NameSpaceStorageCodec::EncodeFileStoreKey(
+                                                        fileInfo.parentid(),
+                                                        fileInfo.filename());
+        auto fileIter = memKvMap_.find(fileKey);
+        if (fileIter == memKvMap_.end() ||
+            fileIter->second != fileInfo.SerializeAsString()) {
+            return StoreStatus::ConditionNotMatch;
+        }
+
+        std::string storeKey =
+            NameSpaceStorageCodec::EncodeSegmentStoreKey(fileInfo.id(), off);
+        auto iter = memKvMap_.find(storeKey);
+        if (iter == memKvMap_.end()) {
+            return StoreStatus::KeyNotExist;
+        }
+        memKvMap_.erase(iter);
+        return StoreStatus::OK;
+    }
+
     StoreStatus SnapShotFile(const FileInfo *originalFileInfo,
                             const FileInfo * snapshotFileInfo) override {
         std::lock_guard<std::mutex> guard(lock_);
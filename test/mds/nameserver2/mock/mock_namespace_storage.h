@@ -77,6 +77,8 @@ class MockNameServerStorage : public NameServerStorage {
                                          int64_t *));
 
     MOCK_METHOD3(DeleteSegment, StoreStatus(InodeID, uint64_t, int64_t*));
+    MOCK_METHOD3(DeleteSegmentIfFileUnchanged,
+                 StoreStatus(const FileInfo &, uint64_t, int64_t*));
 
     MOCK_METHOD2(SnapShotFile, StoreStatus(const FileInfo *,
                                     const FileInfo *));
@@ -84,6 +86,9 @@ class MockNameServerStorage : public NameServerStorage {
         StoreStatus(std::vector<FileInfo> *snapShotFiles));
     MOCK_METHOD2(ListSegment,
         StoreStatus(InodeID, std::vector<PageFileSegment>*));
+    MOCK_METHOD4(ListSegmentInRange,
+        StoreStatus(InodeID, uint64_t, uint64_t,
+                    std::vector<PageFileSegment>*));
 };
 
 }  // namespace mds
@@ -31,6 +31,24 @@
 
 namespace curve {
 namespace mds {
+namespace {
+CacheValue MakeValue(const std::string &filename) {
+    auto fileinfo = std::make_shared<FileInfo>();
+    fileinfo->set_filename(filename);
+    return fileinfo;
+}
+
+std::string GetFileName(const CacheValue &value) {
+    auto fileinfo = std::dynamic_pointer_cast<const FileInfo>(value);
+    EXPECT_NE(nullptr, fileinfo);
+    return fileinfo == nullptr ? "" : fileinfo->filename();
+}
+
+uint64_t ItemSize(const std::string &key, const std::string &filename) {
+    return key.size() + MakeValue(filename)->ByteSizeLong();
+}
+}  // namespace
+
 TEST(CaCheTest, test_cache_with_capacity_limit) {
     int maxCount = 5;
     std::shared_ptr<LRUCache> cache = std::make_shared<LRUCache>(maxCount);
@@ -38,28 +56,28 @@ TEST(CaCheTest, test_cache_with_capacity_limit) {
     // 1. 测试 put/get
     uint64_t cacheSize = 0;
     for (int i = 1; i <= maxCount + 1; i++) {
-        cache->Put(std::to_string(i), std::to_string(i));
+        cache->Put(std::to_string(i), MakeValue(std::to_string(i)));
         if (i <= maxCount) {
-            cacheSize += std::to_string(i).size() * 2;
+            cacheSize += ItemSize(std::to_string(i), std::to_string(i));
             ASSERT_EQ(i, cache->GetCacheMetrics()->cacheCount.get_value());
         } else {
-            cacheSize +=
-                std::to_string(i).size() * 2 - std::to_string(1).size() * 2;
+            cacheSize += ItemSize(std::to_string(i), std::to_string(i)) -
+                ItemSize(std::to_string(1), std::to_string(1));
             ASSERT_EQ(
                 cacheSize, cache->GetCacheMetrics()->cacheBytes.get_value());
         }
 
-        std::string res;
+        CacheValue res;
         ASSERT_TRUE(cache->Get(std::to_string(i), &res));
-        ASSERT_EQ(std::to_string(i), res);
+        ASSERT_EQ(std::to_string(i), GetFileName(res));
     }
 
     // 2. 第一个元素被剔出
-    std::string res;
+    CacheValue res;
     ASSERT_FALSE(cache->Get(std::to_string(1), &res));
     for (int i = 2; i <= maxCount + 1; i++) {
         ASSERT_TRUE(cache->Get(std::to_string(i), &res));
-        ASSERT_EQ(std::to_string(i), res);
+        ASSERT_EQ(std::to_string(i), GetFileName(res));
     }
 
     // 3. 测试删除元素
@@ -68,17 +86,17 @@ TEST(CaCheTest, test_cache_with_capacity_limit) {
     // 删除list中存在的元素
     cache->Remove("2");
     ASSERT_FALSE(cache->Get("2", &res));
-    cacheSize -= std::to_string(2).size() * 2;
+    cacheSize -= ItemSize("2", "2");
     ASSERT_EQ(maxCount - 1, cache->GetCacheMetrics()->cacheCount.get_value());
     ASSERT_EQ(cacheSize, cache->GetCacheMetrics()->cacheBytes.get_value());
 
     // 4. 重复put
-    cache->Put("4", "hello");
+    cache->Put("4", MakeValue("hello"));
     ASSERT_TRUE(cache->Get("4", &res));
-    ASSERT_EQ("hello", res);
+    ASSERT_EQ("hello", GetFileName(res));
     ASSERT_EQ(maxCount - 1, cache->GetCacheMetrics()->cacheCount.get_value());
-    cacheSize -= std::to_string(4).size() * 2;
-    cacheSize += std::to_string(4).size() + std::string("hello").size();
+    cacheSize -= ItemSize("4", "4");
+    cacheSize += ItemSize("4", "hello");
     ASSERT_EQ(cacheSize, cache->GetCacheMetrics()->cacheBytes.get_value());
 }
 
@@ -86,45 +104,42 @@ TEST(CaCheTest, test_cache_with_capacity_no_limit) {
     std::shared_ptr<LRUCache> cache = std::make_shared<LRUCache>();
 
     // 1. 测试 put/get
-    std::string res;
+    CacheValue res;
     for (int i = 1; i <= 10; i++) {
-        cache->Put(std::to_string(i), std::to_string(i));
+        cache->Put(std::to_string(i), MakeValue(std::to_string(i)));
         ASSERT_TRUE(cache->Get(std::to_string(i), &res));
-        ASSERT_EQ(std::to_string(i), res);
+        ASSERT_EQ(std::to_string(i), GetFileName(res));
     }
 
     // 2. 测试元素删除
     cache->Remove("1");
     ASSERT_FALSE(cache->Get("1", &res));
 }
+
 TEST(CaCheTest, test_cache_with_large_data_capacity_no_limit) {
     uint64_t DefaultChunkSize = 16 * kMB;
     std::shared_ptr<LRUCache> cache = std::make_shared<LRUCache>();
 
     int i = 1;
-    FileInfo fileinfo;
+    auto fileinfo = std::make_shared<FileInfo>();
     std::string filename = "helloword-" + std::to_string(i) + ".log";
-    fileinfo.set_id(i);
-    fileinfo.set_filename(filename);
-    fileinfo.set_parentid(i << 8);
-    fileinfo.set_filetype(FileType::INODE_PAGEFILE);
-    fileinfo.set_chunksize(DefaultChunkSize);
-    fileinfo.set_length(10 << 20);
-    fileinfo.set_ctime(::curve::common::TimeUtility::GetTimeofDayUs());
-    fileinfo.set_seqnum(1);
-    std::string encodeFileInfo;
-    ASSERT_TRUE(fileinfo.SerializeToString(&encodeFileInfo));
+    fileinfo->set_id(i);
+    fileinfo->set_filename(filename);
+    fileinfo->set_parentid(i << 8);
+    fileinfo->set_filetype(FileType::INODE_PAGEFILE);
+    fileinfo->set_chunksize(DefaultChunkSize);
+    fileinfo->set_length(10 << 20);
+    fileinfo->set_ctime(::curve::common::TimeUtility::GetTimeofDayUs());
+    fileinfo->set_seqnum(1);
     std::string encodeKey =
             NameSpaceStorageCodec::EncodeFileStoreKey(i << 8, filename);
 
-    // 1. put/get
-    cache->Put(encodeKey, encodeFileInfo);
-    std::string out;
+    // 1. put/get，取出的是同一个对象，不需要再解析
+    cache->Put(encodeKey, fileinfo);
+    CacheValue out;
     ASSERT_TRUE(cache->Get(encodeKey, &out));
-    FileInfo fileinfoout;
-    ASSERT_TRUE(NameSpaceStorageCodec::DecodeFileInfo(out, &fileinfoout));
-    NameSpaceStorageCodec::DecodeFileInfo(out, &fileinfoout);
-    ASSERT_EQ(filename, fileinfoout.filename());
+    ASSERT_EQ(fileinfo.get(), out.get());
+    ASSERT_EQ(filename, GetFileName(out));
 
     // 2. remove
     cache->Remove(encodeKey);
@@ -138,9 +153,9 @@ TEST(CaCheTest, TestCacheHitAndMissMetric) {
 
     std::string existKey = "hello";
     std::string notExistKey = "world";
-    cache->Put(existKey, existKey);
+    cache->Put(existKey, MakeValue(existKey));
 
-    std::string out;
+    CacheValue out;
     for (int i = 0; i < 10; ++i) {
         ASSERT_TRUE(cache->Get(existKey, &out));
         ASSERT_FALSE(cache->Get(notExistKey, &out));
@@ -157,6 +172,29 @@ TEST(CaCheTest, TestCacheHitAndMissMetric) {
     ASSERT_EQ(10, cache->GetCacheMetrics()->cacheMiss.get_value());
 }
 
+TEST(CaCheTest, test_sharded_cache) {
+    int maxCount = 40;
+    int shardNum = 4;
+    std::shared_ptr<LRUCache> cache =
+        std::make_shared<LRUCache>(maxCount, shardNum);
 
+    // 1. 各个分片分别淘汰，总数不超过maxCount
+    for (int i = 1; i <= maxCount * 2; i++) {
+        cache->Put(std::to_string(i), MakeValue(std::to_string(i)));
+    }
+    ASSERT_GE(maxCount, cache->GetCacheMetrics()->cacheCount.get_value());
+    ASSERT_LT(0, cache->GetCacheMetrics()->cacheCount.get_value());
+
+    // 2. 最后put的元素都在缓存中
+    CacheValue res;
+    for (int i = maxCount * 2; i > maxCount * 2 - shardNum; i--) {
+        ASSERT_TRUE(cache->Get(std::to_string(i), &res));
+        ASSERT_EQ(std::to_string(i), GetFileName(res));
+    }
+
+    // 3. 删除
+    cache->Remove(std::to_string(maxCount * 2));
+    ASSERT_FALSE(cache->Get(std::to_string(maxCount * 2), &res));
+}
 }  // namespace mds
 }  // namespace curve
@@ -189,8 +189,9 @@ TEST_F(TestNameServerStorageImp, test_GetFile) {
     ASSERT_EQ(fileinfo.parentid(), getInfo.parentid());
 
     // 3. get file from cache ok
+    CacheValue cachedFileinfo = std::make_shared<FileInfo>(fileinfo);
     EXPECT_CALL(*cache_, Get(_, _))
-        .WillOnce(DoAll(SetArgPointee<1>(encodeFileinfo), Return(true)));
+        .WillOnce(DoAll(SetArgPointee<1>(cachedFileinfo), Return(true)));
     ASSERT_EQ(StoreStatus::OK, storage_->GetFile(fileinfo.parentid(),
                                                  fileinfo.filename(),
                                                  &getInfo));
@@ -388,8 +389,9 @@ TEST_F(TestNameServerStorageImp, test_getSegment) {
     ASSERT_EQ(segment.chunks_size(), getSegment.chunks_size());
 
     // 3. get file from cache ok
+    CacheValue cachedSegment = std::make_shared<PageFileSegment>(segment);
     EXPECT_CALL(*cache_, Get(_, _))
-        .WillOnce(DoAll(SetArgPointee<1>(encodeSegment), Return(true)));
+        .WillOnce(DoAll(SetArgPointee<1>(cachedSegment), Return(true)));
     ASSERT_EQ(StoreStatus::OK, storage_->GetSegment(0, 0, &getSegment));
     ASSERT_EQ(segment.chunksize(), getSegment.chunksize());
     ASSERT_EQ(segment.chunks_size(), getSegment.chunks_size());
@@ -405,6 +407,32 @@ TEST_F(TestNameServerStorageImp, test_deleteSegment) {
         storage_->DeleteSegment(0, 0, &revision));
 }
 
+TEST_F(TestNameServerStorageImp, test_deleteSegmentIfFileUnchanged) {
+    FileInfo fileinfo;
+    GetFileInfoForTest(&fileinfo);
+    std::string encodeFileInfo;
+    ASSERT_TRUE(
+        NameSpaceStorageCodec::EncodeFileInfo(fileinfo, &encodeFileInfo));
+    std::string fileKey = NameSpaceStorageCodec::EncodeFileStoreKey(
+        fileinfo.parentid(), fileinfo.filename());
+    std::string segmentKey =
+        NameSpaceStorageCodec::EncodeSegmentStoreKey(fileinfo.id(), 0);
+
+    EXPECT_CALL(*client_,
+                CompareAndDelete(fileKey, encodeFileInfo, segmentKey, _))
+        .WillOnce(DoAll(SetArgPointee<3>(10), Return(EtcdErrCode::EtcdOK)))
+        .WillOnce(Return(EtcdErrCode::EtcdTxnCompareFailed))
+        .WillOnce(Return(EtcdErrCode::EtcdAborted));
+    int64_t revision = 0;
+    ASSERT_EQ(StoreStatus::OK,
+        storage_->DeleteSegmentIfFileUnchanged(fileinfo, 0, &revision));
+    ASSERT_EQ(10, revision);
+    ASSERT_EQ(StoreStatus::ConditionNotMatch,
+        storage_->DeleteSegmentIfFileUnchanged(fileinfo, 0, &revision));
+    ASSERT_EQ(StoreStatus::InternalError,
+        storage_->DeleteSegmentIfFileUnchanged(fileinfo, 0, &revision));
+}
+
 TEST_F(TestNameServerStorageImp, test_Snapshotfile) {
     EXPECT_CALL(*client_, TxnN(_))
         .WillOnce(Return(EtcdErrCode::EtcdOK))
@@ -439,5 +467,35 @@ TEST_F(TestNameServerStorageImp, test_ListSegment) {
     ASSERT_EQ(segment.DebugString(), segments[0].DebugString());
 }
 
+TEST_F(TestNameServerStorageImp, test_ListSegmentInRange) {
+    uint64_t segmentSize = 1 << 30;
+    std::string startKey =
+        NameSpaceStorageCodec::EncodeSegmentStoreKey(1, segmentSize);
+    std::string endKey =
+        NameSpaceStorageCodec::EncodeSegmentStoreKey(1, 3 * segmentSize);
+
+    // 1. list err
+    std::vector<PageFileSegment> segments;
+    EXPECT_CALL(*client_, List(startKey, endKey, _))
+        .WillOnce(Return(EtcdErrCode::EtcdCanceled));
+    ASSERT_EQ(StoreStatus::InternalError, storage_->ListSegmentInRange(
+        1, segmentSize, 3 * segmentSize, &segments));
+
+    // 2. list ok, only one list request for the range
+    segments.clear();
+    std::string key, encodeSegment;
+    PageFileSegment segment;
+    GetPageFileSegmentForTest(&key, &segment);
+    ASSERT_TRUE(NameSpaceStorageCodec::EncodeSegment(segment, &encodeSegment));
+    EXPECT_CALL(*client_, List(startKey, endKey, _))
+        .WillOnce(DoAll(
+            SetArgPointee<2>(std::vector<std::string>{encodeSegment}),
+            Return(EtcdErrCode::EtcdOK)));
+    ASSERT_EQ(StoreStatus::OK, storage_->ListSegmentInRange(
+        1, segmentSize, 3 * segmentSize, &segments));
+    ASSERT_EQ(1, segments.size());
+    ASSERT_EQ(segment.DebugString(), segments[0].DebugString());
+}
+
 }  // namespace mds
 }  // namespace curve
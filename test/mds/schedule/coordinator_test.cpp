@@ -428,6 +428,26 @@ TEST(CoordinatorTest, test_ChunkserverGoingToAdd) {
     }
 }
 
+TEST(CoordinatorTest, test_HasOperator) {
+    auto topo = std::make_shared<MockTopology>();
+    auto topoAdapter = std::make_shared<MockTopoAdapter>();
+    auto coordinator = std::make_shared<Coordinator>(topoAdapter);
+    ScheduleOption scheduleOption;
+    scheduleOption.operatorConcurrent = 4;
+    coordinator->InitScheduler(
+        scheduleOption, std::make_shared<ScheduleMetrics>(topo));
+
+    ASSERT_FALSE(coordinator->HasOperator(CopySetKey{1, 1}));
+
+    Operator testOperator(1, CopySetKey{1, 1},
+                          OperatorPriority::NormalPriority,
+                          steady_clock::now(),
+                          std::make_shared<TransferLeader>(2, 1));
+    ASSERT_TRUE(coordinator->GetOpController()->AddOperator(testOperator));
+    ASSERT_TRUE(coordinator->HasOperator(CopySetKey{1, 1}));
+    ASSERT_FALSE(coordinator->HasOperator(CopySetKey{1, 2}));
+}
+
 TEST(CoordinatorTest, test_SchedulerSwitch) {
     auto topo = std::make_shared<MockTopology>();
     auto metric = std::make_shared<ScheduleMetrics>(topo);
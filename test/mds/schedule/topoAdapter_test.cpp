@@ -380,6 +380,62 @@ TEST_F(TestTopoAdapterImpl, test_chunkserverInfo) {
     }
 }
 
+TEST_F(TestTopoAdapterImpl, test_topo_snapshot) {
+    topoAdapter_ = std::make_shared<TopoAdapterImpl>(
+        mockTopo_, mockTopoManager_, mockTopoStat_, 60000);
+    auto testTopoCopySet = GetTopoCopySetInfoForTest();
+    auto testTopoChunkServer = GetTopoChunkServerForTest();
+    auto testTopoServer = GetServerForTest();
+    ::curve::mds::topology::LogicalPool lpool;
+    lpool.SetLogicalPoolAvaliableFlag(true);
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_CALL(*mockTopo_, GetChunkServer(i + 1, _))
+            .WillRepeatedly(DoAll(SetArgPointee<1>(testTopoChunkServer[i]),
+                                  Return(true)));
+        EXPECT_CALL(*mockTopo_, GetServer(i + 1, _))
+            .WillRepeatedly(DoAll(SetArgPointee<1>(testTopoServer[i]),
+                                  Return(true)));
+    }
+    EXPECT_CALL(*mockTopoStat_, GetChunkServerStat(_, _))
+        .WillRepeatedly(Return(false));
+
+    // topology is traversed only once for all the calls below
+    EXPECT_CALL(*mockTopo_, GetChunkServerInCluster(_))
+        .WillOnce(Return(std::vector<ChunkServerIdType>{1, 2, 3, 4}));
+    EXPECT_CALL(*mockTopo_, GetLogicalPoolInCluster(_))
+        .WillOnce(Return(std::vector<PoolIdType>{1}));
+    EXPECT_CALL(*mockTopo_, GetLogicalPool(1, _))
+        .WillOnce(DoAll(SetArgPointee<1>(lpool), Return(true)));
+    EXPECT_CALL(*mockTopo_, GetCopySetInfosInLogicalPool(1, _))
+        .WillOnce(Return(
+            std::vector<::curve::mds::topology::CopySetInfo>{
+                testTopoCopySet}));
+    EXPECT_CALL(*mockTopo_, GetChunkServerInLogicalPool(1, _))
+        .WillOnce(Return(std::list<ChunkServerIdType>{1, 2, 3}));
+
+    auto copysets = topoAdapter_->GetCopySetInfos();
+    ASSERT_EQ(1, copysets.size());
+    ASSERT_EQ(testTopoCopySet.GetId(), copysets[0].id.second);
+    ASSERT_TRUE(copysets[0].logicalPoolWork);
+    ASSERT_EQ(3, copysets[0].peers.size());
+    ASSERT_EQ(4, copysets[0].candidatePeerInfo.id);
+
+    ASSERT_EQ(1, topoAdapter_->GetCopySetInfosInLogicalPool(1).size());
+    ASSERT_EQ(0, topoAdapter_->GetCopySetInfosInLogicalPool(2).size());
+    ASSERT_EQ(1, topoAdapter_->GetCopySetInfosInChunkServer(1).size());
+    ASSERT_EQ(0, topoAdapter_->GetCopySetInfosInChunkServer(4).size());
+    ASSERT_EQ(4, topoAdapter_->GetChunkServerInfos().size());
+    auto chunkservers = topoAdapter_->GetChunkServersInLogicalPool(1);
+    ASSERT_EQ(3, chunkservers.size());
+    ASSERT_EQ(1, chunkservers[0].info.id);
+    ASSERT_EQ(0, topoAdapter_->GetChunkServersInLogicalPool(2).size());
+
+    auto snapshot = topoAdapter_->GetSnapshot();
+    ASSERT_EQ(1, snapshot->version);
+    ASSERT_EQ(snapshot.get(), topoAdapter_->GetSnapshot().get());
+}
+
 TEST_F(TestTopoAdapterImpl, test_other_functions) {
     auto testPageFileLogicalPool = GetPageFileLogicalPoolForTest();
     auto testAppendFileLogicalPool = GetAppendFileLogicalPoolForTest();
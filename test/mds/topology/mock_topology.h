@@ -343,6 +343,8 @@ class MockKVStorageClient : public KVStorageClient {
     MOCK_METHOD3(PutRewithRevision, int(const std::string &,
         const std::string &, int64_t *));
     MOCK_METHOD2(DeleteRewithRevision, int(const std::string &, int64_t *));
+    MOCK_METHOD4(CompareAndDelete, int(const std::string &,
+        const std::string &, const std::string &, int64_t *));
 };
 
 }  // namespace kvstorage
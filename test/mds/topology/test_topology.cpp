@@ -1369,6 +1369,13 @@ TEST_F(TestTopology, UpdateChunkServerTopo_UpdateServerSuccess) {
         .WillOnce(Return(true));
     int ret = topology_->UpdateChunkServerTopo(newCs);
     ASSERT_EQ(kTopoErrCodeSuccess, ret);
+
+    // the chunkserver is moved to the new server
+    ASSERT_TRUE(topology_->GetChunkServerInServer(serverId).empty());
+    std::list<ChunkServerIdType> csList =
+        topology_->GetChunkServerInServer(serverId2);
+    ASSERT_EQ(1, csList.size());
+    ASSERT_EQ(csId, csList.front());
 }
 
 TEST_F(TestTopology, UpdateChunkServerTopo_ChunkServerNotFound) {
@@ -2655,6 +2662,62 @@ TEST_F(TestTopology, GetCopySetsInChunkServer_success) {
     ASSERT_EQ(1, csList.size());
 }
 
+TEST_F(TestTopology, GetCopySetsInChunkServer_indexUpdate) {
+    PoolIdType logicalPoolId = 0x01;
+    PoolIdType physicalPoolId = 0x11;
+
+    PrepareAddPhysicalPool(physicalPoolId);
+    PrepareAddZone(0x21, "zone1", physicalPoolId);
+    PrepareAddZone(0x22, "zone2", physicalPoolId);
+    PrepareAddZone(0x23, "zone3", physicalPoolId);
+    PrepareAddServer(
+        0x31, "server1", "127.0.0.1" , 0, "127.0.0.1" , 0, 0x21, 0x11);
+    PrepareAddServer(
+        0x32, "server2", "127.0.0.1" , 0, "127.0.0.1" , 0, 0x22, 0x11);
+    PrepareAddServer(
+        0x33, "server3", "127.0.0.1" , 0, "127.0.0.1" , 0, 0x23, 0x11);
+    PrepareAddChunkServer(0x41, "token1", "nvme", 0x31, "127.0.0.1", 8200);
+    PrepareAddChunkServer(0x42, "token2", "nvme", 0x32, "127.0.0.1", 8200);
+    PrepareAddChunkServer(0x43, "token3", "nvme", 0x33, "127.0.0.1", 8200);
+    PrepareAddChunkServer(0x44, "token4", "nvme", 0x33, "127.0.0.1", 8201);
+    PrepareAddLogicalPool(logicalPoolId, "logicalPool1", physicalPoolId);
+    PrepareAddCopySet(0x51, logicalPoolId, {0x41, 0x42, 0x43});
+    PrepareAddCopySet(0x52, logicalPoolId, {0x41, 0x42, 0x44});
+
+    ASSERT_EQ(2, topology_->GetCopySetsInChunkServer(0x41).size());
+    ASSERT_EQ(1, topology_->GetCopySetsInChunkServer(0x43).size());
+    ASSERT_EQ(1, topology_->GetCopySetsInChunkServer(0x44).size());
+    ASSERT_EQ(0, topology_->GetCopySetsInChunkServer(0x45).size());
+
+    // filter is applied to the copysets found in the index
+    std::vector<CopySetKey> csList = topology_->GetCopySetsInChunkServer(
+        0x41, [](const CopySetInfo &info) {
+            return info.GetId() == 0x52;
+        });
+    ASSERT_EQ(1, csList.size());
+    ASSERT_EQ(CopySetKey(logicalPoolId, 0x52), csList[0]);
+
+    // 0x43 is replaced by 0x44 in copyset 0x51
+    CopySetInfo csInfo(logicalPoolId, 0x51);
+    csInfo.SetCopySetMembers({0x41, 0x42, 0x44});
+    ASSERT_EQ(kTopoErrCodeSuccess, topology_->UpdateCopySetTopo(csInfo));
+    ASSERT_EQ(0, topology_->GetCopySetsInChunkServer(0x43).size());
+    csList = topology_->GetCopySetsInChunkServer(0x44);
+    ASSERT_EQ(2, csList.size());
+    ASSERT_EQ(CopySetKey(logicalPoolId, 0x51), csList[0]);
+    ASSERT_EQ(CopySetKey(logicalPoolId, 0x52), csList[1]);
+
+    // remove copyset 0x52
+    EXPECT_CALL(*storage_, DeleteCopySet(_))
+        .WillOnce(Return(true));
+    ASSERT_EQ(kTopoErrCodeSuccess,
+        topology_->RemoveCopySet(CopySetKey(logicalPoolId, 0x52)));
+    csList = topology_->GetCopySetsInChunkServer(0x41);
+    ASSERT_EQ(1, csList.size());
+    ASSERT_EQ(CopySetKey(logicalPoolId, 0x51), csList[0]);
+    ASSERT_EQ(1, topology_->GetCopySetsInChunkServer(0x44).size());
+}
+
 
 
 
@@ -27,6 +27,8 @@
 #include "src/snapshotcloneserver/snapshot/snapshot_data_store.h"
 #include "test/snapshotcloneserver/mock_s3_adapter.h"
 using ::testing::_;
+using ::testing::DoAll;
+using ::testing::Invoke;
 namespace curve {
 namespace snapshotcloneserver {
 
@@ -174,6 +176,78 @@ TEST_F(TestS3SnapshotDataStore, testDataChunkTransferComplete) {
     ASSERT_EQ(0, store_->DataChunkTranferComplete(cdName, task));
     ASSERT_EQ(-1, store_->DataChunkTranferComplete(cdName, task));
 }
+TEST_F(TestS3SnapshotDataStore, testDataChunkTransferCompressed) {
+    ChunkDataName cdName("test", 1, 1);
+    std::shared_ptr<TransferTask> task = std::make_shared<TransferTask>();
+    const int frameSize = 4096;
+    const int partSize = 4 * frameSize;
+    store_->SetCompressOption(CompressType::Snappy, frameSize);
+    std::string buf(partSize, 'a');
+
+    // 压缩后的header和分片都小于s3 multipart要求的5MiB最小分片，
+    // 压缩时整个对象只能通过一次PutObject上传
+    EXPECT_CALL(*adapter4Data_, MultiUploadInit(_))
+        .Times(0);
+    EXPECT_CALL(*adapter4Data_, UploadOnePart(_, _, _, _, _))
+        .Times(0);
+    EXPECT_CALL(*adapter4Data_, CompleteMultiUpload(_, _, _))
+        .Times(0);
+    ASSERT_EQ(0, store_->DataChunkTranferInit(cdName, task));
+
+    // 1. 分片大小没有对齐frame大小
+    ASSERT_EQ(-1, store_->DataChunkTranferAddPart(
+        cdName, task, 0, partSize - 1, buf.data()));
+
+    // 2. 压缩后的分片缓存在task中
+    ASSERT_EQ(0, store_->DataChunkTranferAddPart(
+        cdName, task, 1, partSize, buf.data()));
+    ASSERT_EQ(0, store_->DataChunkTranferAddPart(
+        cdName, task, 0, partSize, buf.data()));
+    ASSERT_EQ(2, task->GetCompressedPartNum());
+
+    // 3. complete时header放在对象头部，整体上传
+    std::string object;
+    EXPECT_CALL(*adapter4Data_, PutObject(Aws::String("test-1-1"), _))
+        .WillOnce(DoAll(
+            Invoke([&object](const Aws::String &, const std::string &data) {
+                object = data;
+            }),
+            Return(0)));
+    ASSERT_EQ(0, store_->DataChunkTranferComplete(cdName, task));
+    ASSERT_EQ(0, task->GetCompressedPartNum());
+
+    curve::common::CompressedObjectHeader decoded;
+    uint32_t headerLen = curve::common::CompressedObjectHeader::
+        GetHeaderLength(object.data(), object.size(), 2 * partSize);
+    ASSERT_GT(headerLen, 0);
+    ASSERT_TRUE(decoded.Decode(object.data(), headerLen, 2 * partSize));
+    ASSERT_EQ(CompressType::Snappy, decoded.GetType());
+    ASSERT_EQ(frameSize, decoded.GetFrameSize());
+    ASSERT_EQ(8, decoded.GetFrameNum());
+    ASSERT_LT(object.size(), 2 * partSize);
+}
+
+TEST_F(TestS3SnapshotDataStore, testDataChunkTransferCompressPartMissing) {
+    ChunkDataName cdName("test", 1, 1);
+    std::shared_ptr<TransferTask> task = std::make_shared<TransferTask>();
+    store_->SetCompressOption(CompressType::Snappy, 4096);
+    task->AddCompressedPart(1, {100}, std::string(100, 'a'));
+    EXPECT_CALL(*adapter4Data_, PutObject(_, _))
+        .Times(0);
+    ASSERT_EQ(-1, store_->DataChunkTranferComplete(cdName, task));
+}
+
+TEST_F(TestS3SnapshotDataStore, testDataChunkTransferCompressAbort) {
+    ChunkDataName cdName("test", 1, 1);
+    std::shared_ptr<TransferTask> task = std::make_shared<TransferTask>();
+    store_->SetCompressOption(CompressType::Snappy, 4096);
+    task->AddCompressedPart(0, {100}, std::string(100, 'a'));
+    EXPECT_CALL(*adapter4Data_, AbortMultiUpload(_, _))
+        .Times(0);
+    ASSERT_EQ(0, store_->DataChunkTranferAbort(cdName, task));
+    ASSERT_EQ(0, task->GetCompressedPartNum());
+}
+
 TEST_F(TestS3SnapshotDataStore, testDataChunkTransferAbort) {
     ChunkDataName cdName("test", 1, 1);
     std::shared_ptr<TransferTask> task = std::make_shared<TransferTask>();
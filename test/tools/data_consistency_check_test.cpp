@@ -122,13 +122,18 @@ TEST_F(ConsistencyCheckTest, Consistency) {
         .Times(20)
         .WillRepeatedly(DoAll(SetArgPointee<2>(csLocs),
                         Return(0)));
+    // chunkserver未开启region hash，比较整个chunk的hash
     EXPECT_CALL(*csClient_, Init(_))
-        .Times(90)
+        .Times(100)
         .WillRepeatedly(Return(0));
     EXPECT_CALL(*csClient_, GetCopysetStatus(_, _))
         .Times(60)
         .WillRepeatedly(DoAll(SetArgPointee<1>(response),
                         Return(0)));
+    EXPECT_CALL(*csClient_, GetChunkRegionHash(_, _, _))
+        .Times(10)
+        .WillRepeatedly(DoAll(SetArgPointee<1>(0),
+                        Return(0)));
     EXPECT_CALL(*csClient_, GetChunkHash(_, _))
         .Times(30)
         .WillRepeatedly(DoAll(SetArgPointee<1>("1111"),
@@ -158,6 +163,32 @@ TEST_F(ConsistencyCheckTest, Consistency) {
     ASSERT_EQ(0, cfc2.RunCommand("check-consistency"));
     FLAGS_check_hash = true;
     ASSERT_EQ(0, cfc2.RunCommand("check-consistency"));
+
+    // 3、chunkserver开启了region hash，只比较region hash
+    std::vector<uint32_t> regionHashes = {1111, 2222};
+    EXPECT_CALL(*nameSpaceTool_, GetFileSegments(_, _))
+        .Times(1)
+        .WillOnce(DoAll(SetArgPointee<1>(segments),
+                        Return(0)));
+    EXPECT_CALL(*nameSpaceTool_, GetChunkServerListInCopySet(_, _, _))
+        .Times(10)
+        .WillRepeatedly(DoAll(SetArgPointee<2>(csLocs),
+                        Return(0)));
+    EXPECT_CALL(*csClient_, Init(_))
+        .Times(60)
+        .WillRepeatedly(Return(0));
+    EXPECT_CALL(*csClient_, GetCopysetStatus(_, _))
+        .Times(30)
+        .WillRepeatedly(DoAll(SetArgPointee<1>(response),
+                        Return(0)));
+    EXPECT_CALL(*csClient_, GetChunkRegionHash(_, _, _))
+        .Times(30)
+        .WillRepeatedly(DoAll(SetArgPointee<1>(1024 * 1024),
+                        SetArgPointee<2>(regionHashes),
+                        Return(0)));
+    EXPECT_CALL(*csClient_, GetChunkHash(_, _))
+        .Times(0);
+    ASSERT_EQ(0, cfc1.RunCommand("check-consistency"));
 }
 
 TEST_F(ConsistencyCheckTest, NotConsistency) {
@@ -194,9 +225,10 @@ TEST_F(ConsistencyCheckTest, NotConsistency) {
                         Return(0)));
 
     // 1、检查hash，apply index一致，hash不一致
+    // chunkserver未开启region hash，比较整个chunk的hash
     FLAGS_check_hash = true;
     EXPECT_CALL(*csClient_, Init(_))
-        .Times(5)
+        .Times(6)
         .WillRepeatedly(Return(0));
     EXPECT_CALL(*csClient_, GetCopysetStatus(_, _))
         .Times(3)
@@ -302,7 +334,7 @@ TEST_F(ConsistencyCheckTest, CheckError) {
     CopysetStatusResponse response1;
     GetCopysetStatusForTest(&response1);
     EXPECT_CALL(*csClient_, Init(_))
-        .Times(4)
+        .Times(5)
         .WillRepeatedly(Return(0));
     EXPECT_CALL(*csClient_, GetCopysetStatus(_, _))
         .Times(3)
@@ -41,6 +41,8 @@ class MockChunkServerClient : public ChunkServerClient {
     MOCK_METHOD2(GetCopysetStatus, int(const CopysetStatusRequest& request,
                                  CopysetStatusResponse* response));
     MOCK_METHOD2(GetChunkHash, int(const Chunk&, std::string*));
+    MOCK_METHOD3(GetChunkRegionHash, int(const Chunk&, uint32_t*,
+                                         std::vector<uint32_t>*));
 };
 }  // namespace tool
 }  // namespace curve
@@ -57,6 +57,7 @@ enum EtcdErrCode
     EtcdGetLeaderKeyOK = 28,
     EtcdObserverLeaderNotExist = 29,
     EtcdObjectLenNotEnough = 30,
+    EtcdTxnCompareFailed = 31,
 };
 
 enum OpType {
@@ -104,6 +105,7 @@ const (
 	EtcdTxn2      = "Txn2"
 	EtcdTxn3      = "Txn3"
 	EtcdCmpAndSwp = "CmpAndSwp"
+	EtcdCmpAndDel = "CmpAndDel"
 )
 
 var globalClient *clientv3.Client
@@ -412,6 +414,30 @@ func EtcdClientCompareAndSwap(timeout C.int, key, prev, target *C.char,
 	return GetErrCode(EtcdCmpAndSwp, err)
 }
 
+//export EtcdClientCompareAndDelete
+func EtcdClientCompareAndDelete(timeout C.int, cmpKey, cmpValue, key *C.char,
+	cmpKeyLen, cmpValueLen, keyLen C.int) (C.enum_EtcdErrCode, int64) {
+	goCmpKey := C.GoStringN(cmpKey, cmpKeyLen)
+	goCmpValue := C.GoStringN(cmpValue, cmpValueLen)
+	goKey := C.GoStringN(key, keyLen)
+
+	ctx, cancel := context.WithTimeout(context.Background(),
+		time.Duration(int(timeout))*time.Millisecond)
+	defer cancel()
+
+	resp, err := globalClient.Txn(ctx).
+		If(clientv3.Compare(clientv3.Value(goCmpKey), "=", goCmpValue)).
+		Then(clientv3.OpDelete(goKey)).
+		Commit()
+	if err != nil {
+		return GetErrCode(EtcdCmpAndDel, err), 0
+	}
+	if !resp.Succeeded {
+		return C.EtcdTxnCompareFailed, 0
+	}
+	return C.EtcdOK, resp.Header.Revision
+}
+
 //export EtcdElectionCampaign
 func EtcdElectionCampaign(pfx *C.char, pfxLen C.int,
 	leaderName *C.char, nameLen C.int, sessionInterSec uint32,